@@ -55,3 +55,78 @@ H3D_API bool h3dextImportTexture( H3DRes texRes, int texID );
 		 the OpenGL texture name (uint32)
 */
 H3D_API int h3dextGetGLTextureID( H3DRes texRes );
+
+/* Function: h3dextCreateStreamTexture
+		Creates a texture resource that displays a stream of video frames
+
+	Details:
+		This function creates a 2D texture resource backed by a ring of textures with the given size and
+		format. Frames are uploaded into free slots of the ring with h3dextPushStreamFrame or imported with
+		h3dextImportStreamFrame and become the content of the texture through h3dextPresentStreamFrame.
+		Uploads are done through pixel buffers if supported by the render backend, so that neither the
+		application nor the renderer has to wait for the GPU. Only uncompressed formats are supported.
+
+	Parameters:
+		name         - name of the resource
+		width        - width of the frames
+		height       - height of the frames
+		fmt          - texture format, see H3DFormats
+		ringSize     - number of textures in the ring (at least 2), more slots drop fewer frames when the GPU lags behind
+
+	Returns:
+		 handle to the created texture resource or 0 in case of failure
+*/
+H3D_API H3DRes h3dextCreateStreamTexture( const char *name, int width, int height, int fmt, int ringSize );
+
+/* Function: h3dextPushStreamFrame
+		Queues a frame in a texture stream
+
+	Details:
+		Copies the pixel data into a free slot of the stream and starts an asynchronous upload. The data
+		has to match the size and format of the texture. If all slots are in use, the oldest frame that was
+		not presented yet is replaced; if that is not possible either, the frame is dropped.
+
+	Parameters:
+		texRes       - handle to a stream texture
+		pixels       - pointer to the pixel data of the frame
+		timestamp    - presentation time of the frame
+
+	Returns:
+		 true if the frame was queued, false if it was dropped
+*/
+H3D_API bool h3dextPushStreamFrame( H3DRes texRes, const void *pixels, double timestamp );
+
+/* Function: h3dextImportStreamFrame
+		Queues an EGLImage as frame in a texture stream
+
+	Details:
+		Binds an EGLImage to a free slot of the stream without copying the data. This allows zero-copy
+		video playback by creating the EGLImage from a dmabuf of a video decoder or camera. The image has
+		to stay valid until the slot is reused. Requires the OES_EGL_image extension.
+
+	Parameters:
+		texRes       - handle to a stream texture
+		eglImage     - EGLImageKHR handle
+		timestamp    - presentation time of the frame
+
+	Returns:
+		 true if the frame was queued, false if it was dropped
+*/
+H3D_API bool h3dextImportStreamFrame( H3DRes texRes, void *eglImage, double timestamp );
+
+/* Function: h3dextPresentStreamFrame
+		Selects the frame of a texture stream that is displayed
+
+	Details:
+		Makes the newest frame of the stream with a timestamp not later than the given time the content of
+		the texture resource. Only frames whose upload has completed on the GPU are considered, so calling
+		this function once per rendered frame never blocks. Older queued frames are skipped.
+
+	Parameters:
+		texRes       - handle to a stream texture
+		time         - current presentation time
+
+	Returns:
+		 timestamp of the newly presented frame or -1 if the displayed frame did not change
+*/
+H3D_API double h3dextPresentStreamFrame( H3DRes texRes, double time );
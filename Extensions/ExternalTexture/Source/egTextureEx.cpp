@@ -19,11 +19,20 @@
 #include "egRendererBaseGL2.h"
 #include "egRendererBaseGL4.h"
 
+#include <cstring>
+
 namespace  Horde3DExternalTexture {
 
 using namespace Horde3D;
 
-TextureResourceEx::TextureResourceEx(const std::string &name, int flags) : TextureResource(name,flags), m_imported(false)
+TextureResourceEx::TextureResourceEx(const std::string &name, int flags) : TextureResource(name,flags), m_imported(false),
+	m_presentedSlot( -1 )
+{
+}
+
+TextureResourceEx::TextureResourceEx( const std::string &name, uint32 width, uint32 height, TextureFormats::List fmt,
+                                      int flags ) :
+	TextureResource( name, width, height, 1, fmt, flags ), m_imported( false ), m_presentedSlot( -1 )
 {
 }
 
@@ -31,6 +40,7 @@ void TextureResourceEx::release()
 {
 	if( m_imported )
 		replaceTexObj(0);
+	releaseStream();
 	TextureResource::release();
 }
 
@@ -105,4 +115,197 @@ void TextureResourceEx::replaceTexObj( uint32 texObj )
 	}
 }
 
+
+// =================================================================================================
+// Streaming
+// =================================================================================================
+// The stream is a ring of textures of the same size and format as the resource. Frames are written
+// to a free slot and only become presentable once the GPU has finished the upload, so neither the
+// producer nor the render loop ever waits for the GPU. A slot that was replaced on screen is only
+// reused after all commands that might sample it have completed.
+
+bool TextureResourceEx::createStream( int ringSize )
+{
+	// Compressed and depth formats are listed after the plain color formats
+	if( _texType != TextureTypes::Tex2D || _texFormat >= TextureFormats::DXT1 ||
+		_texObject == 0 || _texObject == defTex2DObject || m_imported || ringSize < 2 )
+	{
+		Modules::log().writeError( "Texture stream requires an uncompressed 2D texture and at least 2 slots" );
+		return false;
+	}
+
+	RenderDeviceInterface *rdi = Modules::renderer().getRenderDevice();
+	uint32 frameSize = rdi->calcTextureSize( _texFormat, _width, _height, 1 );
+
+	releaseStream();
+	m_streamSlots.resize( ringSize );
+	for( int i = 0; i < ringSize; ++i )
+	{
+		StreamSlot &slot = m_streamSlots[ i ];
+
+		// Slot 0 reuses the texture of the resource so that it is displayed until the first frame
+		slot.texObj = i == 0 ? _texObject : rdi->createTexture( _texType, _width, _height, 1, _texFormat,
+		                                                        false, false, false, _sRGB );
+		slot.pixelBuf = rdi->getCaps().pixelBuffers ? rdi->createPixelBuffer( frameSize ) : 0;
+		slot.fence = 0;
+		slot.timestamp = 0;
+		slot.state = i == 0 ? StreamSlotState::Presented : StreamSlotState::Free;
+	}
+	m_presentedSlot = 0;
+
+	return true;
+}
+
+
+int TextureResourceEx::acquireStreamSlot()
+{
+	RenderDeviceInterface *rdi = Modules::renderer().getRenderDevice();
+
+	for( size_t i = 0; i < m_streamSlots.size(); ++i )
+	{
+		StreamSlot &slot = m_streamSlots[ i ];
+
+		if( slot.state == StreamSlotState::Retired && rdi->isFenceSignaled( slot.fence ) )
+		{
+			rdi->destroyFence( slot.fence );
+			slot.state = StreamSlotState::Free;
+		}
+		if( slot.state == StreamSlotState::Free ) return (int)i;
+	}
+
+	// Drop the oldest frame that was not presented yet rather than waiting for the GPU
+	int oldest = -1;
+	for( size_t i = 0; i < m_streamSlots.size(); ++i )
+	{
+		const StreamSlot &slot = m_streamSlots[ i ];
+		if( slot.state == StreamSlotState::Ready && rdi->isFenceSignaled( slot.fence ) &&
+			(oldest < 0 || slot.timestamp < m_streamSlots[ oldest ].timestamp) )
+			oldest = (int)i;
+	}
+	if( oldest >= 0 ) rdi->destroyFence( m_streamSlots[ oldest ].fence );
+
+	return oldest;
+}
+
+
+bool TextureResourceEx::pushStreamFrame( const void *pixels, double timestamp )
+{
+	if( m_streamSlots.empty() || pixels == 0x0 ) return false;
+
+	int index = acquireStreamSlot();
+	if( index < 0 ) return false;
+
+	RenderDeviceInterface *rdi = Modules::renderer().getRenderDevice();
+	StreamSlot &slot = m_streamSlots[ index ];
+
+	if( slot.pixelBuf != 0 )
+	{
+		void *dst = rdi->mapPixelBuffer( slot.pixelBuf );
+		if( dst == 0x0 ) return false;
+		memcpy( dst, pixels, rdi->calcTextureSize( _texFormat, _width, _height, 1 ) );
+		rdi->unmapPixelBuffer( slot.pixelBuf );
+		rdi->updateTextureFromBuffer( slot.texObj, slot.pixelBuf, 0 );
+	}
+	else
+	{
+		// No pixel buffers available, the driver has to copy the data synchronously
+		rdi->updateTextureData( slot.texObj, 0, 0, pixels );
+	}
+
+	slot.fence = rdi->createFence();
+	slot.timestamp = timestamp;
+	slot.state = StreamSlotState::Uploading;
+
+	return true;
+}
+
+
+bool TextureResourceEx::importStreamFrame( void *eglImage, double timestamp )
+{
+	if( m_streamSlots.empty() || eglImage == 0x0 ) return false;
+
+	int index = acquireStreamSlot();
+	if( index < 0 ) return false;
+
+	RenderDeviceInterface *rdi = Modules::renderer().getRenderDevice();
+	StreamSlot &slot = m_streamSlots[ index ];
+
+	// The image shares the memory of the producer (e.g. a dmabuf), so no copy is involved
+	rdi->bindImageToTexture( slot.texObj, eglImage );
+
+	slot.fence = rdi->createFence();
+	slot.timestamp = timestamp;
+	slot.state = StreamSlotState::Uploading;
+
+	return true;
+}
+
+
+double TextureResourceEx::presentStreamFrame( double time )
+{
+	if( m_streamSlots.empty() ) return -1;
+
+	RenderDeviceInterface *rdi = Modules::renderer().getRenderDevice();
+
+	// Find the newest completed frame that is due
+	int newest = -1;
+	for( size_t i = 0; i < m_streamSlots.size(); ++i )
+	{
+		StreamSlot &slot = m_streamSlots[ i ];
+
+		if( slot.state == StreamSlotState::Uploading && rdi->isFenceSignaled( slot.fence ) )
+		{
+			rdi->destroyFence( slot.fence );
+			slot.state = StreamSlotState::Ready;
+		}
+		if( slot.state == StreamSlotState::Ready && slot.timestamp <= time &&
+			(newest < 0 || slot.timestamp > m_streamSlots[ newest ].timestamp) )
+			newest = (int)i;
+	}
+	if( newest < 0 ) return -1;
+
+	// Older frames are skipped, their textures were never sampled
+	for( size_t i = 0; i < m_streamSlots.size(); ++i )
+	{
+		StreamSlot &slot = m_streamSlots[ i ];
+		if( slot.state == StreamSlotState::Ready && slot.timestamp < m_streamSlots[ newest ].timestamp )
+			slot.state = StreamSlotState::Free;
+	}
+
+	if( m_presentedSlot >= 0 )
+	{
+		StreamSlot &prev = m_streamSlots[ m_presentedSlot ];
+		prev.fence = rdi->createFence();
+		prev.state = StreamSlotState::Retired;
+	}
+
+	m_presentedSlot = newest;
+	m_streamSlots[ newest ].state = StreamSlotState::Presented;
+	_texObject = m_streamSlots[ newest ].texObj;
+
+	return m_streamSlots[ newest ].timestamp;
+}
+
+
+void TextureResourceEx::releaseStream()
+{
+	if( m_streamSlots.empty() ) return;
+
+	RenderDeviceInterface *rdi = Modules::renderer().getRenderDevice();
+
+	for( size_t i = 0; i < m_streamSlots.size(); ++i )
+	{
+		StreamSlot &slot = m_streamSlots[ i ];
+
+		rdi->destroyFence( slot.fence );
+		if( slot.pixelBuf != 0 ) rdi->destroyBuffer( slot.pixelBuf );
+		if( i > 0 ) rdi->destroyTexture( slot.texObj );
+	}
+
+	// The resource owns the texture of the first slot again
+	_texObject = m_streamSlots[ 0 ].texObj;
+	m_streamSlots.clear();
+	m_presentedSlot = -1;
+}
+
 } // Namespace
@@ -13,6 +13,7 @@
 #define EGTEXTUREEX_H
 
 #include <egTexture.h>
+#include <vector>
 
 namespace Horde3DExternalTexture {
 
@@ -23,6 +24,8 @@ public:
 	    { return new TextureResourceEx( name, flags ); }
 
 	TextureResourceEx( const std::string &name, int flags );
+	TextureResourceEx( const std::string &name, uint32 width, uint32 height, Horde3D::TextureFormats::List fmt,
+	                   int flags );
 
 	void release();
 
@@ -30,10 +33,41 @@ public:
 
 	uint32 getGLTexID();
 
+	bool createStream( int ringSize );
+	bool pushStreamFrame( const void *pixels, double timestamp );
+	bool importStreamFrame( void *eglImage, double timestamp );
+	double presentStreamFrame( double time );
+
 private:
+	struct StreamSlotState
+	{
+		enum List
+		{
+			Free,       // Can be written
+			Uploading,  // Upload issued, fence pending
+			Ready,      // Waiting for presentation
+			Presented,  // Currently bound to the resource
+			Retired     // Replaced, GPU might still sample it until the fence is signaled
+		};
+	};
+
+	struct StreamSlot
+	{
+		uint32                  texObj;
+		uint32                  pixelBuf;
+		uint32                  fence;
+		double                  timestamp;
+		StreamSlotState::List   state;
+	};
+
 	void replaceTexObj(uint32 texObj );
+	int acquireStreamSlot();
+	void releaseStream();
 
 	bool  m_imported;
+
+	std::vector< StreamSlot >  m_streamSlots;
+	int                        m_presentedSlot;
 };
 
 }
@@ -68,4 +68,76 @@ H3D_IMPL int h3dextGetGLTextureID( Horde3D::ResHandle texRes )
 }
 
 
+// Public C API
+H3D_IMPL Horde3D::ResHandle h3dextCreateStreamTexture( const char *name, int width, int height, int fmt, int ringSize )
+{
+	if( name == 0x0 || width <= 0 || height <= 0 )
+	{
+		Modules::log().writeError("Invalid parameters for stream texture");
+		return 0;
+	}
+
+	TextureResourceEx *texRes = new TextureResourceEx( name, (uint32)width, (uint32)height,
+	                                                   (TextureFormats::List)fmt, ResourceFlags::NoTexMipmaps );
+	if( !texRes->createStream( ringSize ) )
+	{
+		texRes->release();
+		delete texRes;
+		return 0;
+	}
+
+	ResHandle res = Modules::resMan().addNonExistingResource( *texRes, true );
+	if( res == 0 )
+	{
+		Modules::log().writeError("Failed to add stream texture, maybe the name is already in use?");
+		texRes->release();
+		delete texRes;
+	}
+
+	return res;
+}
+
+// Public C API
+H3D_IMPL bool h3dextPushStreamFrame( Horde3D::ResHandle texRes, const void *pixels, double timestamp )
+{
+	Resource *res = Modules::resMan().resolveResHandle(texRes);
+	if( res == 0x0 || res->getType() != ResourceTypes::Texture )
+	{
+		Modules::log().writeError("Error pushing stream frame");
+		return false;
+	}
+
+	TextureResourceEx* texEx = dynamic_cast<TextureResourceEx*>(res);
+	return texEx != 0x0 && texEx->pushStreamFrame( pixels, timestamp );
+}
+
+// Public C API
+H3D_IMPL bool h3dextImportStreamFrame( Horde3D::ResHandle texRes, void *eglImage, double timestamp )
+{
+	Resource *res = Modules::resMan().resolveResHandle(texRes);
+	if( res == 0x0 || res->getType() != ResourceTypes::Texture )
+	{
+		Modules::log().writeError("Error importing stream frame");
+		return false;
+	}
+
+	TextureResourceEx* texEx = dynamic_cast<TextureResourceEx*>(res);
+	return texEx != 0x0 && texEx->importStreamFrame( eglImage, timestamp );
+}
+
+// Public C API
+H3D_IMPL double h3dextPresentStreamFrame( Horde3D::ResHandle texRes, double time )
+{
+	Resource *res = Modules::resMan().resolveResHandle(texRes);
+	if( res == 0x0 || res->getType() != ResourceTypes::Texture )
+	{
+		Modules::log().writeError("Error presenting stream frame");
+		return -1;
+	}
+
+	TextureResourceEx* texEx = dynamic_cast<TextureResourceEx*>(res);
+	return texEx != 0x0 ? texEx->presentStreamFrame( time ) : -1;
+}
+
+
 }  // namespace
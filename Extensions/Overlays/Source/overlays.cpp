@@ -72,8 +72,8 @@ bool OverlayRenderer::init()
 
 	// Create vertex layout
 	VertexLayoutAttrib attribsOverlay[ 2 ] = {
-		{ "vertPos", 0, 2, 0 },
-		{ "texCoords0", 0, 2, 8 }
+		{ "vertPos", 0, 2, 0, 0 },
+		{ "texCoords0", 0, 2, 8, 0 }
 	};
 	_vlOverlay = Modules::renderer().getRenderDevice()->registerVertexLayout( 2, attribsOverlay );
 
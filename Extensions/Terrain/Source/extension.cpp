@@ -34,8 +34,8 @@ bool ExtTerrain::init()
 
 	// Create vertex layout
 	VertexLayoutAttrib attribs[2] = {
-		{"vertPos", 0, 3, 0},
-		{"terHeight", 1, 1, 0}
+		{"vertPos", 0, 3, 0, 0},
+		{"terHeight", 1, 1, 0, 0}
 	};
 	TerrainNode::vlTerrain = Modules::renderer().getRenderDevice()->registerVertexLayout( 2, attribs );
 
@@ -78,6 +78,25 @@ OpenGL4
 		BlendMode = Add;
 	}
 
+	context LIGHTING_INSTANCED
+	{
+		VertexShader = compile GLSL VS_VOLUME_INSTANCED_GL4;
+		PixelShader = compile GLSL FS_LIGHTING_INSTANCED_GL4;
+		
+		ZWriteEnable = false;
+		BlendMode = Add;
+	}
+
+	context LIGHTING_TILED
+	{
+		VertexShader = compile GLSL VS_FSQUAD_GL4;
+		PixelShader = compile GLSL FS_LIGHTING_TILED_GL4;
+		
+		ZWriteEnable = false;
+		ZEnable = false;
+		BlendMode = Add;
+	}
+
 	context COPY_DEPTH
 	{
 		VertexShader = compile GLSL VS_FSQUAD_GL4;
@@ -105,6 +124,25 @@ OpenGLES3
 		BlendMode = Add;
 	}
 
+	context LIGHTING_INSTANCED
+	{
+		VertexShader = compile GLSL VS_VOLUME_INSTANCED_GL4;
+		PixelShader = compile GLSL FS_LIGHTING_INSTANCED_GL4;
+		
+		ZWriteEnable = false;
+		BlendMode = Add;
+	}
+
+	context LIGHTING_TILED
+	{
+		VertexShader = compile GLSL VS_FSQUAD_GL4;
+		PixelShader = compile GLSL FS_LIGHTING_TILED_GL4;
+		
+		ZWriteEnable = false;
+		ZEnable = false;
+		BlendMode = Add;
+	}
+
 	context COPY_DEPTH
 	{
 		VertexShader = compile GLSL VS_FSQUAD_GL4;
@@ -166,6 +204,35 @@ void main( void )
 	gl_Position = vpos;
 }
 
+[[VS_VOLUME_INSTANCED_GL4]]
+// Light parameters are passed per instance, see Renderer::drawLightVolumesInstanced
+
+uniform mat4 viewProjMat;
+
+layout( location = 0 ) in vec3 vertPos;
+layout( location = 1 ) in vec4 instWorldMat0;
+layout( location = 2 ) in vec4 instWorldMat1;
+layout( location = 3 ) in vec4 instWorldMat2;
+layout( location = 4 ) in vec4 instWorldMat3;
+layout( location = 5 ) in vec4 instLightPos;
+layout( location = 6 ) in vec4 instLightDir;
+layout( location = 7 ) in vec4 instLightColor;
+out vec4 vpos;
+flat out vec4 volLightPos;
+flat out vec4 volLightDir;
+flat out vec3 volLightColor;
+				
+void main( void )
+{
+	mat4 worldMat = mat4( instWorldMat0, instWorldMat1, instWorldMat2, instWorldMat3 );
+	volLightPos = instLightPos;
+	volLightDir = instLightDir;
+	volLightColor = instLightColor.rgb;
+	
+	vpos = viewProjMat * worldMat * vec4( vertPos, 1 );
+	gl_Position = vpos;
+}
+
 
 [[FS_AMBIENT]]
 
@@ -230,11 +297,12 @@ void main( void )
 #include "shaders/utilityLib/fragDeferredRead.glsl"
 
 uniform mat4 viewMat;
+uniform vec2 viewportScale;
 varying vec4 vpos;
 
 void main( void )
 {
-	vec2 fragCoord = (vpos.xy / vpos.w) * 0.5 + 0.5;
+	vec2 fragCoord = ((vpos.xy / vpos.w) * 0.5 + 0.5) * viewportScale;
 	
 	if( getMatID( fragCoord ) == 1.0 )	// Standard phong material
 	{
@@ -255,13 +323,14 @@ void main( void )
 #include "shaders/utilityLib/fragDeferredReadGL4.glsl"
 
 uniform mat4 viewMat;
+uniform vec2 viewportScale;
 in vec4 vpos;
 
 out vec4 fragColor;
 
 void main( void )
 {
-	vec2 fragCoord = (vpos.xy / vpos.w) * 0.5 + 0.5;
+	vec2 fragCoord = ((vpos.xy / vpos.w) * 0.5 + 0.5) * viewportScale;
 	
 	if( getMatID( fragCoord ) == 1.0 )	// Standard phong material
 	{
@@ -275,6 +344,81 @@ void main( void )
 	else discard;
 }
 
+[[FS_LIGHTING_INSTANCED_GL4]]
+
+#include "shaders/utilityLib/fragLightingGL4.glsl"
+#include "shaders/utilityLib/fragDeferredReadGL4.glsl"
+
+uniform vec2 viewportScale;
+in vec4 vpos;
+flat in vec4 volLightPos;
+flat in vec4 volLightDir;
+flat in vec3 volLightColor;
+
+out vec4 fragColor;
+
+void main( void )
+{
+	vec2 fragCoord = ((vpos.xy / vpos.w) * 0.5 + 0.5) * viewportScale;
+	
+	if( getMatID( fragCoord ) == 1.0 )	// Standard phong material
+	{
+		vec3 pos = getPos( fragCoord ) + viewerPos;
+		vec4 specParams = getSpecParams( fragCoord );
+		
+		fragColor.rgb = calcPhongSpotLightUnshadowed( volLightPos, volLightDir, volLightColor, pos, getNormal( fragCoord ),
+													  getAlbedo( fragCoord ), specParams.rgb, specParams.a );
+	}
+	else discard;
+}
+
+[[FS_LIGHTING_TILED_GL4]]
+// Lights affecting the screen tile are looked up in textures filled by Renderer::drawTiledLights
+
+#include "shaders/utilityLib/fragLightingGL4.glsl"
+#include "shaders/utilityLib/fragDeferredReadGL4.glsl"
+
+uniform sampler2D tileLights;
+uniform sampler2D tileLightIndices;
+uniform vec4 tileParams;  // Tiles per viewport in x and y, tiles per row, texture width
+in vec2 texCoords;
+
+out vec4 fragColor;
+
+vec4 fetchTexel( sampler2D tex, int index )
+{
+	int width = int( tileParams.w );
+	return texelFetch( tex, ivec2( index % width, index / width ), 0 );
+}
+
+void main( void )
+{
+	if( getMatID( texCoords ) == 1.0 )	// Standard phong material
+	{
+		vec3 pos = getPos( texCoords ) + viewerPos;
+		vec3 normal = getNormal( texCoords );
+		vec3 albedo = getAlbedo( texCoords );
+		vec4 specParams = getSpecParams( texCoords );
+		
+		ivec2 tile = min( ivec2( texCoords * tileParams.xy ), ivec2( ceil( tileParams.xy ) ) - 1 );
+		vec4 header = fetchTexel( tileLightIndices, tile.y * int( tileParams.z ) + tile.x );
+		int first = int( header.x ), count = int( header.y );
+		
+		vec3 color = vec3( 0.0 );
+		for( int i = 0; i < count; ++i )
+		{
+			int slot = first + i;
+			int light = int( fetchTexel( tileLightIndices, slot / 4 )[slot % 4] );
+			
+			color += calcPhongSpotLightUnshadowed( fetchTexel( tileLights, light * 3 ), fetchTexel( tileLights, light * 3 + 1 ),
+												   fetchTexel( tileLights, light * 3 + 2 ).rgb, pos, normal, albedo,
+												   specParams.rgb, specParams.a );
+		}
+		fragColor.rgb = color;
+	}
+	else discard;
+}
+
 
 [[FS_COPY_DEPTH]]
 
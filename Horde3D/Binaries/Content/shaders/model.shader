@@ -88,6 +88,12 @@ OpenGL4
 		PixelShader = compile GLSL FS_SHADOWMAP_GL4;
 	}
 
+	context SHADOWMAP_CASCADES
+	{
+		VertexShader = compile GLSL VS_SHADOWMAP_CASCADES_GL4;
+		PixelShader = compile GLSL FS_SHADOWMAP_GL4;
+	}
+
 	context LIGHTING
 	{
 		VertexShader = compile GLSL VS_GENERAL_GL4;
@@ -552,6 +558,53 @@ void main( void )
 	gl_Position = viewProjMat * pos;
 }
 
+
+[[VS_SHADOWMAP_CASCADES_GL4]]
+// =================================================================================================
+// Renders one instance per shadow cascade, each instance is clipped to the region of its cascade
+	
+#include "shaders/utilityLib/vertCommon.glsl"
+#include "shaders/utilityLib/vertSkinningGL4.glsl"
+
+uniform mat4 shadowCascadeMats[4];
+uniform vec4 shadowCascadeRegions[4];
+uniform float shadowCascadeFirst;
+uniform vec4 lightPos;
+
+layout( location = 0 ) in vec3 vertPos;
+out vec3 lightVec;
+
+#ifdef _F05_AlphaTest
+	layout( location = 5 ) in vec2 texCoords0;
+	out vec2 texCoords;
+#endif
+
+void main( void )
+{
+#ifdef _F01_Skinning	
+	vec4 pos = calcWorldPos( skinPos( vec4( vertPos, 1.0 ) ) );
+#else
+	vec4 pos = calcWorldPos( vec4( vertPos, 1.0 ) );
+#endif
+
+#ifdef _F05_AlphaTest
+	texCoords = texCoords0;
+#endif
+
+	int cascade = int( shadowCascadeFirst ) + gl_InstanceID;
+	vec4 clipPos = shadowCascadeMats[cascade] * pos;
+	vec4 region = shadowCascadeRegions[cascade];
+
+	// Region is given in normalized device coordinates: min x, min y, max x, max y
+	gl_ClipDistance[0] = clipPos.x - region.x * clipPos.w;
+	gl_ClipDistance[1] = clipPos.y - region.y * clipPos.w;
+	gl_ClipDistance[2] = region.z * clipPos.w - clipPos.x;
+	gl_ClipDistance[3] = region.w * clipPos.w - clipPos.y;
+
+	lightVec = lightPos.xyz - pos.xyz;
+	gl_Position = clipPos;
+}
+
 	
 [[FS_SHADOWMAP]]
 // =================================================================================================
@@ -0,0 +1,133 @@
+[[FX]]
+
+// Samplers
+sampler2D depthBuf = sampler_state
+{
+	Address = Clamp;
+	Filter = None;
+};
+
+// Contexts
+OpenGL4
+{
+	context BUILD_PYRAMID
+	{
+		ComputeShader = compile GLSL CS_BUILD_PYRAMID_GL4;
+	}
+
+	context TEST_BOXES
+	{
+		ComputeShader = compile GLSL CS_TEST_BOXES_GL4;
+	}
+}
+
+
+[[CS_BUILD_PYRAMID_GL4]]
+// =================================================================================================
+
+uniform sampler2D depthBuf;
+uniform vec4 occPyramidParams;  // Level, number of levels, size of viewport in depth buffer
+uniform vec4 occPyramidLevels[16];  // Offset and size of each level in the pyramid texture
+
+layout( r32f, binding = 7 ) uniform image2D depthPyramid;
+
+layout( local_size_x = 8, local_size_y = 8 ) in;
+
+void main()
+{
+	int level = int( occPyramidParams.x );
+	ivec4 dst = ivec4( occPyramidLevels[level] );
+	ivec2 coords = ivec2( gl_GlobalInvocationID.xy );
+	if( coords.x >= dst.z || coords.y >= dst.w ) return;
+
+	ivec4 src = level == 0 ? ivec4( 0, 0, ivec2( occPyramidParams.zw ) ) : ivec4( occPyramidLevels[level - 1] );
+
+	// Texels at the border of odd sized sources also cover the last row or column
+	ivec2 count = ivec2( coords.x == dst.z - 1 && (src.z & 1) == 1 ? 3 : 2,
+	                     coords.y == dst.w - 1 && (src.w & 1) == 1 ? 3 : 2 );
+
+	float maxDepth = 0.0;
+	for( int y = 0; y < count.y; ++y )
+	{
+		for( int x = 0; x < count.x; ++x )
+		{
+			ivec2 p = min( coords * 2 + ivec2( x, y ), src.zw - 1 );
+			float depth = level == 0 ? texelFetch( depthBuf, p, 0 ).r : imageLoad( depthPyramid, src.xy + p ).r;
+			maxDepth = max( maxDepth, depth );
+		}
+	}
+
+	imageStore( depthPyramid, dst.xy + coords, vec4( maxDepth ) );
+}
+
+
+[[CS_TEST_BOXES_GL4]]
+// =================================================================================================
+
+uniform mat4 viewProjMat;
+uniform vec4 occPyramidParams;  // Unused, number of levels, number of boxes, unused
+uniform vec4 occPyramidLevels[16];
+
+layout( r32f, binding = 7 ) uniform readonly image2D depthPyramid;
+
+layout( std430, binding = 0 ) readonly buffer OcclusionBoxes
+{
+	vec4 boxes[];  // Min and max corner of each box
+};
+
+layout( std430, binding = 1 ) buffer OcclusionResults
+{
+	uint occluded[];  // One bit per box
+};
+
+layout( local_size_x = 64 ) in;
+
+void main()
+{
+	uint index = gl_GlobalInvocationID.x;
+	if( index >= uint( occPyramidParams.z ) ) return;
+
+	vec3 bbMin = boxes[index * 2u].xyz;
+	vec3 bbMax = boxes[index * 2u + 1u].xyz;
+
+	// Screen rectangle and nearest depth of the box
+	vec2 rectMin = vec2( 1.0 ), rectMax = vec2( 0.0 );
+	float minDepth = 1.0;
+	for( int i = 0; i < 8; ++i )
+	{
+		vec3 corner = vec3( (i & 1) != 0 ? bbMax.x : bbMin.x,
+		                    (i & 2) != 0 ? bbMax.y : bbMin.y,
+		                    (i & 4) != 0 ? bbMax.z : bbMin.z );
+		vec4 clipPos = viewProjMat * vec4( corner, 1.0 );
+
+		// Boxes reaching behind the viewer are always visible
+		if( clipPos.w <= 0.0 ) return;
+
+		vec3 ndc = clipPos.xyz / clipPos.w;
+		rectMin = min( rectMin, ndc.xy * 0.5 + 0.5 );
+		rectMax = max( rectMax, ndc.xy * 0.5 + 0.5 );
+		minDepth = min( minDepth, ndc.z * 0.5 + 0.5 );
+	}
+	if( minDepth <= 0.0 ) return;
+	rectMin = clamp( rectMin, 0.0, 1.0 );
+	rectMax = clamp( rectMax, 0.0, 1.0 );
+
+	// Choose the level at which the rectangle spans about two texels
+	vec2 size = (rectMax - rectMin) * occPyramidLevels[0].zw;
+	int level = clamp( int( ceil( log2( max( max( size.x, size.y ), 1.0 ) ) ) ), 0, int( occPyramidParams.y ) - 1 );
+	ivec4 lvl = ivec4( occPyramidLevels[level] );
+
+	// Texels are widened by one to stay conservative with rounded level sizes
+	ivec2 p0 = clamp( ivec2( rectMin * vec2( lvl.zw ) ) - 1, ivec2( 0 ), lvl.zw - 1 );
+	ivec2 p1 = clamp( ivec2( rectMax * vec2( lvl.zw ) ) + 1, ivec2( 0 ), lvl.zw - 1 );
+
+	float maxDepth = 0.0;
+	for( int y = p0.y; y <= p1.y; ++y )
+	{
+		for( int x = p0.x; x <= p1.x; ++x )
+			maxDepth = max( maxDepth, imageLoad( depthPyramid, lvl.xy + ivec2( x, y ) ).r );
+	}
+
+	if( minDepth > maxDepth )
+		atomicOr( occluded[index >> 5u], 1u << (index & 31u) );
+}
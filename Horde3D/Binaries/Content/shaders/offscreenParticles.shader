@@ -0,0 +1,190 @@
+[[FX]]
+
+// Samplers
+sampler2D depthBuf = sampler_state
+{
+	Address = Clamp;
+	Filter = None;
+};
+
+sampler2D particleBuf = sampler_state
+{
+	Address = Clamp;
+};
+
+sampler2D particleDepthBuf = sampler_state
+{
+	Address = Clamp;
+	Filter = None;
+};
+
+// Contexts
+context DOWNSAMPLE_DEPTH
+{
+	VertexShader = compile GLSL VS_FSQUAD;
+	PixelShader = compile GLSL FS_DOWNSAMPLE_DEPTH;
+}
+
+context COMPOSITE
+{
+	VertexShader = compile GLSL VS_FSQUAD;
+	PixelShader = compile GLSL FS_COMPOSITE;
+
+	ZWriteEnable = false;
+	ZEnable = false;
+	BlendMode = { One, SrcAlpha };
+}
+
+OpenGL4
+{
+	context DOWNSAMPLE_DEPTH
+	{
+		VertexShader = compile GLSL VS_FSQUAD_GL4;
+		PixelShader = compile GLSL FS_DOWNSAMPLE_DEPTH_GL4;
+	}
+
+	context COMPOSITE
+	{
+		VertexShader = compile GLSL VS_FSQUAD_GL4;
+		PixelShader = compile GLSL FS_COMPOSITE_GL4;
+
+		ZWriteEnable = false;
+		ZEnable = false;
+		BlendMode = { One, SrcAlpha };
+	}
+}
+
+OpenGLES3
+{
+	context DOWNSAMPLE_DEPTH
+	{
+		VertexShader = compile GLSL VS_FSQUAD_GL4;
+		PixelShader = compile GLSL FS_DOWNSAMPLE_DEPTH_GL4;
+	}
+
+	context COMPOSITE
+	{
+		VertexShader = compile GLSL VS_FSQUAD_GL4;
+		PixelShader = compile GLSL FS_COMPOSITE_GL4;
+
+		ZWriteEnable = false;
+		ZEnable = false;
+		BlendMode = { One, SrcAlpha };
+	}
+}
+
+[[VS_FSQUAD]]
+// =================================================================================================
+
+uniform mat4 projMat;
+attribute vec3 vertPos;
+varying vec2 texCoords;
+
+void main( void )
+{
+	texCoords = vertPos.xy;
+	gl_Position = projMat * vec4( vertPos, 1 );
+}
+
+[[VS_FSQUAD_GL4]]
+// =================================================================================================
+
+uniform mat4 projMat;
+
+layout( location = 0 ) in vec3 vertPos;
+out vec2 texCoords;
+
+void main( void )
+{
+	texCoords = vertPos.xy;
+	gl_Position = projMat * vec4( vertPos, 1 );
+}
+
+
+[[FS_DOWNSAMPLE_DEPTH]]
+// =================================================================================================
+
+uniform sampler2D depthBuf;
+varying vec2 texCoords;
+
+void main( void )
+{
+	// Alpha of the particle buffer accumulates the transmittance of the background
+	gl_FragColor = vec4( 0.0, 0.0, 0.0, 1.0 );
+	gl_FragDepth = texture2D( depthBuf, texCoords ).r;
+}
+
+[[FS_DOWNSAMPLE_DEPTH_GL4]]
+// =================================================================================================
+// Keeps the farthest of the covered depth samples so that particles are not rejected at
+// silhouettes, the composite pass resolves the edges against the full resolution depth
+
+uniform sampler2D depthBuf;
+in vec2 texCoords;
+
+out vec4 fragColor;
+
+void main( void )
+{
+	vec2 texel = 0.5 / vec2( textureSize( depthBuf, 0 ) );
+
+	float depth = max( max( texture( depthBuf, texCoords + vec2( -texel.x, -texel.y ) ).r,
+	                        texture( depthBuf, texCoords + vec2( texel.x, -texel.y ) ).r ),
+	                   max( texture( depthBuf, texCoords + vec2( -texel.x, texel.y ) ).r,
+	                        texture( depthBuf, texCoords + vec2( texel.x, texel.y ) ).r ) );
+
+	fragColor = vec4( 0.0, 0.0, 0.0, 1.0 );
+	gl_FragDepth = depth;
+}
+
+
+[[FS_COMPOSITE]]
+// =================================================================================================
+
+uniform sampler2D particleBuf;
+uniform vec2 viewportScale;
+varying vec2 texCoords;
+
+void main( void )
+{
+	gl_FragColor = texture2D( particleBuf, texCoords / viewportScale );
+}
+
+[[FS_COMPOSITE_GL4]]
+// =================================================================================================
+// Depth-aware upsampling: the bilinear weights of the four nearest low resolution texels are
+// attenuated by how much their depth differs from the full resolution depth of the pixel
+
+uniform sampler2D particleBuf;
+uniform sampler2D particleDepthBuf;
+uniform sampler2D depthBuf;
+uniform vec2 viewportScale;
+in vec2 texCoords;
+
+out vec4 fragColor;
+
+void main( void )
+{
+	vec2 size = vec2( textureSize( particleBuf, 0 ) );
+	vec2 coords = texCoords / viewportScale * size - 0.5;
+	vec2 base = floor( coords );
+	vec2 f = coords - base;
+
+	float depth = texture( depthBuf, texCoords ).r;
+
+	vec4 col = vec4( 0.0 );
+	float weightSum = 0.0;
+	for( int i = 0; i < 4; ++i )
+	{
+		vec2 offset = vec2( float( i - (i / 2) * 2 ), float( i / 2 ) );
+		vec2 uv = (base + offset + 0.5) / size;
+
+		vec2 bilinear = mix( 1.0 - f, f, offset );
+		float weight = bilinear.x * bilinear.y / (abs( texture( particleDepthBuf, uv ).r - depth ) + 0.0001);
+
+		col += texture( particleBuf, uv ) * weight;
+		weightSum += weight;
+	}
+
+	fragColor = col / max( weightSum, 0.00001 );
+}
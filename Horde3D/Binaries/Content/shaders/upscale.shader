@@ -0,0 +1,109 @@
+[[FX]]
+
+// Samplers
+sampler2D buf0 = sampler_state
+{
+	Address = Clamp;
+};
+
+// Uniforms
+float sharpness = 0.25;  // Strength of the sharpening applied after upscaling (0 disables it)
+
+// Contexts
+context UPSCALE
+{
+	VertexShader = compile GLSL VS_FSQUAD;
+	PixelShader = compile GLSL FS_UPSCALE;
+	
+	ZWriteEnable = false;
+}
+
+OpenGL4
+{
+	context UPSCALE
+	{
+		VertexShader = compile GLSL VS_FSQUAD_GL4;
+		PixelShader = compile GLSL FS_UPSCALE_GL4;
+		
+		ZWriteEnable = false;
+	}
+}
+
+OpenGLES3
+{
+	context UPSCALE
+	{
+		VertexShader = compile GLSL VS_FSQUAD_GL4;
+		PixelShader = compile GLSL FS_UPSCALE_GL4;
+		
+		ZWriteEnable = false;
+	}
+}
+
+[[VS_FSQUAD]]
+// =================================================================================================
+
+uniform mat4 projMat;
+attribute vec3 vertPos;
+varying vec2 texCoords;
+				
+void main( void )
+{
+	texCoords = vertPos.xy; 
+	gl_Position = projMat * vec4( vertPos, 1 );
+}
+
+[[VS_FSQUAD_GL4]]
+// =================================================================================================
+
+uniform mat4 projMat;
+
+layout( location = 0 ) in vec3 vertPos;
+out vec2 texCoords;
+				
+void main( void )
+{
+	texCoords = vertPos.xy; 
+	gl_Position = projMat * vec4( vertPos, 1 );
+}
+
+
+[[FS_UPSCALE]]
+// =================================================================================================
+
+uniform sampler2D buf0;
+varying vec2 texCoords;
+
+void main( void )
+{
+	gl_FragColor = texture2D( buf0, texCoords );
+}
+
+[[FS_UPSCALE_GL4]]
+// =================================================================================================
+// Bilinear upscale of the rendered part of a dynamic resolution target with a cross shaped
+// unsharp mask to restore some of the detail lost by the lower resolution
+
+uniform sampler2D buf0;
+uniform vec2 viewportScale;
+uniform float sharpness;
+in vec2 texCoords;
+
+out vec4 fragColor;
+
+void main( void )
+{
+	vec2 texel = 1.0 / vec2( textureSize( buf0, 0 ) );
+	
+	// Texels outside of the rendered area contain stale data
+	vec2 minCoord = texel * 0.5;
+	vec2 maxCoord = viewportScale - texel * 0.5;
+	
+	vec4 col = texture( buf0, clamp( texCoords, minCoord, maxCoord ) );
+	vec4 blur = texture( buf0, clamp( texCoords + vec2( texel.x, 0.0 ), minCoord, maxCoord ) ) +
+	            texture( buf0, clamp( texCoords - vec2( texel.x, 0.0 ), minCoord, maxCoord ) ) +
+	            texture( buf0, clamp( texCoords + vec2( 0.0, texel.y ), minCoord, maxCoord ) ) +
+	            texture( buf0, clamp( texCoords - vec2( 0.0, texel.y ), minCoord, maxCoord ) );
+	
+	fragColor = max( col + (col - blur * 0.25) * sharpness, 0.0 );
+}
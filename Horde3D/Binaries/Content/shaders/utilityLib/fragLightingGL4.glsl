@@ -35,16 +35,18 @@ float PCF( const vec4 projShadow )
 }
 
 
-vec3 calcPhongSpotLight( const vec3 pos, const vec3 normal, const vec3 albedo, const vec3 specColor,
-						 const float gloss, const float viewDist, const float ambientIntensity )
+vec3 calcPhongSpotLightTerms( const vec4 lightPos, const vec4 lightDir, const vec3 pos, const vec3 normal,
+							  const vec3 albedo, const vec3 specColor, const float gloss,
+							  out float atten, out float lightDepth )
 {
+	// Attenuation and BRDF shared by the shadowed and unshadowed spot lights
 	vec3 light = lightPos.xyz - pos;
 	float lightLen = length( light );
 	light /= lightLen;
 	
 	// Distance attenuation
-	float lightDepth = lightLen / lightPos.w;
-	float atten = max( 1.0 - lightDepth * lightDepth, 0.0 );
+	lightDepth = lightLen / lightPos.w;
+	atten = max( 1.0 - lightDepth * lightDepth, 0.0 );
 	
 	// Spotlight falloff
 	float angle = dot( lightDir.xyz, -light );
@@ -61,6 +63,16 @@ vec3 calcPhongSpotLight( const vec3 pos, const vec3 normal, const vec3 albedo, c
 	vec3 specular = specColor * pow( max( dot( halfVec, normal ), 0.0 ), specExp );
 	specular *= (specExp * 0.125 + 0.25);  // Normalization factor (n+2)/8
 	
+	return albedo + specular;
+}
+
+
+vec3 calcPhongSpotLight( const vec3 pos, const vec3 normal, const vec3 albedo, const vec3 specColor,
+						 const float gloss, const float viewDist, const float ambientIntensity )
+{
+	float atten, lightDepth;
+	vec3 brdf = calcPhongSpotLightTerms( lightPos, lightDir, pos, normal, albedo, specColor, gloss, atten, lightDepth );
+	
 	// Shadows
 	float shadowTerm = 1.0;
 	if( atten * (shadowMapSize - 4.0) > 0.0 )  // Skip shadow mapping if default shadow map (size==4) is bound
@@ -77,5 +89,17 @@ vec3 calcPhongSpotLight( const vec3 pos, const vec3 normal, const vec3 albedo, c
 	}
 	
 	// Final color
-	return (albedo + specular) * lightColor * atten * shadowTerm;
+	return brdf * lightColor * atten * shadowTerm;
+}
+
+
+vec3 calcPhongSpotLightUnshadowed( const vec4 lightPos, const vec4 lightDir, const vec3 lightColor,
+								   const vec3 pos, const vec3 normal, const vec3 albedo, const vec3 specColor,
+								   const float gloss )
+{
+	// Light parameters are passed in, e.g. from instance data
+	float atten, lightDepth;
+	vec3 brdf = calcPhongSpotLightTerms( lightPos, lightDir, pos, normal, albedo, specColor, gloss, atten, lightDepth );
+	
+	return brdf * lightColor * atten;
 }
@@ -34,12 +34,14 @@ public static int H3DRootNode
         /// OpenGL2	- use OpenGL 2 as renderer backend (can be used to force OpenGL 2 when higher version is undesirable)
         /// OpenGL4	- use OpenGL 4 as renderer backend (falls back to OpenGL 2 in case of error)
         /// OpenGLES3 - use OpenGL ES 3 as renderer backend
+        /// Null - use a backend that performs no rendering and requires no graphics context (for tests and benchmarks)
         /// </summary>
         public enum H3DRenderDevice
         {
             OpenGL2 = 2,
             OpenGL4 = 4,
-            OpenGLES3 = 8
+            OpenGLES3 = 8,
+            Null = 16
         };
 
         /// <summary>
@@ -67,6 +69,22 @@ public enum H3DRenderDevice
         ///   GatherTimeStats     - Enables or disables gathering of time stats that are useful for profiling (Values: 0, 1; Default: 1)
         ///   DebugRenderBackend  - Enables or disables logging of render backend diagnostic messages. May require additional actions on 
 		///					        application side, like creating a debug opengl context. (Values: 0, 1; Default: 0)
+        ///   ShadowAtlasSize     - Sets the size of the shadow atlas; if not 0, the shadow maps of all visible lights are packed
+        ///                         into the atlas and rendered together before lighting instead of one after another into the
+        ///                         shadow map buffer. (Values: 0, 2048, 4096, 8192; Default: 0)
+        ///   DynResTargetTime    - GPU time budget in ms for rendering the pipelines that have dynamic resolution enabled; the
+        ///                         render resolution of these pipelines is adjusted each frame to meet the budget, 0 disables
+        ///                         the adjustment (Default: 0)
+        ///   DynResMinScale      - Lowest resolution scale used by dynamic resolution (Values: 0.1 - 1.0; Default: 0.5)
+        ///   AsyncShaderCompilation - Enables or disables asynchronous compilation of shader combinations; combinations
+        ///                         that are not ready yet are not drawn or drawn with a fallback (Values: 0, 1; Default: 0)
+        ///   AsyncShaderFallback - Draws with the base combination of a shader context (no flags set) while the requested
+        ///                         combination is still compiling instead of skipping the draw (Values: 0, 1; Default: 1)
+        ///   MaxFramesInFlight   - Maximum number of frames the GPU may lag behind the CPU; h3dFinalizeFrame waits on a
+        ///                         fence until the GPU has caught up, 0 leaves the queue depth to the driver (Values: 0, 1, 2, 3;
+        ///                         Default: 0)
+        ///   LateLatchCamera     - Takes over the camera transformation that was set between h3dPrepareRender and h3dRender
+        ///                         for drawing; culling still uses the camera of h3dPrepareRender (Values: 0, 1; Default: 0)
         /// </summary>
         public enum H3DOptions
         {
@@ -84,7 +102,14 @@ public enum H3DOptions
             DebugViewMode,
             DumpFailedShaders,
             GatherTimeStats,
-            DebugRenderBackend
+            DebugRenderBackend,
+            ShadowAtlasSize,
+            DynResTargetTime,
+            DynResMinScale,
+            AsyncShaderCompilation,
+            AsyncShaderFallback,
+            MaxFramesInFlight,
+            LateLatchCamera
         }
 
        /// <summary>
@@ -105,6 +130,25 @@ public enum H3DOptions
        ///    TextureVMem       - Estimated amount of video memory used by textures (in Mb)
        ///    GeometryVMem      - Estimated amount of video memory used by geometry (in Mb)
        ///    ComputeGPUTime    - GPU time in ms spent for processing compute shaders
+       ///    CullingTime       - CPU time in ms spent for culling and building the render queues
+       ///    TiledLightCount   - Number of lights shaded by tiled deferred lighting passes
+       ///    TileCount         - Number of screen tiles processed by tiled deferred lighting
+       ///    TileLightRefs     - Sum of the number of lights over all screen tiles; divided by TileCount
+       ///                        this gives the average tile occupancy
+       ///    TileMaxLights     - Maximum number of lights affecting a single screen tile
+       ///    FrameGPUTime      - GPU time in ms spent for rendering camera pipelines
+       ///    DynResScale       - Current resolution scale of the last rendered pipeline with dynamic resolution
+       ///    OffscreenParticleGPUTime - GPU time in ms spent for reduced resolution particle passes including depth
+       ///                        downsampling and compositing
+       ///    PendingShaderCount - Number of shader combinations whose asynchronous compilation is still in progress;
+       ///                        querying it finishes combinations that became ready
+       ///    FrameWaitTime     - CPU time in ms spent waiting for the GPU because of MaxFramesInFlight
+       ///    GPUIdleTime       - Estimated time in ms the GPU was idle, frame time minus FrameGPUTime; requires
+       ///                        GatherTimeStats
+       ///    ShadowMapCount    - Number of shadow maps (cascades) that were rendered
+       ///    CascadeBatchCount - Number of batches drawing a shadow caster into several cascades with instancing
+       ///    OcclusionTestCount - Number of renderables whose GPU occlusion test results were read back
+       ///    OccludedCount     - Number of renderables that the read back GPU occlusion tests found to be occluded
        /// </summary>
         public enum H3DStats
         {
@@ -121,7 +165,22 @@ public enum H3DStats
             ParticleGPUTime,
             TextureVMem,
             GeometryVMem,
-            ComputeGPUTime
+            ComputeGPUTime,
+            CullingTime,
+            TiledLightCount,
+            TileCount,
+            TileLightRefs,
+            TileMaxLights,
+            FrameGPUTime,
+            DynResScale,
+            OffscreenParticleGPUTime,
+            PendingShaderCount,
+            FrameWaitTime,
+            GPUIdleTime,
+            ShadowMapCount,
+            CascadeBatchCount,
+            OcclusionTestCount,
+            OccludedCount
         }
 
         /// <summary>
@@ -348,6 +407,7 @@ public enum H3DMatRes
         ///   UnifNameStr     - Name of uniform [read-only]
         ///   UnifSizeI       - Size (number of components) of uniform [read-only]
         ///   UnifDefValueF4  - Default value of uniform (a, b, c, d)
+        ///   ContPendingCombsI - Number of combinations of context whose asynchronous compilation is in progress [read-only]
         /// </summary>
         public enum H3DShaderRes
         {
@@ -358,7 +418,8 @@ public enum H3DShaderRes
             SampNameStr,
             UnifNameStr,
             UnifSizeI,
-            UnifDefValueF4
+            UnifDefValueF4,
+            ContPendingCombsI = 609
         }
 
         /// <summary>
@@ -455,6 +516,8 @@ public enum H3DPipeRes
         /// 	DrawParamsOffsetI			- Specifies the offset of parameter in the buffer (in bytes)
         /// 	                              Example: for first parameter offset is 0. For second (if 1st parameter uses 3 floats) it is 12
         /// 	DrawParamsCountI			- Total number of specified vertex binding parameters [read-only]
+        /// 	CompBufMapOffsetI			- Offset in bytes of the range mapped by the next h3dMapResStream call (default: 0)
+        /// 	CompBufMapSizeI				- Size in bytes of the range mapped by the next h3dMapResStream call, 0 for the rest of the buffer (default: 0)
         /// </summary>
         public enum H3DComputeBufRes
         {
@@ -465,7 +528,9 @@ public enum H3DComputeBufRes
             DrawParamsNameStr,
             DrawParamsSizeI,
             DrawParamsOffsetI,
-            DrawParamsCountI
+            DrawParamsCountI,
+            CompBufMapOffsetI,
+            CompBufMapSizeI
         }
 
         /// <summary>
@@ -618,6 +683,9 @@ public enum H3DJoint
         /// ShadowMapBiasF      - Bias value for shadow mapping to reduce shadow acne (default: 0.005)
         /// LightingContextStr  - Name of shader context used for computing lighting
         /// ShadowContextStr    - Name of shader context used for generating shadow map
+        /// ShadowSplitDistsF5  - Distances from the camera at which the view frustum was split into the shadow maps
+        ///                       when the light was last rendered, from the near plane of the first map to the far
+        ///                       plane of the last one (ShadowMapCountI + 1 values) [read-only]
         /// </summary>
         public enum H3DLight
         {
@@ -630,7 +698,8 @@ public enum H3DLight
             ShadowSplitLambdaF,
             ShadowMapBiasF,
             LightingContextStr,
-            ShadowContextStr
+            ShadowContextStr,
+            ShadowSplitDistsF5
         }
 
         /// <summary>
@@ -706,6 +775,10 @@ public enum H3DEmitter
         /// AABBMaxF       - Maximum of the node's AABB (should be set separately for x, y, z components)
         /// DrawTypeI	   - Specifies how to draw data in the buffer. 0 - Triangles, 1 - Lines, 2 - Points
         /// ElementsCountI - Specifies number of elements to draw (Example: for 1000 points - 1000, for 10 triangles - 10)
+        /// IndirectBufResI - Compute buffer resource containing the draw arguments, used instead of ElementsCountI if set
+        /// IndirectOffsetI - Offset in bytes of the draw arguments in the indirect buffer (default: 0)
+        /// ElementsStartI - First element of the buffer that is drawn (default: 0)
+        /// LodDensityF    - Maximum number of elements drawn per covered pixel, 0 to disable subsampling (default: 0)
         /// </summary>
         public enum H3DComputeNode
         {
@@ -714,7 +787,11 @@ public enum H3DComputeNode
             AABBMinF,
             AABBMaxF,
             DrawTypeI,
-            ElementsCountI
+            ElementsCountI,
+            IndirectBufResI,
+            IndirectOffsetI,
+            ElementsStartI,
+            LodDensityF
         }
 
         /// <summary>
@@ -732,6 +809,63 @@ public enum H3DModelUpdateFlags
             ChildNodes = 3
         };
 
+        /// <summary>
+        /// Struct: H3DTransform
+        ///       Relative transformation of a node as used by the batched transformation functions.
+        ///       The layout matches the nine floats per node expected by the engine.
+        /// </summary>
+        [StructLayout(LayoutKind.Sequential)]
+        public struct H3DTransform
+        {
+            public float tx, ty, tz;
+            public float rx, ry, rz;
+            public float sx, sy, sz;
+
+            public H3DTransform(float tx, float ty, float tz, float rx, float ry, float rz, float sx, float sy, float sz)
+            {
+                this.tx = tx; this.ty = ty; this.tz = tz;
+                this.rx = rx; this.ry = ry; this.rz = rz;
+                this.sx = sx; this.sy = sy; this.sz = sz;
+            }
+        };
+
+        /// <summary>
+        /// Struct: H3DMatrix4
+        ///       4x4 matrix in column major order as used by the batched transformation functions.
+        /// </summary>
+        [StructLayout(LayoutKind.Sequential)]
+        public unsafe struct H3DMatrix4
+        {
+            public fixed float c[16];
+        };
+
+        /// <summary>
+        /// Struct: H3DAABB
+        ///       World space axis aligned bounding box as returned by getNodeAABBBatch.
+        /// </summary>
+        [StructLayout(LayoutKind.Sequential)]
+        public struct H3DAABB
+        {
+            public float minX, minY, minZ;
+            public float maxX, maxY, maxZ;
+        };
+
+        /// <summary>
+        /// Struct: H3DAnimParams
+        ///       Animation time and blend weight of a model animation stage as used by setModelAnimParamsBatch.
+        /// </summary>
+        [StructLayout(LayoutKind.Sequential)]
+        public struct H3DAnimParams
+        {
+            public float time;
+            public float weight;
+
+            public H3DAnimParams(float time, float weight)
+            {
+                this.time = time; this.weight = weight;
+            }
+        };
+
 
         // --- Basic functions ---
         /// <summary>
@@ -812,6 +946,18 @@ public static void compute(int materialRes, string context, int groupX, int grou
             NativeMethodsEngine.h3dCompute(materialRes, context, groupX, groupY, groupZ);
         }
 
+        /// <summary>
+        /// Updates the scene, performs culling and copies the render data of all visible nodes to a snapshot.
+        /// A subsequent call of render with the same camera draws from that snapshot, so the scene can
+        /// already be modified for the next frame while the frame is rendered.
+        /// The camera and lights must not be modified and nodes must not be removed until render has returned.
+        /// <param name="node">camera node used for rendering scene</param>
+        /// </summary>       
+        public static void prepareRender(int node)
+        {
+            NativeMethodsEngine.h3dPrepareRender(node);
+        }
+
         /// <summary>
         /// This is the main function of the engine. 
         /// It executes all the rendering, animation and other tasks. 
@@ -1184,6 +1330,39 @@ public static bool loadResource(int res, byte[] data, int size)
             return result;
         }
 
+        /// <summary>
+        /// Reloads a resource with new data.
+        /// </summary>
+        /// <remarks>
+        /// This function replaces the data of a loaded resource while keeping the resource handle and all
+        /// references to it valid. If the data is identical to the data the resource was loaded from, nothing
+        /// is done. Textures with unchanged dimensions and format are updated in place and shaders only
+        /// recompile the contexts whose code changed. If the resource is not loaded yet, the function behaves
+        /// like loadResource. When reloading a shader fails, the previous version is kept.
+        /// </remarks>
+        /// <param name="res">handle to the resource to be reloaded</param>
+        /// <param name="data">the new data</param>
+        /// <param name="size">size of the data block</param>
+        /// <returns>1 if the resource data was replaced, 0 if the data did not change and -1 in case of failure</returns>
+        public static int reloadResource(int res, byte[] data, int size)
+        {
+            if (data == null) throw new ArgumentNullException("data");
+
+            if (data.Length < size)
+                throw new ArgumentException(Resources.LoadResourceArgumentExceptionString, "data");
+
+            // allocate memory for resource data and terminate data block
+            IntPtr ptr = Marshal.AllocHGlobal(size + 1);
+            Marshal.Copy(data, 0, ptr, size);
+            Marshal.WriteByte(ptr, size, 0x00);
+
+            int result = NativeMethodsEngine.h3dReloadResource(res, ptr, size);
+
+            Marshal.FreeHGlobal(ptr);
+
+            return result;
+        }
+
         /// <summary>
         /// This function unloads a previously loaded resource and restores the default values it had before loading. The state is set back to unloaded which makes it possible to load the resource again.
         /// </summary>
@@ -1645,6 +1824,108 @@ public static void setNodeTransMat(int node, float[] mat4x4)
 
             NativeMethodsEngine.h3dSetNodeTransMat(node, mat4x4);
         }
+
+        private static void checkBatchArgs(int[] nodes, int count, int length, string arrayName)
+        {
+            if (nodes == null) throw new ArgumentNullException("nodes");
+            if (count < 0 || count > nodes.Length) throw new ArgumentOutOfRangeException("count");
+            if (count > length) throw new ArgumentOutOfRangeException(arrayName);
+        }
+
+        /// <summary>
+        /// This function is the batched version of getNodeTransform. It stores the relative transformation of the first count nodes
+        /// in the transforms array. The array is pinned during the call, so a whole scene can be read with a single native call.
+        /// </summary>
+        /// <param name="nodes">array of handles to the nodes which will be accessed</param>
+        /// <param name="count">number of nodes to process</param>
+        /// <param name="transforms">array where the transformations will be stored; invalid nodes get zero entries</param>
+        /// <returns>number of valid nodes</returns>
+        public static int getNodeTransformBatch(int[] nodes, int count, H3DTransform[] transforms)
+        {
+            if (transforms == null) throw new ArgumentNullException("transforms");
+            checkBatchArgs(nodes, count, transforms.Length, "transforms");
+
+            return NativeMethodsEngine.h3dGetNodeTransformBatch(nodes, count, transforms);
+        }
+
+        /// <summary>
+        /// This function is the batched version of setNodeTransform. It sets the relative transformation of the first count nodes.
+        /// </summary>
+        /// <param name="nodes">array of handles to the nodes which will be modified</param>
+        /// <param name="count">number of nodes to process</param>
+        /// <param name="transforms">array with the new transformations</param>
+        /// <returns>number of valid nodes</returns>
+        public static int setNodeTransformBatch(int[] nodes, int count, H3DTransform[] transforms)
+        {
+            if (transforms == null) throw new ArgumentNullException("transforms");
+            checkBatchArgs(nodes, count, transforms.Length, "transforms");
+
+            return NativeMethodsEngine.h3dSetNodeTransformBatch(nodes, count, transforms);
+        }
+
+        /// <summary>
+        /// This function is the batched version of getNodeTransMats. Instead of returning pointers to the internal matrices,
+        /// it copies the relative and absolute transformation matrices of the first count nodes to the specified arrays.
+        /// </summary>
+        /// <param name="nodes">array of handles to the nodes which will be accessed</param>
+        /// <param name="count">number of nodes to process</param>
+        /// <param name="relMats">array for the relative transformation matrices (can be null)</param>
+        /// <param name="absMats">array for the absolute transformation matrices (can be null)</param>
+        /// <returns>number of valid nodes</returns>
+        public static int getNodeTransMatsBatch(int[] nodes, int count, H3DMatrix4[] relMats, H3DMatrix4[] absMats)
+        {
+            if (relMats != null) checkBatchArgs(nodes, count, relMats.Length, "relMats");
+            if (absMats != null) checkBatchArgs(nodes, count, absMats.Length, "absMats");
+
+            return NativeMethodsEngine.h3dGetNodeTransMatsBatch(nodes, count, relMats, absMats);
+        }
+
+        /// <summary>
+        /// This function is the batched version of setNodeTransMat. It sets the relative transformation matrices of the first count nodes.
+        /// </summary>
+        /// <param name="nodes">array of handles to the nodes which will be modified</param>
+        /// <param name="count">number of nodes to process</param>
+        /// <param name="mats">array with the new relative transformation matrices</param>
+        /// <returns>number of valid nodes</returns>
+        public static int setNodeTransMatBatch(int[] nodes, int count, H3DMatrix4[] mats)
+        {
+            if (mats == null) throw new ArgumentNullException("mats");
+            checkBatchArgs(nodes, count, mats.Length, "mats");
+
+            return NativeMethodsEngine.h3dSetNodeTransMatBatch(nodes, count, mats);
+        }
+
+        /// <summary>
+        /// Pointer version of getNodeTransformBatch for data that is already pinned or lives in unmanaged memory.
+        /// </summary>
+        public static unsafe int getNodeTransformBatch(int* nodes, int count, H3DTransform* transforms)
+        {
+            return NativeMethodsEngine.h3dGetNodeTransformBatch(nodes, count, transforms);
+        }
+
+        /// <summary>
+        /// Pointer version of setNodeTransformBatch for data that is already pinned or lives in unmanaged memory.
+        /// </summary>
+        public static unsafe int setNodeTransformBatch(int* nodes, int count, H3DTransform* transforms)
+        {
+            return NativeMethodsEngine.h3dSetNodeTransformBatch(nodes, count, transforms);
+        }
+
+        /// <summary>
+        /// Pointer version of getNodeTransMatsBatch for data that is already pinned or lives in unmanaged memory.
+        /// </summary>
+        public static unsafe int getNodeTransMatsBatch(int* nodes, int count, H3DMatrix4* relMats, H3DMatrix4* absMats)
+        {
+            return NativeMethodsEngine.h3dGetNodeTransMatsBatch(nodes, count, relMats, absMats);
+        }
+
+        /// <summary>
+        /// Pointer version of setNodeTransMatBatch for data that is already pinned or lives in unmanaged memory.
+        /// </summary>
+        public static unsafe int setNodeTransMatBatch(int* nodes, int count, H3DMatrix4* mats)
+        {
+            return NativeMethodsEngine.h3dSetNodeTransMatBatch(nodes, count, mats);
+        }
    
         /// <summary>
         /// Gets a property of a scene node.
@@ -1769,6 +2050,30 @@ public static bool getNodeAABB(int node, out float minX, out float minY, out flo
             return NativeMethodsEngine.h3dGetNodeAABB(node, out minX, out minY, out minZ, out maxX, out maxY, out maxZ);
         }
 
+        /// <summary>
+        /// This function is the batched version of getNodeAABB. It stores the world space bounding boxes of the first count nodes
+        /// in the aabbs array.
+        /// </summary>
+        /// <param name="nodes">array of handles to the nodes which will be accessed</param>
+        /// <param name="count">number of nodes to process</param>
+        /// <param name="aabbs">array where the bounding boxes will be stored; invalid nodes get zero entries</param>
+        /// <returns>number of valid nodes</returns>
+        public static int getNodeAABBBatch(int[] nodes, int count, H3DAABB[] aabbs)
+        {
+            if (aabbs == null) throw new ArgumentNullException("aabbs");
+            checkBatchArgs(nodes, count, aabbs.Length, "aabbs");
+
+            return NativeMethodsEngine.h3dGetNodeAABBBatch(nodes, count, aabbs);
+        }
+
+        /// <summary>
+        /// Pointer version of getNodeAABBBatch for data that is already pinned or lives in unmanaged memory.
+        /// </summary>
+        public static unsafe int getNodeAABBBatch(int* nodes, int count, H3DAABB* aabbs)
+        {
+            return NativeMethodsEngine.h3dGetNodeAABBBatch(nodes, count, aabbs);
+        }
+
         // added (h3d 1.0)
         /// <summary>
         /// Finds scene nodes with the specified properties.
@@ -1870,6 +2175,60 @@ public static int checkNodeVisibility(int node, int cameraNode, bool checkOcclus
             return NativeMethodsEngine.h3dCheckNodeVisibility(node, cameraNode, checkOcclusion, calcLod);
         }
 
+        /// <summary>
+        /// This function is the batched version of checkNodeVisibility. For each of the first count nodes the computed LOD level
+        /// or -1 if the node is not visible is stored in the results array.
+        /// </summary>
+        /// <param name="nodes">array of nodes to be checked for visibility</param>
+        /// <param name="count">number of nodes to process</param>
+        /// <param name="cameraNode">camera node from which the visibility test is done</param>
+        /// <param name="checkOcclusion">specifies if occlusion info from previous frame should be taken into account</param>
+        /// <param name="calcLod">specifies if LOD level should be computed</param>
+        /// <param name="results">array where the results will be stored</param>
+        /// <returns>number of visible nodes</returns>
+        public static int checkNodeVisibilityBatch(int[] nodes, int count, int cameraNode, bool checkOcclusion, bool calcLod, int[] results)
+        {
+            if (results == null) throw new ArgumentNullException("results");
+            checkBatchArgs(nodes, count, results.Length, "results");
+
+            return NativeMethodsEngine.h3dCheckNodeVisibilityBatch(nodes, count, cameraNode, checkOcclusion, calcLod, results);
+        }
+
+        /// <summary>
+        /// Pointer version of checkNodeVisibilityBatch for data that is already pinned or lives in unmanaged memory.
+        /// </summary>
+        public static unsafe int checkNodeVisibilityBatch(int* nodes, int count, int cameraNode, bool checkOcclusion, bool calcLod, int* results)
+        {
+            return NativeMethodsEngine.h3dCheckNodeVisibilityBatch(nodes, count, cameraNode, checkOcclusion, calcLod, results);
+        }
+
+        /// <summary>
+        /// This function checks which of the first count bounding boxes are inside the frustum of a camera, e.g. for objects
+        /// that are not part of the scene graph. For each box -1 (not visible) or 0 (visible) is stored in the results array.
+        /// </summary>
+        /// <param name="aabbs">array of world space bounding boxes</param>
+        /// <param name="count">number of bounding boxes to process</param>
+        /// <param name="cameraNode">camera node from which the visibility test is done</param>
+        /// <param name="results">array where the results will be stored</param>
+        /// <returns>number of visible bounding boxes</returns>
+        public static int checkAABBVisibilityBatch(H3DAABB[] aabbs, int count, int cameraNode, int[] results)
+        {
+            if (aabbs == null) throw new ArgumentNullException("aabbs");
+            if (results == null) throw new ArgumentNullException("results");
+            if (count < 0 || count > aabbs.Length) throw new ArgumentOutOfRangeException("count");
+            if (count > results.Length) throw new ArgumentOutOfRangeException("results");
+
+            return NativeMethodsEngine.h3dCheckAABBVisibilityBatch(aabbs, count, cameraNode, results);
+        }
+
+        /// <summary>
+        /// Pointer version of checkAABBVisibilityBatch for data that is already pinned or lives in unmanaged memory.
+        /// </summary>
+        public static unsafe int checkAABBVisibilityBatch(H3DAABB* aabbs, int count, int cameraNode, int* results)
+        {
+            return NativeMethodsEngine.h3dCheckAABBVisibilityBatch(aabbs, count, cameraNode, results);
+        }
+
         // Group specific
         /// <summary>
         /// This function creates a new Group node and attaches it to the specified parent node.
@@ -1964,6 +2323,34 @@ public static void setModelAnimParams(int node, int stage, float time, float wei
             NativeMethodsEngine.h3dSetModelAnimParams(node, stage, time, weight);
         }
 
+        /// <summary>
+        /// This function is the batched version of setModelAnimParams. Entry i sets the animation parameters of stage stages[i]
+        /// of model nodes[i], so several stages of the same model can be updated by repeating its handle.
+        /// In contrast to setModelAnimParams, only Model nodes are accepted.
+        /// </summary>
+        /// <param name="nodes">array of handles to the Model nodes to be modified</param>
+        /// <param name="count">number of entries to process</param>
+        /// <param name="stages">array of animation stage indices</param>
+        /// <param name="animParams">array of animation times and weights</param>
+        /// <returns>number of valid entries</returns>
+        public static int setModelAnimParamsBatch(int[] nodes, int count, int[] stages, H3DAnimParams[] animParams)
+        {
+            if (stages == null) throw new ArgumentNullException("stages");
+            if (animParams == null) throw new ArgumentNullException("animParams");
+            checkBatchArgs(nodes, count, stages.Length, "stages");
+            checkBatchArgs(nodes, count, animParams.Length, "animParams");
+
+            return NativeMethodsEngine.h3dSetModelAnimParamsBatch(nodes, count, stages, animParams);
+        }
+
+        /// <summary>
+        /// Pointer version of setModelAnimParamsBatch for data that is already pinned or lives in unmanaged memory.
+        /// </summary>
+        public static unsafe int setModelAnimParamsBatch(int* nodes, int count, int* stages, H3DAnimParams* animParams)
+        {
+            return NativeMethodsEngine.h3dSetModelAnimParamsBatch(nodes, count, stages, animParams);
+        }
+
         /// <summary>
         /// This function sets the weight of a specified morph target. If the target parameter is an empty string the weight of all morph targets in the specified Model node is modified. The function operates on Model nodes but accepts also Group nodes in which case the call is passed recursively to the Model child nodes. If the specified morph target is not found the function returns false.
         /// </summary>
@@ -78,6 +78,52 @@ public static bool loadResourcesFromDisk(string contenDir)
             return NativeMethodsUtils.h3dutLoadResourcesFromDisk(contenDir);
         }
 
+        /// <summary>
+        /// Returns the number of resources that the last call of loadResourcesFromDisk loaded from files read in the background.
+        /// </summary>
+        /// <returns>number of prefetched resources</returns>
+        public static int getNumPrefetchedResources()
+        {
+            return NativeMethodsUtils.h3dutGetNumPrefetchedResources();
+        }
+
+        /// <summary>
+        /// Releases the memory mappings of all pack files opened by loadResourcesFromDisk.
+        /// </summary>
+        public static void closePackFiles()
+        {
+            NativeMethodsUtils.h3dutClosePackFiles();
+        }
+
+        /// <summary>
+        /// Starts watching the specified content directories for changed resource files.
+        /// </summary>
+        /// <param name="contentDir">directories where data is located on the drive, using the same search order as loadResourcesFromDisk</param>
+        /// <returns>true in case of success, otherwise false</returns>
+        public static bool watchResourceChanges(string contentDir)
+        {
+            if (contentDir == null) throw new ArgumentNullException("contentDir", Resources.StringNullExceptionString);
+
+            return NativeMethodsUtils.h3dutWatchResourceChanges(contentDir);
+        }
+
+        /// <summary>
+        /// Reloads all loaded resources whose files have changed since the last call.
+        /// </summary>
+        /// <returns>number of resources whose data was actually replaced</returns>
+        public static int reloadChangedResources()
+        {
+            return NativeMethodsUtils.h3dutReloadChangedResources();
+        }
+
+        /// <summary>
+        /// Stops watching content directories for changed resource files.
+        /// </summary>
+        public static void stopWatchingResourceChanges()
+        {
+            NativeMethodsUtils.h3dutStopWatchingResourceChanges();
+        }
+
         /// <summary>
         /// Creates a Geometry resource from specified vertex data.
         /// </summary>
@@ -43,6 +43,22 @@ internal static class NativeMethodsUtils
         [return: MarshalAs(UnmanagedType.U1)]   // represents C++ bool type 
         internal static extern bool h3dutLoadResourcesFromDisk(string contentDir);
 
+        [DllImport(UTILS_DLL, CallingConvention = CallingConvention.Cdecl), SuppressUnmanagedCodeSecurity]
+        internal static extern int h3dutGetNumPrefetchedResources();
+
+        [DllImport(UTILS_DLL, CallingConvention = CallingConvention.Cdecl), SuppressUnmanagedCodeSecurity]
+        internal static extern void h3dutClosePackFiles();
+
+        [DllImport(UTILS_DLL, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl), SuppressUnmanagedCodeSecurity]
+        [return: MarshalAs(UnmanagedType.U1)]   // represents C++ bool type 
+        internal static extern bool h3dutWatchResourceChanges(string contentDir);
+
+        [DllImport(UTILS_DLL, CallingConvention = CallingConvention.Cdecl), SuppressUnmanagedCodeSecurity]
+        internal static extern int h3dutReloadChangedResources();
+
+        [DllImport(UTILS_DLL, CallingConvention = CallingConvention.Cdecl), SuppressUnmanagedCodeSecurity]
+        internal static extern void h3dutStopWatchingResourceChanges();
+
         [DllImport(UTILS_DLL, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl), SuppressUnmanagedCodeSecurity]        
         internal static extern int h3dutCreateGeometryRes(string name, int numVertices, int numTriangleIndices,
                                            float[] posData, int[] indexData, short[] normalData,
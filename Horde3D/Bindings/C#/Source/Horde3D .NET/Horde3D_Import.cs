@@ -55,6 +55,9 @@ internal static class NativeMethodsEngine
 
         //horde3d 1.0
         [DllImport(ENGINE_DLL, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl), SuppressUnmanagedCodeSecurity]        
+        internal static extern void h3dPrepareRender(int node);
+
+        [DllImport(ENGINE_DLL, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl), SuppressUnmanagedCodeSecurity]
         internal static extern void h3dRender(int node);
         /////
 
@@ -137,6 +140,9 @@ internal static class NativeMethodsEngine
         [return: MarshalAs(UnmanagedType.U1)]   // represents C++ bool type 
         internal static extern bool h3dLoadResource(int name, IntPtr data, int size);
 
+        [DllImport(ENGINE_DLL, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl), SuppressUnmanagedCodeSecurity]
+        internal static extern int h3dReloadResource(int res, IntPtr data, int size);
+
         [DllImport(ENGINE_DLL, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl), SuppressUnmanagedCodeSecurity]        
         internal static extern void h3dUnloadResource(int res);
 
@@ -240,6 +246,31 @@ internal static class NativeMethodsEngine
         [DllImport(ENGINE_DLL, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl), SuppressUnmanagedCodeSecurity]        
         internal static extern void h3dSetNodeTransMat(int node, float[] mat4x4);
 
+        // Batched calls; arrays of blittable structs are pinned by the marshaller and not copied
+        [DllImport(ENGINE_DLL, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl), SuppressUnmanagedCodeSecurity]
+        internal static extern int h3dGetNodeTransformBatch(int[] nodes, int count, [Out] h3d.H3DTransform[] transforms);
+
+        [DllImport(ENGINE_DLL, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl), SuppressUnmanagedCodeSecurity]
+        internal static extern int h3dSetNodeTransformBatch(int[] nodes, int count, h3d.H3DTransform[] transforms);
+
+        [DllImport(ENGINE_DLL, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl), SuppressUnmanagedCodeSecurity]
+        internal static extern int h3dGetNodeTransMatsBatch(int[] nodes, int count, [Out] h3d.H3DMatrix4[] relMats, [Out] h3d.H3DMatrix4[] absMats);
+
+        [DllImport(ENGINE_DLL, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl), SuppressUnmanagedCodeSecurity]
+        internal static extern int h3dSetNodeTransMatBatch(int[] nodes, int count, h3d.H3DMatrix4[] mats);
+
+        [DllImport(ENGINE_DLL, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl), SuppressUnmanagedCodeSecurity]
+        internal static extern unsafe int h3dGetNodeTransformBatch(int* nodes, int count, h3d.H3DTransform* transforms);
+
+        [DllImport(ENGINE_DLL, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl), SuppressUnmanagedCodeSecurity]
+        internal static extern unsafe int h3dSetNodeTransformBatch(int* nodes, int count, h3d.H3DTransform* transforms);
+
+        [DllImport(ENGINE_DLL, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl), SuppressUnmanagedCodeSecurity]
+        internal static extern unsafe int h3dGetNodeTransMatsBatch(int* nodes, int count, h3d.H3DMatrix4* relMats, h3d.H3DMatrix4* absMats);
+
+        [DllImport(ENGINE_DLL, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl), SuppressUnmanagedCodeSecurity]
+        internal static extern unsafe int h3dSetNodeTransMatBatch(int* nodes, int count, h3d.H3DMatrix4* mats);
+
         [DllImport(ENGINE_DLL, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl), SuppressUnmanagedCodeSecurity]
         internal static extern int h3dGetNodeParamI(int node, int param);
 
@@ -262,6 +293,12 @@ internal static class NativeMethodsEngine
         [return: MarshalAs(UnmanagedType.U1)]   // represents C++ bool type 
         internal static extern bool h3dGetNodeAABB(int node, out float minX, out float minY, out float minZ, out float maxX, out float maxY, out float maxZ);
 
+        [DllImport(ENGINE_DLL, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl), SuppressUnmanagedCodeSecurity]
+        internal static extern int h3dGetNodeAABBBatch(int[] nodes, int count, [Out] h3d.H3DAABB[] aabbs);
+
+        [DllImport(ENGINE_DLL, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl), SuppressUnmanagedCodeSecurity]
+        internal static extern unsafe int h3dGetNodeAABBBatch(int* nodes, int count, h3d.H3DAABB* aabbs);
+
         [DllImport(ENGINE_DLL, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl), SuppressUnmanagedCodeSecurity]
         internal static extern int h3dFindNodes(int node, string name, int type);
 
@@ -281,6 +318,20 @@ internal static class NativeMethodsEngine
         [DllImport(ENGINE_DLL, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl), SuppressUnmanagedCodeSecurity]
         internal static extern int h3dCheckNodeVisibility(int node, int cameraNode, [MarshalAs(UnmanagedType.U1)]bool checkOcclusion, [MarshalAs(UnmanagedType.U1)]bool calcLod);
 
+        [DllImport(ENGINE_DLL, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl), SuppressUnmanagedCodeSecurity]
+        internal static extern int h3dCheckNodeVisibilityBatch(int[] nodes, int count, int cameraNode, [MarshalAs(UnmanagedType.U1)]bool checkOcclusion,
+                                [MarshalAs(UnmanagedType.U1)]bool calcLod, [Out] int[] results);
+
+        [DllImport(ENGINE_DLL, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl), SuppressUnmanagedCodeSecurity]
+        internal static extern unsafe int h3dCheckNodeVisibilityBatch(int* nodes, int count, int cameraNode, [MarshalAs(UnmanagedType.U1)]bool checkOcclusion,
+                                [MarshalAs(UnmanagedType.U1)]bool calcLod, int* results);
+
+        [DllImport(ENGINE_DLL, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl), SuppressUnmanagedCodeSecurity]
+        internal static extern int h3dCheckAABBVisibilityBatch(h3d.H3DAABB[] aabbs, int count, int cameraNode, [Out] int[] results);
+
+        [DllImport(ENGINE_DLL, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl), SuppressUnmanagedCodeSecurity]
+        internal static extern unsafe int h3dCheckAABBVisibilityBatch(h3d.H3DAABB* aabbs, int count, int cameraNode, int* results);
+
         // Group specific
         [DllImport(ENGINE_DLL, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl), SuppressUnmanagedCodeSecurity]
         internal static extern int h3dAddGroupNode(int parent, string name);
@@ -299,6 +350,12 @@ internal static class NativeMethodsEngine
         [DllImport(ENGINE_DLL, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl), SuppressUnmanagedCodeSecurity]        
         internal static extern void h3dSetModelAnimParams(int node, int stage, float time, float weight);
 
+        [DllImport(ENGINE_DLL, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl), SuppressUnmanagedCodeSecurity]
+        internal static extern int h3dSetModelAnimParamsBatch(int[] nodes, int count, int[] stages, h3d.H3DAnimParams[] animParams);
+
+        [DllImport(ENGINE_DLL, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl), SuppressUnmanagedCodeSecurity]
+        internal static extern unsafe int h3dSetModelAnimParamsBatch(int* nodes, int count, int* stages, h3d.H3DAnimParams* animParams);
+
         [DllImport(ENGINE_DLL, CharSet = CharSet.Ansi, CallingConvention = CallingConvention.Cdecl), SuppressUnmanagedCodeSecurity]
         [return: MarshalAs(UnmanagedType.U1)]   // represents C++ bool type 
         internal static extern bool h3dSetModelMorpher(int node, string target, float weight);
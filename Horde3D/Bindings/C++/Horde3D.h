@@ -69,12 +69,15 @@ struct H3DRenderDevice
 	OpenGL2				- use OpenGL 2 as renderer backend (can be used to force OpenGL 2 when higher version is undesirable)
 	OpenGL4				- use OpenGL 4 as renderer backend (falls back to OpenGL 2 in case of error)
 	OpenGLES3			- use OpenGL ES 3 as renderer backend
+	Null				- use a backend that performs no rendering and requires no graphics context
+						  (intended for automated tests and benchmarks; shaders use the OpenGL4 contexts)
 	*/
 	enum List
 	{
 		OpenGL2 = 2,
 		OpenGL4 = 4,
-		OpenGLES3 = 8
+		OpenGLES3 = 8,
+		Null = 16
 	};
 };
 
@@ -106,6 +109,22 @@ struct H3DOptions
 		GatherTimeStats     - Enables or disables gathering of time stats that are useful for profiling (Values: 0, 1; Default: 1)
 		DebugRenderBackend  - Enables or disables logging of render backend diagnostic messages. May require additional actions on 
 							  application side, like creating a debug opengl context. (Values: 0, 1; Default: 0)
+		ShadowAtlasSize     - Sets the size of the shadow atlas; if not 0, the shadow maps of all visible lights are packed
+		                      into the atlas and rendered together before lighting instead of one after another into the
+		                      shadow map buffer. (Values: 0, 2048, 4096, 8192; Default: 0)
+		DynResTargetTime    - GPU time budget in ms for rendering the pipelines that have dynamic resolution enabled; the
+		                      render resolution of these pipelines is adjusted each frame to meet the budget, 0 disables
+		                      the adjustment (Default: 0)
+		DynResMinScale      - Lowest resolution scale used by dynamic resolution (Values: 0.1 - 1.0; Default: 0.5)
+		AsyncShaderCompilation - Enables or disables asynchronous compilation of shader combinations; combinations
+		                      that are not ready yet are not drawn or drawn with a fallback (Values: 0, 1; Default: 0)
+		AsyncShaderFallback - Draws with the base combination of a shader context (no flags set) while the requested
+		                      combination is still compiling instead of skipping the draw (Values: 0, 1; Default: 1)
+		MaxFramesInFlight   - Maximum number of frames the GPU may lag behind the CPU; h3dFinalizeFrame waits on a
+		                      fence until the GPU has caught up, 0 leaves the queue depth to the driver (Values: 0, 1, 2, 3;
+		                      Default: 0)
+		LateLatchCamera     - Takes over the camera transformation that was set between h3dPrepareRender and h3dRender
+		                      for drawing; culling still uses the camera of h3dPrepareRender (Values: 0, 1; Default: 0)
 	*/
 	enum List
 	{
@@ -123,7 +142,14 @@ struct H3DOptions
 		DebugViewMode,
 		DumpFailedShaders,
 		GatherTimeStats,
-		DebugRenderBackend
+		DebugRenderBackend,
+		ShadowAtlasSize,
+		DynResTargetTime,
+		DynResMinScale,
+		AsyncShaderCompilation,
+		AsyncShaderFallback,
+		MaxFramesInFlight,
+		LateLatchCamera
 	};
 };
 
@@ -146,6 +172,25 @@ struct H3DStats
 		TextureVMem       - Estimated amount of video memory used by textures (in Mb)
 		GeometryVMem      - Estimated amount of video memory used by geometry (in Mb),
 		ComputeGPUTime	  - GPU time in ms spent for processing compute shaders
+		CullingTime       - CPU time in ms spent for culling and building the render queues
+		TiledLightCount   - Number of lights shaded by tiled deferred lighting passes
+		TileCount         - Number of screen tiles processed by tiled deferred lighting
+		TileLightRefs     - Sum of the number of lights over all screen tiles; divided by TileCount
+		                    this gives the average tile occupancy
+		TileMaxLights     - Maximum number of lights affecting a single screen tile
+		FrameGPUTime      - GPU time in ms spent for rendering camera pipelines
+		DynResScale       - Current resolution scale of the last rendered pipeline with dynamic resolution
+		OffscreenParticleGPUTime - GPU time in ms spent for reduced resolution particle passes including depth
+		                    downsampling and compositing
+		PendingShaderCount - Number of shader combinations whose asynchronous compilation is still in progress;
+		                    querying it finishes combinations that became ready
+		FrameWaitTime     - CPU time in ms spent waiting for the GPU because of MaxFramesInFlight
+		GPUIdleTime       - Estimated time in ms the GPU was idle, frame time minus FrameGPUTime; requires
+		                    GatherTimeStats
+		ShadowMapCount    - Number of shadow maps (cascades) that were rendered
+		CascadeBatchCount - Number of batches drawing a shadow caster into several cascades with instancing
+		OcclusionTestCount - Number of renderables whose GPU occlusion test results were read back
+		OccludedCount     - Number of renderables that the read back GPU occlusion tests found to be occluded
 	*/
 	enum List
 	{
@@ -162,7 +207,22 @@ struct H3DStats
 		ParticleGPUTime,
 		TextureVMem,
 		GeometryVMem,
-		ComputeGPUTime
+		ComputeGPUTime,
+		CullingTime,
+		TiledLightCount,
+		TileCount,
+		TileLightRefs,
+		TileMaxLights,
+		FrameGPUTime,
+		DynResScale,
+		OffscreenParticleGPUTime,
+		PendingShaderCount,
+		FrameWaitTime,
+		GPUIdleTime,
+		ShadowMapCount,
+		CascadeBatchCount,
+		OcclusionTestCount,
+		OccludedCount
 	};
 };
 
@@ -410,6 +470,7 @@ struct H3DShaderRes
 		UnifNameStr     - Name of uniform [read-only]
 		UnifSizeI       - Size (number of components) of uniform [read-only]
 		UnifDefValueF4  - Default value of uniform (a, b, c, d)
+		ContPendingCombsI - Number of combinations of context whose asynchronous compilation is in progress [read-only]
 	*/
 	enum List
 	{
@@ -421,7 +482,8 @@ struct H3DShaderRes
 		SampDefTexResI,
 		UnifNameStr,
 		UnifSizeI,
-		UnifDefValueF4
+		UnifDefValueF4,
+		ContPendingCombsI
 	};
 };
 
@@ -436,7 +498,8 @@ struct H3DTexRes
 		                  of mipmaps. Each image element represents the base image of a slice or
 		                  a single mipmap level of the corresponding slice.
 		TexFormatI      - Texture format [read-only]
-		TexSliceCountI  - Number of slices (1 for 2D texture and 6 for cubemap) [read-only]
+		TexSliceCountI  - Number of slices (1 for 2D texture, 6 for cubemap and the number of layers
+		                  for texture arrays) [read-only]
 		ImgWidthI       - Image width [read-only]
 		ImgHeightI      - Image height [read-only]
 		ImgPixelStream  - Pixel data of an image. The data layout matches the layout specified
@@ -525,6 +588,10 @@ struct H3DComputeBufRes
 	DrawParamsOffsetI			- Specifies the offset of parameter in the buffer (in bytes)
 	                              Example: for first parameter offset is 0. For second (if 1st parameter uses 3 floats) it is 12
 	DrawParamsCountI			- Total number of specified vertex binding parameters [read-only]
+	CompBufMapOffsetI			- Offset in bytes of the range mapped by the next h3dMapResStream call (default: 0)
+	CompBufMapSizeI				- Size in bytes of the range mapped by the next h3dMapResStream call, 0 for the rest
+	                              of the buffer (default: 0). Both values are reset when the stream is unmapped,
+	                              which allows uploading single chunks of a large buffer, e.g. from a memory-mapped file
 
 	*/
 	enum List
@@ -536,7 +603,9 @@ struct H3DComputeBufRes
 		DrawParamsNameStr,
 		DrawParamsSizeI,
 		DrawParamsOffsetI,
-		DrawParamsCountI
+		DrawParamsCountI,
+		CompBufMapOffsetI,
+		CompBufMapSizeI
 	};
 };
 
@@ -706,6 +775,9 @@ struct H3DLight
 		ShadowMapBiasF      - Bias value for shadow mapping to reduce shadow acne (default: 0.005)
 		LightingContextStr  - Name of shader context used for computing lighting
 		ShadowContextStr    - Name of shader context used for generating shadow map
+		ShadowSplitDistsF5  - Distances from the camera at which the view frustum was split into the shadow maps
+		                      when the light was last rendered, from the near plane of the first map to the far
+		                      plane of the last one (ShadowMapCountI + 1 values) [read-only]
 	*/
 	enum List
 	{
@@ -718,7 +790,8 @@ struct H3DLight
 		ShadowSplitLambdaF,
 		ShadowMapBiasF,
 		LightingContextStr,
-		ShadowContextStr
+		ShadowContextStr,
+		ShadowSplitDistsF5
 	};
 };
 
@@ -741,7 +814,8 @@ struct H3DCamera
 		ViewportWidthI   - Width of the viewport rectangle (default: 320)
 		ViewportHeightI  - Height of the viewport rectangle (default: 240)
 		OrthoI           - Flag for setting up an orthographic frustum instead of a perspective one (default: 0)
-		OccCullingI      - Flag for enabling occlusion culling (default: 0)
+		OccCullingI      - Flag for enabling occlusion culling; uses hardware queries unless the pipeline
+		                   contains a DoOcclusionCulling command (default: 0)
 	*/
 	enum List
 	{
@@ -801,6 +875,14 @@ struct H3DComputeNode
 		AABBMaxF       - Maximum of the node's AABB (should be set separately for x, y, z components)
 		DrawTypeI	   - Specifies how to draw data in the buffer (see H3DMeshPrimType)
 		ElementsCountI - Specifies number of elements to draw (Example: for 1000 points - 1000, for 10 triangles - 10)
+		IndirectBufResI - Compute buffer resource containing the draw arguments (vertex count, instance count,
+		                  first vertex, base instance as uint32), used instead of ElementsCountI if set
+		IndirectOffsetI - Offset in bytes of the draw arguments in the indirect buffer (default: 0)
+		ElementsStartI - First element of the buffer that is drawn (default: 0); several nodes can share one
+		                 buffer, so that each chunk of a large point cloud is culled with its own AABB
+		LodDensityF    - Maximum number of elements drawn per pixel covered by the node's bounding volume,
+		                 0 to always draw ElementsCountI elements (default: 0). Only a prefix of the element
+		                 range is drawn, so the elements should be stored in a random order
 	*/
 	enum List
 	{
@@ -809,7 +891,11 @@ struct H3DComputeNode
 		AABBMinF,
 		AABBMaxF,
 		DrawTypeI,
-		ElementsCountI
+		ElementsCountI,
+		IndirectBufResI,
+		IndirectOffsetI,
+		ElementsStartI,
+		LodDensityF
 	};
 };
 
@@ -935,6 +1021,40 @@ H3D_API void h3dRelease();
 */
 H3D_API void h3dCompute( H3DRes materialRes, const char *context, int groupX, int groupY, int groupZ );
 
+/* Function: h3dPrepareRender
+		Prepares the rendering of a frame.
+	
+	Details:
+		This function updates the scene, performs culling for the specified camera and copies the render
+		data of all visible nodes (transformations, bounding boxes, skinning matrices, particles and material
+		references) to a snapshot that is owned by the renderer. A subsequent call to h3dRender with the same
+		camera draws the frame from that snapshot without accessing these nodes anymore, so the application can
+		already modify the scene for the next frame while the frame is rendered, for example on another thread.
+		If h3dRender is called without preparing the frame, the preparation is done implicitly.
+		
+		The following restrictions apply until h3dRender has returned: the camera and the light nodes must not
+		be modified, nodes must not be removed, resources must not be changed, unloaded or released and
+		no other function that uses the rendering device may be called. Extension node types are still drawn
+		from the scene nodes. Software skinning and morph targets update geometry on the rendering device when the
+		scene is updated, so this function has to be called on the thread that renders.
+		
+		The functions that may be called on another thread while h3dRender draws the prepared frame are
+		h3dSetNodeTransform and h3dSetNodeTransMat for nodes other than the camera and lights, h3dSetModelAnimParams,
+		h3dUpdateModel for models that use neither software skinning nor morph targets, h3dUpdateEmitter and
+		functions that only query node data like h3dGetNodeTransform and h3dGetNodeAABB.
+		
+		With the LateLatchCamera option, the camera transformation may still be set after this function and before
+		h3dRender to reduce the latency of input that moves the camera. Large changes can make objects at the
+		border of the view disappear since culling was done with the previous transformation.
+	
+	Parameters:
+		cameraNode  - camera node used for rendering scene
+		
+	Returns:
+		nothing
+*/
+H3D_API void h3dPrepareRender( H3DNode cameraNode );
+
 /* Function: h3dRender
 		Main rendering function.
 	
@@ -956,7 +1076,8 @@ H3D_API void h3dRender( H3DNode cameraNode );
 	
 	Details:
 		This function tells the engine that the current frame is finished and that all
-		subsequent rendering operations will be for the next frame.
+		subsequent rendering operations will be for the next frame. If the MaxFramesInFlight option is set,
+		the function blocks until the GPU has finished enough of the previous frames.
 	
 	Parameters:
 		none
@@ -1228,6 +1349,26 @@ H3D_API bool h3dIsResLoaded( H3DRes res );
 */
 H3D_API bool h3dLoadResource( H3DRes res, const char *data, int size );
 
+/* Function: h3dReloadResource
+		Reloads a resource with new data.
+	
+	Details:
+		This function replaces the data of a loaded resource while keeping the resource handle and all
+		references to it valid. If the data is identical to the data the resource was loaded from, nothing
+		is done. Textures with unchanged dimensions and format are updated in place and shaders only
+		recompile the contexts whose code changed. If the resource is not loaded yet, the function behaves
+		like h3dLoadResource. When reloading a shader fails, the previous version is kept.
+	
+	Parameters:
+		res   - handle to the resource to be reloaded
+		data  - pointer to the new data
+		size  - size of the data block
+		
+	Returns:
+		1 if the resource data was replaced, 0 if the data did not change and -1 in case of failure
+*/
+H3D_API int h3dReloadResource( H3DRes res, const char *data, int size );
+
 /* Function: h3dUnloadResource
 		Unloads a resource.
 	
@@ -1775,6 +1916,79 @@ H3D_API void h3dGetNodeTransMats( H3DNode node, const float **relMat, const floa
 */
 H3D_API void h3dSetNodeTransMat( H3DNode node, const float *mat4x4 );
 
+/* Function: h3dGetNodeTransformBatch
+		Gets the relative transformation of several nodes.
+	
+	Details:
+		This function is the batched version of h3dGetNodeTransform. For each node it stores translation,
+		rotation in Euler angles and scale as nine consecutive floats (tx, ty, tz, rx, ry, rz, sx, sy, sz)
+		in the transforms array. Invalid node handles are skipped and their entries are set to zero.
+	
+	Parameters:
+		nodes       - array of handles to the nodes which will be accessed
+		count       - number of nodes in the array
+		transforms  - array of count * 9 floats where the transformations will be stored
+		
+	Returns:
+		number of valid nodes
+*/
+H3D_API int h3dGetNodeTransformBatch( const H3DNode *nodes, int count, float *transforms );
+
+/* Function: h3dSetNodeTransformBatch
+		Sets the relative transformation of several nodes.
+	
+	Details:
+		This function is the batched version of h3dSetNodeTransform. The transforms array contains nine
+		consecutive floats (tx, ty, tz, rx, ry, rz, sx, sy, sz) for each node. Invalid node handles
+		are skipped.
+	
+	Parameters:
+		nodes       - array of handles to the nodes which will be modified
+		count       - number of nodes in the array
+		transforms  - array of count * 9 floats with the new transformations
+		
+	Returns:
+		number of valid nodes
+*/
+H3D_API int h3dSetNodeTransformBatch( const H3DNode *nodes, int count, const float *transforms );
+
+/* Function: h3dGetNodeTransMatsBatch
+		Copies the transformation matrices of several nodes.
+	
+	Details:
+		This function is the batched version of h3dGetNodeTransMats. Instead of returning pointers to
+		the internal matrices, it copies the relative and absolute transformation matrices of all nodes
+		to the specified arrays (16 floats per node in column major order). The scene is updated once
+		before the matrices are copied. Invalid node handles are skipped and their matrices are set to zero.
+	
+	Parameters:
+		nodes    - array of handles to the nodes which will be accessed
+		count    - number of nodes in the array
+		relMats  - array of count * 16 floats for the relative transformation matrices (can be NULL)
+		absMats  - array of count * 16 floats for the absolute transformation matrices (can be NULL)
+		
+	Returns:
+		number of valid nodes
+*/
+H3D_API int h3dGetNodeTransMatsBatch( const H3DNode *nodes, int count, float *relMats, float *absMats );
+
+/* Function: h3dSetNodeTransMatBatch
+		Sets the relative transformation matrices of several nodes.
+	
+	Details:
+		This function is the batched version of h3dSetNodeTransMat. The mats array contains a 4x4 matrix
+		in column major order for each node. Invalid node handles are skipped.
+	
+	Parameters:
+		nodes  - array of handles to the nodes which will be modified
+		count  - number of nodes in the array
+		mats   - array of count * 16 floats with the new relative transformation matrices
+		
+	Returns:
+		number of valid nodes
+*/
+H3D_API int h3dSetNodeTransMatBatch( const H3DNode *nodes, int count, const float *mats );
+
 /* Function: h3dGetNodeParamI
 		Gets a property of a scene node.
 	
@@ -1929,6 +2143,24 @@ H3D_API void h3dSetNodeFlags( H3DNode node, int flags, bool recursive );
 H3D_API void h3dGetNodeAABB( H3DNode node, float *minX, float *minY, float *minZ,
                              float *maxX, float *maxY, float *maxZ );
 
+/* Function: h3dGetNodeAABBBatch
+		Gets the bounding boxes of several scene nodes.
+	
+	Details:
+		This function is the batched version of h3dGetNodeAABB. For each node it stores the world space
+		bounding box as six consecutive floats (minX, minY, minZ, maxX, maxY, maxZ) in the aabbs array.
+		Invalid node handles are skipped and their entries are set to zero.
+	
+	Parameters:
+		nodes  - array of handles to the nodes which will be accessed
+		count  - number of nodes in the array
+		aabbs  - array of count * 6 floats where the bounding boxes will be stored
+		
+	Returns:
+		number of valid nodes
+*/
+H3D_API int h3dGetNodeAABBBatch( const H3DNode *nodes, int count, float *aabbs );
+
 /* Function: h3dFindNodes
 		Finds scene nodes with the specified properties.
 	
@@ -2042,6 +2274,51 @@ H3D_API bool h3dGetCastRayResult( int index, H3DNode *node, float *distance, flo
 */
 H3D_API int h3dCheckNodeVisibility( H3DNode node, H3DNode cameraNode, bool checkOcclusion, bool calcLod );
 
+/*	Function: h3dCheckNodeVisibilityBatch
+		Checks if several nodes are visible.
+
+	Details:
+		This function is the batched version of h3dCheckNodeVisibility. For each node the result
+		(-1 if the node is not visible, otherwise 0 or the computed LOD level) is stored in the results array.
+		Invalid node handles are reported as not visible. If the scene did not change since the last frame
+		was rendered with the camera, the frustum culling results of that frame are reused. The remaining
+		nodes are tested in blocks using SIMD instructions and large batches are split across threads.
+
+	Parameters:
+		nodes           - array of nodes to be checked for visibility
+		count           - number of nodes in the array
+		cameraNode      - camera node from which the visibility test is done
+		checkOcclusion  - specifies if occlusion info from previous frame should be taken into account
+		calcLod         - specifies if LOD level should be computed
+		results         - array of count ints where the results will be stored
+
+	Returns:
+		number of visible nodes
+*/
+H3D_API int h3dCheckNodeVisibilityBatch( const H3DNode *nodes, int count, H3DNode cameraNode,
+                                         bool checkOcclusion, bool calcLod, int *results );
+
+/*	Function: h3dCheckAABBVisibilityBatch
+		Checks if several bounding boxes are visible.
+
+	Details:
+		This function checks which of the specified world space bounding boxes are inside the frustum
+		of a camera, e.g. for objects of the application that are not part of the scene graph. The
+		boxes are stored as six consecutive floats (minX, minY, minZ, maxX, maxY, maxZ), the same layout
+		as returned by h3dGetNodeAABBBatch. For each box, -1 (not visible) or 0 (visible) is stored in the
+		results array.
+
+	Parameters:
+		aabbs       - array of count * 6 floats with the bounding boxes
+		count       - number of bounding boxes in the array
+		cameraNode  - camera node from which the visibility test is done
+		results     - array of count ints where the results will be stored
+
+	Returns:
+		number of visible bounding boxes
+*/
+H3D_API int h3dCheckAABBVisibilityBatch( const float *aabbs, int count, H3DNode cameraNode, int *results );
+
 
 /* Group: Group-specific scene graph functions */
 /* Function: h3dAddGroupNode
@@ -2160,6 +2437,26 @@ H3D_API void h3dGetModelAnimParams( H3DNode modelNode, int stage, float *time, f
 */
 H3D_API void h3dSetModelAnimParams( H3DNode modelNode, int stage, float time, float weight );
 
+/* Function: h3dSetModelAnimParamsBatch
+		Sets the animation stage parameters of several Model nodes.
+	
+	Details:
+		This function is the batched version of h3dSetModelAnimParams. Entry i of the arrays sets the
+		time params[i*2] and weight params[i*2+1] of the stage stages[i] of model modelNodes[i], so
+		several stages of the same model can be updated by repeating its handle. Invalid node handles
+		are skipped.
+	
+	Parameters:
+		modelNodes  - array of handles to the Model nodes to be modified
+		count       - number of entries in the arrays
+		stages      - array of count animation stage indices
+		params      - array of count * 2 floats with animation time and blend weight
+		
+	Returns:
+		number of valid entries
+*/
+H3D_API int h3dSetModelAnimParamsBatch( const H3DNode *modelNodes, int count, const int *stages, const float *params );
+
 /* Function: h3dSetModelMorpher
 		Sets the weight of a morph target.
 	
@@ -111,15 +111,103 @@ H3D_API void h3dutSetResourcePath( int type, const char *path );
 		directories on a data drive. Several search paths can be specified using the pipe character (|)
 		as separator. All resource names are directly converted to filenames and the function tries to
 		find them in the specified directories using the given order of the search paths.
+		
+		Search paths with the extension .h3dpack refer to pack files created with the PackBuilder tool.
+		Pack files are memory-mapped when first used and stay opened until h3dutClosePackFiles is called.
+		Uncompressed files are passed to the engine directly from the mapping.
+		
+		Files are read by a pool of background threads that is created on the first call and reused by
+		later calls. Scene graph, material, pipeline and shader files are scanned for references when read,
+		so that the files of dependent resources are already read while the engine parses their parents.
 	
 	Parameters:
-		contentDir  - directories where data is located on the drive ((back-)slashes at end are removed)
+		contentDir  - directories or pack files where data is located on the drive ((back-)slashes at end are removed)
 		
 	Returns:
 		false if at least one resource could not be loaded, otherwise true
 */
 H3D_API bool h3dutLoadResourcesFromDisk( const char *contentDir );
 
+/* Function: h3dutGetNumPrefetchedResources
+		Returns the number of resources loaded from prefetched data.
+	
+	Details:
+		This utility function returns how many resources the last call of h3dutLoadResourcesFromDisk
+		passed to the engine from files that were read by the background threads. Resources from pack
+		files and resources that were not found are loaded on the calling thread and not counted.
+	
+	Parameters:
+		none
+		
+	Returns:
+		number of prefetched resources
+*/
+H3D_API int h3dutGetNumPrefetchedResources();
+
+/* Function: h3dutClosePackFiles
+		Closes all opened pack files.
+	
+	Details:
+		This utility function releases the memory mappings of all pack files that were opened by
+		h3dutLoadResourcesFromDisk. Resources loaded from the packs are not affected.
+	
+	Parameters:
+		none
+		
+	Returns:
+		nothing
+*/
+H3D_API void h3dutClosePackFiles();
+
+/* Function: h3dutWatchResourceChanges
+		Starts watching content directories for changed resource files.
+	
+	Details:
+		This utility function starts watching the specified directories (same format as for
+		h3dutLoadResourcesFromDisk) for modified resource files. Changed resources are reloaded
+		in place by calling h3dutReloadChangedResources. On Linux the file system is watched by
+		inotify, on other platforms the modification times of the resource files are polled.
+		Calling this function again replaces the previously watched directories.
+	
+	Parameters:
+		contentDir  - directories where data is located on the drive
+		
+	Returns:
+		true in case of success, otherwise false
+*/
+H3D_API bool h3dutWatchResourceChanges( const char *contentDir );
+
+/* Function: h3dutReloadChangedResources
+		Reloads resources whose files have changed.
+	
+	Details:
+		This utility function reloads all loaded resources whose files were modified since the last
+		call using h3dReloadResource. Resources with unchanged content are skipped by the engine.
+		The function is intended to be called periodically, e.g. once per frame or second, and
+		returns immediately if no file has changed.
+	
+	Parameters:
+		none
+		
+	Returns:
+		number of resources whose data was actually replaced
+*/
+H3D_API int h3dutReloadChangedResources();
+
+/* Function: h3dutStopWatchingResourceChanges
+		Stops watching content directories for changed resource files.
+	
+	Details:
+		This utility function stops watching the directories specified with h3dutWatchResourceChanges.
+	
+	Parameters:
+		none
+		
+	Returns:
+		nothing
+*/
+H3D_API void h3dutStopWatchingResourceChanges();
+
 /* Function: h3dutCreateGeometryRes
 		Creates a Geometry resource from specified vertex data.
 	
@@ -61,6 +61,10 @@ bool ChicagoSample::initResources()
 		skyBoxRes = h3dAddResource( H3DResTypes::SceneGraph, "models/skybox/skyboxES.scene.xml", 0 );
 	}
 
+	// Character with walk animation
+	H3DRes characterRes = h3dAddResource( H3DResTypes::SceneGraph, "models/man/man.scene.xml", 0 );
+	H3DRes characterWalkRes = h3dAddResource( H3DResTypes::Animation, "animations/man.anim", 0 );
+
     // 2. Load resources
 
     if ( !getBackend()->loadResources( getResourcePath() ) )
@@ -96,8 +100,8 @@ bool ChicagoSample::initResources()
 	h3dSetNodeParamF( light, H3DLight::ColorF3, 1, 0.7f );
 	h3dSetNodeParamF( light, H3DLight::ColorF3, 2, 0.75f );
 
-    _crowdSim = new CrowdSim( getResourcePath() );
-	_crowdSim->init( getBackend() );
+    _crowdSim = new CrowdSim();
+	_crowdSim->init( H3DRootNode, characterRes, characterWalkRes );
 
 	return true;
 }
@@ -16,49 +16,57 @@
 
 #include "crowd.h"
 #include "../Framework/sampleapp.h"
-#include "../Framework/FrameworkBackend.h"
 #include <math.h>
 #include <stdlib.h>
 #include <time.h>
-#include "Horde3DUtils.h"
+
+
+namespace {
+
+// Parameters for three repulsion zones
+const float d1 = 0.25f, d2 = 2.0f, d3 = 4.5f;
+const float f1 = 1.5f, f2 = 0.8f, f3 = 0.1f;
+
+// Grid cells have the size of the outermost repulsion zone, so all particles that can exert
+// a force are located in the 3x3 cells around a particle
+const float cellSize = d3;
+
+}  // namespace
 
 
 void CrowdSim::chooseDestination( Particle &p )
 {
 	// Choose random destination within a circle
     float ang = (rand() % 360) * H3D_DEG2RAD;
-    float rad = (float) (rand() % 20);
+    float rad = (float) (rand() % _areaRadius);
 
 	p.dx = sinf( ang ) * rad;
 	p.dz = cosf( ang ) * rad;
 }
 
 
-void CrowdSim::init( FrameworkBackend *backend )
+void CrowdSim::init( H3DNode parent, H3DRes characterRes, H3DRes walkAnimRes, unsigned int numCharacters,
+                     unsigned int areaRadius )
 {
 	// Init random generator
 	//srand( (unsigned int)time( NULL ) );
 	srand( 99777 );  // Use fixed value for better performance comparisons
-	
-	// Load character with walk animation
-	H3DRes characterRes = h3dAddResource( H3DResTypes::SceneGraph, "models/man/man.scene.xml", 0 );
-	H3DRes characterWalkRes = h3dAddResource( H3DResTypes::Animation, "animations/man.anim", 0 );
 
-	backend->loadResources( _contentDir.c_str() );
-//	h3dutLoadResourcesFromDisk( _contentDir.c_str() );
+	_areaRadius = areaRadius > 0 ? areaRadius : 1;
 	
 	// Add characters
-    for( unsigned int i = 0; i < 100; ++i )
+    for( unsigned int i = 0; i < numCharacters; ++i )
 	{
 		Particle p;
 		
 		// Add character to scene and apply animation
-		p.node = h3dAddNodes( H3DRootNode, characterRes );
-		h3dSetupModelAnimStage( p.node, 0, characterWalkRes, 0, "", false );
+		p.node = h3dAddNodes( parent, characterRes );
+		h3dSetupModelAnimStage( p.node, 0, walkAnimRes, 0, "", false );
 		
-		// Characters start in a circle formation
-		p.px = sinf( (i / 100.0f) * 6.28f ) * 10.0f;
-		p.pz = cosf( (i / 100.0f) * 6.28f ) * 10.0f;
+		// Characters start in a circle formation, large crowds use additional outer rings
+		float ringRadius = 10.0f + (i / 100) * 2.0f;
+		p.px = sinf( ((i % 100) / 100.0f) * 6.28f ) * ringRadius;
+		p.pz = cosf( ((i % 100) / 100.0f) * 6.28f ) * ringRadius;
 
 		chooseDestination( p );
 
@@ -69,11 +77,47 @@ void CrowdSim::init( FrameworkBackend *backend )
 }
 
 
+unsigned int CrowdSim::getCell( float x, float z, int offsetX, int offsetZ ) const
+{
+	int cx = (int)floorf( x / cellSize ) + offsetX;
+	int cz = (int)floorf( z / cellSize ) + offsetZ;
+
+	// Number of cells is a power of two
+	return ((unsigned int)cx * 73856093u ^ (unsigned int)cz * 19349663u) & (unsigned int)(_cellStarts.size() - 2);
+}
+
+
+void CrowdSim::buildGrid()
+{
+	// Use about two cells per particle to keep hash collisions rare
+	unsigned int numCells = 16;
+	while( numCells < _particles.size() * 2 ) numCells *= 2;
+
+	_cellStarts.assign( numCells + 1, 0 );
+	_cellEntries.resize( _particles.size() );
+	_particleCells.resize( _particles.size() );
+
+	// Counting sort of particles by cell
+	for( unsigned int i = 0; i < _particles.size(); ++i )
+	{
+		_particleCells[i] = getCell( _particles[i].px, _particles[i].pz, 0, 0 );
+		++_cellStarts[_particleCells[i] + 1];
+	}
+	for( unsigned int i = 0; i < numCells; ++i )
+		_cellStarts[i + 1] += _cellStarts[i];
+	for( unsigned int i = 0; i < _particles.size(); ++i )
+		_cellEntries[_cellStarts[_particleCells[i]]++] = i;
+
+	// Restore start offsets which were advanced while filling
+	for( unsigned int i = numCells; i > 0; --i )
+		_cellStarts[i] = _cellStarts[i - 1];
+	_cellStarts[0] = 0;
+}
+
+
 void CrowdSim::update( float fps )
 {
-	// Parameters for three repulsion zones
-	float d1 = 0.25f, d2 = 2.0f, d3 = 4.5f;
-    float f1 = 1.5f, f2 = 0.8f, f3 = 0.1f;
+	buildGrid();
 	
 	for( unsigned int i = 0; i < _particles.size(); ++i )
 	{
@@ -94,40 +138,58 @@ void CrowdSim::update( float fps )
 
             p.fx += afx * 0.035f; p.fz += afz * 0.035f;
 
-			// Repulsion forces from other particles
-			for( unsigned int j = 0; j < _particles.size(); ++j )
+			// Repulsion forces from particles in neighboring cells
+			unsigned int visitedCells[9], numVisited = 0;
+			for( int cz = -1; cz <= 1; ++cz )
 			{
-				if( j == i ) continue;
-				
-				Particle &p2 = _particles[j];
-				
-                float dist2 = sqrtf( (p.px - p2.px)*(p.px - p2.px) + (p.pz - p2.pz)*(p.pz - p2.pz) );
-                float strength = 0;
-
-                float rfx = (p.px - p2.px) / dist2;
-                float rfz = (p.pz - p2.pz) / dist2;
-				
-				// Use three zones with different repulsion strengths
-                if( dist2 <= d3 && dist2 > d2 )
-				{
-					float m = (f3 - 0) / (d2 - d3);
-					float t = 0 - m * d3;
-                    strength = m * dist2 + t;
-				}
-                else if( dist2 <= d2 && dist2 > d1 )
+				for( int cx = -1; cx <= 1; ++cx )
 				{
-					float m = (f2 - f3) / (d1 - d2);
-					float t = f3 - m * d2;
-                    strength = m * dist2 + t;
+					// Different cells can map to the same hash bucket, visit each bucket only once
+					unsigned int cell = getCell( p.px, p.pz, cx, cz );
+					bool visited = false;
+					for( unsigned int k = 0; k < numVisited; ++k )
+						if( visitedCells[k] == cell ) visited = true;
+					if( visited ) continue;
+					visitedCells[numVisited++] = cell;
+
+					for( unsigned int k = _cellStarts[cell]; k < _cellStarts[cell + 1]; ++k )
+					{
+						unsigned int j = _cellEntries[k];
+						if( j == i ) continue;
+						
+						Particle &p2 = _particles[j];
+						
+						float dist2 = sqrtf( (p.px - p2.px)*(p.px - p2.px) + (p.pz - p2.pz)*(p.pz - p2.pz) );
+						if( dist2 > d3 ) continue;
+
+						float strength = 0;
+
+						float rfx = (p.px - p2.px) / dist2;
+						float rfz = (p.pz - p2.pz) / dist2;
+						
+						// Use three zones with different repulsion strengths
+						if( dist2 > d2 )
+						{
+							float m = (f3 - 0) / (d2 - d3);
+							float t = 0 - m * d3;
+							strength = m * dist2 + t;
+						}
+						else if( dist2 > d1 )
+						{
+							float m = (f2 - f3) / (d1 - d2);
+							float t = f3 - m * d2;
+							strength = m * dist2 + t;
+						}
+						else
+						{
+							float m = (f1 - f2) / (0 - d1);
+							float t = f2 - m * d1;
+							strength = m * dist2 + t;
+						}
+
+						p.fx += rfx * strength; p.fz += rfz * strength;
+					}
 				}
-                else if( dist2 <= d1 )
-				{
-					float m = (f1 - f2) / (0 - d1);
-					float t = f2 - m * d1;
-                    strength = m * dist2 + t;
-				}
-
-				p.fx += rfx * strength; p.fz += rfz * strength;
 			}
 		}
 		else
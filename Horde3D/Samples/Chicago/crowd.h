@@ -19,10 +19,6 @@
 
 #include "Horde3D.h"
 #include <vector>
-#include <string>
-
-// Forward declarations
-class FrameworkBackend;
 
 struct Particle
 {
@@ -46,17 +42,29 @@ struct Particle
 class CrowdSim
 {
 public:
-	CrowdSim( const std::string& contentDir ) : _contentDir( contentDir ) {}
+	CrowdSim() : _areaRadius( 20 ) {}
 
-	void init( FrameworkBackend *backend );
+	// Adds characters in a ring formation below parent, resources must already be loaded.
+	// Destinations are chosen randomly within areaRadius around the origin.
+	void init( H3DNode parent, H3DRes characterRes, H3DRes walkAnimRes, unsigned int numCharacters = 100,
+	           unsigned int areaRadius = 20 );
 	void update( float fps );
 
+	unsigned int getNumCharacters() const { return (unsigned int)_particles.size(); }
+
 private:
 	void chooseDestination( Particle &p );
+	void buildGrid();
+	unsigned int getCell( float x, float z, int offsetX, int offsetZ ) const;
 
 private:
-	std::string              _contentDir;
-	std::vector< Particle >  _particles;
+	std::vector< Particle >      _particles;
+	unsigned int                 _areaRadius;
+
+	// Spatial hash of particle positions, rebuilt every update
+	std::vector< unsigned int >  _cellStarts;   // Index into _cellEntries per cell, size is numCells + 1
+	std::vector< unsigned int >  _cellEntries;  // Particle indices sorted by cell
+	std::vector< unsigned int >  _particleCells;
 };
 
 #endif // _crowd_H_
@@ -286,6 +286,26 @@ void CameraNode::setProjectionMatrix( float* projMat )
 }
 
 
+void CameraNode::latchTransform()
+{
+	// Takes over a transformation that was set after the scene was updated for the current frame. Only the
+	// view matrix and position are refreshed, the frustum stays the one that was used for culling. The scene
+	// itself is not touched, the node remains dirty and is updated regularly with the next scene update.
+	if( !_dirty ) return;
+
+	Matrix4f absTrans = _relTrans, tmp;
+	for( SceneNode *node = _parent; node != 0x0; node = node->getParent() )
+	{
+		Matrix4f::fastMult43( tmp, node->getRelTrans(), absTrans );
+		absTrans = tmp;
+	}
+
+	_absTrans = absTrans;
+	_absPos = Vec3f( _absTrans.c[3][0], _absTrans.c[3][1], _absTrans.c[3][2] );
+	_viewMat = _absTrans.inverted();
+}
+
+
 void CameraNode::onPostUpdate()
 {
 	// Get position
@@ -89,6 +89,7 @@ public:
 
 	void setupViewParams( float fov, float aspect, float nearPlane, float farPlane );
 	void setProjectionMatrix( float* projMat );
+	void latchTransform();
 
 	const Frustum &getFrustum() const { return _frustum; }
 	const Matrix4f &getViewMat() const { return _viewMat; }
@@ -14,8 +14,12 @@
 #include "utMath.h"
 #include "egModules.h"
 #include "egRenderer.h"
+#include "egShader.h"
 #include <stdarg.h>
 #include <stdio.h>
+#include <algorithm>
+#include <thread>
+#include <vector>
 
 #include "utDebug.h"
 
@@ -36,12 +40,19 @@ EngineConfig::EngineConfig()
 	loadTextures = true;
 	fastAnimation = true;
 	shadowMapSize = 1024;
+	shadowAtlasSize = 0;
 	sampleCount = 0;
+	dynResTargetTime = 0;
+	dynResMinScale = 0.5f;
 	wireframeMode = false;
 	debugViewMode = false;
 	dumpFailedShaders = false;
 	gatherTimeStats = true;
 	debugRenderBackend = false;
+	asyncShaderCompilation = false;
+	asyncShaderFallback = true;
+	maxFramesInFlight = 0;
+	lateLatchCamera = false;
 }
 
 
@@ -79,6 +90,20 @@ float EngineConfig::getOption( EngineOptions::List param ) const
 		return gatherTimeStats ? 1.0f : 0.0f;
 	case EngineOptions::DebugRenderBackend:
 		return debugRenderBackend ? 1.0f : 0.0f;
+	case EngineOptions::ShadowAtlasSize:
+		return (float)shadowAtlasSize;
+	case EngineOptions::DynResTargetTime:
+		return dynResTargetTime;
+	case EngineOptions::DynResMinScale:
+		return dynResMinScale;
+	case EngineOptions::AsyncShaderCompilation:
+		return asyncShaderCompilation ? 1.0f : 0.0f;
+	case EngineOptions::AsyncShaderFallback:
+		return asyncShaderFallback ? 1.0f : 0.0f;
+	case EngineOptions::MaxFramesInFlight:
+		return (float)maxFramesInFlight;
+	case EngineOptions::LateLatchCamera:
+		return lateLatchCamera ? 1.0f : 0.0f;
 	default:
 		Modules::setError( "Invalid param for h3dGetOption" );
 		return Math::NaN;
@@ -160,6 +185,49 @@ bool EngineConfig::setOption( EngineOptions::List param, float value )
 										   Modules::renderer().getRenderDevice()->disableDebugOutput();
 		return result;
 	}
+	case EngineOptions::ShadowAtlasSize:
+		size = ftoi_r( value );
+
+		if( size == shadowAtlasSize ) return true;
+		if( size != 0 && size != 2048 && size != 4096 && size != 8192 ) return false;
+
+		// Update shadow atlas, size 0 disables it
+		Modules::renderer().releaseShadowAtlasRB();
+
+		if( size != 0 && !Modules::renderer().createShadowAtlasRB( size, size ) )
+		{
+			Modules::log().writeWarning( "Failed to create shadow atlas" );
+			// Restore old buffer
+			if( shadowAtlasSize != 0 ) Modules::renderer().createShadowAtlasRB( shadowAtlasSize, shadowAtlasSize );
+			return false;
+		}
+		else
+		{
+			shadowAtlasSize = size;
+			return true;
+		}
+	case EngineOptions::DynResTargetTime:
+		if( value < 0 ) return false;
+		dynResTargetTime = value;
+		return true;
+	case EngineOptions::DynResMinScale:
+		if( value < 0.1f || value > 1.0f ) return false;
+		dynResMinScale = value;
+		return true;
+	case EngineOptions::AsyncShaderCompilation:
+		asyncShaderCompilation = (value != 0);
+		return true;
+	case EngineOptions::AsyncShaderFallback:
+		asyncShaderFallback = (value != 0);
+		return true;
+	case EngineOptions::MaxFramesInFlight:
+		size = ftoi_r( value );
+		if( size < 0 || size > 3 ) return false;
+		maxFramesInFlight = size;
+		return true;
+	case EngineOptions::LateLatchCamera:
+		lateLatchCamera = (value != 0);
+		return true;
 	default:
 		Modules::setError( "Invalid param for h3dSetOption" );
 		return false;
@@ -283,13 +351,24 @@ bool EngineLog::getMessage( LogMessage &msg )
 // *************************************************************************************************
 
 StatManager::StatManager() : _fwdLightsGPUTimer( 0 ), _defLightsGPUTimer( 0 ), _shadowsGPUTimer( 0 ), _particleGPUTimer( 0 ),
-							 _computeGPUTimer( 0 )
+							 _computeGPUTimer( 0 ), _frameGPUTimer( 0 ),
+							 _offscreenParticleGPUTimer( 0 )
 {
 	_statTriCount = 0;
 	_statBatchCount = 0;
 	_statLightPassCount = 0;
+	_statTiledLightCount = 0;
+	_statTileCount = 0;
+	_statTileLightRefs = 0;
+	_statTileMaxLights = 0;
+	_statShadowMapCount = 0;
+	_statCascadeBatchCount = 0;
+	_statOcclusionTestCount = 0;
+	_statOccludedCount = 0;
+	_statDynResScale = 1.0f;
 
 	_frameTime = 0;
+	_gpuIdleTime = 0;
 }
 
 
@@ -300,6 +379,8 @@ StatManager::~StatManager()
 	if ( _shadowsGPUTimer ) { delete _shadowsGPUTimer; _shadowsGPUTimer = 0; }
 	if ( _particleGPUTimer ) { delete _particleGPUTimer; _particleGPUTimer = 0; }
 	if ( _computeGPUTimer ) { delete _computeGPUTimer; _computeGPUTimer = 0; }
+	if ( _frameGPUTimer ) { delete _frameGPUTimer; _frameGPUTimer = 0; }
+	if ( _offscreenParticleGPUTimer ) { delete _offscreenParticleGPUTimer; _offscreenParticleGPUTimer = 0; }
 }
 
 
@@ -314,6 +395,8 @@ bool StatManager::init()
 	_shadowsGPUTimer = rdi->createGPUTimer();
 	_particleGPUTimer = rdi->createGPUTimer();
 	_computeGPUTimer = rdi->createGPUTimer();
+	_frameGPUTimer = rdi->createGPUTimer();
+	_offscreenParticleGPUTimer = rdi->createGPUTimer();
 
 	return true;
 }
@@ -380,6 +463,68 @@ float StatManager::getStat( int param, bool reset )
 		value = _cullingTimer.getElapsedTimeMS();
 		if ( reset ) _cullingTimer.reset();
 		return value;
+	case EngineStats::TiledLightCount:
+		value = (float)_statTiledLightCount;
+		if( reset ) _statTiledLightCount = 0;
+		return value;
+	case EngineStats::TileCount:
+		value = (float)_statTileCount;
+		if( reset ) _statTileCount = 0;
+		return value;
+	case EngineStats::TileLightRefs:
+		value = (float)_statTileLightRefs;
+		if( reset ) _statTileLightRefs = 0;
+		return value;
+	case EngineStats::TileMaxLights:
+		value = (float)_statTileMaxLights;
+		if( reset ) _statTileMaxLights = 0;
+		return value;
+	case EngineStats::FrameGPUTime:
+		value = _frameGPUTimer->getTimeMS();
+		if( reset ) _frameGPUTimer->reset();
+		return value;
+	case EngineStats::DynResScale:
+		return _statDynResScale;
+	case EngineStats::OffscreenParticleGPUTime:
+		value = _offscreenParticleGPUTimer->getTimeMS();
+		if( reset ) _offscreenParticleGPUTimer->reset();
+		return value;
+	case EngineStats::PendingShaderCount:
+		{
+			// Querying finishes combinations that became ready, so polling this stat drives compilation
+			int count = 0;
+			std::vector< Resource * > &resources = Modules::resMan().getResources();
+			for( size_t i = 0; i < resources.size(); ++i )
+			{
+				if( resources[i] != 0x0 && resources[i]->getType() == ResourceTypes::Shader )
+					count += ((ShaderResource *)resources[i])->updatePendingCombinations();
+			}
+			return (float)count;
+		}
+	case EngineStats::FrameWaitTime:
+		value = _frameWaitTimer.getElapsedTimeMS();
+		if( reset ) _frameWaitTimer.reset();
+		return value;
+	case EngineStats::GPUIdleTime:
+		value = _gpuIdleTime;
+		if( reset ) _gpuIdleTime = 0;
+		return value;
+	case EngineStats::ShadowMapCount:
+		value = (float)_statShadowMapCount;
+		if( reset ) _statShadowMapCount = 0;
+		return value;
+	case EngineStats::CascadeBatchCount:
+		value = (float)_statCascadeBatchCount;
+		if( reset ) _statCascadeBatchCount = 0;
+		return value;
+	case EngineStats::OcclusionTestCount:
+		value = (float)_statOcclusionTestCount;
+		if( reset ) _statOcclusionTestCount = 0;
+		return value;
+	case EngineStats::OccludedCount:
+		value = (float)_statOccludedCount;
+		if( reset ) _statOccludedCount = 0;
+		return value;
 	default:
 		Modules::setError( "Invalid param for h3dGetStat" );
 		return Math::NaN;
@@ -400,9 +545,39 @@ void StatManager::incStat( int param, float value )
 	case EngineStats::LightPassCount:
 		_statLightPassCount += ftoi_r( value );
 		break;
+	case EngineStats::TiledLightCount:
+		_statTiledLightCount += ftoi_r( value );
+		break;
+	case EngineStats::TileCount:
+		_statTileCount += ftoi_r( value );
+		break;
+	case EngineStats::TileLightRefs:
+		_statTileLightRefs += ftoi_r( value );
+		break;
+	case EngineStats::TileMaxLights:
+		_statTileMaxLights = std::max( _statTileMaxLights, (uint32)ftoi_r( value ) );
+		break;
+	case EngineStats::ShadowMapCount:
+		_statShadowMapCount += ftoi_r( value );
+		break;
+	case EngineStats::CascadeBatchCount:
+		_statCascadeBatchCount += ftoi_r( value );
+		break;
+	case EngineStats::OcclusionTestCount:
+		_statOcclusionTestCount += ftoi_r( value );
+		break;
+	case EngineStats::OccludedCount:
+		_statOccludedCount += ftoi_r( value );
+		break;
+	case EngineStats::DynResScale:
+		_statDynResScale = value;
+		break;
 	case EngineStats::FrameTime:
 		_frameTime += value;
 		break;
+	case EngineStats::GPUIdleTime:
+		_gpuIdleTime += value;
+		break;
 	}
 }
 
@@ -421,6 +596,8 @@ Timer *StatManager::getTimer( int param )
 		return &_particleSimTimer;
 	case EngineStats::CullingTime:
 		return &_cullingTimer;
+	case EngineStats::FrameWaitTime:
+		return &_frameWaitTimer;
 	default:
 		return 0x0;
 	}
@@ -441,6 +618,10 @@ GPUTimer *StatManager::getGPUTimer( int param ) const
 		return _particleGPUTimer;
 	case EngineStats::ComputeGPUTime:
 		return _computeGPUTimer;
+	case EngineStats::FrameGPUTime:
+		return _frameGPUTimer;
+	case EngineStats::OffscreenParticleGPUTime:
+		return _offscreenParticleGPUTimer;
 	default:
 		return 0x0;
 	}
@@ -484,4 +665,101 @@ float getRenderDeviceCapabilities( int param )
 	}
 }
 
+
+// *************************************************************************************************
+// Class WorkerPool
+// *************************************************************************************************
+
+WorkerPool::WorkerPool() :
+	_func( 0x0 ), _count( 0 ), _rangeSize( 0 ), _numRanges( 0 ), _nextRange( 0 ), _numPending( 0 ),
+	_numBusy( 0 ), _jobID( 0 ), _stop( false )
+{
+	// The calling thread executes ranges as well
+	uint32 numThreads = std::min( std::max( std::thread::hardware_concurrency(), 1u ), 8u );
+	for( uint32 i = 1; i < numThreads; ++i )
+		_threads.push_back( std::thread( &WorkerPool::workerFunc, this ) );
+}
+
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard< std::mutex > lock( _mutex );
+		_stop = true;
+	}
+	_startCond.notify_all();
+	for( size_t i = 0; i < _threads.size(); ++i ) _threads[i].join();
+}
+
+
+void WorkerPool::run( uint32 count, bool parallel, const std::function< void ( uint32, uint32 ) > &func )
+{
+	if( count == 0 ) return;
+	
+	uint32 numRanges = parallel ? std::min( getNumThreads(), count ) : 1;
+	if( numRanges <= 1 || !_runMutex.try_lock() )
+	{
+		func( 0, count );
+		return;
+	}
+	std::lock_guard< std::mutex > runLock( _runMutex, std::adopt_lock );
+
+	{
+		// Workers that woke up late for the previous job have to leave it before the job is replaced
+		std::unique_lock< std::mutex > lock( _mutex );
+		_doneCond.wait( lock, [this] { return _numBusy == 0; } );
+		_func = &func;
+		_count = count;
+		_rangeSize = (count + numRanges - 1) / numRanges;
+		_numRanges = (count + _rangeSize - 1) / _rangeSize;
+		_nextRange = 0;
+		_numPending = _numRanges;
+		++_jobID;
+	}
+	_startCond.notify_all();
+
+	executeRanges();
+
+	std::unique_lock< std::mutex > lock( _mutex );
+	_doneCond.wait( lock, [this] { return _numPending == 0; } );
+	_func = 0x0;
+}
+
+
+void WorkerPool::executeRanges()
+{
+	for( ;; )
+	{
+		uint32 range = _nextRange++;
+		if( range >= _numRanges ) break;
+
+		(*_func)( range * _rangeSize, std::min( (range + 1) * _rangeSize, _count ) );
+
+		std::lock_guard< std::mutex > lock( _mutex );
+		if( --_numPending == 0 ) _doneCond.notify_all();
+	}
+}
+
+
+void WorkerPool::workerFunc()
+{
+	uint32 lastJobID = 0;
+	
+	std::unique_lock< std::mutex > lock( _mutex );
+	for( ;; )
+	{
+		_startCond.wait( lock, [this, lastJobID] { return _stop || _jobID != lastJobID; } );
+		if( _stop ) break;
+		
+		lastJobID = _jobID;
+		++_numBusy;
+		lock.unlock();
+
+		executeRanges();
+
+		lock.lock();
+		if( --_numBusy == 0 ) _doneCond.notify_all();
+	}
+}
+
 }  // namespace
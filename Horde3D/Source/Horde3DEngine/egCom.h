@@ -17,6 +17,12 @@
 #include <string>
 #include <queue>
 #include <cstdarg>
+#include <functional>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
 #include "utTimer.h"
 
 
@@ -46,7 +52,14 @@ struct EngineOptions
 		DebugViewMode,
 		DumpFailedShaders,
 		GatherTimeStats,
-		DebugRenderBackend
+		DebugRenderBackend,
+		ShadowAtlasSize,
+		DynResTargetTime,
+		DynResMinScale,
+		AsyncShaderCompilation,
+		AsyncShaderFallback,
+		MaxFramesInFlight,
+		LateLatchCamera
 	};
 };
 
@@ -64,7 +77,11 @@ public:
 	int   maxLogLevel;
 	int   maxAnisotropy;
 	int   shadowMapSize;
+	int   shadowAtlasSize;
 	int   sampleCount;
+	int   maxFramesInFlight;
+	float dynResTargetTime;
+	float dynResMinScale;
 	bool  texCompression;
 	bool  sRGBLinearization;
 	bool  loadTextures;
@@ -75,6 +92,9 @@ public:
 	bool  dumpFailedShaders;
 	bool  gatherTimeStats;
 	bool  debugRenderBackend;
+	bool  asyncShaderCompilation;
+	bool  asyncShaderFallback;
+	bool  lateLatchCamera;
 };
 
 
@@ -155,7 +175,21 @@ struct EngineStats
 		TextureVMem,
 		GeometryVMem,
 		ComputeGPUTime,
-		CullingTime
+		CullingTime,
+		TiledLightCount,
+		TileCount,
+		TileLightRefs,
+		TileMaxLights,
+		FrameGPUTime,
+		DynResScale,
+		OffscreenParticleGPUTime,
+		PendingShaderCount,
+		FrameWaitTime,
+		GPUIdleTime,
+		ShadowMapCount,
+		CascadeBatchCount,
+		OcclusionTestCount,
+		OccludedCount
 	};
 };
 
@@ -178,20 +212,33 @@ protected:
 	uint32    _statTriCount;
 	uint32    _statBatchCount;
 	uint32    _statLightPassCount;
+	uint32    _statTiledLightCount;
+	uint32    _statTileCount;
+	uint32    _statTileLightRefs;
+	uint32    _statTileMaxLights;
+	uint32    _statShadowMapCount;
+	uint32    _statCascadeBatchCount;
+	uint32    _statOcclusionTestCount;
+	uint32    _statOccludedCount;
+	float     _statDynResScale;
 
 	Timer     _frameTimer;
 	Timer     _animTimer;
 	Timer     _geoUpdateTimer;
 	Timer     _particleSimTimer;
 	Timer	  _cullingTimer;
+	Timer     _frameWaitTimer;
 
 	float     _frameTime;
+	float     _gpuIdleTime;
 
 	GPUTimer  *_fwdLightsGPUTimer;
 	GPUTimer  *_defLightsGPUTimer;
 	GPUTimer  *_shadowsGPUTimer;
 	GPUTimer  *_particleGPUTimer;
 	GPUTimer  *_computeGPUTimer;
+	GPUTimer  *_frameGPUTimer;
+	GPUTimer  *_offscreenParticleGPUTimer;
 	friend class ProfSample;
 };
 
@@ -218,5 +265,41 @@ struct RenderDeviceCapabilities
 
 float getRenderDeviceCapabilities( int param );
 
+// =================================================================================================
+// Parallel Helpers
+// =================================================================================================
+
+class WorkerPool
+{
+public:
+	WorkerPool();
+	~WorkerPool();
+
+	// Runs func( first, last ) on consecutive ranges of [0, count), split across the workers and the
+	// calling thread if parallel is set. Jobs do not overlap; a call while another job is running,
+	// e.g. from inside a job, is executed on the calling thread only.
+	void run( uint32 count, bool parallel, const std::function< void ( uint32, uint32 ) > &func );
+
+	uint32 getNumThreads() const { return (uint32)_threads.size() + 1; }
+
+private:
+	void workerFunc();
+	void executeRanges();
+
+private:
+	std::mutex                                     _runMutex;  // Held while a job is running
+	std::mutex                                     _mutex;
+	std::condition_variable                        _startCond, _doneCond;
+	std::vector< std::thread >                     _threads;
+
+	const std::function< void ( uint32, uint32 ) > *_func;
+	uint32                                         _count, _rangeSize, _numRanges;
+	std::atomic< uint32 >                          _nextRange;
+	uint32                                         _numPending;  // Ranges not yet finished
+	uint32                                         _numBusy;     // Workers executing ranges
+	uint32                                         _jobID;
+	bool                                           _stop;
+};
+
 }
 #endif // _egCom_H_
@@ -17,7 +17,7 @@ using namespace std;
 
 ComputeBufferResource::ComputeBufferResource( const std::string &name, int flags ) :
 	Resource( ResourceTypes::ComputeBuffer, name, flags ),
-	_dataSize( 1024 ), _bufferID( 0 ), _geoID( 0 ), _vertexLayout( 0 ), _writeRequested( false ), _mapped( false ),
+	_dataSize( 1024 ), _mapOffset( 0 ), _mapSize( 0 ), _bufferID( 0 ), _geoID( 0 ), _vertexLayout( 0 ), _writeRequested( false ), _mapped( false ),
 	_geometryParamsSet( false ), _bufferRecreated( false ), _manuallyUpdated( false ), _useAsVertexBuf( false )
 {
 	initDefault();
@@ -29,7 +29,7 @@ ComputeBufferResource::ComputeBufferResource( const std::string &name, int flags
 
 ComputeBufferResource::ComputeBufferResource( const std::string &name, uint32 bufferID, uint32 geometryID, int flags ) : 
     Resource( ResourceTypes::ComputeBuffer, name, flags ),
-    _dataSize( 1024 ), _bufferID( bufferID ), _geoID( geometryID ), _vertexLayout( 0 ), _writeRequested( false ), _mapped( false ),
+    _dataSize( 1024 ), _mapOffset( 0 ), _mapSize( 0 ), _bufferID( bufferID ), _geoID( geometryID ), _vertexLayout( 0 ), _writeRequested( false ), _mapped( false ),
     _geometryParamsSet( true ), _bufferRecreated( false ), _manuallyUpdated( false ), _useAsVertexBuf( true )
 {
 	if ( flags & ResourceFlags::NoQuery )
@@ -146,6 +146,7 @@ bool ComputeBufferResource::load( const char *data, int size )
 		layout.offset = atoi( node1.getAttribute( "offset", "0" ) );
 		layout.size = atoi( node1.getAttribute( "size", "0" ) );
 		layout.vbSlot = 0;
+		layout.divisor = 0;
 
 		int curAttribSlot = atoi( node1.getAttribute( "attribNumber" ) );
 		if ( curAttribSlot >= 0 && curAttribSlot <= totalBindingsCount )
@@ -360,6 +361,10 @@ int ComputeBufferResource::getElemParamI( int elem, int elemIdx, int param ) con
 					break;
 				case ComputeBufferResData::CompBufDrawableI:
 					return _useAsVertexBuf;
+				case ComputeBufferResData::CompBufMapOffsetI:
+					return _mapOffset;
+				case ComputeBufferResData::CompBufMapSizeI:
+					return _mapSize;
 				default:
 					break;
 			}
@@ -412,6 +417,26 @@ void ComputeBufferResource::setElemParamI( int elem, int elemIdx, int param, int
 				case ComputeBufferResData::CompBufDrawableI:
 					_useAsVertexBuf = value;
 					return;
+
+				case ComputeBufferResData::CompBufMapOffsetI:
+					if ( value < 0 || ( uint32 ) value >= _dataSize )
+					{
+						Modules::log().writeError( "Compute buffer resource '%s': %s", _name.c_str(), "incorrect map offset specified." );
+						return;
+					}
+
+					_mapOffset = value;
+					return;
+
+				case ComputeBufferResData::CompBufMapSizeI:
+					if ( value < 0 || ( uint32 ) value > _dataSize )
+					{
+						Modules::log().writeError( "Compute buffer resource '%s': %s", _name.c_str(), "incorrect map size specified." );
+						return;
+					}
+
+					_mapSize = value;
+					return;
 			}
 			break;
 
@@ -420,6 +445,7 @@ void ComputeBufferResource::setElemParamI( int elem, int elemIdx, int param, int
 			VertexLayoutAttrib params;
 			params.vbSlot = 0; // always zero because only one buffer can be specified at a time
 			params.offset = params.size = 0;
+			params.divisor = 0;
 
 			switch ( param )
 			{
@@ -510,6 +536,7 @@ void ComputeBufferResource::setElemParamStr( int elem, int elemIdx, int param, c
 					VertexLayoutAttrib params;
 					params.vbSlot = 0; // always zero because only one buffer can be specified at a time
 					params.offset = params.size = 0;
+					params.divisor = 0;
 
 					if ( _vlBindingsData.empty() || elemIdx == _vlBindingsData.size() )
 					{
@@ -548,15 +575,25 @@ void *ComputeBufferResource::mapStream( int elem, int elemIdx, int stream, bool
 		{
 			RenderDeviceInterface *rdi = Modules::renderer().getRenderDevice();
 
+			// Only the requested range is mapped, so that single chunks can be streamed into a large buffer
+			if ( _mapSize == 0 ) _mapSize = _dataSize - _mapOffset;
+			if ( _mapOffset + _mapSize > _dataSize )
+			{
+				Modules::log().writeError( "Compute buffer resource '%s': %s", _name.c_str(), "mapped range exceeds the buffer size." );
+				_mapOffset = _mapSize = 0;
+				return 0x0;
+			}
+
 			_mapped = true;
 
-			// Ensure that we are getting data that is not updated right now by the GPU
-            rdi->setMemoryBarrier( VertexBufferBarrier );
+			// Ensure that we are getting data that is not updated right now by the GPU; the barrier has to be
+			// issued right away since mapping is not deferred to the next draw or dispatch
+			Modules::renderer().syncBufferAccess( _bufferID, BufferUpdateBarrier, true );
 
 			if ( read )
 			{
 				_writeRequested = false;
-				return rdi->mapBuffer( 0, _bufferID, 0, _dataSize, Read );
+				return rdi->mapBuffer( 0, _bufferID, _mapOffset, _mapSize, Read );
 			}
 
 			if ( write )
@@ -565,11 +602,11 @@ void *ComputeBufferResource::mapStream( int elem, int elemIdx, int stream, bool
 
 				if ( _bufferRecreated )
 				{
-					return Modules::renderer().useScratchBuf( _dataSize, 1 );
+					return Modules::renderer().useScratchBuf( _mapSize, 1 );
 				} 
 				else
 				{
-					return rdi->mapBuffer( 0, _bufferID, 0, _dataSize, Write );
+					return rdi->mapBuffer( 0, _bufferID, _mapOffset, _mapSize, Write );
 				}
 			}
 
@@ -597,7 +634,7 @@ void ComputeBufferResource::unmapStream()
 			// GL4: for some reason NVIDIA hardware has a significant performance drop if you upload 
 			// a large chunk of data to a not initialized buffer (with 0x0 as data) with buffer map
 			// but has no performance drop if you upload it with BufferData. Therefore this workaround with scratch buffer is used.
-			rdi->updateBufferData( _geoID, _bufferID, 0, _dataSize, Modules::renderer().useScratchBuf( _dataSize, 1 ) );
+			rdi->updateBufferData( _geoID, _bufferID, _mapOffset, _mapSize, Modules::renderer().useScratchBuf( _mapSize, 1 ) );
 
 			_bufferRecreated = false;
 		} 
@@ -608,6 +645,7 @@ void ComputeBufferResource::unmapStream()
 	}
 
 	_mapped = false;
+	_mapOffset = _mapSize = 0;
 }
 
 } // namespace
@@ -33,7 +33,9 @@ struct ComputeBufferResData
 		DrawParamsNameStr,
 		DrawParamsSizeI,
 		DrawParamsOffsetI,
-		DrawParamsCountI
+		DrawParamsCountI,
+		CompBufMapOffsetI,
+		CompBufMapSizeI
 	};
 };
 
@@ -88,6 +90,7 @@ private:
 	std::vector< VertexLayoutAttrib >	_vlBindingsData;  /* Vertex binding parameters, if buffer is used for drawing. */
 
 	uint32								_dataSize;
+	uint32								_mapOffset, _mapSize;  // Byte range of the next mapping, size 0 maps the whole buffer
 	uint32								_bufferID;
 	uint32								_geoID;
 
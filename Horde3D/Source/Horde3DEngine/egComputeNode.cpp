@@ -28,6 +28,10 @@ ComputeNode::ComputeNode( const ComputeNodeTpl &computeTpl ) : SceneNode( comput
 	_materialRes = computeTpl.matRes;
 	_drawType = computeTpl.drawType;
 	_elementsCount = computeTpl.elementsCount;
+	_elementsStart = computeTpl.elementsStart;
+	_lodDensity = computeTpl.lodDensity;
+	_indirectBufferRes = computeTpl.indirectBufRes;
+	_indirectOffset = computeTpl.indirectOffset;
 
 	_renderable = true;
 
@@ -67,6 +71,17 @@ SceneNodeTpl *ComputeNode::parsingFunc( map< string, string > &attribs )
 	}
 	else result = false;
 
+	itr = attribs.find( "indirectBuffer" );
+	if ( itr != attribs.end() )
+	{
+		uint32 res = Modules::resMan().addResource( ResourceTypes::ComputeBuffer, itr->second, 0, false );
+		if ( res != 0 )
+			computeTpl->indirectBufRes = ( ComputeBufferResource * ) Modules::resMan().resolveResHandle( res );
+	}
+
+	itr = attribs.find( "indirectOffset" );
+	if ( itr != attribs.end() ) computeTpl->indirectOffset = atoi( itr->second.c_str() );
+
 	itr = attribs.find( "drawType" );
 	if ( itr != attribs.end() )
 	{
@@ -79,7 +94,13 @@ SceneNodeTpl *ComputeNode::parsingFunc( map< string, string > &attribs )
 	
 	itr = attribs.find( "elementsCount" );
 	if ( itr != attribs.end() ) computeTpl->elementsCount = atoi( itr->second.c_str() );
-	else result = false;
+	else if ( !computeTpl->indirectBufRes ) result = false;
+
+	itr = attribs.find( "elementsStart" );
+	if ( itr != attribs.end() ) computeTpl->elementsStart = atoi( itr->second.c_str() );
+
+	itr = attribs.find( "lodDensity" );
+	if ( itr != attribs.end() ) computeTpl->lodDensity = toFloat( itr->second.c_str() );
 	
 	// AABB
 	itr = attribs.find( "aabbMinX" );
@@ -130,6 +151,28 @@ void ComputeNode::onPostUpdate()
 }
 
 
+uint32 ComputeNode::calcLodElementsCount( const Vec3f &viewPoint, float pixelsPerUnit, bool orthographic ) const
+{
+	if ( _lodDensity <= 0 ) return _elementsCount;
+
+	// The projected bounding sphere approximates the screen area covered by the elements
+	Vec3f center = ( _bBox.min + _bBox.max ) * 0.5f;
+	float radius = ( _bBox.max - _bBox.min ).length() * 0.5f;
+	
+	if ( !orthographic )
+	{
+		float dist = ( center - viewPoint ).length();
+		if ( dist <= radius ) return _elementsCount;
+		pixelsPerUnit /= dist;
+	}
+
+	float pixelRadius = radius * pixelsPerUnit;
+	float count = ceilf( _lodDensity * Math::Pi * pixelRadius * pixelRadius );
+
+	return count < ( float ) _elementsCount ? ( uint32 ) count : _elementsCount;
+}
+
+
 int ComputeNode::getParamI( int param ) const
 {
 	switch ( param )
@@ -144,6 +187,13 @@ int ComputeNode::getParamI( int param ) const
 			return _drawType;
 		case ComputeNodeParams::ElementsCountI:
 			return _elementsCount;
+		case ComputeNodeParams::IndirectBufResI:
+			if ( _indirectBufferRes ) return _indirectBufferRes->getHandle();
+			else return 0;
+		case ComputeNodeParams::IndirectOffsetI:
+			return _indirectOffset;
+		case ComputeNodeParams::ElementsStartI:
+			return _elementsStart;
 		default:
 			break;
 	}
@@ -190,6 +240,31 @@ void ComputeNode::setParamI( int param, int value )
 
 			_elementsCount = value;
 			return;
+		case ComputeNodeParams::IndirectBufResI:
+			res = Modules::resMan().resolveResHandle( value );
+			if ( res == 0x0 || res->getType() == ResourceTypes::ComputeBuffer )
+				_indirectBufferRes = ( ComputeBufferResource * ) res;
+			else
+				Modules::setError( "Invalid handle in h3dSetNodeParamI for H3DComputeNode::IndirectBufResI" );
+			return;
+		case ComputeNodeParams::IndirectOffsetI:
+			if ( value < 0 || value % 4 != 0 )
+			{
+				Modules::log().writeError( "Invalid offset specified in h3dSetNodeParamI for H3DComputeNode::IndirectOffsetI" );
+				return;
+			}
+
+			_indirectOffset = value;
+			return;
+		case ComputeNodeParams::ElementsStartI:
+			if ( value < 0 )
+			{
+				Modules::log().writeError( "Invalid first element specified in h3dSetNodeParamI for H3DComputeNode::ElementsStartI" );
+				return;
+			}
+
+			_elementsStart = value;
+			return;
 		default:
 			break;
 	}
@@ -218,6 +293,8 @@ float ComputeNode::getParamF( int param, int compIdx ) const
 			}
 
 			return _localBBox.max[ compIdx ];
+		case ComputeNodeParams::LodDensityF:
+			return _lodDensity;
 		default:
 			break;
 	}
@@ -251,6 +328,15 @@ void ComputeNode::setParamF( int param, int compIdx, float value )
 			_localBBox.max[ compIdx ] = value;
 			markDirty();
 
+			return;
+		case ComputeNodeParams::LodDensityF:
+			if ( value < 0 )
+			{
+				Modules::log().writeError( "Invalid density specified in h3dSetNodeParamF for H3DComputeNode::LodDensityF" );
+				return;
+			}
+
+			_lodDensity = value;
 			return;
 		default:
 			break;
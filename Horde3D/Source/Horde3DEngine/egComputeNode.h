@@ -31,7 +31,11 @@ struct ComputeNodeParams
 		AABBMinF,
 		AABBMaxF,
 		DrawTypeI,
-		ElementsCountI
+		ElementsCountI,
+		IndirectBufResI,
+		IndirectOffsetI,
+		ElementsStartI,
+		LodDensityF
 	};
 };
 
@@ -39,14 +43,18 @@ struct ComputeNodeTpl : public SceneNodeTpl
 {
 	PMaterialResource		matRes;
 	PComputeBufferResource  compBufRes;
+	PComputeBufferResource  indirectBufRes;
+	int						indirectOffset;
 	int						drawType;
 	int						elementsCount;
+	int						elementsStart;
+	float					lodDensity;
 	Vec3f					aabbMin, aabbMax;
 
 	ComputeNodeTpl( const std::string &name, ComputeBufferResource *computeBufferRes, MaterialResource *materialRes,
 					int vertDrawType, int elemDrawCount ) :
 						SceneNodeTpl( SceneNodeTypes::Compute, name ), matRes( materialRes ), compBufRes( computeBufferRes ),
-						drawType( vertDrawType ), elementsCount( elemDrawCount ), aabbMin( Vec3f( 0, 0, 0 ) ), aabbMax( Vec3f( 1, 1, 1 ) )
+						indirectOffset( 0 ), drawType( vertDrawType ), elementsCount( elemDrawCount ), elementsStart( 0 ), lodDensity( 0 ), aabbMin( Vec3f( 0, 0, 0 ) ), aabbMax( Vec3f( 1, 1, 1 ) )
 	{
 	}
 
@@ -61,6 +69,8 @@ public:
 
 	void onPostUpdate();
 
+	uint32 calcLodElementsCount( const Vec3f &viewPoint, float pixelsPerUnit, bool orthographic ) const;
+
 	int getParamI( int param ) const;
 	void setParamI( int param, int value );
 	float getParamF( int param, int compIdx ) const;
@@ -80,8 +90,12 @@ protected:
 
 	PMaterialResource		_materialRes;
 	PComputeBufferResource	_compBufferRes;
+	PComputeBufferResource	_indirectBufferRes;  // Draw arguments written on the GPU, replace _elementsCount
 
 	uint32					_elementsCount;
+	uint32					_elementsStart;  // First element of the range drawn by this node, e.g. a point cloud chunk
+	uint32					_indirectOffset;
+	float					_lodDensity;  // Target elements per covered screen pixel, 0 disables subsampling
 
 	int16					_drawType;
 
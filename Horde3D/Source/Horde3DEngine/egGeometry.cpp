@@ -27,8 +27,186 @@ namespace Horde3D {
 using namespace std;
 
 
+// *************************************************************************************************
+// Class GeometryArena
+// *************************************************************************************************
+
+const uint32 GeometryArena::InitialVertCapacity;
+const uint32 GeometryArena::InitialIndexCapacity;
+const uint32 GeometryArena::MinCompactionSize;
+
+
+GeometryArena::GeometryArena( uint32 vertexLayout ) :
+	_vertexLayout( vertexLayout ), _indexBuf( 0 ), _posVBuf( 0 ), _tanVBuf( 0 ), _staticVBuf( 0 ), _geoObj( 0 )
+{
+}
+
+
+GeometryArena::~GeometryArena()
+{
+	destroyBuffers();
+}
+
+
+void GeometryArena::addResource( GeometryResource *res )
+{
+	ASSERT( !res->_inArena );
+	
+	if( !allocRanges( res ) )
+	{
+		// Compaction is enough if the free space is just scattered, otherwise the buffers grow
+		uint32 vertCapacity = _vertArena.getCapacity();
+		uint32 indexCapacity = _indexArena.getCapacity();
+		uint32 vertsNeeded = _vertArena.getUsed() + res->_vertCount;
+		uint32 indicesNeeded = _indexArena.getUsed() + res->_indexCount;
+
+		if( vertsNeeded > vertCapacity )
+			vertCapacity = std::max( std::max( vertCapacity * 2, InitialVertCapacity ), vertsNeeded );
+		if( indicesNeeded > indexCapacity )
+			indexCapacity = std::max( std::max( indexCapacity * 2, InitialIndexCapacity ), indicesNeeded );
+		
+		rebuild( vertCapacity, indexCapacity );
+		
+		bool allocated = allocRanges( res );
+		ASSERT( allocated );
+		H3D_UNUSED_VAR( allocated );
+	}
+
+	res->_inArena = true;
+	_residents.push_back( res );
+
+	res->uploadIndexData();
+	res->uploadVertexData( GeometryResData::GeoVertPosStream );
+	res->uploadVertexData( GeometryResData::GeoVertTanStream );
+	res->uploadVertexData( GeometryResData::GeoVertStaticStream );
+}
+
+
+void GeometryArena::removeResource( GeometryResource *res )
+{
+	ASSERT( res->_inArena );
+	
+	_vertArena.release( res->_baseVertex, res->_vertCount );
+	_indexArena.release( res->_firstIndex, res->_indexCount );
+	_residents.erase( std::find( _residents.begin(), _residents.end(), res ) );
+	
+	res->_inArena = false;
+	res->_baseVertex = 0;
+	res->_firstIndex = 0;
+
+	if( _residents.empty() )
+	{
+		destroyBuffers();
+	}
+	else if( isFragmented( _vertArena ) || isFragmented( _indexArena ) )
+	{
+		rebuild( _vertArena.getCapacity(), _indexArena.getCapacity() );
+	}
+}
+
+
+bool GeometryArena::allocRanges( GeometryResource *res )
+{
+	if( !_vertArena.alloc( res->_vertCount, res->_baseVertex ) ) return false;
+	
+	if( !_indexArena.alloc( res->_indexCount, res->_firstIndex ) )
+	{
+		_vertArena.release( res->_baseVertex, res->_vertCount );
+		return false;
+	}
+
+	return true;
+}
+
+
+bool GeometryArena::isFragmented( const RDIBufferArena &arena ) const
+{
+	// Holes are tolerated up to half of the allocated size, so compaction cost stays amortized
+	return arena.getFragmentedSize() > std::max( arena.getUsed() / 2, MinCompactionSize );
+}
+
+
+void GeometryArena::rebuild( uint32 vertCapacity, uint32 indexCapacity )
+{
+	RenderDeviceInterface *rdi = Modules::renderer().getRenderDevice();
+
+	bool newBuffers = vertCapacity != _vertArena.getCapacity() || indexCapacity != _indexArena.getCapacity();
+	if( newBuffers )
+	{
+		destroyBuffers();
+
+		_geoObj = rdi->beginCreatingGeometry( _vertexLayout );
+
+		_indexBuf = rdi->createIndexBuffer( indexCapacity * sizeof( uint32 ), 0x0 );
+		_posVBuf = rdi->createVertexBuffer( vertCapacity * sizeof( Vec3f ), 0x0 );
+		_tanVBuf = rdi->createVertexBuffer( vertCapacity * sizeof( VertexDataTan ), 0x0 );
+		_staticVBuf = rdi->createVertexBuffer( vertCapacity * sizeof( VertexDataStatic ), 0x0 );
+
+		rdi->setGeomVertexParams( _geoObj, _posVBuf, 0, 0, sizeof( Vec3f ) );
+		rdi->setGeomVertexParams( _geoObj, _tanVBuf, 1, 0, sizeof( VertexDataTan ) );
+		rdi->setGeomVertexParams( _geoObj, _tanVBuf, 2, sizeof( Vec3f ), sizeof( VertexDataTan ) );
+		rdi->setGeomVertexParams( _geoObj, _staticVBuf, 3, 0, sizeof( VertexDataStatic ) );
+		rdi->setGeomIndexParams( _geoObj, _indexBuf, IDXFMT_32 );
+
+		rdi->finishCreatingGeometry( _geoObj );
+	}
+	
+	// Pack resident geometry to the front of the arena, keeping its order. The data is uploaded
+	// again from the CPU copies that every geometry resource keeps.
+	std::vector< std::pair< uint32, GeometryResource * > > residents( _residents.size() );
+	for( size_t i = 0; i < _residents.size(); ++i )
+		residents[i] = std::make_pair( _residents[i]->_baseVertex, _residents[i] );
+	std::sort( residents.begin(), residents.end() );
+
+	_vertArena.reset( vertCapacity );
+	_indexArena.reset( indexCapacity );
+
+	for( size_t i = 0; i < residents.size(); ++i )
+	{
+		GeometryResource *res = residents[i].second;
+		uint32 prevBaseVertex = res->_baseVertex, prevFirstIndex = res->_firstIndex;
+		
+		bool allocated = allocRanges( res );
+		ASSERT( allocated );
+		H3D_UNUSED_VAR( allocated );
+
+		if( newBuffers || res->_firstIndex != prevFirstIndex ) res->uploadIndexData();
+		if( newBuffers || res->_baseVertex != prevBaseVertex )
+		{
+			res->uploadVertexData( GeometryResData::GeoVertPosStream );
+			res->uploadVertexData( GeometryResData::GeoVertTanStream );
+			res->uploadVertexData( GeometryResData::GeoVertStaticStream );
+		}
+	}
+}
+
+
+void GeometryArena::destroyBuffers()
+{
+	RenderDeviceInterface *rdi = Modules::renderer().getRenderDevice();
+	
+	if( _geoObj != 0 )
+	{
+		rdi->destroyGeometry( _geoObj, false );
+		rdi->destroyBuffer( _posVBuf );
+		rdi->destroyBuffer( _tanVBuf );
+		rdi->destroyBuffer( _staticVBuf );
+		rdi->destroyBuffer( _indexBuf );
+		_geoObj = 0; _indexBuf = 0; _posVBuf = 0; _tanVBuf = 0; _staticVBuf = 0;
+	}
+
+	_vertArena.reset( 0 );
+	_indexArena.reset( 0 );
+}
+
+
+// *************************************************************************************************
+// Class GeometryResource
+// *************************************************************************************************
+
 uint32 GeometryResource::defVertBuffer = 0;
 uint32 GeometryResource::defIndexBuffer = 0;
+GeometryArena *GeometryResource::modelArena = 0x0;
 int GeometryResource::mappedWriteStream = -1;
 
 
@@ -36,11 +214,16 @@ void GeometryResource::initializationFunc()
 {
 	defVertBuffer = Modules::renderer().getRenderDevice()->createVertexBuffer( 0, 0x0 );
 	defIndexBuffer = Modules::renderer().getRenderDevice()->createIndexBuffer( 0, 0x0 );
+
+	if( Modules::renderer().getRenderDevice()->getCaps().drawBaseVertex )
+		modelArena = new GeometryArena( Modules::renderer().getDefaultVertexLayout( DefaultVertexLayouts::Model ) );
 }
 
 
 void GeometryResource::releaseFunc()
 {
+	delete modelArena; modelArena = 0x0;
+	
 	Modules::renderer().getRenderDevice()->destroyBuffer( defVertBuffer );
 	Modules::renderer().getRenderDevice()->destroyBuffer( defIndexBuffer );
 }
@@ -64,8 +247,9 @@ Resource *GeometryResource::clone()
 	GeometryResource *res = new GeometryResource( "", _flags );
 
 	*res = *this;
-
-	RenderDeviceInterface *rdi = Modules::renderer().getRenderDevice();
+	res->_inArena = false;
+	res->_baseVertex = 0;
+	res->_firstIndex = 0;
 
 	// TODO: Check if elemcpy_le should be used
 	// Make a deep copy of the data
@@ -79,20 +263,7 @@ Resource *GeometryResource::clone()
 	memcpy( res->_vertStaticData, _vertStaticData, _vertCount * sizeof( VertexDataStatic ) );
 
 	res->_16BitIndices = _16BitIndices;
-	res->_geoObj = rdi->beginCreatingGeometry( Modules::renderer().getDefaultVertexLayout( DefaultVertexLayouts::Model ) );
-
-	res->_indexBuf = rdi->createIndexBuffer( _indexCount * (_16BitIndices ? 2 : 4), _indexData );
-	res->_posVBuf = rdi->createVertexBuffer( _vertCount * sizeof( Vec3f ), _vertPosData );
-	res->_tanVBuf = rdi->createVertexBuffer( _vertCount * sizeof( VertexDataTan ), _vertTanData );
-	res->_staticVBuf = rdi->createVertexBuffer( _vertCount * sizeof( VertexDataStatic ), _vertStaticData );
-
-	rdi->setGeomVertexParams( res->_geoObj, res->_posVBuf, 0, 0, sizeof( Vec3f ) );
-	rdi->setGeomVertexParams( res->_geoObj, res->_tanVBuf, 1, 0, sizeof( VertexDataTan ) );
-	rdi->setGeomVertexParams( res->_geoObj, res->_tanVBuf, 2, sizeof( Vec3f ), sizeof( VertexDataTan ) );
-	rdi->setGeomVertexParams( res->_geoObj, res->_staticVBuf, 3, 0, sizeof( VertexDataStatic ) );
-	rdi->setGeomIndexParams( res->_geoObj, res->_indexBuf, _16BitIndices ? IDXFMT_16 : IDXFMT_32 );
-
-	rdi->finishCreatingGeometry( res->_geoObj );
+	res->createGeometry();
 
 	return res;
 }
@@ -112,6 +283,9 @@ void GeometryResource::initDefault()
 	_tanVBuf = defVertBuffer;
 	_staticVBuf = defVertBuffer;
 	_geoObj = 0;
+	_inArena = false;
+	_baseVertex = 0;
+	_firstIndex = 0;
 	_minMorphIndex = 0; _maxMorphIndex = 0;
 	_skelAABB.min = Vec3f( 0, 0, 0 );
 	_skelAABB.max = Vec3f( 0, 0, 0 );
@@ -122,6 +296,9 @@ void GeometryResource::release()
 {
 	RenderDeviceInterface *rdi = Modules::renderer().getRenderDevice();
 
+	if( _inArena )
+		modelArena->removeResource( this );
+
 	if ( _geoObj != 0 )
 		rdi->destroyGeometry( _geoObj, false );
 
@@ -485,29 +662,96 @@ bool GeometryResource::load( const char *data, int size )
 	// Upload data
 	if( _vertCount > 0 && _indexCount > 0 )
 	{
-		RenderDeviceInterface *rdi = Modules::renderer().getRenderDevice();
+		createGeometry();
+	}
+	
+	return true;
+}
 
-		_geoObj = rdi->beginCreatingGeometry( Modules::renderer().getDefaultVertexLayout( DefaultVertexLayouts::Model ) );
 
-		// Upload indices
-		_indexBuf = rdi->createIndexBuffer( _indexCount * (_16BitIndices ? 2 : 4), _indexData );
-		
-		// Upload vertices
-		_posVBuf = rdi->createVertexBuffer(_vertCount * sizeof( Vec3f ), _vertPosData );
-		_tanVBuf = rdi->createVertexBuffer( _vertCount * sizeof( VertexDataTan ), _vertTanData );
-		_staticVBuf = rdi->createVertexBuffer( _vertCount * sizeof( VertexDataStatic ), _vertStaticData );
+void GeometryResource::createGeometry()
+{
+	if( modelArena != 0x0 )
+	{
+		modelArena->addResource( this );
+		return;
+	}
+	
+	RenderDeviceInterface *rdi = Modules::renderer().getRenderDevice();
 
-		rdi->setGeomVertexParams( _geoObj, _posVBuf, 0, 0, sizeof( Vec3f ) );
-		rdi->setGeomVertexParams( _geoObj, _tanVBuf, 1, 0, sizeof( VertexDataTan ) );
-		rdi->setGeomVertexParams( _geoObj, _tanVBuf, 2, sizeof( Vec3f ), sizeof( VertexDataTan ) );
-		rdi->setGeomVertexParams( _geoObj, _staticVBuf, 3, 0, sizeof( VertexDataStatic ) );
+	_geoObj = rdi->beginCreatingGeometry( Modules::renderer().getDefaultVertexLayout( DefaultVertexLayouts::Model ) );
 
-		rdi->setGeomIndexParams( _geoObj, _indexBuf, _16BitIndices ? IDXFMT_16 : IDXFMT_32 );
+	// Upload indices
+	_indexBuf = rdi->createIndexBuffer( _indexCount * (_16BitIndices ? 2 : 4), _indexData );
+	
+	// Upload vertices
+	_posVBuf = rdi->createVertexBuffer(_vertCount * sizeof( Vec3f ), _vertPosData );
+	_tanVBuf = rdi->createVertexBuffer( _vertCount * sizeof( VertexDataTan ), _vertTanData );
+	_staticVBuf = rdi->createVertexBuffer( _vertCount * sizeof( VertexDataStatic ), _vertStaticData );
 
-		rdi->finishCreatingGeometry( _geoObj );
+	rdi->setGeomVertexParams( _geoObj, _posVBuf, 0, 0, sizeof( Vec3f ) );
+	rdi->setGeomVertexParams( _geoObj, _tanVBuf, 1, 0, sizeof( VertexDataTan ) );
+	rdi->setGeomVertexParams( _geoObj, _tanVBuf, 2, sizeof( Vec3f ), sizeof( VertexDataTan ) );
+	rdi->setGeomVertexParams( _geoObj, _staticVBuf, 3, 0, sizeof( VertexDataStatic ) );
+
+	rdi->setGeomIndexParams( _geoObj, _indexBuf, _16BitIndices ? IDXFMT_16 : IDXFMT_32 );
+
+	rdi->finishCreatingGeometry( _geoObj );
+}
+
+
+void GeometryResource::uploadIndexData()
+{
+	if( _indexData == 0x0 ) return;
+	
+	RenderDeviceInterface *rdi = Modules::renderer().getRenderDevice();
+
+	if( !_inArena )
+	{
+		rdi->updateBufferData( _geoObj, _indexBuf, 0, _indexCount * (_16BitIndices ? 2 : 4), _indexData );
+	}
+	else if( _16BitIndices )
+	{
+		// Arena indices are always 32 bit
+		std::vector< uint32 > indices( _indexCount );
+		for( uint32 i = 0; i < _indexCount; ++i ) indices[i] = ((uint16 *)_indexData)[i];
+		
+		rdi->updateBufferData( getGeometryInfo(), getIndexBuf(), _firstIndex * sizeof( uint32 ),
+		                       _indexCount * sizeof( uint32 ), &indices[0] );
 	}
+	else
+	{
+		rdi->updateBufferData( getGeometryInfo(), getIndexBuf(), _firstIndex * sizeof( uint32 ),
+		                       _indexCount * sizeof( uint32 ), _indexData );
+	}
+}
+
+
+void GeometryResource::uploadVertexData( int stream )
+{
+	uint32 buf, elemSize;
+	void *data;
 	
-	return true;
+	switch( stream )
+	{
+	case GeometryResData::GeoVertPosStream:
+		buf = getPosVBuf(); elemSize = sizeof( Vec3f ); data = _vertPosData;
+		break;
+	case GeometryResData::GeoVertTanStream:
+		buf = getTanVBuf(); elemSize = sizeof( VertexDataTan ); data = _vertTanData;
+		break;
+	case GeometryResData::GeoVertStaticStream:
+		buf = getStaticVBuf(); elemSize = sizeof( VertexDataStatic ); data = _vertStaticData;
+		break;
+	default:
+		return;
+	}
+
+	if( data != 0x0 )
+	{
+		Modules::renderer().getRenderDevice()->updateBufferData( getGeometryInfo(), buf, _baseVertex * elemSize,
+		                                                         _vertCount * elemSize, data );
+	}
 }
 
 int GeometryResource::getElemCount( int elem ) const
@@ -576,27 +820,10 @@ void GeometryResource::unmapStream()
 {
 	if( mappedWriteStream >= 0 )
 	{
-		RenderDeviceInterface *rdi = Modules::renderer().getRenderDevice();
-
-		switch( mappedWriteStream )
-		{
-		case GeometryResData::GeoIndexStream:
-			if( _indexData != 0x0 )
-				rdi->updateBufferData( _geoObj, _indexBuf, 0, _indexCount * (_16BitIndices ? 2 : 4), _indexData );
-			break;
-		case GeometryResData::GeoVertPosStream:
-			if( _vertPosData != 0x0 )
-				rdi->updateBufferData( _geoObj, _posVBuf, 0, _vertCount * sizeof( Vec3f ), _vertPosData );
-			break;
-		case GeometryResData::GeoVertTanStream:
-			if( _vertTanData != 0x0 )
-				rdi->updateBufferData( _geoObj, _tanVBuf, 0, _vertCount * sizeof( VertexDataTan ), _vertTanData );
-			break;
-		case GeometryResData::GeoVertStaticStream:
-			if( _vertStaticData != 0x0 )
-				rdi->updateBufferData( _geoObj, _staticVBuf, 0, _vertCount * sizeof( VertexDataStatic ), _vertStaticData );
-			break;
-		}
+		if( mappedWriteStream == GeometryResData::GeoIndexStream )
+			uploadIndexData();
+		else
+			uploadVertexData( mappedWriteStream );
 
 		mappedWriteStream = -1;
 	}
@@ -606,14 +833,8 @@ void GeometryResource::unmapStream()
 void GeometryResource::updateDynamicVertData()
 {
 	// Upload dynamic stream data
-	if( _vertPosData != 0x0 )
-	{
-		Modules::renderer().getRenderDevice()->updateBufferData( _geoObj, _posVBuf, 0, _vertCount * sizeof( Vec3f ), _vertPosData );
-	}
-	if( _vertTanData != 0x0 )
-	{
-		Modules::renderer().getRenderDevice()->updateBufferData( _geoObj, _tanVBuf, 0, _vertCount * sizeof( VertexDataTan ), _vertTanData );
-	}
+	uploadVertexData( GeometryResData::GeoVertPosStream );
+	uploadVertexData( GeometryResData::GeoVertTanStream );
 }
 
 }  // namespace
@@ -16,6 +16,7 @@
 #include "egPrerequisites.h"
 #include "egResource.h"
 #include "egPrimitives.h"
+#include "egRendererBase.h"
 #include "utMath.h"
 
 
@@ -78,6 +79,47 @@ struct MorphTarget
 	std::vector< MorphDiff >  diffs;
 };
 
+// =================================================================================================
+// Geometry Arena
+// =================================================================================================
+
+class GeometryResource;
+
+// Shared vertex and index buffers for one vertex layout. Geometry resources are sub-allocated from
+// them and drawn with a base vertex, so a single geometry object covers all resident resources.
+class GeometryArena
+{
+public:
+	GeometryArena( uint32 vertexLayout );
+	~GeometryArena();
+
+	void addResource( GeometryResource *res );
+	void removeResource( GeometryResource *res );
+
+	uint32 getGeometryInfo() const { return _geoObj; }
+	uint32 getPosVBuf() const { return _posVBuf; }
+	uint32 getTanVBuf() const { return _tanVBuf; }
+	uint32 getStaticVBuf() const { return _staticVBuf; }
+	uint32 getIndexBuf() const { return _indexBuf; }
+
+private:
+	bool allocRanges( GeometryResource *res );
+	bool isFragmented( const RDIBufferArena &arena ) const;
+	void rebuild( uint32 vertCapacity, uint32 indexCapacity );
+	void destroyBuffers();
+
+private:
+	static const uint32  InitialVertCapacity = 65536;
+	static const uint32  InitialIndexCapacity = 196608;
+	static const uint32  MinCompactionSize = 4096;
+
+	uint32                             _vertexLayout;
+	uint32                             _indexBuf, _posVBuf, _tanVBuf, _staticVBuf;
+	uint32                             _geoObj;
+	RDIBufferArena                     _vertArena, _indexArena;  // In vertices and 32 bit indices
+	std::vector< GeometryResource * >  _residents;
+};
+
 // =================================================================================================
 
 class GeometryResource : public Resource
@@ -108,24 +150,32 @@ public:
 	Vec3f *getVertPosData() const { return _vertPosData; }
 	VertexDataTan *getVertTanData() const { return _vertTanData; }
 	VertexDataStatic *getVertStaticData() const { return _vertStaticData; }
-	uint32 getGeometryInfo() const { return _geoObj; }
-	uint32 getPosVBuf() const { return _posVBuf; }
-	uint32 getTanVBuf() const { return _tanVBuf; }
-	uint32 getStaticVBuf() const { return _staticVBuf; }
-	uint32 getIndexBuf() const { return _indexBuf; }
+	uint32 getGeometryInfo() const { return _inArena ? modelArena->getGeometryInfo() : _geoObj; }
+	uint32 getPosVBuf() const { return _inArena ? modelArena->getPosVBuf() : _posVBuf; }
+	uint32 getTanVBuf() const { return _inArena ? modelArena->getTanVBuf() : _tanVBuf; }
+	uint32 getStaticVBuf() const { return _inArena ? modelArena->getStaticVBuf() : _staticVBuf; }
+	uint32 getIndexBuf() const { return _inArena ? modelArena->getIndexBuf() : _indexBuf; }
+	uint32 getBaseVertex() const { return _baseVertex; }
+	uint32 getFirstIndex() const { return _firstIndex; }
 	Matrix4f &getInvBindMat( uint32 jointIndex ) { return _joints[jointIndex].invBindMat; }
 
 public:
 	static uint32 defVertBuffer, defIndexBuffer;
+	static GeometryArena *modelArena;  // NULL if the device does not support base vertex draws
 
 private:
 	bool raiseError( const std::string &msg );
+	void createGeometry();
+	void uploadIndexData();
+	void uploadVertexData( int stream );
 
 private:
 	static int                  mappedWriteStream;
 	
 	uint32                      _indexBuf, _posVBuf, _tanVBuf, _staticVBuf;
 	uint32						_geoObj;
+	bool                        _inArena;
+	uint32                      _baseVertex, _firstIndex;  // Location in the shared arena buffers
 
 	uint32                      _indexCount, _vertCount;
 	bool                        _16BitIndices;
@@ -140,6 +190,7 @@ private:
 	uint32                      _minMorphIndex, _maxMorphIndex;
 
 	friend class Renderer;
+	friend class GeometryArena;
 	friend class ModelNode;
 	friend class MeshNode;
 };
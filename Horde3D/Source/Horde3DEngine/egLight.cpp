@@ -35,6 +35,7 @@ LightNode::LightNode( const LightNodeTpl &lightTpl ) :
 	_shadowMapCount = lightTpl.shadowMapCount;
 	_shadowSplitLambda = lightTpl.shadowSplitLambda;
 	_shadowMapBias = lightTpl.shadowMapBias;
+	for( uint32 i = 0; i < 5; ++i ) _shadowSplitDists[i] = 0;
 
 	_shadowRenderParamsID = -1;
 	_renderViewID = -1;
@@ -167,6 +168,9 @@ float LightNode::getParamF( int param, int compIdx ) const
 		return _shadowSplitLambda;
 	case LightNodeParams::ShadowMapBiasF:
 		return _shadowMapBias;
+	case LightNodeParams::ShadowSplitDistsF5:
+		if( (unsigned)compIdx < 5 ) return _shadowSplitDists[compIdx];
+		break;
 	}
 
 	return SceneNode::getParamF( param, compIdx );
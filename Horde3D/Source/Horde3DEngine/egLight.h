@@ -37,7 +37,8 @@ struct LightNodeParams
 		ShadowSplitLambdaF,
 		ShadowMapBiasF,
 		LightingContextStr,
-		ShadowContextStr
+		ShadowContextStr,
+		ShadowSplitDistsF5
 	};
 };
 
@@ -101,6 +102,7 @@ private:
 	float                  _diffuseColMult;
 	uint32                 _shadowMapCount;
 	float                  _shadowSplitLambda, _shadowMapBias;
+	float                  _shadowSplitDists[5];  // Split distances of the last rendered frame
 
 	int					   _shadowRenderParamsID; // id for shadow parameters (frustums, matrices) queue in renderer
 	int					   _renderViewID; 
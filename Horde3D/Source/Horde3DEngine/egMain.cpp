@@ -77,6 +77,20 @@ inline const string &safeStr( const char *str, int index )
 }
 
 
+// Resolves a node of a batched call; invalid handles are reported and skipped instead of
+// aborting the whole batch
+inline SceneNode *resolveBatchNode( NodeHandle node, int type, const char *func )
+{
+	SceneNode *sn = Modules::sceneMan().resolveNodeHandle( node );
+	if( sn == 0x0 || (type != SceneNodeTypes::Undefined && sn->getType() != type) )
+	{
+		Modules::setError( "Invalid node handle in ", func );
+		return 0x0;
+	}
+	return sn;
+}
+
+
 // =================================================================================================
 // Basic functions
 // =================================================================================================
@@ -136,6 +150,15 @@ H3D_IMPL void h3dCompute( int materialRes, const char *context, int groupX, int
 }
 
 
+H3D_IMPL void h3dPrepareRender( NodeHandle cameraNode )
+{
+	SceneNode *sn = Modules::sceneMan().resolveNodeHandle( cameraNode );
+	APIFUNC_VALIDATE_NODE_TYPE( sn, SceneNodeTypes::Camera, "h3dPrepareRender", APIFUNC_RET_VOID );
+	
+	Modules::renderer().prepareRender( (CameraNode *)sn );
+}
+
+
 H3D_IMPL void h3dRender( NodeHandle cameraNode )
 {
 	SceneNode *sn = Modules::sceneMan().resolveNodeHandle( cameraNode );
@@ -296,6 +319,15 @@ H3D_IMPL bool h3dLoadResource( ResHandle res, const char *data, int size )
 }
 
 
+H3D_IMPL int h3dReloadResource( ResHandle res, const char *data, int size )
+{
+	Resource *resObj = Modules::resMan().resolveResHandle( res );
+	APIFUNC_VALIDATE_RES( resObj, "h3dReloadResource", -1 );
+
+	return resObj->reload( data, size );
+}
+
+
 H3D_IMPL void h3dUnloadResource( ResHandle res )
 {
 	Resource *resObj = Modules::resMan().resolveResHandle( res );
@@ -608,6 +640,118 @@ H3D_IMPL void h3dSetNodeTransMat( NodeHandle node, const float *mat4x4 )
 }
 
 
+H3D_IMPL int h3dGetNodeTransformBatch( const NodeHandle *nodes, int count, float *transforms )
+{
+	if( nodes == 0x0 || transforms == 0x0 || count < 0 )
+	{
+		Modules::setError( "Invalid pointer in h3dGetNodeTransformBatch" );
+		return 0;
+	}
+	
+	int numValid = 0;
+	Vec3f trans, rot, scale;
+	for( int i = 0; i < count; ++i )
+	{
+		float *dst = transforms + i * 9;
+		SceneNode *sn = resolveBatchNode( nodes[i], SceneNodeTypes::Undefined, "h3dGetNodeTransformBatch" );
+		if( sn == 0x0 )
+		{
+			memset( dst, 0, 9 * sizeof( float ) );
+			continue;
+		}
+
+		sn->getTransform( trans, rot, scale );
+		dst[0] = trans.x; dst[1] = trans.y; dst[2] = trans.z;
+		dst[3] = rot.x; dst[4] = rot.y; dst[5] = rot.z;
+		dst[6] = scale.x; dst[7] = scale.y; dst[8] = scale.z;
+		++numValid;
+	}
+
+	return numValid;
+}
+
+
+H3D_IMPL int h3dSetNodeTransformBatch( const NodeHandle *nodes, int count, const float *transforms )
+{
+	if( nodes == 0x0 || transforms == 0x0 || count < 0 )
+	{
+		Modules::setError( "Invalid pointer in h3dSetNodeTransformBatch" );
+		return 0;
+	}
+	
+	int numValid = 0;
+	for( int i = 0; i < count; ++i )
+	{
+		SceneNode *sn = resolveBatchNode( nodes[i], SceneNodeTypes::Undefined, "h3dSetNodeTransformBatch" );
+		if( sn == 0x0 ) continue;
+
+		const float *src = transforms + i * 9;
+		sn->setTransform( Vec3f( src[0], src[1], src[2] ), Vec3f( src[3], src[4], src[5] ),
+		                  Vec3f( src[6], src[7], src[8] ) );
+		++numValid;
+	}
+
+	return numValid;
+}
+
+
+H3D_IMPL int h3dGetNodeTransMatsBatch( const NodeHandle *nodes, int count, float *relMats, float *absMats )
+{
+	if( nodes == 0x0 || count < 0 )
+	{
+		Modules::setError( "Invalid pointer in h3dGetNodeTransMatsBatch" );
+		return 0;
+	}
+
+	// Bring all matrices up to date once instead of per node
+	Modules::sceneMan().updateNodes();
+	
+	int numValid = 0;
+	for( int i = 0; i < count; ++i )
+	{
+		SceneNode *sn = resolveBatchNode( nodes[i], SceneNodeTypes::Undefined, "h3dGetNodeTransMatsBatch" );
+		if( sn == 0x0 )
+		{
+			if( relMats != 0x0 ) memset( relMats + i * 16, 0, 16 * sizeof( float ) );
+			if( absMats != 0x0 ) memset( absMats + i * 16, 0, 16 * sizeof( float ) );
+			continue;
+		}
+		
+		const float *relMat, *absMat;
+		sn->getTransMatrices( relMats != 0x0 ? &relMat : 0x0, absMats != 0x0 ? &absMat : 0x0 );
+		if( relMats != 0x0 ) memcpy( relMats + i * 16, relMat, 16 * sizeof( float ) );
+		if( absMats != 0x0 ) memcpy( absMats + i * 16, absMat, 16 * sizeof( float ) );
+		++numValid;
+	}
+
+	return numValid;
+}
+
+
+H3D_IMPL int h3dSetNodeTransMatBatch( const NodeHandle *nodes, int count, const float *mats )
+{
+	if( nodes == 0x0 || mats == 0x0 || count < 0 )
+	{
+		Modules::setError( "Invalid pointer in h3dSetNodeTransMatBatch" );
+		return 0;
+	}
+
+	int numValid = 0;
+	Matrix4f mat;
+	for( int i = 0; i < count; ++i )
+	{
+		SceneNode *sn = resolveBatchNode( nodes[i], SceneNodeTypes::Undefined, "h3dSetNodeTransMatBatch" );
+		if( sn == 0x0 ) continue;
+
+		memcpy( mat.c, mats + i * 16, 16 * sizeof( float ) );
+		sn->setTransform( mat );
+		++numValid;
+	}
+
+	return numValid;
+}
+
+
 H3D_IMPL int h3dGetNodeParamI( NodeHandle node, int param )
 {
 	SceneNode *sn = Modules::sceneMan().resolveNodeHandle( node );
@@ -694,6 +838,37 @@ H3D_IMPL void h3dGetNodeAABB( NodeHandle node, float *minX, float *minY, float *
 }
 
 
+H3D_IMPL int h3dGetNodeAABBBatch( const NodeHandle *nodes, int count, float *aabbs )
+{
+	if( nodes == 0x0 || aabbs == 0x0 || count < 0 )
+	{
+		Modules::setError( "Invalid pointer in h3dGetNodeAABBBatch" );
+		return 0;
+	}
+	
+	Modules::sceneMan().updateNodes();
+
+	int numValid = 0;
+	for( int i = 0; i < count; ++i )
+	{
+		float *dst = aabbs + i * 6;
+		SceneNode *sn = resolveBatchNode( nodes[i], SceneNodeTypes::Undefined, "h3dGetNodeAABBBatch" );
+		if( sn == 0x0 )
+		{
+			memset( dst, 0, 6 * sizeof( float ) );
+			continue;
+		}
+
+		const BoundingBox &bBox = sn->getBBox();
+		dst[0] = bBox.min.x; dst[1] = bBox.min.y; dst[2] = bBox.min.z;
+		dst[3] = bBox.max.x; dst[4] = bBox.max.y; dst[5] = bBox.max.z;
+		++numValid;
+	}
+
+	return numValid;
+}
+
+
 H3D_IMPL int h3dFindNodes( NodeHandle startNode, const char *name, int type )
 {
 	SceneNode *sn = Modules::sceneMan().resolveNodeHandle( startNode );
@@ -762,6 +937,44 @@ H3D_IMPL int h3dCheckNodeVisibility( NodeHandle node, NodeHandle cameraNode, boo
 }
 
 
+H3D_IMPL int h3dCheckNodeVisibilityBatch( const NodeHandle *nodes, int count, NodeHandle cameraNode,
+                                          bool checkOcclusion, bool calcLod, int *results )
+{
+	SceneNode *cam = Modules::sceneMan().resolveNodeHandle( cameraNode );
+	APIFUNC_VALIDATE_NODE_TYPE( cam, SceneNodeTypes::Camera, "h3dCheckNodeVisibilityBatch", 0 );
+	if( nodes == 0x0 || results == 0x0 || count < 0 )
+	{
+		Modules::setError( "Invalid pointer in h3dCheckNodeVisibilityBatch" );
+		return 0;
+	}
+
+	// Local buffer keeps the function reentrant
+	vector< SceneNode * > sceneNodes( count );
+	for( int i = 0; i < count; ++i )
+		sceneNodes[i] = resolveBatchNode( nodes[i], SceneNodeTypes::Undefined, "h3dCheckNodeVisibilityBatch" );
+
+	return Modules::sceneMan().checkNodesVisibility( sceneNodes.data(), (uint32)count, *(CameraNode *)cam,
+	                                                 checkOcclusion, calcLod, results );
+}
+
+
+H3D_IMPL int h3dCheckAABBVisibilityBatch( const float *aabbs, int count, NodeHandle cameraNode, int *results )
+{
+	ASSERT_STATIC( sizeof( BoundingBox ) == 6 * sizeof( float ) );
+	
+	SceneNode *cam = Modules::sceneMan().resolveNodeHandle( cameraNode );
+	APIFUNC_VALIDATE_NODE_TYPE( cam, SceneNodeTypes::Camera, "h3dCheckAABBVisibilityBatch", 0 );
+	if( aabbs == 0x0 || results == 0x0 || count < 0 )
+	{
+		Modules::setError( "Invalid pointer in h3dCheckAABBVisibilityBatch" );
+		return 0;
+	}
+
+	return Modules::sceneMan().checkBoxesVisibility( (const BoundingBox *)aabbs, (uint32)count,
+	                                                 *(CameraNode *)cam, results );
+}
+
+
 H3D_IMPL NodeHandle h3dAddGroupNode( NodeHandle parent, const char *name )
 {
 	SceneNode *parentNode = Modules::sceneMan().resolveNodeHandle( parent );
@@ -823,6 +1036,28 @@ H3D_IMPL void h3dSetModelAnimParams( NodeHandle modelNode, int stage, float time
 }
 
 
+H3D_IMPL int h3dSetModelAnimParamsBatch( const NodeHandle *modelNodes, int count, const int *stages, const float *params )
+{
+	if( modelNodes == 0x0 || stages == 0x0 || params == 0x0 || count < 0 )
+	{
+		Modules::setError( "Invalid pointer in h3dSetModelAnimParamsBatch" );
+		return 0;
+	}
+	
+	int numValid = 0;
+	for( int i = 0; i < count; ++i )
+	{
+		SceneNode *sn = resolveBatchNode( modelNodes[i], SceneNodeTypes::Model, "h3dSetModelAnimParamsBatch" );
+		if( sn == 0x0 ) continue;
+
+		((ModelNode *)sn)->setAnimParams( stages[i], params[i * 2], params[i * 2 + 1] );
+		++numValid;
+	}
+
+	return numValid;
+}
+
+
 H3D_IMPL bool h3dSetModelMorpher( NodeHandle modelNode, const char *target, float weight )
 {
 	SceneNode *sn = Modules::sceneMan().resolveNodeHandle( modelNode );
@@ -13,6 +13,7 @@
 #include "egMaterial.h"
 #include "egTexture.h"
 #include "egModules.h"
+#include "egRenderer.h"
 #include "egCom.h"
 #include "utXML.h"
 #include <cstring>
@@ -38,7 +39,7 @@ void MaterialResource::releaseFunc()
 
 
 MaterialResource::MaterialResource( const string &name, int flags ) :
-	Resource( ResourceTypes::Material, name, flags )
+	Resource( ResourceTypes::Material, name, flags ), _texTableOffset( 0 ), _texTableSize( 0 )
 {
 	initDefault();	
 }
@@ -47,6 +48,7 @@ MaterialResource::MaterialResource( const string &name, int flags ) :
 MaterialResource::~MaterialResource()
 {
 	release();
+	Modules::renderer().releaseMaterialTexTable( this );
 }
 
 
@@ -55,6 +57,10 @@ Resource *MaterialResource::clone()
 	MaterialResource *res = new MaterialResource( "", _flags );
 
 	*res = *this;
+
+	// The clone may use other textures, so it gets its own entries in the texture table
+	res->_texTableSize = 0;
+	res->_texTableFrame = 0;
 	
 	return res;
 }
@@ -66,6 +72,7 @@ void MaterialResource::initDefault()
 	_combMask = 0;
 	_matLink = 0x0;
 	_classID = 0;
+	_texTableFrame = 0;
 }
 
 
@@ -250,6 +257,38 @@ bool MaterialResource::isOfClass( int theClassID ) const
 }
 
 
+bool MaterialResource::differsOnlyInTextures( const MaterialResource &other ) const
+{
+	if( _shaderRes.getPtr() != other._shaderRes.getPtr() || _combMask != other._combMask ||
+	    _matLink.getPtr() != other._matLink.getPtr() )
+		return false;
+
+	if( _samplers.size() != other._samplers.size() || _uniforms.size() != other._uniforms.size() ||
+	    _buffers.size() != other._buffers.size() )
+		return false;
+
+	for( size_t i = 0, s = _samplers.size(); i < s; ++i )
+	{
+		if( _samplers[i].name != other._samplers[i].name ) return false;
+	}
+
+	for( size_t i = 0, s = _uniforms.size(); i < s; ++i )
+	{
+		if( _uniforms[i].name != other._uniforms[i].name ||
+		    memcmp( _uniforms[i].values, other._uniforms[i].values, sizeof( _uniforms[i].values ) ) != 0 )
+			return false;
+	}
+
+	for( size_t i = 0, s = _buffers.size(); i < s; ++i )
+	{
+		if( _buffers[i].name != other._buffers[i].name || _buffers[i].compBufRes.getPtr() != other._buffers[i].compBufRes.getPtr() )
+			return false;
+	}
+
+	return true;
+}
+
+
 int MaterialResource::getElemCount( int elem ) const
 {
 	switch( elem )
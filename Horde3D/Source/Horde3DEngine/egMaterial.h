@@ -127,6 +127,7 @@ public:
 	bool load( const char *data, int size );
 	bool setUniform( const std::string &name, float a, float b, float c, float d );
 	bool isOfClass( int theClassID ) const;
+	bool differsOnlyInTextures( const MaterialResource &other ) const;
 
 	int getElemCount( int elem ) const;
 	int getElemParamI( int elem, int elemIdx, int param ) const;
@@ -150,6 +151,10 @@ private:
 	std::vector< std::string >  _shaderFlags;
 	PMaterialResource           _matLink;
 
+	uint32                      _texTableOffset;  // First entry of the material in the bindless texture table
+	uint32                      _texTableSize;
+	uint32                      _texTableFrame;  // Frame in which the entries were last validated
+
 	friend class ResourceManager;
 	friend class Renderer;
 	friend class MeshNode;
@@ -40,6 +40,7 @@ bool								Modules::_errorFlag = false;
 EngineConfig						*Modules::_engineConfig = 0x0;
 EngineLog							*Modules::_engineLog = 0x0;
 StatManager							*Modules::_statManager = 0x0;
+WorkerPool							*Modules::_workerPool = 0x0;
 SceneManager						*Modules::_sceneManager = 0x0;
 ResourceManager						*Modules::_resourceManager = 0x0;
 Renderer							*Modules::_renderer = 0x0;
@@ -58,6 +59,7 @@ bool Modules::init( int backendType )
 	if( _extensionManager == 0x0 ) _extensionManager = new ExtensionManager();
 	if( _engineLog == 0x0 ) _engineLog = new EngineLog();
 	if( _engineConfig == 0x0 ) _engineConfig = new EngineConfig();
+	if( _workerPool == 0x0 ) _workerPool = new WorkerPool();
 	if( _sceneManager == 0x0 ) _sceneManager = new SceneManager();
 	if( _resourceManager == 0x0 ) _resourceManager = new ResourceManager();
 	if( _renderer == 0x0 ) _renderer = new Renderer();
@@ -147,6 +149,16 @@ bool Modules::init( int backendType )
 	tex3DRes->unmapStream();
 	tex3DRes->addRef();
 	resMan().addNonExistingResource( *tex3DRes, false );
+
+	if( renderer().getRenderDevice()->getCaps().texArrays )
+	{
+		// Single layer array assembled from the default 2D texture
+		const char *tex2DArrayDesc = "<TextureArray><Layer map=\"$Tex2D\" /></TextureArray>";
+		TextureResource *tex2DArrayRes = new TextureResource( "$Tex2DArray", ResourceFlags::NoTexMipmaps );
+		tex2DArrayRes->load( tex2DArrayDesc, (int)strlen( tex2DArrayDesc ) );
+		tex2DArrayRes->addRef();
+		resMan().addNonExistingResource( *tex2DArrayRes, false );
+	}
 	
 	return true;
 }
@@ -164,6 +176,7 @@ void Modules::release()
 	delete _resourceManager; _resourceManager = 0x0;
 	delete _renderer; _renderer = 0x0;
 	delete _statManager; _statManager = 0x0;
+	delete _workerPool; _workerPool = 0x0;
 	delete _engineLog; _engineLog = 0x0;
 	delete _engineConfig; _engineConfig = 0x0;
 }
@@ -22,6 +22,7 @@ namespace Horde3D {
 class EngineConfig;
 class EngineLog;
 class StatManager;
+class WorkerPool;
 class SceneManager;
 class ResourceManager;
 class Renderer;
@@ -45,6 +46,7 @@ public:
 	static EngineConfig &config() { return *_engineConfig; }
 	static EngineLog &log() { return *_engineLog; }
 	static StatManager &stats() { return *_statManager; }
+	static WorkerPool &workers() { return *_workerPool; }
 	static SceneManager &sceneMan() { return *_sceneManager; }
 	static ResourceManager &resMan() { return *_resourceManager; }
 	static Renderer &renderer() { return *_renderer; }
@@ -62,6 +64,7 @@ private:
 	static EngineConfig						*_engineConfig;
 	static EngineLog						*_engineLog;
 	static StatManager						*_statManager;
+	static WorkerPool						*_workerPool;
 	static SceneManager						*_sceneManager;
 	static ResourceManager					*_resourceManager;
 	static Renderer							*_renderer;
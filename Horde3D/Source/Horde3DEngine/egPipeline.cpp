@@ -17,6 +17,7 @@
 #include "egRenderer.h"
 #include "utXML.h"
 #include <fstream>
+#include <algorithm>
 
 #include "utDebug.h"
 
@@ -45,6 +46,10 @@ PipelineResource::~PipelineResource()
 void PipelineResource::initDefault()
 {
 	_baseWidth = 320; _baseHeight = 240;
+	_renderGraph = false;
+	_dynamicResolution = false;
+	_dynResScale = 1.0f;
+	_dynResFrame = 0;
 }
 
 
@@ -72,6 +77,34 @@ bool PipelineResource::raiseError( const string &msg, int line )
 }
 
 
+static int addBufferParams( const char *list, vector< PipeCmdParam > &params )
+{
+	// Comma separated list of compute buffer resources
+	int count = 0;
+	string names( list );
+	size_t pos = 0;
+	while( pos < names.length() )
+	{
+		size_t end = names.find( ',', pos );
+		if( end == string::npos ) end = names.length();
+
+		size_t first = names.find_first_not_of( " \t", pos );
+		size_t last = names.find_last_not_of( " \t", end - 1 );
+		if( first != string::npos && first < end )
+		{
+			uint32 bufRes = Modules::resMan().addResource(
+				ResourceTypes::ComputeBuffer, names.substr( first, last - first + 1 ), 0, false );
+			params.push_back( PipeCmdParam() );
+			params.back().setResource( Modules::resMan().resolveResHandle( bufRes ) );
+			++count;
+		}
+		pos = end + 1;
+	}
+
+	return count;
+}
+
+
 const string PipelineResource::parseStage( XMLNode &node, PipelineStage &stage )
 {
 	stage.id = node.getAttribute( "id", "" );
@@ -187,6 +220,35 @@ const string PipelineResource::parseStage( XMLNode &node, PipelineStage &stage )
 			params[1].setInt( MaterialClassCollection::addClass( node1.getAttribute( "class", "" ) ) );
 			params[2].setInt( order );
 		}
+		else if( strcmp( node1.getName(), "DrawOffscreenParticles" ) == 0 )
+		{
+			if( !node1.getAttribute( "context" ) ) return "Missing DrawOffscreenParticles attribute 'context'";
+			if( !node1.getAttribute( "material" ) ) return "Missing DrawOffscreenParticles attribute 'material'";
+			if( !node1.getAttribute( "depthRT" ) ) return "Missing DrawOffscreenParticles attribute 'depthRT'";
+			
+			void *renderTarget = findRenderTarget( node1.getAttribute( "depthRT" ) );
+			if( !renderTarget || !((RenderTarget *)renderTarget)->hasDepthBuf )
+				return "Reference to undefined render target or target without depth buffer in DrawOffscreenParticles";
+
+			const char *orderStr = node1.getAttribute( "order", "" );
+			int order = RenderingOrder::StateChanges;
+			if( _stricmp( orderStr, "FRONT_TO_BACK" ) == 0 ) order = RenderingOrder::FrontToBack;
+			else if( _stricmp( orderStr, "BACK_TO_FRONT" ) == 0 ) order = RenderingOrder::BackToFront;
+			else if( _stricmp( orderStr, "NONE" ) == 0 ) order = RenderingOrder::None;
+			
+			uint32 matRes = Modules::resMan().addResource(
+				ResourceTypes::Material, node1.getAttribute( "material" ), 0, false );
+			
+			stage.commands.push_back( PipelineCommand( DefaultPipelineCommands::DrawOffscreenParticles ) );
+			vector< PipeCmdParam > &params = stage.commands.back().params;
+			params.resize( 6 );
+			params[0].setString( node1.getAttribute( "context" ) );
+			params[1].setInt( MaterialClassCollection::addClass( node1.getAttribute( "class", "" ) ) );
+			params[2].setInt( order );
+			params[3].setFloat( clamp( toFloat( node1.getAttribute( "scale", "0.5" ) ), 0.125f, 1.0f ) );
+			params[4].setResource( Modules::resMan().resolveResHandle( matRes ) );
+			params[5].setPtr( renderTarget );
+		}
 		else if( strcmp( node1.getName(), "DrawQuad" ) == 0 )
 		{
 			if( !node1.getAttribute( "material" ) ) return "Missing DrawQuad attribute 'material'";
@@ -221,30 +283,67 @@ const string PipelineResource::parseStage( XMLNode &node, PipelineStage &stage )
 		{
 			stage.commands.push_back( PipelineCommand( DefaultPipelineCommands::DoDeferredLightLoop ) );
 			vector< PipeCmdParam > &params = stage.commands.back().params;
-			params.resize( 2 );
+			params.resize( 4 );
 			params[0].setString( node1.getAttribute( "context", "" ) );
 			params[1].setBool( _stricmp( node1.getAttribute( "noShadows", "false" ), "true" ) == 0 );
+			params[2].setBool( _stricmp( node1.getAttribute( "depthBounds", "false" ), "true" ) == 0 );
+			params[3].setInt( atoi( node1.getAttribute( "tileSize", "0" ) ) );
+		}
+		else if( strcmp( node1.getName(), "DoOcclusionCulling" ) == 0 )
+		{
+			if( !node1.getAttribute( "material" ) ) return "Missing DoOcclusionCulling attribute 'material'";
+			if( !node1.getAttribute( "depthRT" ) ) return "Missing DoOcclusionCulling attribute 'depthRT'";
+
+			void *renderTarget = findRenderTarget( node1.getAttribute( "depthRT" ) );
+			if( !renderTarget || !((RenderTarget *)renderTarget)->hasDepthBuf )
+				return "Reference to undefined render target or target without depth buffer in DoOcclusionCulling";
+
+			uint32 matRes = Modules::resMan().addResource(
+				ResourceTypes::Material, node1.getAttribute( "material" ), 0, false );
+
+			stage.commands.push_back( PipelineCommand( DefaultPipelineCommands::DoOcclusionCulling ) );
+			vector< PipeCmdParam > &params = stage.commands.back().params;
+			params.resize( 2 );
+			params[0].setResource( Modules::resMan().resolveResHandle( matRes ) );
+			params[1].setPtr( renderTarget );
+		}
+		else if( strcmp( node1.getName(), "DispatchCompute" ) == 0 )
+		{
+			if( !node1.getAttribute( "material" ) ) return "Missing DispatchCompute attribute 'material'";
+			if( !node1.getAttribute( "context" ) ) return "Missing DispatchCompute attribute 'context'";
+			if( !node1.getAttribute( "indirectBuffer" ) && !node1.getAttribute( "x" ) )
+				return "Missing DispatchCompute attribute 'x' or 'indirectBuffer'";
+
+			uint32 matRes = Modules::resMan().addResource(
+				ResourceTypes::Material, node1.getAttribute( "material" ), 0, false );
+
+			stage.commands.push_back( PipelineCommand( DefaultPipelineCommands::DispatchCompute ) );
+			vector< PipeCmdParam > &params = stage.commands.back().params;
+			params.resize( 9 );
+			params[0].setResource( Modules::resMan().resolveResHandle( matRes ) );
+			params[1].setString( node1.getAttribute( "context" ) );
+			params[2].setInt( atoi( node1.getAttribute( "x", "1" ) ) );
+			params[3].setInt( atoi( node1.getAttribute( "y", "1" ) ) );
+			params[4].setInt( atoi( node1.getAttribute( "z", "1" ) ) );
+			if( node1.getAttribute( "indirectBuffer" ) )
+			{
+				uint32 bufRes = Modules::resMan().addResource(
+					ResourceTypes::ComputeBuffer, node1.getAttribute( "indirectBuffer" ), 0, false );
+				params[5].setResource( Modules::resMan().resolveResHandle( bufRes ) );
+			}
+			params[6].setInt( atoi( node1.getAttribute( "indirectOffset", "0" ) ) );
+
+			// Declared buffer accesses follow the fixed parameters, without declarations all buffers
+			// of the material are assumed to be read and written
+			int numReads = -1, numWrites = -1;
+			if( node1.getAttribute( "read" ) || node1.getAttribute( "write" ) )
+			{
+				numReads = addBufferParams( node1.getAttribute( "read", "" ), params );
+				numWrites = addBufferParams( node1.getAttribute( "write", "" ), params );
+			}
+			params[7].setInt( numReads );
+			params[8].setInt( numWrites );
 		}
-// 		else if ( strcmp( node1.getName(), "DispatchComputeShader" ) == 0 )
-// 		{
-// 			if ( !node1.getAttribute( "material" ) ) return "Missing DispatchComputeShader attribute 'material'";
-// 			if ( !node1.getAttribute( "context" ) ) return "Missing DispatchComputeShader attribute 'context'";
-// 			if ( !node1.getAttribute( "x" ) ) return "Missing DispatchComputeShader attribute 'x'";
-// 			if ( !node1.getAttribute( "y" ) ) return "Missing DispatchComputeShader attribute 'y'";
-// 			if ( !node1.getAttribute( "z" ) ) return "Missing DispatchComputeShader attribute 'z'";
-// 
-// 			uint32 matRes = Modules::resMan().addResource(
-// 				ResourceTypes::Material, node1.getAttribute( "material" ), 0, false );
-// 
-// 			stage.commands.push_back( PipelineCommand( PipelineCommands::DispatchComputeShader ) );
-// 			vector< PipeCmdParam > &params = stage.commands.back().params;
-// 			params.resize( 5 );
-// 			params[ 0 ].setResource( Modules::resMan().resolveResHandle( matRes ) );
-// 			params[ 1 ].setString( node1.getAttribute( "context", "" ) );
-// 			params[ 2 ].setInt( atoi( node1.getAttribute( "x", "0" ) ) );
-// 			params[ 3 ].setInt( atoi( node1.getAttribute( "y", "0" ) ) );
-// 			params[ 4 ].setInt( atoi( node1.getAttribute( "z", "0" ) ) );
-// 		}
 		else if( strcmp( node1.getName(), "SetUniform" ) == 0 )
 		{
 			if( !node1.getAttribute( "material" ) ) return "Missing SetUniform attribute 'material'";
@@ -292,7 +391,7 @@ const string PipelineResource::parseStage( XMLNode &node, PipelineStage &stage )
 
 void PipelineResource::addRenderTarget( const string &id, bool depthBuf, uint32 numColBufs,
 										TextureFormats::List format, uint32 samples,
-										uint32 width, uint32 height, float scale )
+										uint32 width, uint32 height, float scale, bool persistent )
 {
 	RenderTarget rt;
 	
@@ -304,6 +403,7 @@ void PipelineResource::addRenderTarget( const string &id, bool depthBuf, uint32
 	rt.width = width;
 	rt.height = height;
 	rt.scale = scale;
+	rt.persistent = persistent;
 
 	_renderTargets.push_back( rt );
 }
@@ -325,22 +425,246 @@ RenderTarget *PipelineResource::findRenderTarget( const string &id ) const
 }
 
 
+void PipelineResource::getRenderTargetSize( const RenderTarget &rt, uint32 &width, uint32 &height ) const
+{
+	width = ftoi_r( rt.width * rt.scale ), height = ftoi_r( rt.height * rt.scale );
+	if( width == 0 ) width = ftoi_r( _baseWidth * rt.scale );
+	if( height == 0 ) height = ftoi_r( _baseHeight * rt.scale );
+}
+
+
+uint32 PipelineResource::calcRenderTargetMemory( const RenderTarget &rt ) const
+{
+	RenderDeviceInterface *rdi = Modules::renderer().getRenderDevice();
+	
+	uint32 width, height;
+	getRenderTargetSize( rt, width, height );
+
+	// Multisampled buffers are resolved into textures of the same size
+	uint32 size = rdi->calcTextureSize( rt.format, width, height, 1 ) * rt.numColBufs;
+	if( rt.hasDepthBuf ) size += width * height * 4;
+	if( rt.samples > 0 ) size *= rt.samples + 1;
+
+	return size;
+}
+
+
+// Index of the render target sampled by a command or -1
+static int getSampledTarget( const PipelineCommand &pc, const RenderTarget *firstTarget )
+{
+	void *rt = 0x0;
+	if( pc.command == DefaultPipelineCommands::BindBuffer ) rt = pc.params[0].getPtr();
+	else if( pc.command == DefaultPipelineCommands::DrawOffscreenParticles ) rt = pc.params[5].getPtr();
+	else if( pc.command == DefaultPipelineCommands::DoOcclusionCulling ) rt = pc.params[1].getPtr();
+
+	return rt != 0x0 ? (int)((RenderTarget *)rt - firstTarget) : -1;
+}
+
+
+void PipelineResource::compileRenderGraph()
+{
+	for( size_t i = 0; i < _stages.size(); ++i )
+		_stages[i].culled = false;
+	for( size_t i = 0; i < _renderTargets.size(); ++i )
+	{
+		_renderTargets[i].culled = false;
+		_renderTargets[i].aliasOf = -1;
+	}
+	
+	if( !_renderGraph || _renderTargets.empty() ) return;
+
+	const int numTargets = (int)_renderTargets.size();
+	RenderTarget *firstTarget = &_renderTargets[0];
+	
+	// Targets sampled before being rendered to in a frame carry data over from the last frame;
+	// -1 is the output buffer of the camera which is always live
+	vector< bool > live( numTargets, false ), written( numTargets, false );
+	vector< int > stageStartTarget( _stages.size(), -1 );
+	int curTarget = -1;
+	
+	for( size_t i = 0; i < _stages.size(); ++i )
+	{
+		if( !_stages[i].enabled ) continue;
+		stageStartTarget[i] = curTarget;
+		
+		for( size_t j = 0; j < _stages[i].commands.size(); ++j )
+		{
+			const PipelineCommand &pc = _stages[i].commands[j];
+			
+			if( pc.command == DefaultPipelineCommands::SwitchTarget )
+			{
+				curTarget = pc.params[0].getPtr() != 0x0 ? (int)((RenderTarget *)pc.params[0].getPtr() - firstTarget) : -1;
+				if( curTarget >= 0 ) written[curTarget] = true;
+			}
+			else
+			{
+				int sampled = getSampledTarget( pc, firstTarget );
+				if( sampled >= 0 && !written[sampled] ) live[sampled] = true;
+			}
+		}
+	}
+
+	for( int i = 0; i < numTargets; ++i )
+	{
+		if( _renderTargets[i].persistent ) live[i] = true;
+	}
+	vector< bool > feedback( live );
+
+	// Walk stages backwards and cull those that neither have side effects nor
+	// write to a target that is read later on
+	int numCulledStages = 0;
+	for( int i = (int)_stages.size() - 1; i >= 0; --i )
+	{
+		PipelineStage &stage = _stages[i];
+		if( !stage.enabled ) continue;
+		
+		bool needed = false;
+		curTarget = stageStartTarget[i];
+		for( size_t j = 0; j < stage.commands.size() && !needed; ++j )
+		{
+			const PipelineCommand &pc = stage.commands[j];
+			switch( pc.command )
+			{
+			case DefaultPipelineCommands::SwitchTarget:
+				curTarget = pc.params[0].getPtr() != 0x0 ? (int)((RenderTarget *)pc.params[0].getPtr() - firstTarget) : -1;
+				needed = curTarget < 0 || live[curTarget];
+				break;
+			case DefaultPipelineCommands::BindBuffer:
+			case DefaultPipelineCommands::UnbindBuffers:
+				break;
+			case DefaultPipelineCommands::SetUniform:
+			case DefaultPipelineCommands::DispatchCompute:
+			case DefaultPipelineCommands::DoOcclusionCulling:
+			case DefaultPipelineCommands::ExternalCommand:
+				needed = true;
+				break;
+			default:
+				needed = curTarget < 0 || live[curTarget];
+				break;
+			}
+		}
+
+		if( !needed )
+		{
+			stage.culled = true;
+			++numCulledStages;
+			continue;
+		}
+
+		for( size_t j = 0; j < stage.commands.size(); ++j )
+		{
+			int sampled = getSampledTarget( stage.commands[j], firstTarget );
+			if( sampled >= 0 ) live[sampled] = true;
+		}
+	}
+
+	// Derive lifetimes of targets from the remaining commands
+	vector< int > firstUse( numTargets, -1 ), lastUse( numTargets, -1 );
+	int cmdIndex = 0;
+	for( size_t i = 0; i < _stages.size(); ++i )
+	{
+		const PipelineStage &stage = _stages[i];
+		if( !stage.enabled || stage.culled ) continue;
+
+		curTarget = stageStartTarget[i];
+		for( size_t j = 0; j < stage.commands.size(); ++j, ++cmdIndex )
+		{
+			const PipelineCommand &pc = stage.commands[j];
+			int uses[2] = { -1, getSampledTarget( pc, firstTarget ) };
+			if( pc.command == DefaultPipelineCommands::SwitchTarget )
+			{
+				curTarget = pc.params[0].getPtr() != 0x0 ? (int)((RenderTarget *)pc.params[0].getPtr() - firstTarget) : -1;
+				uses[0] = curTarget;
+			}
+			else if( pc.command != DefaultPipelineCommands::BindBuffer &&
+			         pc.command != DefaultPipelineCommands::UnbindBuffers &&
+			         pc.command != DefaultPipelineCommands::SetUniform )
+			{
+				// Drawing commands render to the current target
+				uses[0] = curTarget;
+			}
+
+			for( int k = 0; k < 2; ++k )
+			{
+				if( uses[k] < 0 ) continue;
+				if( firstUse[uses[k]] < 0 ) firstUse[uses[k]] = cmdIndex;
+				lastUse[uses[k]] = cmdIndex;
+			}
+		}
+	}
+
+	// Assign render buffers to targets in order of first use, reusing the buffer of a target with
+	// identical layout whose lifetime has already ended
+	vector< int > order;
+	for( int i = 0; i < numTargets; ++i )
+	{
+		if( firstUse[i] < 0 && !_renderTargets[i].persistent ) _renderTargets[i].culled = true;
+		else if( !feedback[i] ) order.push_back( i );
+	}
+	std::sort( order.begin(), order.end(), [&firstUse]( int a, int b ) { return firstUse[a] < firstUse[b]; } );
+
+	vector< int > owners;
+	for( size_t i = 0; i < order.size(); ++i )
+	{
+		RenderTarget &rt = _renderTargets[order[i]];
+		uint32 width, height;
+		getRenderTargetSize( rt, width, height );
+
+		for( size_t j = 0; j < owners.size(); ++j )
+		{
+			RenderTarget &owner = _renderTargets[owners[j]];
+			uint32 ownerWidth, ownerHeight;
+			getRenderTargetSize( owner, ownerWidth, ownerHeight );
+
+			if( lastUse[owners[j]] < firstUse[order[i]] && width == ownerWidth && height == ownerHeight &&
+			    rt.format == owner.format && rt.numColBufs == owner.numColBufs &&
+			    rt.hasDepthBuf == owner.hasDepthBuf && rt.samples == owner.samples )
+			{
+				rt.aliasOf = owners[j];
+				lastUse[owners[j]] = lastUse[order[i]];
+				break;
+			}
+		}
+		if( rt.aliasOf < 0 ) owners.push_back( order[i] );
+	}
+
+	uint32 memDeclared = 0, memAllocated = 0;
+	for( int i = 0; i < numTargets; ++i )
+	{
+		const RenderTarget &rt = _renderTargets[i];
+		memDeclared += calcRenderTargetMemory( rt );
+		if( !rt.culled && rt.aliasOf < 0 ) memAllocated += calcRenderTargetMemory( rt );
+	}
+
+	Modules::log().writeInfo( "Pipeline resource '%s': render graph culled %i stages, render target memory %.2f MB -> %.2f MB",
+		_name.c_str(), numCulledStages, memDeclared / (1024.0f * 1024.0f), memAllocated / (1024.0f * 1024.0f) );
+}
+
+
 bool PipelineResource::createRenderTargets()
 {
 	RenderDeviceInterface *rdi = Modules::renderer().getRenderDevice();
 
+	compileRenderGraph();
+
 	for( uint32 i = 0; i < _renderTargets.size(); ++i )
 	{
 		RenderTarget &rt = _renderTargets[i];
+		if( rt.culled || rt.aliasOf >= 0 ) continue;
 	
-		uint32 width = ftoi_r( rt.width * rt.scale ), height = ftoi_r( rt.height * rt.scale );
-		if( width == 0 ) width = ftoi_r( _baseWidth * rt.scale );
-		if( height == 0 ) height = ftoi_r( _baseHeight * rt.scale );
+		uint32 width, height;
+		getRenderTargetSize( rt, width, height );
 		
 		rt.rendBuf = rdi->createRenderBuffer(
 			width, height, rt.format, rt.hasDepthBuf, rt.numColBufs, rt.samples, 0 );
 		if( rt.rendBuf == 0 ) return false;
 	}
+
+	for( uint32 i = 0; i < _renderTargets.size(); ++i )
+	{
+		RenderTarget &rt = _renderTargets[i];
+		if( rt.aliasOf >= 0 ) rt.rendBuf = _renderTargets[rt.aliasOf].rendBuf;
+	}
 	
 	return true;
 }
@@ -353,9 +677,12 @@ void PipelineResource::releaseRenderTargets()
 	for( uint32 i = 0; i < _renderTargets.size(); ++i )
 	{
 		RenderTarget &rt = _renderTargets[i];
-		if( rt.rendBuf )
+		if( rt.rendBuf && rt.aliasOf < 0 )
 			rdi->destroyRenderBuffer( rt.rendBuf );
 	}
+
+	for( uint32 i = 0; i < _renderTargets.size(); ++i )
+		_renderTargets[i].rendBuf = 0;
 }
 
 
@@ -376,6 +703,11 @@ bool PipelineResource::load( const char *data, int size )
 	XMLNode node1 = rootNode.getFirstChild( "Setup" );
 	if( !node1.isEmpty() )
 	{
+		_renderGraph = _stricmp( node1.getAttribute( "renderGraph", "false" ), "true" ) == 0 ||
+		               _stricmp( node1.getAttribute( "renderGraph", "0" ), "1" ) == 0;
+		_dynamicResolution = _stricmp( node1.getAttribute( "dynamicResolution", "false" ), "true" ) == 0 ||
+		                     _stricmp( node1.getAttribute( "dynamicResolution", "0" ), "1" ) == 0;
+		
 		XMLNode node2 = node1.getFirstChild( "RenderTarget" );
 		while( !node2.isEmpty() )
 		{
@@ -406,9 +738,10 @@ bool PipelineResource::load( const char *data, int size )
 			uint32 width = atoi( node2.getAttribute( "width", "0" ) );
 			uint32 height = atoi( node2.getAttribute( "height", "0" ) );
 			float scale = toFloat( node2.getAttribute( "scale", "1" ) );
+			bool persistent = _stricmp( node2.getAttribute( "persistent", "false" ), "true" ) == 0;
 
 			addRenderTarget( id, depth, numBuffers, format,
-				std::min( maxSamples, Modules::config().sampleCount ), width, height, scale );
+				std::min( maxSamples, Modules::config().sampleCount ), width, height, scale, persistent );
 
 			node2 = node2.getNextSibling( "RenderTarget" );
 		}
@@ -494,7 +827,17 @@ void PipelineResource::setElemParamI( int elem, int elemIdx, int param, int valu
 			switch( param )
 			{
 			case PipelineResData::StageActivationI:
-				_stages[elemIdx].enabled = (value == 0) ? 0 : 1;
+				if( _stages[elemIdx].enabled != (value != 0) )
+				{
+					_stages[elemIdx].enabled = value != 0;
+					
+					// Stage toggles change target lifetimes
+					if( _renderGraph )
+					{
+						releaseRenderTargets();
+						createRenderTargets();
+					}
+				}
 				return;
 			}
 		}
@@ -532,7 +875,7 @@ bool PipelineResource::getRenderTargetData( const string &target, int bufIndex,
 	if( target != "" )
 	{	
 		RenderTarget *rt = findRenderTarget( target );
-		if( rt == 0x0 ) return false;
+		if( rt == 0x0 || rt->rendBuf == 0 ) return false;
 		else rbObj = rt->rendBuf;
 	}
 	
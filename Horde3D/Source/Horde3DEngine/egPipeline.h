@@ -55,6 +55,9 @@ struct DefaultPipelineCommands
 		DoForwardLightLoop,
 		DoDeferredLightLoop,
 		SetUniform,
+		DrawOffscreenParticles,
+		DispatchCompute,
+		DoOcclusionCulling,
 		ExternalCommand = 256 // must be the last command
 	};
 };
@@ -129,8 +132,9 @@ struct PipelineStage
 	PMaterialResource               matLink;
 	std::vector< PipelineCommand >  commands;
 	bool                            enabled;
+	bool                            culled;  // Set by render graph when no output of the stage is used
 
-	PipelineStage() : matLink( 0x0 ), enabled( false ) {}
+	PipelineStage() : matLink( 0x0 ), enabled( false ), culled( false ) {}
 };
 
 
@@ -143,11 +147,17 @@ struct RenderTarget
 	uint32                samples;
 	float                 scale;  // Scale factor for FB width and height
 	bool                  hasDepthBuf;
+	bool                  persistent;  // Contents are used outside of the frame, never aliased or culled
+	bool                  culled;      // Not used by any active stage, no render buffer allocated
+	int                   aliasOf;     // Index of target owning the shared render buffer or -1
 	uint32                rendBuf;
 
 	RenderTarget()
 	{
 		hasDepthBuf = false;
+		persistent = false;
+		culled = false;
+		aliasOf = -1;
 		numColBufs = 0;
 		rendBuf = 0;
 		width = height = 0;
@@ -214,14 +224,20 @@ public:
 	bool getRenderTargetData( const std::string &target, int bufIndex, int *width, int *height,
 	                          int *compCount, void *dataBuffer, int bufferSize ) const;
 
+	const std::vector< PipelineStage > &getStages() const { return _stages; }
+	const std::vector< RenderTarget > &getRenderTargets() const { return _renderTargets; }
+
 private:
 	bool raiseError( const std::string &msg, int line = -1 );
 	const std::string parseStage( XMLNode &node, PipelineStage &stage );
 
 	void addRenderTarget( const std::string &id, bool depthBuffer, uint32 numBuffers,
 	                      TextureFormats::List format, uint32 samples,
-	                      uint32 width, uint32 height, float scale );
+	                      uint32 width, uint32 height, float scale, bool persistent );
 	RenderTarget *findRenderTarget( const std::string &id ) const;
+	void getRenderTargetSize( const RenderTarget &rt, uint32 &width, uint32 &height ) const;
+	uint32 calcRenderTargetMemory( const RenderTarget &rt ) const;
+	void compileRenderGraph();
 	bool createRenderTargets();
 	void releaseRenderTargets();
 
@@ -229,6 +245,10 @@ private:
 	std::vector< RenderTarget >   _renderTargets;
 	std::vector< PipelineStage >  _stages;
 	uint32                        _baseWidth, _baseHeight;
+	bool                          _renderGraph;  // Cull unused stages and alias render target memory
+	bool                          _dynamicResolution;  // Render to a scaled viewport of the targets
+	float                         _dynResScale;
+	uint32                        _dynResFrame;
 
 	friend class ResourceManager;
 	friend class Renderer;
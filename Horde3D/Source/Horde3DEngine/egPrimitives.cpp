@@ -64,6 +64,10 @@ void Frustum::buildViewFrustum( const Matrix4f &transMat, float left, float righ
 	_planes[3] = Plane( _origin, _corners[2], _corners[3] );		// Top
 	_planes[4] = Plane( _corners[0], _corners[1], _corners[2] );	// Near
 	_planes[5] = Plane( _corners[5], _corners[4], _corners[7] );	// Far
+
+#ifdef H3D_MATH_SIMD
+	updateCullPlanes();
+#endif
 }
 
 
@@ -108,6 +112,10 @@ void Frustum::buildViewFrustum( const Matrix4f &viewMat, const Matrix4f &projMat
 	_corners[6] = Vec3f( corner.x / corner.w, corner.y / corner.w, corner.z / corner.w );
 	corner = mm * Vec4f( -1, 1, 1, 1 );
 	_corners[7] = Vec3f( corner.x / corner.w, corner.y / corner.w, corner.z / corner.w );
+
+#ifdef H3D_MATH_SIMD
+	updateCullPlanes();
+#endif
 }
 
 
@@ -138,9 +146,31 @@ void Frustum::buildBoxFrustum( const Matrix4f &transMat, float left, float right
 	_planes[3] = Plane( _corners[3], _corners[2], _corners[6] );	// Top
 	_planes[4] = Plane( _corners[0], _corners[1], _corners[2] );	// Front
 	_planes[5] = Plane( _corners[4], _corners[7], _corners[6] );	// Back
+
+#ifdef H3D_MATH_SIMD
+	updateCullPlanes();
+#endif
 }
 
 
+#ifdef H3D_MATH_SIMD
+void Frustum::updateCullPlanes()
+{
+	// Unused slots are filled with planes that never cull
+	for( uint32 i = 0; i < 8; ++i )
+	{
+		Vec3f normal = i < 6 ? _planes[i].normal : Vec3f( 0, 0, 0 );
+		float dist = i < 6 ? _planes[i].dist : -Math::MaxFloat;
+		
+		_cullPlanes[i / 4][0][i % 4] = normal.x;
+		_cullPlanes[i / 4][1][i % 4] = normal.y;
+		_cullPlanes[i / 4][2][i % 4] = normal.z;
+		_cullPlanes[i / 4][3][i % 4] = dist;
+	}
+}
+#endif
+
+
 bool Frustum::cullSphere( Vec3f pos, float rad ) const
 {
 	// Check the distance of the center to the planes
@@ -153,9 +183,29 @@ bool Frustum::cullSphere( Vec3f pos, float rad ) const
 }
 
 
-bool Frustum::cullBox( BoundingBox &b ) const
+bool Frustum::cullBox( const BoundingBox &b ) const
 {
 	// Idea for optimized AABB testing from www.lighthouse3d.com
+#ifdef H3D_MATH_SIMD
+	using namespace Simd;
+	Vec minX = splat( b.min.x ), minY = splat( b.min.y ), minZ = splat( b.min.z );
+	Vec maxX = splat( b.max.x ), maxY = splat( b.max.y ), maxZ = splat( b.max.z );
+	
+	for( uint32 i = 0; i < 2; ++i )
+	{
+		// Test four planes at once
+		Vec nx = load( &_cullPlanes[i][0].x ), ny = load( &_cullPlanes[i][1].x ), nz = load( &_cullPlanes[i][2].x );
+		
+		Vec px = select( cmpLE( nx, zero() ), maxX, minX );
+		Vec py = select( cmpLE( ny, zero() ), maxY, minY );
+		Vec pz = select( cmpLE( nz, zero() ), maxZ, minZ );
+
+		Vec dist = add( add( add( mul( nx, px ), mul( ny, py ) ), mul( nz, pz ) ), load( &_cullPlanes[i][3].x ) );
+		if( anyTrue( cmpGT( dist, zero() ) ) ) return true;
+	}
+
+	return false;
+#else
 	for( uint32 i = 0; i < 6; ++i )
 	{
 		const Vec3f &n = _planes[i].normal;
@@ -169,6 +219,44 @@ bool Frustum::cullBox( BoundingBox &b ) const
 	}
 	
 	return false;
+#endif
+}
+
+
+void Frustum::cullBoxes( const BoundingBox *boxes, uint32 count, bool *culled ) const
+{
+	uint32 i = 0;
+	
+#ifdef H3D_MATH_SIMD
+	// Test four boxes at once against one plane after the other, the tested box vertex is the
+	// same for all lanes since it only depends on the plane normal
+	using namespace Simd;
+	for( ; i + 4 <= count; i += 4 )
+	{
+		const BoundingBox *b = boxes + i;
+		Vec minX = set( b[0].min.x, b[1].min.x, b[2].min.x, b[3].min.x );
+		Vec minY = set( b[0].min.y, b[1].min.y, b[2].min.y, b[3].min.y );
+		Vec minZ = set( b[0].min.z, b[1].min.z, b[2].min.z, b[3].min.z );
+		Vec maxX = set( b[0].max.x, b[1].max.x, b[2].max.x, b[3].max.x );
+		Vec maxY = set( b[0].max.y, b[1].max.y, b[2].max.y, b[3].max.y );
+		Vec maxZ = set( b[0].max.z, b[1].max.z, b[2].max.z, b[3].max.z );
+		
+		Vec outside = zero();
+		for( uint32 j = 0; j < 6; ++j )
+		{
+			const Vec3f &n = _planes[j].normal;
+			Vec dist = add( add( add( mul( splat( n.x ), n.x <= 0 ? maxX : minX ),
+			                          mul( splat( n.y ), n.y <= 0 ? maxY : minY ) ),
+			                     mul( splat( n.z ), n.z <= 0 ? maxZ : minZ ) ), splat( _planes[j].dist ) );
+			outside = orMask( outside, cmpGT( dist, zero() ) );
+		}
+
+		int mask = moveMask( outside );
+		for( uint32 j = 0; j < 4; ++j ) culled[i + j] = (mask & (1 << j)) != 0;
+	}
+#endif
+
+	for( ; i < count; ++i ) culled[i] = cullBox( boxes[i] );
 }
 
 
@@ -130,15 +130,24 @@ public:
 	void buildBoxFrustum( const Matrix4f &transMat, float left, float right,
 	                      float bottom, float top, float front, float back );
 	bool cullSphere( Vec3f pos, float rad ) const;
-	bool cullBox( BoundingBox &b ) const;
+	bool cullBox( const BoundingBox &b ) const;
+	void cullBoxes( const BoundingBox *boxes, uint32 count, bool *culled ) const;
 	bool cullFrustum( const Frustum &frust ) const;
 
 	void calcAABB( Vec3f &mins, Vec3f &maxs ) const;
 
+private:
+#ifdef H3D_MATH_SIMD
+	void updateCullPlanes();
+#endif
+
 private:
 	Plane  _planes[6];  // Planes of frustum
 	Vec3f  _origin;
 	Vec3f  _corners[8];  // Corner points
+#ifdef H3D_MATH_SIMD
+	Vec4f  _cullPlanes[2][4];  // Planes as normal x, y, z and distance of four planes each
+#endif
 };
 
 }
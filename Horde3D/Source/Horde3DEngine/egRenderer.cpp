@@ -31,6 +31,7 @@
 #else
 #	include "egRendererBaseGLES3.h"
 #endif
+#include "egRendererBaseNull.h"
 
 // Constants
 constexpr int defaultCameraView = 0;
@@ -52,19 +53,37 @@ Renderer::Renderer()
 	_curShader = 0x0;
 	_curRenderTarget = 0x0;
 	_curShaderUpdateStamp = 1;
+	_viewportScale = 1.0f;
 	_curStageMatLink = 0;
 	_maxAnisoMask = 0;
 	_smSize = 0;
+	for( uint32 i = 0; i < 16; ++i ) _cascadeRegions[i] = 0;
 	_shadowRB = 0;
+	_shadowAtlasRB = 0;
+	_shadowAtlasValid = false;
 	_vlPosOnly = 0;
 	_vlModel = 0;
 	_vlParticle = 0;
+	_vlLightVolume = 0;
 
 	_particleGeo = 0;
 	_cubeGeo = 0;
 	_sphereGeo = 0;
 	_coneGeo = 0;
 	_FSPolyGeo = 0;
+	_sphereInstGeo = 0;
+	_coneInstGeo = 0;
+	_vbLightVolumeInst = 0;
+	_tileLightTex = 0;
+	_tileIndexTex = 0;
+	_tileIndexTexHeight = 0;
+	_offscreenParticleRB = 0;
+	_matTexBuf = 0;
+	_matTexBufCapacity = 0;
+	_matTexBufBound = false;
+	memset( _frameFences, 0, sizeof( _frameFences ) );
+	_offscreenParticleWidth = _offscreenParticleHeight = 0;
+	_offscreenParticlePass = false;
 
 	// reserve memory for occlusion culling proxies
 	_occProxies[ 0 ].reserve( 200 ); // meshes
@@ -81,6 +100,7 @@ Renderer::Renderer()
 
 	// Misc general uniforms
 	_uni.frameBufSize = registerEngineUniform( "frameBufSize" );
+	_uni.viewportScale = registerEngineUniform( "viewportScale" );
 
 	// View/projection uniforms
 	_uni.viewMat = registerEngineUniform( "viewMat" );
@@ -103,6 +123,9 @@ Renderer::Renderer()
 	_uni.lightColor = registerEngineUniform( "lightColor" );
 	_uni.shadowSplitDists = registerEngineUniform( "shadowSplitDists" );
 	_uni.shadowMats = registerEngineUniform( "shadowMats" );
+	_uni.shadowCascadeMats = registerEngineUniform( "shadowCascadeMats" );
+	_uni.shadowCascadeRegions = registerEngineUniform( "shadowCascadeRegions" );
+	_uni.shadowCascadeFirst = registerEngineUniform( "shadowCascadeFirst" );
 	_uni.shadowMapSize = registerEngineUniform( "shadowMapSize" );
 	_uni.shadowBias = registerEngineUniform( "shadowBias" );
 
@@ -111,6 +134,16 @@ Renderer::Renderer()
 	_uni.parSizeAndRotArray = registerEngineUniform( "parSizeAndRotArray" );
 	_uni.parColorArray = registerEngineUniform( "parColorArray" );
 
+	// Tiled deferred lighting uniforms
+	_uni.tileParams = registerEngineUniform( "tileParams" );
+
+	// GPU occlusion culling uniforms
+	_uni.occPyramidLevels = registerEngineUniform( "occPyramidLevels" );
+	_uni.occPyramidParams = registerEngineUniform( "occPyramidParams" );
+
+	// Bindless material texture uniforms
+	_uni.materialTexBase = registerEngineUniform( "materialTexBase" );
+
 	_renderDevice = 0x0;
 }
 
@@ -120,6 +153,7 @@ Renderer::~Renderer()
 	if ( _renderDevice )
 	{
 		releaseShadowRB();
+		releaseShadowAtlasRB();
 		_renderDevice->destroyTexture( _defShadowMap );
 		releaseShaderComb( _defColorShader );
 
@@ -128,6 +162,16 @@ Renderer::~Renderer()
 		_renderDevice->destroyGeometry( _sphereGeo );
 		_renderDevice->destroyGeometry( _coneGeo );
 		_renderDevice->destroyGeometry( _FSPolyGeo );
+		if( _sphereInstGeo ) _renderDevice->destroyGeometry( _sphereInstGeo );
+		if( _coneInstGeo ) _renderDevice->destroyGeometry( _coneInstGeo );
+		if( _tileLightTex ) _renderDevice->destroyTexture( _tileLightTex );
+		if( _tileIndexTex ) _renderDevice->destroyTexture( _tileIndexTex );
+		if( _offscreenParticleRB ) _renderDevice->destroyRenderBuffer( _offscreenParticleRB );
+		for( size_t i = 0; i < _occPyramids.size(); ++i )
+			releaseOcclusionPyramid( _occPyramids[i] );
+		if( _matTexBuf ) _renderDevice->destroyBuffer( _matTexBuf );
+		for( uint32 i = 0; i < FrameFenceSlots; ++i )
+			_renderDevice->destroyFence( _frameFences[i] );
 
 		releaseRenderDevice();
 	}
@@ -224,26 +268,38 @@ bool Renderer::init( RenderBackendType::List type )
 	
 	// Create vertex layouts
 	VertexLayoutAttrib attribsPosOnly[1] = {
-		{"vertPos", 0, 3, 0}
+		{"vertPos", 0, 3, 0, 0}
 	};
 	_vlPosOnly = _renderDevice->registerVertexLayout( 1, attribsPosOnly );
 
 	VertexLayoutAttrib attribsModel[7] = {
-		{"vertPos", 0, 3, 0},
-		{"normal", 1, 3, 0},
-		{"tangent", 2, 4, 0},
-		{"joints", 3, 4, 8},
-		{"weights", 3, 4, 24},
-		{"texCoords0", 3, 2, 0},
-		{"texCoords1", 3, 2, 40}
+		{"vertPos", 0, 3, 0, 0},
+		{"normal", 1, 3, 0, 0},
+		{"tangent", 2, 4, 0, 0},
+		{"joints", 3, 4, 8, 0},
+		{"weights", 3, 4, 24, 0},
+		{"texCoords0", 3, 2, 0, 0},
+		{"texCoords1", 3, 2, 40, 0}
 	};
 	_vlModel = _renderDevice->registerVertexLayout( 7, attribsModel );
 
 	VertexLayoutAttrib attribsParticle[2] = {
-		{"texCoords0", 0, 2, 0},
-		{"parIdx", 0, 1, 8}
+		{"texCoords0", 0, 2, 0, 0},
+		{"parIdx", 0, 1, 8, 0}
 	};
 	_vlParticle = _renderDevice->registerVertexLayout( 2, attribsParticle );
+
+	VertexLayoutAttrib attribsLightVolume[8] = {
+		{"vertPos", 0, 3, 0, 0},
+		{"instWorldMat0", 1, 4, 0, 1},
+		{"instWorldMat1", 1, 4, 16, 1},
+		{"instWorldMat2", 1, 4, 32, 1},
+		{"instWorldMat3", 1, 4, 48, 1},
+		{"instLightPos", 1, 4, 64, 1},
+		{"instLightDir", 1, 4, 80, 1},
+		{"instLightColor", 1, 4, 96, 1}
+	};
+	_vlLightVolume = _renderDevice->registerVertexLayout( 8, attribsLightVolume );
 	
 	// Upload default shaders
 	if ( !createShaderComb( _defColorShader, _renderDevice->getDefaultVSCode(), _renderDevice->getDefaultFSCode(), 0, 0, 0, 0 ) )
@@ -348,6 +404,10 @@ RenderDeviceInterface *Renderer::createRenderDevice( int type )
 			return new RDI_GLES3::RenderDeviceGLES3();
 		}
 #endif
+		case RenderBackendType::Null:
+		{
+			return new RDI_Null::RenderDeviceNull();
+		}
 		default:
 			Modules::log().writeError( "Incorrect render interface type or type not specified. Renderer cannot be initialized." );
 			break;
@@ -487,6 +547,25 @@ void Renderer::createPrimitives()
 	_vbFSPoly = _renderDevice->createVertexBuffer( 3 * 3 * sizeof( float ), fsVerts );
 	_renderDevice->setGeomVertexParams( _FSPolyGeo, _vbFSPoly, 0, 0, 12 );
 	_renderDevice->finishCreatingGeometry( _FSPolyGeo );
+
+	// Light volumes with per-instance light data, sharing the vertex and index data from above
+	if( _renderDevice->getCaps().instancing )
+	{
+		_vbLightVolumeInst = _renderDevice->createVertexBuffer(
+			LightVolumesPerBatch * sizeof( LightVolumeInstance ), 0x0 );
+
+		_sphereInstGeo = _renderDevice->beginCreatingGeometry( _vlLightVolume );
+		_renderDevice->setGeomVertexParams( _sphereInstGeo, _vbSphere, 0, 0, 12 );
+		_renderDevice->setGeomVertexParams( _sphereInstGeo, _vbLightVolumeInst, 1, 0, sizeof( LightVolumeInstance ) );
+		_renderDevice->setGeomIndexParams( _sphereInstGeo, _ibSphere, IDXFMT_16 );
+		_renderDevice->finishCreatingGeometry( _sphereInstGeo );
+
+		_coneInstGeo = _renderDevice->beginCreatingGeometry( _vlLightVolume );
+		_renderDevice->setGeomVertexParams( _coneInstGeo, _vbCone, 0, 0, 12 );
+		_renderDevice->setGeomVertexParams( _coneInstGeo, _vbLightVolumeInst, 1, 0, sizeof( LightVolumeInstance ) );
+		_renderDevice->setGeomIndexParams( _coneInstGeo, _ibCone, IDXFMT_16 );
+		_renderDevice->finishCreatingGeometry( _coneInstGeo );
+	}
 }
 
 
@@ -540,6 +619,8 @@ void Renderer::prepareRenderViews()
 
 	// Clear old views 
 	scm.clearRenderViews();
+	_shadowParams.resize( 0 );
+	_shadowAtlasValid = false;
 
 	// WARNING! Currently lighting will not be present in the first frame, because scene update will happen
 	// after lights addition to render views. If that behavior is not desirable uncomment the following statement (may reduce performance a bit)
@@ -589,6 +670,9 @@ void Renderer::prepareRenderViews()
 		// We need to send AABB with only shadow casting objects
 		light->_shadowRenderParamsID = prepareCropFrustum( light, view->auxObjectsAABB );
 		processedLightsCount++;
+
+		const ShadowParameters &params = _shadowParams[ light->_shadowRenderParamsID ];
+		for ( uint32 j = 0; j < 5; ++j ) light->_shadowSplitDists[ j ] = params.splitPlanes[ j ];
 	}
 
 	// Prepare render queues for crop frustums
@@ -617,6 +701,156 @@ void Renderer::prepareRenderViews()
 	timer->setEnabled( false );
 }
 
+
+void Renderer::extractRenderData()
+{
+	SceneManager &scm = Modules::sceneMan();
+
+	// Clear without affecting capacity
+	_snapshot.nodes.resize( 0 );
+	_snapshot.models.resize( 0 );
+	_snapshot.particleBatches.resize( 0 );
+	_snapshot.skinMatRows.resize( 0 );
+	_snapshot.parPositions.resize( 0 );
+	_snapshot.parSizesAndRotations.resize( 0 );
+	_snapshot.parColors.resize( 0 );
+	++_snapshot.stamp;
+
+	// Nodes are usually contained in several views but their data is copied only once
+	auto &views = scm.getRenderViews(); auto count = scm.getActiveRenderViewCount();
+	for ( int i = 0; i < count; ++i )
+	{
+		RenderQueue &objects = views[ i ].objects;
+		for ( size_t j = 0, s = objects.size(); j < s; ++j )
+		{
+			SceneNode *node = objects[ j ].node;
+			if ( node->_snapshotStamp != _snapshot.stamp )
+			{
+				node->_snapshotStamp = _snapshot.stamp;
+				node->_snapshotIndex = extractNode( node );
+			}
+			objects[ j ].dataIndex = node->_snapshotIndex;
+		}
+	}
+
+	_snapshot.camera = _curCamera;
+}
+
+
+uint32 Renderer::extractNode( SceneNode *node )
+{
+	uint32 index = (uint32)_snapshot.nodes.size();
+	_snapshot.nodes.emplace_back();
+	SnapshotNode &data = _snapshot.nodes.back();
+
+	data.absTrans = node->_absTrans;
+	data.bBox = node->_bBox;
+	data.node = node;
+	data.materialRes = 0x0;
+	data.handle = node->_handle;
+	data.sortKey = node->_sortKey;
+	data.type = node->_type;
+	data.modelIndex = 0;
+	data.firstBatch = 0;
+	data.batchCount = 0;
+	data.elementsCount = 0;
+	data.elementsStart = 0;
+	data.geoRes = 0x0;
+	data.compBufferRes = 0x0;
+	data.indirectBufferRes = 0x0;
+
+	switch( node->_type )
+	{
+	case SceneNodeTypes::Mesh:
+		{
+			MeshNode *meshNode = (MeshNode *)node;
+			ModelNode *modelNode = meshNode->getParentModel();
+			GeometryResource *geoRes = modelNode->getGeometryResource();
+
+			data.materialRes = meshNode->getMaterialRes();
+			data.batchStart = meshNode->getBatchStart();
+			data.batchIndexCount = meshNode->getBatchCount();
+			data.vertRStart = meshNode->getVertRStart();
+			data.vertREnd = meshNode->getVertREnd();
+			data.lodLevel = meshNode->getLodLevel();
+			data.primType = meshNode->getPrimType();
+			
+			// Check that mesh is valid
+			if( geoRes != 0x0 && data.batchStart + data.batchIndexCount <= geoRes->_indexCount )
+				data.geoRes = geoRes;
+
+			// Skin palette and instance data are shared by all meshes of a model
+			if( modelNode->_snapshotStamp != _snapshot.stamp )
+			{
+				modelNode->_snapshotStamp = _snapshot.stamp;
+				modelNode->_snapshotIndex = (uint32)_snapshot.models.size();
+				_snapshot.models.emplace_back();
+				SnapshotModel &model = _snapshot.models.back();
+
+				for( uint32 i = 0; i < ModelCustomVecCount; ++i )
+					model.customInstData[i] = modelNode->_customInstData[i];
+				model.firstSkinRow = (uint32)_snapshot.skinMatRows.size();
+				model.skinRowCount = (uint32)modelNode->_skinMatRows.size();
+				model.hasJoints = !modelNode->_jointList.empty();
+				_snapshot.skinMatRows.insert( _snapshot.skinMatRows.end(),
+				                              modelNode->_skinMatRows.begin(), modelNode->_skinMatRows.end() );
+			}
+			data.modelIndex = modelNode->_snapshotIndex;
+			break;
+		}
+	case SceneNodeTypes::Emitter:
+		{
+			EmitterNode *emitter = (EmitterNode *)node;
+
+			data.materialRes = emitter->_materialRes;
+			data.elementsCount = emitter->_particleCount;
+			data.firstBatch = (uint32)_snapshot.particleBatches.size();
+
+			// Only batches with living particles are drawn, so the others are not copied
+			for( uint32 first = 0; first < emitter->_particleCount; first += ParticlesPerBatch )
+			{
+				uint32 count = std::min( emitter->_particleCount - first, ParticlesPerBatch );
+				uint32 k = 0;
+				while( k < count && emitter->_particles[first + k].life <= 0 ) ++k;
+				if( k == count ) continue;
+
+				SnapshotParticleBatch batch;
+				batch.firstParticle = (uint32)_snapshot.parColors.size() / 4;
+				batch.count = count;
+				_snapshot.particleBatches.push_back( batch );
+
+				_snapshot.parPositions.insert( _snapshot.parPositions.end(), emitter->_parPositions + first * 3,
+				                               emitter->_parPositions + (first + count) * 3 );
+				_snapshot.parSizesAndRotations.insert( _snapshot.parSizesAndRotations.end(),
+					emitter->_parSizesANDRotations + first * 2, emitter->_parSizesANDRotations + (first + count) * 2 );
+				_snapshot.parColors.insert( _snapshot.parColors.end(), emitter->_parColors + first * 4,
+				                            emitter->_parColors + (first + count) * 4 );
+			}
+			data.batchCount = (uint32)_snapshot.particleBatches.size() - data.firstBatch;
+			break;
+		}
+	case SceneNodeTypes::Compute:
+		{
+			ComputeNode *compNode = (ComputeNode *)node;
+
+			data.materialRes = compNode->_materialRes;
+			data.compBufferRes = compNode->_compBufferRes;
+			data.indirectBufferRes = compNode->_indirectBufferRes;
+			data.indirectOffset = compNode->_indirectOffset;
+			data.elementsStart = compNode->_elementsStart;
+			data.drawType = compNode->_drawType;
+
+			// Subsample distant chunks by drawing only a prefix of their element range
+			const Matrix4f &projMat = _curCamera->getProjMat();
+			data.elementsCount = compNode->calcLodElementsCount( _curCamera->getAbsPos(),
+				projMat.c[1][1] * _curCamera->getViewportHeight() * 0.5f, _curCamera->_orthographic );
+			break;
+		}
+	}
+
+	return index;
+}
+
 // =================================================================================================
 // Material System
 // =================================================================================================
@@ -629,11 +863,43 @@ bool Renderer::createShaderComb( ShaderCombination &sc, const char *vertexShader
 	if( shdObj == 0 ) return false;
 	
 	sc.shaderObj = shdObj;
+	initShaderComb( sc );
+
+	return true;
+}
+
+
+bool Renderer::beginShaderComb( ShaderCombination &sc, const char *vertexShader, const char *fragmentShader, const char *geometryShader,
+								const char *tessControlShader, const char *tessEvaluationShader, const char *computeShader )
+{
+	sc.shaderObj = _renderDevice->beginCreatingShader( vertexShader, fragmentShader, geometryShader,
+	                                                   tessControlShader, tessEvaluationShader, computeShader );
+	return sc.shaderObj != 0;
+}
+
+
+bool Renderer::finishShaderComb( ShaderCombination &sc )
+{
+	if( !_renderDevice->finishCreatingShader( sc.shaderObj ) ) return false;
+
+	initShaderComb( sc );
+
+	return true;
+}
+
+
+void Renderer::initShaderComb( ShaderCombination &sc )
+{
+	uint32 shdObj = sc.shaderObj;
 	_renderDevice->bindShader( shdObj );
 	
 	// Set standard uniforms
 	int loc =_renderDevice-> getShaderSamplerLoc( shdObj, "shadowMap" );
 	if( loc >= 0 ) _renderDevice->setShaderSampler( loc, 12 );
+	loc = _renderDevice->getShaderSamplerLoc( shdObj, "tileLights" );
+	if( loc >= 0 ) _renderDevice->setShaderSampler( loc, 13 );
+	loc = _renderDevice->getShaderSamplerLoc( shdObj, "tileLightIndices" );
+	if( loc >= 0 ) _renderDevice->setShaderSampler( loc, 14 );
 
 	sc.uniLocs.reserve( _engineUniforms.size() );
 
@@ -675,8 +941,6 @@ bool Renderer::createShaderComb( ShaderCombination &sc, const char *vertexShader
 // 	sc.uni_parColorArray = _renderDevice->getShaderConstLoc( shdObj, "parColorArray" );
 // 	
 // 	// Uniforms, requested by extensions
-
-	return true;
 }
 
 
@@ -710,6 +974,12 @@ void Renderer::commitGeneralUniforms()
 			float dimensions[2] = { (float)_renderDevice->_fbWidth, (float)_renderDevice->_fbHeight };
 			_renderDevice->setShaderConst( _curShader->uniLocs[ _uni.frameBufSize ], CONST_FLOAT2, dimensions );
 		}
+
+		if( _curShader->uniLocs[ _uni.viewportScale ] >= 0 )
+		{
+			float scale[2] = { _viewportScale, _viewportScale };
+			_renderDevice->setShaderConst( _curShader->uniLocs[ _uni.viewportScale ], CONST_FLOAT2, scale );
+		}
 		
 		// Viewer params
 		if( _curShader->uniLocs[ _uni.viewMat ] >= 0 )
@@ -758,6 +1028,12 @@ void Renderer::commitGeneralUniforms()
 
 			if( _curShader->uniLocs[ _uni.shadowMats ] >= 0 )
 				_renderDevice->setShaderConst( _curShader->uniLocs[ _uni.shadowMats ], CONST_FLOAT44, &_lightMats[0].x[0], 4 );
+
+			if( _curShader->uniLocs[ _uni.shadowCascadeMats ] >= 0 )
+				_renderDevice->setShaderConst( _curShader->uniLocs[ _uni.shadowCascadeMats ], CONST_FLOAT44, &_cascadeMats[0].x[0], 4 );
+
+			if( _curShader->uniLocs[ _uni.shadowCascadeRegions ] >= 0 )
+				_renderDevice->setShaderConst( _curShader->uniLocs[ _uni.shadowCascadeRegions ], CONST_FLOAT4, _cascadeRegions, 4 );
 			
 			if( _curShader->uniLocs[ _uni.shadowMapSize ] >= 0 )
 				_renderDevice->setShaderConst( _curShader->uniLocs[ _uni.shadowMapSize ], CONST_FLOAT, &_smSize );
@@ -809,6 +1085,14 @@ bool Renderer::setMaterialRec( MaterialResource *materialRes, const string &shad
 		// Configure blending
 		_renderDevice->setBlendMode( context->blendingEnabled, ( RDIBlendFunc ) context->blendStateSrc, ( RDIBlendFunc ) context->blendStateDst );
 
+		// Offscreen particles keep the transmittance of the background in alpha for compositing,
+		// additive blending leaves it untouched
+		if( _offscreenParticlePass && context->blendingEnabled )
+		{
+			_renderDevice->setAlphaBlendMode( BS_BLEND_ZERO, context->blendStateDst == BlendModes::One ?
+			                                  BS_BLEND_ONE : BS_BLEND_INV_SRC_ALPHA );
+		}
+
 		// Configure depth test
 		_renderDevice->setDepthTest( context->depthTest );
 		_renderDevice->setDepthFunc( (RDIDepthFunc)context->depthFunc );
@@ -818,6 +1102,14 @@ bool Renderer::setMaterialRec( MaterialResource *materialRes, const string &shad
 
 		// Configure how many vertices form a patch in tesselation shader
 		if ( context->tessVerticesInPatchCount > 1 ) _renderDevice->setTessPatchVertices( context->tessVerticesInPatchCount );
+
+		// Shaders sampling through bindless handles only need the position of the material in the texture table
+		int texBaseLoc = _curShader->uniLocs[_uni.materialTexBase];
+		if( texBaseLoc >= 0 && _renderDevice->getCaps().bindlessTextures )
+		{
+			float texBase = (float)updateMaterialTexTable( materialRes, shaderRes );
+			_renderDevice->setShaderConst( texBaseLoc, CONST_FLOAT, &texBase );
+		}
 	}
 
 	// Setup texture samplers
@@ -842,11 +1134,7 @@ bool Renderer::setMaterialRec( MaterialResource *materialRes, const string &shad
 			}
 		}
 
-		uint32 sampState = shaderRes->_samplers[i].sampState;
-		if( (sampState & SS_FILTER_TRILINEAR) && !Modules::config().trilinearFiltering )
-			sampState = (sampState & ~SS_FILTER_TRILINEAR) | SS_FILTER_BILINEAR;
-		if( (sampState & SS_ANISO_MASK) > _maxAnisoMask )
-			sampState = (sampState & ~SS_ANISO_MASK) | _maxAnisoMask;
+		uint32 sampState = adjustSamplerState( shaderRes->_samplers[i].sampState );
 
 		// specify how texture is used (as texture or as read/write buffer)
 		uint32 usage = shaderRes->_samplers[ i ].usage;
@@ -977,6 +1265,156 @@ bool Renderer::setMaterialRec( MaterialResource *materialRes, const string &shad
 }
 
 
+uint32 Renderer::adjustSamplerState( uint32 sampState ) const
+{
+	if( (sampState & SS_FILTER_TRILINEAR) && !Modules::config().trilinearFiltering )
+		sampState = (sampState & ~SS_FILTER_TRILINEAR) | SS_FILTER_BILINEAR;
+	if( (sampState & SS_ANISO_MASK) > _maxAnisoMask )
+		sampState = (sampState & ~SS_ANISO_MASK) | _maxAnisoMask;
+
+	return sampState;
+}
+
+
+uint32 Renderer::updateMaterialTexTable( MaterialResource *materialRes, ShaderResource *shaderRes )
+{
+	// Every material owns a range with one handle per shader sampler, in the order of the FX section.
+	// Ranges of removed materials are reused, the table only grows when no free range is large enough.
+	uint32 numSamplers = (uint32)shaderRes->_samplers.size();
+	if( materialRes->_texTableSize < numSamplers )
+	{
+		releaseMaterialTexTable( materialRes );
+		if( !_matTexArena.alloc( numSamplers, materialRes->_texTableOffset ) )
+		{
+			_matTexArena.grow( _matTexArena.getCapacity() + numSamplers );
+			_matTexArena.alloc( numSamplers, materialRes->_texTableOffset );
+			_matTexHandles.resize( _matTexArena.getCapacity(), 0 );
+		}
+		materialRes->_texTableSize = numSamplers;
+		materialRes->_texTableFrame = 0;
+
+		// Entries of a reused range still hold the handles of the previous owner
+		std::fill( _matTexHandles.begin() + materialRes->_texTableOffset,
+		           _matTexHandles.begin() + materialRes->_texTableOffset + numSamplers, 0 );
+	}
+
+	// Handles are validated once per frame so that reloaded textures and changed settings are picked up
+	if( materialRes->_texTableFrame != _frameID )
+	{
+		materialRes->_texTableFrame = _frameID;
+		bool changed = false;
+
+		for( uint32 i = 0; i < numSamplers; ++i )
+		{
+			ShaderSampler &sampler = shaderRes->_samplers[i];
+			if( sampler.usage != TextureUsage::Texture ) continue;
+
+			// Same precedence as in setMaterialRec, textures of linked materials override the own ones
+			TextureResource *texRes = sampler.defTex;
+			for( MaterialResource *mat = materialRes; mat != 0x0; mat = mat->_matLink )
+			{
+				for( size_t j = 0, sj = mat->_samplers.size(); j < sj; ++j )
+				{
+					if( mat->_samplers[j].name == sampler.id )
+					{
+						if( mat->_samplers[j].texRes && mat->_samplers[j].texRes->isLoaded() )
+							texRes = mat->_samplers[j].texRes;
+						break;
+					}
+				}
+				if( mat->_matLink == materialRes ) break;
+			}
+			if( texRes != 0x0 && texRes->getTexType() != sampler.type ) texRes = sampler.defTex;
+
+			uint32 texObj = texRes != 0x0 ? texRes->getTexObject() : 0;
+			if( texObj == 0 )
+			{
+				switch( sampler.type )
+				{
+				case TextureTypes::Tex3D: texObj = TextureResource::defTex3DObject; break;
+				case TextureTypes::TexCube: texObj = TextureResource::defTexCubeObject; break;
+				case TextureTypes::Tex2DArray: texObj = TextureResource::defTex2DArrayObject; break;
+				default: texObj = TextureResource::defTex2DObject; break;
+				}
+			}
+
+			uint64 handle = _renderDevice->getTextureHandle( texObj, (uint16)adjustSamplerState( sampler.sampState ) );
+			if( _matTexHandles[materialRes->_texTableOffset + i] != handle )
+			{
+				_matTexHandles[materialRes->_texTableOffset + i] = handle;
+				changed = true;
+			}
+		}
+
+		if( _matTexHandles.size() > _matTexBufCapacity )
+		{
+			// Recreate the buffer with room for more materials and upload the whole table
+			if( _matTexBuf ) _renderDevice->destroyBuffer( _matTexBuf );
+			_matTexBufCapacity = std::max( (uint32)_matTexHandles.size() * 2, 1024u );
+			_matTexBuf = _renderDevice->createShaderStorageBuffer( _matTexBufCapacity * sizeof( uint64 ), 0x0 );
+			_renderDevice->updateBufferData( 0, _matTexBuf, 0, (uint32)_matTexHandles.size() * sizeof( uint64 ),
+			                                 _matTexHandles.data() );
+			_matTexBufBound = false;
+		}
+		else if( changed )
+		{
+			_renderDevice->updateBufferData( 0, _matTexBuf, materialRes->_texTableOffset * sizeof( uint64 ),
+			                                 numSamplers * sizeof( uint64 ), &_matTexHandles[materialRes->_texTableOffset] );
+		}
+	}
+
+	if( !_matTexBufBound )
+	{
+		_renderDevice->setStorageBuffer( MaterialTexTableSlot, _matTexBuf );
+		_matTexBufBound = true;
+	}
+
+	return materialRes->_texTableOffset;
+}
+
+
+void Renderer::releaseMaterialTexTable( MaterialResource *materialRes )
+{
+	if( materialRes->_texTableSize == 0 ) return;
+
+	_matTexArena.release( materialRes->_texTableOffset, materialRes->_texTableSize );
+	materialRes->_texTableOffset = 0;
+	materialRes->_texTableSize = 0;
+}
+
+
+bool Renderer::switchMaterialTextures( MaterialResource *curMatRes, MaterialResource *materialRes )
+{
+	// Only possible when the current shader reads all material textures from the texture table
+	if( _curShader == 0x0 || curMatRes == 0x0 || !_renderDevice->getCaps().bindlessTextures ) return false;
+	int texBaseLoc = _curShader->uniLocs[_uni.materialTexBase];
+	if( texBaseLoc < 0 ) return false;
+	
+	if( !materialRes->differsOnlyInTextures( *curMatRes ) ) return false;
+
+	// Samplers that are still bound to texture units must keep their texture
+	ShaderResource *shaderRes = materialRes->_shaderRes;
+	for( size_t i = 0, si = materialRes->_samplers.size(); i < si; ++i )
+	{
+		if( materialRes->_samplers[i].texRes.getPtr() == curMatRes->_samplers[i].texRes.getPtr() ) continue;
+
+		for( size_t j = 0, sj = shaderRes->_samplers.size(); j < sj; ++j )
+		{
+			if( shaderRes->_samplers[j].id == materialRes->_samplers[i].name )
+			{
+				if( _curShader->samplersLocs[j] >= 0 ) return false;
+				break;
+			}
+		}
+	}
+
+	float texBase = (float)updateMaterialTexTable( materialRes, shaderRes );
+	_renderDevice->setShaderConst( texBaseLoc, CONST_FLOAT, &texBase );
+
+	return true;
+}
+
+
 bool Renderer::setMaterial( MaterialResource *materialRes, const string &shaderContext )
 {
 	if( materialRes == 0x0 )
@@ -1018,6 +1456,22 @@ void Renderer::releaseShadowRB()
 }
 
 
+bool Renderer::createShadowAtlasRB( uint32 width, uint32 height )
+{
+	_shadowAtlasRB = _renderDevice->createRenderBuffer( width, height, TextureFormats::BGRA8, true, 0, 0, 0 );
+	_shadowAtlasValid = false;
+
+	return _shadowAtlasRB != 0;
+}
+
+
+void Renderer::releaseShadowAtlasRB()
+{
+	if( _shadowAtlasRB ) _renderDevice->destroyRenderBuffer( _shadowAtlasRB );
+	_shadowAtlasRB = 0;
+}
+
+
 void Renderer::setupShadowMap( bool noShadows )
 {
 	uint32 sampState = SS_FILTER_BILINEAR | SS_ANISO1 | SS_ADDR_CLAMPCOL | SS_COMP_LEQUAL;
@@ -1025,8 +1479,18 @@ void Renderer::setupShadowMap( bool noShadows )
 	// Bind shadow map
 	if( !noShadows && _curLight->_shadowMapCount > 0 )
 	{
-		_renderDevice->setTexture( 12, _renderDevice->getRenderBufferTex( _shadowRB, 32 ), sampState, TextureUsage::Texture );
-		_smSize = (float)Modules::config().shadowMapSize;
+		int paramsID = _curLight->_shadowRenderParamsID;
+		if( paramsID >= 0 && paramsID < (int)_shadowParams.size() && _shadowParams[ paramsID ].atlasX >= 0 )
+		{
+			// Shadow matrices point to the region of the light in the atlas
+			_renderDevice->setTexture( 12, _renderDevice->getRenderBufferTex( _shadowAtlasRB, 32 ), sampState, TextureUsage::Texture );
+			_smSize = (float)Modules::config().shadowAtlasSize;
+		}
+		else
+		{
+			_renderDevice->setTexture( 12, _renderDevice->getRenderBufferTex( _shadowRB, 32 ), sampState, TextureUsage::Texture );
+			_smSize = (float)Modules::config().shadowMapSize;
+		}
 	}
 	else
 	{
@@ -1245,109 +1709,315 @@ bool Renderer::prepareShadowMapFrustum( const LightNode *light, int shadowView )
 }
 
 
-void Renderer::updateShadowMap()
+void Renderer::prepareShadowCascades()
 {
-	if ( _curLight == 0x0 || _curLight->_shadowRenderParamsID == -1 ) return;
+	// Casters of a light with several cascades are moved from the cascade views into one view, so that
+	// each caster is drawn once with an instance per overlapped cascade. Casters whose shader has no
+	// cascade context stay in the cascade views and are drawn per cascade as before
+	if( !_renderDevice->getCaps().instancing || !_renderDevice->getCaps().clipDistances ) return;
 
-	uint32 prevRendBuf = _renderDevice->_curRendBuf;
-	int prevVPX = _renderDevice->_vpX, prevVPY = _renderDevice->_vpY, prevVPWidth = _renderDevice->_vpWidth, prevVPHeight = _renderDevice->_vpHeight;
+	SceneManager &scm = Modules::sceneMan();
+	_cascadeMasks.assign( _snapshot.nodes.size(), 0 );
 
-	int shadowRTWidth, shadowRTHeight;
-	_renderDevice->getRenderBufferDimensions( _shadowRB, &shadowRTWidth, &shadowRTHeight );
+	// Views added here are appended, so only the views that existed before are visited
+	int count = scm.getActiveRenderViewCount();
+	for( int i = 0; i < count; ++i )
+	{
+		if( scm.getRenderViews()[ i ].type != RenderViewType::Light ) continue;
 
-	_renderDevice->setViewport( 0, 0, shadowRTWidth, shadowRTHeight );
-	_renderDevice->setRenderBuffer( _shadowRB );
+		LightNode *light = (LightNode *)scm.getRenderViews()[ i ].node;
+		if( light->_shadowMapCount < 2 || light->_shadowRenderParamsID < 0 ) continue;
 
-	_renderDevice->setColorWriteMask( false );
-	_renderDevice->setDepthMask( true );
-	_renderDevice->clear( CLR_DEPTH, 0x0, 1.f );
+		ShadowParameters &params = _shadowParams[ light->_shadowRenderParamsID ];
+		const std::string context = light->_shadowContext + "_CASCADES";
+
+		// Adding the view can reallocate the views, so references are taken afterwards
+		int cascadeView = scm.addRenderView( RenderViewType::Shadow, light,
+		                                     scm.getRenderViews()[ params.viewID[ 0 ] ].frustum, -1 );
+		auto &views = scm.getRenderViews();
+		RenderQueue &merged = views[ cascadeView ].objects;
+		views[ cascadeView ].updated = true;
+
+		// Find the cascades overlapped by each caster that can be instanced
+		MaterialResource *lastMatRes = 0x0;
+		bool lastMatInstanced = false;
+		for( uint32 c = 0; c < light->_shadowMapCount; ++c )
+		{
+			const RenderQueue &objects = views[ params.viewID[ c ] ].objects;
+			for( size_t j = 0, s = objects.size(); j < s; ++j )
+			{
+				const SnapshotNode &data = _snapshot.nodes[ objects[ j ].dataIndex ];
+				if( data.type != SceneNodeTypes::Mesh || data.geoRes == 0x0 ) continue;
+
+				if( data.materialRes != lastMatRes )
+				{
+					lastMatRes = data.materialRes;
+					lastMatInstanced = lastMatRes != 0x0 && lastMatRes->_shaderRes != 0x0 &&
+					                   lastMatRes->_shaderRes->findContext( context ) != 0x0;
+				}
+				if( lastMatInstanced ) _cascadeMasks[ objects[ j ].dataIndex ] |= 1 << c;
+			}
+		}
+
+		// Move casters to the merged view, they are added when their first cascade is visited
+		for( uint32 c = 0; c < light->_shadowMapCount; ++c )
+		{
+			RenderQueue &objects = views[ params.viewID[ c ] ].objects;
+			size_t kept = 0;
+			for( size_t j = 0, s = objects.size(); j < s; ++j )
+			{
+				uint8 mask = _cascadeMasks[ objects[ j ].dataIndex ];
+				if( mask == 0 )
+				{
+					objects[ kept++ ] = objects[ j ];
+					continue;
+				}
+
+				if( ( mask & ( ( 1 << c ) - 1 ) ) == 0 )
+				{
+					uint32 last = c;
+					while( mask >> ( last + 1 ) ) ++last;
+
+					merged.push_back( objects[ j ] );
+					merged.back().cascadeFirst = (uint8)c;
+					merged.back().cascadeCount = (uint8)( last - c + 1 );
+				}
+			}
+			objects.resize( kept );
+		}
+
+		// Masks are reset for the next light
+		for( size_t j = 0, s = merged.size(); j < s; ++j )
+			_cascadeMasks[ merged[ j ].dataIndex ] = 0;
+
+		params.cascadeViewID = merged.empty() ? -1 : cascadeView;
+	}
+}
 
+
+void Renderer::drawShadowViews( ShadowParameters &params, int x, int y, int size, int texSize, RenderingOrder::List order )
+{
+	// Renders the shadow views of the current light into the square region at x, y of the bound
+	// render buffer and stores the matrices for looking up the region in params.lightMats
+	
 	// ********************************************************************************************
 	// Cascaded Shadow Maps
 	// ********************************************************************************************
 
 	// Prepare shadow map rendering
+	_renderDevice->setViewport( x, y, size, size );
 	_renderDevice->setDepthTest( true );
 	//_renderDevice->setCullMode( RS_CULL_FRONT );	// Front face culling reduces artefacts but produces more "peter-panning"
 	
 	const uint32 numMaps = _curLight->_shadowMapCount;
-	ShadowParameters &params = _shadowParams[ _curLight->_shadowRenderParamsID ];
+	const int hsm = size / 2;
+	Modules::stats().incStat( EngineStats::ShadowMapCount, (float)numMaps );
+	const int scissorXY[ 8 ] = { 0, 0,  hsm, 0,  hsm, hsm,  0, hsm };
+	const float transXY[ 8 ] = { -0.5f, -0.5f,  0.5f, -0.5f,  0.5f, 0.5f,  -0.5f, 0.5f };
 
-	// Copy split planes so that it is passed to shader on material setting
-	for ( uint32 i = 0; i < 5; ++i ) _splitPlanes[ i ] = params.splitPlanes[ i ];
+	// Create texture atlas if several splits are enabled
+	for ( uint32 i = 0; i < numMaps; ++i )
+	{
+		if ( numMaps > 1 )
+		{
+			// Select quadrant of shadow map
+			params.lightProjMatrix[ i ].scale( 0.5f, 0.5f, 1.0f );
+			params.lightProjMatrix[ i ].translate( transXY[ i * 2 ], transXY[ i * 2 + 1 ], 0.0f );
+		}
+
+		params.lightMats[ i ] = params.lightProjMatrix[ i ] * _curLight->getViewMat();
+	}
+
+	// Render casters that overlap several cascades once, each instance is clipped to its quadrant
+	if ( params.cascadeViewID >= 0 )
+	{
+		for ( uint32 i = 0; i < numMaps; ++i )
+		{
+			_cascadeMats[ i ] = params.lightMats[ i ];
+			_cascadeRegions[ i * 4 + 0 ] = transXY[ i * 2 ] - 0.5f;
+			_cascadeRegions[ i * 4 + 1 ] = transXY[ i * 2 + 1 ] - 0.5f;
+			_cascadeRegions[ i * 4 + 2 ] = transXY[ i * 2 ] + 0.5f;
+			_cascadeRegions[ i * 4 + 3 ] = transXY[ i * 2 + 1 ] + 0.5f;
+		}
+		setupViewMatrices( _curLight->getViewMat(), params.lightProjMatrix[ 0 ] );
+
+		_renderDevice->setScissorTest( true );
+		_renderDevice->setScissorRect( x, y, size, size );
+		_renderDevice->setClipDistances( true );
+
+		Modules::sceneMan().setCurrentView( params.cascadeViewID );
+		if ( order != RenderingOrder::None ) Modules::sceneMan().sortViewObjects( order );
+		Frustum &f = Modules::sceneMan().getRenderViews()[ params.cascadeViewID ].frustum;
+		drawRenderables( _curLight->_shadowContext + "_CASCADES", 0, false, &f, 0x0, order, -1 );
+
+		_renderDevice->setClipDistances( false );
+	}
 
 	// Split viewing frustum into slices and render shadow maps
 	for ( uint32 i = 0; i < numMaps; ++i )
 	{
-		// Create texture atlas if several splits are enabled
 		if ( numMaps > 1 )
 		{
-			const int hsm = Modules::config().shadowMapSize / 2;
-			const int scissorXY[ 8 ] = { 0, 0,  hsm, 0,  hsm, hsm,  0, hsm };
-			const float transXY[ 8 ] = { -0.5f, -0.5f,  0.5f, -0.5f,  0.5f, 0.5f,  -0.5f, 0.5f };
+			// Casters of this cascade may all be drawn by the instanced pass
+			if ( Modules::sceneMan().getRenderViews()[ params.viewID[ i ] ].objects.empty() ) continue;
 
 			_renderDevice->setScissorTest( true );
-
-			// Select quadrant of shadow map
-			params.lightProjMatrix[ i ].scale( 0.5f, 0.5f, 1.0f );
-			params.lightProjMatrix[ i ].translate( transXY[ i * 2 ], transXY[ i * 2 + 1 ], 0.0f );
-			_renderDevice->setScissorRect( scissorXY[ i * 2 ], scissorXY[ i * 2 + 1 ], hsm, hsm );
+			_renderDevice->setScissorRect( x + scissorXY[ i * 2 ], y + scissorXY[ i * 2 + 1 ], hsm, hsm );
 		}
 
-		_lightMats[ i ] = params.lightProjMatrix[ i ] * _curLight->getViewMat();
 		setupViewMatrices( _curLight->getViewMat(), params.lightProjMatrix[ i ] );
 
 		// Render
 		Modules::sceneMan().setCurrentView( params.viewID[ i ] );
+		if ( order != RenderingOrder::None ) Modules::sceneMan().sortViewObjects( order );
 		Frustum &f = Modules::sceneMan().getRenderViews()[ params.viewID[ i ] ].frustum;
-		drawRenderables( _curLight->_shadowContext, 0, false, &f, 0x0, RenderingOrder::None, -1 );
+		drawRenderables( _curLight->_shadowContext, 0, false, &f, 0x0, order, -1 );
 	}
 
-	// Map from post-projective space [-1,1] to texture space [0,1]
+	// Map from post-projective space [-1,1] to the region in texture space [0,1]
+	const float scale = 0.5f * size / texSize;
 	for ( uint32 i = 0; i < numMaps; ++i )
 	{
-		_lightMats[ i ].scale( 0.5f, 0.5f, 1.0f );
-		_lightMats[ i ].translate( 0.5f, 0.5f, 0.0f );
+		params.lightMats[ i ].scale( scale, scale, 1.0f );
+		params.lightMats[ i ].translate( x / (float)texSize + scale, y / (float)texSize + scale, 0.0f );
 	}
 
 	// ********************************************************************************************
 
 	_renderDevice->setCullMode( RS_CULL_BACK );
 	_renderDevice->setScissorTest( false );
-
-	_renderDevice->setViewport( prevVPX, prevVPY, prevVPWidth, prevVPHeight );
-	_renderDevice->setRenderBuffer( prevRendBuf );
-	_renderDevice->setColorWriteMask( true );
 }
 
-// =================================================================================================
-// Occlusion Culling
-// =================================================================================================
 
-int Renderer::registerOccSet()
+void Renderer::updateShadowMap()
 {
-	for( int i = 0; i < (int)_occSets.size(); ++i )
+	if ( _curLight == 0x0 || _curLight->_shadowRenderParamsID == -1 ) return;
+
+	ShadowParameters &params = _shadowParams[ _curLight->_shadowRenderParamsID ];
+
+	// Lights that are packed into the atlas are already rendered
+	if ( params.atlasX < 0 )
 	{
-		if( _occSets[i] == 0 )
-		{
-			_occSets[i] = 1;
-			return i;
-		}
-	}
+		uint32 prevRendBuf = _renderDevice->_curRendBuf;
+		int prevVPX = _renderDevice->_vpX, prevVPY = _renderDevice->_vpY, prevVPWidth = _renderDevice->_vpWidth, prevVPHeight = _renderDevice->_vpHeight;
 
-	_occSets.push_back( 1 );
-	return (int)_occSets.size() - 1;
-}
+		int shadowRTWidth, shadowRTHeight;
+		_renderDevice->getRenderBufferDimensions( _shadowRB, &shadowRTWidth, &shadowRTHeight );
 
+		_renderDevice->setViewport( 0, 0, shadowRTWidth, shadowRTHeight );
+		_renderDevice->setRenderBuffer( _shadowRB );
 
-void Renderer::unregisterOccSet( int occSet )
-{
-	if( occSet >= 0 && occSet < (int)_occSets.size() )
-		_occSets[occSet] = 0;
+		_renderDevice->setColorWriteMask( false );
+		_renderDevice->setDepthMask( true );
+		_renderDevice->clear( CLR_DEPTH, 0x0, 1.f );
+
+		drawShadowViews( params, 0, 0, shadowRTWidth, shadowRTWidth, RenderingOrder::None );
+
+		_renderDevice->setViewport( prevVPX, prevVPY, prevVPWidth, prevVPHeight );
+		_renderDevice->setRenderBuffer( prevRendBuf );
+		_renderDevice->setColorWriteMask( true );
+	}
+
+	// Copy split planes and matrices so that they are passed to shader on material setting
+	for ( uint32 i = 0; i < 5; ++i ) _splitPlanes[ i ] = params.splitPlanes[ i ];
+	for ( uint32 i = 0; i < _curLight->_shadowMapCount; ++i ) _lightMats[ i ] = params.lightMats[ i ];
 }
 
 
-void Renderer::drawOccProxies( uint32 list )
+void Renderer::updateShadowAtlas()
+{
+	// Renders the shadow maps of all lights in the current render views into one atlas, so that
+	// there is a single render target switch and clear per frame instead of one per light
+	if ( _shadowAtlasRB == 0 || _shadowAtlasValid ) return;
+	_shadowAtlasValid = true;
+
+	auto &views = Modules::sceneMan().getRenderViews();
+	int numLights = 0;
+	for ( size_t i = 0, s = Modules::sceneMan().getActiveRenderViewCount(); i < s; ++i )
+	{
+		if ( views[ i ].type != RenderViewType::Light ) continue;
+
+		LightNode *light = ( LightNode * ) views[ i ].node;
+		if ( light->_shadowMapCount > 0 && light->_shadowRenderParamsID >= 0 ) ++numLights;
+	}
+	if ( numLights == 0 ) return;
+
+	int atlasWidth, atlasHeight;
+	_renderDevice->getRenderBufferDimensions( _shadowAtlasRB, &atlasWidth, &atlasHeight );
+
+	// Each light gets a square region of the shadow map size; regions are made smaller if not all lights fit.
+	// Lights that still do not fit fall back to the shadow map buffer
+	int regionSize = std::min( Modules::config().shadowMapSize, atlasWidth );
+	while ( regionSize > ShadowAtlasMinRegionSize && ( atlasWidth / regionSize ) * ( atlasHeight / regionSize ) < numLights )
+		regionSize /= 2;
+	const int regionsPerRow = atlasWidth / regionSize;
+	const int numRegions = regionsPerRow * ( atlasHeight / regionSize );
+
+	uint32 prevRendBuf = _renderDevice->_curRendBuf;
+	int prevVPX = _renderDevice->_vpX, prevVPY = _renderDevice->_vpY, prevVPWidth = _renderDevice->_vpWidth, prevVPHeight = _renderDevice->_vpHeight;
+
+	_renderDevice->setViewport( 0, 0, atlasWidth, atlasHeight );
+	_renderDevice->setRenderBuffer( _shadowAtlasRB );
+
+	_renderDevice->setColorWriteMask( false );
+	_renderDevice->setDepthMask( true );
+	_renderDevice->clear( CLR_DEPTH, 0x0, 1.f );
+
+	int region = 0;
+	for ( size_t i = 0, s = Modules::sceneMan().getActiveRenderViewCount(); i < s && region < numRegions; ++i )
+	{
+		if ( views[ i ].type != RenderViewType::Light ) continue;
+
+		_curLight = ( LightNode * ) views[ i ].node;
+		if ( _curLight->_shadowMapCount == 0 || _curLight->_shadowRenderParamsID < 0 ) continue;
+
+		ShadowParameters &params = _shadowParams[ _curLight->_shadowRenderParamsID ];
+		params.atlasX = ( region % regionsPerRow ) * regionSize + ShadowAtlasBorder;
+		params.atlasY = ( region / regionsPerRow ) * regionSize + ShadowAtlasBorder;
+		params.atlasSize = regionSize - 2 * ShadowAtlasBorder;
+		++region;
+
+		// Casters are sorted by material to reduce state changes
+		drawShadowViews( params, params.atlasX, params.atlasY, params.atlasSize, atlasWidth, RenderingOrder::StateChanges );
+	}
+
+	_curLight = 0x0;
+
+	_renderDevice->setViewport( prevVPX, prevVPY, prevVPWidth, prevVPHeight );
+	_renderDevice->setRenderBuffer( prevRendBuf );
+	_renderDevice->setColorWriteMask( true );
+}
+
+// =================================================================================================
+// Occlusion Culling
+// =================================================================================================
+
+int Renderer::registerOccSet()
+{
+	for( int i = 0; i < (int)_occSets.size(); ++i )
+	{
+		if( _occSets[i] == 0 )
+		{
+			_occSets[i] = 1;
+			return i;
+		}
+	}
+
+	_occSets.push_back( 1 );
+	return (int)_occSets.size() - 1;
+}
+
+
+void Renderer::unregisterOccSet( int occSet )
+{
+	if( occSet >= 0 && occSet < (int)_occSets.size() )
+		_occSets[occSet] = 0;
+	if( occSet >= 0 && occSet < (int)_occPyramids.size() )
+		releaseOcclusionPyramid( _occPyramids[occSet] );
+}
+
+
+void Renderer::drawOccProxies( uint32 list )
 {
 	ASSERT( list < 2 );
 
@@ -1389,10 +2059,264 @@ void Renderer::drawOccProxies( uint32 list )
 }
 
 
+bool Renderer::usesOcclusionPyramid( int occSet ) const
+{
+	if( occSet < 0 || occSet >= (int)_occPyramids.size() ) return false;
+	
+	// Pyramid must have been built in the current or last frame, otherwise the stored
+	// results are stale and the hardware queries take over again
+	const OcclusionPyramid &pyr = _occPyramids[occSet];
+	return pyr.tex != 0 && pyr.lastFrame + 1 >= _frameID;
+}
+
+
+bool Renderer::isOccludedByPyramid( const SceneNode *node, int occSet ) const
+{
+	return occSet < (int)node->_occPyramidStamps.size() &&
+	       node->_occPyramidStamps[occSet] == _occPyramids[occSet].resultStamp;
+}
+
+
+void Renderer::releaseOcclusionPyramid( OcclusionPyramid &pyr )
+{
+	if( pyr.tex ) _renderDevice->destroyTexture( pyr.tex );
+	if( pyr.boxBuf ) _renderDevice->destroyBuffer( pyr.boxBuf );
+	for( uint32 i = 0; i < OccPyramidResultSlots; ++i )
+	{
+		if( pyr.resultBufs[i] ) _renderDevice->destroyBuffer( pyr.resultBufs[i] );
+		if( pyr.fences[i] ) _renderDevice->destroyFence( pyr.fences[i] );
+	}
+
+	// Stamps stay unique so that nodes marked by the released pyramid are not considered occluded
+	uint32 resultStamp = pyr.resultStamp;
+	pyr = OcclusionPyramid();
+	pyr.resultStamp = resultStamp + 1;
+}
+
+
+void Renderer::doOcclusionCulling( Resource *matRes, RenderTarget *depthRT, int occSet )
+{
+	if( occSet < 0 || !_renderDevice->getCaps().computeShaders ) return;
+	if( matRes == 0x0 || matRes->getType() != ResourceTypes::Material || depthRT == 0x0 || depthRT->rendBuf == 0 ) return;
+
+	if( occSet >= (int)_occPyramids.size() ) _occPyramids.resize( occSet + 1 );
+	OcclusionPyramid &pyr = _occPyramids[occSet];
+	MaterialResource *materialRes = (MaterialResource *)matRes;
+
+	// Level 0 halves the part of the depth buffer covered by the viewport
+	int srcWidth, srcHeight;
+	_renderDevice->getRenderBufferDimensions( depthRT->rendBuf, &srcWidth, &srcHeight );
+	if( depthRT->width == 0 && depthRT->height == 0 && _viewportScale < 1.0f )
+	{
+		srcWidth = std::max( ftoi_r( srcWidth * _viewportScale ), 1 );
+		srcHeight = std::max( ftoi_r( srcHeight * _viewportScale ), 1 );
+	}
+	int width = std::max( (srcWidth + 1) / 2, 1 ), height = std::max( (srcHeight + 1) / 2, 1 );
+	
+	if( width != pyr.width || height != pyr.height )
+	{
+		if( pyr.tex ) _renderDevice->destroyTexture( pyr.tex );
+		
+		// Smaller levels are stacked in a column next to level 0
+		int x = width, y = 0, w = width, h = height, texHeight = height;
+		pyr.levels[0] = 0; pyr.levels[1] = 0; pyr.levels[2] = (float)width; pyr.levels[3] = (float)height;
+		pyr.numLevels = 1;
+		while( (w > 1 || h > 1) && pyr.numLevels < OccPyramidMaxLevels )
+		{
+			w = std::max( (w + 1) / 2, 1 );
+			h = std::max( (h + 1) / 2, 1 );
+			float *level = &pyr.levels[pyr.numLevels++ * 4];
+			level[0] = (float)x; level[1] = (float)y; level[2] = (float)w; level[3] = (float)h;
+			y += h;
+			texHeight = std::max( texHeight, y );
+		}
+
+		pyr.tex = _renderDevice->createTexture( TextureTypes::Tex2D, width + std::max( (width + 1) / 2, 1 ), texHeight, 1,
+		                                        TextureFormats::R32F, 0, false, false, false );
+		pyr.width = pyr.tex != 0 ? width : 0;
+		pyr.height = pyr.tex != 0 ? height : 0;
+		if( pyr.tex == 0 ) return;
+	}
+
+	GPUTimer *timer = Modules::stats().getGPUTimer( EngineStats::ComputeGPUTime );
+	if( Modules::config().gatherTimeStats ) timer->beginQuery( _frameID );
+
+	vector< PipeSamplerBinding > prevBindings( _pipeSamplerBindings );
+	setupViewMatrices( _curCamera->getViewMat(), _curCamera->getProjMat() );
+	
+	// Build pyramid, each level takes the max depth of the level before
+	bindPipeBuffer( depthRT->rendBuf, "depthBuf", 32 );
+	if( setMaterial( materialRes, "BUILD_PYRAMID" ) )
+	{
+		_renderDevice->setTexture( OccPyramidImageUnit, pyr.tex, 0, TextureUsage::ComputeImageRW );
+		if( _curShader->uniLocs[ _uni.occPyramidLevels ] >= 0 )
+			_renderDevice->setShaderConst( _curShader->uniLocs[ _uni.occPyramidLevels ], CONST_FLOAT4,
+			                               pyr.levels, OccPyramidMaxLevels );
+		
+		for( int i = 0; i < pyr.numLevels; ++i )
+		{
+			float params[4] = { (float)i, (float)pyr.numLevels, (float)srcWidth, (float)srcHeight };
+			if( _curShader->uniLocs[ _uni.occPyramidParams ] >= 0 )
+				_renderDevice->setShaderConst( _curShader->uniLocs[ _uni.occPyramidParams ], CONST_FLOAT4, params );
+			if( i > 0 ) _renderDevice->setMemoryBarrier( ImageBarrier );
+
+			const float *level = &pyr.levels[i * 4];
+			_renderDevice->runComputeShader( _curShader->shaderObj, ((uint32)level[2] + 7) / 8, ((uint32)level[3] + 7) / 8, 1 );
+		}
+	}
+	_pipeSamplerBindings = prevBindings;
+
+	// Collect bounding boxes of the renderables in the camera view
+	uint32 slot = pyr.nextSlot;
+	vector< NodeHandle > &candidates = pyr.candidates[slot];
+	candidates.resize( 0 );
+	_occBoxData.resize( 0 );
+
+	const RenderQueue &objects = Modules::sceneMan().getRenderViews()[ defaultCameraView ].objects;
+	for( size_t i = 0, s = objects.size(); i < s; ++i )
+	{
+		if( objects[i].type != SceneNodeTypes::Mesh && objects[i].type != SceneNodeTypes::Emitter ) continue;
+
+		const SnapshotNode &data = _snapshot.nodes[ objects[i].dataIndex ];
+		candidates.push_back( data.handle );
+		float box[8] = { data.bBox.min.x, data.bBox.min.y, data.bBox.min.z, 1.0f,
+		                 data.bBox.max.x, data.bBox.max.y, data.bBox.max.z, 1.0f };
+		_occBoxData.insert( _occBoxData.end(), box, box + 8 );
+	}
+
+	// Results of a slot that is still in flight are dropped, the GPU lags too far behind
+	if( pyr.fences[slot] ) _renderDevice->destroyFence( pyr.fences[slot] );
+	
+	uint32 numBoxes = (uint32)candidates.size();
+	if( numBoxes > 0 && setMaterial( materialRes, "TEST_BOXES" ) )
+	{
+		uint32 boxDataSize = numBoxes * 8 * sizeof( float );
+		if( boxDataSize > pyr.boxBufSize )
+		{
+			if( pyr.boxBuf ) _renderDevice->destroyBuffer( pyr.boxBuf );
+			pyr.boxBufSize = std::max( boxDataSize, pyr.boxBufSize * 2 );
+			pyr.boxBuf = _renderDevice->createShaderStorageBuffer( pyr.boxBufSize, 0x0 );
+		}
+		
+		// Result is a bitset with one bit per box that is set if the box is occluded
+		uint32 resultSize = (numBoxes + 31) / 32 * sizeof( uint32 );
+		if( resultSize > pyr.resultBufSizes[slot] )
+		{
+			if( pyr.resultBufs[slot] ) _renderDevice->destroyBuffer( pyr.resultBufs[slot] );
+			pyr.resultBufSizes[slot] = std::max( resultSize, pyr.resultBufSizes[slot] * 2 );
+			pyr.resultBufs[slot] = _renderDevice->createShaderStorageBuffer( pyr.resultBufSizes[slot], 0x0 );
+		}
+		if( _occResultClear.size() * sizeof( uint32 ) < resultSize ) _occResultClear.resize( resultSize / sizeof( uint32 ), 0 );
+		
+		_renderDevice->updateBufferData( 0, pyr.boxBuf, 0, boxDataSize, _occBoxData.data() );
+		_renderDevice->updateBufferData( 0, pyr.resultBufs[slot], 0, resultSize, _occResultClear.data() );
+
+		_renderDevice->setTexture( OccPyramidImageUnit, pyr.tex, 0, TextureUsage::ComputeImageRO );
+		_renderDevice->setStorageBuffer( 0, pyr.boxBuf );
+		_renderDevice->setStorageBuffer( 1, pyr.resultBufs[slot] );
+		_renderDevice->setMemoryBarrier( ImageBarrier );
+
+		float params[4] = { 0, (float)pyr.numLevels, (float)numBoxes, 0 };
+		if( _curShader->uniLocs[ _uni.occPyramidParams ] >= 0 )
+			_renderDevice->setShaderConst( _curShader->uniLocs[ _uni.occPyramidParams ], CONST_FLOAT4, params );
+		if( _curShader->uniLocs[ _uni.occPyramidLevels ] >= 0 )
+			_renderDevice->setShaderConst( _curShader->uniLocs[ _uni.occPyramidLevels ], CONST_FLOAT4,
+			                               pyr.levels, OccPyramidMaxLevels );
+
+		_renderDevice->runComputeShader( _curShader->shaderObj, (numBoxes + 63) / 64, 1, 1 );
+
+		// Results are mapped once the fence is signaled, the barrier has to be issued before it
+		_renderDevice->setMemoryBarrier( BufferUpdateBarrier );
+		_renderDevice->commitStates( RenderDeviceInterface::PM_BARRIER );
+		pyr.fences[slot] = _renderDevice->createFence();
+		pyr.nextSlot = (slot + 1) % OccPyramidResultSlots;
+	}
+	else
+	{
+		candidates.resize( 0 );
+	}
+	
+	_renderDevice->setTexture( OccPyramidImageUnit, 0, 0, 0 );
+	setMaterial( 0x0, "" );
+	pyr.lastFrame = _frameID;
+
+	timer->endQuery();
+}
+
+
+void Renderer::readOcclusionResults( int occSet )
+{
+	if( occSet < 0 || occSet >= (int)_occPyramids.size() ) return;
+	OcclusionPyramid &pyr = _occPyramids[occSet];
+
+	// Fences complete in submission order, the newest signaled slot holds the latest results
+	int newest = -1;
+	for( uint32 i = 0; i < OccPyramidResultSlots; ++i )
+	{
+		uint32 slot = (pyr.nextSlot + i) % OccPyramidResultSlots;
+		if( pyr.fences[slot] == 0 || !_renderDevice->isFenceSignaled( pyr.fences[slot] ) ) continue;
+		
+		_renderDevice->destroyFence( pyr.fences[slot] );
+		newest = (int)slot;
+	}
+	if( newest < 0 ) return;
+
+	const vector< NodeHandle > &candidates = pyr.candidates[newest];
+	uint32 resultSize = ((uint32)candidates.size() + 31) / 32 * sizeof( uint32 );
+	const uint32 *bits = (const uint32 *)_renderDevice->mapBuffer( 0, pyr.resultBufs[newest], 0, resultSize, Read );
+	if( bits == 0x0 ) return;
+
+	// Nodes are marked with a new stamp so that older results do not have to be cleared
+	++pyr.resultStamp;
+	uint32 numOccluded = 0;
+	for( size_t i = 0, s = candidates.size(); i < s; ++i )
+	{
+		if( (bits[i >> 5] & (1u << (i & 31))) == 0 ) continue;
+		
+		SceneNode *node = Modules::sceneMan().resolveNodeHandle( candidates[i] );
+		if( node == 0x0 ) continue;
+		
+		if( occSet >= (int)node->_occPyramidStamps.size() ) node->_occPyramidStamps.resize( occSet + 1, 0 );
+		node->_occPyramidStamps[occSet] = pyr.resultStamp;
+		++numOccluded;
+	}
+	Modules::stats().incStat( EngineStats::OcclusionTestCount, (float)candidates.size() );
+	Modules::stats().incStat( EngineStats::OccludedCount, (float)numOccluded );
+
+	_renderDevice->unmapBuffer( 0, pyr.resultBufs[newest] );
+}
+
+
 // =================================================================================================
 // Pipeline Functions
 // =================================================================================================
 
+void Renderer::bindRenderTarget( RenderTarget *rt )
+{
+	_curRenderTarget = rt;
+
+	if( rt != 0x0 )
+	{
+		int width, height;
+		_renderDevice->getRenderBufferDimensions( rt->rendBuf, &width, &height );
+		if( rt->width == 0 && rt->height == 0 && _viewportScale < 1.0f )
+		{
+			width = std::max( ftoi_r( width * _viewportScale ), 1 );
+			height = std::max( ftoi_r( height * _viewportScale ), 1 );
+		}
+		_renderDevice->_outputBufferIndex = _curCamera->_outputBufferIndex;
+		_renderDevice->setViewport( 0, 0, width, height );
+		_renderDevice->setRenderBuffer( rt->rendBuf );
+	}
+	else
+	{
+		_renderDevice->setViewport( _curCamera->_vpX, _curCamera->_vpY, _curCamera->_vpWidth, _curCamera->_vpHeight );
+		_renderDevice->setRenderBuffer( _curCamera->_outputTex != 0x0 ?
+		                       _curCamera->_outputTex->getRBObject() : 0 );
+	}
+}
+
+
 void Renderer::bindPipeBuffer( uint32 rbObj, const string &sampler, uint32 bufIndex )
 {
 	if( rbObj == 0 )
@@ -1456,7 +2380,8 @@ void Renderer::drawFSQuad( Resource *matRes, const string &shaderContext )
 {
 	if( matRes == 0x0 || matRes->getType() != ResourceTypes::Material ) return;
 
-	setupViewMatrices( _curCamera->getViewMat(), Matrix4f::OrthoMat( 0, 1, 0, 1, -1, 1 ) );
+	// Texture coordinates cover the rendered part of dynamic resolution targets
+	setupViewMatrices( _curCamera->getViewMat(), Matrix4f::OrthoMat( 0, _viewportScale, 0, _viewportScale, -1, 1 ) );
 	
 	if( !setMaterial( (MaterialResource *)matRes, shaderContext ) ) return;
 
@@ -1476,12 +2401,77 @@ void Renderer::drawGeometry( const string &shaderContext, int theClass,
 }
 
 
+void Renderer::drawOffscreenParticles( const string &shaderContext, int theClass, RenderingOrder::List order,
+                                       float scale, Resource *matRes, RenderTarget *depthRT, int occSet )
+{
+	if( matRes == 0x0 || matRes->getType() != ResourceTypes::Material || depthRT == 0x0 || depthRT->rendBuf == 0 )
+	{
+		drawGeometry( shaderContext, theClass, order, occSet );
+		return;
+	}
+
+	// Low resolution buffer follows the viewport of the current target
+	int width = std::max( ftoi_r( _renderDevice->_vpWidth * scale ), 1 );
+	int height = std::max( ftoi_r( _renderDevice->_vpHeight * scale ), 1 );
+	if( width != _offscreenParticleWidth || height != _offscreenParticleHeight )
+	{
+		if( _offscreenParticleRB ) _renderDevice->destroyRenderBuffer( _offscreenParticleRB );
+		_offscreenParticleRB = _renderDevice->createRenderBuffer( width, height,
+			_renderDevice->getCaps().texFloat ? TextureFormats::RGBA16F : TextureFormats::BGRA8, true, 1, 0, 0 );
+		_offscreenParticleWidth = _offscreenParticleRB != 0 ? width : 0;
+		_offscreenParticleHeight = _offscreenParticleRB != 0 ? height : 0;
+	}
+	if( _offscreenParticleRB == 0 )
+	{
+		drawGeometry( shaderContext, theClass, order, occSet );
+		return;
+	}
+
+	GPUTimer *timer = Modules::stats().getGPUTimer( EngineStats::OffscreenParticleGPUTime );
+	if( Modules::config().gatherTimeStats ) timer->beginQuery( _frameID );
+
+	RenderTarget *prevTarget = _curRenderTarget;
+	vector< PipeSamplerBinding > prevBindings( _pipeSamplerBindings );
+	
+	// Downsample depth, alpha holds the transmittance of the background
+	_renderDevice->setRenderBuffer( _offscreenParticleRB );
+	_renderDevice->setViewport( 0, 0, width, height );
+	clear( true, true, false, false, false, 0, 0, 0, 1 );
+	bindPipeBuffer( depthRT->rendBuf, "depthBuf", 32 );
+	drawFSQuad( matRes, "DOWNSAMPLE_DEPTH" );
+	_pipeSamplerBindings = prevBindings;
+
+	_offscreenParticlePass = true;
+	drawGeometry( shaderContext, theClass, order, occSet );
+	_offscreenParticlePass = false;
+
+	// Composite with depth-aware upsampling
+	bindRenderTarget( prevTarget );
+	bindPipeBuffer( _offscreenParticleRB, "particleBuf", 0 );
+	bindPipeBuffer( _offscreenParticleRB, "particleDepthBuf", 32 );
+	bindPipeBuffer( depthRT->rendBuf, "depthBuf", 32 );
+	drawFSQuad( matRes, "COMPOSITE" );
+	_pipeSamplerBindings = prevBindings;
+
+	timer->endQuery();
+}
+
+
 void Renderer::drawLightGeometry( const string &shaderContext, int theClass,
                                   bool noShadows, RenderingOrder::List order, int occSet )
 {
 // 	Modules::sceneMan().updateQueues( _curCamera->getFrustum(), 0x0, RenderingOrder::None,
 // 	                                  SceneNodeFlags::NoDraw, true, false );
 	
+	// Render shadow maps of all lights up front when the atlas is used
+	if( !noShadows && _shadowAtlasRB != 0 )
+	{
+		GPUTimer *timerShadows = Modules::stats().getGPUTimer( EngineStats::ShadowsGPUTime );
+		if( Modules::config().gatherTimeStats ) timerShadows->beginQuery( _frameID );
+		updateShadowAtlas();
+		timerShadows->endQuery();
+	}
+
 	GPUTimer *timer = Modules::stats().getGPUTimer( EngineStats::FwdLightsGPUTime );
 	if( Modules::config().gatherTimeStats ) timer->beginQuery( _frameID );
 	
@@ -1552,8 +2542,10 @@ void Renderer::drawLightGeometry( const string &shaderContext, int theClass,
 		// Set scissor rectangle
 		if( bbx != 0 || bby != 0 || bbw != 1 || bbh != 1 )
 		{
-			_renderDevice->setScissorRect( ftoi_r( bbx * _renderDevice->_fbWidth ), ftoi_r( bby * _renderDevice->_fbHeight ),
-			                      ftoi_r( bbw * _renderDevice->_fbWidth ), ftoi_r( bbh * _renderDevice->_fbHeight ) );
+			int vpX = _renderDevice->_vpX, vpY = _renderDevice->_vpY;
+			int vpWidth = _renderDevice->_vpWidth, vpHeight = _renderDevice->_vpHeight;
+			_renderDevice->setScissorRect( vpX + ftoi_r( bbx * vpWidth ), vpY + ftoi_r( bby * vpHeight ),
+			                      ftoi_r( bbw * vpWidth ), ftoi_r( bbh * vpHeight ) );
 			_renderDevice->setScissorTest( true );
 		}
 		
@@ -1585,13 +2577,38 @@ void Renderer::drawLightGeometry( const string &shaderContext, int theClass,
 }
 
 
-void Renderer::drawLightShapes( const string &shaderContext, bool noShadows, int occSet )
+bool Renderer::hasLightContextVariant( const LightNode *light, const string &shaderContext, const char *suffix )
+{
+	if( light->_materialRes == 0x0 || light->_materialRes->_shaderRes == 0x0 ) return false;
+
+	// Variants of the lighting context are found by suffix, e.g. LIGHTING_INSTANCED
+	const string &context = shaderContext.empty() ? light->_lightingContext : shaderContext;
+	return light->_materialRes->_shaderRes->findContext( context + suffix ) != 0x0;
+}
+
+
+void Renderer::drawLightShapes( const string &shaderContext, bool noShadows, bool depthBounds, int tileSize, int occSet )
 {
 	MaterialResource *curMatRes = 0x0;
+	_instancedLights.resize( 0 );
+	_tiledLights.resize( 0 );
+
+	// Tile data is stored in float textures
+	if( !_renderDevice->getCaps().texFloat ) tileSize = 0;
+	else if( tileSize > 0 ) tileSize = std::max( tileSize, 8 );
 	
 // 	Modules::sceneMan().updateQueues( _curCamera->getFrustum(), 0x0, RenderingOrder::None,
 // 	                                  SceneNodeFlags::NoDraw, true, false );
 	
+	// Render shadow maps of all lights up front when the atlas is used
+	if( !noShadows && _shadowAtlasRB != 0 )
+	{
+		GPUTimer *timerShadows = Modules::stats().getGPUTimer( EngineStats::ShadowsGPUTime );
+		if( Modules::config().gatherTimeStats ) timerShadows->beginQuery( _frameID );
+		updateShadowAtlas();
+		timerShadows->endQuery();
+	}
+
 	GPUTimer *timer = Modules::stats().getGPUTimer( EngineStats::DefLightsGPUTime );
 	if( Modules::config().gatherTimeStats ) timer->beginQuery( _frameID );
 	
@@ -1638,6 +2655,23 @@ void Renderer::drawLightShapes( const string &shaderContext, bool noShadows, int
 				}
 			}
 		}
+
+		// Unshadowed lights are batched and drawn after the loop, either in tiled passes with one
+		// pass per light material or as instanced volumes
+		if( noShadows || _curLight->_shadowMapCount == 0 )
+		{
+			if( tileSize > 0 && _tiledLights.size() < TiledLightsMax &&
+			    hasLightContextVariant( _curLight, shaderContext, "_TILED" ) )
+			{
+				_tiledLights.push_back( _curLight );
+				continue;
+			}
+			if( _sphereInstGeo != 0 && hasLightContextVariant( _curLight, shaderContext, "_INSTANCED" ) )
+			{
+				_instancedLights.push_back( _curLight );
+				continue;
+			}
+		}
 		
 		// Update shadow map
 		if( !noShadows && _curLight->_shadowMapCount > 0 )
@@ -1696,6 +2730,9 @@ void Renderer::drawLightShapes( const string &shaderContext, bool noShadows, int
 
 	_curLight = 0x0;
 
+	if( !_instancedLights.empty() ) drawLightVolumesInstanced( shaderContext, depthBounds );
+	if( !_tiledLights.empty() ) drawTiledLights( shaderContext, tileSize );
+
 	timer->endQuery();
 
 	// Draw occlusion proxies
@@ -1706,18 +2743,383 @@ void Renderer::drawLightShapes( const string &shaderContext, bool noShadows, int
 	}
 }
 
+
+void Renderer::drawLightVolumesInstanced( const string &shaderContext, bool depthBounds )
+{
+	// Group lights that can share one draw call
+	std::sort( _instancedLights.begin(), _instancedLights.end(), []( const LightNode *a, const LightNode *b )
+	{
+		if( a->_materialRes.getPtr() != b->_materialRes.getPtr() ) return a->_materialRes.getPtr() < b->_materialRes.getPtr();
+		if( (a->_fov < 180) != (b->_fov < 180) ) return a->_fov < 180;
+		return a->_lightingContext < b->_lightingContext;
+	} );
+
+	_lightVolumeInsts.resize( LightVolumesPerBatch );
+
+	setupShadowMap( true );
+	setupViewMatrices( _curCamera->getViewMat(), _curCamera->getProjMat() );
+
+	size_t first = 0, count = _instancedLights.size();
+	while( first < count )
+	{
+		LightNode *batchLight = _instancedLights[ first ];
+		bool cone = batchLight->_fov < 180;
+		const string &context = shaderContext.empty() ? batchLight->_lightingContext : shaderContext;
+
+		// Fill instance data
+		uint32 numInsts = 0;
+		for( ; first + numInsts < count && numInsts < LightVolumesPerBatch; ++numInsts )
+		{
+			LightNode *light = _instancedLights[ first + numInsts ];
+			if( light->_materialRes.getPtr() != batchLight->_materialRes.getPtr() || (light->_fov < 180) != cone ||
+			    light->_lightingContext != batchLight->_lightingContext ) break;
+
+			Matrix4f mat;
+			if( cone )
+			{
+				float r = light->_radius * tanf( degToRad( light->_fov / 2 ) );
+				mat = light->_absTrans * Matrix4f::ScaleMat( r, r, light->_radius );
+			}
+			else
+			{
+				mat = Matrix4f::TransMat( light->_absPos.x, light->_absPos.y, light->_absPos.z ) *
+				      Matrix4f::ScaleMat( light->_radius, light->_radius, light->_radius );
+			}
+
+			LightVolumeInstance &inst = _lightVolumeInsts[ numInsts ];
+			memcpy( inst.worldMat, mat.x, sizeof( inst.worldMat ) );
+			inst.lightPos[0] = light->_absPos.x; inst.lightPos[1] = light->_absPos.y;
+			inst.lightPos[2] = light->_absPos.z; inst.lightPos[3] = light->_radius;
+			inst.lightDir[0] = light->_spotDir.x; inst.lightDir[1] = light->_spotDir.y;
+			inst.lightDir[2] = light->_spotDir.z; inst.lightDir[3] = cosf( degToRad( light->_fov / 2.0f ) );
+			Vec3f col = light->_diffuseCol * light->_diffuseColMult;
+			inst.lightColor[0] = col.x; inst.lightColor[1] = col.y;
+			inst.lightColor[2] = col.z; inst.lightColor[3] = 1.0f;
+		}
+		first += numInsts;
+
+		if( !setMaterial( batchLight->_materialRes, context + "_INSTANCED" ) ) continue;
+
+		uint32 geo = cone ? _coneInstGeo : _sphereInstGeo;
+		_renderDevice->updateBufferData( geo, _vbLightVolumeInst, 0, numInsts * sizeof( LightVolumeInstance ),
+		                                 &_lightVolumeInsts[ 0 ] );
+
+		// Back faces of the volumes are drawn; with a valid scene depth buffer, pixels where the
+		// geometry lies behind the volume are rejected before shading
+		_renderDevice->setCullMode( RS_CULL_FRONT );
+		_renderDevice->setDepthTest( depthBounds );
+		_renderDevice->setDepthFunc( DSS_DEPTHFUNC_GREATER_EQUAL );
+
+		_renderDevice->setGeometry( geo );
+		if( cone )
+			_renderDevice->drawIndexedInstanced( PRIM_TRILIST, 0, 22 * 3, 0, 13, numInsts );
+		else
+			_renderDevice->drawIndexedInstanced( PRIM_TRILIST, 0, 128 * 3, 0, 126, numInsts );
+
+		Modules().stats().incStat( EngineStats::LightPassCount, (float)numInsts );
+
+		// Reset
+		_renderDevice->setCullMode( RS_CULL_BACK );
+		_renderDevice->setDepthTest( true );
+		_renderDevice->setDepthFunc( DSS_DEPTHFUNC_LESS_EQUAL );
+	}
+}
+
+
+void Renderer::binTiledLights( uint32 firstLight, uint32 numLights, int tilesX, int tilesY,
+                               float tileScaleX, float tileScaleY )
+{
+	uint32 numTiles = (uint32)(tilesX * tilesY);
+	bool parallel = numLights >= TiledParallelMinLights;
+	Matrix4f viewProjMat = _curCamera->getProjMat() * _curCamera->getViewMat();
+
+	_tiledLightRects.resize( numLights * 4 );
+	_tileLightCounts.resize( numTiles );
+
+	// Light data and covered tiles
+	WorkerPool &workers = Modules::workers();
+	workers.run( numLights, parallel, [&]( uint32 first, uint32 last )
+	{
+		for( uint32 i = first; i < last; ++i )
+		{
+			const LightNode *light = _tiledLights[firstLight + i];
+			
+			float x, y, w, h;
+			light->calcScreenSpaceAABB( viewProjMat, x, y, w, h );
+			int *rect = &_tiledLightRects[i * 4];
+			rect[0] = std::min( (int)(x * tileScaleX), tilesX - 1 );
+			rect[1] = std::min( (int)(y * tileScaleY), tilesY - 1 );
+			rect[2] = std::min( (int)((x + w) * tileScaleX), tilesX - 1 );
+			rect[3] = std::min( (int)((y + h) * tileScaleY), tilesY - 1 );
+
+			float *data = &_tileLightData[i * 12];
+			data[0] = light->_absPos.x; data[1] = light->_absPos.y; data[2] = light->_absPos.z;
+			data[3] = light->_radius;
+			data[4] = light->_spotDir.x; data[5] = light->_spotDir.y; data[6] = light->_spotDir.z;
+			data[7] = cosf( degToRad( light->_fov / 2.0f ) );
+			Vec3f col = light->_diffuseCol * light->_diffuseColMult;
+			data[8] = col.x; data[9] = col.y; data[10] = col.z; data[11] = 1.0f;
+		}
+	} );
+
+	// Count lights per tile, each thread handles a band of tile rows
+	workers.run( (uint32)tilesY, parallel, [&]( uint32 firstRow, uint32 lastRow )
+	{
+		memset( &_tileLightCounts[firstRow * tilesX], 0, (lastRow - firstRow) * tilesX * sizeof( uint32 ) );
+		for( uint32 i = 0; i < numLights; ++i )
+		{
+			const int *rect = &_tiledLightRects[i * 4];
+			int y0 = std::max( rect[1], (int)firstRow ), y1 = std::min( rect[3], (int)lastRow - 1 );
+			for( int y = y0; y <= y1; ++y )
+			{
+				for( int x = rect[0]; x <= rect[2]; ++x ) ++_tileLightCounts[y * tilesX + x];
+			}
+		}
+	} );
+
+	// Tile headers; lists of tiles that don't fit into the largest index texture are cut
+	uint32 capacity = TiledLightTexWidth * TiledIndexTexMaxHeight * 4 - numTiles * 4;
+	uint32 numRefs = 0, maxCount = 0;
+	for( uint32 i = 0; i < numTiles; ++i )
+	{
+		_tileLightCounts[i] = std::min( _tileLightCounts[i], capacity - numRefs );
+		numRefs += _tileLightCounts[i];
+		maxCount = std::max( maxCount, _tileLightCounts[i] );
+	}
+
+	int height = std::max( _tileIndexTexHeight, 16 );
+	while( (uint32)(height * TiledLightTexWidth) < numTiles + (numRefs + 3) / 4 ) height *= 2;
+	if( height != _tileIndexTexHeight )
+	{
+		if( _tileIndexTex ) _renderDevice->destroyTexture( _tileIndexTex );
+		_tileIndexTex = _renderDevice->createTexture( TextureTypes::Tex2D, TiledLightTexWidth, height, 1,
+		                                              TextureFormats::RGBA32F, 0, false, false, false );
+		_tileIndexTexHeight = height;
+		_tileIndexData.resize( TiledLightTexWidth * height * 4 );
+	}
+
+	uint32 slot = numTiles * 4;
+	for( uint32 i = 0; i < numTiles; ++i )
+	{
+		_tileIndexData[i * 4] = (float)slot;
+		_tileIndexData[i * 4 + 1] = (float)_tileLightCounts[i];
+		_tileIndexData[i * 4 + 2] = 0;  // Used as fill counter below
+		slot += _tileLightCounts[i];
+	}
+
+	// Light indices, written in light order so that the result does not depend on the thread count
+	workers.run( (uint32)tilesY, parallel, [&]( uint32 firstRow, uint32 lastRow )
+	{
+		for( uint32 i = 0; i < numLights; ++i )
+		{
+			const int *rect = &_tiledLightRects[i * 4];
+			int y0 = std::max( rect[1], (int)firstRow ), y1 = std::min( rect[3], (int)lastRow - 1 );
+			for( int y = y0; y <= y1; ++y )
+			{
+				for( int x = rect[0]; x <= rect[2]; ++x )
+				{
+					float *header = &_tileIndexData[(y * tilesX + x) * 4];
+					if( header[2] < header[1] )
+					{
+						_tileIndexData[(uint32)header[0] + (uint32)header[2]] = (float)i;
+						header[2] += 1.0f;
+					}
+				}
+			}
+		}
+	} );
+
+	Modules::stats().incStat( EngineStats::TileCount, (float)numTiles );
+	Modules::stats().incStat( EngineStats::TileLightRefs, (float)numRefs );
+	Modules::stats().incStat( EngineStats::TileMaxLights, (float)maxCount );
+}
+
+
+void Renderer::drawTiledLights( const string &shaderContext, int tileSize )
+{
+	if( _tileLightTex == 0 )
+	{
+		_tileLightTex = _renderDevice->createTexture( TextureTypes::Tex2D, TiledLightTexWidth,
+			TiledLightsMax * 3 / TiledLightTexWidth, 1, TextureFormats::RGBA32F, 0, false, false, false );
+		_tileLightData.resize( TiledLightsMax * 12 );
+	}
+
+	// Tiles cover the viewport, light rectangles are in normalized viewport coordinates
+	int vpWidth = _renderDevice->_vpWidth, vpHeight = _renderDevice->_vpHeight;
+	int tilesX = (vpWidth + tileSize - 1) / tileSize;
+	int tilesY = (vpHeight + tileSize - 1) / tileSize;
+	if( tilesX <= 0 || tilesY <= 0 ) return;
+	float tileScaleX = (float)vpWidth / tileSize;
+	float tileScaleY = (float)vpHeight / tileSize;
+
+	// Lights with the same material and context share one fullscreen pass
+	std::sort( _tiledLights.begin(), _tiledLights.end(), []( const LightNode *a, const LightNode *b )
+	{
+		if( a->_materialRes.getPtr() != b->_materialRes.getPtr() ) return a->_materialRes.getPtr() < b->_materialRes.getPtr();
+		return a->_lightingContext < b->_lightingContext;
+	} );
+
+	uint32 sampState = SS_FILTER_POINT | SS_ANISO1 | SS_ADDR_CLAMP;
+	size_t first = 0, count = _tiledLights.size();
+	while( first < count )
+	{
+		LightNode *groupLight = _tiledLights[first];
+		size_t numLights = 1;
+		while( first + numLights < count &&
+		       _tiledLights[first + numLights]->_materialRes.getPtr() == groupLight->_materialRes.getPtr() &&
+		       _tiledLights[first + numLights]->_lightingContext == groupLight->_lightingContext ) ++numLights;
+		
+		binTiledLights( (uint32)first, (uint32)numLights, tilesX, tilesY, tileScaleX, tileScaleY );
+		first += numLights;
+
+		_renderDevice->updateTextureData( _tileLightTex, 0, 0, &_tileLightData[0] );
+		_renderDevice->updateTextureData( _tileIndexTex, 0, 0, &_tileIndexData[0] );
+
+		const string &context = shaderContext.empty() ? groupLight->_lightingContext : shaderContext;
+
+		setupShadowMap( true );
+		setupViewMatrices( _curCamera->getViewMat(), Matrix4f::OrthoMat( 0, _viewportScale, 0, _viewportScale, -1, 1 ) );
+		if( !setMaterial( groupLight->_materialRes, context + "_TILED" ) ) continue;
+
+		_renderDevice->setTexture( 13, _tileLightTex, sampState, TextureUsage::Texture );
+		_renderDevice->setTexture( 14, _tileIndexTex, sampState, TextureUsage::Texture );
+
+		if( _curShader->uniLocs[ _uni.tileParams ] >= 0 )
+		{
+			float data[4] = { tileScaleX / _viewportScale, tileScaleY / _viewportScale, (float)tilesX, (float)TiledLightTexWidth };
+			_renderDevice->setShaderConst( _curShader->uniLocs[ _uni.tileParams ], CONST_FLOAT4, data );
+		}
+
+		_renderDevice->setGeometry( _FSPolyGeo );
+		_renderDevice->draw( PRIM_TRILIST, 0, 3 );
+
+		Modules().stats().incStat( EngineStats::LightPassCount, 1 );
+		Modules().stats().incStat( EngineStats::TiledLightCount, (float)numLights );
+	}
+}
+
+
 void Renderer::dispatchCompute( MaterialResource *materialRes, const std::string &context, uint32 groups_x, uint32 groups_y, uint32 groups_z )
 {
+	// Buffer accesses of dispatches issued by the application are unknown
+	dispatchComputeCommand( materialRes, context, groups_x, groups_y, groups_z, 0x0, 0, 0x0, -1, -1 );
+}
+
+
+void Renderer::markBufferWritten( uint32 bufObj )
+{
+	if( bufObj == 0 ) return;
+
+	const uint32 allBarriers = VertexBufferBarrier | IndexBufferBarrier | StorageBufferBarrier |
+	                           IndirectBufferBarrier | BufferUpdateBarrier;
+
+	for( size_t i = 0; i < _pendingBufferWrites.size(); ++i )
+	{
+		if( _pendingBufferWrites[i].bufObj == bufObj )
+		{
+			_pendingBufferWrites[i].barriers = allBarriers;
+			return;
+		}
+	}
+
+	PendingBufferWrite write;
+	write.bufObj = bufObj;
+	write.barriers = allBarriers;
+	_pendingBufferWrites.push_back( write );
+}
+
+
+void Renderer::syncBufferAccess( uint32 bufObj, uint32 barriers, bool immediate )
+{
+	uint32 required = 0;
+	for( size_t i = 0; i < _pendingBufferWrites.size(); ++i )
+	{
+		if( _pendingBufferWrites[i].bufObj == bufObj )
+		{
+			required = _pendingBufferWrites[i].barriers & barriers;
+			break;
+		}
+	}
+	if( required == 0 ) return;
+
+	_renderDevice->setMemoryBarrier( required );
+	if( immediate ) _renderDevice->commitMemoryBarriers();
+
+	// A barrier makes all previous writes visible for its kind of access, not only those to bufObj
+	for( size_t i = 0; i < _pendingBufferWrites.size(); )
+	{
+		_pendingBufferWrites[i].barriers &= ~required;
+		if( _pendingBufferWrites[i].barriers == 0 )
+		{
+			_pendingBufferWrites[i] = _pendingBufferWrites.back();
+			_pendingBufferWrites.pop_back();
+		}
+		else ++i;
+	}
+}
+
+
+void Renderer::dispatchComputeCommand( Resource *matRes, const std::string &context, uint32 groupsX, uint32 groupsY,
+                                       uint32 groupsZ, Resource *indirectBuf, uint32 indirectOffset,
+                                       const PipeCmdParam *bufParams, int numReads, int numWrites )
+{
+	if( matRes == 0x0 || matRes->getType() != ResourceTypes::Material ) return;
+	MaterialResource *materialRes = (MaterialResource *)matRes;
+
+	ComputeBufferResource *argsBuf = 0x0;
+	if( indirectBuf != 0x0 && indirectBuf->getType() == ResourceTypes::ComputeBuffer )
+	{
+		argsBuf = (ComputeBufferResource *)indirectBuf;
+		if( !_renderDevice->getCaps().indirectDraws || argsBuf->getBufferObject() == 0 ) return;
+	}
+
 	if ( !setMaterial( materialRes, context ) ) return;
 
-	ShaderCombination *curShader = Modules::renderer().getCurShader();
+	// Without declarations every buffer of the material is treated as read and written
+	if( numReads < 0 )
+	{
+		for( size_t i = 0; i < materialRes->_buffers.size(); ++i )
+		{
+			ComputeBufferResource *buf = materialRes->_buffers[i].compBufRes;
+			if( buf != 0x0 ) syncBufferAccess( buf->getBufferObject(), StorageBufferBarrier );
+		}
+	}
+	else
+	{
+		for( int i = 0; i < numReads + numWrites; ++i )
+		{
+			Resource *res = bufParams[i].getResource();
+			if( res != 0x0 ) syncBufferAccess( ((ComputeBufferResource *)res)->getBufferObject(), StorageBufferBarrier );
+		}
+	}
+	if( argsBuf != 0x0 ) syncBufferAccess( argsBuf->getBufferObject(), IndirectBufferBarrier );
 
 	GPUTimer *timer = Modules::stats().getGPUTimer( EngineStats::ComputeGPUTime );
 	if ( Modules::config().gatherTimeStats ) timer->beginQuery( Modules::renderer().getFrameID() );
 
-	_renderDevice->runComputeShader( curShader->shaderObj, groups_x, groups_y, groups_z );
+	if( argsBuf != 0x0 )
+		_renderDevice->runComputeShaderIndirect( _curShader->shaderObj, argsBuf->getBufferObject(), indirectOffset );
+	else
+		_renderDevice->runComputeShader( _curShader->shaderObj, groupsX, groupsY, groupsZ );
 
 	timer->endQuery();
+
+	if( numWrites < 0 )
+	{
+		for( size_t i = 0; i < materialRes->_buffers.size(); ++i )
+		{
+			ComputeBufferResource *buf = materialRes->_buffers[i].compBufRes;
+			if( buf != 0x0 ) markBufferWritten( buf->getBufferObject() );
+		}
+	}
+	else
+	{
+		for( int i = numReads; i < numReads + numWrites; ++i )
+		{
+			Resource *res = bufParams[i].getResource();
+			if( res != 0x0 ) markBufferWritten( ((ComputeBufferResource *)res)->getBufferObject() );
+		}
+	}
 }
 
 // =================================================================================================
@@ -1781,28 +3183,36 @@ void Renderer::drawMeshes( uint32 firstItem, uint32 lastItem, const std::string
 	RenderDeviceInterface *rdi = Modules::renderer().getRenderDevice();
 
 	const RenderQueue &renderQueue = Modules::sceneMan().getRenderQueue();
+	RenderSnapshot &snapshot = Modules::renderer()._snapshot;
 	GeometryResource *curGeoRes = 0x0;
+	uint32 curGeoObj = 0;
 	MaterialResource *curMatRes = 0x0;
 
 	DefaultShaderUniforms &uni = Modules::renderer()._uni;
+	
+	// A recent depth pyramid replaces the hardware queries of the occlusion set
+	const bool useOccPyramid = occSet >= 0 && Modules::renderer().usesOcclusionPyramid( occSet );
 
 	// Loop over mesh queue
 	for( size_t i = firstItem; i <= lastItem; ++i )
 	{
-		MeshNode *meshNode = (MeshNode *)renderQueue[i].node;
-		ModelNode *modelNode = meshNode->getParentModel();
+		SnapshotNode &mesh = snapshot.nodes[ renderQueue[i].dataIndex ];
+		SnapshotModel &model = snapshot.models[ mesh.modelIndex ];
+		SceneNode *meshNode = mesh.node;
 		
 		// Check that mesh is valid
-		if( modelNode->getGeometryResource() == 0x0 )
-			continue;
-		if( meshNode->getBatchStart() + meshNode->getBatchCount() > modelNode->getGeometryResource()->_indexCount )
+		if( mesh.geoRes == 0x0 )
 			continue;
 		
 		bool modelChanged = true;
 		uint32 queryObj = 0;
 
 		// Occlusion culling
-		if( occSet >= 0 )
+		if( useOccPyramid )
+		{
+			if( Modules::renderer().isOccludedByPyramid( meshNode, occSet ) ) continue;
+		}
+		else if( occSet >= 0 )
 		{
 			if( occSet > (int)meshNode->_occQueries.size() - 1 )
 			{
@@ -1822,11 +3232,10 @@ void Renderer::drawMeshes( uint32 firstItem, uint32 lastItem, const std::string
 					meshNode->_occQueriesLastVisited[occSet] = Modules::renderer().getFrameID();
 				
 					// Check query result (viewer must be outside of bounding box)
-					if( nearestDistToAABB( frust1->getOrigin(), meshNode->getBBox().min,
-					                       meshNode->getBBox().max ) > 0 &&
+					if( nearestDistToAABB( frust1->getOrigin(), mesh.bBox.min, mesh.bBox.max ) > 0 &&
 						rdi->getQueryResult( meshNode->_occQueries[occSet] ) < 1 )
 					{
-						Modules::renderer().pushOccProxy( 0, meshNode->getBBox().min, meshNode->getBBox().max,
+						Modules::renderer().pushOccProxy( 0, mesh.bBox.min, mesh.bBox.max,
 						                                  meshNode->_occQueries[occSet] );
 						continue;
 					}
@@ -1836,30 +3245,34 @@ void Renderer::drawMeshes( uint32 firstItem, uint32 lastItem, const std::string
 			}
 		}
 		
-		// Bind geometry
-		if( curGeoRes != modelNode->getGeometryResource() )
+		// Bind geometry, resources in the shared arena only differ by their base vertex
+		if( curGeoRes != mesh.geoRes )
 		{
-			curGeoRes = modelNode->getGeometryResource();
-			ASSERT( curGeoRes != 0x0 );
+			curGeoRes = mesh.geoRes;
 		
-			rdi->setGeometry( curGeoRes->getGeometryInfo() );
+			if( curGeoObj != curGeoRes->getGeometryInfo() )
+			{
+				curGeoObj = curGeoRes->getGeometryInfo();
+				rdi->setGeometry( curGeoObj );
+			}
 		}
 
 		ShaderCombination *prevShader = Modules::renderer().getCurShader();
 
 		if( !debugView )
 		{
-			if( !meshNode->getMaterialRes()->isOfClass( theClass ) ) continue;
+			if( !mesh.materialRes->isOfClass( theClass ) ) continue;
 			
-			// Set material
-			if( curMatRes != meshNode->getMaterialRes() )
+			// Set material, variants that only use other textures just select their range of the texture table
+			if( curMatRes != mesh.materialRes )
 			{
-				if( !Modules::renderer().setMaterial( meshNode->getMaterialRes(), shaderContext ) )
+				if( !Modules::renderer().switchMaterialTextures( curMatRes, mesh.materialRes ) &&
+				    !Modules::renderer().setMaterial( mesh.materialRes, shaderContext ) )
 				{	
 					curMatRes = 0x0;
 					continue;
 				}
-				curMatRes = meshNode->getMaterialRes();
+				curMatRes = mesh.materialRes;
 			}
 		}
 		else
@@ -1867,7 +3280,7 @@ void Renderer::drawMeshes( uint32 firstItem, uint32 lastItem, const std::string
 			Modules::renderer().setShaderComb( &Modules::renderer()._defColorShader );
 			Modules::renderer().commitGeneralUniforms();
 			
-			uint32 curLod = meshNode->getLodLevel();
+			uint32 curLod = mesh.lodLevel;
 			Vec4f color;
 			if( curLod == 0 ) color = Vec4f( 0.5f, 0.75f, 1, 1 );
 			else if( curLod == 1 ) color = Vec4f( 0.25f, 0.75, 0.75f, 1 );
@@ -1876,7 +3289,7 @@ void Renderer::drawMeshes( uint32 firstItem, uint32 lastItem, const std::string
 			else color = Vec4f( 0.75f, 0.5, 0.25f, 1 );
 
 			// Darken models with skeleton so that bones are more noticeable
-			if( !modelNode->_jointList.empty() ) color = color * 0.3f;
+			if( model.hasJoints ) color = color * 0.3f;
 
 			rdi->setShaderConst( Modules::renderer()._defColShader_color, CONST_FLOAT4, &color.x );
 		}
@@ -1886,13 +3299,13 @@ void Renderer::drawMeshes( uint32 firstItem, uint32 lastItem, const std::string
 		if( modelChanged || curShader != prevShader )
 		{
 			// Skeleton
-			if( curShader->uniLocs[ uni.skinMatRows ] >= 0 && !modelNode->_skinMatRows.empty() )
+			if( curShader->uniLocs[ uni.skinMatRows ] >= 0 && model.skinRowCount > 0 )
 			{
 				// Note:	OpenGL 2.1 supports mat4x3 but it is internally realized as mat4 on most
 				//			hardware so it would require 4 instead of 3 uniform slots per joint
 				
 				rdi->setShaderConst( curShader->uniLocs[ uni.skinMatRows ], CONST_FLOAT4,
-				                      &modelNode->_skinMatRows[0], (int)modelNode->_skinMatRows.size() );
+				                      &snapshot.skinMatRows[model.firstSkinRow], (int)model.skinRowCount );
 			}
 
 			modelChanged = false;
@@ -1901,12 +3314,12 @@ void Renderer::drawMeshes( uint32 firstItem, uint32 lastItem, const std::string
 		// World transformation
 		if( curShader->uniLocs[ uni.worldMat ] >= 0 )
 		{
-			rdi->setShaderConst( curShader->uniLocs[ uni.worldMat ], CONST_FLOAT44, &meshNode->_absTrans.x[0] );
+			rdi->setShaderConst( curShader->uniLocs[ uni.worldMat ], CONST_FLOAT44, &mesh.absTrans.x[0] );
 		}
 		if( curShader->uniLocs[ uni.worldNormalMat ] >= 0 )
 		{
 			// TODO: Optimize this
-			Matrix4f normalMat4 = meshNode->_absTrans.inverted().transposed();
+			Matrix4f normalMat4 = mesh.absTrans.inverted().transposed();
 			float normalMat[9] = { normalMat4.x[0], normalMat4.x[1], normalMat4.x[2],
 			                       normalMat4.x[4], normalMat4.x[5], normalMat4.x[6],
 			                       normalMat4.x[8], normalMat4.x[9], normalMat4.x[10] };
@@ -1914,23 +3327,56 @@ void Renderer::drawMeshes( uint32 firstItem, uint32 lastItem, const std::string
 		}
 		if( curShader->uniLocs[ uni.nodeId ] >= 0 )
 		{
-			float id = (float)meshNode->getHandle();
+			float id = (float)mesh.handle;
 			rdi->setShaderConst( curShader->uniLocs[ uni.nodeId ], CONST_FLOAT, &id );
 		}
 		if( curShader->uniLocs[ uni.customInstData ] >= 0 )
 		{
 			rdi->setShaderConst( curShader->uniLocs[ uni.customInstData ], CONST_FLOAT4,
-			                      &modelNode->_customInstData[0].x, ModelCustomVecCount );
+			                      &model.customInstData[0].x, ModelCustomVecCount );
+		}
+		if( curShader->uniLocs[ uni.shadowCascadeFirst ] >= 0 )
+		{
+			float first = (float)renderQueue[i].cascadeFirst;
+			rdi->setShaderConst( curShader->uniLocs[ uni.shadowCascadeFirst ], CONST_FLOAT, &first );
 		}
 
 		if( queryObj )
 			rdi->beginQuery( queryObj );
 		
-		// Render
-		rdi->drawIndexed( meshNode->getPrimType(), meshNode->getBatchStart(), meshNode->getBatchCount(),
-		                  meshNode->getVertRStart(), meshNode->getVertREnd() - meshNode->getVertRStart() + 1 );
+		// Render, shadow casters are instanced once per overlapped cascade
+		uint32 numInstances = renderQueue[i].cascadeCount;
+		if( numInstances > 1 )
+		{
+			if( curGeoRes->getBaseVertex() > 0 )
+			{
+				rdi->drawIndexedInstancedBaseVertex( mesh.primType, curGeoRes->getFirstIndex() + mesh.batchStart,
+				                                     mesh.batchIndexCount, mesh.vertRStart,
+				                                     mesh.vertREnd - mesh.vertRStart + 1, numInstances,
+				                                     curGeoRes->getBaseVertex() );
+			}
+			else
+			{
+				rdi->drawIndexedInstanced( mesh.primType, curGeoRes->getFirstIndex() + mesh.batchStart,
+				                           mesh.batchIndexCount, mesh.vertRStart,
+				                           mesh.vertREnd - mesh.vertRStart + 1, numInstances );
+			}
+		}
+		else if( curGeoRes->getBaseVertex() > 0 )
+		{
+			rdi->drawIndexedBaseVertex( mesh.primType, curGeoRes->getFirstIndex() + mesh.batchStart,
+			                            mesh.batchIndexCount, mesh.vertRStart,
+			                            mesh.vertREnd - mesh.vertRStart + 1, curGeoRes->getBaseVertex() );
+		}
+		else
+		{
+			rdi->drawIndexed( mesh.primType, curGeoRes->getFirstIndex() + mesh.batchStart,
+			                  mesh.batchIndexCount, mesh.vertRStart,
+			                  mesh.vertREnd - mesh.vertRStart + 1 );
+		}
 		Modules::stats().incStat( EngineStats::BatchCount, 1 );
-		Modules::stats().incStat( EngineStats::TriCount, meshNode->getBatchCount() / 3.0f );
+		Modules::stats().incStat( EngineStats::TriCount, mesh.batchIndexCount / 3.0f * std::max( numInstances, 1u ) );
+		if( numInstances > 1 ) Modules::stats().incStat( EngineStats::CascadeBatchCount, 1 );
 
 		if( queryObj )
 			rdi->endQuery( queryObj );
@@ -1952,6 +3398,7 @@ void Renderer::drawParticles( uint32 firstItem, uint32 lastItem, const std::stri
 	RenderDeviceInterface *rdi = Modules::renderer().getRenderDevice();
 
 	const RenderQueue &renderQueue = Modules::sceneMan().getRenderQueue();
+	RenderSnapshot &snapshot = Modules::renderer()._snapshot;
 	MaterialResource *curMatRes = 0x0;
 
 	GPUTimer *timer = Modules::stats().getGPUTimer( EngineStats::ParticleGPUTime );
@@ -1962,18 +3409,24 @@ void Renderer::drawParticles( uint32 firstItem, uint32 lastItem, const std::stri
 	ASSERT( QuadIndexBufCount >= ParticlesPerBatch * 6 );
 
 	DefaultShaderUniforms &uni = Modules::renderer()._uni;
+	const bool useOccPyramid = occSet >= 0 && Modules::renderer().usesOcclusionPyramid( occSet );
 
 	// Loop through emitter queue
 	for( uint32 i = firstItem; i <= lastItem; ++i )
 	{
-		EmitterNode *emitter = (EmitterNode *)renderQueue[i].node;
+		const SnapshotNode &data = snapshot.nodes[ renderQueue[i].dataIndex ];
+		SceneNode *emitter = data.node;
 		
-		if( emitter->_particleCount == 0 ) continue;
-		if( !emitter->_materialRes->isOfClass( theClass ) ) continue;
+		if( data.elementsCount == 0 ) continue;
+		if( !data.materialRes->isOfClass( theClass ) ) continue;
 		
 		// Occlusion culling
 		uint32 queryObj = 0;
-		if( occSet >= 0 )
+		if( useOccPyramid )
+		{
+			if( Modules::renderer().isOccludedByPyramid( emitter, occSet ) ) continue;
+		}
+		else if( occSet >= 0 )
 		{
 			if( occSet > (int)emitter->_occQueries.size() - 1 )
 			{
@@ -1993,12 +3446,11 @@ void Renderer::drawParticles( uint32 firstItem, uint32 lastItem, const std::stri
 					emitter->_occQueriesLastVisited[occSet] = Modules::renderer().getFrameID();
 				
 					// Check query result (viewer must be outside of bounding box)
-					if( nearestDistToAABB( frust1->getOrigin(), emitter->getBBox().min,
-					                       emitter->getBBox().max ) > 0 &&
+					if( nearestDistToAABB( frust1->getOrigin(), data.bBox.min, data.bBox.max ) > 0 &&
 						rdi->getQueryResult( emitter->_occQueries[occSet] ) < 1 )
 					{
-						Modules::renderer().pushOccProxy( 0, emitter->getBBox().min,
-							emitter->getBBox().max, emitter->_occQueries[occSet] );
+						Modules::renderer().pushOccProxy( 0, data.bBox.min,
+							data.bBox.max, emitter->_occQueries[occSet] );
 						continue;
 					}
 					else
@@ -2008,10 +3460,10 @@ void Renderer::drawParticles( uint32 firstItem, uint32 lastItem, const std::stri
 		}
 		
 		// Set material
-		if( curMatRes != emitter->_materialRes )
+		if( curMatRes != data.materialRes )
 		{
-			if( !Modules::renderer().setMaterial( emitter->_materialRes, shaderContext ) ) continue;
-			curMatRes = emitter->_materialRes;
+			if( !Modules::renderer().setMaterial( data.materialRes, shaderContext ) ) continue;
+			curMatRes = data.materialRes;
 		}
 
 		if( queryObj )
@@ -2021,74 +3473,28 @@ void Renderer::drawParticles( uint32 firstItem, uint32 lastItem, const std::stri
 		ShaderCombination *curShader = Modules::renderer().getCurShader();
 		if( curShader->uniLocs[ uni.nodeId ] >= 0 )
 		{
-			float id = (float)emitter->getHandle();
+			float id = (float)data.handle;
 			rdi->setShaderConst( curShader->uniLocs[ uni.nodeId ], CONST_FLOAT, &id );
 		}
 
-		// Divide particles in batches and render them
-		for( uint32 j = 0; j < emitter->_particleCount / ParticlesPerBatch; ++j )
+		// Render batches, those without living particles were already dropped during extraction
+		for( uint32 j = data.firstBatch; j < data.firstBatch + data.batchCount; ++j )
 		{
-			// Check if batch needs to be rendered
-			bool allDead = true;
-			for( uint32 k = 0; k < ParticlesPerBatch; ++k )
-			{
-				if( emitter->_particles[j*ParticlesPerBatch + k].life > 0 )
-				{
-					allDead = false;
-					break;
-				}
-			}
-			if( allDead ) continue;
-
-			// Render batch
+			const SnapshotParticleBatch &batch = snapshot.particleBatches[j];
+			
 			if( curShader->uniLocs[ uni.parPosArray ] >= 0 )
 				rdi->setShaderConst( curShader->uniLocs[ uni.parPosArray ], CONST_FLOAT3,
-				                      (float *)emitter->_parPositions + j*ParticlesPerBatch*3, ParticlesPerBatch );
+				                      &snapshot.parPositions[batch.firstParticle * 3], batch.count );
 			if( curShader->uniLocs[ uni.parSizeAndRotArray ] >= 0 )
 				rdi->setShaderConst( curShader->uniLocs[ uni.parSizeAndRotArray ], CONST_FLOAT2,
-				                      (float *)emitter->_parSizesANDRotations + j*ParticlesPerBatch*2, ParticlesPerBatch );
+				                      &snapshot.parSizesAndRotations[batch.firstParticle * 2], batch.count );
 			if( curShader->uniLocs[ uni.parColorArray ] >= 0 )
 				rdi->setShaderConst( curShader->uniLocs[ uni.parColorArray ], CONST_FLOAT4,
-				                      (float *)emitter->_parColors + j*ParticlesPerBatch*4, ParticlesPerBatch );
+				                      &snapshot.parColors[batch.firstParticle * 4], batch.count );
 
-			rdi->drawIndexed( PRIM_TRILIST, 0, ParticlesPerBatch * 6, 0, ParticlesPerBatch * 4 );
+			rdi->drawIndexed( PRIM_TRILIST, 0, batch.count * 6, 0, batch.count * 4 );
 			Modules::stats().incStat( EngineStats::BatchCount, 1 );
-			Modules::stats().incStat( EngineStats::TriCount, ParticlesPerBatch * 2.0f );
-		}
-
-		uint32 count = emitter->_particleCount % ParticlesPerBatch;
-		if( count > 0 )
-		{
-			uint32 offset = (emitter->_particleCount / ParticlesPerBatch) * ParticlesPerBatch;
-			
-			// Check if batch needs to be rendered
-			bool allDead = true;
-			for( uint32 k = 0; k < count; ++k )
-			{
-				if( emitter->_particles[offset + k].life > 0 )
-				{
-					allDead = false;
-					break;
-				}
-			}
-			
-			if( !allDead )
-			{
-				// Render batch
-				if( curShader->uniLocs[ uni.parPosArray ] >= 0 )
-					rdi->setShaderConst( curShader->uniLocs[ uni.parPosArray ], CONST_FLOAT3,
-					                      (float *)emitter->_parPositions + offset*3, count );
-				if( curShader->uniLocs[ uni.parSizeAndRotArray ] >= 0 )
-					rdi->setShaderConst( curShader->uniLocs[ uni.parSizeAndRotArray ], CONST_FLOAT2,
-					                      (float *)emitter->_parSizesANDRotations + offset*2, count );
-				if( curShader->uniLocs[ uni.parColorArray ] >= 0 )
-					rdi->setShaderConst( curShader->uniLocs[ uni.parColorArray ], CONST_FLOAT4,
-					                      (float *)emitter->_parColors + offset*4, count );
-				
-				rdi->drawIndexed( PRIM_TRILIST, 0, count * 6, 0, count * 4 );
-				Modules::stats().incStat( EngineStats::BatchCount, 1 );
-				Modules::stats().incStat( EngineStats::TriCount, count * 2.0f );
-			}
+			Modules::stats().incStat( EngineStats::TriCount, batch.count * 2.0f );
 		}
 
 		if( queryObj )
@@ -2113,6 +3519,7 @@ void Renderer::drawComputeResults( uint32 firstItem, uint32 lastItem, const std:
 	if ( !rdi->getCaps().computeShaders ) return; 
 
 	const RenderQueue &renderQueue = Modules::sceneMan().getRenderQueue();
+	RenderSnapshot &snapshot = Modules::renderer()._snapshot;
 
 	MaterialResource *curMatRes = 0;
 	ShaderCombination *curShader = 0;
@@ -2125,11 +3532,15 @@ void Renderer::drawComputeResults( uint32 firstItem, uint32 lastItem, const std:
 	// Loop over compute node queue
 	for ( size_t i = firstItem; i <= lastItem; ++i )
 	{
-		ComputeNode *compNode = ( ComputeNode * ) renderQueue[ i ].node;
+		SnapshotNode &compNode = snapshot.nodes[ renderQueue[ i ].dataIndex ];
+
+		// Draw arguments are taken from a buffer if the device can source them from there
+		ComputeBufferResource *argsBuf = compNode.indirectBufferRes;
+		if ( argsBuf != 0x0 && ( !rdi->getCaps().indirectDraws || argsBuf->getBufferObject() == 0 ) ) argsBuf = 0x0;
 
 		// Sanity check
-		if ( !compNode->_compBufferRes->_useAsVertexBuf || !compNode->_compBufferRes->_geometryParamsSet || 
-			 compNode->_elementsCount == 0 || !compNode->_materialRes->isOfClass( theClass ) )
+		if ( !compNode.compBufferRes->_useAsVertexBuf || !compNode.compBufferRes->_geometryParamsSet || 
+			 ( compNode.elementsCount == 0 && argsBuf == 0x0 ) || !compNode.materialRes->isOfClass( theClass ) )
 			continue;
 
 		if ( debugView )
@@ -2141,14 +3552,14 @@ void Renderer::drawComputeResults( uint32 firstItem, uint32 lastItem, const std:
 			Vec4f color = Vec4f( 1.f, 1.f, 1.f, 1 );
 			rdi->setShaderConst( Modules::renderer()._defColShader_color, CONST_FLOAT4, &color.x );
 
-			Modules::renderer().drawAABB( compNode->_bBox.min, compNode->_bBox.max );
+			Modules::renderer().drawAABB( compNode.bBox.min, compNode.bBox.max );
 
 			continue;
 		}
 
 		// Specify drawing type
 		RDIPrimType drawType;
-		switch ( compNode->_drawType )
+		switch ( compNode.drawType )
 		{
 			case 0: // Triangles
 				drawType = PRIM_TRILIST;
@@ -2168,14 +3579,14 @@ void Renderer::drawComputeResults( uint32 firstItem, uint32 lastItem, const std:
 		}
 
 		// Set material
-		if ( curMatRes != compNode->_materialRes )
+		if ( curMatRes != compNode.materialRes )
 		{
-			if ( !Modules::renderer().setMaterial( compNode->_materialRes, shaderContext ) ) continue;
-			curMatRes = compNode->_materialRes;
+			if ( !Modules::renderer().setMaterial( compNode.materialRes, shaderContext ) ) continue;
+			curMatRes = compNode.materialRes;
 		}
 
 		// Set compute buffer to act like vertex buffer
-		rdi->setGeometry( compNode->_compBufferRes->_geoID );
+		rdi->setGeometry( compNode.compBufferRes->_geoID );
 
 		curShader = Modules::renderer().getCurShader();
 
@@ -2183,21 +3594,29 @@ void Renderer::drawComputeResults( uint32 firstItem, uint32 lastItem, const std:
 		// World transformation
 		if ( curShader->uniLocs[ uni.worldMat ] >= 0 )
 		{
-			rdi->setShaderConst( curShader->uniLocs[ uni.worldMat ], CONST_FLOAT44, &compNode->_absTrans.x[ 0 ] );
+			rdi->setShaderConst( curShader->uniLocs[ uni.worldMat ], CONST_FLOAT44, &compNode.absTrans.x[ 0 ] );
 		}
 		if ( curShader->uniLocs[ uni.nodeId ] >= 0 )
 		{
-			float id = ( float ) compNode->getHandle();
+			float id = ( float ) compNode.handle;
 			rdi->setShaderConst( curShader->uniLocs[ uni.nodeId ], CONST_FLOAT, &id );
 		}
 		
-		// Wait for completion of compute operation (writing to buffer)
-		rdi->setMemoryBarrier( VertexBufferBarrier );
+		// Wait for completion of compute operations that wrote to the buffers
+		Modules::renderer().syncBufferAccess( compNode.compBufferRes->getBufferObject(), VertexBufferBarrier );
 
 		// Render
-		rdi->draw( drawType, 0, compNode->_elementsCount );
+		if ( argsBuf != 0x0 )
+		{
+			Modules::renderer().syncBufferAccess( argsBuf->getBufferObject(), IndirectBufferBarrier );
+			rdi->drawIndirect( drawType, argsBuf->getBufferObject(), compNode.indirectOffset );
+		}
+		else
+		{
+			rdi->draw( drawType, compNode.elementsStart, compNode.elementsCount );
+			Modules::stats().incStat( EngineStats::TriCount, ( float ) compNode.elementsCount );
+		}
 		Modules::stats().incStat( EngineStats::BatchCount, 1 );
-		Modules::stats().incStat( EngineStats::TriCount, ( float ) compNode->_elementsCount );
 	}
 
 	timer->endQuery();
@@ -2207,6 +3626,56 @@ void Renderer::drawComputeResults( uint32 firstItem, uint32 lastItem, const std:
 // Main Rendering Functions
 // =================================================================================================
 
+void Renderer::updateDynamicResolution( PipelineResource *pipeRes )
+{
+	float targetTime = Modules::config().dynResTargetTime;
+	if( targetTime <= 0 )
+	{
+		pipeRes->_dynResScale = 1.0f;
+		Modules::stats().incStat( EngineStats::DynResScale, pipeRes->_dynResScale );
+		return;
+	}
+
+	// Adjust only once per frame when pipeline is used by several cameras
+	if( pipeRes->_dynResFrame == _frameID ) return;
+	pipeRes->_dynResFrame = _frameID;
+
+	// No time is available while the queries of the last frame are still in flight
+	float gpuTime = Modules::stats().getGPUTimer( EngineStats::FrameGPUTime )->getTimeMS();
+	if( gpuTime > 0 && (gpuTime > targetTime || gpuTime < targetTime * 0.85f) )
+	{
+		// GPU time is dominated by the number of shaded pixels which grows with the square of the scale;
+		// aim for the middle of the tolerance band and damp the step to avoid oscillation
+		float scale = pipeRes->_dynResScale;
+		float targetScale = scale * sqrtf( targetTime * 0.925f / gpuTime );
+		scale += (targetScale - scale) * 0.5f;
+		pipeRes->_dynResScale = clamp( scale, Modules::config().dynResMinScale, 1.0f );
+	}
+	else if( pipeRes->_dynResScale < Modules::config().dynResMinScale )
+	{
+		pipeRes->_dynResScale = Modules::config().dynResMinScale;
+	}
+
+	Modules::stats().incStat( EngineStats::DynResScale, pipeRes->_dynResScale );
+}
+
+
+void Renderer::prepareRender( CameraNode *camNode )
+{
+	_curCamera = camNode;
+	if( _curCamera == 0x0 ) return;
+
+	// Perform culling
+	prepareRenderViews();
+
+	// Copy render data of culled nodes, drawing does not access them anymore
+	extractRenderData();
+
+	// Merge shadow casters of cascades, uses the extracted data
+	prepareShadowCascades();
+}
+
+
 void Renderer::render( CameraNode *camNode )
 {
 	_curCamera = camNode;
@@ -2221,9 +3690,12 @@ void Renderer::render( CameraNode *camNode )
 	else _maxAnisoMask = SS_ANISO16;
 	_renderDevice->beginRendering();
 	_renderDevice->setViewport( _curCamera->_vpX, _curCamera->_vpY, _curCamera->_vpWidth, _curCamera->_vpHeight );
+	_matTexBufBound = false;
 
-	// Perform culling
-	prepareRenderViews();
+	// Culling and extraction are skipped if the frame was prepared in advance, the camera can then
+	// still take over a transformation that was set after preparing
+	if( _snapshot.camera != _curCamera ) prepareRender( _curCamera );
+	else if( Modules::config().lateLatchCamera ) _curCamera->latchTransform();
 
 	if( Modules::config().debugViewMode || _curCamera->_pipelineRes == 0x0 )
 	{
@@ -2239,11 +3711,30 @@ void Renderer::render( CameraNode *camNode )
 	else 
 		_renderDevice->setRenderBuffer( 0 );
 
+	// Measure GPU time of the whole pipeline, the result of the last frame drives dynamic resolution
+	GPUTimer *timer = Modules::stats().getGPUTimer( EngineStats::FrameGPUTime );
+	if( Modules::config().gatherTimeStats || Modules::config().dynResTargetTime > 0 ) timer->beginQuery( _frameID );
+
+	float viewportScale = 1.0f;
+	if( _curCamera->_pipelineRes->_dynamicResolution )
+	{
+		updateDynamicResolution( _curCamera->_pipelineRes );
+		viewportScale = _curCamera->_pipelineRes->_dynResScale;
+	}
+	if( viewportScale != _viewportScale )
+	{
+		_viewportScale = viewportScale;
+		++_curShaderUpdateStamp;
+	}
+
+	// Apply GPU occlusion tests of earlier frames that have completed
+	if( _curCamera->_occSet >= 0 ) readOcclusionResults( _curCamera->_occSet );
+
 	// Process pipeline commands
 	for( uint32 i = 0; i < _curCamera->_pipelineRes->_stages.size(); ++i )
 	{
 		PipelineStage &stage = _curCamera->_pipelineRes->_stages[i];
-		if( !stage.enabled ) continue;
+		if( !stage.enabled || stage.culled ) continue;
 		_curStageMatLink = stage.matLink;
 		
 		for( uint32 j = 0; j < stage.commands.size(); ++j )
@@ -2258,23 +3749,7 @@ void Renderer::render( CameraNode *camNode )
 				bindPipeBuffer( 0x0, "", 0 );
 				
 				// Bind new render target
-				rt = (RenderTarget *)pc.params[0].getPtr();
-				_curRenderTarget = rt;
-
-				if( rt != 0x0 )
-				{
-					int width, height;
-					_renderDevice->getRenderBufferDimensions( rt->rendBuf, &width, &height );
-					_renderDevice->_outputBufferIndex = _curCamera->_outputBufferIndex;
-					_renderDevice->setViewport( 0, 0, width, height );
-					_renderDevice->setRenderBuffer( rt->rendBuf );
-				}
-				else
-				{
-					_renderDevice->setViewport( _curCamera->_vpX, _curCamera->_vpY, _curCamera->_vpWidth, _curCamera->_vpHeight );
-					_renderDevice->setRenderBuffer( _curCamera->_outputTex != 0x0 ?
-					                       _curCamera->_outputTex->getRBObject() : 0 );
-				}
+				bindRenderTarget( (RenderTarget *)pc.params[0].getPtr() );
 				break;
 
 			case DefaultPipelineCommands::BindBuffer:
@@ -2308,7 +3783,26 @@ void Renderer::render( CameraNode *camNode )
 				break;
 
 			case DefaultPipelineCommands::DoDeferredLightLoop:
-				drawLightShapes( pc.params[0].getString(), pc.params[1].getBool(), _curCamera->_occSet );
+				drawLightShapes( pc.params[0].getString(), pc.params[1].getBool(), pc.params[2].getBool(),
+				                 pc.params[3].getInt(), _curCamera->_occSet );
+				break;
+
+			case DefaultPipelineCommands::DrawOffscreenParticles:
+				drawOffscreenParticles( pc.params[0].getString(), pc.params[1].getInt(),
+				                        (RenderingOrder::List)pc.params[2].getInt(), pc.params[3].getFloat(),
+				                        pc.params[4].getResource(), (RenderTarget *)pc.params[5].getPtr(),
+				                        _curCamera->_occSet );
+				break;
+
+			case DefaultPipelineCommands::DispatchCompute:
+				dispatchComputeCommand( pc.params[0].getResource(), pc.params[1].getString(), (uint32)pc.params[2].getInt(),
+				                        (uint32)pc.params[3].getInt(), (uint32)pc.params[4].getInt(),
+				                        pc.params[5].getResource(), (uint32)pc.params[6].getInt(),
+				                        pc.params.data() + 9, pc.params[7].getInt(), pc.params[8].getInt() );
+				break;
+
+			case DefaultPipelineCommands::DoOcclusionCulling:
+				doOcclusionCulling( pc.params[0].getResource(), (RenderTarget *)pc.params[1].getPtr(), _curCamera->_occSet );
 				break;
 
 			case DefaultPipelineCommands::SetUniform:
@@ -2327,6 +3821,8 @@ void Renderer::render( CameraNode *camNode )
 		}
 	}
 	
+	timer->endQuery();
+	
 	// Update mipmaps if necessary
 	if( _curCamera->_outputTex != 0x0 && _curCamera->_outputTex->getMaxMipLevel() > 0 )
 		_renderDevice->generateTextureMipmap( _curCamera->_outputTex->getTexObject() );
@@ -2337,14 +3833,45 @@ void Renderer::render( CameraNode *camNode )
 
 void Renderer::finalizeFrame()
 {
+	// Limit how many frames the GPU may lag behind so that the latency between input and display is bounded
+	int maxFramesInFlight = Modules::config().maxFramesInFlight;
+	if( maxFramesInFlight > 0 )
+	{
+		uint32 slot = _frameID % FrameFenceSlots;
+		_renderDevice->destroyFence( _frameFences[slot] );
+		_frameFences[slot] = _renderDevice->createFence();
+
+		// With one frame in flight the frame that was just submitted has to complete
+		uint32 waitSlot = (_frameID + FrameFenceSlots - (maxFramesInFlight - 1)) % FrameFenceSlots;
+		if( _frameFences[waitSlot] != 0 )
+		{
+			Timer *waitTimer = Modules::stats().getTimer( EngineStats::FrameWaitTime );
+			waitTimer->setEnabled( true );
+			if( !_renderDevice->waitForFence( _frameFences[waitSlot] ) )
+				Modules::log().writeWarning( "Frame pacing: Waiting for the GPU to complete a frame failed" );
+			waitTimer->setEnabled( false );
+			_renderDevice->destroyFence( _frameFences[waitSlot] );
+		}
+	}
+	else
+	{
+		for( uint32 i = 0; i < FrameFenceSlots; ++i )
+			_renderDevice->destroyFence( _frameFences[i] );
+	}
+
 	++_frameID;
 	
 	// Reset frame timer
 	Timer *timer = Modules::stats().getTimer( EngineStats::FrameTime );
 	ASSERT( timer != 0x0 );
+	float frameTime = timer->getElapsedTimeMS();
 	Modules::stats().getStat( EngineStats::FrameTime, true );  // Reset
-	Modules::stats().incStat( EngineStats::FrameTime, timer->getElapsedTimeMS() );
+	Modules::stats().incStat( EngineStats::FrameTime, frameTime );
 	timer->reset();
+
+	// GPU idle time is estimated from the GPU time of the last completed frame
+	float gpuTime = Modules::stats().getGPUTimer( EngineStats::FrameGPUTime )->getTimeMS();
+	if( gpuTime > 0 ) Modules::stats().incStat( EngineStats::GPUIdleTime, std::max( frameTime - gpuTime, 0.0f ) );
 }
 
 
@@ -2366,6 +3893,7 @@ void Renderer::renderDebugView()
 // 	                                  SceneNodeFlags::NoDraw, true, true );
 
 	// Draw renderable nodes as wireframe
+	Modules::sceneMan().setCurrentView( defaultCameraView );
 	setupViewMatrices( _curCamera->getViewMat(), _curCamera->getProjMat() );
 	drawRenderables( "", 0, true, &_curCamera->getFrustum(), 0x0, RenderingOrder::None, -1 );
 
@@ -2381,9 +3909,9 @@ void Renderer::renderDebugView()
 	_renderDevice->setShaderConst( Modules::renderer()._defColShader_color, CONST_FLOAT4, color );
 	for( uint32 i = 0, s = (uint32)Modules::sceneMan().getRenderQueue().size(); i < s; ++i )
 	{
-		SceneNode *sn = Modules::sceneMan().getRenderQueue()[i].node;
+		const SnapshotNode &data = _snapshot.nodes[ Modules::sceneMan().getRenderQueue()[i].dataIndex ];
 		
-		drawAABB( sn->_bBox.min, sn->_bBox.max );
+		drawAABB( data.bBox.min, data.bBox.max );
 	}
 	_renderDevice->setCullMode( RS_CULL_BACK );
 
@@ -2416,11 +3944,12 @@ void Renderer::renderDebugView()
 
 void Renderer::finishRendering()
 {
-	_shadowParams.resize( 0 );
+	_snapshot.camera = 0x0;
 
 	_renderDevice->setRenderBuffer( 0 );
 	setMaterial( 0x0, "" );
 	_renderDevice->resetStates();
+	_matTexBufBound = false;
 }
 
 
@@ -25,12 +25,25 @@
 namespace Horde3D {
 
 class MaterialResource;
+class ComputeBufferResource;
 class LightNode;
 class CameraNode;
 struct ShaderContext;
 
 const uint32 ParticlesPerBatch = 64;	// Warning: The GPU must have enough registers
 const uint32 QuadIndexBufCount = ParticlesPerBatch * 6;
+const int ShadowAtlasBorder = 2;  // Texels kept free around each atlas region so that filtering stays inside
+const int ShadowAtlasMinRegionSize = 128;
+const uint32 LightVolumesPerBatch = 256;  // Max number of light volumes drawn with one instanced call
+const uint32 TiledLightsMax = 4096;  // Max number of lights shaded by the tiled deferred pass
+const int TiledLightTexWidth = 1024;  // Width of light data and tile index textures
+const int TiledIndexTexMaxHeight = 1024;
+const uint32 TiledParallelMinLights = 256;  // Light count from which binning is split across threads
+const int OccPyramidMaxLevels = 16;
+const uint32 OccPyramidResultSlots = 3;  // Max number of frames for which occlusion tests can be in flight
+const uint32 OccPyramidImageUnit = 7;  // Image unit of the depth pyramid in the culling shaders
+const uint32 MaterialTexTableSlot = 7;  // Storage buffer binding of the bindless material texture table
+const uint32 FrameFenceSlots = 4;  // Fences of the last frames kept for frame pacing, more than MaxFramesInFlight allows
 
 #define OCCPROXYLIST_RENDERABLES 0
 #define OCCPROXYLIST_LIGHTS 1
@@ -59,7 +72,8 @@ struct RenderBackendType
 	{
 		OpenGL2 = 2,
 		OpenGL4 = 4,
-		OpenGLES3 = 8
+		OpenGLES3 = 8,
+		Null = 16
 	};
 };
 
@@ -92,6 +106,47 @@ struct OccProxy
 	}
 };
 
+// Hierarchical depth buffer (Hi-Z) of an occlusion set that is built from the depth of a frame
+// and used to test the bounding boxes of the frame's renderables on the GPU
+struct OcclusionPyramid
+{
+	uint32                     tex;  // R32F, levels after the first one are stacked right of level 0
+	int                        width, height;  // Size of level 0 (half the depth buffer resolution)
+	int                        numLevels;
+	float                      levels[OccPyramidMaxLevels * 4];  // Offset and size of each level
+	uint32                     boxBuf, boxBufSize;
+	uint32                     resultBufs[OccPyramidResultSlots], resultBufSizes[OccPyramidResultSlots];
+	uint32                     fences[OccPyramidResultSlots];
+	std::vector< NodeHandle >  candidates[OccPyramidResultSlots];  // Tested nodes, bit i of results is node i
+	uint32                     nextSlot;
+	uint32                     resultStamp;  // Incremented each time results are read back
+	uint32                     lastFrame;  // Frame in which the pyramid was last built
+
+	OcclusionPyramid() :
+		tex( 0 ), width( 0 ), height( 0 ), numLevels( 0 ), boxBuf( 0 ), boxBufSize( 0 ),
+		nextSlot( 0 ), resultStamp( 1 ), lastFrame( 0 )
+	{
+		for( uint32 i = 0; i < OccPyramidResultSlots; ++i )
+		{
+			resultBufs[i] = 0; resultBufSizes[i] = 0; fences[i] = 0;
+		}
+	}
+};
+
+struct LightVolumeInstance
+{
+	float  worldMat[16];   // Transformation of unit sphere or cone
+	float  lightPos[4];    // Position and radius
+	float  lightDir[4];    // Spot direction and cosine of cutoff angle
+	float  lightColor[4];
+};
+
+struct PendingBufferWrite
+{
+	uint32  bufObj;
+	uint32  barriers;  // Kinds of access (RDIDrawBarriers) that do not see the write yet
+};
+
 struct PipeSamplerBinding
 {
 	char    sampler[64];
@@ -118,7 +173,7 @@ struct EngineUniform
 
 struct DefaultShaderUniforms
 {
-	int                 frameBufSize = -1;
+	int                 frameBufSize = -1, viewportScale = -1;
 	int                 viewMat = -1, viewMatInv = -1, projMat = -1, viewProjMat = -1, 
 						viewProjMatInv = -1, viewerPos = -1;
 
@@ -126,7 +181,11 @@ struct DefaultShaderUniforms
 	int                 skinMatRows = -1;
 	int                 lightPos = -1, lightDir = -1, lightColor = -1;
 	int                 shadowSplitDists = -1, shadowMats = -1, shadowMapSize = -1, shadowBias = -1;
+	int                 shadowCascadeMats = -1, shadowCascadeRegions = -1, shadowCascadeFirst = -1;
 	int                 parPosArray = -1, parSizeAndRotArray = -1, parColorArray = -1;
+	int                 tileParams = -1;
+	int                 occPyramidLevels = -1, occPyramidParams = -1;
+	int                 materialTexBase = -1;
 };
 
 struct DefaultVertexLayouts
@@ -146,6 +205,64 @@ struct ShadowParameters
 	float                              splitPlanes[ 5 ] = { 0 };
 
 	int								   viewID[ 4 ] = { 0 };
+	int                                cascadeViewID = -1;  // Casters drawn once for all cascades or -1
+
+	int                                atlasX = -1, atlasY = 0, atlasSize = 0;  // Region in shadow atlas, atlasX is -1 if not packed
+};
+
+// =================================================================================================
+
+// Render data of a culled node, copied from the scene when a frame is prepared so that drawing
+// does not access scene nodes that the application already modifies for the next frame
+struct SnapshotNode
+{
+	Matrix4f               absTrans;
+	BoundingBox            bBox;
+	SceneNode              *node;  // Only used for occlusion query bookkeeping
+	MaterialResource       *materialRes;
+	NodeHandle             handle;
+	float                  sortKey;
+	int                    type;
+	uint32                 modelIndex;  // Meshes: model data in snapshot
+	uint32                 firstBatch, batchCount;  // Emitters: batches with living particles in snapshot
+	uint32                 elementsCount;  // Particle count of emitters or element count of compute nodes
+	uint32                 elementsStart;  // First element drawn by compute nodes
+
+	// Meshes
+	GeometryResource       *geoRes;  // 0x0 if the mesh is not valid
+	uint32                 batchStart, batchIndexCount, vertRStart, vertREnd;
+	uint32                 lodLevel;
+	RDIPrimType            primType;
+
+	// Compute nodes
+	ComputeBufferResource  *compBufferRes, *indirectBufferRes;
+	uint32                 indirectOffset;
+	int                    drawType;
+};
+
+struct SnapshotModel
+{
+	Vec4f   customInstData[ModelCustomVecCount];
+	uint32  firstSkinRow, skinRowCount;
+	bool    hasJoints;
+};
+
+struct SnapshotParticleBatch
+{
+	uint32  firstParticle, count;
+};
+
+struct RenderSnapshot
+{
+	std::vector< SnapshotNode >           nodes;
+	std::vector< SnapshotModel >          models;
+	std::vector< SnapshotParticleBatch >  particleBatches;
+	std::vector< Vec4f >                  skinMatRows;
+	std::vector< float >                  parPositions, parSizesAndRotations, parColors;
+	CameraNode                            *camera;  // Camera the snapshot was prepared for, 0x0 if consumed
+	uint32                                stamp;
+
+	RenderSnapshot() : camera( 0x0 ), stamp( 0 ) {}
 };
 
 class Renderer
@@ -172,13 +289,19 @@ public:
 	// Shader & material handling
 	bool createShaderComb( ShaderCombination &sc, const char *vertexShader, const char *fragmentShader, const char *geometryShader,
 						   const char *tessControlShader, const char *tessEvaluationShader, const char *computeShader );
+	bool beginShaderComb( ShaderCombination &sc, const char *vertexShader, const char *fragmentShader, const char *geometryShader,
+						  const char *tessControlShader, const char *tessEvaluationShader, const char *computeShader );
+	bool finishShaderComb( ShaderCombination &sc );
 	void releaseShaderComb( ShaderCombination &sc );
 	void setShaderComb( ShaderCombination *sc );
 	void commitGeneralUniforms();
 	bool setMaterial( MaterialResource *materialRes, const std::string &shaderContext );
+	bool switchMaterialTextures( MaterialResource *curMatRes, MaterialResource *materialRes );
 	
 	bool createShadowRB( uint32 width, uint32 height );
 	void releaseShadowRB();
+	bool createShadowAtlasRB( uint32 width, uint32 height );
+	void releaseShadowAtlasRB();
 
 	// Occlusion culling
 	int registerOccSet();
@@ -186,6 +309,8 @@ public:
 	void drawOccProxies( uint32 list );
 	void pushOccProxy( uint32 list, const Vec3f &bbMin, const Vec3f &bbMax, uint32 queryObj )
 		{ _occProxies[list].push_back( OccProxy( bbMin, bbMax, queryObj ) ); }
+	bool usesOcclusionPyramid( int occSet ) const;
+	bool isOccludedByPyramid( const SceneNode *node, int occSet ) const;
 	
 	// Drawing
 	void drawAABB( const Vec3f &bbMin, const Vec3f &bbMax );
@@ -199,19 +324,30 @@ public:
 	static void drawComputeResults( uint32 firstItem, uint32 lastItem, const std::string &shaderContext, int theClass, 
 									bool debugView, const Frustum *frust1, const Frustum *frust2, RenderingOrder::List order, int occSet );
 
+	void prepareRender( CameraNode *camNode );
 	void render( CameraNode *camNode );
 	void finalizeFrame();
 
 	void dispatchCompute( MaterialResource *materialRes, const std::string &context, uint32 groups_x, uint32 groups_y, uint32 groups_z );
 
+	// Tracking of buffers written by shaders, barriers are only placed when such a buffer is accessed
+	void markBufferWritten( uint32 bufObj );
+	void syncBufferAccess( uint32 bufObj, uint32 barriers, bool immediate = false );
+
+	// Returns the entries of a material in the bindless texture table for reuse by other materials
+	void releaseMaterialTexTable( MaterialResource *materialRes );
+
 	// Getters
 	uint32 getFrameID() const { return _frameID; }
 	ShaderCombination *getCurShader() const { return _curShader; }
 	CameraNode *getCurCamera() const { return _curCamera; }
+	const RenderSnapshot &getSnapshot() const { return _snapshot; }
+	const std::vector< ShadowParameters > &getShadowParams() const { return _shadowParams; }
 	uint32 getQuadIdxBuf() const { return _quadIdxBuf; }
 	uint32 getParticleVBO() const { return _particleVBO; }
 	uint32 getParticleGeometry() const { return _particleGeo; }
 	uint32 getDefaultVertexLayout( DefaultVertexLayouts::List vl ) const;
+	const std::vector< uint64 > &getMaterialTexTable() const { return _matTexHandles; }
 
 	inline RenderDeviceInterface *getRenderDevice() const { return _renderDevice; }
 	int getRenderDeviceType() { return _renderDeviceType; }
@@ -220,9 +356,14 @@ protected:
 	
 	void createPrimitives();
 	
+	void initShaderComb( ShaderCombination &sc );
 	bool setMaterialRec( MaterialResource *materialRes, const std::string &shaderContext, ShaderResource *shaderRes );
+	uint32 adjustSamplerState( uint32 sampState ) const;
+	uint32 updateMaterialTexTable( MaterialResource *materialRes, ShaderResource *shaderRes );
 	
 	void prepareRenderViews();
+	void extractRenderData();
+	uint32 extractNode( SceneNode *node );
 
 	// Shadows
 	void setupShadowMap( bool noShadows );
@@ -232,8 +373,11 @@ protected:
 	
 	int prepareCropFrustum( const LightNode *light, const BoundingBox &viewBB );
 	bool prepareShadowMapFrustum( const LightNode *light, int shadowView );
+	void prepareShadowCascades();
+	void drawShadowViews( ShadowParameters &params, int x, int y, int size, int texSize, RenderingOrder::List order );
 	void updateShadowMap();
 	void updateShadowMapOld();
+	void updateShadowAtlas();
 
 	// Drawing functions
 	void bindPipeBuffer( uint32 rbObj, const std::string &sampler, uint32 bufIndex );
@@ -243,7 +387,21 @@ protected:
 	                   RenderingOrder::List order, int occSet );
 	void drawLightGeometry( const std::string &shaderContext, int theClass,
 	                        bool noShadows, RenderingOrder::List order, int occSet );
-	void drawLightShapes( const std::string &shaderContext, bool noShadows, int occSet );
+	void drawLightShapes( const std::string &shaderContext, bool noShadows, bool depthBounds, int tileSize, int occSet );
+	bool hasLightContextVariant( const LightNode *light, const std::string &shaderContext, const char *suffix );
+	void drawLightVolumesInstanced( const std::string &shaderContext, bool depthBounds );
+	void binTiledLights( uint32 firstLight, uint32 numLights, int tilesX, int tilesY, float tileScaleX, float tileScaleY );
+	void drawTiledLights( const std::string &shaderContext, int tileSize );
+	void updateDynamicResolution( PipelineResource *pipeRes );
+	void bindRenderTarget( RenderTarget *rt );
+	void drawOffscreenParticles( const std::string &shaderContext, int theClass, RenderingOrder::List order,
+	                             float scale, Resource *matRes, RenderTarget *depthRT, int occSet );
+	void dispatchComputeCommand( Resource *matRes, const std::string &context, uint32 groupsX, uint32 groupsY, uint32 groupsZ,
+	                             Resource *indirectBuf, uint32 indirectOffset, const PipeCmdParam *bufParams,
+	                             int numReads, int numWrites );
+	void doOcclusionCulling( Resource *matRes, RenderTarget *depthRT, int occSet );
+	void readOcclusionResults( int occSet );
+	void releaseOcclusionPyramid( OcclusionPyramid &pyr );
 	
 	void drawRenderables( const std::string &shaderContext, int theClass, bool debugView,
 		const Frustum *frust1, const Frustum *frust2, RenderingOrder::List order, int occSet );
@@ -263,11 +421,22 @@ protected:
 	std::vector< RenderFuncListItem >  _renderFuncRegistry;
 	
 	std::vector< PipeSamplerBinding >  _pipeSamplerBindings;
+	std::vector< PendingBufferWrite >  _pendingBufferWrites;
 	std::vector< char >                _occSets;  // Actually bool
 	std::vector< OccProxy >            _occProxies[2];  // 0: renderables, 1: lights
+	std::vector< OcclusionPyramid >    _occPyramids;  // Depth pyramid of each occlusion set
+	std::vector< float >               _occBoxData;  // Candidate AABBs uploaded for GPU occlusion tests
+	std::vector< uint32 >              _occResultClear;
+	std::vector< uint64 >              _matTexHandles;  // Bindless texture handles of all materials, see updateMaterialTexTable
+	RDIBufferArena                     _matTexArena;  // Ranges of _matTexHandles owned by materials
+	uint32                             _matTexBuf;
+	uint32                             _matTexBufCapacity;  // Number of handles the buffer can store
+	bool                               _matTexBufBound;
+	uint32                             _frameFences[FrameFenceSlots];  // Fence of each frame, indexed by frame ID
 
 	std::vector< EngineUniform >	   _engineUniforms; // uniforms, that are used internally by the engine and extensions
 	std::vector< ShadowParameters >	   _shadowParams; // shadow lightmaps and project matrices
+	RenderSnapshot                     _snapshot;  // Render data of the prepared frame
 
 	Matrix4f                           _viewMat, _viewMatInv, _projMat, _viewProjMat, _viewProjMatInv;
 
@@ -280,8 +449,12 @@ protected:
 	uint32								_sphereGeo;
 	uint32								_coneGeo;
 	uint32								_FSPolyGeo;
+	uint32								_sphereInstGeo;  // Sphere and cone with per-instance light data
+	uint32								_coneInstGeo;
 
 	uint32                             _shadowRB;
+	uint32                             _shadowAtlasRB;
+	bool                               _shadowAtlasValid;  // Atlas is up to date for current render views
 	uint32                             _frameID;
 	uint32                             _defShadowMap;
 	uint32                             _quadIdxBuf;
@@ -293,19 +466,38 @@ protected:
 	ShaderCombination                  *_curShader;
 	RenderTarget                       *_curRenderTarget;
 	uint32                             _curShaderUpdateStamp;
+	float                              _viewportScale;  // Resolution scale of pipeline targets with dynamic resolution
 	
 	uint32                             _maxAnisoMask;
 	float                              _smSize;
 
 	float                              _splitPlanes[5];
 	Matrix4f                           _lightMats[4];
-
-	uint32                             _vlPosOnly, _vlModel, _vlParticle;
+	Matrix4f                           _cascadeMats[4];
+	float                              _cascadeRegions[16];  // Clip region of each cascade in NDC
+	std::vector< uint8 >               _cascadeMasks;  // Overlapped cascades per snapshot node
+
+	std::vector< LightNode * >         _instancedLights;  // Unshadowed lights collected for instanced drawing
+	std::vector< LightVolumeInstance > _lightVolumeInsts;
+
+	std::vector< LightNode * >         _tiledLights;  // Unshadowed lights shaded by the tiled passes
+	std::vector< int >                 _tiledLightRects;  // Covered tile range per light: x0, y0, x1, y1
+	std::vector< uint32 >              _tileLightCounts;
+	std::vector< float >               _tileLightData;  // 3 texels per light: position/radius, direction/cutoff, color
+	std::vector< float >               _tileIndexData;  // Tile headers (first slot, count) followed by light indices
+	uint32                             _tileLightTex, _tileIndexTex;
+	int                                _tileIndexTexHeight;
+
+	uint32                             _offscreenParticleRB;  // Reduced resolution color and downsampled depth
+	int                                _offscreenParticleWidth, _offscreenParticleHeight;
+	bool                               _offscreenParticlePass;
+
+	uint32                             _vlPosOnly, _vlModel, _vlParticle, _vlLightVolume;
 	ShaderCombination                  _defColorShader;
 	int                                _defColShader_color;  // Uniform location
 	
 	uint32                             _vbCube, _ibCube, _vbSphere, _ibSphere;
-	uint32                             _vbCone, _ibCone, _vbFSPoly;
+	uint32                             _vbCone, _ibCone, _vbFSPoly, _vbLightVolumeInst;
 	
 	int									_renderDeviceType;
 
@@ -169,6 +169,110 @@ private:
 };
 
 
+// Sub-allocates ranges of elements from a large shared buffer; released ranges are
+// merged with their free neighbours so that the arena can be compacted when it fragments
+class RDIBufferArena
+{
+public:
+
+	RDIBufferArena() : _capacity( 0 ), _used( 0 ) {}
+
+	void reset( uint32 capacity )
+	{
+		_freeRanges.clear();
+		if( capacity > 0 ) _freeRanges.push_back( Range( 0, capacity ) );
+		_capacity = capacity;
+		_used = 0;
+	}
+
+	bool alloc( uint32 size, uint32 &offset )
+	{
+		// First fit, ranges are sorted by offset so the arena is filled from the front
+		for( size_t i = 0; i < _freeRanges.size(); ++i )
+		{
+			Range &range = _freeRanges[i];
+			if( range.size < size ) continue;
+
+			offset = range.offset;
+			range.offset += size;
+			range.size -= size;
+			if( range.size == 0 ) _freeRanges.erase( _freeRanges.begin() + i );
+			
+			_used += size;
+			return true;
+		}
+
+		return false;
+	}
+
+	void release( uint32 offset, uint32 size )
+	{
+		ASSERT( offset + size <= _capacity && size <= _used );
+		
+		size_t i = 0;
+		while( i < _freeRanges.size() && _freeRanges[i].offset < offset ) ++i;
+		
+		if( i > 0 && _freeRanges[i - 1].offset + _freeRanges[i - 1].size == offset )
+		{
+			// Merge with previous range and possibly with the next one
+			_freeRanges[i - 1].size += size;
+			if( i < _freeRanges.size() && offset + size == _freeRanges[i].offset )
+			{
+				_freeRanges[i - 1].size += _freeRanges[i].size;
+				_freeRanges.erase( _freeRanges.begin() + i );
+			}
+		}
+		else if( i < _freeRanges.size() && offset + size == _freeRanges[i].offset )
+		{
+			_freeRanges[i].offset = offset;
+			_freeRanges[i].size += size;
+		}
+		else
+		{
+			_freeRanges.insert( _freeRanges.begin() + i, Range( offset, size ) );
+		}
+
+		_used -= size;
+	}
+
+	void grow( uint32 capacity )
+	{
+		// Added elements are free, they extend a free range at the end
+		if( capacity <= _capacity ) return;
+
+		if( !_freeRanges.empty() && _freeRanges.back().offset + _freeRanges.back().size == _capacity )
+			_freeRanges.back().size += capacity - _capacity;
+		else
+			_freeRanges.push_back( Range( _capacity, capacity - _capacity ) );
+		_capacity = capacity;
+	}
+
+	uint32 getCapacity() const { return _capacity; }
+	uint32 getUsed() const { return _used; }
+	
+	// Free elements that are not part of the contiguous free space at the end of the arena
+	uint32 getFragmentedSize() const
+	{
+		uint32 tail = 0;
+		if( !_freeRanges.empty() && _freeRanges.back().offset + _freeRanges.back().size == _capacity )
+			tail = _freeRanges.back().size;
+		
+		return _capacity - _used - tail;
+	}
+
+private:
+	struct Range
+	{
+		uint32  offset, size;
+
+		Range( uint32 offset, uint32 size ) : offset( offset ), size( size ) {}
+	};
+
+	std::vector< Range >  _freeRanges;  // Sorted by offset
+	uint32                _capacity, _used;
+};
+
+
 struct DeviceCaps
 {
 	uint16	maxJointCount;
@@ -184,6 +288,13 @@ struct DeviceCaps
 	bool	texETC2;
 	bool	texASTC;
 	bool	texBPTC;
+	bool	parallelShaderCompile;  // Completion of background shader compilation can be queried
+	bool	drawBaseVertex;  // Indexed draws can add a base vertex to the fetched indices
+	bool	pixelBuffers;  // Textures can be updated asynchronously from pixel buffers
+	bool	indirectDraws;  // Draw and dispatch arguments can be sourced from buffers written on the GPU
+	bool	clipDistances;  // Vertex shaders can write gl_ClipDistance[0..3] for user clip planes
+	bool	texArrays;  // 2D array textures can be created and filled by copying slices of other textures
+	bool	bindlessTextures;  // Textures can be referenced in shaders by 64 bit handles instead of units
 };
 
 
@@ -197,6 +308,7 @@ struct VertexLayoutAttrib
 	uint32       vbSlot;
 	uint32       size;
 	uint32       offset;
+	uint32       divisor;  // 0 for per-vertex data, otherwise attribute advances every divisor instances
 };
 
 struct RDIVertexLayout
@@ -236,7 +348,8 @@ struct TextureTypes
 	{
 		Tex2D = 0,
 		Tex3D,
-		TexCube
+		TexCube,
+		Tex2DArray
 	};
 };
 
@@ -394,6 +507,7 @@ struct RDIRasterState
 			uint32  scissorEnable : 1;
 			uint32  multisampleEnable : 1;
 			uint32  renderTargetWriteMask : 1;
+			uint32  clipDistances : 1;  // Enables clip distances 0 to 3
 		};
 	};
 };
@@ -423,6 +537,9 @@ struct RDIBlendState
 			uint32  blendEnable : 1;
 			uint32  srcBlendFunc : 4;
 			uint32  destBlendFunc : 4;
+			uint32  separateAlphaBlend : 1;
+			uint32  srcAlphaBlendFunc : 4;
+			uint32  destAlphaBlendFunc : 4;
 		};
 	};
 };
@@ -479,12 +596,16 @@ enum RDIPrimType
 	PRIM_PATCHES
 };
 
+// Barriers can be combined, each flag only covers the given kind of access
 enum RDIDrawBarriers
 {
 	NotSet = 0,
-	VertexBufferBarrier,		// Wait till vertex buffer is updated by shaders
-	IndexBufferBarrier,			// Wait till index buffer is updated by shaders
-	ImageBarrier				// Wait till image is updated by shaders
+	VertexBufferBarrier = 1,	// Wait till vertex buffer is updated by shaders
+	IndexBufferBarrier = 2,		// Wait till index buffer is updated by shaders
+	ImageBarrier = 4,			// Wait till image is updated by shaders
+	StorageBufferBarrier = 8,	// Wait till storage buffer writes are visible to shaders
+	IndirectBufferBarrier = 16,	// Wait till draw and dispatch arguments are updated by shaders
+	BufferUpdateBarrier = 32	// Wait till buffer is updated by shaders before mapping it
 };
 
 class RenderDeviceInterface
@@ -516,6 +637,9 @@ protected:
 	RDIDelegate< void ( uint32, uint32, uint32, uint32, void *data ) >	_delegate_updateBufferData;
 	RDIDelegate< void* ( uint32, uint32, uint32, uint32, RDIBufferMappingTypes ) > _delegate_mapBuffer;
 	RDIDelegate< void ( uint32, uint32 ) >								_delegate_unmapBuffer;
+	RDIDelegate< uint32 ( uint32 ) >									_delegate_createPixelBuffer;
+	RDIDelegate< void* ( uint32 ) >										_delegate_mapPixelBuffer;
+	RDIDelegate< void ( uint32 ) >										_delegate_unmapPixelBuffer;
 
 	RDIDelegate< uint32 ( TextureTypes::List, int, int, int, TextureFormats::List, int, bool, bool, bool ) > _delegate_createTexture;
 	RDIDelegate< void ( uint32 ) >										_delegate_generateTextureMipmap;
@@ -524,14 +648,21 @@ protected:
 	RDIDelegate< void ( uint32, int, int, const void * ) >				_delegate_updateTextureData;
 	RDIDelegate< bool ( uint32, int, int, void * ) >					_delegate_getTextureData;
 	RDIDelegate< void ( uint32, void * ) >								_delegate_bindImageToTexture;
+	RDIDelegate< void ( uint32, uint32, uint32 ) >						_delegate_updateTextureFromBuffer;
+	RDIDelegate< void ( uint32, int, uint32, int, int ) >				_delegate_copyTextureSlice;
+	RDIDelegate< uint64 ( uint32, uint16 ) >							_delegate_getTextureHandle;
 
 	RDIDelegate< uint32 ( const char *, const char *, const char *, const char *, const char *, const char * ) > _delegate_createShader;
+	RDIDelegate< uint32 ( const char *, const char *, const char *, const char *, const char *, const char * ) > _delegate_beginCreatingShader;
+	RDIDelegate< bool ( uint32 ) >										_delegate_isShaderPending;
+	RDIDelegate< bool ( uint32 & ) >									_delegate_finishCreatingShader;
 	RDIDelegate< void ( uint32 & ) >									_delegate_destroyShader;
 	RDIDelegate< void ( uint32 ) >										_delegate_bindShader;
 	RDIDelegate< int ( uint32, const char * ) >							_delegate_getShaderConstLoc;
 	RDIDelegate< int ( uint32, const char * ) >							_delegate_getShaderSamplerLoc;
 	RDIDelegate< int ( uint32, const char * ) >							_delegate_getShaderBufferLoc;
 	RDIDelegate< void ( uint32, uint32, uint32, uint32 ) >				_delegate_runComputeShader;
+	RDIDelegate< void ( uint32, uint32, uint32 ) >						_delegate_runComputeShaderIndirect;
 	RDIDelegate< void ( int, RDIShaderConstType, void *values, uint32 ) > _delegate_setShaderConst;
 	RDIDelegate< void ( int, uint32 ) >									_delegate_setShaderSampler;
 	RDIDelegate< const char *() >										_delegate_getDefaultVSCode;
@@ -552,12 +683,21 @@ protected:
 
 	RDIDelegate< GPUTimer * () >										_delegate_createGPUTimer;
 
+	RDIDelegate< uint32 () >											_delegate_createFence;
+	RDIDelegate< bool ( uint32 ) >										_delegate_isFenceSignaled;
+	RDIDelegate< bool ( uint32 ) >										_delegate_waitForFence;
+	RDIDelegate< void ( uint32 & ) >									_delegate_destroyFence;
+
 	RDIDelegate< bool ( uint32 ) >										_delegate_commitStates;
 	RDIDelegate< void () >												_delegate_resetStates;
 
 	RDIDelegate< void ( uint32, float *, float ) >						_delegate_clear;
 	RDIDelegate< void ( RDIPrimType, uint32, uint32 ) >					_delegate_draw;
 	RDIDelegate< void ( RDIPrimType, uint32, uint32, uint32, uint32 ) >	_delegate_drawIndexed;
+	RDIDelegate< void ( RDIPrimType, uint32, uint32, uint32, uint32, uint32 ) > _delegate_drawIndexedBaseVertex;
+	RDIDelegate< void ( RDIPrimType, uint32, uint32, uint32, uint32, uint32 ) > _delegate_drawIndexedInstanced;
+	RDIDelegate< void ( RDIPrimType, uint32, uint32, uint32, uint32, uint32, uint32 ) > _delegate_drawIndexedInstancedBaseVertex;
+	RDIDelegate< void ( RDIPrimType, uint32, uint32 ) >					_delegate_drawIndirect;
 	RDIDelegate< void ( uint8, uint32 ) >								_delegate_setStorageBuffer;
 
 // -----------------------------------------------------------------------------
@@ -664,6 +804,20 @@ public:
 	{
 		_delegate_unmapBuffer.invoke( geoObj, bufObj );
 	}
+	uint32 createPixelBuffer( uint32 size )
+	{
+		return _delegate_createPixelBuffer.invoke( size );
+	}
+	void *mapPixelBuffer( uint32 bufObj )
+	{
+		// The mapping is unsynchronized, the caller has to make sure with a fence that the
+		// previous upload from the buffer has finished
+		return _delegate_mapPixelBuffer.invoke( bufObj );
+	}
+	void unmapPixelBuffer( uint32 bufObj )
+	{
+		_delegate_unmapPixelBuffer.invoke( bufObj );
+	}
 
 	uint32 getBufferMem() const 
 	{ 
@@ -764,6 +918,23 @@ public:
 	{
 		return _delegate_bindImageToTexture.invoke( texObj, eglImage );
 	}
+	void updateTextureFromBuffer( uint32 texObj, uint32 bufObj, uint32 offset )
+	{
+		ASSERT( _caps.pixelBuffers );
+		_delegate_updateTextureFromBuffer.invoke( texObj, bufObj, offset );
+	}
+	void copyTextureSlice( uint32 srcTexObj, int srcSlice, uint32 dstTexObj, int dstSlice, int mipLevel )
+	{
+		ASSERT( _caps.texArrays );
+		_delegate_copyTextureSlice.invoke( srcTexObj, srcSlice, dstTexObj, dstSlice, mipLevel );
+	}
+	// Returns a resident handle that samples the texture with the given state. The sampler state
+	// of the texture becomes immutable, so the texture must always be bound with that state.
+	uint64 getTextureHandle( uint32 texObj, uint16 samplerState )
+	{
+		ASSERT( _caps.bindlessTextures );
+		return _delegate_getTextureHandle.invoke( texObj, samplerState );
+	}
 
 	// Shaders
 	uint32 createShader( const char *vertexShaderSrc, const char *fragmentShaderSrc, const char *geometryShaderSrc, 
@@ -772,6 +943,22 @@ public:
 		return _delegate_createShader.invoke( vertexShaderSrc, fragmentShaderSrc, geometryShaderSrc, 
 											  tessControlShaderSrc, tessEvaluationShaderSrc, computeShaderSrc );
 	}
+	// Asynchronous shader creation: compilation and linking are started without waiting for the results,
+	// the shader must be finished before it is used. Finishing blocks while the shader is still pending.
+	uint32 beginCreatingShader( const char *vertexShaderSrc, const char *fragmentShaderSrc, const char *geometryShaderSrc, 
+						 const char *tessControlShaderSrc, const char *tessEvaluationShaderSrc, const char *computeShaderSrc ) 
+	{
+		return _delegate_beginCreatingShader.invoke( vertexShaderSrc, fragmentShaderSrc, geometryShaderSrc, 
+											  tessControlShaderSrc, tessEvaluationShaderSrc, computeShaderSrc );
+	}
+	bool isShaderPending( uint32 shaderId )
+	{
+		return _delegate_isShaderPending.invoke( shaderId );
+	}
+	bool finishCreatingShader( uint32 &shaderId )
+	{
+		return _delegate_finishCreatingShader.invoke( shaderId );
+	}
 	void destroyShader( uint32& shaderId )
 	{
 		_delegate_destroyShader.invoke( shaderId );
@@ -816,6 +1003,12 @@ public:
 	{
 		_delegate_runComputeShader.invoke( shaderId, xDim, yDim, zDim );
 	}
+	// Group counts are read from three uint32 values at offset in the buffer
+	void runComputeShaderIndirect( uint32 shaderId, uint32 bufObj, uint32 offset )
+	{
+		ASSERT( _caps.indirectDraws );
+		_delegate_runComputeShaderIndirect.invoke( shaderId, bufObj, offset );
+	}
 
 	// Renderbuffers
 	uint32 createRenderBuffer( uint32 width, uint32 height, TextureFormats::List format,
@@ -873,6 +1066,25 @@ public:
 		return _delegate_createGPUTimer.invoke();
 	}
 
+	// Fences, signaled when all commands issued before their creation have completed
+	uint32 createFence()
+	{
+		return _delegate_createFence.invoke();
+	}
+	bool isFenceSignaled( uint32 fenceObj )
+	{
+		return _delegate_isFenceSignaled.invoke( fenceObj );
+	}
+	// Blocks until the fence is signaled, returns false if waiting failed or took unreasonably long
+	bool waitForFence( uint32 fenceObj )
+	{
+		return _delegate_waitForFence.invoke( fenceObj );
+	}
+	void destroyFence( uint32 &fenceObj )
+	{
+		_delegate_destroyFence.invoke( fenceObj );
+	}
+
 // -----------------------------------------------------------------------------
 // Commands
 // -----------------------------------------------------------------------------
@@ -888,8 +1100,10 @@ public:
 	      _pendingMask |= PM_TEXTURES; }
 // 	void setTextureBuffer( uint32 bufObj )
 // 	{	_curTextureBuf = bufObj; _pendingMask |= PM_TEXTUREBUFFER; }
-	void setMemoryBarrier( RDIDrawBarriers barrier )
-	{	_memBarriers = barrier; _pendingMask |= PM_BARRIER; }
+	void setMemoryBarrier( uint32 barriers )
+	{	_memBarriers |= barriers; _pendingMask |= PM_BARRIER; }
+	void commitMemoryBarriers()
+	{	commitStates( PM_BARRIER ); }
 	void setStorageBuffer( uint8 slot, uint32 bufObj )
 	{	_delegate_setStorageBuffer.invoke( slot, bufObj ); }
 
@@ -914,13 +1128,21 @@ public:
 		{ _newRasterState.multisampleEnable = enabled; _pendingMask |= PM_RENDERSTATES; }
 	void getMulisampling( bool &enabled ) const
 		{ enabled = _newRasterState.multisampleEnable; }
+	void setClipDistances( bool enabled )
+		{ ASSERT( !enabled || _caps.clipDistances ); _newRasterState.clipDistances = enabled; _pendingMask |= PM_RENDERSTATES; }
+	void getClipDistances( bool &enabled ) const
+		{ enabled = _newRasterState.clipDistances; }
 	void setAlphaToCoverage( bool enabled )
 		{ _newBlendState.alphaToCoverageEnable = enabled; _pendingMask |= PM_RENDERSTATES; }
 	void getAlphaToCoverage( bool &enabled ) const
 		{ enabled = _newBlendState.alphaToCoverageEnable; }
 	void setBlendMode( bool enabled, RDIBlendFunc srcBlendFunc = BS_BLEND_ZERO, RDIBlendFunc destBlendFunc = BS_BLEND_ZERO )
 		{ _newBlendState.blendEnable = enabled; _newBlendState.srcBlendFunc = srcBlendFunc;
-		  _newBlendState.destBlendFunc = destBlendFunc; _pendingMask |= PM_RENDERSTATES; }
+		  _newBlendState.destBlendFunc = destBlendFunc; _newBlendState.separateAlphaBlend = 0; _pendingMask |= PM_RENDERSTATES; }
+	// Uses different blend functions for the alpha channel until the next call of setBlendMode
+	void setAlphaBlendMode( RDIBlendFunc srcAlphaBlendFunc, RDIBlendFunc destAlphaBlendFunc )
+		{ _newBlendState.separateAlphaBlend = 1; _newBlendState.srcAlphaBlendFunc = srcAlphaBlendFunc;
+		  _newBlendState.destAlphaBlendFunc = destAlphaBlendFunc; _pendingMask |= PM_RENDERSTATES; }
 	void getBlendMode( bool &enabled, RDIBlendFunc &srcBlendFunc, RDIBlendFunc &destBlendFunc ) const
 		{ enabled = _newBlendState.blendEnable; srcBlendFunc = (RDIBlendFunc)_newBlendState.srcBlendFunc;
 		  destBlendFunc = (RDIBlendFunc)_newBlendState.destBlendFunc; }
@@ -962,6 +1184,30 @@ public:
 	{ 
 		_delegate_drawIndexed.invoke( primType, firstIndex, numIndices, firstVert, numVerts );
 	}
+	void drawIndexedBaseVertex( RDIPrimType primType, uint32 firstIndex, uint32 numIndices,
+	                            uint32 firstVert, uint32 numVerts, uint32 baseVertex )
+	{
+		ASSERT( _caps.drawBaseVertex );
+		_delegate_drawIndexedBaseVertex.invoke( primType, firstIndex, numIndices, firstVert, numVerts, baseVertex );
+	}
+	void drawIndexedInstanced( RDIPrimType primType, uint32 firstIndex, uint32 numIndices,
+	                           uint32 firstVert, uint32 numVerts, uint32 numInstances )
+	{
+		_delegate_drawIndexedInstanced.invoke( primType, firstIndex, numIndices, firstVert, numVerts, numInstances );
+	}
+	void drawIndexedInstancedBaseVertex( RDIPrimType primType, uint32 firstIndex, uint32 numIndices,
+	                                     uint32 firstVert, uint32 numVerts, uint32 numInstances, uint32 baseVertex )
+	{
+		ASSERT( _caps.instancing && _caps.drawBaseVertex );
+		_delegate_drawIndexedInstancedBaseVertex.invoke( primType, firstIndex, numIndices, firstVert, numVerts,
+		                                                 numInstances, baseVertex );
+	}
+	// Arguments are read from four uint32 values at offset in the buffer: count, instances, first, base instance
+	void drawIndirect( RDIPrimType primType, uint32 bufObj, uint32 offset )
+	{
+		ASSERT( _caps.indirectDraws );
+		_delegate_drawIndirect.invoke( primType, bufObj, offset );
+	}
 
 // -----------------------------------------------------------------------------
 // Getters
@@ -996,7 +1242,7 @@ protected:
 	RDIRasterState				_curRasterState, _newRasterState;
 	RDIBlendState				_curBlendState, _newBlendState;
 	RDIDepthStencilState		_curDepthStencilState, _newDepthStencilState;
-	RDIDrawBarriers				_memBarriers;
+	uint32						_memBarriers;  // Combination of RDIDrawBarriers
 
 	std::string					_shaderLog;
 	uint32						_depthFormat;
@@ -49,7 +49,7 @@ static const uint32 indexFormats[ 2 ] = { GL_UNSIGNED_SHORT, GL_UNSIGNED_INT };
 
 static const uint32 primitiveTypes[ 5 ] = { GL_TRIANGLES, GL_TRIANGLE_STRIP, GL_LINES, GL_POINTS, GL_TRIANGLES }; // GL_PATCHES is not supported for gl 2
 
-static const uint32 textureTypes[ 3 ] = { GL_TEXTURE_2D, GL_TEXTURE_3D, GL_TEXTURE_CUBE_MAP };
+static const uint32 textureTypes[ 4 ] = { GL_TEXTURE_2D, GL_TEXTURE_3D, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_2D_ARRAY };
 
 static const uint32 bufferMappingTypes[ 3 ] = { GL_READ_ONLY, GL_WRITE_ONLY, GL_READ_WRITE };
 
@@ -266,6 +266,9 @@ void RenderDeviceGL2::initRDIFuncs()
 	_delegate_updateBufferData.bind< RenderDeviceGL2, &RenderDeviceGL2::updateBufferData >( this );
 	_delegate_mapBuffer.bind< RenderDeviceGL2, &RenderDeviceGL2::mapBuffer >( this );
 	_delegate_unmapBuffer.bind< RenderDeviceGL2, &RenderDeviceGL2::unmapBuffer >( this );
+	_delegate_createPixelBuffer.bind< RenderDeviceGL2, &RenderDeviceGL2::createPixelBuffer >( this );
+	_delegate_mapPixelBuffer.bind< RenderDeviceGL2, &RenderDeviceGL2::mapPixelBuffer >( this );
+	_delegate_unmapPixelBuffer.bind< RenderDeviceGL2, &RenderDeviceGL2::unmapPixelBuffer >( this );
 
 	_delegate_createTexture.bind< RenderDeviceGL2, &RenderDeviceGL2::createTexture >( this );
 	_delegate_generateTextureMipmap.bind< RenderDeviceGL2, &RenderDeviceGL2::generateTextureMipmap >( this );
@@ -274,14 +277,21 @@ void RenderDeviceGL2::initRDIFuncs()
 	_delegate_updateTextureData.bind< RenderDeviceGL2, &RenderDeviceGL2::updateTextureData >( this );
 	_delegate_getTextureData.bind< RenderDeviceGL2, &RenderDeviceGL2::getTextureData >( this );
 	_delegate_bindImageToTexture.bind< RenderDeviceGL2, &RenderDeviceGL2::bindImageToTexture >( this );
+	_delegate_updateTextureFromBuffer.bind< RenderDeviceGL2, &RenderDeviceGL2::updateTextureFromBuffer >( this );
+	_delegate_copyTextureSlice.bind< RenderDeviceGL2, &RenderDeviceGL2::copyTextureSlice >( this );
+	_delegate_getTextureHandle.bind< RenderDeviceGL2, &RenderDeviceGL2::getTextureHandle >( this );
 
 	_delegate_createShader.bind< RenderDeviceGL2, &RenderDeviceGL2::createShader >( this );
+	_delegate_beginCreatingShader.bind< RenderDeviceGL2, &RenderDeviceGL2::beginCreatingShader >( this );
+	_delegate_isShaderPending.bind< RenderDeviceGL2, &RenderDeviceGL2::isShaderPending >( this );
+	_delegate_finishCreatingShader.bind< RenderDeviceGL2, &RenderDeviceGL2::finishCreatingShader >( this );
 	_delegate_destroyShader.bind< RenderDeviceGL2, &RenderDeviceGL2::destroyShader >( this );
 	_delegate_bindShader.bind< RenderDeviceGL2, &RenderDeviceGL2::bindShader >( this );
 	_delegate_getShaderConstLoc.bind< RenderDeviceGL2, &RenderDeviceGL2::getShaderConstLoc >( this );
 	_delegate_getShaderSamplerLoc.bind< RenderDeviceGL2, &RenderDeviceGL2::getShaderSamplerLoc >( this );
 	_delegate_getShaderBufferLoc.bind< RenderDeviceGL2, &RenderDeviceGL2::getShaderBufferLoc >( this );
 	_delegate_runComputeShader.bind< RenderDeviceGL2, &RenderDeviceGL2::runComputeShader >( this );
+	_delegate_runComputeShaderIndirect.bind< RenderDeviceGL2, &RenderDeviceGL2::runComputeShaderIndirect >( this );
 	_delegate_setShaderConst.bind< RenderDeviceGL2, &RenderDeviceGL2::setShaderConst >( this );
 	_delegate_setShaderSampler.bind< RenderDeviceGL2, &RenderDeviceGL2::setShaderSampler >( this );
 	_delegate_getDefaultVSCode.bind< RenderDeviceGL2, &RenderDeviceGL2::getDefaultVSCode >( this );
@@ -301,12 +311,20 @@ void RenderDeviceGL2::initRDIFuncs()
 	_delegate_getQueryResult.bind< RenderDeviceGL2, &RenderDeviceGL2::getQueryResult >( this );
 
 	_delegate_createGPUTimer.bind< RenderDeviceGL2, &RenderDeviceGL2::createGPUTimer >( this );
+	_delegate_createFence.bind< RenderDeviceGL2, &RenderDeviceGL2::createFence >( this );
+	_delegate_isFenceSignaled.bind< RenderDeviceGL2, &RenderDeviceGL2::isFenceSignaled >( this );
+	_delegate_waitForFence.bind< RenderDeviceGL2, &RenderDeviceGL2::waitForFence >( this );
+	_delegate_destroyFence.bind< RenderDeviceGL2, &RenderDeviceGL2::destroyFence >( this );
 	_delegate_commitStates.bind< RenderDeviceGL2, &RenderDeviceGL2::commitStates >( this );
 	_delegate_resetStates.bind< RenderDeviceGL2, &RenderDeviceGL2::resetStates >( this );
 	_delegate_clear.bind< RenderDeviceGL2, &RenderDeviceGL2::clear >( this );
 
 	_delegate_draw.bind< RenderDeviceGL2, &RenderDeviceGL2::draw >( this );
 	_delegate_drawIndexed.bind< RenderDeviceGL2, &RenderDeviceGL2::drawIndexed >( this );
+	_delegate_drawIndexedBaseVertex.bind< RenderDeviceGL2, &RenderDeviceGL2::drawIndexedBaseVertex >( this );
+	_delegate_drawIndexedInstanced.bind< RenderDeviceGL2, &RenderDeviceGL2::drawIndexedInstanced >( this );
+	_delegate_drawIndexedInstancedBaseVertex.bind< RenderDeviceGL2, &RenderDeviceGL2::drawIndexedInstancedBaseVertex >( this );
+	_delegate_drawIndirect.bind< RenderDeviceGL2, &RenderDeviceGL2::drawIndirect >( this );
 	_delegate_setStorageBuffer.bind< RenderDeviceGL2, &RenderDeviceGL2::setStorageBuffer >( this );
 }
 
@@ -406,6 +424,13 @@ bool RenderDeviceGL2::init()
 	_caps.texETC2 = false;
 	_caps.texBPTC = glExt::ARB_texture_compression_bptc;
 	_caps.texASTC = false;
+	_caps.parallelShaderCompile = false;
+	_caps.drawBaseVertex = false;
+	_caps.pixelBuffers = false;
+	_caps.indirectDraws = false;
+	_caps.clipDistances = false;
+	_caps.texArrays = false;
+	_caps.bindlessTextures = false;
 
 	// Init states before creating test render buffer, to
 	// ensure binding the current FBO again
@@ -705,6 +730,29 @@ void RenderDeviceGL2::unmapBuffer( uint32 geoObj, uint32 bufObj )
 }
 
 
+uint32 RenderDeviceGL2::createPixelBuffer( uint32 size )
+{
+	// Pixel buffers are not supported by this backend (caps.pixelBuffers is false)
+	H3D_UNUSED_VAR( size );
+
+	return 0;
+}
+
+
+void *RenderDeviceGL2::mapPixelBuffer( uint32 bufObj )
+{
+	H3D_UNUSED_VAR( bufObj );
+
+	return 0x0;
+}
+
+
+void RenderDeviceGL2::unmapPixelBuffer( uint32 bufObj )
+{
+	H3D_UNUSED_VAR( bufObj );
+}
+
+
 // =================================================================================================
 // Textures
 // =================================================================================================
@@ -927,6 +975,38 @@ void RenderDeviceGL2::bindImageToTexture(uint32 texObj, void *eglImage)
 	}
 }
 
+
+void RenderDeviceGL2::updateTextureFromBuffer( uint32 texObj, uint32 bufObj, uint32 offset )
+{
+	H3D_UNUSED_VAR( texObj );
+	H3D_UNUSED_VAR( bufObj );
+	H3D_UNUSED_VAR( offset );
+
+	ASSERT( _caps.pixelBuffers );
+}
+
+
+void RenderDeviceGL2::copyTextureSlice( uint32 srcTexObj, int srcSlice, uint32 dstTexObj, int dstSlice, int mipLevel )
+{
+	H3D_UNUSED_VAR( srcTexObj );
+	H3D_UNUSED_VAR( srcSlice );
+	H3D_UNUSED_VAR( dstTexObj );
+	H3D_UNUSED_VAR( dstSlice );
+	H3D_UNUSED_VAR( mipLevel );
+
+	ASSERT( _caps.texArrays );
+}
+
+
+uint64 RenderDeviceGL2::getTextureHandle( uint32 texObj, uint16 samplerState )
+{
+	H3D_UNUSED_VAR( texObj );
+	H3D_UNUSED_VAR( samplerState );
+
+	ASSERT( _caps.bindlessTextures );
+	return 0;
+}
+
 // =================================================================================================
 // Shaders
 // =================================================================================================
@@ -1036,6 +1116,120 @@ uint32 RenderDeviceGL2::createShader( const char *vertexShaderSrc, const char *f
 	RDIShaderGL2 &shader = _shaders.getRef( shaderId );
 	shader.oglProgramObj = programObj;
 	
+	initShaderInputLayouts( shader );
+
+	return shaderId;
+}
+
+
+uint32 RenderDeviceGL2::beginCreatingShader( const char *vertexShaderSrc, const char *fragmentShaderSrc, const char *geometryShaderSrc,
+                                            const char *tessControlShaderSrc, const char *tessEvaluationShaderSrc, const char *computeShaderSrc )
+{
+	H3D_UNUSED_VAR( geometryShaderSrc );
+	H3D_UNUSED_VAR( tessControlShaderSrc );
+	H3D_UNUSED_VAR( tessEvaluationShaderSrc );
+	H3D_UNUSED_VAR( computeShaderSrc );
+
+	const char *sources[2] = { vertexShaderSrc, fragmentShaderSrc };
+	const uint32 stages[2] = { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER };
+
+	_shaderLog = "";
+
+	// No status is queried here so that the driver can compile and link in the background
+	uint32 programObj = glCreateProgram();
+	for( uint32 i = 0; i < 2; ++i )
+	{
+		if( sources[i] == 0x0 ) continue;
+
+		uint32 shaderObj = glCreateShader( stages[i] );
+		glShaderSource( shaderObj, 1, &sources[i], 0x0 );
+		glCompileShader( shaderObj );
+		glAttachShader( programObj, shaderObj );
+		glDeleteShader( shaderObj );
+	}
+	glLinkProgram( programObj );
+
+	uint32 shaderId = _shaders.add( RDIShaderGL2() );
+	RDIShaderGL2 &shader = _shaders.getRef( shaderId );
+	shader.oglProgramObj = programObj;
+	shader.pending = true;
+
+	return shaderId;
+}
+
+
+bool RenderDeviceGL2::isShaderPending( uint32 shaderId )
+{
+	RDIShaderGL2 &shader = _shaders.getRef( shaderId );
+	if( !shader.pending ) return false;
+
+	// Status cannot be queried without blocking, finishing waits for the driver
+	return false;
+}
+
+
+bool RenderDeviceGL2::finishCreatingShader( uint32 &shaderId )
+{
+	RDIShaderGL2 &shader = _shaders.getRef( shaderId );
+	if( !shader.pending ) return true;
+	shader.pending = false;
+
+	int infologLength = 0;
+	int charsWritten = 0;
+	char *infoLog = 0x0;
+	int status;
+
+	_shaderLog = "";
+
+	// Gather compiler output of failed stages, the shader objects live as long as they are attached
+	glGetProgramiv( shader.oglProgramObj, GL_LINK_STATUS, &status );
+	if( !status )
+	{
+		uint32 shaderObjs[2];
+		int numShaderObjs = 0;
+		glGetAttachedShaders( shader.oglProgramObj, 2, &numShaderObjs, shaderObjs );
+		for( int i = 0; i < numShaderObjs; ++i )
+		{
+			glGetShaderiv( shaderObjs[i], GL_COMPILE_STATUS, &status );
+			glGetShaderiv( shaderObjs[i], GL_INFO_LOG_LENGTH, &infologLength );
+			if( status || infologLength <= 1 ) continue;
+
+			int stage;
+			glGetShaderiv( shaderObjs[i], GL_SHADER_TYPE, &stage );
+			infoLog = new char[infologLength];
+			glGetShaderInfoLog( shaderObjs[i], infologLength, &charsWritten, infoLog );
+			_shaderLog = _shaderLog + (stage == GL_VERTEX_SHADER ? "[Vertex Shader]\n" :
+			                           stage == GL_FRAGMENT_SHADER ? "[Fragment Shader]\n" : "[Shader]\n") + infoLog;
+			delete[] infoLog; infoLog = 0x0;
+		}
+	}
+
+	glGetProgramiv( shader.oglProgramObj, GL_INFO_LOG_LENGTH, &infologLength );
+	if( infologLength > 1 )
+	{
+		infoLog = new char[infologLength];
+		glGetProgramInfoLog( shader.oglProgramObj, infologLength, &charsWritten, infoLog );
+		_shaderLog = _shaderLog + "[Linking]\n" + infoLog;
+		delete[] infoLog; infoLog = 0x0;
+	}
+
+	glGetProgramiv( shader.oglProgramObj, GL_LINK_STATUS, &status );
+	if( !status )
+	{
+		destroyShader( shaderId );
+		return false;
+	}
+
+	initShaderInputLayouts( shader );
+
+	return true;
+}
+
+
+void RenderDeviceGL2::initShaderInputLayouts( RDIShaderGL2 &shader )
+{
+	uint32 programObj = shader.oglProgramObj;
+
 	int attribCount;
 	glGetProgramiv( programObj, GL_ACTIVE_ATTRIBUTES, &attribCount );
 	
@@ -1072,8 +1266,6 @@ uint32 RenderDeviceGL2::createShader( const char *vertexShaderSrc, const char *f
 
 		shader.inputLayouts[i].valid = allAttribsFound;
 	}
-
-	return shaderId;
 }
 
 
@@ -1195,6 +1387,14 @@ void RenderDeviceGL2::runComputeShader( uint32 shaderId, uint32 xDim, uint32 yDi
 	Modules::log().writeError( "Compute shaders are not supported on OpenGL 2 render device." );
 }
 
+
+void RenderDeviceGL2::runComputeShaderIndirect( uint32 shaderId, uint32 bufObj, uint32 offset )
+{
+	H3D_UNUSED_VAR( shaderId );
+	H3D_UNUSED_VAR( bufObj );
+	H3D_UNUSED_VAR( offset );
+}
+
 // =================================================================================================
 // Renderbuffers
 // =================================================================================================
@@ -1574,6 +1774,39 @@ uint32 RenderDeviceGL2::getQueryResult( uint32 queryObj )
 }
 
 
+// =================================================================================================
+// Fences
+// =================================================================================================
+
+uint32 RenderDeviceGL2::createFence()
+{
+	// Sync objects are not available in OpenGL 2, commands are treated as completed immediately
+	return 0;
+}
+
+
+bool RenderDeviceGL2::isFenceSignaled( uint32 fenceObj )
+{
+	H3D_UNUSED_VAR( fenceObj );
+
+	return true;
+}
+
+
+bool RenderDeviceGL2::waitForFence( uint32 fenceObj )
+{
+	H3D_UNUSED_VAR( fenceObj );
+
+	return true;
+}
+
+
+void RenderDeviceGL2::destroyFence( uint32 &fenceObj )
+{
+	fenceObj = 0;
+}
+
+
 // =================================================================================================
 // Internal state management
 // =================================================================================================
@@ -1730,7 +1963,11 @@ void RenderDeviceGL2::applyRenderStates()
 										   GL_ONE_MINUS_DST_COLOR, GL_ONE_MINUS_SRC_COLOR, GL_ZERO, GL_ZERO, GL_ZERO, GL_ZERO, GL_ZERO, GL_ZERO };
 
 			glEnable( GL_BLEND );
-			glBlendFunc( oglBlendFuncs[_newBlendState.srcBlendFunc], oglBlendFuncs[_newBlendState.destBlendFunc] );
+			if( _newBlendState.separateAlphaBlend )
+				glBlendFuncSeparate( oglBlendFuncs[_newBlendState.srcBlendFunc], oglBlendFuncs[_newBlendState.destBlendFunc],
+				                     oglBlendFuncs[_newBlendState.srcAlphaBlendFunc], oglBlendFuncs[_newBlendState.destAlphaBlendFunc] );
+			else
+				glBlendFunc( oglBlendFuncs[_newBlendState.srcBlendFunc], oglBlendFuncs[_newBlendState.destBlendFunc] );
 		}
 		
 		_curBlendState.hash = _newBlendState.hash;
@@ -1977,5 +2214,61 @@ void RenderDeviceGL2::drawIndexed( RDIPrimType primType, uint32 firstIndex, uint
 	CHECK_GL_ERROR
 }
 
+
+void RenderDeviceGL2::drawIndexedBaseVertex( RDIPrimType primType, uint32 firstIndex, uint32 numIndices,
+                                             uint32 firstVert, uint32 numVerts, uint32 baseVertex )
+{
+	// Base vertex draws are not supported by this backend (caps.drawBaseVertex is false), so this is never called
+	H3D_UNUSED_VAR( primType );
+	H3D_UNUSED_VAR( firstIndex );
+	H3D_UNUSED_VAR( numIndices );
+	H3D_UNUSED_VAR( firstVert );
+	H3D_UNUSED_VAR( numVerts );
+	H3D_UNUSED_VAR( baseVertex );
+
+	ASSERT( _caps.drawBaseVertex );
+}
+
+
+void RenderDeviceGL2::drawIndexedInstanced( RDIPrimType primType, uint32 firstIndex, uint32 numIndices,
+                                            uint32 firstVert, uint32 numVerts, uint32 numInstances )
+{
+	// Instancing is not supported by this backend (caps.instancing is false), so this is never called
+	H3D_UNUSED_VAR( primType );
+	H3D_UNUSED_VAR( firstIndex );
+	H3D_UNUSED_VAR( numIndices );
+	H3D_UNUSED_VAR( firstVert );
+	H3D_UNUSED_VAR( numVerts );
+	H3D_UNUSED_VAR( numInstances );
+
+	ASSERT( _caps.instancing );
+}
+
+
+void RenderDeviceGL2::drawIndexedInstancedBaseVertex( RDIPrimType primType, uint32 firstIndex, uint32 numIndices,
+                                                      uint32 firstVert, uint32 numVerts, uint32 numInstances,
+                                                      uint32 baseVertex )
+{
+	// Instancing is not supported by this backend (caps.instancing is false), so this is never called
+	H3D_UNUSED_VAR( primType );
+	H3D_UNUSED_VAR( firstIndex );
+	H3D_UNUSED_VAR( numIndices );
+	H3D_UNUSED_VAR( firstVert );
+	H3D_UNUSED_VAR( numVerts );
+	H3D_UNUSED_VAR( numInstances );
+	H3D_UNUSED_VAR( baseVertex );
+
+	ASSERT( _caps.instancing );
+}
+
+
+void RenderDeviceGL2::drawIndirect( RDIPrimType primType, uint32 bufObj, uint32 offset )
+{
+	// Indirect draws are not supported by this backend (caps.indirectDraws is false), so this is never called
+	H3D_UNUSED_VAR( primType );
+	H3D_UNUSED_VAR( bufObj );
+	H3D_UNUSED_VAR( offset );
+}
+
 }  // namespace RDI_GL2
 }  // namespace Horde3D
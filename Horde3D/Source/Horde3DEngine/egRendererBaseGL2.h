@@ -160,8 +160,9 @@ struct RDIShaderGL2
 {
 	uint32				oglProgramObj;
 	RDIInputLayoutGL2	inputLayouts[MaxNumVertexLayouts];
+	bool				pending;  // Compilation and linking started but results not queried yet
 
-	RDIShaderGL2() : oglProgramObj( 0 )
+	RDIShaderGL2() : oglProgramObj( 0 ), pending( false )
 	{
 
 	}
@@ -236,6 +237,9 @@ public:
 	void updateBufferData( uint32 geoObj, uint32 bufObj, uint32 offset, uint32 size, void *data );
 	void *mapBuffer( uint32 geoObj, uint32 bufObj, uint32 offset, uint32 size, RDIBufferMappingTypes mapType );
 	void unmapBuffer( uint32 geoObj, uint32 bufObj );
+	uint32 createPixelBuffer( uint32 size );
+	void *mapPixelBuffer( uint32 bufObj );
+	void unmapPixelBuffer( uint32 bufObj );
 	// 	uint32 getBufferMem() const { return _bufferMem; }
 
 	// Textures
@@ -249,10 +253,17 @@ public:
 	bool getTextureData( uint32 texObj, int slice, int mipLevel, void *buffer );
 // 	uint32 getTextureMem() const { return _textureMem; }
     void bindImageToTexture( uint32 texObj, void* eglImage );
+	void updateTextureFromBuffer( uint32 texObj, uint32 bufObj, uint32 offset );
+	void copyTextureSlice( uint32 srcTexObj, int srcSlice, uint32 dstTexObj, int dstSlice, int mipLevel );
+	uint64 getTextureHandle( uint32 texObj, uint16 samplerState );
 
 	// Shaders
 	uint32 createShader( const char *vertexShaderSrc, const char *fragmentShaderSrc, const char *geometryShaderSrc,
 						 const char *tessControlShaderSrc, const char *tessEvaluationShaderSrc, const char *computeShaderSrc );
+	uint32 beginCreatingShader( const char *vertexShaderSrc, const char *fragmentShaderSrc, const char *geometryShaderSrc,
+								 const char *tessControlShaderSrc, const char *tessEvaluationShaderSrc, const char *computeShaderSrc );
+	bool isShaderPending( uint32 shaderId );
+	bool finishCreatingShader( uint32 &shaderId );
 	void destroyShader(uint32 &shaderId );
 	void bindShader( uint32 shaderId );
 	std::string getShaderLog() const { return _shaderLog; }
@@ -264,6 +275,7 @@ public:
 	const char *getDefaultVSCode();
 	const char *getDefaultFSCode();
 	void runComputeShader( uint32 shaderId, uint32 xDim, uint32 yDim, uint32 zDim );
+	void runComputeShaderIndirect( uint32 shaderId, uint32 bufObj, uint32 offset );
 
 	// Renderbuffers
 	uint32 createRenderBuffer( uint32 width, uint32 height, TextureFormats::List format,
@@ -282,6 +294,12 @@ public:
 	void endQuery( uint32 queryObj );
 	uint32 getQueryResult( uint32 queryObj );
 
+	// Fences
+	uint32 createFence();
+	bool isFenceSignaled( uint32 fenceObj );
+	bool waitForFence( uint32 fenceObj );
+	void destroyFence( uint32 &fenceObj );
+
 	// Render Device dependent GPU Timer
 	GPUTimer *createGPUTimer() { return new GPUTimerGL2(); }
 
@@ -297,6 +315,13 @@ public:
 	void draw( RDIPrimType primType, uint32 firstVert, uint32 numVerts );
 	void drawIndexed( RDIPrimType primType, uint32 firstIndex, uint32 numIndices,
 	                  uint32 firstVert, uint32 numVerts );
+	void drawIndexedBaseVertex( RDIPrimType primType, uint32 firstIndex, uint32 numIndices,
+	                            uint32 firstVert, uint32 numVerts, uint32 baseVertex );
+	void drawIndexedInstanced( RDIPrimType primType, uint32 firstIndex, uint32 numIndices,
+	                           uint32 firstVert, uint32 numVerts, uint32 numInstances );
+	void drawIndexedInstancedBaseVertex( RDIPrimType primType, uint32 firstIndex, uint32 numIndices,
+	                                     uint32 firstVert, uint32 numVerts, uint32 numInstances, uint32 baseVertex );
+	void drawIndirect( RDIPrimType primType, uint32 bufObj, uint32 offset );
 
 // -----------------------------------------------------------------------------
 // Getters
@@ -325,6 +350,7 @@ protected:
 
 	uint32 createShaderProgram( const char *vertexShaderSrc, const char *fragmentShaderSrc );
 	bool linkShaderProgram( uint32 programObj );
+	void initShaderInputLayouts( RDIShaderGL2 &shader );
 	void resolveRenderBuffer( uint32 rbObj );
 	inline uint32 createBuffer( uint32 type, uint32 size, const void *data );
 
@@ -54,9 +54,11 @@ static const uint32 indexFormats[ 2 ] = { GL_UNSIGNED_SHORT, GL_UNSIGNED_INT };
 
 static const uint32 primitiveTypes[ 5 ] = { GL_TRIANGLES, GL_TRIANGLE_STRIP, GL_LINES, GL_POINTS, GL_PATCHES };
 
-static const uint32 textureTypes[ 3 ] = { GL_TEXTURE_2D, GL_TEXTURE_3D, GL_TEXTURE_CUBE_MAP };
+static const uint32 textureTypes[ 4 ] = { GL_TEXTURE_2D, GL_TEXTURE_3D, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_2D_ARRAY };
 
-static const uint32 memoryBarrierType[ 3 ] = { GL_BUFFER_UPDATE_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT, GL_ELEMENT_ARRAY_BARRIER_BIT, GL_SHADER_IMAGE_ACCESS_BARRIER_BIT };
+// GL barrier bits for each flag of RDIDrawBarriers
+static const uint32 memoryBarrierType[ 6 ] = { GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT, GL_ELEMENT_ARRAY_BARRIER_BIT,
+	GL_SHADER_IMAGE_ACCESS_BARRIER_BIT, GL_SHADER_STORAGE_BARRIER_BIT, GL_COMMAND_BARRIER_BIT, GL_BUFFER_UPDATE_BARRIER_BIT };
 
 static const uint32 bufferMappingTypes[ 3 ] = { GL_MAP_READ_BIT, GL_MAP_WRITE_BIT, GL_MAP_READ_BIT | GL_MAP_WRITE_BIT };
 
@@ -271,6 +273,8 @@ RenderDeviceGL4::RenderDeviceGL4()
 // 	_texSlots.reserve( _maxTexSlots ); // reserve memory
 
 	_doubleBuffered = false;
+	memset( _boundSamplers, 0, sizeof( _boundSamplers ) );
+
 	// add default geometry for resetting
 	RDIGeometryInfoGL4 defGeom;
 	defGeom.atrribsBinded = true;
@@ -280,6 +284,8 @@ RenderDeviceGL4::RenderDeviceGL4()
 
 RenderDeviceGL4::~RenderDeviceGL4()
 {
+	for( size_t i = 0; i < _samplerObjs.size(); ++i )
+		glDeleteSamplers( 1, &_samplerObjs[ i ].second );
 }
 
 
@@ -306,6 +312,9 @@ void RenderDeviceGL4::initRDIFuncs()
 	_delegate_updateBufferData.bind< RenderDeviceGL4, &RenderDeviceGL4::updateBufferData >( this );
 	_delegate_mapBuffer.bind< RenderDeviceGL4, &RenderDeviceGL4::mapBuffer >( this );
 	_delegate_unmapBuffer.bind< RenderDeviceGL4, &RenderDeviceGL4::unmapBuffer >( this );
+	_delegate_createPixelBuffer.bind< RenderDeviceGL4, &RenderDeviceGL4::createPixelBuffer >( this );
+	_delegate_mapPixelBuffer.bind< RenderDeviceGL4, &RenderDeviceGL4::mapPixelBuffer >( this );
+	_delegate_unmapPixelBuffer.bind< RenderDeviceGL4, &RenderDeviceGL4::unmapPixelBuffer >( this );
 
 	_delegate_createTexture.bind< RenderDeviceGL4, &RenderDeviceGL4::createTexture >( this );
 	_delegate_generateTextureMipmap.bind< RenderDeviceGL4, &RenderDeviceGL4::generateTextureMipmap >( this );
@@ -314,14 +323,21 @@ void RenderDeviceGL4::initRDIFuncs()
 	_delegate_updateTextureData.bind< RenderDeviceGL4, &RenderDeviceGL4::updateTextureData >( this );
 	_delegate_getTextureData.bind< RenderDeviceGL4, &RenderDeviceGL4::getTextureData >( this );
 	_delegate_bindImageToTexture.bind< RenderDeviceGL4, &RenderDeviceGL4::bindImageToTexture >( this );
+	_delegate_updateTextureFromBuffer.bind< RenderDeviceGL4, &RenderDeviceGL4::updateTextureFromBuffer >( this );
+	_delegate_copyTextureSlice.bind< RenderDeviceGL4, &RenderDeviceGL4::copyTextureSlice >( this );
+	_delegate_getTextureHandle.bind< RenderDeviceGL4, &RenderDeviceGL4::getTextureHandle >( this );
 
 	_delegate_createShader.bind< RenderDeviceGL4, &RenderDeviceGL4::createShader >( this );
+	_delegate_beginCreatingShader.bind< RenderDeviceGL4, &RenderDeviceGL4::beginCreatingShader >( this );
+	_delegate_isShaderPending.bind< RenderDeviceGL4, &RenderDeviceGL4::isShaderPending >( this );
+	_delegate_finishCreatingShader.bind< RenderDeviceGL4, &RenderDeviceGL4::finishCreatingShader >( this );
 	_delegate_destroyShader.bind< RenderDeviceGL4, &RenderDeviceGL4::destroyShader >( this );
 	_delegate_bindShader.bind< RenderDeviceGL4, &RenderDeviceGL4::bindShader >( this );
 	_delegate_getShaderConstLoc.bind< RenderDeviceGL4, &RenderDeviceGL4::getShaderConstLoc >( this );
 	_delegate_getShaderSamplerLoc.bind< RenderDeviceGL4, &RenderDeviceGL4::getShaderSamplerLoc >( this );
 	_delegate_getShaderBufferLoc.bind< RenderDeviceGL4, &RenderDeviceGL4::getShaderBufferLoc >( this );
 	_delegate_runComputeShader.bind< RenderDeviceGL4, &RenderDeviceGL4::runComputeShader >( this );
+	_delegate_runComputeShaderIndirect.bind< RenderDeviceGL4, &RenderDeviceGL4::runComputeShaderIndirect >( this );
 	_delegate_setShaderConst.bind< RenderDeviceGL4, &RenderDeviceGL4::setShaderConst >( this );
 	_delegate_setShaderSampler.bind< RenderDeviceGL4, &RenderDeviceGL4::setShaderSampler >( this );
 	_delegate_getDefaultVSCode.bind< RenderDeviceGL4, &RenderDeviceGL4::getDefaultVSCode >( this );
@@ -341,12 +357,20 @@ void RenderDeviceGL4::initRDIFuncs()
 	_delegate_getQueryResult.bind< RenderDeviceGL4, &RenderDeviceGL4::getQueryResult >( this );
 
 	_delegate_createGPUTimer.bind< RenderDeviceGL4, &RenderDeviceGL4::createGPUTimer >( this );
+	_delegate_createFence.bind< RenderDeviceGL4, &RenderDeviceGL4::createFence >( this );
+	_delegate_isFenceSignaled.bind< RenderDeviceGL4, &RenderDeviceGL4::isFenceSignaled >( this );
+	_delegate_waitForFence.bind< RenderDeviceGL4, &RenderDeviceGL4::waitForFence >( this );
+	_delegate_destroyFence.bind< RenderDeviceGL4, &RenderDeviceGL4::destroyFence >( this );
 	_delegate_commitStates.bind< RenderDeviceGL4, &RenderDeviceGL4::commitStates >( this );
 	_delegate_resetStates.bind< RenderDeviceGL4, &RenderDeviceGL4::resetStates >( this );
 	_delegate_clear.bind< RenderDeviceGL4, &RenderDeviceGL4::clear >( this );
 
 	_delegate_draw.bind< RenderDeviceGL4, &RenderDeviceGL4::draw >( this );
 	_delegate_drawIndexed.bind< RenderDeviceGL4, &RenderDeviceGL4::drawIndexed >( this );
+	_delegate_drawIndexedBaseVertex.bind< RenderDeviceGL4, &RenderDeviceGL4::drawIndexedBaseVertex >( this );
+	_delegate_drawIndexedInstanced.bind< RenderDeviceGL4, &RenderDeviceGL4::drawIndexedInstanced >( this );
+	_delegate_drawIndexedInstancedBaseVertex.bind< RenderDeviceGL4, &RenderDeviceGL4::drawIndexedInstancedBaseVertex >( this );
+	_delegate_drawIndirect.bind< RenderDeviceGL4, &RenderDeviceGL4::drawIndirect >( this );
 	_delegate_setStorageBuffer.bind< RenderDeviceGL4, &RenderDeviceGL4::setStorageBuffer >( this );
 }
 
@@ -437,6 +461,16 @@ bool RenderDeviceGL4::init()
 	_caps.texETC2 = glExt::ARB_ES3_compatibility;
 	_caps.texBPTC = glExt::ARB_texture_compression_bptc;
 	_caps.texASTC = glExt::KHR_texture_compression_astc;
+	_caps.parallelShaderCompile = glExt::KHR_parallel_shader_compile;
+	_caps.drawBaseVertex = true;
+	_caps.pixelBuffers = true;
+	_caps.indirectDraws = _caps.computeShaders;
+	_caps.clipDistances = true;
+	_caps.texArrays = glCopyImageSubData != 0x0;
+	_caps.bindlessTextures = glExt::ARB_bindless_texture;
+
+	// Let the driver choose the number of background compiler threads
+	if( _caps.parallelShaderCompile ) glMaxShaderCompilerThreadsKHR( 0xFFFFFFFF );
 
 	// Find maximum number of storage buffers in compute shader
 	glGetIntegerv( GL_MAX_COMPUTE_SHADER_STORAGE_BLOCKS, (GLint *) &_maxComputeBufferAttachments );
@@ -564,6 +598,7 @@ void RenderDeviceGL4::finishCreatingGeometry( uint32 geoObj )
 			glBindBuffer( GL_ARRAY_BUFFER, buf.glObj );
 			glVertexAttribPointer( i, attrib.size, GL_FLOAT, GL_FALSE,
 								   vbSlot.stride, ( char * ) 0 + vbSlot.offset + attrib.offset );
+			glVertexAttribDivisor( i, attrib.divisor );
 
 			newVertexAttribMask |= 1 << i;
 		}
@@ -822,6 +857,53 @@ void RenderDeviceGL4::unmapBuffer( uint32 geoObj, uint32 bufObj )
 }
 
 
+uint32 RenderDeviceGL4::createPixelBuffer( uint32 size )
+{
+	if( glExt::majorVersion * 10 + glExt::minorVersion < 44 )
+		return createBuffer( GL_PIXEL_UNPACK_BUFFER, size, 0x0 );
+
+	// Persistently mapped storage, so uploads only need to be fenced instead of remapping the buffer
+	RDIBufferGL4 buf;
+	GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+	buf.type = GL_PIXEL_UNPACK_BUFFER;
+	buf.size = size;
+	glGenBuffers( 1, &buf.glObj );
+	glBindBuffer( buf.type, buf.glObj );
+	glBufferStorage( buf.type, size, 0x0, flags );
+	buf.persistentPtr = glMapBufferRange( buf.type, 0, size, flags );
+	glBindBuffer( buf.type, 0 );
+
+	_bufferMem += size;
+	return _buffers.add( buf );
+}
+
+
+void *RenderDeviceGL4::mapPixelBuffer( uint32 bufObj )
+{
+	const RDIBufferGL4 &buf = _buffers.getRef( bufObj );
+	if( buf.persistentPtr != 0x0 ) return buf.persistentPtr;
+
+	glBindBuffer( buf.type, buf.glObj );
+	void *ptr = glMapBufferRange( buf.type, 0, buf.size,
+	                              GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT );
+	glBindBuffer( buf.type, 0 );
+
+	return ptr;
+}
+
+
+void RenderDeviceGL4::unmapPixelBuffer( uint32 bufObj )
+{
+	const RDIBufferGL4 &buf = _buffers.getRef( bufObj );
+	if( buf.persistentPtr != 0x0 ) return;
+
+	glBindBuffer( buf.type, buf.glObj );
+	glUnmapBuffer( buf.type );
+	glBindBuffer( buf.type, 0 );
+}
+
+
 // =================================================================================================
 // Textures
 // =================================================================================================
@@ -877,7 +959,7 @@ uint32 RenderDeviceGL4::createTexture( TextureTypes::List type, int width, int h
 
 	if ( glTexStorage2D && glTexStorage3D ) {
 		// Prefer immutable format texture if available
-		if ( tex.type != GL_TEXTURE_3D ) {
+		if ( tex.type != GL_TEXTURE_3D && tex.type != GL_TEXTURE_2D_ARRAY ) {
 			glTexStorage2D( tex.type, maxMipLevel+1, tex.glFmt, tex.width, tex.height );
 		} else {
 			glTexStorage3D( tex.type, maxMipLevel+1, tex.glFmt, tex.width, tex.height, tex.depth );
@@ -920,6 +1002,16 @@ uint32 RenderDeviceGL4::createTexture( TextureTypes::List type, int width, int h
 						glTexImage3D( GL_TEXTURE_3D, mipLevel, tex.glFmt, mipWidth, mipHeight, depth, 0,
 									  inputFormat, inputType, nullptr );
 				}
+				else if ( tex.type == textureTypes[ TextureTypes::Tex2DArray ] && slice == 0 )
+				{
+					// Layers are not reduced along with the mip level
+					if( compressed )
+						glCompressedTexImage3D( GL_TEXTURE_2D_ARRAY, mipLevel, tex.glFmt, mipWidth, mipHeight, tex.depth, 0,
+												calcTextureSize( format, mipWidth, mipHeight, 1 ) * tex.depth, nullptr );
+					else
+						glTexImage3D( GL_TEXTURE_2D_ARRAY, mipLevel, tex.glFmt, mipWidth, mipHeight, tex.depth, 0,
+									  inputFormat, inputType, nullptr );
+				}
 			}
 		}
 
@@ -937,7 +1029,10 @@ uint32 RenderDeviceGL4::createTexture( TextureTypes::List type, int width, int h
 		glBindTexture( _textures.getRef( _texSlots[15].texObj ).type, _textures.getRef( _texSlots[15].texObj ).glObj );
 
 	// Calculate memory requirements
-	tex.memSize = calcTextureSize( format, width, height, depth, maxMipLevel );
+	if( type == TextureTypes::Tex2DArray )
+		tex.memSize = calcTextureSize( format, width, height, 1, maxMipLevel ) * depth;
+	else
+		tex.memSize = calcTextureSize( format, width, height, depth, maxMipLevel );
 	if( type == TextureTypes::TexCube ) tex.memSize *= 6;
 	_textureMem += tex.memSize;
 	
@@ -997,10 +1092,21 @@ void RenderDeviceGL4::uploadTextureData( uint32 texObj, int slice, int mipLevel,
 			glTexSubImage3D( GL_TEXTURE_3D, mipLevel, 0, 0, 0, width, height, depth,
 			                 inputFormat, inputType, pixels );
 	}
+	else if ( tex.type == textureTypes[ TextureTypes::Tex2DArray ] )
+	{
+		// A slice is a single layer of the array
+		if( compressed )
+			glCompressedTexSubImage3D( GL_TEXTURE_2D_ARRAY, mipLevel, 0, 0, slice, width, height, 1,
+			                           tex.glFmt, calcTextureSize( format, width, height, 1 ), pixels );
+		else
+			glTexSubImage3D( GL_TEXTURE_2D_ARRAY, mipLevel, 0, 0, slice, width, height, 1,
+			                 inputFormat, inputType, pixels );
+	}
 
-	if( tex.genMips && (tex.type != GL_TEXTURE_CUBE_MAP || slice == 5) )
+	if( tex.genMips && (tex.type != GL_TEXTURE_CUBE_MAP || slice == 5) &&
+		(tex.type != GL_TEXTURE_2D_ARRAY || slice == tex.depth - 1) )
 	{
-		// Note: for cube maps mips are only generated when the side with the highest index is uploaded
+		// Note: for cube maps and arrays mips are only generated when the slice with the highest index is uploaded
 		glGenerateMipmap( tex.type );
 	}
 
@@ -1016,6 +1122,8 @@ void RenderDeviceGL4::destroyTexture( uint32& texObj )
 		return;
 	
 	const RDITextureGL4 &tex = _textures.getRef( texObj );
+	for( size_t i = 0; i < tex.handles.size(); ++i )
+		glMakeTextureHandleNonResidentARB( tex.handles[ i ].handle );
 	if( tex.glObj ) glDeleteTextures( 1, &tex.glObj );
 
 	_textureMem -= tex.memSize;
@@ -1033,6 +1141,9 @@ void RenderDeviceGL4::updateTextureData( uint32 texObj, int slice, int mipLevel,
 bool RenderDeviceGL4::getTextureData( uint32 texObj, int slice, int mipLevel, void *buffer )
 {
 	const RDITextureGL4 &tex = _textures.getRef( texObj );
+
+	// Reading single layers would require GL 4.5, arrays are only sources for sampling
+	if( tex.type == textureTypes[ TextureTypes::Tex2DArray ] ) return false;
 	
 	int target = tex.type == textureTypes[ TextureTypes::TexCube ] ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D;
 	if( target == GL_TEXTURE_CUBE_MAP ) target = GL_TEXTURE_CUBE_MAP_POSITIVE_X + slice;
@@ -1095,6 +1206,65 @@ void RenderDeviceGL4::bindImageToTexture( uint32 texObj, void *eglImage )
 	}
 }
 
+
+void RenderDeviceGL4::updateTextureFromBuffer( uint32 texObj, uint32 bufObj, uint32 offset )
+{
+	const RDITextureGL4 &tex = _textures.getRef( texObj );
+	const RDIBufferGL4 &buf = _buffers.getRef( bufObj );
+	ASSERT( tex.type == textureTypes[ TextureTypes::Tex2D ] && !isCompressedTextureFormat( tex.format ) );
+	ASSERT( offset + calcTextureSize( tex.format, tex.width, tex.height, 1 ) <= buf.size );
+
+	glActiveTexture( GL_TEXTURE15 );
+	glBindTexture( tex.type, tex.glObj );
+
+	// The copy is executed asynchronously by the driver since the source is a buffer object
+	glBindBuffer( GL_PIXEL_UNPACK_BUFFER, buf.glObj );
+	glTexSubImage2D( GL_TEXTURE_2D, 0, 0, 0, tex.width, tex.height, textureGLFormats[ tex.format ].glInputFormat,
+	                 textureGLFormats[ tex.format ].glInputType, ( char * ) 0 + offset );
+	glBindBuffer( GL_PIXEL_UNPACK_BUFFER, 0 );
+
+	if( tex.genMips ) glGenerateMipmap( tex.type );
+
+	glBindTexture( tex.type, 0 );
+	if( _texSlots[15].texObj )
+		glBindTexture( _textures.getRef( _texSlots[15].texObj ).type, _textures.getRef( _texSlots[15].texObj ).glObj );
+}
+
+
+void RenderDeviceGL4::copyTextureSlice( uint32 srcTexObj, int srcSlice, uint32 dstTexObj, int dstSlice, int mipLevel )
+{
+	const RDITextureGL4 &src = _textures.getRef( srcTexObj );
+	const RDITextureGL4 &dst = _textures.getRef( dstTexObj );
+	ASSERT( src.format == dst.format && src.width == dst.width && src.height == dst.height );
+
+	// Cube faces and array layers are both addressed by the z offset
+	int width = std::max( src.width >> mipLevel, 1 ), height = std::max( src.height >> mipLevel, 1 );
+	glCopyImageSubData( src.glObj, src.type, mipLevel, 0, 0, src.type == GL_TEXTURE_2D ? 0 : srcSlice,
+	                    dst.glObj, dst.type, mipLevel, 0, 0, dst.type == GL_TEXTURE_2D ? 0 : dstSlice,
+	                    width, height, 1 );
+}
+
+
+uint64 RenderDeviceGL4::getTextureHandle( uint32 texObj, uint16 samplerState )
+{
+	RDITextureGL4 &tex = _textures.getRef( texObj );
+
+	for( size_t i = 0; i < tex.handles.size(); ++i )
+	{
+		if( tex.handles[ i ].samplerState == samplerState ) return tex.handles[ i ].handle;
+	}
+
+	RDITextureHandleGL4 texHandle;
+	texHandle.handle = glGetTextureSamplerHandleARB( tex.glObj, getSamplerObject( samplerState, tex.hasMips ) );
+	texHandle.samplerState = samplerState;
+	if( texHandle.handle == 0 ) return 0;
+
+	glMakeTextureHandleResidentARB( texHandle.handle );
+	tex.handles.push_back( texHandle );
+
+	return texHandle.handle;
+}
+
 // =================================================================================================
 // Shaders
 // =================================================================================================
@@ -1343,6 +1513,123 @@ uint32 RenderDeviceGL4::createShader( const char *vertexShaderSrc, const char *f
 	RDIShaderGL4 &shader = _shaders.getRef( shaderId );
 	shader.oglProgramObj = programObj;
 	
+	initShaderInputLayouts( shader );
+	initShaderLocations( shader );
+
+	return shaderId;
+}
+
+
+uint32 RenderDeviceGL4::beginCreatingShader( const char *vertexShaderSrc, const char *fragmentShaderSrc, const char *geometryShaderSrc,
+                                            const char *tessControlShaderSrc, const char *tessEvaluationShaderSrc, const char *computeShaderSrc )
+{
+	const char *sources[6] = { vertexShaderSrc, fragmentShaderSrc, geometryShaderSrc,
+	                           tessControlShaderSrc, tessEvaluationShaderSrc, computeShaderSrc };
+	const uint32 stages[6] = { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER, GL_GEOMETRY_SHADER,
+	                           GL_TESS_CONTROL_SHADER, GL_TESS_EVALUATION_SHADER, GL_COMPUTE_SHADER };
+
+	_shaderLog = "";
+
+	// No status is queried here so that the driver can compile and link in the background
+	uint32 programObj = glCreateProgram();
+	for( uint32 i = 0; i < 6; ++i )
+	{
+		if( sources[i] == 0x0 ) continue;
+
+		uint32 shaderObj = glCreateShader( stages[i] );
+		glShaderSource( shaderObj, 1, &sources[i], 0x0 );
+		glCompileShader( shaderObj );
+		glAttachShader( programObj, shaderObj );
+		glDeleteShader( shaderObj );
+	}
+	glLinkProgram( programObj );
+
+	uint32 shaderId = _shaders.add( RDIShaderGL4() );
+	RDIShaderGL4 &shader = _shaders.getRef( shaderId );
+	shader.oglProgramObj = programObj;
+	shader.pending = true;
+
+	return shaderId;
+}
+
+
+bool RenderDeviceGL4::isShaderPending( uint32 shaderId )
+{
+	RDIShaderGL4 &shader = _shaders.getRef( shaderId );
+	if( !shader.pending ) return false;
+
+	// Without parallel compilation the status cannot be queried without blocking
+	if( !_caps.parallelShaderCompile ) return false;
+
+	int completed = 0;
+	glGetProgramiv( shader.oglProgramObj, GL_COMPLETION_STATUS_KHR, &completed );
+	return completed == 0;
+}
+
+
+bool RenderDeviceGL4::finishCreatingShader( uint32 &shaderId )
+{
+	RDIShaderGL4 &shader = _shaders.getRef( shaderId );
+	if( !shader.pending ) return true;
+	shader.pending = false;
+
+	int infologLength = 0;
+	int charsWritten = 0;
+	char *infoLog = 0x0;
+	int status;
+
+	_shaderLog = "";
+
+	// Gather compiler output of failed stages, the shader objects live as long as they are attached
+	glGetProgramiv( shader.oglProgramObj, GL_LINK_STATUS, &status );
+	if( !status )
+	{
+		uint32 shaderObjs[6];
+		int numShaderObjs = 0;
+		glGetAttachedShaders( shader.oglProgramObj, 6, &numShaderObjs, shaderObjs );
+		for( int i = 0; i < numShaderObjs; ++i )
+		{
+			glGetShaderiv( shaderObjs[i], GL_COMPILE_STATUS, &status );
+			glGetShaderiv( shaderObjs[i], GL_INFO_LOG_LENGTH, &infologLength );
+			if( status || infologLength <= 1 ) continue;
+
+			int stage;
+			glGetShaderiv( shaderObjs[i], GL_SHADER_TYPE, &stage );
+			infoLog = new char[infologLength];
+			glGetShaderInfoLog( shaderObjs[i], infologLength, &charsWritten, infoLog );
+			_shaderLog = _shaderLog + (stage == GL_VERTEX_SHADER ? "[Vertex Shader]\n" :
+			                           stage == GL_FRAGMENT_SHADER ? "[Fragment Shader]\n" : "[Shader]\n") + infoLog;
+			delete[] infoLog; infoLog = 0x0;
+		}
+	}
+
+	glGetProgramiv( shader.oglProgramObj, GL_INFO_LOG_LENGTH, &infologLength );
+	if( infologLength > 1 )
+	{
+		infoLog = new char[infologLength];
+		glGetProgramInfoLog( shader.oglProgramObj, infologLength, &charsWritten, infoLog );
+		_shaderLog = _shaderLog + "[Linking]\n" + infoLog;
+		delete[] infoLog; infoLog = 0x0;
+	}
+
+	glGetProgramiv( shader.oglProgramObj, GL_LINK_STATUS, &status );
+	if( !status )
+	{
+		destroyShader( shaderId );
+		return false;
+	}
+
+	initShaderInputLayouts( shader );
+	initShaderLocations( shader );
+
+	return true;
+}
+
+
+void RenderDeviceGL4::initShaderInputLayouts( RDIShaderGL4 &shader )
+{
+	uint32 programObj = shader.oglProgramObj;
+
 	int attribCount;
 	glGetProgramiv( programObj, GL_ACTIVE_ATTRIBUTES, &attribCount );
 	
@@ -1379,8 +1666,64 @@ uint32 RenderDeviceGL4::createShader( const char *vertexShaderSrc, const char *f
 
 		shader.inputLayouts[i].valid = allAttribsFound;
 	}
+}
 
-	return shaderId;
+
+void RenderDeviceGL4::initShaderLocations( RDIShaderGL4 &shader )
+{
+	// All locations are gathered in one pass so that resolving the engine and material uniforms of a
+	// combination does not require a driver query per name
+	uint32 programObj = shader.oglProgramObj;
+	shader.uniformLocs.clear();
+	shader.bufferLocs.clear();
+
+	int uniformCount = 0, maxNameLength = 0;
+	glGetProgramiv( programObj, GL_ACTIVE_UNIFORMS, &uniformCount );
+	glGetProgramiv( programObj, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength );
+	std::vector< char > name( maxNameLength + 1, 0 );
+
+	for( int i = 0; i < uniformCount; ++i )
+	{
+		int nameLength = 0, size;
+		uint32 type;
+		glGetActiveUniform( programObj, i, (int)name.size(), &nameLength, &size, &type, &name[0] );
+		
+		int loc = -1;
+		if( _caps.computeShaders )
+		{
+			// Program interface queries return the location by index instead of by name
+			const GLenum locationProp[ 1 ] = { GL_LOCATION };
+			glGetProgramResourceiv( programObj, GL_UNIFORM, i, 1, locationProp, 1, 0x0, &loc );
+		}
+		else
+		{
+			loc = glGetUniformLocation( programObj, &name[0] );
+		}
+		if( loc < 0 ) continue;  // Members of uniform blocks
+
+		shader.uniformLocs[&name[0]] = loc;
+
+		// Arrays are listed with the subscript of the first element but can also be referenced without it
+		if( nameLength > 3 && strcmp( &name[nameLength - 3], "[0]" ) == 0 )
+			shader.uniformLocs[std::string( &name[0], nameLength - 3 )] = loc;
+	}
+
+	if( _caps.computeShaders )
+	{
+		int blockCount = 0;
+		glGetProgramInterfaceiv( programObj, GL_SHADER_STORAGE_BLOCK, GL_ACTIVE_RESOURCES, &blockCount );
+		glGetProgramInterfaceiv( programObj, GL_SHADER_STORAGE_BLOCK, GL_MAX_NAME_LENGTH, &maxNameLength );
+		name.assign( maxNameLength + 1, 0 );
+
+		for( int i = 0; i < blockCount; ++i )
+		{
+			const GLenum bufBindingPoint[ 1 ] = { GL_BUFFER_BINDING };
+			int binding = -1;
+			glGetProgramResourceName( programObj, GL_SHADER_STORAGE_BLOCK, i, (int)name.size(), 0x0, &name[0] );
+			glGetProgramResourceiv( programObj, GL_SHADER_STORAGE_BLOCK, i, 1, bufBindingPoint, 1, 0x0, &binding );
+			shader.bufferLocs[&name[0]] = binding;
+		}
+	}
 }
 
 
@@ -1416,14 +1759,19 @@ void RenderDeviceGL4::bindShader( uint32 shaderId )
 int RenderDeviceGL4::getShaderConstLoc( uint32 shaderId, const char *name )
 {
 	RDIShaderGL4 &shader = _shaders.getRef( shaderId );
-	return glGetUniformLocation( shader.oglProgramObj, name );
+	std::map< std::string, int >::const_iterator itr = shader.uniformLocs.find( name );
+	if( itr != shader.uniformLocs.end() ) return itr->second;
+
+	// Single elements of arrays are not listed as active uniforms
+	if( strchr( name, '[' ) != 0x0 ) return glGetUniformLocation( shader.oglProgramObj, name );
+
+	return -1;
 }
 
 
 int RenderDeviceGL4::getShaderSamplerLoc( uint32 shaderId, const char *name )
 {
-	RDIShaderGL4 &shader = _shaders.getRef( shaderId );
-	return glGetUniformLocation( shader.oglProgramObj, name );
+	return getShaderConstLoc( shaderId, name );
 }
 
 
@@ -1432,13 +1780,8 @@ int RenderDeviceGL4::getShaderBufferLoc( uint32 shaderId, const char *name )
 	if ( _caps.computeShaders )
 	{
 		RDIShaderGL4 &shader = _shaders.getRef( shaderId );
-		int idx = glGetProgramResourceIndex( shader.oglProgramObj, GL_SHADER_STORAGE_BLOCK, name );
-		if( idx != -1 )
-		{
-			const GLenum bufBindingPoint[ 1 ] = { GL_BUFFER_BINDING };
-			glGetProgramResourceiv( shader.oglProgramObj, GL_SHADER_STORAGE_BLOCK, idx, 1, bufBindingPoint, 1, 0, &idx );
-		}
-		return idx;
+		std::map< std::string, int >::const_iterator itr = shader.bufferLocs.find( name );
+		return itr != shader.bufferLocs.end() ? itr->second : -1;
 	}
 	else
 	{
@@ -1513,6 +1856,19 @@ void RenderDeviceGL4::runComputeShader( uint32 shaderId, uint32 xDim, uint32 yDi
 		glDispatchCompute( xDim, yDim, zDim );
 }
 
+
+void RenderDeviceGL4::runComputeShaderIndirect( uint32 shaderId, uint32 bufObj, uint32 offset )
+{
+	bindShader( shaderId );
+
+	if ( commitStates( ~PM_GEOMETRY ) )
+	{
+		glBindBuffer( GL_DISPATCH_INDIRECT_BUFFER, _buffers.getRef( bufObj ).glObj );
+		glDispatchComputeIndirect( offset );
+		glBindBuffer( GL_DISPATCH_INDIRECT_BUFFER, 0 );
+	}
+}
+
 // =================================================================================================
 // Renderbuffers
 // =================================================================================================
@@ -1892,6 +2248,62 @@ uint32 RenderDeviceGL4::getQueryResult( uint32 queryObj )
 }
 
 
+// =================================================================================================
+// Fences
+// =================================================================================================
+
+uint32 RenderDeviceGL4::createFence()
+{
+	RDIFenceGL4 fence;
+	fence.sync = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+
+	return _fences.add( fence );
+}
+
+
+bool RenderDeviceGL4::isFenceSignaled( uint32 fenceObj )
+{
+	if( fenceObj == 0 ) return true;
+
+	const RDIFenceGL4 &fence = _fences.getRef( fenceObj );
+
+	// Zero timeout so that the caller never stalls, flushing makes sure the fence is submitted
+	GLenum result = glClientWaitSync( ( GLsync ) fence.sync, GL_SYNC_FLUSH_COMMANDS_BIT, 0 );
+
+	return result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED;
+}
+
+
+bool RenderDeviceGL4::waitForFence( uint32 fenceObj )
+{
+	if( fenceObj == 0 ) return true;
+
+	const RDIFenceGL4 &fence = _fences.getRef( fenceObj );
+
+	// Wait in slices of 100 ms, only the first wait needs to flush the commands
+	GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+	for( int i = 0; i < 10; ++i )
+	{
+		GLenum result = glClientWaitSync( ( GLsync ) fence.sync, flags, 100000000 );
+		if( result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED ) return true;
+		if( result == GL_WAIT_FAILED ) return false;
+		flags = 0;
+	}
+
+	return false;
+}
+
+
+void RenderDeviceGL4::destroyFence( uint32 &fenceObj )
+{
+	if( fenceObj == 0 ) return;
+
+	glDeleteSync( ( GLsync ) _fences.getRef( fenceObj ).sync );
+	_fences.remove( fenceObj );
+	fenceObj = 0;
+}
+
+
 // =================================================================================================
 // Internal state management
 // =================================================================================================
@@ -1937,6 +2349,7 @@ bool RenderDeviceGL4::applyVertexLayout( RDIGeometryInfoGL4 &geo )
 			glBindBuffer( GL_ARRAY_BUFFER, _buffers.getRef( geo.vertexBufInfo[ attrib.vbSlot ].vbObj ).glObj );
 			glVertexAttribPointer( attribIndex, attrib.size, GL_FLOAT, GL_FALSE,
 									vbSlot.stride, (char *)0 + vbSlot.offset + attrib.offset );
+			glVertexAttribDivisor( attribIndex, attrib.divisor );
 
 			newVertexAttribMask |= 1 << attribIndex;
 		}
@@ -1993,6 +2406,43 @@ void RenderDeviceGL4::applySamplerState( RDITextureGL4 &tex )
 }
 
 
+uint32 RenderDeviceGL4::getSamplerObject( uint32 samplerState, bool hasMips )
+{
+	// Same mapping as applySamplerState, used for textures whose own state became immutable
+	uint32 key = samplerState | (hasMips ? 0x80000000 : 0);
+	for( size_t i = 0; i < _samplerObjs.size(); ++i )
+	{
+		if( _samplerObjs[ i ].first == key ) return _samplerObjs[ i ].second;
+	}
+
+	const uint32 magFilters[] = { GL_LINEAR, GL_LINEAR, GL_NEAREST };
+	const uint32 minFiltersMips[] = { GL_LINEAR_MIPMAP_NEAREST, GL_LINEAR_MIPMAP_LINEAR, GL_NEAREST_MIPMAP_NEAREST };
+	const uint32 maxAniso[] = { 1, 2, 4, 0, 8, 0, 0, 0, 16 };
+	const uint32 wrapModes[] = { GL_CLAMP_TO_EDGE, GL_REPEAT, GL_CLAMP_TO_BORDER };
+	float borderColor[] = { 1.0f, 1.0f, 1.0f, 1.0f };
+
+	uint32 sampler = 0;
+	glGenSamplers( 1, &sampler );
+	glSamplerParameteri( sampler, GL_TEXTURE_MIN_FILTER, hasMips ?
+		minFiltersMips[(samplerState & SS_FILTER_MASK) >> SS_FILTER_START] : magFilters[(samplerState & SS_FILTER_MASK) >> SS_FILTER_START] );
+	glSamplerParameteri( sampler, GL_TEXTURE_MAG_FILTER, magFilters[(samplerState & SS_FILTER_MASK) >> SS_FILTER_START] );
+	glSamplerParameteri( sampler, GL_TEXTURE_MAX_ANISOTROPY_EXT, maxAniso[(samplerState & SS_ANISO_MASK) >> SS_ANISO_START] );
+	glSamplerParameteri( sampler, GL_TEXTURE_WRAP_S, wrapModes[(samplerState & SS_ADDRU_MASK) >> SS_ADDRU_START] );
+	glSamplerParameteri( sampler, GL_TEXTURE_WRAP_T, wrapModes[(samplerState & SS_ADDRV_MASK) >> SS_ADDRV_START] );
+	glSamplerParameteri( sampler, GL_TEXTURE_WRAP_R, wrapModes[(samplerState & SS_ADDRW_MASK) >> SS_ADDRW_START] );
+	glSamplerParameterfv( sampler, GL_TEXTURE_BORDER_COLOR, borderColor );
+	if( samplerState & SS_COMP_LEQUAL )
+	{
+		glSamplerParameteri( sampler, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_R_TO_TEXTURE );
+		glSamplerParameteri( sampler, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL );
+	}
+
+	_samplerObjs.push_back( std::pair< uint32, uint32 >( key, sampler ) );
+
+	return sampler;
+}
+
+
 void RenderDeviceGL4::applyRenderStates()
 {
 	// Rasterizer state
@@ -2021,6 +2471,12 @@ void RenderDeviceGL4::applyRenderStates()
 
 		if( _newRasterState.renderTargetWriteMask ) glColorMask( GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE );
 		else glColorMask( GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE );
+
+		for( uint32 i = 0; i < 4; ++i )
+		{
+			if( !_newRasterState.clipDistances ) glDisable( GL_CLIP_DISTANCE0 + i );
+			else glEnable( GL_CLIP_DISTANCE0 + i );
+		}
 		
 		_curRasterState.hash = _newRasterState.hash;
 	}
@@ -2041,7 +2497,11 @@ void RenderDeviceGL4::applyRenderStates()
 										   GL_ONE_MINUS_DST_COLOR, GL_ONE_MINUS_SRC_COLOR, GL_ZERO, GL_ZERO, GL_ZERO, GL_ZERO, GL_ZERO, GL_ZERO };
 			
 			glEnable( GL_BLEND );
-			glBlendFunc( oglBlendFuncs[_newBlendState.srcBlendFunc], oglBlendFuncs[_newBlendState.destBlendFunc] );
+			if( _newBlendState.separateAlphaBlend )
+				glBlendFuncSeparate( oglBlendFuncs[_newBlendState.srcBlendFunc], oglBlendFuncs[_newBlendState.destBlendFunc],
+				                     oglBlendFuncs[_newBlendState.srcAlphaBlendFunc], oglBlendFuncs[_newBlendState.destAlphaBlendFunc] );
+			else
+				glBlendFunc( oglBlendFuncs[_newBlendState.srcBlendFunc], oglBlendFuncs[_newBlendState.destBlendFunc] );
 		}
 		
 		_curBlendState.hash = _newBlendState.hash;
@@ -2080,9 +2540,22 @@ void RenderDeviceGL4::applyRenderStates()
 
 void RenderDeviceGL4::setStorageBuffer( uint8 slot, uint32 bufObj )
 {
-	ASSERT( slot < _maxComputeBufferAttachments && _storageBufs.size() < _maxComputeBufferAttachments );
+	ASSERT( slot < _maxComputeBufferAttachments );
 
 	RDIBufferGL4 &buf = _buffers.getRef( bufObj );
+
+	// Rebinding a slot replaces the previous buffer instead of accumulating attachments
+	for( size_t i = 0; i < _storageBufs.size(); ++i )
+	{
+		if( _storageBufs[ i ].slot == slot )
+		{
+			_storageBufs[ i ].oglObject = buf.glObj;
+			_pendingMask |= PM_COMPUTE;
+			return;
+		}
+	}
+
+	ASSERT( _storageBufs.size() < _maxComputeBufferAttachments );
 	_storageBufs.push_back( RDIShaderStorageGL4( slot, buf.glObj ) );
 
 	_pendingMask |= PM_COMPUTE;
@@ -2147,6 +2620,7 @@ bool RenderDeviceGL4::commitStates( uint32 filter )
 					glBindImageTexture( i, tex.glObj, 0, false, 0, access[ _texSlots[ i ].usage - 1 ], tex.glFmt );
 					glBindTexture( GL_TEXTURE_CUBE_MAP, 0 ); // as image units are different from texture units - clear binded texture units
 					glBindTexture( GL_TEXTURE_3D, 0 );
+					glBindTexture( GL_TEXTURE_2D_ARRAY, 0 );
 					glBindTexture( GL_TEXTURE_2D, 0 );
 				}
 				else if( _texSlots[i].texObj != 0 )
@@ -2155,16 +2629,28 @@ bool RenderDeviceGL4::commitStates( uint32 filter )
 					glBindTexture( tex.type, tex.glObj );
 
 					// Apply sampler state
-					if( tex.samplerState != _texSlots[i].samplerState )
+					uint32 sampler = 0;
+					if( !tex.handles.empty() )
+					{
+						// Texture parameters are immutable once a bindless handle exists
+						sampler = getSamplerObject( _texSlots[i].samplerState, tex.hasMips );
+					}
+					else if( tex.samplerState != _texSlots[i].samplerState )
 					{
 						tex.samplerState = _texSlots[i].samplerState;
 						applySamplerState( tex );
 					}
+					if( _boundSamplers[i] != sampler )
+					{
+						glBindSampler( i, sampler );
+						_boundSamplers[i] = sampler;
+					}
 				}
 				else
 				{
 					glBindTexture( GL_TEXTURE_CUBE_MAP, 0 );
 					glBindTexture( GL_TEXTURE_3D, 0 );
+					glBindTexture( GL_TEXTURE_2D_ARRAY, 0 );
 					glBindTexture( GL_TEXTURE_2D, 0 );
 				}
 			}
@@ -2191,7 +2677,16 @@ bool RenderDeviceGL4::commitStates( uint32 filter )
 		// Place memory barriers
 		if ( mask & PM_BARRIER )
 		{
-			if ( _memBarriers != NotSet ) glMemoryBarrier( memoryBarrierType[ ( uint32 ) _memBarriers - 1 ] );
+			if ( _memBarriers != NotSet )
+			{
+				GLbitfield barrierBits = 0;
+				for ( uint32 i = 0; i < 6; ++i )
+				{
+					if ( _memBarriers & ( 1 << i ) ) barrierBits |= memoryBarrierType[ i ];
+				}
+				glMemoryBarrier( barrierBits );
+				_memBarriers = NotSet;
+			}
 			_pendingMask &= ~PM_BARRIER;
 		}
 
@@ -2327,5 +2822,72 @@ void RenderDeviceGL4::drawIndexed( RDIPrimType primType, uint32 firstIndex, uint
 	CHECK_GL_ERROR
 }
 
+
+void RenderDeviceGL4::drawIndexedBaseVertex( RDIPrimType primType, uint32 firstIndex, uint32 numIndices,
+											 uint32 firstVert, uint32 numVerts, uint32 baseVertex )
+{
+	if( commitStates() )
+	{
+		firstIndex *= (_indexFormat == IDXFMT_16) ? sizeof( short ) : sizeof( int );
+
+		glDrawRangeElementsBaseVertex( RDI_GL4::primitiveTypes[ ( uint32 ) primType ], firstVert, firstVert + numVerts,
+									   numIndices, RDI_GL4::indexFormats[ _indexFormat ], ( char * ) 0 + firstIndex,
+									   ( GLint ) baseVertex );
+	}
+
+	CHECK_GL_ERROR
+}
+
+
+void RenderDeviceGL4::drawIndexedInstanced( RDIPrimType primType, uint32 firstIndex, uint32 numIndices,
+											uint32 firstVert, uint32 numVerts, uint32 numInstances )
+{
+	H3D_UNUSED_VAR( firstVert );
+	H3D_UNUSED_VAR( numVerts );
+
+	if( commitStates() )
+	{
+		firstIndex *= (_indexFormat == IDXFMT_16) ? sizeof( short ) : sizeof( int );
+
+		glDrawElementsInstanced( RDI_GL4::primitiveTypes[ ( uint32 ) primType ], numIndices,
+								 RDI_GL4::indexFormats[ _indexFormat ], ( char * ) 0 + firstIndex, numInstances );
+	}
+
+	CHECK_GL_ERROR
+}
+
+
+void RenderDeviceGL4::drawIndexedInstancedBaseVertex( RDIPrimType primType, uint32 firstIndex, uint32 numIndices,
+                                                      uint32 firstVert, uint32 numVerts, uint32 numInstances,
+                                                      uint32 baseVertex )
+{
+	H3D_UNUSED_VAR( firstVert );
+	H3D_UNUSED_VAR( numVerts );
+
+	if( commitStates() )
+	{
+		firstIndex *= (_indexFormat == IDXFMT_16) ? sizeof( short ) : sizeof( int );
+
+		glDrawElementsInstancedBaseVertex( RDI_GL4::primitiveTypes[ ( uint32 ) primType ], numIndices,
+										   RDI_GL4::indexFormats[ _indexFormat ], ( char * ) 0 + firstIndex,
+										   numInstances, ( GLint ) baseVertex );
+	}
+
+	CHECK_GL_ERROR
+}
+
+
+void RenderDeviceGL4::drawIndirect( RDIPrimType primType, uint32 bufObj, uint32 offset )
+{
+	if( commitStates() )
+	{
+		glBindBuffer( GL_DRAW_INDIRECT_BUFFER, _buffers.getRef( bufObj ).glObj );
+		glDrawArraysIndirect( RDI_GL4::primitiveTypes[ ( uint32 ) primType ], ( char * ) 0 + offset );
+		glBindBuffer( GL_DRAW_INDIRECT_BUFFER, 0 );
+	}
+
+	CHECK_GL_ERROR
+}
+
 } // namespace RDI_GL4
 }  // namespace
@@ -15,6 +15,7 @@
 
 #include "egRendererBase.h"
 #include <string.h>
+#include <map>
 
 
 namespace Horde3D {
@@ -63,8 +64,16 @@ struct RDIBufferGL4
 	uint32  glObj;
 	uint32  size;
 	int		geometryRefCount;
+	void    *persistentPtr;  // Persistently mapped pixel buffers
 
-	RDIBufferGL4() : type( 0 ), glObj( 0 ), size( 0 ), geometryRefCount( 0 ) {}
+	RDIBufferGL4() : type( 0 ), glObj( 0 ), size( 0 ), geometryRefCount( 0 ), persistentPtr( 0x0 ) {}
+};
+
+struct RDIFenceGL4
+{
+	void  *sync;  // GLsync
+
+	RDIFenceGL4() : sync( 0x0 ) {}
 };
 
 struct RDIVertBufSlotGL4
@@ -105,6 +114,12 @@ struct RDIShaderStorageGL4
 // Textures
 // ---------------------------------------------------------
 
+struct RDITextureHandleGL4
+{
+	uint64  handle;
+	uint32  samplerState;
+};
+
 struct RDITextureGL4
 {
 	uint32                glObj;
@@ -116,6 +131,7 @@ struct RDITextureGL4
 	uint32                samplerState;
 	bool                  sRGB;
 	bool                  hasMips, genMips;
+	std::vector< RDITextureHandleGL4 >  handles;  // Bindless handles; texture state is immutable once one exists
 
 	RDITextureGL4() : glObj( 0 ), glFmt( 0 ), type( 0 ), format( TextureFormats::Unknown ), width( 0 ), height( 0 ),
 					  depth( 0 ), memSize( 0 ), samplerState( 0 ), sRGB( false ), hasMips( false ), genMips( false )
@@ -162,8 +178,11 @@ struct RDIShaderGL4
 {
 	uint32				oglProgramObj;
 	RDIInputLayoutGL4	inputLayouts[MaxNumVertexLayouts];
+	std::map< std::string, int >  uniformLocs;  // Locations of all active uniforms, gathered once after linking
+	std::map< std::string, int >  bufferLocs;  // Binding points of all active storage blocks
+	bool				pending;  // Compilation and linking started but results not queried yet
 
-	RDIShaderGL4() : oglProgramObj( 0 )
+	RDIShaderGL4() : oglProgramObj( 0 ), pending( false )
 	{
 		
 	}
@@ -231,6 +250,9 @@ public:
 	void updateBufferData( uint32 geoObj, uint32 bufObj, uint32 offset, uint32 size, void *data );
 	void *mapBuffer( uint32 geoObj, uint32 bufObj, uint32 offset, uint32 size, RDIBufferMappingTypes mapType );
 	void unmapBuffer( uint32 geoObj, uint32 bufObj );
+	uint32 createPixelBuffer( uint32 size );
+	void *mapPixelBuffer( uint32 bufObj );
+	void unmapPixelBuffer( uint32 bufObj );
 
 	// Textures
 // 	uint32 calcTextureSize( TextureFormats::List format, int width, int height, int depth );
@@ -243,10 +265,17 @@ public:
 	bool getTextureData( uint32 texObj, int slice, int mipLevel, void *buffer );
 	uint32 getTextureMem() const { return _textureMem; }
 	void bindImageToTexture( uint32 texObj, void* eglImage );
+	void updateTextureFromBuffer( uint32 texObj, uint32 bufObj, uint32 offset );
+	void copyTextureSlice( uint32 srcTexObj, int srcSlice, uint32 dstTexObj, int dstSlice, int mipLevel );
+	uint64 getTextureHandle( uint32 texObj, uint16 samplerState );
 
 	// Shaders
 	uint32 createShader( const char *vertexShaderSrc, const char *fragmentShaderSrc, const char *geometryShaderSrc,
 						 const char *tessControlShaderSrc, const char *tessEvaluationShaderSrc, const char *computeShaderSrc );
+	uint32 beginCreatingShader( const char *vertexShaderSrc, const char *fragmentShaderSrc, const char *geometryShaderSrc,
+								 const char *tessControlShaderSrc, const char *tessEvaluationShaderSrc, const char *computeShaderSrc );
+	bool isShaderPending( uint32 shaderId );
+	bool finishCreatingShader( uint32 &shaderId );
 	void destroyShader(uint32 &shaderId );
 	void bindShader( uint32 shaderId );
 	std::string getShaderLog() const { return _shaderLog; }
@@ -258,6 +287,7 @@ public:
 	const char *getDefaultVSCode();
 	const char *getDefaultFSCode();
 	void runComputeShader( uint32 shaderId, uint32 xDim, uint32 yDim, uint32 zDim );
+	void runComputeShaderIndirect( uint32 shaderId, uint32 bufObj, uint32 offset );
 
 	// Renderbuffers
 	uint32 createRenderBuffer( uint32 width, uint32 height, TextureFormats::List format,
@@ -276,6 +306,12 @@ public:
 	void endQuery( uint32 queryObj );
 	uint32 getQueryResult( uint32 queryObj );
 
+	// Fences
+	uint32 createFence();
+	bool isFenceSignaled( uint32 fenceObj );
+	bool waitForFence( uint32 fenceObj );
+	void destroyFence( uint32 &fenceObj );
+
 	// Render Device dependent GPU Timer
 	GPUTimer *createGPUTimer()
 	{
@@ -295,6 +331,13 @@ public:
 	void draw( RDIPrimType primType, uint32 firstVert, uint32 numVerts );
 	void drawIndexed( RDIPrimType primType, uint32 firstIndex, uint32 numIndices,
 	                  uint32 firstVert, uint32 numVerts );
+	void drawIndexedBaseVertex( RDIPrimType primType, uint32 firstIndex, uint32 numIndices,
+	                            uint32 firstVert, uint32 numVerts, uint32 baseVertex );
+	void drawIndexedInstanced( RDIPrimType primType, uint32 firstIndex, uint32 numIndices,
+	                           uint32 firstVert, uint32 numVerts, uint32 numInstances );
+	void drawIndexedInstancedBaseVertex( RDIPrimType primType, uint32 firstIndex, uint32 numIndices,
+	                                     uint32 firstVert, uint32 numVerts, uint32 numInstances, uint32 baseVertex );
+	void drawIndirect( RDIPrimType primType, uint32 bufObj, uint32 offset );
 
 // -----------------------------------------------------------------------------
 // Getters
@@ -324,11 +367,14 @@ protected:
 	uint32 createShaderProgram( const char *vertexShaderSrc, const char *fragmentShaderSrc, const char *geometryShaderSrc, 
 								const char *tessControlShaderSrc, const char *tessEvalShaderSrc, const char *computeShaderSrc );
 	bool linkShaderProgram( uint32 programObj );
+	void initShaderInputLayouts( RDIShaderGL4 &shader );
+	void initShaderLocations( RDIShaderGL4 &shader );
 	void resolveRenderBuffer( uint32 rbObj );
 
 	void checkError();
 	bool applyVertexLayout( RDIGeometryInfoGL4 &geo );
 	void applySamplerState( RDITextureGL4 &tex );
+	uint32 getSamplerObject( uint32 samplerState, bool hasMips );
 	void applyRenderStates();
 
 	inline uint32 createBuffer( uint32 type, uint32 size, const void *data );
@@ -347,7 +393,10 @@ protected:
 	RDIObjects< RDIShaderGL4 >         _shaders;
 	RDIObjects< RDIRenderBufferGL4 >   _rendBufs;
 	RDIObjects< RDIGeometryInfoGL4 >   _vaos;
+	RDIObjects< RDIFenceGL4 >          _fences;
 	std::vector< RDIShaderStorageGL4 > _storageBufs;
+	std::vector< std::pair< uint32, uint32 > >  _samplerObjs;  // Sampler state key and GL sampler object
+	uint32                             _boundSamplers[16];
 
  	uint32                             _indexFormat;
  	uint32                             _activeVertexAttribsMask;
@@ -18,6 +18,7 @@
 #include "utDebug.h"
 #include <array>
 #include <map>
+#include <string.h>
 
 
 namespace Horde3D {
@@ -53,9 +54,11 @@ static const uint32 indexFormats[ 2 ] = { GL_UNSIGNED_SHORT, GL_UNSIGNED_INT };
 
 static const uint32 primitiveTypes[ 5 ] = { GL_TRIANGLES, GL_TRIANGLE_STRIP, GL_LINES, GL_POINTS, GL_PATCHES };
 
-static const uint32 textureTypes[ 3 ] = { GL_TEXTURE_2D, GL_TEXTURE_3D, GL_TEXTURE_CUBE_MAP };
+static const uint32 textureTypes[ 4 ] = { GL_TEXTURE_2D, GL_TEXTURE_3D, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_2D_ARRAY };
 
-static const uint32 memoryBarrierType[ 3 ] = { GL_BUFFER_UPDATE_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT, GL_ELEMENT_ARRAY_BARRIER_BIT, GL_SHADER_IMAGE_ACCESS_BARRIER_BIT };
+// GL barrier bits for each flag of RDIDrawBarriers
+static const uint32 memoryBarrierType[ 6 ] = { GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT, GL_ELEMENT_ARRAY_BARRIER_BIT,
+	GL_SHADER_IMAGE_ACCESS_BARRIER_BIT, GL_SHADER_STORAGE_BARRIER_BIT, GL_COMMAND_BARRIER_BIT, GL_BUFFER_UPDATE_BARRIER_BIT };
 
 static const uint32 bufferMappingTypes[ 3 ] = { GL_MAP_READ_BIT, GL_MAP_WRITE_BIT, GL_MAP_READ_BIT | GL_MAP_WRITE_BIT };
 
@@ -301,6 +304,9 @@ void RenderDeviceGLES3::initRDIFuncs()
 	_delegate_updateBufferData.bind< RenderDeviceGLES3, &RenderDeviceGLES3::updateBufferData >( this );
 	_delegate_mapBuffer.bind< RenderDeviceGLES3, &RenderDeviceGLES3::mapBuffer >( this );
 	_delegate_unmapBuffer.bind< RenderDeviceGLES3, &RenderDeviceGLES3::unmapBuffer >( this );
+	_delegate_createPixelBuffer.bind< RenderDeviceGLES3, &RenderDeviceGLES3::createPixelBuffer >( this );
+	_delegate_mapPixelBuffer.bind< RenderDeviceGLES3, &RenderDeviceGLES3::mapPixelBuffer >( this );
+	_delegate_unmapPixelBuffer.bind< RenderDeviceGLES3, &RenderDeviceGLES3::unmapPixelBuffer >( this );
 
 	_delegate_createTexture.bind< RenderDeviceGLES3, &RenderDeviceGLES3::createTexture >( this );
 	_delegate_generateTextureMipmap.bind< RenderDeviceGLES3, &RenderDeviceGLES3::generateTextureMipmap >( this );
@@ -309,14 +315,21 @@ void RenderDeviceGLES3::initRDIFuncs()
 	_delegate_updateTextureData.bind< RenderDeviceGLES3, &RenderDeviceGLES3::updateTextureData >( this );
 	_delegate_getTextureData.bind< RenderDeviceGLES3, &RenderDeviceGLES3::getTextureData >( this );
 	_delegate_bindImageToTexture.bind< RenderDeviceGLES3, &RenderDeviceGLES3::bindImageToTexture >( this );
+	_delegate_updateTextureFromBuffer.bind< RenderDeviceGLES3, &RenderDeviceGLES3::updateTextureFromBuffer >( this );
+	_delegate_copyTextureSlice.bind< RenderDeviceGLES3, &RenderDeviceGLES3::copyTextureSlice >( this );
+	_delegate_getTextureHandle.bind< RenderDeviceGLES3, &RenderDeviceGLES3::getTextureHandle >( this );
 
 	_delegate_createShader.bind< RenderDeviceGLES3, &RenderDeviceGLES3::createShader >( this );
+	_delegate_beginCreatingShader.bind< RenderDeviceGLES3, &RenderDeviceGLES3::beginCreatingShader >( this );
+	_delegate_isShaderPending.bind< RenderDeviceGLES3, &RenderDeviceGLES3::isShaderPending >( this );
+	_delegate_finishCreatingShader.bind< RenderDeviceGLES3, &RenderDeviceGLES3::finishCreatingShader >( this );
 	_delegate_destroyShader.bind< RenderDeviceGLES3, &RenderDeviceGLES3::destroyShader >( this );
 	_delegate_bindShader.bind< RenderDeviceGLES3, &RenderDeviceGLES3::bindShader >( this );
 	_delegate_getShaderConstLoc.bind< RenderDeviceGLES3, &RenderDeviceGLES3::getShaderConstLoc >( this );
 	_delegate_getShaderSamplerLoc.bind< RenderDeviceGLES3, &RenderDeviceGLES3::getShaderSamplerLoc >( this );
 	_delegate_getShaderBufferLoc.bind< RenderDeviceGLES3, &RenderDeviceGLES3::getShaderBufferLoc >( this );
 	_delegate_runComputeShader.bind< RenderDeviceGLES3, &RenderDeviceGLES3::runComputeShader >( this );
+	_delegate_runComputeShaderIndirect.bind< RenderDeviceGLES3, &RenderDeviceGLES3::runComputeShaderIndirect >( this );
 	_delegate_setShaderConst.bind< RenderDeviceGLES3, &RenderDeviceGLES3::setShaderConst >( this );
 	_delegate_setShaderSampler.bind< RenderDeviceGLES3, &RenderDeviceGLES3::setShaderSampler >( this );
 	_delegate_getDefaultVSCode.bind< RenderDeviceGLES3, &RenderDeviceGLES3::getDefaultVSCode >( this );
@@ -336,12 +349,20 @@ void RenderDeviceGLES3::initRDIFuncs()
 	_delegate_getQueryResult.bind< RenderDeviceGLES3, &RenderDeviceGLES3::getQueryResult >( this );
 
 	_delegate_createGPUTimer.bind< RenderDeviceGLES3, &RenderDeviceGLES3::createGPUTimer >( this );
+	_delegate_createFence.bind< RenderDeviceGLES3, &RenderDeviceGLES3::createFence >( this );
+	_delegate_isFenceSignaled.bind< RenderDeviceGLES3, &RenderDeviceGLES3::isFenceSignaled >( this );
+	_delegate_waitForFence.bind< RenderDeviceGLES3, &RenderDeviceGLES3::waitForFence >( this );
+	_delegate_destroyFence.bind< RenderDeviceGLES3, &RenderDeviceGLES3::destroyFence >( this );
 	_delegate_commitStates.bind< RenderDeviceGLES3, &RenderDeviceGLES3::commitStates >( this );
 	_delegate_resetStates.bind< RenderDeviceGLES3, &RenderDeviceGLES3::resetStates >( this );
 	_delegate_clear.bind< RenderDeviceGLES3, &RenderDeviceGLES3::clear >( this );
 
 	_delegate_draw.bind< RenderDeviceGLES3, &RenderDeviceGLES3::draw >( this );
 	_delegate_drawIndexed.bind< RenderDeviceGLES3, &RenderDeviceGLES3::drawIndexed >( this );
+	_delegate_drawIndexedBaseVertex.bind< RenderDeviceGLES3, &RenderDeviceGLES3::drawIndexedBaseVertex >( this );
+	_delegate_drawIndexedInstanced.bind< RenderDeviceGLES3, &RenderDeviceGLES3::drawIndexedInstanced >( this );
+	_delegate_drawIndexedInstancedBaseVertex.bind< RenderDeviceGLES3, &RenderDeviceGLES3::drawIndexedInstancedBaseVertex >( this );
+	_delegate_drawIndirect.bind< RenderDeviceGLES3, &RenderDeviceGLES3::drawIndirect >( this );
 	_delegate_setStorageBuffer.bind< RenderDeviceGLES3, &RenderDeviceGLES3::setStorageBuffer >( this );
 }
 
@@ -437,6 +458,16 @@ bool RenderDeviceGLES3::init()
 	_caps.texETC2 = true;
 	_caps.texBPTC = glESExt::EXT_texture_compression_bptc;
 	_caps.texASTC = glESExt::KHR_texture_compression_astc;
+	_caps.parallelShaderCompile = glESExt::KHR_parallel_shader_compile;
+	_caps.drawBaseVertex = glESExt::EXT_draw_elements_base_vertex;
+	_caps.pixelBuffers = true;
+	_caps.indirectDraws = _caps.computeShaders;
+	_caps.clipDistances = false;
+	_caps.texArrays = glESExt::EXT_copy_image;
+	_caps.bindlessTextures = false;
+
+	// Let the driver choose the number of background compiler threads
+	if( _caps.parallelShaderCompile ) glMaxShaderCompilerThreadsKHR( 0xFFFFFFFF );
 
     // Get the currently bound frame buffer object.
     glGetIntegerv( GL_FRAMEBUFFER_BINDING, &_defaultFBO );
@@ -560,6 +591,7 @@ void RenderDeviceGLES3::finishCreatingGeometry( uint32 geoObj )
 			glBindBuffer( GL_ARRAY_BUFFER, buf.glObj );
 			glVertexAttribPointer( i, attrib.size, GL_FLOAT, GL_FALSE,
 								   vbSlot.stride, ( char * ) 0 + vbSlot.offset + attrib.offset );
+			glVertexAttribDivisor( i, attrib.divisor );
 
 			newVertexAttribMask |= 1 << i;
 		}
@@ -811,6 +843,35 @@ void RenderDeviceGLES3::unmapBuffer( uint32 geoObj, uint32 bufObj )
 }
 
 
+uint32 RenderDeviceGLES3::createPixelBuffer( uint32 size )
+{
+	return createBuffer( GL_PIXEL_UNPACK_BUFFER, size, 0x0 );
+}
+
+
+void *RenderDeviceGLES3::mapPixelBuffer( uint32 bufObj )
+{
+	const RDIBufferGLES3 &buf = _buffers.getRef( bufObj );
+
+	glBindBuffer( buf.type, buf.glObj );
+	void *ptr = glMapBufferRange( buf.type, 0, buf.size,
+	                              GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT );
+	glBindBuffer( buf.type, 0 );
+
+	return ptr;
+}
+
+
+void RenderDeviceGLES3::unmapPixelBuffer( uint32 bufObj )
+{
+	const RDIBufferGLES3 &buf = _buffers.getRef( bufObj );
+
+	glBindBuffer( buf.type, buf.glObj );
+	glUnmapBuffer( buf.type );
+	glBindBuffer( buf.type, 0 );
+}
+
+
 // =================================================================================================
 // Textures
 // =================================================================================================
@@ -868,7 +929,7 @@ uint32 RenderDeviceGLES3::createTexture( TextureTypes::List type, int width, int
 	glActiveTexture( GL_TEXTURE15 );
 	glBindTexture( tex.type, tex.glObj );
 
-	if ( tex.type != GL_TEXTURE_3D ) {
+	if ( tex.type != GL_TEXTURE_3D && tex.type != GL_TEXTURE_2D_ARRAY ) {
 		glTexStorage2D( tex.type, maxMipLevel+1, tex.glFmt, tex.width, tex.height );
 	} else {
 		glTexStorage3D( tex.type, maxMipLevel+1, tex.glFmt, tex.width, tex.height, tex.depth );
@@ -882,7 +943,10 @@ uint32 RenderDeviceGLES3::createTexture( TextureTypes::List type, int width, int
 		glBindTexture( _textures.getRef( _texSlots[15].texObj ).type, _textures.getRef( _texSlots[15].texObj ).glObj );
 
 	// Calculate memory requirements
-	tex.memSize = calcTextureSize( format, width, height, depth, maxMipLevel );
+	if( type == TextureTypes::Tex2DArray )
+		tex.memSize = calcTextureSize( format, width, height, 1, maxMipLevel ) * depth;
+	else
+		tex.memSize = calcTextureSize( format, width, height, depth, maxMipLevel );
 	if( type == TextureTypes::TexCube ) tex.memSize *= 6;
 	_textureMem += tex.memSize;
 	
@@ -942,10 +1006,21 @@ void RenderDeviceGLES3::uploadTextureData( uint32 texObj, int slice, int mipLeve
 			glTexSubImage3D( GL_TEXTURE_3D, mipLevel, 0, 0, 0, width, height, depth,
 			                 inputFormat, inputType, pixels );
 	}
+	else if ( tex.type == textureTypes[ TextureTypes::Tex2DArray ] )
+	{
+		// A slice is a single layer of the array
+		if( compressed )
+			glCompressedTexSubImage3D( GL_TEXTURE_2D_ARRAY, mipLevel, 0, 0, slice, width, height, 1,
+			                           tex.glFmt, calcTextureSize( format, width, height, 1 ), pixels );
+		else
+			glTexSubImage3D( GL_TEXTURE_2D_ARRAY, mipLevel, 0, 0, slice, width, height, 1,
+			                 inputFormat, inputType, pixels );
+	}
 
-	if( tex.genMips && (tex.type != GL_TEXTURE_CUBE_MAP || slice == 5) )
+	if( tex.genMips && (tex.type != GL_TEXTURE_CUBE_MAP || slice == 5) &&
+		(tex.type != GL_TEXTURE_2D_ARRAY || slice == tex.depth - 1) )
 	{
-		// Note: for cube maps mips are only generated when the side with the highest index is uploaded
+		// Note: for cube maps and arrays mips are only generated when the slice with the highest index is uploaded
 		glGenerateMipmap( tex.type );
 	}
 
@@ -977,6 +1052,9 @@ void RenderDeviceGLES3::updateTextureData( uint32 texObj, int slice, int mipLeve
 bool RenderDeviceGLES3::getTextureData( uint32 texObj, int slice, int mipLevel, void *buffer )
 {
  	const RDITextureGLES3 &tex = _textures.getRef( texObj );
+
+	// Array layers cannot be read back, arrays are only sources for sampling
+	if( tex.type == textureTypes[ TextureTypes::Tex2DArray ] ) return false;
  	
  	int target = tex.type == textureTypes[ TextureTypes::TexCube ] ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D;
  	if( target == GL_TEXTURE_CUBE_MAP ) target = GL_TEXTURE_CUBE_MAP_POSITIVE_X + slice;
@@ -1064,6 +1142,54 @@ void RenderDeviceGLES3::bindImageToTexture(uint32 texObj, void *eglImage)
 }
 
 
+void RenderDeviceGLES3::updateTextureFromBuffer( uint32 texObj, uint32 bufObj, uint32 offset )
+{
+	const RDITextureGLES3 &tex = _textures.getRef( texObj );
+	const RDIBufferGLES3 &buf = _buffers.getRef( bufObj );
+	ASSERT( tex.type == textureTypes[ TextureTypes::Tex2D ] && !isCompressedTextureFormat( tex.format ) );
+
+	glActiveTexture( GL_TEXTURE15 );
+	glBindTexture( tex.type, tex.glObj );
+
+	// The copy is executed asynchronously by the driver since the source is a buffer object
+	glBindBuffer( GL_PIXEL_UNPACK_BUFFER, buf.glObj );
+	glTexSubImage2D( GL_TEXTURE_2D, 0, 0, 0, tex.width, tex.height, textureGLFormats[ tex.format ].glInputFormat,
+	                 textureGLFormats[ tex.format ].glInputType, ( char * ) 0 + offset );
+	glBindBuffer( GL_PIXEL_UNPACK_BUFFER, 0 );
+
+	if( tex.genMips ) glGenerateMipmap( tex.type );
+
+	glBindTexture( tex.type, 0 );
+	if( _texSlots[15].texObj )
+		glBindTexture( _textures.getRef( _texSlots[15].texObj ).type, _textures.getRef( _texSlots[15].texObj ).glObj );
+}
+
+
+void RenderDeviceGLES3::copyTextureSlice( uint32 srcTexObj, int srcSlice, uint32 dstTexObj, int dstSlice, int mipLevel )
+{
+	const RDITextureGLES3 &src = _textures.getRef( srcTexObj );
+	const RDITextureGLES3 &dst = _textures.getRef( dstTexObj );
+	ASSERT( src.format == dst.format && src.width == dst.width && src.height == dst.height );
+
+	// Cube faces and array layers are both addressed by the z offset
+	int width = std::max( src.width >> mipLevel, 1 ), height = std::max( src.height >> mipLevel, 1 );
+	glCopyImageSubDataEXT( src.glObj, src.type, mipLevel, 0, 0, src.type == GL_TEXTURE_2D ? 0 : srcSlice,
+	                       dst.glObj, dst.type, mipLevel, 0, 0, dst.type == GL_TEXTURE_2D ? 0 : dstSlice,
+	                       width, height, 1 );
+}
+
+
+uint64 RenderDeviceGLES3::getTextureHandle( uint32 texObj, uint16 samplerState )
+{
+	H3D_UNUSED_VAR( texObj );
+	H3D_UNUSED_VAR( samplerState );
+
+	// There is no bindless texture extension for OpenGL ES
+	ASSERT( _caps.bindlessTextures );
+	return 0;
+}
+
+
 // =================================================================================================
 // Shaders
 // =================================================================================================
@@ -1312,6 +1438,123 @@ uint32 RenderDeviceGLES3::createShader( const char *vertexShaderSrc, const char
 	RDIShaderGLES3 &shader = _shaders.getRef( shaderId );
 	shader.oglProgramObj = programObj;
 	
+	initShaderInputLayouts( shader );
+	initShaderLocations( shader );
+
+	return shaderId;
+}
+
+
+uint32 RenderDeviceGLES3::beginCreatingShader( const char *vertexShaderSrc, const char *fragmentShaderSrc, const char *geometryShaderSrc,
+                                              const char *tessControlShaderSrc, const char *tessEvaluationShaderSrc, const char *computeShaderSrc )
+{
+	const char *sources[6] = { vertexShaderSrc, fragmentShaderSrc, geometryShaderSrc,
+	                           tessControlShaderSrc, tessEvaluationShaderSrc, computeShaderSrc };
+	const uint32 stages[6] = { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER, GL_GEOMETRY_SHADER_EXT,
+	                           GL_TESS_CONTROL_SHADER, GL_TESS_EVALUATION_SHADER, GL_COMPUTE_SHADER };
+
+	_shaderLog = "";
+
+	// No status is queried here so that the driver can compile and link in the background
+	uint32 programObj = glCreateProgram();
+	for( uint32 i = 0; i < 6; ++i )
+	{
+		if( sources[i] == 0x0 ) continue;
+
+		uint32 shaderObj = glCreateShader( stages[i] );
+		glShaderSource( shaderObj, 1, &sources[i], 0x0 );
+		glCompileShader( shaderObj );
+		glAttachShader( programObj, shaderObj );
+		glDeleteShader( shaderObj );
+	}
+	glLinkProgram( programObj );
+
+	uint32 shaderId = _shaders.add( RDIShaderGLES3() );
+	RDIShaderGLES3 &shader = _shaders.getRef( shaderId );
+	shader.oglProgramObj = programObj;
+	shader.pending = true;
+
+	return shaderId;
+}
+
+
+bool RenderDeviceGLES3::isShaderPending( uint32 shaderId )
+{
+	RDIShaderGLES3 &shader = _shaders.getRef( shaderId );
+	if( !shader.pending ) return false;
+
+	// Without parallel compilation the status cannot be queried without blocking
+	if( !_caps.parallelShaderCompile ) return false;
+
+	int completed = 0;
+	glGetProgramiv( shader.oglProgramObj, GL_COMPLETION_STATUS_KHR, &completed );
+	return completed == 0;
+}
+
+
+bool RenderDeviceGLES3::finishCreatingShader( uint32 &shaderId )
+{
+	RDIShaderGLES3 &shader = _shaders.getRef( shaderId );
+	if( !shader.pending ) return true;
+	shader.pending = false;
+
+	int infologLength = 0;
+	int charsWritten = 0;
+	char *infoLog = 0x0;
+	int status;
+
+	_shaderLog = "";
+
+	// Gather compiler output of failed stages, the shader objects live as long as they are attached
+	glGetProgramiv( shader.oglProgramObj, GL_LINK_STATUS, &status );
+	if( !status )
+	{
+		uint32 shaderObjs[6];
+		int numShaderObjs = 0;
+		glGetAttachedShaders( shader.oglProgramObj, 6, &numShaderObjs, shaderObjs );
+		for( int i = 0; i < numShaderObjs; ++i )
+		{
+			glGetShaderiv( shaderObjs[i], GL_COMPILE_STATUS, &status );
+			glGetShaderiv( shaderObjs[i], GL_INFO_LOG_LENGTH, &infologLength );
+			if( status || infologLength <= 1 ) continue;
+
+			int stage;
+			glGetShaderiv( shaderObjs[i], GL_SHADER_TYPE, &stage );
+			infoLog = new char[infologLength];
+			glGetShaderInfoLog( shaderObjs[i], infologLength, &charsWritten, infoLog );
+			_shaderLog = _shaderLog + (stage == GL_VERTEX_SHADER ? "[Vertex Shader]\n" :
+			                           stage == GL_FRAGMENT_SHADER ? "[Fragment Shader]\n" : "[Shader]\n") + infoLog;
+			delete[] infoLog; infoLog = 0x0;
+		}
+	}
+
+	glGetProgramiv( shader.oglProgramObj, GL_INFO_LOG_LENGTH, &infologLength );
+	if( infologLength > 1 )
+	{
+		infoLog = new char[infologLength];
+		glGetProgramInfoLog( shader.oglProgramObj, infologLength, &charsWritten, infoLog );
+		_shaderLog = _shaderLog + "[Linking]\n" + infoLog;
+		delete[] infoLog; infoLog = 0x0;
+	}
+
+	glGetProgramiv( shader.oglProgramObj, GL_LINK_STATUS, &status );
+	if( !status )
+	{
+		destroyShader( shaderId );
+		return false;
+	}
+
+	initShaderInputLayouts( shader );
+	initShaderLocations( shader );
+
+	return true;
+}
+
+
+void RenderDeviceGLES3::initShaderInputLayouts( RDIShaderGLES3 &shader )
+{
+	uint32 programObj = shader.oglProgramObj;
+
 	int attribCount;
 	glGetProgramiv( programObj, GL_ACTIVE_ATTRIBUTES, &attribCount );
 	
@@ -1348,8 +1591,64 @@ uint32 RenderDeviceGLES3::createShader( const char *vertexShaderSrc, const char
 
 		shader.inputLayouts[i].valid = allAttribsFound;
 	}
+}
 
-	return shaderId;
+
+void RenderDeviceGLES3::initShaderLocations( RDIShaderGLES3 &shader )
+{
+	// All locations are gathered in one pass so that resolving the engine and material uniforms of a
+	// combination does not require a driver query per name
+	uint32 programObj = shader.oglProgramObj;
+	shader.uniformLocs.clear();
+	shader.bufferLocs.clear();
+
+	int uniformCount = 0, maxNameLength = 0;
+	glGetProgramiv( programObj, GL_ACTIVE_UNIFORMS, &uniformCount );
+	glGetProgramiv( programObj, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength );
+	std::vector< char > name( maxNameLength + 1, 0 );
+
+	for( int i = 0; i < uniformCount; ++i )
+	{
+		int nameLength = 0, size;
+		uint32 type;
+		glGetActiveUniform( programObj, i, (int)name.size(), &nameLength, &size, &type, &name[0] );
+		
+		int loc = -1;
+		if( _caps.computeShaders )
+		{
+			// Program interface queries return the location by index instead of by name
+			const GLenum locationProp[ 1 ] = { GL_LOCATION };
+			glGetProgramResourceiv( programObj, GL_UNIFORM, i, 1, locationProp, 1, 0x0, &loc );
+		}
+		else
+		{
+			loc = glGetUniformLocation( programObj, &name[0] );
+		}
+		if( loc < 0 ) continue;  // Members of uniform blocks
+
+		shader.uniformLocs[&name[0]] = loc;
+
+		// Arrays are listed with the subscript of the first element but can also be referenced without it
+		if( nameLength > 3 && strcmp( &name[nameLength - 3], "[0]" ) == 0 )
+			shader.uniformLocs[std::string( &name[0], nameLength - 3 )] = loc;
+	}
+
+	if( _caps.computeShaders )
+	{
+		int blockCount = 0;
+		glGetProgramInterfaceiv( programObj, GL_SHADER_STORAGE_BLOCK, GL_ACTIVE_RESOURCES, &blockCount );
+		glGetProgramInterfaceiv( programObj, GL_SHADER_STORAGE_BLOCK, GL_MAX_NAME_LENGTH, &maxNameLength );
+		name.assign( maxNameLength + 1, 0 );
+
+		for( int i = 0; i < blockCount; ++i )
+		{
+			const GLenum bufBindingPoint[ 1 ] = { GL_BUFFER_BINDING };
+			int binding = -1;
+			glGetProgramResourceName( programObj, GL_SHADER_STORAGE_BLOCK, i, (int)name.size(), 0x0, &name[0] );
+			glGetProgramResourceiv( programObj, GL_SHADER_STORAGE_BLOCK, i, 1, bufBindingPoint, 1, 0x0, &binding );
+			shader.bufferLocs[&name[0]] = binding;
+		}
+	}
 }
 
 
@@ -1384,28 +1683,29 @@ void RenderDeviceGLES3::bindShader( uint32 shaderId )
 int RenderDeviceGLES3::getShaderConstLoc( uint32 shaderId, const char *name )
 {
 	RDIShaderGLES3 &shader = _shaders.getRef( shaderId );
-	return glGetUniformLocation( shader.oglProgramObj, name );
+	std::map< std::string, int >::const_iterator itr = shader.uniformLocs.find( name );
+	if( itr != shader.uniformLocs.end() ) return itr->second;
+
+	// Single elements of arrays are not listed as active uniforms
+	if( strchr( name, '[' ) != 0x0 ) return glGetUniformLocation( shader.oglProgramObj, name );
+
+	return -1;
 }
 
 
 int RenderDeviceGLES3::getShaderSamplerLoc( uint32 shaderId, const char *name )
 {
-	RDIShaderGLES3 &shader = _shaders.getRef( shaderId );
-	return glGetUniformLocation( shader.oglProgramObj, name );
+	return getShaderConstLoc( shaderId, name );
 }
 
+
 int RenderDeviceGLES3::getShaderBufferLoc( uint32 shaderId, const char *name )
 {
 	if ( _caps.computeShaders )
 	{
 		RDIShaderGLES3 &shader = _shaders.getRef( shaderId );
-		int idx = glGetProgramResourceIndex( shader.oglProgramObj, GL_SHADER_STORAGE_BLOCK, name );
-		if( idx != -1 )
-		{
-			const GLenum bufBindingPoint[ 1 ] = { GL_BUFFER_BINDING };
-			glGetProgramResourceiv( shader.oglProgramObj, GL_SHADER_STORAGE_BLOCK, idx, 1, bufBindingPoint, 1, 0, &idx );
-		}
-		return idx;
+		std::map< std::string, int >::const_iterator itr = shader.bufferLocs.find( name );
+		return itr != shader.bufferLocs.end() ? itr->second : -1;
 	}
 	else
 	{
@@ -1480,6 +1780,19 @@ void RenderDeviceGLES3::runComputeShader( uint32 shaderId, uint32 xDim, uint32 y
 		glDispatchCompute( xDim, yDim, zDim );
 }
 
+
+void RenderDeviceGLES3::runComputeShaderIndirect( uint32 shaderId, uint32 bufObj, uint32 offset )
+{
+	bindShader( shaderId );
+
+	if ( commitStates( ~PM_GEOMETRY ) )
+	{
+		glBindBuffer( GL_DISPATCH_INDIRECT_BUFFER, _buffers.getRef( bufObj ).glObj );
+		glDispatchComputeIndirect( offset );
+		glBindBuffer( GL_DISPATCH_INDIRECT_BUFFER, 0 );
+	}
+}
+
 // =================================================================================================
 // Renderbuffers
 // =================================================================================================
@@ -2019,6 +2332,62 @@ uint32 RenderDeviceGLES3::getQueryResult( uint32 queryObj )
 }
 
 
+// =================================================================================================
+// Fences
+// =================================================================================================
+
+uint32 RenderDeviceGLES3::createFence()
+{
+	RDIFenceGLES3 fence;
+	fence.sync = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+
+	return _fences.add( fence );
+}
+
+
+bool RenderDeviceGLES3::isFenceSignaled( uint32 fenceObj )
+{
+	if( fenceObj == 0 ) return true;
+
+	const RDIFenceGLES3 &fence = _fences.getRef( fenceObj );
+
+	// Zero timeout so that the caller never stalls, flushing makes sure the fence is submitted
+	GLenum result = glClientWaitSync( ( GLsync ) fence.sync, GL_SYNC_FLUSH_COMMANDS_BIT, 0 );
+
+	return result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED;
+}
+
+
+bool RenderDeviceGLES3::waitForFence( uint32 fenceObj )
+{
+	if( fenceObj == 0 ) return true;
+
+	const RDIFenceGLES3 &fence = _fences.getRef( fenceObj );
+
+	// Wait in slices of 100 ms, only the first wait needs to flush the commands
+	GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+	for( int i = 0; i < 10; ++i )
+	{
+		GLenum result = glClientWaitSync( ( GLsync ) fence.sync, flags, 100000000 );
+		if( result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED ) return true;
+		if( result == GL_WAIT_FAILED ) return false;
+		flags = 0;
+	}
+
+	return false;
+}
+
+
+void RenderDeviceGLES3::destroyFence( uint32 &fenceObj )
+{
+	if( fenceObj == 0 ) return;
+
+	glDeleteSync( ( GLsync ) _fences.getRef( fenceObj ).sync );
+	_fences.remove( fenceObj );
+	fenceObj = 0;
+}
+
+
 // =================================================================================================
 // Internal state management
 // =================================================================================================
@@ -2063,6 +2432,7 @@ bool RenderDeviceGLES3::applyVertexLayout( RDIGeometryInfoGLES3 &geo )
 			glBindBuffer( GL_ARRAY_BUFFER, _buffers.getRef( geo.vertexBufInfo[ attrib.vbSlot ].vbObj ).glObj );
 			glVertexAttribPointer( attribIndex, attrib.size, GL_FLOAT, GL_FALSE,
 									vbSlot.stride, (char *)0 + vbSlot.offset + attrib.offset );
+			glVertexAttribDivisor( attribIndex, attrib.divisor );
 
 			newVertexAttribMask |= 1 << attribIndex;
 		}
@@ -2167,7 +2537,11 @@ void RenderDeviceGLES3::applyRenderStates()
 										   GL_ONE_MINUS_DST_COLOR, GL_ONE_MINUS_SRC_COLOR, GL_ZERO, GL_ZERO, GL_ZERO, GL_ZERO, GL_ZERO, GL_ZERO };
 			
 			glEnable( GL_BLEND );
-			glBlendFunc( oglBlendFuncs[_newBlendState.srcBlendFunc], oglBlendFuncs[_newBlendState.destBlendFunc] );
+			if( _newBlendState.separateAlphaBlend )
+				glBlendFuncSeparate( oglBlendFuncs[_newBlendState.srcBlendFunc], oglBlendFuncs[_newBlendState.destBlendFunc],
+				                     oglBlendFuncs[_newBlendState.srcAlphaBlendFunc], oglBlendFuncs[_newBlendState.destAlphaBlendFunc] );
+			else
+				glBlendFunc( oglBlendFuncs[_newBlendState.srcBlendFunc], oglBlendFuncs[_newBlendState.destBlendFunc] );
 		}
 		
 		_curBlendState.hash = _newBlendState.hash;
@@ -2206,9 +2580,22 @@ void RenderDeviceGLES3::applyRenderStates()
 
 void RenderDeviceGLES3::setStorageBuffer( uint8 slot, uint32 bufObj )
 {
-	ASSERT( slot < _maxComputeBufferAttachments && _storageBufs.size() < _maxComputeBufferAttachments );
+	ASSERT( slot < _maxComputeBufferAttachments );
 
 	RDIBufferGLES3 &buf = _buffers.getRef( bufObj );
+
+	// Rebinding a slot replaces the previous buffer instead of accumulating attachments
+	for( size_t i = 0; i < _storageBufs.size(); ++i )
+	{
+		if( _storageBufs[ i ].slot == slot )
+		{
+			_storageBufs[ i ].oglObject = buf.glObj;
+			_pendingMask |= PM_COMPUTE;
+			return;
+		}
+	}
+
+	ASSERT( _storageBufs.size() < _maxComputeBufferAttachments );
 	_storageBufs.push_back( RDIShaderStorageGLES3( slot, buf.glObj ) );
 
 	_pendingMask |= PM_COMPUTE;
@@ -2280,6 +2667,7 @@ bool RenderDeviceGLES3::commitStates( uint32 filter )
 				{
 					glBindTexture( GL_TEXTURE_CUBE_MAP, 0 );
 					glBindTexture( GL_TEXTURE_3D, 0 );
+					glBindTexture( GL_TEXTURE_2D_ARRAY, 0 );
 					glBindTexture( GL_TEXTURE_2D, 0 );
 				}
 			}
@@ -2306,7 +2694,16 @@ bool RenderDeviceGLES3::commitStates( uint32 filter )
 		// Place memory barriers
 		if ( mask & PM_BARRIER )
 		{
-			if ( _memBarriers != NotSet ) glMemoryBarrier( memoryBarrierType[ ( uint32 ) _memBarriers - 1 ] );
+			if ( _memBarriers != NotSet )
+			{
+				GLbitfield barrierBits = 0;
+				for ( uint32 i = 0; i < 6; ++i )
+				{
+					if ( _memBarriers & ( 1 << i ) ) barrierBits |= memoryBarrierType[ i ];
+				}
+				glMemoryBarrier( barrierBits );
+				_memBarriers = NotSet;
+			}
 			_pendingMask &= ~PM_BARRIER;
 		}
 
@@ -2445,5 +2842,78 @@ void RenderDeviceGLES3::drawIndexed( RDIPrimType primType, uint32 firstIndex, ui
 	CHECK_GL_ERROR
 }
 
+
+void RenderDeviceGLES3::drawIndexedBaseVertex( RDIPrimType primType, uint32 firstIndex, uint32 numIndices,
+											   uint32 firstVert, uint32 numVerts, uint32 baseVertex )
+{
+	_drawType = primType;
+
+	if( commitStates() )
+	{
+		firstIndex *= (_indexFormat == IDXFMT_16) ? sizeof( short ) : sizeof( int );
+
+		glDrawRangeElementsBaseVertexEXT( RDI_GLES3::primitiveTypes[ _drawType ], firstVert, firstVert + numVerts,
+										  numIndices, RDI_GLES3::indexFormats[ _indexFormat ], ( char * ) 0 + firstIndex,
+										  ( GLint ) baseVertex );
+	}
+
+	CHECK_GL_ERROR
+}
+
+
+void RenderDeviceGLES3::drawIndexedInstanced( RDIPrimType primType, uint32 firstIndex, uint32 numIndices,
+                                              uint32 firstVert, uint32 numVerts, uint32 numInstances )
+{
+	H3D_UNUSED_VAR( firstVert );
+	H3D_UNUSED_VAR( numVerts );
+
+	_drawType = primType;
+
+	if( commitStates() )
+	{
+		firstIndex *= (_indexFormat == IDXFMT_16) ? sizeof( short ) : sizeof( int );
+
+		glDrawElementsInstanced( RDI_GLES3::primitiveTypes[ _drawType ], numIndices,
+								 RDI_GLES3::indexFormats[ _indexFormat ], ( char * ) 0 + firstIndex, numInstances );
+	}
+
+	CHECK_GL_ERROR
+}
+
+
+void RenderDeviceGLES3::drawIndexedInstancedBaseVertex( RDIPrimType primType, uint32 firstIndex, uint32 numIndices,
+                                                        uint32 firstVert, uint32 numVerts, uint32 numInstances,
+                                                        uint32 baseVertex )
+{
+	H3D_UNUSED_VAR( firstVert );
+	H3D_UNUSED_VAR( numVerts );
+
+	_drawType = primType;
+
+	if( commitStates() )
+	{
+		firstIndex *= (_indexFormat == IDXFMT_16) ? sizeof( short ) : sizeof( int );
+
+		glDrawElementsInstancedBaseVertexEXT( RDI_GLES3::primitiveTypes[ _drawType ], numIndices,
+											  RDI_GLES3::indexFormats[ _indexFormat ], ( char * ) 0 + firstIndex,
+											  numInstances, ( GLint ) baseVertex );
+	}
+
+	CHECK_GL_ERROR
+}
+
+
+void RenderDeviceGLES3::drawIndirect( RDIPrimType primType, uint32 bufObj, uint32 offset )
+{
+	if( commitStates() )
+	{
+		glBindBuffer( GL_DRAW_INDIRECT_BUFFER, _buffers.getRef( bufObj ).glObj );
+		glDrawArraysIndirect( RDI_GLES3::primitiveTypes[ ( uint32 ) primType ], ( char * ) 0 + offset );
+		glBindBuffer( GL_DRAW_INDIRECT_BUFFER, 0 );
+	}
+
+	CHECK_GL_ERROR
+}
+
 } // namespace RDI_GLES3
 }  // namespace
@@ -16,6 +16,7 @@
 #include "egRendererBase.h"
 #include <string>
 #include <vector>
+#include <map>
 
 
 namespace Horde3D {
@@ -68,6 +69,13 @@ struct RDIBufferGLES3
 	RDIBufferGLES3() : type( 0 ), glObj( 0 ), size( 0 ), geometryRefCount( 0 ) {}
 };
 
+struct RDIFenceGLES3
+{
+	void  *sync;  // GLsync
+
+	RDIFenceGLES3() : sync( 0x0 ) {}
+};
+
 struct RDIVertBufSlotGLES3
 {
 	uint32  vbObj;
@@ -150,6 +158,9 @@ struct RDIShaderGLES3
 {
 	uint32          oglProgramObj;
 	RDIInputLayoutGLES3  inputLayouts[MaxNumVertexLayouts];
+	std::map< std::string, int >  uniformLocs;  // Locations of all active uniforms, gathered once after linking
+	std::map< std::string, int >  bufferLocs;  // Binding points of all active storage blocks
+	bool            pending;  // Compilation and linking started but results not queried yet
 };
 
 
@@ -213,6 +224,9 @@ public:
 	void updateBufferData( uint32 geoObj, uint32 bufObj, uint32 offset, uint32 size, void *data );
 	void *mapBuffer( uint32 geoObj, uint32 bufObj, uint32 offset, uint32 size, RDIBufferMappingTypes mapType );
 	void unmapBuffer( uint32 geoObj, uint32 bufObj );
+	uint32 createPixelBuffer( uint32 size );
+	void *mapPixelBuffer( uint32 bufObj );
+	void unmapPixelBuffer( uint32 bufObj );
 
 	// Textures
 // 	uint32 calcTextureSize( TextureFormats::List format, int width, int height, int depth );
@@ -225,10 +239,17 @@ public:
 	bool getTextureData( uint32 texObj, int slice, int mipLevel, void *buffer );
 	uint32 getTextureMem() const { return _textureMem; }
 	void bindImageToTexture( uint32 texObj, void* eglImage );
+	void updateTextureFromBuffer( uint32 texObj, uint32 bufObj, uint32 offset );
+	void copyTextureSlice( uint32 srcTexObj, int srcSlice, uint32 dstTexObj, int dstSlice, int mipLevel );
+	uint64 getTextureHandle( uint32 texObj, uint16 samplerState );
 
 	// Shaders
 	uint32 createShader( const char *vertexShaderSrc, const char *fragmentShaderSrc, const char *geometryShaderSrc,
 						 const char *tessControlShaderSrc, const char *tessEvaluationShaderSrc, const char *computeShaderSrc );
+	uint32 beginCreatingShader( const char *vertexShaderSrc, const char *fragmentShaderSrc, const char *geometryShaderSrc,
+								 const char *tessControlShaderSrc, const char *tessEvaluationShaderSrc, const char *computeShaderSrc );
+	bool isShaderPending( uint32 shaderId );
+	bool finishCreatingShader( uint32 &shaderId );
 	void destroyShader( uint32 &shaderId );
 	void bindShader( uint32 shaderId );
 	std::string getShaderLog() const { return _shaderLog; }
@@ -240,6 +261,7 @@ public:
 	const char *getDefaultVSCode();
 	const char *getDefaultFSCode();
 	void runComputeShader( uint32 shaderId, uint32 xDim, uint32 yDim, uint32 zDim );
+	void runComputeShaderIndirect( uint32 shaderId, uint32 bufObj, uint32 offset );
 
 	// Renderbuffers
 	uint32 createRenderBuffer( uint32 width, uint32 height, TextureFormats::List format,
@@ -258,6 +280,12 @@ public:
 	void endQuery( uint32 queryObj );
 	uint32 getQueryResult( uint32 queryObj );
 
+	// Fences
+	uint32 createFence();
+	bool isFenceSignaled( uint32 fenceObj );
+	bool waitForFence( uint32 fenceObj );
+	void destroyFence( uint32 &fenceObj );
+
 	// Render Device dependent GPU Timer
 	GPUTimer *createGPUTimer()
 	{
@@ -277,6 +305,13 @@ public:
 	void draw( RDIPrimType primType, uint32 firstVert, uint32 numVerts );
 	void drawIndexed( RDIPrimType primType, uint32 firstIndex, uint32 numIndices,
 	                  uint32 firstVert, uint32 numVerts );
+	void drawIndexedBaseVertex( RDIPrimType primType, uint32 firstIndex, uint32 numIndices,
+	                            uint32 firstVert, uint32 numVerts, uint32 baseVertex );
+	void drawIndexedInstanced( RDIPrimType primType, uint32 firstIndex, uint32 numIndices,
+	                           uint32 firstVert, uint32 numVerts, uint32 numInstances );
+	void drawIndexedInstancedBaseVertex( RDIPrimType primType, uint32 firstIndex, uint32 numIndices,
+	                                     uint32 firstVert, uint32 numVerts, uint32 numInstances, uint32 baseVertex );
+	void drawIndirect( RDIPrimType primType, uint32 bufObj, uint32 offset );
 
 // -----------------------------------------------------------------------------
 // Getters
@@ -306,6 +341,8 @@ protected:
 	uint32 createShaderProgram( const char *vertexShaderSrc, const char *fragmentShaderSrc, const char *geometryShaderSrc, 
 								const char *tessControlShaderSrc, const char *tessEvalShaderSrc, const char *computeShaderSrc );
 	bool linkShaderProgram( uint32 programObj );
+	void initShaderInputLayouts( RDIShaderGLES3 &shader );
+	void initShaderLocations( RDIShaderGLES3 &shader );
 	void resolveRenderBuffer( uint32 rbObj );
 
 	void checkError();
@@ -330,6 +367,7 @@ protected:
 	RDIObjects< RDIShaderGLES3 >        _shaders;
 	RDIObjects< RDIRenderBufferGLES3 >  _rendBufs;
 	RDIObjects< RDIGeometryInfoGLES3 >  _vaos;
+	RDIObjects< RDIFenceGLES3 >         _fences;
 	std::vector< RDIShaderStorageGLES3 >  _storageBufs;
 
 //	uint32                _prevShaderId, _curShaderId;
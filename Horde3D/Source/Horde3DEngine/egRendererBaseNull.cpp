@@ -0,0 +1,1116 @@
+// *************************************************************************************************
+//
+// Horde3D
+//   Next-Generation Graphics Engine
+// --------------------------------------
+// Copyright (C) 2006-2021 Nicolas Schulz and Horde3D team
+//
+// This software is distributed under the terms of the Eclipse Public License v1.0.
+// A copy of the license may be obtained at: http://www.eclipse.org/legal/epl-v10.html
+//
+// *************************************************************************************************
+
+#include "egRendererBaseNull.h"
+#include "egModules.h"
+#include "egCom.h"
+
+#include <cstring>
+
+#include "utDebug.h"
+
+namespace Horde3D {
+namespace RDI_Null {
+
+// Buffer types, only used for validation
+enum NullBufferTypes
+{
+	BufVertex = 1,
+	BufIndex,
+	BufTexture,
+	BufStorage
+};
+
+// Debug shaders
+static const char *defaultShaderVS =
+	"uniform mat4 viewProjMat;\n"
+	"uniform mat4 worldMat;\n"
+	"attribute vec3 vertPos;\n";
+
+static const char *defaultShaderFS =
+	"uniform vec4 color;\n";
+
+// =================================================================================================
+// GPUTimer
+// =================================================================================================
+
+GPUTimerNull::GPUTimerNull()
+{
+	_beginQuery.bind< GPUTimerNull, &GPUTimerNull::beginQuery >( this );
+	_endQuery.bind< GPUTimerNull, &GPUTimerNull::endQuery > ( this );
+	_updateResults.bind< GPUTimerNull, &GPUTimerNull::updateResults >( this );
+	_reset.bind< GPUTimerNull, &GPUTimerNull::reset >( this );
+
+	reset();
+}
+
+
+GPUTimerNull::~GPUTimerNull()
+{
+}
+
+
+void GPUTimerNull::beginQuery( uint32 /*frameID*/ )
+{
+}
+
+
+void GPUTimerNull::endQuery()
+{
+}
+
+
+bool GPUTimerNull::updateResults()
+{
+	_time = 0;
+	return true;
+}
+
+
+void GPUTimerNull::reset()
+{
+	_time = 0.f;
+}
+
+
+// =================================================================================================
+// RenderDevice
+// =================================================================================================
+
+RenderDeviceNull::RenderDeviceNull()
+{
+	initRDIFuncs(); // bind render device functions
+
+	_numVertexLayouts = 0;
+
+	_vpX = 0; _vpY = 0; _vpWidth = 320; _vpHeight = 240;
+	_scX = 0; _scY = 0; _scWidth = 320; _scHeight = 240;
+	_fbWidth = 320; _fbHeight = 240;
+	_prevShaderId = _curShaderId = 0;
+	_curRendBuf = 0; _outputBufferIndex = 0;
+	_textureMem = 0; _bufferMem = 0;
+	_curRasterState.hash = _newRasterState.hash = 0;
+	_curBlendState.hash = _newBlendState.hash = 0;
+	_curDepthStencilState.hash = _newDepthStencilState.hash = 0;
+	_curGeometryIndex = 1;
+	_defaultFBO = 0;
+	_defaultFBOMultisampled = false;
+	_pendingMask = 0;
+	_tessPatchVerts = 0;
+	_memBarriers = NotSet;
+	_depthFormat = 0;
+	_maxTexSlots = 32;
+	_numQueries = 0;
+	_recordCommands = false;
+	_computeHandler = 0x0;
+	_computeHandlerData = 0x0;
+
+	// add default geometry for resetting
+	_geometries.add( RDIGeometryInfoNull() );
+}
+
+
+RenderDeviceNull::~RenderDeviceNull()
+{
+}
+
+
+void RenderDeviceNull::initRDIFuncs()
+{
+	_delegate_init.bind< RenderDeviceNull, &RenderDeviceNull::init >( this );
+	_delegate_initStates.bind< RenderDeviceNull, &RenderDeviceNull::initStates >( this );
+	_delegate_enableDebugOutput.bind< RenderDeviceNull, &RenderDeviceNull::enableDebugOutput >( this );
+	_delegate_disableDebugOutput.bind< RenderDeviceNull, &RenderDeviceNull::disableDebugOutput >( this );
+	_delegate_registerVertexLayout.bind< RenderDeviceNull, &RenderDeviceNull::registerVertexLayout >( this );
+	_delegate_beginRendering.bind< RenderDeviceNull, &RenderDeviceNull::beginRendering >( this );
+
+	_delegate_beginCreatingGeometry.bind< RenderDeviceNull, &RenderDeviceNull::beginCreatingGeometry >( this );
+	_delegate_finishCreatingGeometry.bind< RenderDeviceNull, &RenderDeviceNull::finishCreatingGeometry >( this );
+	_delegate_destroyGeometry.bind< RenderDeviceNull, &RenderDeviceNull::destroyGeometry >( this );
+	_delegate_setGeomVertexParams.bind< RenderDeviceNull, &RenderDeviceNull::setGeomVertexParams >( this );
+	_delegate_setGeomIndexParams.bind< RenderDeviceNull, &RenderDeviceNull::setGeomIndexParams >( this );
+	_delegate_createVertexBuffer.bind< RenderDeviceNull, &RenderDeviceNull::createVertexBuffer >( this );
+	_delegate_createIndexBuffer.bind< RenderDeviceNull, &RenderDeviceNull::createIndexBuffer >( this );
+	_delegate_createTextureBuffer.bind< RenderDeviceNull, &RenderDeviceNull::createTextureBuffer >( this );
+	_delegate_createShaderStorageBuffer.bind< RenderDeviceNull, &RenderDeviceNull::createShaderStorageBuffer >( this );
+	_delegate_destroyBuffer.bind< RenderDeviceNull, &RenderDeviceNull::destroyBuffer >( this );
+	_delegate_destroyTextureBuffer.bind< RenderDeviceNull, &RenderDeviceNull::destroyTextureBuffer >( this );
+	_delegate_updateBufferData.bind< RenderDeviceNull, &RenderDeviceNull::updateBufferData >( this );
+	_delegate_mapBuffer.bind< RenderDeviceNull, &RenderDeviceNull::mapBuffer >( this );
+	_delegate_unmapBuffer.bind< RenderDeviceNull, &RenderDeviceNull::unmapBuffer >( this );
+	_delegate_createPixelBuffer.bind< RenderDeviceNull, &RenderDeviceNull::createPixelBuffer >( this );
+	_delegate_mapPixelBuffer.bind< RenderDeviceNull, &RenderDeviceNull::mapPixelBuffer >( this );
+	_delegate_unmapPixelBuffer.bind< RenderDeviceNull, &RenderDeviceNull::unmapPixelBuffer >( this );
+
+	_delegate_createTexture.bind< RenderDeviceNull, &RenderDeviceNull::createTexture >( this );
+	_delegate_generateTextureMipmap.bind< RenderDeviceNull, &RenderDeviceNull::generateTextureMipmap >( this );
+	_delegate_uploadTextureData.bind< RenderDeviceNull, &RenderDeviceNull::uploadTextureData >( this );
+	_delegate_destroyTexture.bind< RenderDeviceNull, &RenderDeviceNull::destroyTexture >( this );
+	_delegate_updateTextureData.bind< RenderDeviceNull, &RenderDeviceNull::updateTextureData >( this );
+	_delegate_getTextureData.bind< RenderDeviceNull, &RenderDeviceNull::getTextureData >( this );
+	_delegate_bindImageToTexture.bind< RenderDeviceNull, &RenderDeviceNull::bindImageToTexture >( this );
+	_delegate_updateTextureFromBuffer.bind< RenderDeviceNull, &RenderDeviceNull::updateTextureFromBuffer >( this );
+	_delegate_copyTextureSlice.bind< RenderDeviceNull, &RenderDeviceNull::copyTextureSlice >( this );
+	_delegate_getTextureHandle.bind< RenderDeviceNull, &RenderDeviceNull::getTextureHandle >( this );
+
+	_delegate_createShader.bind< RenderDeviceNull, &RenderDeviceNull::createShader >( this );
+	_delegate_beginCreatingShader.bind< RenderDeviceNull, &RenderDeviceNull::beginCreatingShader >( this );
+	_delegate_isShaderPending.bind< RenderDeviceNull, &RenderDeviceNull::isShaderPending >( this );
+	_delegate_finishCreatingShader.bind< RenderDeviceNull, &RenderDeviceNull::finishCreatingShader >( this );
+	_delegate_destroyShader.bind< RenderDeviceNull, &RenderDeviceNull::destroyShader >( this );
+	_delegate_bindShader.bind< RenderDeviceNull, &RenderDeviceNull::bindShader >( this );
+	_delegate_getShaderConstLoc.bind< RenderDeviceNull, &RenderDeviceNull::getShaderConstLoc >( this );
+	_delegate_getShaderSamplerLoc.bind< RenderDeviceNull, &RenderDeviceNull::getShaderSamplerLoc >( this );
+	_delegate_getShaderBufferLoc.bind< RenderDeviceNull, &RenderDeviceNull::getShaderBufferLoc >( this );
+	_delegate_runComputeShader.bind< RenderDeviceNull, &RenderDeviceNull::runComputeShader >( this );
+	_delegate_runComputeShaderIndirect.bind< RenderDeviceNull, &RenderDeviceNull::runComputeShaderIndirect >( this );
+	_delegate_setShaderConst.bind< RenderDeviceNull, &RenderDeviceNull::setShaderConst >( this );
+	_delegate_setShaderSampler.bind< RenderDeviceNull, &RenderDeviceNull::setShaderSampler >( this );
+	_delegate_getDefaultVSCode.bind< RenderDeviceNull, &RenderDeviceNull::getDefaultVSCode >( this );
+	_delegate_getDefaultFSCode.bind< RenderDeviceNull, &RenderDeviceNull::getDefaultFSCode >( this );
+
+	_delegate_createRenderBuffer.bind< RenderDeviceNull, &RenderDeviceNull::createRenderBuffer >( this );
+	_delegate_destroyRenderBuffer.bind< RenderDeviceNull, &RenderDeviceNull::destroyRenderBuffer >( this );
+	_delegate_getRenderBufferTex.bind< RenderDeviceNull, &RenderDeviceNull::getRenderBufferTex >( this );
+	_delegate_setRenderBuffer.bind< RenderDeviceNull, &RenderDeviceNull::setRenderBuffer >( this );
+	_delegate_getRenderBufferData.bind< RenderDeviceNull, &RenderDeviceNull::getRenderBufferData >( this );
+	_delegate_getRenderBufferDimensions.bind< RenderDeviceNull, &RenderDeviceNull::getRenderBufferDimensions >( this );
+
+	_delegate_createOcclusionQuery.bind< RenderDeviceNull, &RenderDeviceNull::createOcclusionQuery >( this );
+	_delegate_destroyQuery.bind< RenderDeviceNull, &RenderDeviceNull::destroyQuery >( this );
+	_delegate_beginQuery.bind< RenderDeviceNull, &RenderDeviceNull::beginQuery >( this );
+	_delegate_endQuery.bind< RenderDeviceNull, &RenderDeviceNull::endQuery >( this );
+	_delegate_getQueryResult.bind< RenderDeviceNull, &RenderDeviceNull::getQueryResult >( this );
+
+	_delegate_createGPUTimer.bind< RenderDeviceNull, &RenderDeviceNull::createGPUTimer >( this );
+	_delegate_createFence.bind< RenderDeviceNull, &RenderDeviceNull::createFence >( this );
+	_delegate_isFenceSignaled.bind< RenderDeviceNull, &RenderDeviceNull::isFenceSignaled >( this );
+	_delegate_waitForFence.bind< RenderDeviceNull, &RenderDeviceNull::waitForFence >( this );
+	_delegate_destroyFence.bind< RenderDeviceNull, &RenderDeviceNull::destroyFence >( this );
+	_delegate_commitStates.bind< RenderDeviceNull, &RenderDeviceNull::commitStates >( this );
+	_delegate_resetStates.bind< RenderDeviceNull, &RenderDeviceNull::resetStates >( this );
+	_delegate_clear.bind< RenderDeviceNull, &RenderDeviceNull::clear >( this );
+
+	_delegate_draw.bind< RenderDeviceNull, &RenderDeviceNull::draw >( this );
+	_delegate_drawIndexed.bind< RenderDeviceNull, &RenderDeviceNull::drawIndexed >( this );
+	_delegate_drawIndexedBaseVertex.bind< RenderDeviceNull, &RenderDeviceNull::drawIndexedBaseVertex >( this );
+	_delegate_drawIndexedInstanced.bind< RenderDeviceNull, &RenderDeviceNull::drawIndexedInstanced >( this );
+	_delegate_drawIndexedInstancedBaseVertex.bind< RenderDeviceNull, &RenderDeviceNull::drawIndexedInstancedBaseVertex >( this );
+	_delegate_drawIndirect.bind< RenderDeviceNull, &RenderDeviceNull::drawIndirect >( this );
+	_delegate_setStorageBuffer.bind< RenderDeviceNull, &RenderDeviceNull::setStorageBuffer >( this );
+}
+
+
+void RenderDeviceNull::initStates()
+{
+}
+
+
+bool RenderDeviceNull::init()
+{
+	Modules::log().writeInfo( "Initializing Null backend (no rendering output)" );
+
+	// Report a fully featured device so that all engine code paths can be exercised
+	_caps.texFloat = true;
+	_caps.texNPOT = true;
+	_caps.rtMultisampling = true;
+	_caps.geometryShaders = true;
+	_caps.tesselation = true;
+	_caps.computeShaders = true;
+	_caps.instancing = true;
+	_caps.maxJointCount = 330;
+	_caps.maxTexUnitCount = 96;
+	_caps.texDXT = true;
+	_caps.texETC2 = true;
+	_caps.texBPTC = true;
+	_caps.texASTC = true;
+	_caps.parallelShaderCompile = true;
+	_caps.drawBaseVertex = true;
+	_caps.pixelBuffers = true;
+	_caps.indirectDraws = true;
+	_caps.clipDistances = true;
+	_caps.texArrays = true;
+	_caps.bindlessTextures = true;
+
+	resetStates();
+
+	return true;
+}
+
+
+// =================================================================================================
+// Vertex layouts
+// =================================================================================================
+
+uint32 RenderDeviceNull::registerVertexLayout( uint32 numAttribs, VertexLayoutAttrib *attribs )
+{
+	if( _numVertexLayouts == MaxNumVertexLayouts )
+		return 0;
+
+	_vertexLayouts[_numVertexLayouts].numAttribs = numAttribs;
+
+	for( uint32 i = 0; i < numAttribs; ++i )
+		_vertexLayouts[_numVertexLayouts].attribs[i] = attribs[i];
+
+	return ++_numVertexLayouts;
+}
+
+
+// =================================================================================================
+// Buffers
+// =================================================================================================
+
+void RenderDeviceNull::beginRendering()
+{
+	resetStates();
+}
+
+
+uint32 RenderDeviceNull::beginCreatingGeometry( uint32 vlObj )
+{
+	RDIGeometryInfoNull geo;
+	geo.layout = vlObj;
+
+	return _geometries.add( geo );
+}
+
+
+void RenderDeviceNull::finishCreatingGeometry( uint32 geoObj )
+{
+	ASSERT( geoObj > 0 )
+	H3D_UNUSED_VAR( geoObj );
+}
+
+
+void RenderDeviceNull::setGeomVertexParams( uint32 geoObj, uint32 vbo, uint32 vbSlot, uint32 offset, uint32 stride )
+{
+	H3D_UNUSED_VAR( vbSlot );
+	H3D_UNUSED_VAR( offset );
+	H3D_UNUSED_VAR( stride );
+
+	RDIGeometryInfoNull &geo = _geometries.getRef( geoObj );
+	RDIBufferNull &buf = _buffers.getRef( vbo );
+
+	buf.geometryRefCount++;
+	geo.vertexBufs.push_back( vbo );
+}
+
+
+void RenderDeviceNull::setGeomIndexParams( uint32 geoObj, uint32 indBuf, RDIIndexFormat format )
+{
+	RDIGeometryInfoNull &geo = _geometries.getRef( geoObj );
+	RDIBufferNull &buf = _buffers.getRef( indBuf );
+
+	buf.geometryRefCount++;
+	geo.indexBuf = indBuf;
+	geo.indexBuf32Bit = ( format == IDXFMT_32 );
+}
+
+
+void RenderDeviceNull::destroyGeometry( uint32& geoObj, bool destroyBindedBuffers )
+{
+	if( geoObj == 0 )
+		return;
+
+	RDIGeometryInfoNull &geo = _geometries.getRef( geoObj );
+
+	for( size_t i = 0; i < geo.vertexBufs.size(); ++i )
+	{
+		decreaseBufferRefCount( geo.vertexBufs[ i ] );
+		if( destroyBindedBuffers ) destroyBuffer( geo.vertexBufs[ i ] );
+	}
+
+	decreaseBufferRefCount( geo.indexBuf );
+	if( destroyBindedBuffers ) destroyBuffer( geo.indexBuf );
+
+	_geometries.remove( geoObj );
+	geoObj = 0;
+}
+
+
+void RenderDeviceNull::decreaseBufferRefCount( uint32 bufObj )
+{
+	if( bufObj == 0 ) return;
+
+	_buffers.getRef( bufObj ).geometryRefCount--;
+}
+
+
+uint32 RenderDeviceNull::createVertexBuffer( uint32 size, const void *data )
+{
+	return createBuffer( BufVertex, size, data );
+}
+
+
+uint32 RenderDeviceNull::createIndexBuffer( uint32 size, const void *data )
+{
+	return createBuffer( BufIndex, size, data );
+}
+
+
+uint32 RenderDeviceNull::createShaderStorageBuffer( uint32 size, const void *data )
+{
+	return createBuffer( BufStorage, size, data );
+}
+
+
+uint32 RenderDeviceNull::createTextureBuffer( TextureFormats::List format, uint32 bufSize, const void *data )
+{
+	H3D_UNUSED_VAR( format );
+
+	return createBuffer( BufTexture, bufSize, data );
+}
+
+
+uint32 RenderDeviceNull::createBuffer( uint32 bufType, uint32 size, const void *data )
+{
+	RDIBufferNull buf;
+	buf.type = bufType;
+	buf.size = size;
+
+	// Storage buffers keep their contents for compute handlers
+	if( bufType == BufStorage )
+	{
+		buf.data.resize( size );
+		if( data != 0x0 && size > 0 ) memcpy( &buf.data[0], data, size );
+	}
+
+	_bufferMem += size;
+	return _buffers.add( buf );
+}
+
+
+void RenderDeviceNull::destroyBuffer( uint32& bufObj )
+{
+	if( bufObj == 0 )
+		return;
+
+	RDIBufferNull &buf = _buffers.getRef( bufObj );
+
+	if( buf.geometryRefCount < 1 )
+	{
+		_bufferMem -= buf.size;
+		_buffers.remove( bufObj );
+		bufObj = 0;
+	}
+}
+
+
+void RenderDeviceNull::destroyTextureBuffer( uint32& bufObj )
+{
+	destroyBuffer( bufObj );
+}
+
+
+void RenderDeviceNull::updateBufferData( uint32 geoObj, uint32 bufObj, uint32 offset, uint32 size, void *data )
+{
+	H3D_UNUSED_VAR( geoObj );
+
+	RDIBufferNull &buf = _buffers.getRef( bufObj );
+	ASSERT( offset + size <= buf.size );
+
+	// Keep contents only for storage buffers and buffers that have been mapped before and thus may be read back
+	if( !buf.data.empty() && data != 0x0 )
+		memcpy( &buf.data[ offset ], data, size );
+}
+
+
+void *RenderDeviceNull::mapBuffer( uint32 geoObj, uint32 bufObj, uint32 offset, uint32 size, RDIBufferMappingTypes mapType )
+{
+	H3D_UNUSED_VAR( geoObj );
+	H3D_UNUSED_VAR( mapType );
+
+	RDIBufferNull &buf = _buffers.getRef( bufObj );
+	ASSERT( offset + size <= buf.size );
+	recordCommand( RDICommandNull::MapBuffer, bufObj, offset, size );
+
+	// Mapped buffers get CPU storage so that the engine can write to them like to real GPU memory
+	if( buf.data.empty() ) buf.data.resize( buf.size );
+
+	return buf.size > 0 ? &buf.data[ offset ] : 0x0;
+}
+
+
+void RenderDeviceNull::unmapBuffer( uint32 geoObj, uint32 bufObj )
+{
+	H3D_UNUSED_VAR( geoObj );
+	H3D_UNUSED_VAR( bufObj );
+}
+
+
+uint32 RenderDeviceNull::createPixelBuffer( uint32 size )
+{
+	return createBuffer( BufTexture, size, 0x0 );
+}
+
+
+void *RenderDeviceNull::mapPixelBuffer( uint32 bufObj )
+{
+	return mapBuffer( 0, bufObj, 0, _buffers.getRef( bufObj ).size, Write );
+}
+
+
+void RenderDeviceNull::unmapPixelBuffer( uint32 bufObj )
+{
+	H3D_UNUSED_VAR( bufObj );
+}
+
+
+// =================================================================================================
+// Textures
+// =================================================================================================
+
+uint32 RenderDeviceNull::createTexture( TextureTypes::List type, int width, int height, int depth,
+                                        TextureFormats::List format,
+                                        int maxMipLevel, bool genMips, bool compress, bool sRGB )
+{
+	H3D_UNUSED_VAR( genMips );
+	H3D_UNUSED_VAR( compress );
+	H3D_UNUSED_VAR( sRGB );
+	ASSERT( depth > 0 );
+
+	RDITextureNull tex;
+	tex.type = type;
+	tex.format = format;
+	tex.width = width;
+	tex.height = height;
+	tex.depth = depth;
+
+	// Calculate memory requirements
+	if( type == TextureTypes::Tex2DArray )
+		tex.memSize = calcTextureSize( format, width, height, 1, maxMipLevel ) * depth;
+	else
+		tex.memSize = calcTextureSize( format, width, height, depth, maxMipLevel );
+	if( type == TextureTypes::TexCube ) tex.memSize *= 6;
+	_textureMem += tex.memSize;
+
+	return _textures.add( tex );
+}
+
+
+void RenderDeviceNull::generateTextureMipmap( uint32 texObj )
+{
+	H3D_UNUSED_VAR( texObj );
+}
+
+
+void RenderDeviceNull::uploadTextureData( uint32 texObj, int slice, int mipLevel, const void *pixels )
+{
+	ASSERT( pixels );
+	H3D_UNUSED_VAR( texObj );
+	H3D_UNUSED_VAR( slice );
+	H3D_UNUSED_VAR( mipLevel );
+	H3D_UNUSED_VAR( pixels );
+}
+
+
+void RenderDeviceNull::destroyTexture( uint32& texObj )
+{
+	if( texObj == 0 )
+		return;
+
+	const RDITextureNull &tex = _textures.getRef( texObj );
+
+	_textureMem -= tex.memSize;
+	_textures.remove( texObj );
+	texObj = 0;
+}
+
+
+void RenderDeviceNull::updateTextureData( uint32 texObj, int slice, int mipLevel, const void *pixels )
+{
+	uploadTextureData( texObj, slice, mipLevel, pixels );
+}
+
+
+bool RenderDeviceNull::getTextureData( uint32 texObj, int slice, int mipLevel, void *buffer )
+{
+	H3D_UNUSED_VAR( slice );
+
+	const RDITextureNull &tex = _textures.getRef( texObj );
+
+	int width = std::max( tex.width >> mipLevel, 1 ), height = std::max( tex.height >> mipLevel, 1 );
+	int depth = tex.type == TextureTypes::Tex3D ? std::max( tex.depth >> mipLevel, 1 ) : 1;
+
+	memset( buffer, 0, calcTextureSize( tex.format, width, height, depth ) );
+
+	return true;
+}
+
+
+void RenderDeviceNull::bindImageToTexture( uint32 texObj, void *eglImage )
+{
+	H3D_UNUSED_VAR( texObj );
+	H3D_UNUSED_VAR( eglImage );
+
+	Modules::log().writeError( "bindImageToTexture is not supported by the Null backend" );
+}
+
+
+void RenderDeviceNull::updateTextureFromBuffer( uint32 texObj, uint32 bufObj, uint32 offset )
+{
+	H3D_UNUSED_VAR( texObj );
+	H3D_UNUSED_VAR( offset );
+
+	ASSERT( _buffers.getRef( bufObj ).type == BufTexture );
+	H3D_UNUSED_VAR( bufObj );
+}
+
+
+void RenderDeviceNull::copyTextureSlice( uint32 srcTexObj, int srcSlice, uint32 dstTexObj, int dstSlice, int mipLevel )
+{
+	H3D_UNUSED_VAR( srcSlice );
+	H3D_UNUSED_VAR( mipLevel );
+
+	const RDITextureNull &src = _textures.getRef( srcTexObj );
+	const RDITextureNull &dst = _textures.getRef( dstTexObj );
+	ASSERT( src.format == dst.format && src.width == dst.width && src.height == dst.height );
+	ASSERT( dst.type != TextureTypes::Tex2DArray || dstSlice < dst.depth );
+	H3D_UNUSED_VAR( src );
+	H3D_UNUSED_VAR( dst );
+	H3D_UNUSED_VAR( dstSlice );
+}
+
+
+uint64 RenderDeviceNull::getTextureHandle( uint32 texObj, uint16 samplerState )
+{
+	// Unique non-zero values are enough since no shader ever dereferences them
+	return ( (uint64)texObj << 16 ) | samplerState | ( (uint64)1 << 63 );
+}
+
+
+// =================================================================================================
+// Shaders
+// =================================================================================================
+
+uint32 RenderDeviceNull::createShader( const char *vertexShaderSrc, const char *fragmentShaderSrc, const char *geometryShaderSrc,
+                                       const char *tessControlShaderSrc, const char *tessEvaluationShaderSrc, const char *computeShaderSrc )
+{
+	_shaderLog = "";
+
+	RDIShaderNull shader;
+	const char *sources[] = { vertexShaderSrc, fragmentShaderSrc, geometryShaderSrc,
+	                          tessControlShaderSrc, tessEvaluationShaderSrc, computeShaderSrc };
+
+	for( uint32 i = 0; i < 6; ++i )
+	{
+		if( sources[i] != 0x0 ) shader.source.append( sources[i] );
+	}
+
+	return _shaders.add( shader );
+}
+
+
+uint32 RenderDeviceNull::beginCreatingShader( const char *vertexShaderSrc, const char *fragmentShaderSrc, const char *geometryShaderSrc,
+                                              const char *tessControlShaderSrc, const char *tessEvaluationShaderSrc, const char *computeShaderSrc )
+{
+	uint32 shaderId = createShader( vertexShaderSrc, fragmentShaderSrc, geometryShaderSrc,
+	                                tessControlShaderSrc, tessEvaluationShaderSrc, computeShaderSrc );
+	_shaders.getRef( shaderId ).pending = true;
+
+	return shaderId;
+}
+
+
+bool RenderDeviceNull::isShaderPending( uint32 shaderId )
+{
+	// Emulate background compilation that completes after the first poll, so that the engine
+	// runs through its fallback path
+	RDIShaderNull &shader = _shaders.getRef( shaderId );
+	bool pending = shader.pending;
+	shader.pending = false;
+
+	return pending;
+}
+
+
+bool RenderDeviceNull::finishCreatingShader( uint32 &shaderId )
+{
+	_shaders.getRef( shaderId ).pending = false;
+
+	return true;
+}
+
+
+void RenderDeviceNull::destroyShader( uint32& shaderId )
+{
+	if( shaderId == 0 )
+		return;
+
+	_shaders.remove( shaderId );
+	shaderId = 0;
+}
+
+
+void RenderDeviceNull::bindShader( uint32 shaderId )
+{
+	_curShaderId = shaderId;
+	_pendingMask |= PM_GEOMETRY;
+}
+
+
+int RenderDeviceNull::findShaderSymbol( uint32 shaderId, const char *name )
+{
+	// Emulate the linker: symbols that occur in the source get a valid location, so that the
+	// engine performs the same amount of uniform work as with a real backend
+	const RDIShaderNull &shader = _shaders.getRef( shaderId );
+
+	std::string symbol( name );
+	size_t arrayPos = symbol.find( '[' );
+	if( arrayPos != std::string::npos ) symbol.erase( arrayPos );
+
+	size_t pos = shader.source.find( symbol );
+	return pos != std::string::npos ? (int)pos : -1;
+}
+
+
+int RenderDeviceNull::getShaderConstLoc( uint32 shaderId, const char *name )
+{
+	return findShaderSymbol( shaderId, name );
+}
+
+
+int RenderDeviceNull::getShaderSamplerLoc( uint32 shaderId, const char *name )
+{
+	return findShaderSymbol( shaderId, name );
+}
+
+
+int RenderDeviceNull::getShaderBufferLoc( uint32 shaderId, const char *name )
+{
+	return findShaderSymbol( shaderId, name );
+}
+
+
+void RenderDeviceNull::setShaderConst( int loc, RDIShaderConstType type, void *values, uint32 count )
+{
+	H3D_UNUSED_VAR( loc );
+	H3D_UNUSED_VAR( type );
+	H3D_UNUSED_VAR( values );
+	H3D_UNUSED_VAR( count );
+}
+
+
+void RenderDeviceNull::setShaderSampler( int loc, uint32 texUnit )
+{
+	H3D_UNUSED_VAR( loc );
+	H3D_UNUSED_VAR( texUnit );
+}
+
+
+const char *RenderDeviceNull::getDefaultVSCode()
+{
+	return defaultShaderVS;
+}
+
+
+const char *RenderDeviceNull::getDefaultFSCode()
+{
+	return defaultShaderFS;
+}
+
+
+void RenderDeviceNull::runComputeShader( uint32 shaderId, uint32 xDim, uint32 yDim, uint32 zDim )
+{
+	bindShader( shaderId );
+	commitStates( ~PM_GEOMETRY );
+	recordCommand( RDICommandNull::Compute, xDim, yDim, zDim );
+
+	if( _computeHandler != 0x0 ) _computeHandler( *this, shaderId, xDim, yDim, zDim, _computeHandlerData );
+}
+
+
+void RenderDeviceNull::runComputeShaderIndirect( uint32 shaderId, uint32 bufObj, uint32 offset )
+{
+	ASSERT( _buffers.getRef( bufObj ).size >= offset + 3 * sizeof( uint32 ) );
+
+	bindShader( shaderId );
+	commitStates( ~PM_GEOMETRY );
+	recordCommand( RDICommandNull::ComputeIndirect, bufObj, offset );
+}
+
+
+// =================================================================================================
+// Renderbuffers
+// =================================================================================================
+
+uint32 RenderDeviceNull::createRenderBuffer( uint32 width, uint32 height, TextureFormats::List format,
+                                             bool depth, uint32 numColBufs, uint32 samples, uint32 maxMipLevel )
+{
+	if( numColBufs > RDIRenderBufferNull::MaxColorAttachmentCount ) return 0;
+
+	RDIRenderBufferNull rb;
+	rb.width = width;
+	rb.height = height;
+	rb.samples = samples;
+
+	for( uint32 j = 0; j < numColBufs; ++j )
+	{
+		rb.colTexs[j] = createTexture( TextureTypes::Tex2D, rb.width, rb.height, 1, format,
+		                               maxMipLevel, maxMipLevel > 0, false, false );
+	}
+
+	if( depth )
+	{
+		rb.depthTex = createTexture( TextureTypes::Tex2D, rb.width, rb.height, 1, TextureFormats::DEPTH,
+		                             0, false, false, false );
+	}
+
+	return _rendBufs.add( rb );
+}
+
+
+void RenderDeviceNull::destroyRenderBuffer( uint32& rbObj )
+{
+	RDIRenderBufferNull &rb = _rendBufs.getRef( rbObj );
+
+	if( rb.depthTex != 0 ) destroyTexture( rb.depthTex );
+
+	for( uint32 i = 0; i < RDIRenderBufferNull::MaxColorAttachmentCount; ++i )
+	{
+		if( rb.colTexs[i] != 0 ) destroyTexture( rb.colTexs[i] );
+	}
+
+	_rendBufs.remove( rbObj );
+	rbObj = 0;
+}
+
+
+void RenderDeviceNull::getRenderBufferDimensions( uint32 rbObj, int *width, int *height )
+{
+	RDIRenderBufferNull &rb = _rendBufs.getRef( rbObj );
+
+	*width = rb.width;
+	*height = rb.height;
+}
+
+
+uint32 RenderDeviceNull::getRenderBufferTex( uint32 rbObj, uint32 bufIndex )
+{
+	RDIRenderBufferNull &rb = _rendBufs.getRef( rbObj );
+
+	if( bufIndex < RDIRenderBufferNull::MaxColorAttachmentCount ) return rb.colTexs[bufIndex];
+	else if( bufIndex == 32 ) return rb.depthTex;
+	else return 0;
+}
+
+
+void RenderDeviceNull::setRenderBuffer( uint32 rbObj )
+{
+	_curRendBuf = rbObj;
+
+	if( rbObj == 0 )
+	{
+		_fbWidth = _vpWidth + _vpX;
+		_fbHeight = _vpHeight + _vpY;
+	}
+	else
+	{
+		// Unbind all textures like the real backends do
+		for( uint32 i = 0; i < 16; ++i ) setTexture( i, 0, 0, 0 );
+		commitStates( PM_TEXTURES );
+
+		RDIRenderBufferNull &rb = _rendBufs.getRef( rbObj );
+		_fbWidth = rb.width;
+		_fbHeight = rb.height;
+
+		// Offscreen buffers are recorded with the viewport that is used for drawing into them
+		recordCommand( RDICommandNull::RenderBuffer, rbObj, _fbWidth, _fbHeight );
+		recordCommand( RDICommandNull::Viewport, _vpWidth, _vpHeight );
+	}
+}
+
+
+bool RenderDeviceNull::getRenderBufferData( uint32 rbObj, int bufIndex, int *width, int *height,
+                                            int *compCount, void *dataBuffer, int bufferSize )
+{
+	int w, h;
+
+	if( rbObj == 0 )
+	{
+		if( bufIndex != 32 && bufIndex != 0 ) return false;
+		w = _vpWidth; h = _vpHeight;
+	}
+	else
+	{
+		RDIRenderBufferNull &rb = _rendBufs.getRef( rbObj );
+
+		if( bufIndex == 32 && rb.depthTex == 0 ) return false;
+		if( bufIndex != 32 )
+		{
+			if( (unsigned)bufIndex >= RDIRenderBufferNull::MaxColorAttachmentCount || rb.colTexs[bufIndex] == 0 )
+				return false;
+		}
+		w = rb.width; h = rb.height;
+	}
+
+	if( width != 0x0 ) *width = w;
+	if( height != 0x0 ) *height = h;
+
+	int comps = (bufIndex == 32 ? 1 : 4);
+	if( compCount != 0x0 ) *compCount = comps;
+
+	// Data is always returned as float
+	if( dataBuffer != 0x0 && bufferSize >= w * h * comps * 4 )
+	{
+		memset( dataBuffer, 0, w * h * comps * 4 );
+		return true;
+	}
+
+	return false;
+}
+
+
+// =================================================================================================
+// Queries
+// =================================================================================================
+
+uint32 RenderDeviceNull::createOcclusionQuery()
+{
+	return ++_numQueries;
+}
+
+
+void RenderDeviceNull::destroyQuery( uint32 queryObj )
+{
+	H3D_UNUSED_VAR( queryObj );
+}
+
+
+void RenderDeviceNull::beginQuery( uint32 queryObj )
+{
+	H3D_UNUSED_VAR( queryObj );
+}
+
+
+void RenderDeviceNull::endQuery( uint32 /*queryObj*/ )
+{
+}
+
+
+uint32 RenderDeviceNull::getQueryResult( uint32 queryObj )
+{
+	H3D_UNUSED_VAR( queryObj );
+
+	// Report everything as visible so that occlusion culling never drops objects
+	return 1;
+}
+
+
+// =================================================================================================
+// Fences
+// =================================================================================================
+
+uint32 RenderDeviceNull::createFence()
+{
+	uint32 fenceObj = _fences.add( RDIFenceNull() );
+	recordCommand( RDICommandNull::CreateFence, fenceObj );
+
+	return fenceObj;
+}
+
+
+bool RenderDeviceNull::isFenceSignaled( uint32 fenceObj )
+{
+	if( fenceObj == 0 ) return true;
+
+	// Report the fence as pending once so that the asynchronous paths of the engine are exercised
+	RDIFenceNull &fence = _fences.getRef( fenceObj );
+	bool signaled = fence.signaled;
+	fence.signaled = true;
+
+	return signaled;
+}
+
+
+bool RenderDeviceNull::waitForFence( uint32 fenceObj )
+{
+	if( fenceObj == 0 ) return true;
+
+	_fences.getRef( fenceObj ).signaled = true;
+	recordCommand( RDICommandNull::WaitFence, fenceObj );
+
+	return true;
+}
+
+
+void RenderDeviceNull::destroyFence( uint32 &fenceObj )
+{
+	if( fenceObj == 0 ) return;
+
+	recordCommand( RDICommandNull::DestroyFence, fenceObj );
+	_fences.remove( fenceObj );
+	fenceObj = 0;
+}
+
+
+// =================================================================================================
+// Internal state management
+// =================================================================================================
+
+void RenderDeviceNull::setStorageBuffer( uint8 slot, uint32 bufObj )
+{
+	if( slot >= _storageBufs.size() ) _storageBufs.resize( slot + 1, 0 );
+	_storageBufs[slot] = bufObj;
+
+	_pendingMask |= PM_COMPUTE;
+}
+
+
+bool RenderDeviceNull::commitStates( uint32 filter )
+{
+	if( _pendingMask & filter )
+	{
+		uint32 mask = _pendingMask & filter;
+
+		if( mask & PM_RENDERSTATES )
+		{
+			_curRasterState.hash = _newRasterState.hash;
+			_curBlendState.hash = _newBlendState.hash;
+			_curDepthStencilState.hash = _newDepthStencilState.hash;
+		}
+
+		if( mask & PM_GEOMETRY )
+		{
+			_prevShaderId = _curShaderId;
+		}
+
+		if( mask & PM_BARRIER )
+		{
+			if( _memBarriers != NotSet ) recordCommand( RDICommandNull::MemoryBarrier, _memBarriers );
+			_memBarriers = NotSet;
+		}
+
+		_pendingMask &= ~mask;
+	}
+
+	return true;
+}
+
+
+void RenderDeviceNull::resetStates()
+{
+	_curGeometryIndex = 1;
+	_curRasterState.hash = 0xFFFFFFFF; _newRasterState.hash = 0;
+	_curBlendState.hash = 0xFFFFFFFF; _newBlendState.hash = 0;
+	_curDepthStencilState.hash = 0xFFFFFFFF; _newDepthStencilState.hash = 0;
+
+	_memBarriers = NotSet;
+
+	for( uint32 i = 0; i < 16; ++i )
+		setTexture( i, 0, 0, 0 );
+
+	setColorWriteMask( true );
+	_pendingMask = 0xFFFFFFFF;
+	commitStates();
+}
+
+
+// =================================================================================================
+// Draw calls and clears
+// =================================================================================================
+
+void RenderDeviceNull::clear( uint32 flags, float *colorRGBA, float depth )
+{
+	H3D_UNUSED_VAR( flags );
+	H3D_UNUSED_VAR( colorRGBA );
+	H3D_UNUSED_VAR( depth );
+
+	commitStates( PM_VIEWPORT | PM_SCISSOR | PM_RENDERSTATES );
+}
+
+
+void RenderDeviceNull::draw( RDIPrimType primType, uint32 firstVert, uint32 numVerts )
+{
+	H3D_UNUSED_VAR( primType );
+	H3D_UNUSED_VAR( firstVert );
+	H3D_UNUSED_VAR( numVerts );
+
+	commitStates();
+	recordCommand( RDICommandNull::Draw, _curShaderId );
+}
+
+
+void RenderDeviceNull::drawIndexed( RDIPrimType primType, uint32 firstIndex, uint32 numIndices,
+                                    uint32 firstVert, uint32 numVerts )
+{
+	H3D_UNUSED_VAR( primType );
+	H3D_UNUSED_VAR( firstIndex );
+	H3D_UNUSED_VAR( numIndices );
+	H3D_UNUSED_VAR( firstVert );
+	H3D_UNUSED_VAR( numVerts );
+
+	commitStates();
+	recordCommand( RDICommandNull::Draw, _curShaderId );
+}
+
+
+void RenderDeviceNull::drawIndexedBaseVertex( RDIPrimType primType, uint32 firstIndex, uint32 numIndices,
+                                              uint32 firstVert, uint32 numVerts, uint32 baseVertex )
+{
+	H3D_UNUSED_VAR( primType );
+	H3D_UNUSED_VAR( firstIndex );
+	H3D_UNUSED_VAR( numIndices );
+	H3D_UNUSED_VAR( firstVert );
+	H3D_UNUSED_VAR( numVerts );
+	H3D_UNUSED_VAR( baseVertex );
+
+	commitStates();
+	recordCommand( RDICommandNull::Draw, _curShaderId );
+}
+
+
+void RenderDeviceNull::drawIndexedInstanced( RDIPrimType primType, uint32 firstIndex, uint32 numIndices,
+                                             uint32 firstVert, uint32 numVerts, uint32 numInstances )
+{
+	H3D_UNUSED_VAR( primType );
+	H3D_UNUSED_VAR( firstIndex );
+	H3D_UNUSED_VAR( numIndices );
+	H3D_UNUSED_VAR( firstVert );
+	H3D_UNUSED_VAR( numVerts );
+	H3D_UNUSED_VAR( numInstances );
+
+	commitStates();
+	recordCommand( RDICommandNull::Draw, _curShaderId );
+}
+
+
+void RenderDeviceNull::drawIndexedInstancedBaseVertex( RDIPrimType primType, uint32 firstIndex, uint32 numIndices,
+                                                       uint32 firstVert, uint32 numVerts, uint32 numInstances,
+                                                       uint32 baseVertex )
+{
+	H3D_UNUSED_VAR( primType );
+	H3D_UNUSED_VAR( firstIndex );
+	H3D_UNUSED_VAR( numIndices );
+	H3D_UNUSED_VAR( firstVert );
+	H3D_UNUSED_VAR( numVerts );
+	H3D_UNUSED_VAR( numInstances );
+	H3D_UNUSED_VAR( baseVertex );
+
+	commitStates();
+	recordCommand( RDICommandNull::Draw, _curShaderId );
+}
+
+
+void RenderDeviceNull::drawIndirect( RDIPrimType primType, uint32 bufObj, uint32 offset )
+{
+	H3D_UNUSED_VAR( primType );
+	H3D_UNUSED_VAR( offset );
+	ASSERT( _buffers.getRef( bufObj ).size >= offset + 4 * sizeof( uint32 ) );
+	H3D_UNUSED_VAR( bufObj );
+
+	commitStates();
+	recordCommand( RDICommandNull::Draw, _curShaderId );
+}
+
+} // namespace RDI_Null
+} // namespace Horde3D
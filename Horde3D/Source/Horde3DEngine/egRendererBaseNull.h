@@ -0,0 +1,305 @@
+// *************************************************************************************************
+//
+// Horde3D
+//   Next-Generation Graphics Engine
+// --------------------------------------
+// Copyright (C) 2006-2021 Nicolas Schulz and Horde3D team
+//
+// This software is distributed under the terms of the Eclipse Public License v1.0.
+// A copy of the license may be obtained at: http://www.eclipse.org/legal/epl-v10.html
+//
+// *************************************************************************************************
+
+#ifndef _egRendererBaseNull_H_
+#define _egRendererBaseNull_H_
+
+#include "egRendererBase.h"
+#include <string>
+#include <vector>
+
+
+namespace Horde3D {
+namespace RDI_Null {
+
+// The null render device executes the complete CPU side of the engine (scene update, culling,
+// render queue building, uniform setup) without talking to a graphics API. It is used for
+// headless runs like automated tests and benchmarks where no GPU or window is available.
+
+const uint32 MaxNumVertexLayouts = 64;
+
+// =================================================================================================
+// GPUTimer
+// =================================================================================================
+
+class GPUTimerNull : public GPUTimer
+{
+public:
+	GPUTimerNull();
+	~GPUTimerNull();
+
+	void beginQuery( uint32 frameID );
+	void endQuery();
+	bool updateResults();
+
+	void reset();
+
+	// Nothing is measured, tests can set the reported time instead
+	void setTimeMS( float time ) { _time = time; }
+};
+
+
+// =================================================================================================
+// Render Device Interface
+// =================================================================================================
+
+struct RDIBufferNull
+{
+	uint32                 type;
+	uint32                 size;
+	int                    geometryRefCount;
+	std::vector< uint8 >   data;  // Only allocated for storage buffers and when buffer is mapped
+
+	RDIBufferNull() : type( 0 ), size( 0 ), geometryRefCount( 0 ) {}
+};
+
+struct RDIGeometryInfoNull
+{
+	std::vector< uint32 >  vertexBufs;
+	uint32                 indexBuf;
+	uint32                 layout;
+	bool                   indexBuf32Bit;
+
+	RDIGeometryInfoNull() : indexBuf( 0 ), layout( 0 ), indexBuf32Bit( false ) {}
+};
+
+struct RDITextureNull
+{
+	int                   type;
+	TextureFormats::List  format;
+	int                   width, height, depth;
+	int                   memSize;
+
+	RDITextureNull() : type( 0 ), format( TextureFormats::Unknown ), width( 0 ), height( 0 ), depth( 0 ), memSize( 0 ) {}
+};
+
+struct RDIFenceNull
+{
+	bool  signaled;
+
+	RDIFenceNull() : signaled( false ) {}
+};
+
+struct RDIShaderNull
+{
+	std::string  source;  // Concatenated sources used to emulate uniform lookups
+	bool         pending;
+
+	RDIShaderNull() : pending( false ) {}
+};
+
+struct RDIRenderBufferNull
+{
+	static const uint32 MaxColorAttachmentCount = 4;
+
+	uint32  width, height;
+	uint32  samples;
+	uint32  depthTex, colTexs[MaxColorAttachmentCount];
+
+	RDIRenderBufferNull() : width( 0 ), height( 0 ), samples( 0 ), depthTex( 0 )
+	{
+		for( uint32 i = 0; i < MaxColorAttachmentCount; ++i ) colTexs[i] = 0;
+	}
+};
+
+// Commands that are relevant for synchronization, recorded for tests
+struct RDICommandNull
+{
+	enum Type { MemoryBarrier, MapBuffer, Compute, ComputeIndirect, RenderBuffer, Viewport, Draw,
+	            CreateFence, WaitFence, DestroyFence };
+
+	Type    type;
+	uint32  args[3];  // Barriers; buffer, offset, size; group counts; buffer, offset; buffer, frame buffer size;
+	                  // viewport size; bound shader; fence
+
+	RDICommandNull( Type type, uint32 arg0, uint32 arg1, uint32 arg2 ) : type( type )
+		{ args[0] = arg0; args[1] = arg1; args[2] = arg2; }
+};
+
+class RenderDeviceNull;
+
+// Called for each compute dispatch, so that tests can emulate the results of compute shaders
+typedef void (*RDIComputeHandlerNull)( RenderDeviceNull &rdi, uint32 shaderId, uint32 xDim, uint32 yDim,
+                                       uint32 zDim, void *userData );
+
+// =================================================================================================
+
+
+class RenderDeviceNull : public RenderDeviceInterface
+{
+public:
+
+	RenderDeviceNull();
+	~RenderDeviceNull();
+
+	void initStates();
+	bool init();
+
+	bool enableDebugOutput() { return false; }
+	bool disableDebugOutput() { return false; }
+
+// -----------------------------------------------------------------------------
+// Resources
+// -----------------------------------------------------------------------------
+
+	// Vertex layouts
+	uint32 registerVertexLayout( uint32 numAttribs, VertexLayoutAttrib *attribs );
+
+	// Buffers
+	void beginRendering();
+	uint32 beginCreatingGeometry( uint32 vlObj );
+	void finishCreatingGeometry( uint32 geoObj );
+	void setGeomVertexParams( uint32 geoObj, uint32 vbo, uint32 vbSlot, uint32 offset, uint32 stride );
+	void setGeomIndexParams( uint32 geoObj, uint32 indBuf, RDIIndexFormat format );
+	void destroyGeometry( uint32 &geoObj, bool destroyBindedBuffers );
+
+	uint32 createVertexBuffer( uint32 size, const void *data );
+	uint32 createIndexBuffer( uint32 size, const void *data );
+	uint32 createTextureBuffer( TextureFormats::List format, uint32 bufSize, const void *data );
+	uint32 createShaderStorageBuffer( uint32 size, const void *data );
+	void destroyBuffer( uint32 &bufObj );
+	void destroyTextureBuffer( uint32& bufObj );
+	void updateBufferData( uint32 geoObj, uint32 bufObj, uint32 offset, uint32 size, void *data );
+	void *mapBuffer( uint32 geoObj, uint32 bufObj, uint32 offset, uint32 size, RDIBufferMappingTypes mapType );
+	void unmapBuffer( uint32 geoObj, uint32 bufObj );
+	uint32 createPixelBuffer( uint32 size );
+	void *mapPixelBuffer( uint32 bufObj );
+	void unmapPixelBuffer( uint32 bufObj );
+
+	// Textures
+	uint32 createTexture( TextureTypes::List type, int width, int height, int depth, TextureFormats::List format,
+	                      int maxMipLevel, bool genMips, bool compress, bool sRGB );
+	void generateTextureMipmap( uint32 texObj );
+	void uploadTextureData( uint32 texObj, int slice, int mipLevel, const void *pixels );
+	void destroyTexture( uint32 &texObj );
+	void updateTextureData( uint32 texObj, int slice, int mipLevel, const void *pixels );
+	bool getTextureData( uint32 texObj, int slice, int mipLevel, void *buffer );
+	void bindImageToTexture( uint32 texObj, void* eglImage );
+	void updateTextureFromBuffer( uint32 texObj, uint32 bufObj, uint32 offset );
+	void copyTextureSlice( uint32 srcTexObj, int srcSlice, uint32 dstTexObj, int dstSlice, int mipLevel );
+	uint64 getTextureHandle( uint32 texObj, uint16 samplerState );
+
+	// Shaders
+	uint32 createShader( const char *vertexShaderSrc, const char *fragmentShaderSrc, const char *geometryShaderSrc,
+						 const char *tessControlShaderSrc, const char *tessEvaluationShaderSrc, const char *computeShaderSrc );
+	uint32 beginCreatingShader( const char *vertexShaderSrc, const char *fragmentShaderSrc, const char *geometryShaderSrc,
+								const char *tessControlShaderSrc, const char *tessEvaluationShaderSrc, const char *computeShaderSrc );
+	bool isShaderPending( uint32 shaderId );
+	bool finishCreatingShader( uint32 &shaderId );
+	void destroyShader( uint32 &shaderId );
+	void bindShader( uint32 shaderId );
+	int getShaderConstLoc( uint32 shaderId, const char *name );
+	int getShaderSamplerLoc( uint32 shaderId, const char *name );
+	int getShaderBufferLoc( uint32 shaderId, const char *name );
+	void setShaderConst( int loc, RDIShaderConstType type, void *values, uint32 count = 1 );
+	void setShaderSampler( int loc, uint32 texUnit );
+	const char *getDefaultVSCode();
+	const char *getDefaultFSCode();
+	void runComputeShader( uint32 shaderId, uint32 xDim, uint32 yDim, uint32 zDim );
+	void runComputeShaderIndirect( uint32 shaderId, uint32 bufObj, uint32 offset );
+
+	// Renderbuffers
+	uint32 createRenderBuffer( uint32 width, uint32 height, TextureFormats::List format,
+	                           bool depth, uint32 numColBufs, uint32 samples, uint32 maxMipLevel );
+	void destroyRenderBuffer( uint32 &rbObj );
+	uint32 getRenderBufferTex( uint32 rbObj, uint32 bufIndex );
+	void setRenderBuffer( uint32 rbObj );
+	bool getRenderBufferData( uint32 rbObj, int bufIndex, int *width, int *height,
+	                          int *compCount, void *dataBuffer, int bufferSize );
+	void getRenderBufferDimensions( uint32 rbObj, int *width, int *height );
+
+	// Queries
+	uint32 createOcclusionQuery();
+	void destroyQuery( uint32 queryObj );
+	void beginQuery( uint32 queryObj );
+	void endQuery( uint32 queryObj );
+	uint32 getQueryResult( uint32 queryObj );
+
+	// Fences
+	uint32 createFence();
+	bool isFenceSignaled( uint32 fenceObj );
+	bool waitForFence( uint32 fenceObj );
+	void destroyFence( uint32 &fenceObj );
+
+	// Render Device dependent GPU Timer
+	GPUTimer *createGPUTimer()
+	{
+		return new GPUTimerNull();
+	}
+
+// -----------------------------------------------------------------------------
+// Commands
+// -----------------------------------------------------------------------------
+	void setStorageBuffer( uint8 slot, uint32 bufObj );
+
+	bool commitStates( uint32 filter = 0xFFFFFFFF );
+	void resetStates();
+
+	// Draw calls and clears
+	void clear( uint32 flags, float *colorRGBA = 0x0, float depth = 1.0f );
+	void draw( RDIPrimType primType, uint32 firstVert, uint32 numVerts );
+	void drawIndexed( RDIPrimType primType, uint32 firstIndex, uint32 numIndices,
+	                  uint32 firstVert, uint32 numVerts );
+	void drawIndexedBaseVertex( RDIPrimType primType, uint32 firstIndex, uint32 numIndices,
+	                            uint32 firstVert, uint32 numVerts, uint32 baseVertex );
+	void drawIndexedInstanced( RDIPrimType primType, uint32 firstIndex, uint32 numIndices,
+	                           uint32 firstVert, uint32 numVerts, uint32 numInstances );
+	void drawIndexedInstancedBaseVertex( RDIPrimType primType, uint32 firstIndex, uint32 numIndices,
+	                                     uint32 firstVert, uint32 numVerts, uint32 numInstances, uint32 baseVertex );
+	void drawIndirect( RDIPrimType primType, uint32 bufObj, uint32 offset );
+
+	// Recording of barriers, buffer mappings and dispatches; enabling clears the recorded commands
+	void setCommandRecording( bool enabled ) { _recordCommands = enabled; _recordedCommands.clear(); }
+	const std::vector< RDICommandNull > &getRecordedCommands() const { return _recordedCommands; }
+
+	// Emulation of compute shaders, the handler can read and write the bound storage buffers
+	void setComputeHandler( RDIComputeHandlerNull handler, void *userData )
+		{ _computeHandler = handler; _computeHandlerData = userData; }
+	bool hasShaderSymbol( uint32 shaderId, const char *name ) { return findShaderSymbol( shaderId, name ) >= 0; }
+	uint32 getStorageBuffer( uint8 slot ) const { return slot < _storageBufs.size() ? _storageBufs[slot] : 0; }
+	std::vector< uint8 > &getBufferData( uint32 bufObj ) { return _buffers.getRef( bufObj ).data; }
+
+protected:
+
+	inline uint32 createBuffer( uint32 type, uint32 size, const void *data );
+	inline void decreaseBufferRefCount( uint32 bufObj );
+	int findShaderSymbol( uint32 shaderId, const char *name );
+
+	void initRDIFuncs();
+
+	void recordCommand( RDICommandNull::Type type, uint32 arg0, uint32 arg1 = 0, uint32 arg2 = 0 )
+		{ if( _recordCommands ) _recordedCommands.push_back( RDICommandNull( type, arg0, arg1, arg2 ) ); }
+
+protected:
+
+	RDIVertexLayout                    _vertexLayouts[MaxNumVertexLayouts];
+	RDIObjects< RDIBufferNull >        _buffers;
+	RDIObjects< RDITextureNull >       _textures;
+	RDIObjects< RDIShaderNull >        _shaders;
+	RDIObjects< RDIRenderBufferNull >  _rendBufs;
+	RDIObjects< RDIGeometryInfoNull >  _geometries;
+	RDIObjects< RDIFenceNull >         _fences;
+
+	uint32                             _numQueries;
+
+	std::vector< RDICommandNull >      _recordedCommands;
+	bool                               _recordCommands;
+
+	std::vector< uint32 >              _storageBufs;  // Buffer bound to each storage slot
+	RDIComputeHandlerNull              _computeHandler;
+	void                               *_computeHandlerData;
+};
+
+} // namespace RDI_Null
+} // namespace Horde3D
+
+#endif // _egRendererBaseNull_H_
@@ -36,6 +36,7 @@ Resource::Resource( int type, const string &name, int flags )
 	_refCount = 0;
 	_userRefCount = 0;
 	_flags = flags;
+	_contentHash = 0;
 	
 	if( (flags & ResourceFlags::NoQuery) == ResourceFlags::NoQuery ) _noQuery = true;
 	else _noQuery = false;
@@ -80,16 +81,72 @@ bool Resource::load( const char *data, int size )
 	}
 
 	_loaded = true;
+	_contentHash = calcContentHash( data, size );
 	
 	return true;
 }
 
 
+int Resource::reload( const char *data, int size )
+{
+	if( !_loaded ) return load( data, size ) ? 1 : -1;
+	
+	if( data == 0x0 || size <= 0 )
+	{
+		Modules::log().writeWarning( "Resource '%s' of type %i: No data for reloading", _name.c_str(), _type );
+		return -1;
+	}
+
+	// Skip reloading if content did not change
+	uint64 hash = calcContentHash( data, size );
+	if( hash == _contentHash )
+	{
+		Modules::log().writeDebugInfo( "Resource '%s' unchanged, skipping reload", _name.c_str() );
+		return 0;
+	}
+
+	if( !reloadData( data, size ) ) return -1;
+	_contentHash = hash;
+
+	return 1;
+}
+
+
+bool Resource::reloadData( const char *data, int size )
+{
+	// Default: Reload from scratch, the resource object (and thus all references to it) stays valid
+	unload();
+	return load( data, size );
+}
+
+
 void Resource::unload()
 {
 	release();
 	initDefault();
 	_loaded = false;
+	_contentHash = 0;
+}
+
+
+uint64 Resource::calcContentHash( const char *data, int size )
+{
+	// FNV-1a variant processing 8 bytes per step, only used for change detection
+	const uint64 prime = 0x100000001b3ULL;
+	uint64 hash = 0xcbf29ce484222325ULL ^ (uint64)size;
+	
+	int i = 0;
+	for( ; i + 8 <= size; i += 8 )
+	{
+		uint64 word;
+		memcpy( &word, data + i, 8 );
+		hash = (hash ^ word) * prime;
+		hash ^= hash >> 29;
+	}
+	for( ; i < size; ++i )
+		hash = (hash ^ (uint8)data[i]) * prime;
+
+	return hash;
 }
 
 
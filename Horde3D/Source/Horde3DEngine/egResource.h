@@ -71,6 +71,7 @@ public:
 	virtual void initDefault();
 	virtual void release();
 	virtual bool load( const char *data, int size );
+	int reload( const char *data, int size );
 	void unload();
 	
 	int findElem( int elem, int param, const char *value ) const;
@@ -89,14 +90,21 @@ public:
 	const std::string &getName() const { return _name; }
 	ResHandle getHandle() const { return _handle; }
 	bool isLoaded() const { return _loaded; }
+	uint64 getContentHash() const { return _contentHash; }
 	void addRef() { ++_refCount; }
     void subRef() { ASSERT(_refCount > 0 ); --_refCount; }
 
+	static uint64 calcContentHash( const char *data, int size );
+
+protected:
+	virtual bool reloadData( const char *data, int size );
+
 protected:
 	int                  _type;
 	std::string          _name;
 	ResHandle            _handle;
 	int                  _flags;
+	uint64               _contentHash;  // Hash of the data the resource was loaded from
 	
 	uint32               _refCount;  // Number of other objects referencing this resource
 	uint32               _userRefCount;  // Number of handles created by user
@@ -33,7 +33,8 @@ using namespace std;
 SceneNode::SceneNode( const SceneNodeTpl &tpl ) :
 	_name( tpl.name ), _attachment( tpl.attachmentString ), _parent( 0x0 ), _type( tpl.type ),
 	_handle( 0 ), _sgHandle( 0 ), _flags( 0 ), _sortKey( 0 ), _dirty( true ), _transformed( true ),
-	_renderable( false ), _lodSupported( false ), _occlusionCullingSupported( false )
+	_renderable( false ), _lodSupported( false ), _occlusionCullingSupported( false ),
+	_cullVisible( false ), _cullStamp( 0 ), _snapshotStamp( 0 ), _snapshotIndex( 0 )
 {
 	_relTrans = Matrix4f::ScaleMat( tpl.scale.x, tpl.scale.y, tpl.scale.z );
 	_relTrans.rotate( degToRad( tpl.rot.x ), degToRad( tpl.rot.y ), degToRad( tpl.rot.z ) );
@@ -302,7 +303,8 @@ RenderView::RenderView() : node( nullptr ), type( RenderViewType::Unknown ), upd
 
 // =================================================================================================
 
-SpatialGraph::SpatialGraph() : _currentView( -1 ), _totalViews( 0 )
+SpatialGraph::SpatialGraph() : _currentView( -1 ), _totalViews( 0 ),
+	_cullCamera( 0x0 ), _cullStamp( 0 ), _cullRevision( 0 )
 {
 	_lightQueue.reserve( 20 );
 	_renderQueue.reserve( 256 );
@@ -452,6 +454,15 @@ void SpatialGraph::updateQueues( uint32 filterIgnore, bool forceUpdateAllViews /
 
 	Modules::sceneMan().updateNodes();
 
+	// Camera views are added with the frustum before the update; refresh them so that culling and
+	// the recorded visibility match the scene revision after the update
+	for ( size_t i = 0; i < _totalViews; ++i )
+	{
+		RenderView &view = _views[ i ];
+		if ( !view.updated && view.type == RenderViewType::Camera && view.node->getType() == SceneNodeTypes::Camera )
+			view.frustum = ( ( CameraNode * ) view.node )->getFrustum();
+	}
+
 	Vec3f camPos;
 	if ( Modules::renderer().getCurCamera() != 0x0 )
 		camPos = Modules::renderer().getCurCamera()->getAbsPos();
@@ -471,6 +482,15 @@ void SpatialGraph::updateQueues( uint32 filterIgnore, bool forceUpdateAllViews /
 	RenderView *v = nullptr;
 	RenderView *cameraView = &_views[ 0 ];
 
+	// Remember the culling results of the camera view for visibility queries
+	bool recordCulling = !cameraView->updated && cameraView->type == RenderViewType::Camera;
+	if ( recordCulling )
+	{
+		_cullCamera = cameraView->node;
+		_cullRevision = Modules::sceneMan().getRevision();
+		++_cullStamp;
+	}
+
 	// Culling
 	for ( size_t i = 0, s = _nodes.size(); i < s; ++i )
 	{
@@ -482,7 +502,16 @@ void SpatialGraph::updateQueues( uint32 filterIgnore, bool forceUpdateAllViews /
 			v = &_views[ view ];
 
 			// Skip views that are already updated
-			if ( !v->updated && !v->frustum.cullBox( node->_bBox ) )
+			if ( v->updated ) continue;
+
+			bool culled = v->frustum.cullBox( node->_bBox );
+			if ( v == cameraView && recordCulling )
+			{
+				node->_cullStamp = _cullStamp;
+				node->_cullVisible = !culled;
+			}
+			
+			if ( !culled )
 			{
 				if ( v != cameraView ) 
 				{
@@ -519,6 +548,16 @@ void SpatialGraph::updateQueues( uint32 filterIgnore, bool forceUpdateAllViews /
 }
 
 
+int SpatialGraph::getCachedVisibility( const SceneNode &node, const SceneNode &cam ) const
+{
+	if ( _cullStamp == 0 || node._cullStamp != _cullStamp || _cullCamera != &cam ||
+	     _cullRevision != Modules::sceneMan().getRevision() )
+		return -1;
+
+	return node._cullVisible ? 1 : 0;
+}
+
+
 void SpatialGraph::clearViews()
 {
 	for ( size_t i = 0; i < _views.size(); ++i )
@@ -574,19 +613,22 @@ void SpatialGraph::sortViewObjects( int viewID, RenderingOrder::List order )
 	float sortKey;
 	RenderView *view = &_views[ viewID ];
 
+	// Objects are sorted while rendering, so the extracted data is used instead of the nodes
+	const std::vector< SnapshotNode > &snapshotNodes = Modules::renderer().getSnapshot().nodes;
+
 	for ( size_t i = 0; i < view->objects.size(); ++i )
 	{
-		SceneNode *node = view->objects[ i ].node;
+		const SnapshotNode &data = snapshotNodes[ view->objects[ i ].dataIndex ];
 		switch ( order )
 		{
 			case RenderingOrder::StateChanges:
-				sortKey = node->_sortKey;
+				sortKey = data.sortKey;
 				break;
 			case RenderingOrder::FrontToBack:
-				sortKey = nearestDistToAABB( view->frustum.getOrigin(), node->_bBox.min, node->_bBox.max );
+				sortKey = nearestDistToAABB( view->frustum.getOrigin(), data.bBox.min, data.bBox.max );
 				break;
 			case RenderingOrder::BackToFront:
-				sortKey = -nearestDistToAABB( view->frustum.getOrigin(), node->_bBox.min, node->_bBox.max );
+				sortKey = -nearestDistToAABB( view->frustum.getOrigin(), data.bBox.min, data.bBox.max );
 				break;
 			default:
 				sortKey = 0;
@@ -625,7 +667,7 @@ void SpatialGraph::setCurrentView( int viewID )
 // Class SceneManager
 // *************************************************************************************************
 
-SceneManager::SceneManager() : _rayNum( 0 ), _spatialGraph( nullptr )
+SceneManager::SceneManager() : _rayNum( 0 ), _revision( 0 ), _spatialGraph( nullptr )
 {
 	SceneNode *rootNode = GroupNode::factoryFunc( GroupNodeTpl( "RootNode" ) );
 	rootNode->_handle = RootNode;
@@ -696,6 +738,8 @@ NodeRegEntry *SceneManager::findType( const string &typeString )
 
 void SceneManager::updateNodes()
 {
+	// Every change of a node marks the root as dirty
+	if( getRootNode()._dirty ) ++_revision;
 	getRootNode().updateTree();
 }
 
@@ -996,7 +1040,8 @@ bool SceneManager::getCastRayResult( int index, CastRayResult &crr )
 
 int SceneManager::checkNodeVisibility( SceneNode &node, CameraNode &cam, bool checkOcclusion, bool calcLod )
 {
-	if( node._dirty ) updateNodes();
+	// Cached culling results are only valid for the current transformations of node and camera
+	if( node._dirty || cam._dirty ) updateNodes();
 
 	RenderDeviceInterface *rdi = Modules::renderer().getRenderDevice();
 
@@ -1008,8 +1053,9 @@ int SceneManager::checkNodeVisibility( SceneNode &node, CameraNode &cam, bool ch
 			return -1;
 	}
 	
-	// Frustum culling
-	if( cam.getFrustum().cullBox( node.getBBox() ) )
+	// Frustum culling, the result of the last culling pass is used if the scene did not change since
+	int cached = _spatialGraph->getCachedVisibility( node, cam );
+	if( cached == 0 || (cached < 0 && cam.getFrustum().cullBox( node.getBBox() )) )
 		return -1;
 	else if( calcLod )
 		return node.calcLodLevel( cam.getAbsPos() );
@@ -1018,6 +1064,103 @@ int SceneManager::checkNodeVisibility( SceneNode &node, CameraNode &cam, bool ch
 }
 
 
+int SceneManager::checkNodesVisibility( SceneNode *const *nodes, uint32 count, CameraNode &cam,
+                                        bool checkOcclusion, bool calcLod, int *results )
+{
+	updateNodes();
+
+	const Frustum &frustum = cam.getFrustum();
+	Vec3f camPos = cam.getAbsPos();
+
+	// Frustum culling and LOD selection, nodes that were not included in the last culling pass
+	// are gathered and tested in blocks
+	Modules::workers().run( count, count >= VisibilityParallelMinNodes, [&]( uint32 first, uint32 last )
+	{
+		const uint32 blockSize = 64;
+		BoundingBox boxes[blockSize];
+		bool culled[blockSize];
+		uint32 indices[blockSize];
+		uint32 numBoxes = 0;
+
+		for( uint32 i = first; i < last || numBoxes > 0; ++i )
+		{
+			if( i < last )
+			{
+				int cached = nodes[i] != 0x0 ? _spatialGraph->getCachedVisibility( *nodes[i], cam ) : 0;
+				if( cached >= 0 )
+				{
+					results[i] = cached > 0 ? 0 : -1;
+					continue;
+				}
+
+				boxes[numBoxes] = nodes[i]->_bBox;
+				indices[numBoxes++] = i;
+				if( numBoxes < blockSize ) continue;
+			}
+
+			// Block is full or all nodes of the range are gathered
+			frustum.cullBoxes( boxes, numBoxes, culled );
+			for( uint32 j = 0; j < numBoxes; ++j ) results[indices[j]] = culled[j] ? -1 : 0;
+			numBoxes = 0;
+		}
+
+		if( calcLod )
+		{
+			for( uint32 i = first; i < last; ++i )
+				if( results[i] >= 0 ) results[i] = nodes[i]->calcLodLevel( camPos );
+		}
+	} );
+
+	// Occlusion query results are read on the calling thread since they access the render device
+	RenderDeviceInterface *rdi = Modules::renderer().getRenderDevice();
+	int numVisible = 0;
+	for( uint32 i = 0; i < count; ++i )
+	{
+		if( results[i] < 0 ) continue;
+		
+		if( checkOcclusion && cam._occSet >= 0 && nodes[i]->checkOcclusionSupported() )
+		{
+			uint32 query = nodes[i]->getOcclusionResult( cam._occSet );
+			if( query != Math::MaxUInt32 && rdi->getQueryResult( query ) < 1 )
+			{
+				results[i] = -1;
+				continue;
+			}
+		}
+		++numVisible;
+	}
+
+	return numVisible;
+}
+
+
+int SceneManager::checkBoxesVisibility( const BoundingBox *boxes, uint32 count, CameraNode &cam, int *results )
+{
+	if( cam._dirty ) updateNodes();
+
+	const Frustum &frustum = cam.getFrustum();
+	
+	Modules::workers().run( count, count >= VisibilityParallelMinNodes, [&]( uint32 first, uint32 last )
+	{
+		const uint32 blockSize = 64;
+		bool culled[blockSize];
+
+		for( uint32 i = first; i < last; i += blockSize )
+		{
+			uint32 num = std::min( blockSize, last - i );
+			frustum.cullBoxes( boxes + i, num, culled );
+			for( uint32 j = 0; j < num; ++j ) results[i + j] = culled[j] ? -1 : 0;
+		}
+	} );
+
+	int numVisible = 0;
+	for( uint32 i = 0; i < count; ++i )
+		if( results[i] >= 0 ) ++numVisible;
+
+	return numVisible;
+}
+
+
 int SceneManager::addRenderView( RenderViewType type, SceneNode *node, const Frustum &f, int link /*= -1*/, uint32 additionalFilter /* = 0 */ )
 {
 	return _spatialGraph->addView( type, node, f, link, additionalFilter );
@@ -28,6 +28,7 @@ class SceneGraphResource;
 
 
 const int RootNode = 1;
+const uint32 VisibilityParallelMinNodes = 4096;  // Node count from which visibility queries are split across threads
 
 
 // =================================================================================================
@@ -156,6 +157,7 @@ protected:
 
 	std::vector< uint32 >		_occQueries;
 	std::vector< uint32 >		_occQueriesLastVisited;
+	std::vector< uint32 >		_occPyramidStamps;  // Result stamp of the depth pyramid that found the node occluded
 
 	std::string                 _name;
 	std::string                 _attachment;  // User defined data
@@ -172,6 +174,9 @@ protected:
 	bool                        _renderable;
 	bool						_lodSupported;
 	bool						_occlusionCullingSupported;
+	bool                        _cullVisible;  // Frustum culling result of the camera view with _cullStamp
+	uint32                      _cullStamp;
+	uint32                      _snapshotStamp, _snapshotIndex;  // Render snapshot entry of the node
 
 	friend class SceneManager;
 	friend class SpatialGraph;
@@ -224,10 +229,12 @@ struct RenderQueueItem
 	SceneNode  *node;
 	int        type;  // Type is stored explicitly for better cache efficiency when iterating over list
 	float      sortKey;
+	uint32     dataIndex;  // Extracted render data in the snapshot of the renderer
+	uint8      cascadeFirst, cascadeCount;  // Shadow cascades drawn as instances, count is 0 if not instanced
 
 	RenderQueueItem() {}
 	RenderQueueItem( int type, float sortKey, SceneNode *node )
-		: node( node ), type( type ), sortKey( sortKey )
+		: node( node ), type( type ), sortKey( sortKey ), dataIndex( 0 ), cascadeFirst( 0 ), cascadeCount( 0 )
 	{
 	}
 };
@@ -286,6 +293,10 @@ public:
 
 	std::vector< SceneNode * > &getLightQueue() { return _lightQueue; }
 	RenderQueue &getRenderQueue();
+
+	// Returns 1 if the node is inside the frustum of cam, 0 if it is culled and -1 if the
+	// last culling pass of the camera view is not valid anymore or did not include the node
+	int getCachedVisibility( const SceneNode &node, const SceneNode &cam ) const;
 protected:
 	std::vector< SceneNode * >     _nodes;		// Renderable nodes and lights
 	std::vector< uint32 >          _freeList;
@@ -297,6 +308,10 @@ protected:
 
 	int							   _currentView;
 	int							   _totalViews;
+
+	SceneNode                      *_cullCamera;  // Camera of the last culled camera view
+	uint32                         _cullStamp;
+	uint32                         _cullRevision;  // Scene revision at the time of culling
 };
 
 
@@ -351,6 +366,10 @@ public:
 	bool getCastRayResult( int index, CastRayResult &crr );
 
 	int checkNodeVisibility( SceneNode &node, CameraNode &cam, bool checkOcclusion, bool calcLod );
+	int checkNodesVisibility( SceneNode *const *nodes, uint32 count, CameraNode &cam,
+	                          bool checkOcclusion, bool calcLod, int *results );
+	int checkBoxesVisibility( const BoundingBox *boxes, uint32 count, CameraNode &cam, int *results );
+	uint32 getRevision() const { return _revision; }
 
 	SceneNode &getRootNode() const { return *_nodes[0]; }
 	SceneNode &getDefCamNode() const { return *_nodes[1]; }
@@ -397,6 +416,7 @@ protected:
 	Vec3f                          _rayOrigin;  // Don't put these values on the stack during recursive search
 	Vec3f                          _rayDirection;  // Ditto
 	int                            _rayNum;  // Ditto
+	uint32                         _revision;  // Incremented whenever an update changes the scene
 
 	friend class Renderer;
 };
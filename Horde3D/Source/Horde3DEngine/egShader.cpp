@@ -174,8 +174,9 @@ bool CodeResource::load( const char *data, int size )
 	_code = code;
 	delete[] code;
 
-	// Compile shaders that require this code block
-	updateShaders();
+	// Compile shaders that require this code block. Private code sections of shaders are not managed
+	// by the resource manager and cannot be included, the owning shader compiles them itself.
+	if( _handle != 0 ) updateShaders();
 
 	return true;
 }
@@ -230,7 +231,7 @@ std::string CodeResource::assembleCode() const
 
 void CodeResource::updateShaders()
 {
-	auto resources = Modules::resMan().getResources();
+	std::vector< Resource * > &resources = Modules::resMan().getResources();
 	for( uint32 i = 0; i < resources.size(); ++i )
 	{
 		Resource *res = resources[ i ];
@@ -422,6 +423,7 @@ void ShaderResource::initializationFunc()
 	switch ( Modules::renderer().getRenderDeviceType() )
 	{
 		case RenderBackendType::OpenGL4:
+		case RenderBackendType::Null:
 		{
 			_vertPreamble = "#version 330\n";
 			_fragPreamble = "#version 330\n";
@@ -579,7 +581,8 @@ bool ShaderResource::parseFXSection( char *data )
 			_buffers.push_back( buffer );
 		}
 		else if( tok.checkToken( "sampler2D", true ) || tok.checkToken( "samplerCube", true ) ||
-				 tok.checkToken( "sampler3D", true ) /*|| tok.checkToken( "samplerBuffer", true )*/ )
+				 tok.checkToken( "sampler3D", true ) || tok.checkToken( "sampler2DArray", true )
+				 /*|| tok.checkToken( "samplerBuffer", true )*/ )
 		{
 			ShaderSampler sampler;
 			sampler.sampState = SS_FILTER_TRILINEAR | SS_ANISO8 | SS_ADDR_WRAP;
@@ -600,6 +603,11 @@ bool ShaderResource::parseFXSection( char *data )
 				sampler.type = TextureTypes::Tex3D;
 				sampler.defTex = (TextureResource *)Modules::resMan().findResource( ResourceTypes::Texture, "$Tex3D" );
 			}
+			else if( tok.checkToken( "sampler2DArray" ) )
+			{
+				sampler.type = TextureTypes::Tex2DArray;
+				sampler.defTex = (TextureResource *)Modules::resMan().findResource( ResourceTypes::Texture, "$Tex2DArray" );
+			}
 // 			else if ( tok.checkToken( "samplerBuffer" ) )
 // 			{
 // 				sampler.type = TextureTypes::Tex2D;
@@ -1016,7 +1024,11 @@ bool ShaderResource::parseFXSectionContext( Tokenizer &tok, const char * identif
 	}
 
 	// Skip contexts that are intended for other render interfaces
-	if ( Modules::renderer().getRenderDeviceType() == targetRenderBackend )
+	// (the null backend does not compile code, it uses the OpenGL4 contexts for their parameters)
+	int deviceType = Modules::renderer().getRenderDeviceType();
+	if ( deviceType == RenderBackendType::Null ) deviceType = RenderBackendType::OpenGL4;
+
+	if ( deviceType == targetRenderBackend )
 	{
 		_contexts.push_back( context );
  	}
@@ -1027,7 +1039,16 @@ bool ShaderResource::parseFXSectionContext( Tokenizer &tok, const char * identif
 bool ShaderResource::load( const char *data, int size )
 {
 	if( !Resource::load( data, size ) ) return false;
+
+	if( !parseShader( data, size ) ) return false;
+	compileContexts();
 	
+	return true;
+}
+
+
+bool ShaderResource::parseShader( const char *data, int size )
+{
 	// Parse sections
 	const char *pData = data;
 	const char *eof = data + size;
@@ -1108,9 +1129,106 @@ bool ShaderResource::load( const char *data, int size )
 // 		if ( !_codeSections[ counter ].isLoaded() ) _codeSections.erase( _codeSections.begin() + counter );
 // 		counter--;
 // 	}
+	
+	return true;
+}
+
+
+bool ShaderResource::reloadData( const char *data, int size )
+{
+	// Keep previous version so that combinations of unchanged contexts can be reused
+	std::vector< ShaderContext > prevContexts;
+	std::vector< ShaderSampler > prevSamplers;
+	std::vector< ShaderUniform > prevUniforms;
+	std::vector< ShaderBuffer > prevBuffers;
+	std::vector< CodeResource > prevCodeSections;
+	prevContexts.swap( _contexts );
+	prevSamplers.swap( _samplers );
+	prevUniforms.swap( _uniforms );
+	prevBuffers.swap( _buffers );
+	prevCodeSections.swap( _codeSections );
+
+	// Combinations are moved or destroyed, so the renderer must not use the current one any longer
+	Modules::renderer().setShaderComb( 0x0 );
+
+	if( !parseShader( data, size ) )
+	{
+		// Keep running with the previous version
+		_contexts.swap( prevContexts );
+		_samplers.swap( prevSamplers );
+		_uniforms.swap( prevUniforms );
+		_buffers.swap( prevBuffers );
+		_codeSections.swap( prevCodeSections );
+		Modules::log().writeWarning( "Shader resource '%s': Reload failed, keeping previous version", _name.c_str() );
+		return false;
+	}
 
+	// Uniform and sampler locations of the combinations are stored by index, so they can only be
+	// reused if the declarations did not change
+	bool declsChanged = prevSamplers.size() != _samplers.size() || prevUniforms.size() != _uniforms.size() ||
+	                    prevBuffers.size() != _buffers.size();
+	for( size_t i = 0; !declsChanged && i < _samplers.size(); ++i )
+		declsChanged = prevSamplers[i].id != _samplers[i].id || prevSamplers[i].texUnit != _samplers[i].texUnit;
+	for( size_t i = 0; !declsChanged && i < _uniforms.size(); ++i )
+		declsChanged = prevUniforms[i].id != _uniforms[i].id;
+	for( size_t i = 0; !declsChanged && i < _buffers.size(); ++i )
+		declsChanged = prevBuffers[i].id != _buffers[i].id;
+
+	uint32 numReused = 0, numChanged = 0;
+	for( size_t i = 0; i < _contexts.size(); ++i )
+	{
+		ShaderContext &context = _contexts[i];
+
+		ShaderContext *prevContext = 0x0;
+		for( size_t j = 0; j < prevContexts.size(); ++j )
+		{
+			if( prevContexts[j].id == context.id ) prevContext = &prevContexts[j];
+		}
+		if( declsChanged || prevContext == 0x0 || !prevContext->compiled )
+		{
+			++numChanged;
+			continue;
+		}
+
+		// Compare final code of all stages
+		const int prevCodeIdx[6] = { prevContext->vertCodeIdx, prevContext->fragCodeIdx, prevContext->geomCodeIdx,
+		                             prevContext->tessCtlCodeIdx, prevContext->tessEvalCodeIdx, prevContext->computeCodeIdx };
+		const int codeIdx[6] = { context.vertCodeIdx, context.fragCodeIdx, context.geomCodeIdx,
+		                         context.tessCtlCodeIdx, context.tessEvalCodeIdx, context.computeCodeIdx };
+		bool codeChanged = false;
+		for( int j = 0; j < 6 && !codeChanged; ++j )
+		{
+			if( (prevCodeIdx[j] < 0) != (codeIdx[j] < 0) ) codeChanged = true;
+			else if( codeIdx[j] >= 0 )
+				codeChanged = prevCodeSections[prevCodeIdx[j]].assembleCode() != _codeSections[codeIdx[j]].assembleCode();
+		}
+		if( codeChanged )
+		{
+			++numChanged;
+			continue;
+		}
+
+		// Take over compiled combinations, render states are taken from the new version
+		context.shaderCombs.swap( prevContext->shaderCombs );
+		context.flagMask = prevContext->flagMask;
+		context.compiled = true;
+		++numReused;
+	}
+
+	// Destroy combinations that were not taken over
+	RenderDeviceInterface *rdi = Modules::renderer().getRenderDevice();
+	for( size_t i = 0; i < prevContexts.size(); ++i )
+	{
+		for( size_t j = 0; j < prevContexts[i].shaderCombs.size(); ++j )
+			rdi->destroyShader( prevContexts[i].shaderCombs[j].shaderObj );
+	}
+
+	Modules::log().writeInfo( "Shader resource '%s': Reloaded, %i contexts unchanged, %i contexts recompiled",
+	                          _name.c_str(), numReused, numChanged );
+
+	// Compiles changed contexts only
 	compileContexts();
-	
+
 	return true;
 }
 
@@ -1247,6 +1365,34 @@ bool ShaderResource::compileCombination( ShaderContext &context, ShaderCombinati
 		rdi->destroyShader( sc.shaderObj );
 		sc.shaderObj = 0;
 	}
+
+	// Combination might be recompiled, so reset everything that refers to the previous shader object
+	sc.samplersLocs.clear();
+	sc.bufferLocs.clear();
+	sc.uniLocs.clear();
+	sc.lastUpdateStamp = 0;
+	sc.pending = false;
+
+	if( Modules::config().asyncShaderCompilation )
+	{
+		// Results are checked in finishCombination when the driver is done
+		sc.pending = Modules::renderer().beginShaderComb( sc, 
+														  vsAvailable ? _tmpCodeVS.c_str() : 0,
+														  fsAvailable ? _tmpCodeFS.c_str() : 0,  
+														  gsAvailable ? _tmpCodeGS.c_str() : 0,
+														  tscAvailable ? _tmpCodeTSCtl.c_str() : 0,
+														  tseAvailable ? _tmpCodeTSEval.c_str() : 0,
+														  csAvailable ? _tmpCodeCS.c_str() : 0
+														  );
+		sc.submitFrameID = Modules::renderer().getFrameID();
+		if( !sc.pending )
+		{
+			Modules::log().writeError( "Shader resource '%s': Failed to compile shader context '%s' (comb %i)",
+				_name.c_str(), context.id.c_str(), sc.combMask );
+		}
+
+		return sc.pending;
+	}
 	
 	// Compile shader
 	bool compiled = Modules::renderer().createShaderComb( sc, 
@@ -1257,6 +1403,7 @@ bool ShaderResource::compileCombination( ShaderContext &context, ShaderCombinati
 														  tseAvailable ? _tmpCodeTSEval.c_str() : 0,
 														  csAvailable ? _tmpCodeCS.c_str() : 0
 														  );
+
 	if( !compiled )
 	{
 		Modules::log().writeError( "Shader resource '%s': Failed to compile shader context '%s' (comb %i)",
@@ -1299,40 +1446,53 @@ bool ShaderResource::compileCombination( ShaderContext &context, ShaderCombinati
 	}
 	else
 	{
-		rdi->bindShader( sc.shaderObj );
+		initCombination( sc );
+	}
 
-		// Find samplers in compiled shader
-		sc.samplersLocs.reserve( _samplers.size() );
-		for( uint32 i = 0; i < _samplers.size(); ++i )
-		{
-			int samplerLoc = rdi->getShaderSamplerLoc( sc.shaderObj, _samplers[i].id.c_str() );
-			sc.samplersLocs.push_back( samplerLoc );
-			
-			// Set texture unit
-			if( samplerLoc >= 0 )
-				rdi->setShaderSampler( samplerLoc, _samplers[i].texUnit );
-		}
-		
-		// Find buffers in compiled shader
-		sc.bufferLocs.reserve( _buffers.size() );
-		for ( uint32 i = 0; i < _buffers.size(); ++i )
-		{
-			int bufferLoc = rdi->getShaderBufferLoc( sc.shaderObj, _buffers[ i ].id.c_str() );
-			sc.bufferLocs.push_back( bufferLoc );
-		}
+	// Renderer must not assume that its current shader is still bound
+	rdi->bindShader( 0 );
+	Modules::renderer().setShaderComb( 0x0 );
 
-		// Find uniforms in compiled shader
-		sc.uniLocs.reserve( Modules::renderer().totalEngineUniforms() + _uniforms.size() );
-		for( uint32 i = 0; i < _uniforms.size(); ++i )
-		{
-			sc.uniLocs.push_back(
-				rdi->getShaderConstLoc( sc.shaderObj, _uniforms[i].id.c_str() ) );
-		}
+	// Output shader log
+	if( rdi->getShaderLog() != "" )
+		Modules::log().writeInfo( "Shader resource '%s': ShaderLog: %s", _name.c_str(), rdi->getShaderLog().c_str() );
+
+	return compiled;
+}
+
+
+bool ShaderResource::isCombinationReady( ShaderCombination &sc )
+{
+	if( !sc.pending ) return true;
+
+	RenderDeviceInterface *rdi = Modules::renderer().getRenderDevice();
+	if( rdi->getCaps().parallelShaderCompile ) return !rdi->isShaderPending( sc.shaderObj );
+
+	// Completion cannot be queried, give the driver one frame to compile in the background
+	return Modules::renderer().getFrameID() != sc.submitFrameID;
+}
+
+
+bool ShaderResource::finishCombination( ShaderContext &context, ShaderCombination &sc )
+{
+	RenderDeviceInterface *rdi = Modules::renderer().getRenderDevice();
+
+	sc.pending = false;
+	bool compiled = Modules::renderer().finishShaderComb( sc );
+	if( !compiled )
+	{
+		Modules::log().writeError( "Shader resource '%s': Failed to compile shader context '%s' (comb %i)",
+			_name.c_str(), context.id.c_str(), sc.combMask );
+	}
+	else
+	{
+		initCombination( sc );
 	}
 
+	// Renderer must not assume that its current shader is still bound
 	rdi->bindShader( 0 );
+	Modules::renderer().setShaderComb( 0x0 );
 
-	// Output shader log
 	if( rdi->getShaderLog() != "" )
 		Modules::log().writeInfo( "Shader resource '%s': ShaderLog: %s", _name.c_str(), rdi->getShaderLog().c_str() );
 
@@ -1340,6 +1500,41 @@ bool ShaderResource::compileCombination( ShaderContext &context, ShaderCombinati
 }
 
 
+void ShaderResource::initCombination( ShaderCombination &sc )
+{
+	RenderDeviceInterface *rdi = Modules::renderer().getRenderDevice();
+	rdi->bindShader( sc.shaderObj );
+
+	// Find samplers in compiled shader
+	sc.samplersLocs.reserve( _samplers.size() );
+	for( uint32 i = 0; i < _samplers.size(); ++i )
+	{
+		int samplerLoc = rdi->getShaderSamplerLoc( sc.shaderObj, _samplers[i].id.c_str() );
+		sc.samplersLocs.push_back( samplerLoc );
+		
+		// Set texture unit
+		if( samplerLoc >= 0 )
+			rdi->setShaderSampler( samplerLoc, _samplers[i].texUnit );
+	}
+	
+	// Find buffers in compiled shader
+	sc.bufferLocs.reserve( _buffers.size() );
+	for ( uint32 i = 0; i < _buffers.size(); ++i )
+	{
+		int bufferLoc = rdi->getShaderBufferLoc( sc.shaderObj, _buffers[ i ].id.c_str() );
+		sc.bufferLocs.push_back( bufferLoc );
+	}
+
+	// Find uniforms in compiled shader
+	sc.uniLocs.reserve( Modules::renderer().totalEngineUniforms() + _uniforms.size() );
+	for( uint32 i = 0; i < _uniforms.size(); ++i )
+	{
+		sc.uniLocs.push_back(
+			rdi->getShaderConstLoc( sc.shaderObj, _uniforms[i].id.c_str() ) );
+	}
+}
+
+
 void ShaderResource::compileContexts()
 {
 	for( uint32 i = 0; i < _contexts.size(); ++i )
@@ -1405,17 +1600,68 @@ ShaderCombination *ShaderResource::getCombination( ShaderContext &context, uint3
 	
 	// Try to find combination
 	std::vector< ShaderCombination > &combs = context.shaderCombs;
+	ShaderCombination *sc = 0x0;
 	for( size_t i = 0, s = combs.size(); i < s; ++i )
 	{
-		if( combs[i].combMask == combMask ) return &combs[i];
+		if( combs[i].combMask == combMask )
+		{
+			sc = &combs[i];
+			break;
+		}
 	}
 
 	// Add combination
-	combs.push_back( ShaderCombination() );
-	combs.back().combMask = combMask;
-	compileCombination( context, combs.back() );
+	bool submitted = false;
+	if( sc == 0x0 )
+	{
+		combs.push_back( ShaderCombination() );
+		combs.back().combMask = combMask;
+		compileCombination( context, combs.back() );
+		sc = &combs.back();
+		submitted = true;
+	}
 
-	return &combs.back();
+	if( sc->pending )
+	{
+		// A combination that was submitted just now cannot have finished compiling yet
+		if( !submitted && isCombinationReady( *sc ) )
+		{
+			finishCombination( context, *sc );
+		}
+		else
+		{
+			// Draw with the base combination of the context until the requested one is ready
+			if( combMask != 0 && Modules::config().asyncShaderFallback )
+			{
+				ShaderCombination *fallback = getCombination( context, 0 );
+				if( fallback != 0x0 && !fallback->pending ) return fallback;
+			}
+
+			return 0x0;
+		}
+	}
+
+	return sc;
+}
+
+
+int ShaderResource::updatePendingCombinations()
+{
+	int numPending = 0;
+
+	for( size_t i = 0; i < _contexts.size(); ++i )
+	{
+		for( size_t j = 0; j < _contexts[i].shaderCombs.size(); ++j )
+		{
+			ShaderCombination &sc = _contexts[i].shaderCombs[j];
+			if( !sc.pending ) continue;
+
+			if( isCombinationReady( sc ) ) finishCombination( _contexts[i], sc );
+			else ++numPending;
+		}
+	}
+
+	return numPending;
 }
 
 
@@ -1460,6 +1706,23 @@ int ShaderResource::getElemParamI( int elem, int elemIdx, int param ) const
 {
 	switch( elem )
 	{
+	case ShaderResData::ContextElem:
+		if( (unsigned)elemIdx < _contexts.size() )
+		{
+			switch( param )
+			{
+			case ShaderResData::ContPendingCombsI:
+				{
+					int numPending = 0;
+					for( size_t i = 0; i < _contexts[elemIdx].shaderCombs.size(); ++i )
+					{
+						if( _contexts[elemIdx].shaderCombs[i].pending ) ++numPending;
+					}
+					return numPending;
+				}
+			}
+		}
+		break;
 	case ShaderResData::UniformElem:
 		if( (unsigned)elemIdx < _uniforms.size() )
 		{
@@ -82,7 +82,8 @@ struct ShaderResData
 		SampDefTexResI,
 		UnifNameStr,
 		UnifSizeI,
-		UnifDefValueF4
+		UnifDefValueF4,
+		ContPendingCombsI
 	};
 };
 
@@ -135,6 +136,8 @@ struct ShaderCombination
 	
 	uint32              shaderObj;
 	uint32              lastUpdateStamp;
+	uint32              submitFrameID;  // Frame in which asynchronous compilation was started
+	bool                pending;        // Asynchronous compilation not finished yet
 
 	// Engine uniforms
 // 	int                 uni_frameBufSize;
@@ -151,7 +154,7 @@ struct ShaderCombination
 
 
 	ShaderCombination() :
-		combMask( 0 ), shaderObj( 0 ), lastUpdateStamp( 0 ) 
+		combMask( 0 ), shaderObj( 0 ), lastUpdateStamp( 0 ), submitFrameID( 0 ), pending( false )
 // 		uni_frameBufSize( -1 ), uni_viewMat( -1 ), uni_viewMatInv( -1 ), uni_projMat( -1 ), uni_viewProjMat( -1 ), 
 // 		uni_viewProjMatInv( -1 ), uni_viewerPos( -1 ), uni_worldMat( -1 ), uni_worldNormalMat( -1 ), uni_nodeId( -1 ), uni_customInstData( -1 ),
 // 		uni_skinMatRows( -1 ), uni_lightPos( -1 ), uni_lightDir( -1 ), uni_lightColor( -1 ), uni_shadowSplitDists( -1 ), uni_shadowMats( -1 ), 
@@ -258,6 +261,7 @@ public:
 	void preLoadCombination( uint32 combMask );
 	void compileContexts();
 	ShaderCombination *getCombination( ShaderContext &context, uint32 combMask );
+	int updatePendingCombinations();
 
 	int getElemCount( int elem ) const;
 	int getElemParamI( int elem, int elemIdx, int param ) const;
@@ -278,11 +282,16 @@ public:
 
 private:
 	bool raiseError( const std::string &msg, int line = -1 );
+	bool parseShader( const char *data, int size );
 	bool parseFXSection( char *data );
+	bool reloadData( const char *data, int size );
 
 	bool parseFXSectionContext( Tokenizer &tok, const char * identifier, int targetRenderBackend );
 
 	bool compileCombination( ShaderContext &context, ShaderCombination &sc );
+	bool isCombinationReady( ShaderCombination &sc );
+	bool finishCombination( ShaderContext &context, ShaderCombination &sc );
+	void initCombination( ShaderCombination &sc );
 	
 private:
 	static std::string            _vertPreamble, _fragPreamble, _geomPreamble, _tessCtlPreamble, _tessEvalPreamble, _computePreamble;
@@ -16,7 +16,9 @@
 #include "egCom.h"
 #include "egRenderer.h"
 #include "utImage.h"
+#include "utXML.h"
 #include <cstring>
+#include <algorithm>
 
 #include "utDebug.h"
 #include <array>
@@ -146,6 +148,7 @@ int TextureResource::mappedWriteImage = -1;
 uint32 TextureResource::defTex2DObject = 0;
 uint32 TextureResource::defTex3DObject = 0;
 uint32 TextureResource::defTexCubeObject = 0;
+uint32 TextureResource::defTex2DArrayObject = 0;
 bool TextureResource::bgraSwizzleRequired = true;
 
 void TextureResource::initializationFunc()
@@ -184,6 +187,13 @@ void TextureResource::initializationFunc()
 	                                      TextureFormats::BGRA8, 2, true, false, false );
 	rdi->uploadTextureData( defTex3DObject, 0, 0, texData2 );
 	delete[] texData2;
+
+	if( rdi->getCaps().texArrays )
+	{
+		defTex2DArrayObject = rdi->createTexture( TextureTypes::Tex2DArray, 4, 4, 1,
+		                                          TextureFormats::BGRA8, 2, true, false, false );
+		rdi->uploadTextureData( defTex2DArrayObject, 0, 0, texData );
+	}
 }
 
 
@@ -194,11 +204,12 @@ void TextureResource::releaseFunc()
 	rdi->destroyTexture( defTex2DObject );
 	rdi->destroyTexture( defTex3DObject );
 	rdi->destroyTexture( defTexCubeObject );
+	rdi->destroyTexture( defTex2DArrayObject );
 }
 
 
 TextureResource::TextureResource( const string &name, int flags ) :
-	Resource( ResourceTypes::Texture, name, flags )
+	Resource( ResourceTypes::Texture, name, flags ), _prevTexObject( 0 )
 {
 	_texType = TextureTypes::Tex2D;
 	initDefault();
@@ -208,7 +219,8 @@ TextureResource::TextureResource( const string &name, int flags ) :
 TextureResource::TextureResource( const string &name, uint32 width, uint32 height, uint32 depth,
                                   TextureFormats::List fmt, int flags ) :
 	Resource( ResourceTypes::Texture, name, flags ),
-	_width( width ), _height( height ), _depth( depth ), _rbObj( 0 )
+	_width( width ), _height( height ), _depth( depth ), _rbObj( 0 ), _genMips( false ), _compress( false ),
+	_prevTexObject( 0 )
 {	
 	_loaded = true;
 	_texFormat = fmt;
@@ -264,12 +276,15 @@ void TextureResource::initDefault()
 	_texFormat = TextureFormats::BGRA8;
 	_width = 0; _height = 0; _depth = 0;
 	_sRGB = false;
+	_genMips = false; _compress = false;
 	_maxMipLevel = 0;
 	
 	if( _texType == TextureTypes::TexCube )
 		_texObject = defTexCubeObject;
 	else if( _texType == TextureTypes::Tex3D )
 		_texObject = defTex3DObject;
+	else if( _texType == TextureTypes::Tex2DArray )
+		_texObject = defTex2DArrayObject;
 	else
 		_texObject = defTex2DObject;
 }
@@ -284,11 +299,20 @@ void TextureResource::release()
 		// In this case _texObject is just points to the render buffer
 		rdi->destroyRenderBuffer( _rbObj );
 	}
-	else if( _texObject != 0 && _texObject != defTex2DObject && _texObject != defTexCubeObject )
+	else if( _texObject != 0 && _texObject != defTex2DObject && _texObject != defTexCubeObject &&
+	         _texObject != defTex3DObject && _texObject != defTex2DArrayObject )
 	{
 		rdi->destroyTexture( _texObject );
 	}
 
+	// Layers keep their list of arrays when they are reloaded, arrays unregister when they are released
+	for( size_t i = 0; i < _layers.size(); ++i )
+	{
+		vector< TextureResource * > &arrays = _layers[ i ]->_arrays;
+		arrays.erase( std::remove( arrays.begin(), arrays.end(), this ), arrays.end() );
+	}
+	_layers.clear();
+
 	_texObject = 0;
 }
 
@@ -455,8 +479,7 @@ bool TextureResource::loadDDS( const char *data, int size )
 	RenderDeviceInterface *rdi = Modules::renderer().getRenderDevice();
 
 	// Create texture
-	_texObject = rdi->createTexture( _texType, _width, _height, _depth, _texFormat,
-	                                 _maxMipLevel, false, false, _sRGB );
+	_texObject = createTexObject( false, false );
 	
 	if ( _texObject == 0 ) return raiseError( "Failed to create DDS texture" );
 
@@ -595,8 +618,7 @@ bool TextureResource::loadKTX( const char *data, int size )
 	RenderDeviceInterface *rdi = Modules::renderer().getRenderDevice();
 
 	// Create texture
-	_texObject = rdi->createTexture( _texType, _width, _height, _depth, _texFormat,
-		_maxMipLevel, false, false, _sRGB );
+	_texObject = createTexObject( false, false );
 
 	if ( _texObject == 0 ) return raiseError( "Failed to create KTX texture" );
 
@@ -694,8 +716,7 @@ bool TextureResource::loadSTBI( const char *data, int size )
 	RenderDeviceInterface *rdi = Modules::renderer().getRenderDevice();
 
 	// Create and upload texture
-	_texObject = rdi->createTexture( _texType, _width, _height, _depth, _texFormat,
-		_maxMipLevel, _maxMipLevel > 1, !(_flags & ResourceFlags::NoTexCompression), _sRGB );
+	_texObject = createTexObject( _maxMipLevel > 1, !(_flags & ResourceFlags::NoTexCompression) );
 	rdi->uploadTextureData( _texObject, 0, 0, pixels );
 
 	stbi_image_free( pixels );
@@ -704,16 +725,204 @@ bool TextureResource::loadSTBI( const char *data, int size )
 }
 
 
+bool TextureResource::checkTextureArray( const char *data, int size ) const
+{
+	// Skip leading whitespace and an optional UTF-8 byte order mark
+	int pos = 0;
+	if( size >= 3 && (unsigned char)data[0] == 0xEF && (unsigned char)data[1] == 0xBB && (unsigned char)data[2] == 0xBF )
+		pos = 3;
+	while( pos < size && (data[pos] == ' ' || data[pos] == '\t' || data[pos] == '\n' || data[pos] == '\r') ) ++pos;
+
+	return size - pos > 13 && strncmp( data + pos, "<TextureArray", 13 ) == 0;
+}
+
+
+bool TextureResource::loadTextureArray( const char *data, int size )
+{
+	RenderDeviceInterface *rdi = Modules::renderer().getRenderDevice();
+	
+	_texType = TextureTypes::Tex2DArray;
+	if( !rdi->getCaps().texArrays )
+		return raiseError( "Texture arrays are not supported by the render device" );
+	
+	XMLDoc doc;
+	doc.parseBuffer( data, size );
+	if( doc.hasError() )
+		return raiseError( "XML parsing error" );
+
+	XMLNode rootNode = doc.getRootNode();
+	if( strcmp( rootNode.getName(), "TextureArray" ) != 0 )
+		return raiseError( "Not a texture array" );
+
+	// Layers are copied on the GPU, so they must not be recompressed or converted independently
+	int flags = (_flags & (ResourceFlags::NoQuery | ResourceFlags::NoTexMipmaps | ResourceFlags::TexSRGB)) |
+	            ResourceFlags::NoTexCompression;
+
+	XMLNode node1 = rootNode.getFirstChild( "Layer" );
+	while( !node1.isEmpty() )
+	{
+		if( node1.getAttribute( "map" ) == 0x0 ) return raiseError( "Missing Layer attribute 'map'" );
+
+		ResHandle texMap = Modules::resMan().addResource(
+			ResourceTypes::Texture, node1.getAttribute( "map" ), flags, false );
+		TextureResource *layer = (TextureResource *)Modules::resMan().resolveResHandle( texMap );
+		if( layer == this ) return raiseError( "Illegal self reference in texture array" );
+		
+		_layers.push_back( layer );
+		if( std::find( layer->_arrays.begin(), layer->_arrays.end(), this ) == layer->_arrays.end() )
+			layer->_arrays.push_back( this );
+		
+		node1 = node1.getNextSibling( "Layer" );
+	}
+
+	if( _layers.empty() )
+		return raiseError( "Texture array has no layers" );
+
+	_depth = (int)_layers.size();
+
+	// Layers that are already loaded are copied right away, the others trigger assembly when loaded.
+	// Errors reset the resource which removes the layers.
+	assembleTextureArray();
+
+	return !_layers.empty();
+}
+
+
+bool TextureResource::assembleTextureArray()
+{
+	for( size_t i = 0; i < _layers.size(); ++i )
+	{
+		if( !_layers[ i ]->_loaded || _layers[ i ]->_width == 0 ) return false;
+	}
+
+	const TextureResource &first = *_layers[ 0 ];
+	for( size_t i = 0; i < _layers.size(); ++i )
+	{
+		const TextureResource &layer = *_layers[ i ];
+		
+		if( layer._texType != TextureTypes::Tex2D )
+			return raiseError( "Texture array layer '" + layer._name + "' is not a 2D texture" );
+		if( layer._width != first._width || layer._height != first._height ||
+		    layer._texFormat != first._texFormat || layer._maxMipLevel != first._maxMipLevel )
+			return raiseError( "Texture array layer '" + layer._name + "' differs in size, format or mipmap count" );
+	}
+
+	RenderDeviceInterface *rdi = Modules::renderer().getRenderDevice();
+
+	// Layers are reassembled when one of them is reloaded, the object is kept if the layout did not change
+	bool ownObject = _texObject != 0 && _texObject != defTex2DArrayObject;
+	if( ownObject && (_width != first._width || _height != first._height || _texFormat != first._texFormat ||
+	    _maxMipLevel != first._maxMipLevel || _depth != (int)_layers.size()) )
+	{
+		rdi->destroyTexture( _texObject );
+		ownObject = false;
+	}
+
+	_width = first._width;
+	_height = first._height;
+	_depth = (int)_layers.size();
+	_texFormat = first._texFormat;
+	_maxMipLevel = first._maxMipLevel;
+	_sRGB = (_flags & ResourceFlags::TexSRGB) != 0;
+
+	if( !ownObject )
+	{
+		_texObject = createTexObject( false, false );
+		if( _texObject == 0 ) return raiseError( "Failed to create texture array" );
+	}
+
+	for( size_t i = 0; i < _layers.size(); ++i )
+	{
+		for( uint32 mipLevel = 0; mipLevel <= _maxMipLevel; ++mipLevel )
+			rdi->copyTextureSlice( _layers[ i ]->_texObject, 0, _texObject, (int)i, (int)mipLevel );
+	}
+
+	return true;
+}
+
+
+void TextureResource::updateTextureArrays()
+{
+	// Assembly errors release the array which removes it from the list, so iterate over a copy
+	vector< TextureResource * > arrays = _arrays;
+	for( size_t i = 0; i < arrays.size(); ++i )
+		arrays[ i ]->assembleTextureArray();
+}
+
+
 bool TextureResource::load( const char *data, int size )
 {
 	if( !Resource::load( data, size ) ) return false;
 
+	if ( checkTextureArray( data, size ) )
+		return loadTextureArray( data, size );
+
+	bool result;
 	if ( checkDDS( data, size ) )
-		return loadDDS( data, size );
+		result = loadDDS( data, size );
 	else if ( checkKTX( data, size ) )
-		return loadKTX( data, size );
+		result = loadKTX( data, size );
 	else
-		return loadSTBI( data, size );
+		result = loadSTBI( data, size );
+
+	// Copy the new data into texture arrays using this texture as layer
+	if( result && _handle != 0 ) updateTextureArrays();
+
+	return result;
+}
+
+
+uint32 TextureResource::createTexObject( bool genMips, bool compress )
+{
+	_genMips = genMips;
+	_compress = compress;
+	
+	// When reloading, reuse the texture object of the previous version if the layout did not change.
+	// Uploads overwrite the existing image data in place, so no new GPU object is allocated.
+	if( _prevTexObject != 0 && _prevTexType == _texType && _prevTexFormat == _texFormat &&
+	    _prevWidth == _width && _prevHeight == _height && _prevDepth == _depth &&
+	    _prevMaxMipLevel == _maxMipLevel && _prevSRGB == _sRGB && _prevGenMips == genMips &&
+	    _prevCompress == compress )
+	{
+		uint32 texObj = _prevTexObject;
+		_prevTexObject = 0;
+		return texObj;
+	}
+
+	RenderDeviceInterface *rdi = Modules::renderer().getRenderDevice();
+	return rdi->createTexture( _texType, _width, _height, _depth, _texFormat,
+	                           _maxMipLevel, genMips, compress, _sRGB );
+}
+
+
+bool TextureResource::reloadData( const char *data, int size )
+{
+	// Render targets and textures without own GPU object are recreated from scratch
+	if( _rbObj != 0 || _texObject == 0 || _texObject == defTex2DObject || _texObject == defTex3DObject ||
+	    _texObject == defTexCubeObject || _texObject == defTex2DArrayObject )
+	{
+		return Resource::reloadData( data, size );
+	}
+	
+	// Keep texture object of current version alive so that it can be updated in place
+	_prevTexObject = _texObject;
+	_prevTexType = _texType; _prevTexFormat = _texFormat;
+	_prevWidth = _width; _prevHeight = _height; _prevDepth = _depth;
+	_prevMaxMipLevel = _maxMipLevel;
+	_prevSRGB = _sRGB; _prevGenMips = _genMips; _prevCompress = _compress;
+	_texObject = 0;
+
+	unload();
+	bool result = load( data, size );
+
+	// Layout changed or loading failed, previous texture object was not reused
+	if( _prevTexObject != 0 )
+	{
+		Modules::renderer().getRenderDevice()->destroyTexture( _prevTexObject );
+		_prevTexObject = 0;
+	}
+
+	return result;
 }
 
 
@@ -730,6 +939,7 @@ int TextureResource::getElemCount( int elem ) const
 	case TextureResData::TextureElem:
 		return 1;
 	case TextureResData::ImageElem:
+		if( _texType == TextureTypes::Tex2DArray ) return _depth * (_maxMipLevel + 1);
 		return _texType == TextureTypes::TexCube ? 6 * (_maxMipLevel + 1) : _maxMipLevel + 1;
 	default:
 		return Resource::getElemCount( elem );
@@ -747,6 +957,7 @@ int TextureResource::getElemParamI( int elem, int elemIdx, int param ) const
 		case TextureResData::TexFormatI:
 			return _texFormat;
 		case TextureResData::TexSliceCountI:
+			if( _texType == TextureTypes::Tex2DArray ) return _depth;
 			return _texType == TextureTypes::TexCube ? 6 : 1;
 		}
 		break;
@@ -78,6 +78,7 @@ public:
 	static uint32	defTex2DObject;
 	static uint32	defTex3DObject;
 	static uint32	defTexCubeObject;
+	static uint32	defTex2DArrayObject;
 	static bool		bgraSwizzleRequired;
 
 protected:
@@ -87,7 +88,13 @@ protected:
 	bool loadKTX( const char *data, int size );
 	bool loadDDS( const char *data, int size );
 	bool loadSTBI( const char *data, int size );
+	bool checkTextureArray( const char *data, int size ) const;
+	bool loadTextureArray( const char *data, int size );
+	bool assembleTextureArray();
+	void updateTextureArrays();
     uint32 getMaxAtMipFullLevel() const;
+	uint32 createTexObject( bool genMips, bool compress );
+	bool reloadData( const char *data, int size );
 
 protected:
 	static unsigned char  *mappedData;
@@ -100,6 +107,16 @@ protected:
 	uint32                _rbObj;           // Used when texture is renderable
 	uint32                _maxMipLevel;     // number of mip levels = _maxMipLevel + 1
 	bool                  _sRGB;
+	bool                  _genMips, _compress;
+	std::vector< SmartResPtr< TextureResource > >  _layers;  // Source textures of a texture array
+	std::vector< TextureResource * >               _arrays;  // Texture arrays using this texture as layer
+
+	uint32                _prevTexObject;   // Texture object of previous version while reloading
+	TextureTypes::List    _prevTexType;
+	TextureFormats::List  _prevTexFormat;
+	int                   _prevWidth, _prevHeight, _prevDepth;
+	uint32                _prevMaxMipLevel;
+	bool                  _prevSRGB, _prevGenMips, _prevCompress;
 
 	friend class ResourceManager;
 };
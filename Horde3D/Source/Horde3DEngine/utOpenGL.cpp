@@ -31,6 +31,8 @@ namespace glExt
 	bool ARB_texture_rg = false;
 	bool KHR_texture_compression_astc = false;
 	bool KHR_debug = false;
+	bool KHR_parallel_shader_compile = false;
+	bool ARB_bindless_texture = false;
 
 	int	majorVersion = 1, minorVersion = 0;
 }
@@ -562,6 +564,15 @@ PFNGLDEBUGMESSAGECONTROLKHRPROC glDebugMessageControlKHR = 0x0;
 PFNGLDEBUGMESSAGEINSERTKHRPROC glDebugMessageInsertKHR = 0x0;
 PFNGLDEBUGMESSAGECALLBACKKHRPROC glDebugMessageCallbackKHR = 0x0;
 PFNGLGETDEBUGMESSAGELOGKHRPROC glGetDebugMessageLogKHR = 0x0;
+
+// GL_KHR_parallel_shader_compile
+PFNGLMAXSHADERCOMPILERTHREADSKHRPROC glMaxShaderCompilerThreadsKHR = 0x0;
+
+// GL_ARB_bindless_texture
+PFNGLGETTEXTUREHANDLEARBPROC glGetTextureHandleARB = 0x0;
+PFNGLGETTEXTURESAMPLERHANDLEARBPROC glGetTextureSamplerHandleARB = 0x0;
+PFNGLMAKETEXTUREHANDLERESIDENTARBPROC glMakeTextureHandleResidentARB = 0x0;
+PFNGLMAKETEXTUREHANDLENONRESIDENTARBPROC glMakeTextureHandleNonResidentARB = 0x0;
 }  // namespace h3dGL
 
 
@@ -766,6 +777,28 @@ void initModernExtensions( bool &r )
 		r &= ( glDebugMessageInsertKHR = ( PFNGLDEBUGMESSAGEINSERTKHRPROC ) platGetProcAddress( "glDebugMessageInsert" ) ) != 0x0;
 		r &= ( glGetDebugMessageLogKHR = ( PFNGLGETDEBUGMESSAGELOGKHRPROC ) platGetProcAddress( "glGetDebugMessageLog" ) ) != 0x0;
 	}
+
+	// The ARB variant has the same tokens, only the entry point is named differently
+	if ( isExtensionSupported( "GL_KHR_parallel_shader_compile" ) )
+	{
+		glMaxShaderCompilerThreadsKHR = ( PFNGLMAXSHADERCOMPILERTHREADSKHRPROC ) platGetProcAddress( "glMaxShaderCompilerThreadsKHR" );
+	}
+	else if ( isExtensionSupported( "GL_ARB_parallel_shader_compile" ) )
+	{
+		glMaxShaderCompilerThreadsKHR = ( PFNGLMAXSHADERCOMPILERTHREADSKHRPROC ) platGetProcAddress( "glMaxShaderCompilerThreadsARB" );
+	}
+	glExt::KHR_parallel_shader_compile = glMaxShaderCompilerThreadsKHR != 0x0;
+
+	glExt::ARB_bindless_texture = isExtensionSupported( "GL_ARB_bindless_texture" );
+	if ( glExt::ARB_bindless_texture )
+	{
+		bool b = true;
+		b &= ( glGetTextureHandleARB = ( PFNGLGETTEXTUREHANDLEARBPROC ) platGetProcAddress( "glGetTextureHandleARB" ) ) != 0x0;
+		b &= ( glGetTextureSamplerHandleARB = ( PFNGLGETTEXTURESAMPLERHANDLEARBPROC ) platGetProcAddress( "glGetTextureSamplerHandleARB" ) ) != 0x0;
+		b &= ( glMakeTextureHandleResidentARB = ( PFNGLMAKETEXTUREHANDLERESIDENTARBPROC ) platGetProcAddress( "glMakeTextureHandleResidentARB" ) ) != 0x0;
+		b &= ( glMakeTextureHandleNonResidentARB = ( PFNGLMAKETEXTUREHANDLENONRESIDENTARBPROC ) platGetProcAddress( "glMakeTextureHandleNonResidentARB" ) ) != 0x0;
+		glExt::ARB_bindless_texture = b;
+	}
 }
 
 bool initOpenGLExtensions( bool forceLegacyFuncs )
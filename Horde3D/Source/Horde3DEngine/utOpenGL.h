@@ -67,6 +67,8 @@ namespace glExt
 	extern bool ARB_texture_rg;
 	extern bool KHR_texture_compression_astc;
 	extern bool KHR_debug;
+	extern bool KHR_parallel_shader_compile;
+	extern bool ARB_bindless_texture;
 
 	extern int  majorVersion, minorVersion;
 }
@@ -2975,6 +2977,33 @@ extern PFNGLDEBUGMESSAGEINSERTKHRPROC glDebugMessageInsertKHR;
 extern PFNGLDEBUGMESSAGECALLBACKKHRPROC glDebugMessageCallbackKHR;
 extern PFNGLGETDEBUGMESSAGELOGKHRPROC glGetDebugMessageLogKHR;
 
+#endif
+
+#ifndef GL_KHR_parallel_shader_compile
+#define GL_KHR_parallel_shader_compile 1
+
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#define GL_COMPLETION_STATUS_KHR          0x91B1
+typedef void ( GLAPIENTRYP PFNGLMAXSHADERCOMPILERTHREADSKHRPROC ) ( GLuint count );
+
+extern PFNGLMAXSHADERCOMPILERTHREADSKHRPROC glMaxShaderCompilerThreadsKHR;
+
+#endif
+
+#ifndef GL_ARB_bindless_texture
+#define GL_ARB_bindless_texture 1
+
+#define GL_UNSIGNED_INT64_ARB             0x140F
+typedef GLuint64 ( GLAPIENTRYP PFNGLGETTEXTUREHANDLEARBPROC ) ( GLuint texture );
+typedef GLuint64 ( GLAPIENTRYP PFNGLGETTEXTURESAMPLERHANDLEARBPROC ) ( GLuint texture, GLuint sampler );
+typedef void ( GLAPIENTRYP PFNGLMAKETEXTUREHANDLERESIDENTARBPROC ) ( GLuint64 handle );
+typedef void ( GLAPIENTRYP PFNGLMAKETEXTUREHANDLENONRESIDENTARBPROC ) ( GLuint64 handle );
+
+extern PFNGLGETTEXTUREHANDLEARBPROC glGetTextureHandleARB;
+extern PFNGLGETTEXTURESAMPLERHANDLEARBPROC glGetTextureSamplerHandleARB;
+extern PFNGLMAKETEXTUREHANDLERESIDENTARBPROC glMakeTextureHandleResidentARB;
+extern PFNGLMAKETEXTUREHANDLENONRESIDENTARBPROC glMakeTextureHandleNonResidentARB;
+
 #endif
 }  // namespace h3dGL
 
@@ -54,6 +54,9 @@ namespace glESExt
 
 	bool OES_EGL_image_external = false;
 	bool KHR_debug = false;
+	bool KHR_parallel_shader_compile = false;
+	bool EXT_draw_elements_base_vertex = false;
+	bool EXT_copy_image = false;
 	
 	int	majorVersion = 1, minorVersion = 0;
 }
@@ -83,12 +86,24 @@ namespace h3dGLES
     PFNGLGETPROGRAMRESOURCEIVPROC glGetProgramResourceiv = 0x0;
     PFNGLMEMORYBARRIERPROC glMemoryBarrier = 0x0;
     PFNGLGETPROGRAMRESOURCEINDEXPROC glGetProgramResourceIndex = 0x0;
+    PFNGLGETPROGRAMINTERFACEIVPROC glGetProgramInterfaceiv = 0x0;
+    PFNGLGETPROGRAMRESOURCENAMEPROC glGetProgramResourceName = 0x0;
+    PFNGLDISPATCHCOMPUTEINDIRECTPROC glDispatchComputeIndirect = 0x0;
+    PFNGLDRAWARRAYSINDIRECTPROC glDrawArraysIndirect = 0x0;
 
 	PFNGLDEBUGMESSAGECONTROLKHRPROC glDebugMessageControlKHR = 0x0;
 	PFNGLDEBUGMESSAGEINSERTKHRPROC glDebugMessageInsertKHR = 0x0;
 	PFNGLDEBUGMESSAGECALLBACKKHRPROC glDebugMessageCallbackKHR = 0x0;
 	PFNGLGETDEBUGMESSAGELOGKHRPROC glGetDebugMessageLogKHR = 0x0;
 
+	PFNGLMAXSHADERCOMPILERTHREADSKHRPROC glMaxShaderCompilerThreadsKHR = 0x0;
+
+	PFNGLDRAWRANGEELEMENTSBASEVERTEXEXTPROC glDrawRangeElementsBaseVertexEXT = 0x0;
+	PFNGLDRAWELEMENTSINSTANCEDBASEVERTEXEXTPROC glDrawElementsInstancedBaseVertexEXT = 0x0;
+
+	// EXT_copy_image
+	PFNGLCOPYIMAGESUBDATAEXTPROC glCopyImageSubDataEXT = 0x0;
+
 }  // namespace h3dGLES
 
 
@@ -162,6 +177,61 @@ bool initOpenGLExtensions()
 		r &= ( glGetDebugMessageLogKHR = ( PFNGLGETDEBUGMESSAGELOGKHRPROC ) platformGetProcAddress( "glGetDebugMessageLogKHR" ) ) != 0x0;
 	}
 
+	glESExt::KHR_parallel_shader_compile = checkExtensionSupported( "GL_KHR_parallel_shader_compile" );
+	if ( glESExt::KHR_parallel_shader_compile )
+	{
+		r &= ( glMaxShaderCompilerThreadsKHR = ( PFNGLMAXSHADERCOMPILERTHREADSKHRPROC ) platformGetProcAddress( "glMaxShaderCompilerThreadsKHR" ) ) != 0x0;
+	}
+
+	// Compute shaders and indirect draws are core in OpenGL ES 3.1
+	if ( glESExt::majorVersion * 10 + glESExt::minorVersion >= 31 )
+	{
+		r &= ( h3dGLES::glDispatchCompute = ( PFNGLDISPATCHCOMPUTEPROC ) platformGetProcAddress( "glDispatchCompute" ) ) != 0x0;
+		r &= ( h3dGLES::glDispatchComputeIndirect = ( PFNGLDISPATCHCOMPUTEINDIRECTPROC ) platformGetProcAddress( "glDispatchComputeIndirect" ) ) != 0x0;
+		r &= ( h3dGLES::glDrawArraysIndirect = ( PFNGLDRAWARRAYSINDIRECTPROC ) platformGetProcAddress( "glDrawArraysIndirect" ) ) != 0x0;
+		r &= ( h3dGLES::glMemoryBarrier = ( PFNGLMEMORYBARRIERPROC ) platformGetProcAddress( "glMemoryBarrier" ) ) != 0x0;
+		r &= ( h3dGLES::glGetProgramResourceiv = ( PFNGLGETPROGRAMRESOURCEIVPROC ) platformGetProcAddress( "glGetProgramResourceiv" ) ) != 0x0;
+		r &= ( h3dGLES::glGetProgramResourceIndex = ( PFNGLGETPROGRAMRESOURCEINDEXPROC ) platformGetProcAddress( "glGetProgramResourceIndex" ) ) != 0x0;
+		r &= ( h3dGLES::glGetProgramInterfaceiv = ( PFNGLGETPROGRAMINTERFACEIVPROC ) platformGetProcAddress( "glGetProgramInterfaceiv" ) ) != 0x0;
+		r &= ( h3dGLES::glGetProgramResourceName = ( PFNGLGETPROGRAMRESOURCENAMEPROC ) platformGetProcAddress( "glGetProgramResourceName" ) ) != 0x0;
+	}
+
+	if ( glESExt::majorVersion * 10 + glESExt::minorVersion >= 32 )
+	{
+		glESExt::EXT_draw_elements_base_vertex = true;
+		r &= ( glDrawRangeElementsBaseVertexEXT = ( PFNGLDRAWRANGEELEMENTSBASEVERTEXEXTPROC ) platformGetProcAddress( "glDrawRangeElementsBaseVertex" ) ) != 0x0;
+		r &= ( glDrawElementsInstancedBaseVertexEXT = ( PFNGLDRAWELEMENTSINSTANCEDBASEVERTEXEXTPROC ) platformGetProcAddress( "glDrawElementsInstancedBaseVertex" ) ) != 0x0;
+	}
+	else
+	{
+		glESExt::EXT_draw_elements_base_vertex = checkExtensionSupported( "GL_EXT_draw_elements_base_vertex" ) ||
+		                                         checkExtensionSupported( "GL_OES_draw_elements_base_vertex" );
+		if ( checkExtensionSupported( "GL_EXT_draw_elements_base_vertex" ) )
+		{
+			r &= ( glDrawRangeElementsBaseVertexEXT = ( PFNGLDRAWRANGEELEMENTSBASEVERTEXEXTPROC ) platformGetProcAddress( "glDrawRangeElementsBaseVertexEXT" ) ) != 0x0;
+			r &= ( glDrawElementsInstancedBaseVertexEXT = ( PFNGLDRAWELEMENTSINSTANCEDBASEVERTEXEXTPROC ) platformGetProcAddress( "glDrawElementsInstancedBaseVertexEXT" ) ) != 0x0;
+		}
+		else if ( glESExt::EXT_draw_elements_base_vertex )
+		{
+			r &= ( glDrawRangeElementsBaseVertexEXT = ( PFNGLDRAWRANGEELEMENTSBASEVERTEXEXTPROC ) platformGetProcAddress( "glDrawRangeElementsBaseVertexOES" ) ) != 0x0;
+			r &= ( glDrawElementsInstancedBaseVertexEXT = ( PFNGLDRAWELEMENTSINSTANCEDBASEVERTEXEXTPROC ) platformGetProcAddress( "glDrawElementsInstancedBaseVertexOES" ) ) != 0x0;
+		}
+	}
+
+	if ( glESExt::majorVersion * 10 + glESExt::minorVersion >= 32 )
+	{
+		glESExt::EXT_copy_image = true;
+		r &= ( glCopyImageSubDataEXT = ( PFNGLCOPYIMAGESUBDATAEXTPROC ) platformGetProcAddress( "glCopyImageSubData" ) ) != 0x0;
+	}
+	else
+	{
+		glESExt::EXT_copy_image = checkExtensionSupported( "GL_EXT_copy_image" ) || checkExtensionSupported( "GL_OES_copy_image" );
+		if ( checkExtensionSupported( "GL_EXT_copy_image" ) )
+			r &= ( glCopyImageSubDataEXT = ( PFNGLCOPYIMAGESUBDATAEXTPROC ) platformGetProcAddress( "glCopyImageSubDataEXT" ) ) != 0x0;
+		else if ( glESExt::EXT_copy_image )
+			r &= ( glCopyImageSubDataEXT = ( PFNGLCOPYIMAGESUBDATAEXTPROC ) platformGetProcAddress( "glCopyImageSubDataOES" ) ) != 0x0;
+	}
+
 	glESExt::EXT_disjoint_timer_query = checkExtensionSupported( "GL_EXT_disjoint_timer_query" );
 	if ( glESExt::EXT_disjoint_timer_query )
 	{
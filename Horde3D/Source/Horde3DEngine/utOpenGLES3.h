@@ -70,6 +70,9 @@ namespace glESExt
 	extern bool OES_EGL_image_external;
 
 	extern bool KHR_debug;
+	extern bool KHR_parallel_shader_compile;
+	extern bool EXT_draw_elements_base_vertex;
+	extern bool EXT_copy_image;
 
 	extern int  majorVersion, minorVersion;
 }
@@ -603,6 +606,10 @@ extern PFNGLDISPATCHCOMPUTEPROC glDispatchCompute;
 extern PFNGLMEMORYBARRIERPROC glMemoryBarrier;
 extern PFNGLGETPROGRAMRESOURCEIVPROC glGetProgramResourceiv;
 extern PFNGLGETPROGRAMRESOURCEINDEXPROC glGetProgramResourceIndex;
+extern PFNGLGETPROGRAMINTERFACEIVPROC glGetProgramInterfaceiv;
+extern PFNGLGETPROGRAMRESOURCENAMEPROC glGetProgramResourceName;
+extern PFNGLDISPATCHCOMPUTEINDIRECTPROC glDispatchComputeIndirect;
+extern PFNGLDRAWARRAYSINDIRECTPROC glDrawArraysIndirect;
 
 /*
 GL_APICALL void GL_APIENTRY glDispatchComputeIndirect (GLintptr indirect);
@@ -739,5 +746,41 @@ extern PFNGLGETDEBUGMESSAGELOGKHRPROC glGetDebugMessageLogKHR;
 
 #endif
 
+#ifndef GL_KHR_parallel_shader_compile
+#define GL_KHR_parallel_shader_compile 1
+
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#define GL_COMPLETION_STATUS_KHR          0x91B1
+typedef void ( GL_APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSKHRPROC ) ( GLuint count );
+
+extern PFNGLMAXSHADERCOMPILERTHREADSKHRPROC glMaxShaderCompilerThreadsKHR;
+
+#endif
+
+// EXT_draw_elements_base_vertex, core in OpenGL ES 3.2
+#ifndef GL_EXT_draw_elements_base_vertex
+#define GL_EXT_draw_elements_base_vertex 1
+
+typedef void ( GL_APIENTRYP PFNGLDRAWRANGEELEMENTSBASEVERTEXEXTPROC ) ( GLenum mode, GLuint start, GLuint end, GLsizei count, GLenum type, const void *indices, GLint basevertex );
+
+typedef void ( GL_APIENTRYP PFNGLDRAWELEMENTSINSTANCEDBASEVERTEXEXTPROC ) ( GLenum mode, GLsizei count, GLenum type, const void *indices, GLsizei instancecount, GLint basevertex );
+
+extern PFNGLDRAWRANGEELEMENTSBASEVERTEXEXTPROC glDrawRangeElementsBaseVertexEXT;
+extern PFNGLDRAWELEMENTSINSTANCEDBASEVERTEXEXTPROC glDrawElementsInstancedBaseVertexEXT;
+
+#endif
+
+// EXT_copy_image, core in OpenGL ES 3.2
+#ifndef GL_EXT_copy_image
+#define GL_EXT_copy_image 1
+
+typedef void ( GL_APIENTRYP PFNGLCOPYIMAGESUBDATAEXTPROC ) ( GLuint srcName, GLenum srcTarget, GLint srcLevel, GLint srcX, GLint srcY, GLint srcZ,
+															 GLuint dstName, GLenum dstTarget, GLint dstLevel, GLint dstX, GLint dstY, GLint dstZ,
+															 GLsizei srcWidth, GLsizei srcHeight, GLsizei srcDepth );
+
+extern PFNGLCOPYIMAGESUBDATAEXTPROC glCopyImageSubDataEXT;
+
+#endif
+
 }  // namespace h3dGLES
 
@@ -15,6 +15,7 @@
 #include "utPlatform.h"
 #include "utEndian.h"
 #include "utMath.h"
+#include "utPack.h"
 #include <math.h>
 #ifdef PLATFORM_WIN
 #	define WIN32_LEAN_AND_MEAN 1
@@ -22,6 +23,10 @@
 #		define NOMINMAX
 #	endif
 #	include <windows.h>
+#elif !defined( _WIN32 )
+#	include <sys/mman.h>
+#	include <fcntl.h>
+#	include <unistd.h>
 #endif
 #include <cstdlib>
 #include <cstring>
@@ -31,6 +36,12 @@
 #include <map>
 #include <fstream>
 #include <iomanip>
+#include <set>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <sys/stat.h>
 
 using namespace Horde3D;
 using namespace std;
@@ -39,6 +50,13 @@ using namespace std;
 #undef PLATFORM_WIN
 #endif
 
+#if defined( PLATFORM_LINUX ) && defined( __linux__ )
+#	define H3DUT_USE_INOTIFY
+#	include <sys/inotify.h>
+#	include <dirent.h>
+#	include <unistd.h>
+#endif
+
 
 namespace Horde3DUtils {
 
@@ -70,6 +88,599 @@ string cleanPath( string path )
 	return path;
 }
 
+
+vector< string > splitContentDirs( const char *contentDir )
+{
+	string dir;
+	vector< string > dirs;
+
+	// Split path string
+	const char *c = contentDir;
+	do
+	{
+		if( *c != '|' && *c != '\0' )
+			dir += *c;
+		else
+		{
+			dir = cleanPath( dir );
+			if( dir != "" ) dir += '/';
+			dirs.push_back( dir );
+			dir = "";
+		}
+	} while( *c++ != '\0' );
+
+	return dirs;
+}
+
+
+// =================================================================================================
+// Resource file watching
+// =================================================================================================
+
+struct ResourceWatcher
+{
+	vector< string >       dirs;
+	bool                   active;
+	map< H3DRes, time_t >  fileTimes;  // Modification times for polling
+#ifdef H3DUT_USE_INOTIFY
+	int                    inotifyFd;
+	map< int, string >     watchDirs;  // Watch descriptor -> directory
+#endif
+
+	ResourceWatcher() : active( false )
+	{
+#ifdef H3DUT_USE_INOTIFY
+		inotifyFd = -1;
+#endif
+	}
+};
+
+ResourceWatcher  watcher;
+
+
+string normalizePath( const string &path )
+{
+	// Unify separators and remove duplicate ones so that paths built in different ways can be compared
+	string result;
+	result.reserve( path.length() );
+	for( size_t i = 0; i < path.length(); ++i )
+	{
+		char c = path[i] == '\\' ? '/' : path[i];
+		if( c == '/' && !result.empty() && result[result.length() - 1] == '/' ) continue;
+		result += c;
+	}
+
+	return result;
+}
+
+
+bool findResourceFile( H3DRes res, const vector< string > &dirs, string &fileName, time_t *modTime )
+{
+	// Same search order as when loading resources from disk
+	for( size_t i = 0; i < dirs.size(); ++i )
+	{
+		fileName = dirs[i] + resourcePaths[h3dGetResType( res )] + "/" + h3dGetResName( res );
+		
+		struct stat fileStat;
+		if( stat( fileName.c_str(), &fileStat ) == 0 && (fileStat.st_mode & S_IFREG) )
+		{
+			if( modTime != 0x0 ) *modTime = fileStat.st_mtime;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+bool reloadResourceFile( H3DRes res, const string &fileName, vector< char > &dataBuf )
+{
+	ifstream inf( fileName.c_str(), ios::binary );
+	if( !inf.good() ) return false;
+
+	inf.seekg( 0, ios::end );
+	size_t fileSize = (size_t)inf.tellg();
+	if( fileSize == 0 ) return false;
+	
+	dataBuf.resize( fileSize );
+	inf.seekg( 0 );
+	inf.read( &dataBuf[0], fileSize );
+	if( !inf.good() ) return false;
+
+	// Files that were saved without changing their content are not counted
+	return h3dReloadResource( res, &dataBuf[0], (int)fileSize ) > 0;
+}
+
+
+#ifdef H3DUT_USE_INOTIFY
+void addDirWatch( const string &dir )
+{
+	int wd = inotify_add_watch( watcher.inotifyFd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE );
+	if( wd < 0 ) return;
+	watcher.watchDirs[wd] = dir;
+
+	// Watch subdirectories as well
+	DIR *dirHandle = opendir( dir.c_str() );
+	if( dirHandle == 0x0 ) return;
+
+	while( dirent *entry = readdir( dirHandle ) )
+	{
+		if( strcmp( entry->d_name, "." ) == 0 || strcmp( entry->d_name, ".." ) == 0 ) continue;
+
+		string path = dir + "/" + entry->d_name;
+		bool isDir = entry->d_type == DT_DIR;
+		if( entry->d_type == DT_UNKNOWN )
+		{
+			struct stat fileStat;
+			isDir = stat( path.c_str(), &fileStat ) == 0 && S_ISDIR( fileStat.st_mode );
+		}
+		if( isDir ) addDirWatch( path );
+	}
+
+	closedir( dirHandle );
+}
+
+
+bool readDirEvents( set< string > &changedFiles )
+{
+	// Returns false if events were lost and all files need to be checked
+	bool complete = true;
+	char buf[4096] __attribute__(( aligned( __alignof__( inotify_event ) ) ));
+	
+	for( ;; )
+	{
+		ssize_t len = read( watcher.inotifyFd, buf, sizeof( buf ) );
+		if( len <= 0 ) break;
+
+		for( char *ptr = buf; ptr < buf + len; )
+		{
+			const inotify_event *event = (const inotify_event *)ptr;
+			ptr += sizeof( inotify_event ) + event->len;
+
+			if( event->mask & IN_Q_OVERFLOW )
+			{
+				complete = false;
+				continue;
+			}
+			
+			map< int, string >::iterator itr = watcher.watchDirs.find( event->wd );
+			if( itr == watcher.watchDirs.end() || event->len == 0 ) continue;
+
+			string path = itr->second + "/" + event->name;
+			if( event->mask & IN_ISDIR )
+			{
+				// New directory, files in it might have been created before the watch was added
+				if( event->mask & (IN_CREATE | IN_MOVED_TO) ) addDirWatch( path );
+				complete = false;
+			}
+			else if( event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO) )
+			{
+				changedFiles.insert( normalizePath( path ) );
+			}
+		}
+	}
+
+	return complete;
+}
+#endif
+
+
+// =================================================================================================
+// Pack files
+// =================================================================================================
+
+const char PackFileExtension[] = ".h3dpack";
+
+class PackArchive
+{
+public:
+	PackArchive() : _data( 0x0 ), _size( 0 ) {}
+	~PackArchive() { close(); }
+
+	bool open( const string &fileName )
+	{
+		// Map complete file, the OS pages in only the parts that are actually accessed
+#if defined( _WIN32 )
+		HANDLE file = CreateFileA( fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, 0x0, OPEN_EXISTING,
+		                           FILE_ATTRIBUTE_NORMAL, 0x0 );
+		if( file == INVALID_HANDLE_VALUE ) return false;
+		
+		LARGE_INTEGER fileSize;
+		HANDLE mapping = 0x0;
+		if( GetFileSizeEx( file, &fileSize ) && fileSize.QuadPart > 0 )
+			mapping = CreateFileMappingA( file, 0x0, PAGE_READONLY, 0, 0, 0x0 );
+		if( mapping != 0x0 )
+		{
+			_data = (const uint8 *)MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+			_size = _data != 0x0 ? (size_t)fileSize.QuadPart : 0;
+			CloseHandle( mapping );
+		}
+		CloseHandle( file );
+#else
+		int fd = ::open( fileName.c_str(), O_RDONLY );
+		if( fd < 0 ) return false;
+
+		struct stat fileStat;
+		if( fstat( fd, &fileStat ) == 0 && fileStat.st_size > 0 )
+		{
+			void *ptr = mmap( 0x0, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+			if( ptr != MAP_FAILED )
+			{
+				_data = (const uint8 *)ptr;
+				_size = (size_t)fileStat.st_size;
+			}
+		}
+		::close( fd );
+#endif
+
+		if( _data == 0x0 || !_header.read( _data, _size ) )
+		{
+			close();
+			return false;
+		}
+
+		return true;
+	}
+
+	void close()
+	{
+		if( _data == 0x0 ) return;
+#if defined( _WIN32 )
+		UnmapViewOfFile( _data );
+#else
+		munmap( (void *)_data, _size );
+#endif
+		_data = 0x0;
+		_size = 0;
+	}
+
+	bool findEntry( const string &name, PackEntry &entry ) const
+	{
+		return _data != 0x0 && packFindEntry( _data, _size, _header, name, entry );
+	}
+
+	const uint8 *getEntryData( const PackEntry &entry ) const { return _data + entry.dataOffset; }
+
+private:
+	const uint8  *_data;
+	size_t       _size;
+	PackHeader   _header;
+};
+
+map< string, PackArchive * >  packArchives;  // Opened pack files by path
+
+
+PackArchive *getPackArchive( const string &dir )
+{
+	// Search path entries with pack extension refer to pack files, directories otherwise
+	size_t extLen = sizeof( PackFileExtension ) - 1;
+	string path = cleanPath( dir );
+	if( path.length() <= extLen || _stricmp( path.c_str() + path.length() - extLen, PackFileExtension ) != 0 )
+		return 0x0;
+
+	map< string, PackArchive * >::iterator itr = packArchives.find( path );
+	if( itr != packArchives.end() ) return itr->second;
+
+	PackArchive *archive = new PackArchive();
+	if( !archive->open( path ) )
+	{
+		delete archive;
+		archive = 0x0;
+	}
+	
+	// Failed attempts are remembered as well to avoid opening the file for every resource
+	packArchives[path] = archive;
+	return archive;
+}
+
+
+// =================================================================================================
+// Resource prefetching
+// =================================================================================================
+
+struct ResourceRef
+{
+	int     type;
+	string  name;
+};
+
+struct ReferenceAttrib
+{
+	const char  *name;
+	int         type;
+	bool        assignment;  // Value is preceded by '=', otherwise by the keyword only
+};
+
+const ReferenceAttrib referenceAttribs[] = {
+	{ "geometry", H3DResTypes::Geometry, true },
+	{ "material", H3DResTypes::Material, true },
+	{ "link", H3DResTypes::Material, true },
+	{ "sceneGraph", H3DResTypes::SceneGraph, true },
+	{ "particleEffect", H3DResTypes::ParticleEffect, true },
+	{ "pipeline", H3DResTypes::Pipeline, true },
+	{ "source", H3DResTypes::Shader, true },
+	{ "map", H3DResTypes::Texture, true },
+	{ "Texture", H3DResTypes::Texture, true },
+	{ "#include", H3DResTypes::Code, false }
+};
+
+
+bool isIdentChar( char c )
+{
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == '#';
+}
+
+
+void scanResourceRefs( const string &fileName, const char *data, size_t size, vector< ResourceRef > &refs )
+{
+	// Cheap scan for resource references without parsing. Scene graphs, materials, pipelines and shaders
+	// reference other resources in quoted attribute values (name="value") or includes (#include "value").
+	// Wrong guesses only result in unused prefetches.
+	const char *exts[] = { ".xml", ".shader", ".glsl" };
+	bool text = false;
+	for( size_t i = 0; i < sizeof( exts ) / sizeof( exts[0] ) && !text; ++i )
+	{
+		size_t len = strlen( exts[i] );
+		text = fileName.length() > len && _stricmp( fileName.c_str() + fileName.length() - len, exts[i] ) == 0;
+	}
+	if( !text ) return;
+
+	for( size_t i = 0; i < size; ++i )
+	{
+		if( data[i] != '"' ) continue;
+
+		size_t end = i + 1;
+		while( end < size && data[end] != '"' && data[end] != '\n' ) ++end;
+		if( end >= size || data[end] != '"' || end == i + 1 )
+		{
+			i = end;
+			continue;
+		}
+		
+		// Identifier before value
+		size_t j = i;
+		while( j > 0 && (data[j - 1] == ' ' || data[j - 1] == '\t') ) --j;
+		bool assignment = j > 0 && data[j - 1] == '=';
+		if( assignment )
+		{
+			--j;
+			while( j > 0 && (data[j - 1] == ' ' || data[j - 1] == '\t') ) --j;
+		}
+		size_t identEnd = j;
+		while( j > 0 && isIdentChar( data[j - 1] ) ) --j;
+		
+		for( size_t k = 0; k < sizeof( referenceAttribs ) / sizeof( referenceAttribs[0] ); ++k )
+		{
+			const ReferenceAttrib &attrib = referenceAttribs[k];
+			if( attrib.assignment == assignment && strlen( attrib.name ) == identEnd - j &&
+			    strncmp( attrib.name, data + j, identEnd - j ) == 0 )
+			{
+				ResourceRef ref;
+				ref.type = attrib.type;
+				ref.name.assign( data + i + 1, end - i - 1 );
+				refs.push_back( ref );
+				break;
+			}
+		}
+
+		i = end;
+	}
+}
+
+
+class ResourcePrefetcher
+{
+public:
+	enum Result
+	{
+		NotRequested,
+		NotFound,   // Not found in directories or found in a pack file
+		Data
+	};
+
+	ResourcePrefetcher() : _numReading( 0 ), _stop( false )
+	{
+		// Many concurrent reads hide the latency of network storage
+		unsigned int numThreads = std::thread::hardware_concurrency();
+		numThreads = numThreads < 4 ? 4 : (numThreads > 16 ? 16 : numThreads);
+		for( unsigned int i = 0; i < numThreads; ++i )
+			_workers.push_back( std::thread( &ResourcePrefetcher::workerFunc, this ) );
+	}
+
+	~ResourcePrefetcher()
+	{
+		{
+			std::lock_guard< std::mutex > lock( _mutex );
+			_stop = true;
+		}
+		_queueCond.notify_all();
+		for( size_t i = 0; i < _workers.size(); ++i ) _workers[i].join();
+	}
+
+	static ResourcePrefetcher &instance()
+	{
+		// Created on first use and kept for the lifetime of the process, so the threads are not started
+		// for every load call; never destroyed since joining threads during DLL unload can deadlock
+		static ResourcePrefetcher *prefetcher = new ResourcePrefetcher();
+		return *prefetcher;
+	}
+
+	void begin( const vector< string > &dirs, const vector< PackArchive * > &packs )
+	{
+		// Workers are idle between sessions, so they do not access the search paths while replaced
+		std::lock_guard< std::mutex > lock( _mutex );
+		_dirs = dirs;
+		_packs = packs;
+		_paths = resourcePaths;
+	}
+
+	void end()
+	{
+		// Drop pending requests and wait for reads in progress since their items are discarded
+		std::unique_lock< std::mutex > lock( _mutex );
+		_queue.clear();
+		_idleCond.wait( lock, [this] { return _numReading == 0; } );
+		_queue.clear();
+		_items.clear();
+	}
+
+	void skip( int type, const string &name )
+	{
+		// Already loaded resources are not prefetched when referenced
+		std::lock_guard< std::mutex > lock( _mutex );
+		_items[getPath( type, name )].state = Item::Taken;
+	}
+
+	void request( int type, const string &name )
+	{
+		std::lock_guard< std::mutex > lock( _mutex );
+		requestLocked( getPath( type, name ) );
+	}
+
+	Result take( int type, const string &name, vector< char > &data )
+	{
+		std::unique_lock< std::mutex > lock( _mutex );
+		map< string, Item >::iterator itr = _items.find( getPath( type, name ) );
+		if( itr == _items.end() || itr->second.state == Item::Taken ) return NotRequested;
+
+		// Move own request to front of queue if not yet in progress
+		if( itr->second.state == Item::Queued )
+			_queue.push_front( itr->first );
+		
+		_doneCond.wait( lock, [&itr] { return itr->second.state == Item::Done; } );
+		itr->second.state = Item::Taken;
+		if( !itr->second.found ) return NotFound;
+
+		data.swap( itr->second.data );
+		vector< char >().swap( itr->second.data );
+		return Data;
+	}
+
+private:
+	struct Item
+	{
+		enum State { Queued, Reading, Done, Taken };
+
+		State           state;
+		bool            found;
+		vector< char >  data;
+
+		Item() : state( Queued ), found( false ) {}
+	};
+
+	string getPath( int type, const string &name ) const
+	{
+		map< int, string >::const_iterator itr = _paths.find( type );
+		return (itr != _paths.end() ? itr->second : string()) + "/" + name;
+	}
+
+	void requestLocked( const string &path )
+	{
+		if( _items.find( path ) != _items.end() ) return;
+
+		_items[path];
+		_queue.push_back( path );
+		_queueCond.notify_one();
+	}
+
+	bool readFile( const string &path, vector< char > &data ) const
+	{
+		// Same search order as h3dutLoadResourcesFromDisk
+		string packName;
+		PackEntry entry;
+		for( size_t i = 0; i < _dirs.size(); ++i )
+		{
+			if( _packs[i] != 0x0 )
+			{
+				if( packName.empty() ) packName = packNormalizeName( path.c_str() );
+				if( _packs[i]->findEntry( packName, entry ) ) return false;  // No I/O needed
+				continue;
+			}
+
+			ifstream inf( (_dirs[i] + path).c_str(), ios::binary );
+			if( !inf.good() ) continue;
+
+			inf.seekg( 0, ios::end );
+			size_t fileSize = (size_t)inf.tellg();
+			inf.seekg( 0 );
+			data.resize( fileSize );
+			if( fileSize > 0 ) inf.read( &data[0], fileSize );
+			return inf.good() && fileSize > 0;
+		}
+
+		return false;
+	}
+
+	void workerFunc()
+	{
+		vector< char > data;
+		vector< ResourceRef > refs;
+		
+		std::unique_lock< std::mutex > lock( _mutex );
+		for( ;; )
+		{
+			_queueCond.wait( lock, [this] { return _stop || !_queue.empty(); } );
+			if( _stop ) break;
+
+			string path = _queue.front();
+			_queue.pop_front();
+			Item &item = _items[path];
+			if( item.state != Item::Queued ) continue;  // Duplicate entry from prioritization
+			item.state = Item::Reading;
+			++_numReading;
+
+			lock.unlock();
+			data.clear();
+			refs.clear();
+			bool found = readFile( path, data );
+			if( found ) scanResourceRefs( path, &data[0], data.size(), refs );
+			lock.lock();
+
+			item.found = found;
+			item.data.swap( data );
+			item.state = Item::Done;
+			_doneCond.notify_all();
+
+			// Issue reads for the dependencies before they are discovered by the engine
+			for( size_t i = 0; i < refs.size(); ++i )
+				requestLocked( getPath( refs[i].type, refs[i].name ) );
+
+			if( --_numReading == 0 ) _idleCond.notify_all();
+		}
+	}
+
+private:
+	vector< string >              _dirs;   // Search paths of current session
+	vector< PackArchive * >       _packs;
+	map< int, string >            _paths;  // Copy of resource paths for worker threads
+
+	std::mutex                    _mutex;
+	std::condition_variable       _queueCond, _doneCond, _idleCond;
+	deque< string >               _queue;
+	map< string, Item >           _items;  // Items by path
+	vector< std::thread >         _workers;
+	int                           _numReading;
+	bool                          _stop;
+};
+
+
+class PrefetchSession
+{
+public:
+	PrefetchSession( ResourcePrefetcher &prefetcher, const vector< string > &dirs,
+	                 const vector< PackArchive * > &packs ) : _prefetcher( prefetcher )
+	{
+		_prefetcher.begin( dirs, packs );
+	}
+
+	~PrefetchSession() { _prefetcher.end(); }
+
+private:
+	ResourcePrefetcher  &_prefetcher;
+};
+
+int numPrefetchedResources = 0;  // Resources of last load call that were passed from prefetched data
+
 }  // namespace
 
 
@@ -97,45 +708,99 @@ H3D_IMPL void h3dutSetResourcePath( int type, const char *path )
 H3D_IMPL bool h3dutLoadResourcesFromDisk( const char *contentDir )
 {
 	bool result = true;
-	string dir;
-	vector< string > dirs;
-
-	// Split path string
-	char *c = (char *)contentDir;
-	do
-	{
-		if( *c != '|' && *c != '\0' )
-			dir += *c;
-		else
-		{
-			dir = cleanPath( dir );
-			if( dir != "" ) dir += '/';
-			dirs.push_back( dir );
-			dir = "";
-		}
-	} while( *c++ != '\0' );
+	vector< string > dirs = splitContentDirs( contentDir );
+	numPrefetchedResources = 0;
 	
+	vector< PackArchive * > packs( dirs.size() );
+	for( unsigned int i = 0; i < dirs.size(); ++i )
+		packs[i] = getPackArchive( dirs[i] );
+
 	// Get the first resource that needs to be loaded
 	int res = h3dQueryUnloadedResource( 0 );
+	if( res == 0 ) return result;
 	
+	// Read all unloaded resources and their dependencies in the background while the engine parses
+	ResourcePrefetcher &prefetcher = ResourcePrefetcher::instance();
+	PrefetchSession session( prefetcher, dirs, packs );
+	for( int r = h3dGetNextResource( H3DResTypes::Undefined, 0 ); r != 0; r = h3dGetNextResource( H3DResTypes::Undefined, r ) )
+	{
+		if( h3dIsResLoaded( r ) ) prefetcher.skip( h3dGetResType( r ), h3dGetResName( r ) );
+	}
+	for( int i = 0, r = res; r != 0; r = h3dQueryUnloadedResource( ++i ) )
+		prefetcher.request( h3dGetResType( r ), h3dGetResName( r ) );
+
 	char *dataBuf = 0;
 	size_t bufSize = 0;
+	vector< char > prefetchBuf;
 
 	while( res != 0 )
 	{
+		// Parsing happens in discovery order, so a resource is always parsed after the resources
+		// referencing it, while the data of its own dependencies is already being read
+		ResourcePrefetcher::Result prefetch = prefetcher.take( h3dGetResType( res ), h3dGetResName( res ), prefetchBuf );
+		if( prefetch == ResourcePrefetcher::Data )
+		{
+			result &= h3dLoadResource( res, &prefetchBuf[0], (int)prefetchBuf.size() );
+			++numPrefetchedResources;
+			res = h3dQueryUnloadedResource( 0 );
+			continue;
+		}
+		
 		ifstream inf;
+		const PackArchive *pack = 0x0;
+		PackEntry entry;
+		string packName;
 		
-		// Loop over search paths and try to open files
+		// Loop over search paths and try to find files in packs or open them
 		for( unsigned int i = 0; i < dirs.size(); ++i )
 		{
+			if( packs[i] != 0x0 )
+			{
+				if( packName.empty() )
+					packName = packNormalizeName( (resourcePaths[h3dGetResType( res )] + "/" + h3dGetResName( res )).c_str() );
+				if( packs[i]->findEntry( packName, entry ) )
+				{
+					pack = packs[i];
+					break;
+				}
+				continue;
+			}
+			
 			string fileName = dirs[i] + resourcePaths[h3dGetResType( res )] + "/" + h3dGetResName( res );
 			inf.clear();
 			inf.open( fileName.c_str(), ios::binary );
 			if( inf.good() ) break;
 		}
 
-		// Open resource file
-		if( inf.good() ) // Resource file found
+		if( pack != 0x0 )  // Resource found in pack file
+		{
+			if( entry.compression == PackCompression::None )
+			{
+				// Pass data directly from mapping
+				result &= h3dLoadResource( res, (const char *)pack->getEntryData( entry ), (int)entry.size );
+			}
+			else
+			{
+				if( bufSize < entry.size )
+				{
+					delete[] dataBuf;
+					dataBuf = new char[entry.size];
+					bufSize = entry.size;
+				}
+				
+				if( entry.compression == PackCompression::LZ &&
+				    packLZDecompress( pack->getEntryData( entry ), entry.storedSize, (uint8 *)dataBuf, entry.size ) )
+				{
+					result &= h3dLoadResource( res, dataBuf, (int)entry.size );
+				}
+				else
+				{
+					h3dLoadResource( res, 0x0, 0 );
+					result = false;
+				}
+			}
+		}
+		else if( inf.good() ) // Resource file found
 		{
 			// Find size of resource file
 			inf.seekg( 0, ios::end );
@@ -174,6 +839,124 @@ H3D_IMPL bool h3dutLoadResourcesFromDisk( const char *contentDir )
 }
 
 
+H3D_IMPL int h3dutGetNumPrefetchedResources()
+{
+	return numPrefetchedResources;
+}
+
+
+H3D_IMPL void h3dutClosePackFiles()
+{
+	for( map< string, PackArchive * >::iterator itr = packArchives.begin(); itr != packArchives.end(); ++itr )
+		delete itr->second;
+	packArchives.clear();
+}
+
+
+H3D_IMPL void h3dutStopWatchingResourceChanges()
+{
+#ifdef H3DUT_USE_INOTIFY
+	if( watcher.inotifyFd >= 0 ) close( watcher.inotifyFd );
+	watcher.inotifyFd = -1;
+	watcher.watchDirs.clear();
+#endif
+	watcher.fileTimes.clear();
+	watcher.dirs.clear();
+	watcher.active = false;
+}
+
+
+H3D_IMPL bool h3dutWatchResourceChanges( const char *contentDir )
+{
+	h3dutStopWatchingResourceChanges();
+	if( contentDir == 0x0 ) return false;
+
+	watcher.dirs = splitContentDirs( contentDir );
+
+#ifdef H3DUT_USE_INOTIFY
+	watcher.inotifyFd = inotify_init1( IN_NONBLOCK | IN_CLOEXEC );
+	if( watcher.inotifyFd < 0 ) return false;
+
+	for( size_t i = 0; i < watcher.dirs.size(); ++i )
+		addDirWatch( cleanPath( watcher.dirs[i] != "" ? watcher.dirs[i] : "." ) );
+#else
+	// Remember modification times of the current files
+	string fileName;
+	for( H3DRes res = h3dGetNextResource( H3DResTypes::Undefined, 0 ); res != 0;
+	     res = h3dGetNextResource( H3DResTypes::Undefined, res ) )
+	{
+		time_t modTime;
+		if( h3dIsResLoaded( res ) && findResourceFile( res, watcher.dirs, fileName, &modTime ) )
+			watcher.fileTimes[res] = modTime;
+	}
+#endif
+
+	watcher.active = true;
+	return true;
+}
+
+
+H3D_IMPL int h3dutReloadChangedResources()
+{
+	if( !watcher.active ) return 0;
+
+	int numReloaded = 0;
+	string fileName;
+	vector< char > dataBuf;
+
+#ifdef H3DUT_USE_INOTIFY
+	set< string > changedFiles;
+	bool checkAll = !readDirEvents( changedFiles );
+	if( changedFiles.empty() && !checkAll ) return 0;
+
+	vector< string > normDirs( watcher.dirs.size() );
+	for( size_t i = 0; i < watcher.dirs.size(); ++i )
+		normDirs[i] = normalizePath( watcher.dirs[i] );
+	
+	for( H3DRes res = h3dGetNextResource( H3DResTypes::Undefined, 0 ); res != 0;
+	     res = h3dGetNextResource( H3DResTypes::Undefined, res ) )
+	{
+		if( !h3dIsResLoaded( res ) ) continue;
+
+		// Cheap check by name before accessing the file system
+		bool changed = checkAll;
+		string relName = resourcePaths[h3dGetResType( res )] + "/" + h3dGetResName( res );
+		for( size_t i = 0; i < normDirs.size() && !changed; ++i )
+			changed = changedFiles.find( normalizePath( normDirs[i] + relName ) ) != changedFiles.end();
+		if( !changed ) continue;
+
+		// File in a search path with higher priority can shadow the changed one
+		if( !findResourceFile( res, watcher.dirs, fileName, 0x0 ) ) continue;
+		if( !checkAll && changedFiles.find( normalizePath( fileName ) ) == changedFiles.end() ) continue;
+
+		// Engine skips resources with unchanged content
+		if( reloadResourceFile( res, fileName, dataBuf ) ) ++numReloaded;
+	}
+#else
+	for( H3DRes res = h3dGetNextResource( H3DResTypes::Undefined, 0 ); res != 0;
+	     res = h3dGetNextResource( H3DResTypes::Undefined, res ) )
+	{
+		time_t modTime;
+		if( !h3dIsResLoaded( res ) || !findResourceFile( res, watcher.dirs, fileName, &modTime ) ) continue;
+
+		map< H3DRes, time_t >::iterator itr = watcher.fileTimes.find( res );
+		if( itr == watcher.fileTimes.end() )
+		{
+			// Resource loaded after watching was started
+			watcher.fileTimes[res] = modTime;
+			continue;
+		}
+		if( itr->second == modTime ) continue;
+
+		itr->second = modTime;
+		if( reloadResourceFile( res, fileName, dataBuf ) ) ++numReloaded;
+	}
+#endif
+
+	return numReloaded;
+}
+
+
 H3D_IMPL bool h3dutDumpMessages()
 {
 	if( !outf.is_open() )
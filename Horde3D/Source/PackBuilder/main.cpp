@@ -0,0 +1,320 @@
+// *************************************************************************************************
+//
+// Horde3D
+//   Next-Generation Graphics Engine
+// --------------------------------------
+// Copyright (C) 2006-2021 Nicolas Schulz and Horde3D team
+//
+// This software is distributed under the terms of the Eclipse Public License v1.0.
+// A copy of the license may be obtained at: http://www.eclipse.org/legal/epl-v10.html
+//
+// *************************************************************************************************
+
+#include "utPlatform.h"
+#include "utPack.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+#ifdef PLATFORM_WIN
+#   define WIN32_LEAN_AND_MEAN 1
+#	ifndef NOMINMAX
+#		define NOMINMAX
+#	endif
+#	include <windows.h>
+#else
+#	include <sys/stat.h>
+#	include <dirent.h>
+#endif
+
+using namespace std;
+using namespace Horde3D;
+
+
+struct PackFile
+{
+	string     name;      // Normalized name relative to content directory
+	PackEntry  entry;
+};
+
+
+void log( const string &msg )
+{
+	cout << msg << endl;
+}
+
+
+void createFileList( const string &basePath, const string &path, vector< string > &fileList )
+{
+	vector< string >  directories;
+	vector< string >  files;
+
+// Find all files and subdirectories in current search path
+#ifdef PLATFORM_WIN
+	string searchString( basePath + path + "*" );
+
+	WIN32_FIND_DATA fdat;
+	HANDLE h = FindFirstFile( searchString.c_str(), &fdat );
+	if( h == INVALID_HANDLE_VALUE ) return;
+	do
+	{
+		// Ignore hidden files
+		if( fdat.cFileName[0] == '.' || fdat.dwFileAttributes & FILE_ATTRIBUTE_HIDDEN ) continue;
+
+		if( fdat.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY )
+			directories.push_back( fdat.cFileName );
+		else
+			files.push_back( fdat.cFileName );
+	} while( FindNextFile( h, &fdat ) );
+	FindClose( h );
+#else
+	dirent *dirEnt;
+	struct stat fileStat;
+	string finalPath = basePath + path;
+	DIR *dir = opendir( finalPath.c_str() );
+	if( dir == 0x0 ) return;
+
+	while( (dirEnt = readdir( dir )) != 0x0 )
+	{
+		if( dirEnt->d_name[0] == '.' ) continue;  // Ignore hidden files
+
+		if( stat( (finalPath + dirEnt->d_name).c_str(), &fileStat ) != 0 ) continue;
+
+		if( S_ISDIR( fileStat.st_mode ) )
+			directories.push_back( dirEnt->d_name );
+		else if( S_ISREG( fileStat.st_mode ) )
+			files.push_back( dirEnt->d_name );
+	}
+
+	closedir( dir );
+#endif
+
+	sort( directories.begin(), directories.end() );
+	sort( files.begin(), files.end() );
+
+	for( size_t i = 0; i < files.size(); ++i )
+		fileList.push_back( path + files[i] );
+
+	for( size_t i = 0; i < directories.size(); ++i )
+		createFileList( basePath, path + directories[i] + "/", fileList );
+}
+
+
+bool readFile( const string &fileName, vector< uint8 > &data )
+{
+	FILE *f = fopen( fileName.c_str(), "rb" );
+	if( f == 0x0 ) return false;
+
+	fseek( f, 0, SEEK_END );
+	long size = ftell( f );
+	fseek( f, 0, SEEK_SET );
+
+	data.resize( size > 0 ? (size_t)size : 0 );
+	bool result = size >= 0 && (size == 0 || fread( &data[0], 1, data.size(), f ) == data.size());
+	fclose( f );
+
+	return result;
+}
+
+
+bool hasExtension( const string &name, const vector< string > &extensions )
+{
+	for( size_t i = 0; i < extensions.size(); ++i )
+	{
+		const string &ext = extensions[i];
+		if( name.length() >= ext.length() &&
+		    _stricmp( name.c_str() + name.length() - ext.length(), ext.c_str() ) == 0 )
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+bool lessByHash( const PackFile &a, const PackFile &b )
+{
+	if( a.entry.nameHash != b.entry.nameHash ) return a.entry.nameHash < b.entry.nameHash;
+	return a.name < b.name;
+}
+
+
+void printHelp()
+{
+	log( "Usage:" );
+	log( "PackBuilder input output [optional arguments]" );
+	log( "" );
+	log( "input              content directory to be packed" );
+	log( "output             pack file to be written" );
+	log( "-store ext,ext     never compress files with these extensions (default: .dds,.ktx,.jpg,.png)" );
+	log( "-noCompression     store all files uncompressed" );
+	log( "-minSaving percent compress only when the size is reduced by at least percent (default: 15)" );
+}
+
+
+int main( int argc, char **argv )
+{
+	log( "Horde3D PackBuilder - 1.0.0" );
+	log( "" );
+
+	if( argc < 3 || argv[1][0] == '-' || argv[2][0] == '-' )
+	{
+		printHelp();
+		return 1;
+	}
+
+	string basePath = argv[1], outFileName = argv[2];
+	replace( basePath.begin(), basePath.end(), '\\', '/' );
+	if( !basePath.empty() && basePath[basePath.length() - 1] != '/' ) basePath += '/';
+
+	// Already compressed formats gain nothing from compression and are better used directly from the mapping
+	vector< string > storeExtensions;
+	storeExtensions.push_back( ".dds" );
+	storeExtensions.push_back( ".ktx" );
+	storeExtensions.push_back( ".jpg" );
+	storeExtensions.push_back( ".png" );
+	bool compression = true;
+	float minSaving = 0.15f;
+
+	for( int i = 3; i < argc; ++i )
+	{
+		if( _stricmp( argv[i], "-store" ) == 0 && argc > i + 1 )
+		{
+			storeExtensions.clear();
+			string list = argv[++i];
+			size_t start = 0;
+			while( start <= list.length() )
+			{
+				size_t end = list.find( ',', start );
+				if( end == string::npos ) end = list.length();
+				string ext = list.substr( start, end - start );
+				if( !ext.empty() ) storeExtensions.push_back( ext[0] == '.' ? ext : "." + ext );
+				start = end + 1;
+			}
+		}
+		else if( _stricmp( argv[i], "-noCompression" ) == 0 )
+		{
+			compression = false;
+		}
+		else if( _stricmp( argv[i], "-minSaving" ) == 0 && argc > i + 1 )
+		{
+			minSaving = (float)atof( argv[++i] ) / 100.0f;
+		}
+		else
+		{
+			log( "Invalid argument " + string( argv[i] ) );
+			printHelp();
+			return 1;
+		}
+	}
+
+	vector< string > fileList;
+	createFileList( basePath, "", fileList );
+	if( fileList.empty() )
+	{
+		log( "No files found in " + basePath );
+		return 1;
+	}
+
+	FILE *outFile = fopen( outFileName.c_str(), "wb" );
+	if( outFile == 0x0 )
+	{
+		log( "Failed to open " + outFileName + " for writing" );
+		return 1;
+	}
+
+	// Header is written again when the index offsets are known
+	uint8 headerBuf[PackHeaderSize] = { 0 };
+	fwrite( headerBuf, 1, PackHeaderSize, outFile );
+	uint64 offset = PackHeaderSize;
+
+	vector< PackFile > packFiles;
+	vector< uint8 > data, compressed;
+	uint64 totalSize = 0, totalStored = 0;
+	string names;
+
+	for( size_t i = 0; i < fileList.size(); ++i )
+	{
+		if( basePath + fileList[i] == outFileName ) continue;
+
+		if( !readFile( basePath + fileList[i], data ) || data.size() > 0xFFFFFFFFu )
+		{
+			log( "Failed to read " + fileList[i] );
+			fclose( outFile );
+			return 1;
+		}
+
+		PackFile file;
+		file.name = packNormalizeName( fileList[i].c_str() );
+		file.entry.nameHash = packHashName( file.name );
+		file.entry.size = (uint32)data.size();
+		file.entry.compression = PackCompression::None;
+		file.entry.nameOffset = (uint32)names.length();
+		file.entry.nameLength = (uint32)file.name.length();
+		names += file.name;
+
+		const uint8 *storedData = data.empty() ? 0x0 : &data[0];
+		file.entry.storedSize = file.entry.size;
+
+		if( compression && !data.empty() && !hasExtension( file.name, storeExtensions ) )
+		{
+			packLZCompress( &data[0], data.size(), compressed );
+			if( compressed.size() <= data.size() * (1.0f - minSaving) )
+			{
+				file.entry.compression = PackCompression::LZ;
+				file.entry.storedSize = (uint32)compressed.size();
+				storedData = &compressed[0];
+			}
+		}
+
+		// Align data so that uncompressed entries can be used in place
+		static const uint8 padding[PackDataAlignment] = { 0 };
+		uint64 padSize = (PackDataAlignment - offset % PackDataAlignment) % PackDataAlignment;
+		fwrite( padding, 1, (size_t)padSize, outFile );
+		offset += padSize;
+
+		file.entry.dataOffset = offset;
+		if( file.entry.storedSize > 0 ) fwrite( storedData, 1, file.entry.storedSize, outFile );
+		offset += file.entry.storedSize;
+
+		totalSize += file.entry.size;
+		totalStored += file.entry.storedSize;
+		packFiles.push_back( file );
+	}
+
+	// Index sorted by name hash for binary search
+	sort( packFiles.begin(), packFiles.end(), lessByHash );
+
+	PackHeader header;
+	header.version = PackVersion;
+	header.numEntries = (uint32)packFiles.size();
+	header.indexOffset = offset;
+	header.namesOffset = offset + (uint64)packFiles.size() * PackEntrySize;
+
+	vector< uint8 > index( packFiles.size() * PackEntrySize );
+	for( size_t i = 0; i < packFiles.size(); ++i )
+		packFiles[i].entry.write( &index[i * PackEntrySize] );
+	if( !index.empty() ) fwrite( &index[0], 1, index.size(), outFile );
+	fwrite( names.data(), 1, names.length(), outFile );
+
+	header.write( headerBuf );
+	fseek( outFile, 0, SEEK_SET );
+	fwrite( headerBuf, 1, PackHeaderSize, outFile );
+
+	bool result = ferror( outFile ) == 0;
+	result &= fclose( outFile ) == 0;
+	if( !result )
+	{
+		log( "Failed to write " + outFileName );
+		return 1;
+	}
+
+	char buf[256];
+	snprintf( buf, sizeof( buf ), "Packed %u files, %.2f MB -> %.2f MB", header.numEntries,
+	          totalSize / (1024.0 * 1024.0), totalStored / (1024.0 * 1024.0) );
+	log( buf );
+
+	return 0;
+}
@@ -28,6 +28,20 @@
 
 #include <cmath>
 
+// SIMD implementation of performance critical functions, can be disabled by defining H3D_MATH_NO_SIMD
+#ifndef H3D_MATH_NO_SIMD
+#	if defined( __SSE__ ) || defined( _M_X64 ) || defined( _M_AMD64 ) || (defined( _M_IX86_FP ) && _M_IX86_FP >= 1)
+#		define H3D_MATH_SSE
+#		include <xmmintrin.h>
+#	elif defined( __ARM_NEON ) || defined( __ARM_NEON__ )
+#		define H3D_MATH_NEON
+#		include <arm_neon.h>
+#	endif
+#endif
+#if defined( H3D_MATH_SSE ) || defined( H3D_MATH_NEON )
+#	define H3D_MATH_SIMD
+#endif
+
 
 namespace Horde3D {
 
@@ -132,6 +146,205 @@ inline int ftoi_r( double val )
 }
 
 
+// -------------------------------------------------------------------------------------------------
+// SIMD
+// -------------------------------------------------------------------------------------------------
+
+#ifdef H3D_MATH_SIMD
+
+// Thin wrapper around the 4-wide float instructions of the target, so that the math functions
+// are written only once. Loads and stores are unaligned, aligned data is just faster to access.
+namespace Simd
+{
+#if defined( H3D_MATH_SSE )
+	typedef __m128 Vec;
+
+	inline Vec load( const float *ptr ) { return _mm_loadu_ps( ptr ); }
+	inline void store( float *ptr, Vec v ) { _mm_storeu_ps( ptr, v ); }
+	inline Vec set( float x, float y, float z, float w ) { return _mm_setr_ps( x, y, z, w ); }
+	inline Vec splat( float f ) { return _mm_set1_ps( f ); }
+	inline Vec zero() { return _mm_setzero_ps(); }
+	inline float getX( Vec v ) { return _mm_cvtss_f32( v ); }
+
+	inline Vec add( Vec a, Vec b ) { return _mm_add_ps( a, b ); }
+	inline Vec sub( Vec a, Vec b ) { return _mm_sub_ps( a, b ); }
+	inline Vec mul( Vec a, Vec b ) { return _mm_mul_ps( a, b ); }
+	inline Vec div( Vec a, Vec b ) { return _mm_div_ps( a, b ); }
+	inline Vec sqrt( Vec v ) { return _mm_sqrt_ps( v ); }
+
+	// Returns ( a[i0], a[i1], b[i2], b[i3] )
+	template< int i0, int i1, int i2, int i3 > inline Vec shuffle( Vec a, Vec b )
+	{
+		return _mm_shuffle_ps( a, b, _MM_SHUFFLE( i3, i2, i1, i0 ) );
+	}
+
+	inline Vec cmpLE( Vec a, Vec b ) { return _mm_cmple_ps( a, b ); }
+	inline Vec cmpGT( Vec a, Vec b ) { return _mm_cmpgt_ps( a, b ); }
+	inline Vec select( Vec mask, Vec a, Vec b ) { return _mm_or_ps( _mm_and_ps( mask, a ), _mm_andnot_ps( mask, b ) ); }
+	inline Vec orMask( Vec a, Vec b ) { return _mm_or_ps( a, b ); }
+	inline bool anyTrue( Vec mask ) { return _mm_movemask_ps( mask ) != 0; }
+	inline int moveMask( Vec mask ) { return _mm_movemask_ps( mask ); }  // Bit i is set if lane i is true
+
+#elif defined( H3D_MATH_NEON )
+	typedef float32x4_t Vec;
+
+	inline Vec load( const float *ptr ) { return vld1q_f32( ptr ); }
+	inline void store( float *ptr, Vec v ) { vst1q_f32( ptr, v ); }
+	inline Vec set( float x, float y, float z, float w ) { float f[4] = { x, y, z, w }; return vld1q_f32( f ); }
+	inline Vec splat( float f ) { return vdupq_n_f32( f ); }
+	inline Vec zero() { return vdupq_n_f32( 0 ); }
+	inline float getX( Vec v ) { return vgetq_lane_f32( v, 0 ); }
+
+	inline Vec add( Vec a, Vec b ) { return vaddq_f32( a, b ); }
+	inline Vec sub( Vec a, Vec b ) { return vsubq_f32( a, b ); }
+	inline Vec mul( Vec a, Vec b ) { return vmulq_f32( a, b ); }
+#if defined( __aarch64__ )
+	inline Vec div( Vec a, Vec b ) { return vdivq_f32( a, b ); }
+	inline Vec sqrt( Vec v ) { return vsqrtq_f32( v ); }
+#else
+	inline Vec div( Vec a, Vec b )
+	{
+		// Reciprocal estimate refined with two Newton-Raphson steps
+		Vec r = vrecpeq_f32( b );
+		r = vmulq_f32( vrecpsq_f32( b, r ), r );
+		r = vmulq_f32( vrecpsq_f32( b, r ), r );
+		return vmulq_f32( a, r );
+	}
+	inline Vec sqrt( Vec v )
+	{
+		float f[4];
+		vst1q_f32( f, v );
+		return set( sqrtf( f[0] ), sqrtf( f[1] ), sqrtf( f[2] ), sqrtf( f[3] ) );
+	}
+#endif
+
+	// Returns ( a[i0], a[i1], b[i2], b[i3] )
+	template< int i0, int i1, int i2, int i3 > inline Vec shuffle( Vec a, Vec b )
+	{
+		return set( vgetq_lane_f32( a, i0 ), vgetq_lane_f32( a, i1 ), vgetq_lane_f32( b, i2 ), vgetq_lane_f32( b, i3 ) );
+	}
+
+	inline Vec cmpLE( Vec a, Vec b ) { return vreinterpretq_f32_u32( vcleq_f32( a, b ) ); }
+	inline Vec cmpGT( Vec a, Vec b ) { return vreinterpretq_f32_u32( vcgtq_f32( a, b ) ); }
+	inline Vec select( Vec mask, Vec a, Vec b ) { return vbslq_f32( vreinterpretq_u32_f32( mask ), a, b ); }
+	inline Vec orMask( Vec a, Vec b )
+	{
+		return vreinterpretq_f32_u32( vorrq_u32( vreinterpretq_u32_f32( a ), vreinterpretq_u32_f32( b ) ) );
+	}
+	inline bool anyTrue( Vec mask )
+	{
+		uint32x4_t m = vreinterpretq_u32_f32( mask );
+		uint32x2_t r = vorr_u32( vget_low_u32( m ), vget_high_u32( m ) );
+		return (vget_lane_u32( r, 0 ) | vget_lane_u32( r, 1 )) != 0;
+	}
+	inline int moveMask( Vec mask )
+	{
+		uint32x4_t m = vreinterpretq_u32_f32( mask );
+		return (vgetq_lane_u32( m, 0 ) >> 31) | ((vgetq_lane_u32( m, 1 ) >> 31) << 1) |
+		       ((vgetq_lane_u32( m, 2 ) >> 31) << 2) | ((vgetq_lane_u32( m, 3 ) >> 31) << 3);
+	}
+#endif
+
+	template< int i0, int i1, int i2, int i3 > inline Vec swizzle( Vec v ) { return shuffle< i0, i1, i2, i3 >( v, v ); }
+	inline Vec madd( Vec a, Vec b, Vec c ) { return add( mul( a, b ), c ); }
+
+	inline Vec dot4( Vec a, Vec b )
+	{
+		// Result in all components
+		Vec m = mul( a, b );
+		m = add( m, swizzle< 2, 3, 0, 1 >( m ) );
+		return add( m, swizzle< 1, 0, 3, 2 >( m ) );
+	}
+
+	inline Vec transform( const float *m, float x, float y, float z, float w )
+	{
+		// Column major 4x4 matrix times vector; the vector is passed as scalars since vectors are
+		// usually written component-wise right before, which would stall a vector load
+		Vec r = mul( load( m ), splat( x ) );
+		r = madd( load( m + 4 ), splat( y ), r );
+		r = madd( load( m + 8 ), splat( z ), r );
+		return madd( load( m + 12 ), splat( w ), r );
+	}
+
+	inline Vec transformPoint( const float *m, float x, float y, float z )
+	{
+		Vec r = madd( load( m ), splat( x ), load( m + 12 ) );
+		r = madd( load( m + 4 ), splat( y ), r );
+		return madd( load( m + 8 ), splat( z ), r );
+	}
+
+	inline Vec transformVector( const float *m, float x, float y, float z )
+	{
+		Vec r = mul( load( m ), splat( x ) );
+		r = madd( load( m + 4 ), splat( y ), r );
+		return madd( load( m + 8 ), splat( z ), r );
+	}
+
+	// 2x2 matrix helpers for the block-wise inverse, a 2x2 matrix is stored as ( m00, m01, m10, m11 )
+	inline Vec mat2Mul( Vec a, Vec b )
+	{
+		return add( mul( a, swizzle< 0, 3, 0, 3 >( b ) ), mul( swizzle< 1, 0, 3, 2 >( a ), swizzle< 2, 1, 2, 1 >( b ) ) );
+	}
+
+	inline Vec mat2AdjMul( Vec a, Vec b )
+	{
+		// adj( a ) * b
+		return sub( mul( swizzle< 3, 3, 0, 0 >( a ), b ), mul( swizzle< 1, 1, 2, 2 >( a ), swizzle< 2, 3, 0, 1 >( b ) ) );
+	}
+
+	inline Vec mat2MulAdj( Vec a, Vec b )
+	{
+		// a * adj( b )
+		return sub( mul( a, swizzle< 3, 0, 3, 0 >( b ) ), mul( swizzle< 1, 0, 3, 2 >( a ), swizzle< 2, 1, 2, 1 >( b ) ) );
+	}
+
+	inline bool invert( float *dst, const float *src )
+	{
+		// Block-wise inverse using 2x2 sub-matrices A, B, C, D. Inverting the transpose yields the
+		// transposed inverse, so the column major layout can be processed as if it was row major.
+		Vec r0 = load( src ), r1 = load( src + 4 ), r2 = load( src + 8 ), r3 = load( src + 12 );
+		Vec a = shuffle< 0, 1, 0, 1 >( r0, r1 );
+		Vec b = shuffle< 2, 3, 2, 3 >( r0, r1 );
+		Vec c = shuffle< 0, 1, 0, 1 >( r2, r3 );
+		Vec d = shuffle< 2, 3, 2, 3 >( r2, r3 );
+
+		// Determinants of sub-matrices ( |A|, |B|, |C|, |D| )
+		Vec detSub = sub( mul( shuffle< 0, 2, 0, 2 >( r0, r2 ), shuffle< 1, 3, 1, 3 >( r1, r3 ) ),
+		                  mul( shuffle< 1, 3, 1, 3 >( r0, r2 ), shuffle< 0, 2, 0, 2 >( r1, r3 ) ) );
+		Vec detA = swizzle< 0, 0, 0, 0 >( detSub ), detB = swizzle< 1, 1, 1, 1 >( detSub );
+		Vec detC = swizzle< 2, 2, 2, 2 >( detSub ), detD = swizzle< 3, 3, 3, 3 >( detSub );
+
+		Vec dc = mat2AdjMul( d, c );
+		Vec ab = mat2AdjMul( a, b );
+		Vec x = sub( mul( detD, a ), mat2Mul( b, dc ) );
+		Vec w = sub( mul( detA, d ), mat2Mul( c, ab ) );
+		Vec y = sub( mul( detB, c ), mat2MulAdj( d, ab ) );
+		Vec z = sub( mul( detC, b ), mat2MulAdj( a, dc ) );
+
+		// |M| = |A| * |D| + |B| * |C| - tr( adj( A ) * B * adj( D ) * C )
+		Vec detM = add( mul( detA, detD ), mul( detB, detC ) );
+		detM = sub( detM, dot4( ab, swizzle< 0, 2, 1, 3 >( dc ) ) );
+		if( getX( detM ) == 0 ) return false;
+
+		Vec rDetM = div( set( 1, -1, -1, 1 ), detM );
+		x = mul( x, rDetM );
+		y = mul( y, rDetM );
+		z = mul( z, rDetM );
+		w = mul( w, rDetM );
+
+		// Adjugate of the blocks combined with reordering to rows
+		store( dst, shuffle< 3, 1, 3, 1 >( x, y ) );
+		store( dst + 4, shuffle< 2, 0, 2, 0 >( x, y ) );
+		store( dst + 8, shuffle< 3, 1, 3, 1 >( z, w ) );
+		store( dst + 12, shuffle< 2, 0, 2, 0 >( z, w ) );
+
+		return true;
+	}
+}
+
+#endif
+
+
 // -------------------------------------------------------------------------------------------------
 // Vector
 // -------------------------------------------------------------------------------------------------
@@ -435,7 +648,7 @@ public:
 };
 
 
-class Vec4f
+class alignas( 16 ) Vec4f
 {
 public:
 	
@@ -525,11 +738,26 @@ public:
 	// ---------------------
 	Quaternion operator*( const Quaternion &q ) const
 	{
+#ifdef H3D_MATH_SIMD
+		using namespace Simd;
+		Vec a = load( &x ), b = load( &q.x );
+		Vec sign = set( 1, 1, 1, -1 );
+		
+		Vec r = mul( swizzle< 3, 3, 3, 3 >( a ), b );
+		r = madd( mul( swizzle< 0, 1, 2, 0 >( a ), swizzle< 3, 3, 3, 0 >( b ) ), sign, r );
+		r = madd( mul( swizzle< 1, 2, 0, 1 >( a ), swizzle< 2, 0, 1, 1 >( b ) ), sign, r );
+		r = sub( r, mul( swizzle< 2, 0, 1, 2 >( a ), swizzle< 1, 2, 0, 2 >( b ) ) );
+
+		Quaternion result;
+		store( &result.x, r );
+		return result;
+#else
 		return Quaternion(
 			y * q.z - z * q.y + q.x * w + x * q.w,
 			z * q.x - x * q.z + q.y * w + y * q.w,
 			x * q.y - y * q.x + q.z * w + z * q.w,
 			w * q.w - (x * q.x + y * q.y + z * q.z) );
+#endif
 	}
 
 	Quaternion &operator*=( const Quaternion &q )
@@ -582,6 +810,18 @@ public:
 		// Normalized linear quaternion interpolation
 		// Note: NLERP is faster than SLERP and commutative but does not yield constant velocity
 
+#ifdef H3D_MATH_SIMD
+		using namespace Simd;
+		Vec a = load( &x ), b = load( &q.x );
+
+		// Use the shortest path and interpolate linearly
+		if( getX( dot4( a, b ) ) < 0 ) b = sub( zero(), b );
+		Vec qt = madd( sub( b, a ), splat( t ), a );
+
+		Quaternion result;
+		store( &result.x, div( qt, sqrt( dot4( qt, qt ) ) ) );
+		return result;
+#else
 		Quaternion qt;
 		float cosTheta = x * q.x + y * q.y + z * q.z + w * q.w;
 		
@@ -596,6 +836,7 @@ public:
 		// Return normalized quaternion
 		float invLen = 1.0f / sqrtf( qt.x * qt.x + qt.y * qt.y + qt.z * qt.z + qt.w * qt.w );
 		return Quaternion( qt.x * invLen, qt.y * invLen, qt.z * invLen, qt.w * invLen );
+#endif
 	}
 
 	Quaternion inverted() const
@@ -615,7 +856,7 @@ public:
 // Matrix
 // -------------------------------------------------------------------------------------------------
 
-class Matrix4f
+class alignas( 16 ) Matrix4f
 {
 public:
 	
@@ -696,6 +937,19 @@ public:
 	{
 		// Note: dst may not be the same as m1 or m2
 
+#ifdef H3D_MATH_SIMD
+		using namespace Simd;
+		Vec col0 = load( m1.x ), col1 = load( m1.x + 4 ), col2 = load( m1.x + 8 );
+		for( int i = 0; i < 3; ++i )
+		{
+			const float *m2x = m2.x + i * 4;
+			store( dst.x + i * 4, madd( col2, splat( m2x[2] ), madd( col1, splat( m2x[1] ), mul( col0, splat( m2x[0] ) ) ) ) );
+		}
+		store( dst.x + 12, madd( load( m1.x + 12 ), splat( m2.x[15] ), madd( col2, splat( m2.x[14] ),
+		       madd( col1, splat( m2.x[13] ), mul( col0, splat( m2.x[12] ) ) ) ) ) );
+		
+		dst.x[3] = 0.0f; dst.x[7] = 0.0f; dst.x[11] = 0.0f; dst.x[15] = 1.0f;
+#else
 		float *dstx = dst.x;
 		const float *m1x = m1.x;
 		const float *m2x = m2.x;
@@ -719,6 +973,7 @@ public:
 		dstx[13] = m1x[1] * m2x[12] + m1x[5] * m2x[13] + m1x[9] * m2x[14] + m1x[13] * m2x[15];
 		dstx[14] = m1x[2] * m2x[12] + m1x[6] * m2x[13] + m1x[10] * m2x[14] + m1x[14] * m2x[15];
 		dstx[15] = 1.0f;
+#endif
 	}
 
 	// ------------
@@ -750,6 +1005,19 @@ public:
 
 	Matrix4f( const Quaternion &q )
 	{
+#ifdef H3D_MATH_SIMD
+		using namespace Simd;
+		Vec v = load( &q.x ), v2 = add( v, v );
+
+		// Products like in the scalar version arranged per column, w component is masked by the sign
+		store( x, madd( mul( swizzle< 1, 0, 0, 0 >( v ), swizzle< 1, 1, 2, 0 >( v2 ) ), set( -1, 1, 1, 0 ),
+		       madd( mul( swizzle< 2, 3, 3, 0 >( v ), swizzle< 2, 2, 1, 0 >( v2 ) ), set( -1, 1, -1, 0 ), set( 1, 0, 0, 0 ) ) ) );
+		store( x + 4, madd( mul( swizzle< 0, 0, 1, 0 >( v ), swizzle< 1, 0, 2, 0 >( v2 ) ), set( 1, -1, 1, 0 ),
+		       madd( mul( swizzle< 3, 2, 3, 0 >( v ), swizzle< 2, 2, 0, 0 >( v2 ) ), set( -1, -1, 1, 0 ), set( 0, 1, 0, 0 ) ) ) );
+		store( x + 8, madd( mul( swizzle< 0, 1, 0, 0 >( v ), swizzle< 2, 2, 0, 0 >( v2 ) ), set( 1, 1, -1, 0 ),
+		       madd( mul( swizzle< 3, 3, 1, 0 >( v ), swizzle< 1, 0, 1, 0 >( v2 ) ), set( 1, -1, -1, 0 ), set( 0, 0, 1, 0 ) ) ) );
+		store( x + 12, set( 0, 0, 0, 1 ) );
+#else
 		// Calculate coefficients
 		float x2 = q.x + q.x, y2 = q.y + q.y, z2 = q.z + q.z;
 		float xx = q.x * x2,  xy = q.x * y2,  xz = q.x * z2;
@@ -764,6 +1032,7 @@ public:
 		c[2][2] = 1 - (xx + yy);  c[3][2] = 0;
 		c[0][3] = 0;              c[1][3] = 0;
 		c[2][3] = 0;              c[3][3] = 1;
+#endif
 	}
 
 	// ----------
@@ -805,6 +1074,16 @@ public:
 	{
 		Matrix4f mf( Math::NO_INIT );
 		
+#ifdef H3D_MATH_SIMD
+		using namespace Simd;
+		Vec col0 = load( x ), col1 = load( x + 4 ), col2 = load( x + 8 ), col3 = load( x + 12 );
+		for( int i = 0; i < 4; ++i )
+		{
+			const float *mx = m.x + i * 4;
+			store( mf.x + i * 4, madd( col3, splat( mx[3] ), madd( col2, splat( mx[2] ),
+			       madd( col1, splat( mx[1] ), mul( col0, splat( mx[0] ) ) ) ) ) );
+		}
+#else
 		mf.x[0] = x[0] * m.x[0] + x[4] * m.x[1] + x[8] * m.x[2] + x[12] * m.x[3];
 		mf.x[1] = x[1] * m.x[0] + x[5] * m.x[1] + x[9] * m.x[2] + x[13] * m.x[3];
 		mf.x[2] = x[2] * m.x[0] + x[6] * m.x[1] + x[10] * m.x[2] + x[14] * m.x[3];
@@ -824,6 +1103,7 @@ public:
 		mf.x[13] = x[1] * m.x[12] + x[5] * m.x[13] + x[9] * m.x[14] + x[13] * m.x[15];
 		mf.x[14] = x[2] * m.x[12] + x[6] * m.x[13] + x[10] * m.x[14] + x[14] * m.x[15];
 		mf.x[15] = x[3] * m.x[12] + x[7] * m.x[13] + x[11] * m.x[14] + x[15] * m.x[15];
+#endif
 
 		return mf;
 	}
@@ -845,24 +1125,42 @@ public:
 	// ----------------------------
 	Vec3f operator*( const Vec3f &v ) const
 	{
+#ifdef H3D_MATH_SIMD
+		Vec4f r;
+		Simd::store( &r.x, Simd::transformPoint( x, v.x, v.y, v.z ) );
+		return Vec3f( r.x, r.y, r.z );
+#else
 		return Vec3f( v.x * c[0][0] + v.y * c[1][0] + v.z * c[2][0] + c[3][0],
 		              v.x * c[0][1] + v.y * c[1][1] + v.z * c[2][1] + c[3][1],
 		              v.x * c[0][2] + v.y * c[1][2] + v.z * c[2][2] + c[3][2] );
+#endif
 	}
 
 	Vec4f operator*( const Vec4f &v ) const
 	{
+#ifdef H3D_MATH_SIMD
+		Vec4f r;
+		Simd::store( &r.x, Simd::transform( x, v.x, v.y, v.z, v.w ) );
+		return r;
+#else
 		return Vec4f( v.x * c[0][0] + v.y * c[1][0] + v.z * c[2][0] + v.w * c[3][0],
 		              v.x * c[0][1] + v.y * c[1][1] + v.z * c[2][1] + v.w * c[3][1],
 		              v.x * c[0][2] + v.y * c[1][2] + v.z * c[2][2] + v.w * c[3][2],
 		              v.x * c[0][3] + v.y * c[1][3] + v.z * c[2][3] + v.w * c[3][3] );
+#endif
 	}
 
 	Vec3f mult33Vec( const Vec3f &v ) const
 	{
+#ifdef H3D_MATH_SIMD
+		Vec4f r;
+		Simd::store( &r.x, Simd::transformVector( x, v.x, v.y, v.z ) );
+		return Vec3f( r.x, r.y, r.z );
+#else
 		return Vec3f( v.x * c[0][0] + v.y * c[1][0] + v.z * c[2][0],
 		              v.x * c[0][1] + v.y * c[1][1] + v.z * c[2][1],
 		              v.x * c[0][2] + v.y * c[1][2] + v.z * c[2][2] );
+#endif
 	}
 	
 	// ---------------
@@ -919,6 +1217,9 @@ public:
 	{
 		Matrix4f m( Math::NO_INIT );
 
+#ifdef H3D_MATH_SIMD
+		Simd::invert( m.x, x );
+#else
 		float d = determinant();
 		if( d == 0 ) return m;
 		d = 1.0f / d;
@@ -939,6 +1240,7 @@ public:
 		m.c[3][1] = d * (c[0][1]*c[2][2]*c[3][0] - c[0][2]*c[2][1]*c[3][0] + c[0][2]*c[2][0]*c[3][1] - c[0][0]*c[2][2]*c[3][1] - c[0][1]*c[2][0]*c[3][2] + c[0][0]*c[2][1]*c[3][2]);
 		m.c[3][2] = d * (c[0][2]*c[1][1]*c[3][0] - c[0][1]*c[1][2]*c[3][0] - c[0][2]*c[1][0]*c[3][1] + c[0][0]*c[1][2]*c[3][1] + c[0][1]*c[1][0]*c[3][2] - c[0][0]*c[1][1]*c[3][2]);
 		m.c[3][3] = d * (c[0][1]*c[1][2]*c[2][0] - c[0][2]*c[1][1]*c[2][0] + c[0][2]*c[1][0]*c[2][1] - c[0][0]*c[1][2]*c[2][1] - c[0][1]*c[1][0]*c[2][2] + c[0][0]*c[1][1]*c[2][2]);
+#endif
 		
 		return m;
 	}
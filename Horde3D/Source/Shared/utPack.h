@@ -0,0 +1,342 @@
+// *************************************************************************************************
+//
+// Horde3D
+//   Next-Generation Graphics Engine
+// --------------------------------------
+// Copyright (C) 2006-2021 Nicolas Schulz and Horde3D team
+//
+// This software is distributed under the terms of the Eclipse Public License v1.0.
+// A copy of the license may be obtained at: http://www.eclipse.org/legal/epl-v10.html
+//
+// *************************************************************************************************
+
+#ifndef _utPack_H_
+#define _utPack_H_
+
+#include "utPlatform.h"
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Pack files are indexed archives of resource files. The layout is (all values little endian):
+//
+//   PackHeader
+//   file data, each entry aligned to PackDataAlignment
+//   PackEntry[numEntries], sorted by nameHash
+//   names, not null-terminated
+//
+// Entries are either stored uncompressed, so that they can be used directly from a memory mapping,
+// or compressed with an LZ4 style block compression.
+
+
+namespace Horde3D {
+
+const char PackMagic[8] = { 'H', '3', 'D', 'P', 'A', 'C', 'K', '\0' };
+const uint32 PackVersion = 1;
+const uint32 PackHeaderSize = 32;
+const uint32 PackEntrySize = 40;
+const uint32 PackDataAlignment = 16;
+
+struct PackCompression
+{
+	enum List
+	{
+		None = 0,
+		LZ = 1
+	};
+};
+
+// =================================================================================================
+// Pack index
+// =================================================================================================
+
+inline uint32 packReadU32( const uint8 *ptr )
+{
+	return (uint32)ptr[0] | ((uint32)ptr[1] << 8) | ((uint32)ptr[2] << 16) | ((uint32)ptr[3] << 24);
+}
+
+inline uint64 packReadU64( const uint8 *ptr )
+{
+	return (uint64)packReadU32( ptr ) | ((uint64)packReadU32( ptr + 4 ) << 32);
+}
+
+inline void packWriteU32( uint8 *ptr, uint32 value )
+{
+	for( int i = 0; i < 4; ++i ) ptr[i] = (uint8)(value >> (i * 8));
+}
+
+inline void packWriteU64( uint8 *ptr, uint64 value )
+{
+	packWriteU32( ptr, (uint32)value );
+	packWriteU32( ptr + 4, (uint32)(value >> 32) );
+}
+
+
+struct PackHeader
+{
+	uint32  version;
+	uint32  numEntries;
+	uint64  indexOffset;
+	uint64  namesOffset;
+
+	bool read( const uint8 *data, size_t size )
+	{
+		if( size < PackHeaderSize || memcmp( data, PackMagic, 8 ) != 0 ) return false;
+		version = packReadU32( data + 8 );
+		numEntries = packReadU32( data + 12 );
+		indexOffset = packReadU64( data + 16 );
+		namesOffset = packReadU64( data + 24 );
+
+		return version == PackVersion && indexOffset <= size &&
+		       (size - indexOffset) / PackEntrySize >= numEntries && namesOffset <= size;
+	}
+
+	void write( uint8 *data ) const
+	{
+		memcpy( data, PackMagic, 8 );
+		packWriteU32( data + 8, version );
+		packWriteU32( data + 12, numEntries );
+		packWriteU64( data + 16, indexOffset );
+		packWriteU64( data + 24, namesOffset );
+	}
+};
+
+
+struct PackEntry
+{
+	uint64  nameHash;
+	uint64  dataOffset;
+	uint32  storedSize;   // Size in pack file
+	uint32  size;         // Uncompressed size
+	uint32  nameOffset;   // Relative to names section
+	uint32  nameLength;
+	uint32  compression;
+
+	void read( const uint8 *data )
+	{
+		nameHash = packReadU64( data );
+		dataOffset = packReadU64( data + 8 );
+		storedSize = packReadU32( data + 16 );
+		size = packReadU32( data + 20 );
+		nameOffset = packReadU32( data + 24 );
+		nameLength = packReadU32( data + 28 );
+		compression = packReadU32( data + 32 );
+	}
+
+	void write( uint8 *data ) const
+	{
+		packWriteU64( data, nameHash );
+		packWriteU64( data + 8, dataOffset );
+		packWriteU32( data + 16, storedSize );
+		packWriteU32( data + 20, size );
+		packWriteU32( data + 24, nameOffset );
+		packWriteU32( data + 28, nameLength );
+		packWriteU32( data + 32, compression );
+		packWriteU32( data + 36, 0 );
+	}
+};
+
+
+inline std::string packNormalizeName( const char *name )
+{
+	// Forward slashes only, no duplicate or leading slashes
+	std::string result;
+	for( const char *c = name; *c != '\0'; ++c )
+	{
+		char ch = *c == '\\' ? '/' : *c;
+		if( ch == '/' && (result.empty() || result[result.length() - 1] == '/') ) continue;
+		result += ch;
+	}
+
+	return result;
+}
+
+
+inline uint64 packHashName( const std::string &name )
+{
+	// FNV-1a
+	uint64 hash = 14695981039346656037ull;
+	for( size_t i = 0; i < name.length(); ++i )
+	{
+		hash ^= (uint8)name[i];
+		hash *= 1099511628211ull;
+	}
+
+	return hash;
+}
+
+
+inline bool packFindEntry( const uint8 *data, size_t size, const PackHeader &header, const std::string &name,
+                           PackEntry &entry )
+{
+	// Binary search in index sorted by hash; entries with equal hash are disambiguated by name
+	uint64 hash = packHashName( name );
+	const uint8 *index = data + header.indexOffset;
+
+	uint32 first = 0, count = header.numEntries;
+	while( count > 0 )
+	{
+		uint32 step = count / 2;
+		if( packReadU64( index + (size_t)(first + step) * PackEntrySize ) < hash )
+		{
+			first += step + 1;
+			count -= step + 1;
+		}
+		else count = step;
+	}
+
+	for( ; first < header.numEntries; ++first )
+	{
+		entry.read( index + (size_t)first * PackEntrySize );
+		if( entry.nameHash != hash ) break;
+
+		if( header.namesOffset + entry.nameOffset + entry.nameLength <= size &&
+		    entry.nameLength == name.length() &&
+		    memcmp( data + header.namesOffset + entry.nameOffset, name.c_str(), name.length() ) == 0 )
+		{
+			// Uncompressed entries are used directly from the mapping with their uncompressed size
+			if( entry.compression == PackCompression::None && entry.size != entry.storedSize ) return false;
+			if( entry.compression != PackCompression::None && entry.compression != PackCompression::LZ ) return false;
+
+			return entry.dataOffset <= size && entry.storedSize <= size - entry.dataOffset;
+		}
+	}
+
+	return false;
+}
+
+
+// =================================================================================================
+// LZ block compression
+// =================================================================================================
+
+// Byte oriented LZ77 compression using the LZ4 block format: sequences of a token (literal length
+// in high nibble, match length - 4 in low nibble), optional length extension bytes, literals and a
+// 16 bit match offset. Fast to decode and good enough for text resources like XML and shaders.
+
+const int PackLZMinMatch = 4;
+const int PackLZHashBits = 14;
+const int PackLZMaxOffset = 65535;
+const int PackLZLastLiterals = 5;
+
+inline void packLZWriteLength( std::vector< uint8 > &out, size_t length )
+{
+	while( length >= 255 )
+	{
+		out.push_back( 255 );
+		length -= 255;
+	}
+	out.push_back( (uint8)length );
+}
+
+
+inline void packLZCompress( const uint8 *src, size_t size, std::vector< uint8 > &out )
+{
+	out.clear();
+	out.reserve( size + size / 255 + 16 );
+
+	std::vector< uint32 > table( (size_t)1 << PackLZHashBits, 0xFFFFFFFF );
+	size_t pos = 0, anchor = 0;
+	size_t matchLimit = size > PackLZLastLiterals ? size - PackLZLastLiterals : 0;
+
+	while( pos + PackLZMinMatch <= matchLimit )
+	{
+		uint32 seq;
+		memcpy( &seq, src + pos, 4 );
+		uint32 h = (seq * 2654435761u) >> (32 - PackLZHashBits);
+		size_t candidate = table[h];
+		table[h] = (uint32)pos;
+
+		if( candidate == 0xFFFFFFFF || pos - candidate > PackLZMaxOffset ||
+		    memcmp( src + candidate, src + pos, 4 ) != 0 )
+		{
+			++pos;
+			continue;
+		}
+
+		size_t matchLen = PackLZMinMatch;
+		while( pos + matchLen < matchLimit && src[candidate + matchLen] == src[pos + matchLen] ) ++matchLen;
+
+		// Sequence
+		size_t litLen = pos - anchor;
+		size_t extraMatch = matchLen - PackLZMinMatch;
+		out.push_back( (uint8)((litLen < 15 ? litLen : 15) << 4 | (extraMatch < 15 ? extraMatch : 15)) );
+		if( litLen >= 15 ) packLZWriteLength( out, litLen - 15 );
+		out.insert( out.end(), src + anchor, src + pos );
+
+		size_t offset = pos - candidate;
+		out.push_back( (uint8)offset );
+		out.push_back( (uint8)(offset >> 8) );
+		if( extraMatch >= 15 ) packLZWriteLength( out, extraMatch - 15 );
+
+		pos += matchLen;
+		anchor = pos;
+	}
+
+	// Remaining literals
+	size_t litLen = size - anchor;
+	out.push_back( (uint8)((litLen < 15 ? litLen : 15) << 4) );
+	if( litLen >= 15 ) packLZWriteLength( out, litLen - 15 );
+	out.insert( out.end(), src + anchor, src + size );
+}
+
+
+inline bool packLZDecompress( const uint8 *src, size_t srcSize, uint8 *dst, size_t dstSize )
+{
+	const uint8 *srcEnd = src + srcSize;
+	uint8 *dstPos = dst, *dstEnd = dst + dstSize;
+
+	while( src < srcEnd )
+	{
+		uint8 token = *src++;
+
+		// Literals
+		size_t litLen = token >> 4;
+		if( litLen == 15 )
+		{
+			uint8 b;
+			do
+			{
+				if( src >= srcEnd ) return false;
+				b = *src++;
+				litLen += b;
+			} while( b == 255 );
+		}
+		if( litLen > (size_t)(srcEnd - src) || litLen > (size_t)(dstEnd - dstPos) ) return false;
+		memcpy( dstPos, src, litLen );
+		src += litLen;
+		dstPos += litLen;
+
+		if( src == srcEnd ) break;  // Last sequence has no match
+
+		// Match
+		if( srcEnd - src < 2 ) return false;
+		size_t offset = src[0] | ((size_t)src[1] << 8);
+		src += 2;
+		if( offset == 0 || offset > (size_t)(dstPos - dst) ) return false;
+
+		size_t matchLen = token & 15;
+		if( matchLen == 15 )
+		{
+			uint8 b;
+			do
+			{
+				if( src >= srcEnd ) return false;
+				b = *src++;
+				matchLen += b;
+			} while( b == 255 );
+		}
+		matchLen += PackLZMinMatch;
+		if( matchLen > (size_t)(dstEnd - dstPos) ) return false;
+
+		// Byte-wise copy since source and destination can overlap
+		const uint8 *matchPos = dstPos - offset;
+		for( size_t i = 0; i < matchLen; ++i ) dstPos[i] = matchPos[i];
+		dstPos += matchLen;
+	}
+
+	return dstPos == dstEnd;
+}
+
+}
+#endif // _utPack_H_
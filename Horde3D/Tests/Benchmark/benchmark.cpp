@@ -0,0 +1,382 @@
+// *************************************************************************************************
+//
+// Horde3D
+//   Next-Generation Graphics Engine
+// --------------------------------------
+// Copyright (C) 2006-2021 Nicolas Schulz and Horde3D team
+//
+// This software is distributed under the terms of the Eclipse Public License v1.0.
+// A copy of the license may be obtained at: http://www.eclipse.org/legal/epl-v10.html
+//
+// *************************************************************************************************
+
+#include "benchmark.h"
+#include "Horde3DUtils.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace std;
+
+namespace {
+
+const int ViewportWidth = 1280;
+const int ViewportHeight = 720;
+const float FrameDelta = 1.0f / 30.0f;
+const unsigned int RandomSeed = 99777;  // Same seed as the Chicago sample
+
+class WallTimer
+{
+public:
+	WallTimer() : _start( chrono::steady_clock::now() ) {}
+
+	double getElapsedMS() const
+	{
+		return chrono::duration< double, milli >( chrono::steady_clock::now() - _start ).count();
+	}
+
+private:
+	chrono::steady_clock::time_point  _start;
+};
+
+void resetEngineStats()
+{
+	for( int i = H3DStats::TriCount; i <= H3DStats::CullingTime; ++i )
+		h3dGetStat( (H3DStats::List)i, true );
+}
+
+}  // namespace
+
+
+// =================================================================================================
+// BenchResults
+// =================================================================================================
+
+void BenchResults::addMetric( const string &scenario, const string &name, double value )
+{
+	BenchMetric metric = { scenario, name, value };
+	metrics.push_back( metric );
+}
+
+
+void BenchResults::addCounter( const string &scenario, const string &name, long long value )
+{
+	BenchCounter counter = { scenario, name, value };
+	counters.push_back( counter );
+}
+
+
+// =================================================================================================
+// BenchScenes
+// =================================================================================================
+
+BenchScenes::BenchScenes( const BenchConfig &config, BenchResults &results ) :
+	_config( config ), _results( results ), _pipelineRes( 0 ), _sphereRes( 0 ), _characterRes( 0 ),
+	_walkAnimRes( 0 ), _particleSysRes( 0 ), _lightMatRes( 0 ), _cam( 0 )
+{
+}
+
+
+bool BenchScenes::loadContent( const string &contentDir )
+{
+	_pipelineRes = h3dAddResource( H3DResTypes::Pipeline, "pipelines/forward.pipeline.xml", 0 );
+	_sphereRes = h3dAddResource( H3DResTypes::SceneGraph, "models/sphere/sphere.scene.xml", 0 );
+	_characterRes = h3dAddResource( H3DResTypes::SceneGraph, "models/man/man.scene.xml", 0 );
+	_walkAnimRes = h3dAddResource( H3DResTypes::Animation, "animations/man.anim", 0 );
+	_particleSysRes = h3dAddResource( H3DResTypes::SceneGraph, "particles/particleSys1/particleSys1.scene.xml", 0 );
+	_lightMatRes = h3dAddResource( H3DResTypes::Material, "materials/light.material.xml", 0 );
+
+	WallTimer timer;
+	bool result = h3dutLoadResourcesFromDisk( contentDir.c_str() );
+	_results.addMetric( "load", "contentMs", timer.getElapsedMS() );
+
+	if( !result || !h3dIsResLoaded( _pipelineRes ) || !h3dIsResLoaded( _characterRes ) ) return false;
+
+	_cam = h3dAddCameraNode( H3DRootNode, "BenchCamera", _pipelineRes );
+	h3dSetNodeParamI( _cam, H3DCamera::ViewportXI, 0 );
+	h3dSetNodeParamI( _cam, H3DCamera::ViewportYI, 0 );
+	h3dSetNodeParamI( _cam, H3DCamera::ViewportWidthI, ViewportWidth );
+	h3dSetNodeParamI( _cam, H3DCamera::ViewportHeightI, ViewportHeight );
+	h3dSetupCameraView( _cam, 45.0f, (float)ViewportWidth / ViewportHeight, 0.5f, 1000.0f );
+	h3dResizePipelineBuffers( _pipelineRes, ViewportWidth, ViewportHeight );
+
+	return true;
+}
+
+
+void BenchScenes::release()
+{
+	if( _cam != 0 ) h3dRemoveNode( _cam );
+	_cam = 0;
+}
+
+
+void BenchScenes::setCameraPose( float t )
+{
+	// Slow orbit around the origin, looking slightly down
+	float ang = t * 6.2831853f;
+	h3dSetNodeTransform( _cam, sinf( ang ) * 60.0f, 25.0f, cosf( ang ) * 60.0f,
+	                     -20.0f, ang * 57.29578f, 0, 1, 1, 1 );
+}
+
+
+void BenchScenes::renderFrame( long long &batches, long long &tris, long long &lightPasses )
+{
+	h3dRender( _cam );
+	h3dFinalizeFrame();
+
+	batches += (long long)h3dGetStat( H3DStats::BatchCount, true );
+	tris += (long long)h3dGetStat( H3DStats::TriCount, true );
+	lightPasses += (long long)h3dGetStat( H3DStats::LightPassCount, true );
+}
+
+
+void BenchScenes::runCulling()
+{
+	BenchRandom rnd( RandomSeed );
+	H3DNode root = h3dAddGroupNode( H3DRootNode, "CullingScene" );
+
+	// Static meshes on a jittered grid
+	int side = (int)ceilf( sqrtf( (float)_config.cullingNodes ) );
+	float spacing = 4.0f, offset = side * spacing * 0.5f;
+	vector< H3DNode > nodes( _config.cullingNodes );
+	for( int i = 0; i < _config.cullingNodes; ++i )
+	{
+		H3DNode node = h3dAddNodes( root, _sphereRes );
+		nodes[i] = node;
+		float scale = rnd.nextFloat( 0.5f, 1.5f );
+		h3dSetNodeTransform( node, (i % side) * spacing - offset + rnd.nextFloat( -1.0f, 1.0f ),
+		                     rnd.nextFloat( 0.0f, 4.0f ), (i / side) * spacing - offset + rnd.nextFloat( -1.0f, 1.0f ),
+		                     0, rnd.nextFloat( 0.0f, 360.0f ), 0, scale, scale, scale );
+	}
+
+	// Lights pointing down onto the grid, every eighth light casts shadows
+	for( int i = 0; i < _config.cullingLights; ++i )
+	{
+		H3DNode light = h3dAddLightNode( root, "BenchLight", _lightMatRes, "LIGHTING", "SHADOWMAP" );
+		h3dSetNodeTransform( light, rnd.nextFloat( -offset, offset ), 20.0f, rnd.nextFloat( -offset, offset ),
+		                     -90.0f, 0, 0, 1, 1, 1 );
+		h3dSetNodeParamF( light, H3DLight::RadiusF, 0, 40.0f );
+		h3dSetNodeParamF( light, H3DLight::FovF, 0, 90.0f );
+		h3dSetNodeParamI( light, H3DLight::ShadowMapCountI, i % 8 == 0 ? 1 : 0 );
+	}
+
+	long long batches = 0, tris = 0, lightPasses = 0, culled = 0;
+	double renderTime = 0, cullingTime = 0;
+	vector< int > visibility( nodes.size() );
+
+	resetEngineStats();
+	for( int frame = 0; frame < _config.frames; ++frame )
+	{
+		setCameraPose( (float)frame / _config.frames );
+
+		WallTimer timer;
+		renderFrame( batches, tris, lightPasses );
+		renderTime += timer.getElapsedMS();
+		cullingTime += h3dGetStat( H3DStats::CullingTime, true );
+
+		// Outside of the timed section, reuses the culling results of the frame
+		culled += (long long)nodes.size() -
+			h3dCheckNodeVisibilityBatch( &nodes[0], (int)nodes.size(), _cam, false, false, &visibility[0] );
+	}
+
+	_results.addMetric( "culling", "cullingMs", cullingTime / _config.frames );
+	_results.addMetric( "culling", "renderMs", renderTime / _config.frames );
+	_results.addCounter( "culling", "batches", batches );
+	_results.addCounter( "culling", "triangles", tris );
+	_results.addCounter( "culling", "lightPasses", lightPasses );
+	_results.addCounter( "culling", "culled", culled );
+
+	h3dRemoveNode( root );
+}
+
+
+void BenchScenes::runHierarchy()
+{
+	H3DNode root = h3dAddGroupNode( H3DRootNode, "HierarchyScene" );
+
+	vector< H3DNode > chainNodes;
+	chainNodes.reserve( _config.hierarchyChains * _config.hierarchyDepth );
+
+	for( int i = 0; i < _config.hierarchyChains; ++i )
+	{
+		H3DNode parent = root;
+		for( int j = 0; j < _config.hierarchyDepth; ++j )
+		{
+			parent = h3dAddGroupNode( parent, "Link" );
+			h3dSetNodeTransform( parent, 0, 0.5f, 0, 0, 5.0f, 0, 1, 1, 1 );
+			chainNodes.push_back( parent );
+		}
+
+		// Leaf geometry so that bounding boxes have to be propagated through the chain
+		h3dAddNodes( parent, _sphereRes );
+	}
+
+	double updateTime = 0;
+	for( int frame = 0; frame < _config.frames; ++frame )
+	{
+		WallTimer timer;
+
+		// Animate every eighth link of every chain, which dirties the complete subtree
+		float angle = 5.0f + frame * 0.5f;
+		for( size_t i = 0; i < chainNodes.size(); i += 8 )
+			h3dSetNodeTransform( chainNodes[i], 0, 0.5f, 0, 0, angle, 0, 1, 1, 1 );
+
+		// Querying the bounding box forces the scene update
+		float minY, maxY;
+		h3dGetNodeAABB( root, 0x0, &minY, 0x0, 0x0, &maxY, 0x0 );
+
+		updateTime += timer.getElapsedMS();
+	}
+
+	_results.addMetric( "hierarchy", "updateMs", updateTime / _config.frames );
+	_results.addCounter( "hierarchy", "nodes", (long long)chainNodes.size() );
+
+	h3dRemoveNode( root );
+}
+
+
+void BenchScenes::runAnimation()
+{
+	BenchRandom rnd( RandomSeed );
+	H3DNode root = h3dAddGroupNode( H3DRootNode, "AnimationScene" );
+
+	vector< H3DNode > characters;
+	vector< float > phases;
+	int side = (int)ceilf( sqrtf( (float)_config.skinnedModels ) );
+
+	for( int i = 0; i < _config.skinnedModels; ++i )
+	{
+		H3DNode node = h3dAddNodes( root, _characterRes );
+		h3dSetupModelAnimStage( node, 0, _walkAnimRes, 0, "", false );
+		h3dSetNodeTransform( node, (i % side) * 2.0f - side, 0, (i / side) * 2.0f - side,
+		                     0, rnd.nextFloat( 0.0f, 360.0f ), 0, 1, 1, 1 );
+		if( i < _config.swSkinnedModels )
+			h3dSetNodeParamI( node, H3DModel::SWSkinningI, 1 );
+
+		characters.push_back( node );
+		phases.push_back( rnd.nextFloat( 0.0f, 100.0f ) );
+	}
+
+	// Animation parameters of all characters are set with a single batched call per frame
+	vector< int > stages( characters.size(), 0 );
+	vector< float > animParams( characters.size() * 2, 1.0f );
+
+	long long batches = 0, tris = 0, lightPasses = 0;
+	double animTime = 0, skinTime = 0, updateTime = 0;
+
+	resetEngineStats();
+	for( int frame = 0; frame < _config.frames; ++frame )
+	{
+		setCameraPose( (float)frame / _config.frames );
+
+		WallTimer timer;
+		for( size_t i = 0; i < characters.size(); ++i )
+			animParams[i * 2] = phases[i] + frame * 24.0f * FrameDelta;
+		if( !characters.empty() )
+			h3dSetModelAnimParamsBatch( &characters[0], (int)characters.size(), &stages[0], &animParams[0] );
+		for( size_t i = 0; i < characters.size(); ++i )
+			h3dUpdateModel( characters[i], H3DModelUpdateFlags::Animation | H3DModelUpdateFlags::Geometry );
+		updateTime += timer.getElapsedMS();
+
+		animTime += h3dGetStat( H3DStats::AnimationTime, true );
+		skinTime += h3dGetStat( H3DStats::GeoUpdateTime, true );
+
+		renderFrame( batches, tris, lightPasses );
+	}
+
+	_results.addMetric( "animation", "animationMs", animTime / _config.frames );
+	_results.addMetric( "animation", "updateMs", updateTime / _config.frames );
+	_results.addMetric( "skinning", "geoUpdateMs", skinTime / _config.frames );
+	_results.addCounter( "animation", "batches", batches );
+	_results.addCounter( "animation", "triangles", tris );
+
+	h3dRemoveNode( root );
+}
+
+
+void BenchScenes::runParticles()
+{
+	BenchRandom rnd( RandomSeed );
+	H3DNode root = h3dAddGroupNode( H3DRootNode, "ParticleScene" );
+
+	// Particle spawning uses the C library generator
+	srand( RandomSeed );
+
+	for( int i = 0; i < _config.emitterScenes; ++i )
+	{
+		H3DNode node = h3dAddNodes( root, _particleSysRes );
+		h3dSetNodeTransform( node, rnd.nextFloat( -40.0f, 40.0f ), 0, rnd.nextFloat( -40.0f, 40.0f ),
+		                     0, 0, 0, 1, 1, 1 );
+	}
+
+	vector< H3DNode > emitters;
+	int count = h3dFindNodes( root, "", H3DNodeTypes::Emitter );
+	for( int i = 0; i < count; ++i )
+		emitters.push_back( h3dGetNodeFindResult( i ) );
+
+	long long batches = 0, tris = 0, lightPasses = 0;
+	double simTime = 0;
+
+	resetEngineStats();
+	for( int frame = 0; frame < _config.frames; ++frame )
+	{
+		setCameraPose( (float)frame / _config.frames );
+
+		for( size_t i = 0; i < emitters.size(); ++i )
+			h3dUpdateEmitter( emitters[i], FrameDelta );
+
+		simTime += h3dGetStat( H3DStats::ParticleSimTime, true );
+
+		renderFrame( batches, tris, lightPasses );
+	}
+
+	_results.addMetric( "particles", "simulationMs", simTime / _config.frames );
+	// Batch counts are not recorded as they depend on the C library random generator
+	_results.addCounter( "particles", "emitters", (long long)emitters.size() );
+
+	h3dRemoveNode( root );
+}
+
+
+void BenchScenes::runResourceLoading()
+{
+	BenchRandom rnd( RandomSeed );
+
+	vector< string > sources( _config.resources );
+	for( int i = 0; i < _config.resources; ++i )
+	{
+		char buf[512];
+		snprintf( buf, sizeof( buf ),
+		          "<Material>\n"
+		          "\t<Shader source=\"shaders/model.shader\"/>\n"
+		          "\t<ShaderFlag name=\"_F02_NormalMapping\"/>\n"
+		          "\t<Uniform name=\"matDiffuseCol\" a=\"%.3f\" b=\"%.3f\" c=\"%.3f\" d=\"1.0\" />\n"
+		          "\t<Uniform name=\"matSpecParams\" a=\"%.3f\" b=\"0.5\" />\n"
+		          "</Material>\n",
+		          rnd.nextFloat( 0, 1 ), rnd.nextFloat( 0, 1 ), rnd.nextFloat( 0, 1 ), rnd.nextFloat( 0, 1 ) );
+		sources[i] = buf;
+	}
+
+	vector< H3DRes > resources( _config.resources );
+	long long loaded = 0;
+
+	WallTimer loadTimer;
+	for( int i = 0; i < _config.resources; ++i )
+	{
+		char name[64];
+		snprintf( name, sizeof( name ), "bench/material%05d.material.xml", i );
+		resources[i] = h3dAddResource( H3DResTypes::Material, name, 0 );
+		if( h3dLoadResource( resources[i], sources[i].c_str(), (int)sources[i].size() ) ) ++loaded;
+	}
+	_results.addMetric( "load", "resourcesMs", loadTimer.getElapsedMS() );
+
+	WallTimer releaseTimer;
+	for( int i = 0; i < _config.resources; ++i )
+		h3dRemoveResource( resources[i] );
+	h3dReleaseUnusedResources();
+	_results.addMetric( "load", "releaseMs", releaseTimer.getElapsedMS() );
+
+	_results.addCounter( "load", "resources", loaded );
+}
@@ -0,0 +1,126 @@
+// *************************************************************************************************
+//
+// Horde3D
+//   Next-Generation Graphics Engine
+// --------------------------------------
+// Copyright (C) 2006-2021 Nicolas Schulz and Horde3D team
+//
+// This software is distributed under the terms of the Eclipse Public License v1.0.
+// A copy of the license may be obtained at: http://www.eclipse.org/legal/epl-v10.html
+//
+// *************************************************************************************************
+
+#ifndef _Benchmark_H_
+#define _Benchmark_H_
+
+#include "Horde3D.h"
+#include <string>
+#include <vector>
+
+
+// =================================================================================================
+// Deterministic random generator (independent of the C library implementation)
+// =================================================================================================
+
+class BenchRandom
+{
+public:
+	explicit BenchRandom( unsigned int seed ) : _state( seed ) {}
+
+	unsigned int next()
+	{
+		_state = _state * 1664525u + 1013904223u;
+		return _state >> 8;
+	}
+
+	float nextFloat( float minVal, float maxVal )
+	{
+		return minVal + (maxVal - minVal) * ((next() & 0xFFFF) / 65535.0f);
+	}
+
+private:
+	unsigned int  _state;
+};
+
+
+// =================================================================================================
+// Results
+// =================================================================================================
+
+struct BenchMetric
+{
+	std::string  scenario;
+	std::string  name;
+	double       value;        // Measured time in ms (average per frame or total, see name)
+};
+
+struct BenchCounter
+{
+	std::string  scenario;
+	std::string  name;
+	long long    value;        // Exact work counter, compared without tolerance
+};
+
+struct BenchResults
+{
+	std::vector< BenchMetric >   metrics;
+	std::vector< BenchCounter >  counters;
+
+	void addMetric( const std::string &scenario, const std::string &name, double value );
+	void addCounter( const std::string &scenario, const std::string &name, long long value );
+};
+
+
+// =================================================================================================
+// Benchmark scenes
+// =================================================================================================
+
+struct BenchConfig
+{
+	int  frames;               // Number of simulated frames per scenario
+	int  cullingNodes;         // Number of static meshes in culling scene
+	int  cullingLights;        // Number of point lights in culling scene
+	int  hierarchyChains;      // Number of independent node chains
+	int  hierarchyDepth;       // Depth of each node chain
+	int  skinnedModels;        // Number of animated characters
+	int  swSkinnedModels;      // Number of characters using software skinning (subset of skinnedModels)
+	int  emitterScenes;        // Number of particle scenes (two emitters each)
+	int  resources;            // Number of in-memory resources created in load scenario
+
+	BenchConfig() : frames( 60 ), cullingNodes( 4096 ), cullingLights( 32 ), hierarchyChains( 64 ),
+		hierarchyDepth( 64 ), skinnedModels( 1000 ), swSkinnedModels( 100 ), emitterScenes( 50 ),
+		resources( 10000 ) {}
+};
+
+class BenchScenes
+{
+public:
+	BenchScenes( const BenchConfig &config, BenchResults &results );
+
+	bool loadContent( const std::string &contentDir );
+	void release();
+
+	void runCulling();
+	void runHierarchy();
+	void runAnimation();
+	void runParticles();
+	void runResourceLoading();
+
+private:
+	void renderFrame( long long &batches, long long &tris, long long &lightPasses );
+	void setCameraPose( float t );
+
+private:
+	const BenchConfig  &_config;
+	BenchResults       &_results;
+
+	H3DRes             _pipelineRes;
+	H3DRes             _sphereRes;
+	H3DRes             _characterRes;
+	H3DRes             _walkAnimRes;
+	H3DRes             _particleSysRes;
+	H3DRes             _lightMatRes;
+	H3DNode            _cam;
+};
+
+#endif // _Benchmark_H_
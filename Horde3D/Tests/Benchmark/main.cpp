@@ -0,0 +1,309 @@
+// *************************************************************************************************
+//
+// Horde3D
+//   Next-Generation Graphics Engine
+// --------------------------------------
+// Copyright (C) 2006-2021 Nicolas Schulz and Horde3D team
+//
+// This software is distributed under the terms of the Eclipse Public License v1.0.
+// A copy of the license may be obtained at: http://www.eclipse.org/legal/epl-v10.html
+//
+// *************************************************************************************************
+
+// Performance regression benchmark
+//
+// Builds deterministic synthetic scenes, runs them on the headless Null render backend and compares
+// the measured CPU times against checked-in budgets. Work counters (batches, triangles, ...) are
+// compared exactly, so a change in culling or batching results is detected independent of timing.
+// With --counters-only the times are reported but not checked, which is what the default test run
+// does since the timing budgets only hold for optimized builds on comparable machines.
+// Results are written as JSON for tracking trends across commits.
+//
+// Usage: Horde3DBenchmark --content <dir> [--budgets <file>] [--output <file>]
+//                         [--write-budgets <file>] [--frames <n>] [--time-scale <f>] [--counters-only]
+
+#include "benchmark.h"
+#include "Horde3DUtils.h"
+#include "utXML.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+
+using namespace std;
+using namespace Horde3D;
+
+
+struct Budget
+{
+	double  value;
+	double  tolerance;  // Relative; metric fails when exceeding value * (1 + tolerance)
+};
+
+struct Options
+{
+	string  contentDir;
+	string  budgetsFile;
+	string  outputFile;
+	string  writeBudgetsFile;
+	double  timeScale;  // Multiplier for timing budgets, useful for slow or instrumented builds
+	int     frames;
+	bool    countersOnly;  // Timing budgets are not checked
+
+	Options() : timeScale( 1.0 ), frames( 0 ), countersOnly( false ) {}
+};
+
+
+static bool parseArgs( int argc, char **argv, Options &opts )
+{
+	for( int i = 1; i < argc; ++i )
+	{
+		bool hasValue = i + 1 < argc;
+
+		if( strcmp( argv[i], "--content" ) == 0 && hasValue ) opts.contentDir = argv[++i];
+		else if( strcmp( argv[i], "--budgets" ) == 0 && hasValue ) opts.budgetsFile = argv[++i];
+		else if( strcmp( argv[i], "--output" ) == 0 && hasValue ) opts.outputFile = argv[++i];
+		else if( strcmp( argv[i], "--write-budgets" ) == 0 && hasValue ) opts.writeBudgetsFile = argv[++i];
+		else if( strcmp( argv[i], "--time-scale" ) == 0 && hasValue ) opts.timeScale = atof( argv[++i] );
+		else if( strcmp( argv[i], "--frames" ) == 0 && hasValue ) opts.frames = atoi( argv[++i] );
+		else if( strcmp( argv[i], "--counters-only" ) == 0 ) opts.countersOnly = true;
+		else
+		{
+			fprintf( stderr, "Unknown or incomplete argument '%s'\n", argv[i] );
+			return false;
+		}
+	}
+
+	if( opts.contentDir.empty() )
+	{
+		fprintf( stderr, "Usage: Horde3DBenchmark --content <dir> [--budgets <file>] [--output <file>]\n"
+		                 "                        [--write-budgets <file>] [--frames <n>] [--time-scale <f>]\n"
+		                 "                        [--counters-only]\n" );
+		return false;
+	}
+
+	return true;
+}
+
+
+static string makeKey( const string &scenario, const string &name )
+{
+	return scenario + "." + name;
+}
+
+
+static bool loadBudgets( const string &fileName, map< string, Budget > &metrics, map< string, long long > &counters )
+{
+	XMLDoc doc;
+	if( !doc.parseFile( fileName.c_str() ) || doc.hasError() ) return false;
+
+	XMLNode rootNode = doc.getRootNode();
+	if( strcmp( rootNode.getName(), "Budgets" ) != 0 ) return false;
+
+	XMLNode node = rootNode.getFirstChild( "Metric" );
+	while( !node.isEmpty() )
+	{
+		Budget budget;
+		budget.value = atof( node.getAttribute( "budget", "0" ) );
+		budget.tolerance = atof( node.getAttribute( "tolerance", "0" ) );
+		metrics[makeKey( node.getAttribute( "scenario" ), node.getAttribute( "name" ) )] = budget;
+
+		node = node.getNextSibling( "Metric" );
+	}
+
+	node = rootNode.getFirstChild( "Counter" );
+	while( !node.isEmpty() )
+	{
+		counters[makeKey( node.getAttribute( "scenario" ), node.getAttribute( "name" ) )] =
+			atoll( node.getAttribute( "value", "0" ) );
+
+		node = node.getNextSibling( "Counter" );
+	}
+
+	return true;
+}
+
+
+static bool writeBudgets( const string &fileName, const BenchResults &results )
+{
+	FILE *f = fopen( fileName.c_str(), "w" );
+	if( f == 0x0 ) return false;
+
+	// Measured times are taken as budget, the tolerance absorbs run to run noise. A single run can be
+	// an outlier, so check the written values against a few more runs before checking them in.
+	fprintf( f, "<!-- Performance budgets for Horde3DBenchmark. Generated with --write-budgets, tune as required.\n"
+	            "     Metric: fails when value > budget * (1 + tolerance). Counter: must match exactly. -->\n" );
+	fprintf( f, "<Budgets>\n" );
+	for( size_t i = 0; i < results.metrics.size(); ++i )
+	{
+		const BenchMetric &m = results.metrics[i];
+		fprintf( f, "\t<Metric scenario=\"%s\" name=\"%s\" budget=\"%.3f\" tolerance=\"0.25\" />\n",
+		         m.scenario.c_str(), m.name.c_str(), m.value );
+	}
+	for( size_t i = 0; i < results.counters.size(); ++i )
+	{
+		const BenchCounter &c = results.counters[i];
+		fprintf( f, "\t<Counter scenario=\"%s\" name=\"%s\" value=\"%lld\" />\n",
+		         c.scenario.c_str(), c.name.c_str(), c.value );
+	}
+	fprintf( f, "</Budgets>\n" );
+
+	fclose( f );
+	return true;
+}
+
+
+static void dumpEngineMessages()
+{
+	int level;
+	float time;
+	const char *msg = h3dGetMessage( &level, &time );
+	while( msg != 0x0 && msg[0] != '\0' )
+	{
+		if( level <= 2 ) fprintf( stderr, "Horde3D: %s\n", msg );
+		msg = h3dGetMessage( &level, &time );
+	}
+}
+
+
+int main( int argc, char **argv )
+{
+	Options opts;
+	if( !parseArgs( argc, argv, opts ) ) return 2;
+
+	BenchConfig config;
+	if( opts.frames > 0 ) config.frames = opts.frames;
+
+	if( !h3dInit( H3DRenderDevice::Null ) )
+	{
+		fprintf( stderr, "Failed to initialize engine with Null backend\n" );
+		dumpEngineMessages();
+		return 2;
+	}
+	h3dSetOption( H3DOptions::MaxLogLevel, 2 );
+	h3dSetOption( H3DOptions::GatherTimeStats, 1 );
+
+	BenchResults results;
+	BenchScenes scenes( config, results );
+
+	if( !scenes.loadContent( opts.contentDir ) )
+	{
+		fprintf( stderr, "Failed to load content from '%s'\n", opts.contentDir.c_str() );
+		dumpEngineMessages();
+		h3dRelease();
+		return 2;
+	}
+
+	scenes.runCulling();
+	scenes.runHierarchy();
+	scenes.runAnimation();
+	scenes.runParticles();
+	scenes.runResourceLoading();
+	scenes.release();
+
+	dumpEngineMessages();
+	h3dRelease();
+
+	if( !opts.writeBudgetsFile.empty() && !writeBudgets( opts.writeBudgetsFile, results ) )
+		fprintf( stderr, "Failed to write budgets to '%s'\n", opts.writeBudgetsFile.c_str() );
+
+	// Compare against budgets
+	map< string, Budget > metricBudgets;
+	map< string, long long > counterBudgets;
+	if( !opts.budgetsFile.empty() && !loadBudgets( opts.budgetsFile, metricBudgets, counterBudgets ) )
+	{
+		fprintf( stderr, "Failed to load budgets from '%s'\n", opts.budgetsFile.c_str() );
+		return 2;
+	}
+
+	bool passed = true;
+	string json = "{\n";
+	char buf[512];
+
+	snprintf( buf, sizeof( buf ), "\t\"backend\": \"Null\",\n\t\"frames\": %d,\n\t\"timeScale\": %.3f,\n",
+	          config.frames, opts.timeScale );
+	json += buf;
+
+	json += "\t\"metrics\": [\n";
+	for( size_t i = 0; i < results.metrics.size(); ++i )
+	{
+		const BenchMetric &m = results.metrics[i];
+		map< string, Budget >::const_iterator itr = metricBudgets.find( makeKey( m.scenario, m.name ) );
+
+		const char *status = "unbudgeted";
+		double budget = 0, tolerance = 0;
+		if( itr != metricBudgets.end() )
+		{
+			budget = itr->second.value * opts.timeScale;
+			tolerance = itr->second.tolerance;
+			bool ok = m.value <= budget * (1.0 + tolerance);
+			status = opts.countersOnly ? "unchecked" : ok ? "pass" : "fail";
+			if( !ok && !opts.countersOnly )
+			{
+				passed = false;
+				fprintf( stderr, "FAIL %s.%s: %.3f ms exceeds budget %.3f ms (+%.0f%%)\n",
+				         m.scenario.c_str(), m.name.c_str(), m.value, budget, tolerance * 100.0 );
+			}
+		}
+
+		snprintf( buf, sizeof( buf ),
+		          "\t\t{ \"scenario\": \"%s\", \"name\": \"%s\", \"unit\": \"ms\", \"value\": %.4f, "
+		          "\"budget\": %.4f, \"tolerance\": %.3f, \"status\": \"%s\" }%s\n",
+		          m.scenario.c_str(), m.name.c_str(), m.value, budget, tolerance, status,
+		          i + 1 < results.metrics.size() ? "," : "" );
+		json += buf;
+	}
+	json += "\t],\n";
+
+	json += "\t\"counters\": [\n";
+	for( size_t i = 0; i < results.counters.size(); ++i )
+	{
+		const BenchCounter &c = results.counters[i];
+		map< string, long long >::const_iterator itr = counterBudgets.find( makeKey( c.scenario, c.name ) );
+
+		const char *status = "unbudgeted";
+		long long expected = 0;
+		if( itr != counterBudgets.end() )
+		{
+			expected = itr->second;
+			status = c.value == expected ? "pass" : "fail";
+			if( c.value != expected )
+			{
+				passed = false;
+				fprintf( stderr, "FAIL %s.%s: counter is %lld, expected %lld\n",
+				         c.scenario.c_str(), c.name.c_str(), c.value, expected );
+			}
+		}
+
+		snprintf( buf, sizeof( buf ),
+		          "\t\t{ \"scenario\": \"%s\", \"name\": \"%s\", \"value\": %lld, \"expected\": %lld, \"status\": \"%s\" }%s\n",
+		          c.scenario.c_str(), c.name.c_str(), c.value, expected, status,
+		          i + 1 < results.counters.size() ? "," : "" );
+		json += buf;
+	}
+	json += "\t],\n";
+
+	json += passed ? "\t\"passed\": true\n}\n" : "\t\"passed\": false\n}\n";
+
+	if( !opts.outputFile.empty() )
+	{
+		FILE *f = fopen( opts.outputFile.c_str(), "w" );
+		if( f != 0x0 )
+		{
+			fputs( json.c_str(), f );
+			fclose( f );
+		}
+		else
+		{
+			fprintf( stderr, "Failed to write results to '%s'\n", opts.outputFile.c_str() );
+		}
+
+		printf( "Benchmark %s, results written to '%s'\n", passed ? "passed" : "failed", opts.outputFile.c_str() );
+	}
+	else
+	{
+		fputs( json.c_str(), stdout );
+	}
+
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,1658 @@
+// *************************************************************************************************
+//
+// Horde3D
+//   Next-Generation Graphics Engine
+// --------------------------------------
+// Copyright (C) 2006-2021 Nicolas Schulz and Horde3D team
+//
+// This software is distributed under the terms of the Eclipse Public License v1.0.
+// A copy of the license may be obtained at: http://www.eclipse.org/legal/epl-v10.html
+//
+// *************************************************************************************************
+
+// Engine tests
+//
+// Functional tests of engine and utility library features. Every test initializes the engine with
+// the Null render backend, so no window or GPU is required. Files created by the tests are written
+// to the work directory.
+//
+// Tests of internal engine classes are only built where the shared engine library exports them.
+//
+// Usage: Horde3DEngineTests --content <dir> --work-dir <dir>
+
+#include "Horde3D.h"
+#include "Horde3DUtils.h"
+#include "utPack.h"
+#ifdef H3D_TEST_ENGINE_INTERNALS
+#include "egModules.h"
+#include "egCom.h"
+#include "egGeometry.h"
+#include "egCamera.h"
+#include "egShader.h"
+#include "egPipeline.h"
+#include "egRenderer.h"
+#include "egRendererBaseNull.h"
+#endif
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace Horde3D;
+
+
+static int failures = 0;
+
+#define CHECK( cond, ... ) \
+	if( !(cond) ) { ++failures; printf( "FAIL %s:%d: ", __FILE__, __LINE__ ); printf( __VA_ARGS__ ); printf( "\n" ); }
+
+
+struct Options
+{
+	string  contentDir;
+	string  workDir;
+};
+
+
+// =================================================================================================
+// Helpers
+// =================================================================================================
+
+static bool initEngine()
+{
+	if( !h3dInit( H3DRenderDevice::Null ) )
+	{
+		printf( "FAIL: engine could not be initialized with the Null backend\n" );
+		++failures;
+		return false;
+	}
+	h3dSetOption( H3DOptions::MaxLogLevel, 2 );
+
+	return true;
+}
+
+
+static void writeFile( const string &fileName, const string &data )
+{
+	ofstream out( fileName.c_str(), ios::binary | ios::trunc );
+	out << data;
+}
+
+
+static string materialWithUniform( float value )
+{
+	char buf[128];
+	snprintf( buf, sizeof( buf ), "<Material>\n\t<Uniform name=\"testValue\" a=\"%.1f\" />\n</Material>\n", value );
+	return buf;
+}
+
+
+static float getMaterialUniform( H3DRes matRes )
+{
+	int idx = h3dFindResElem( matRes, H3DMatRes::UniformElem, H3DMatRes::UnifNameStr, "testValue" );
+	if( idx < 0 ) return -1.0f;
+
+	return h3dGetResParamF( matRes, H3DMatRes::UniformElem, idx, H3DMatRes::UnifValueF4, 0 );
+}
+
+
+static H3DNode addCamera( H3DRes pipelineRes )
+{
+	H3DNode cam = h3dAddCameraNode( H3DRootNode, "TestCamera", pipelineRes );
+	h3dSetNodeParamI( cam, H3DCamera::ViewportWidthI, 320 );
+	h3dSetNodeParamI( cam, H3DCamera::ViewportHeightI, 240 );
+	h3dSetupCameraView( cam, 45.0f, 320.0f / 240.0f, 0.5f, 200.0f );
+	h3dResizePipelineBuffers( pipelineRes, 320, 240 );
+
+	return cam;
+}
+
+
+static H3DNode findMesh( H3DNode node )
+{
+	return h3dFindNodes( node, "", H3DNodeTypes::Mesh ) > 0 ? h3dGetNodeFindResult( 0 ) : 0;
+}
+
+
+// =================================================================================================
+// Hot reload
+// =================================================================================================
+
+static void testHotReload( const Options &opts )
+{
+	if( !initEngine() ) return;
+
+	writeFile( opts.workDir + "/reloadTest.material.xml", materialWithUniform( 1.0f ) );
+	H3DRes matRes = h3dAddResource( H3DResTypes::Material, "reloadTest.material.xml", 0 );
+	CHECK( h3dutLoadResourcesFromDisk( opts.workDir.c_str() ), "reload: initial loading failed" );
+	CHECK( getMaterialUniform( matRes ) == 1.0f, "reload: unexpected initial value %f", getMaterialUniform( matRes ) );
+
+	CHECK( h3dutWatchResourceChanges( opts.workDir.c_str() ), "reload: watching the work directory failed" );
+	CHECK( h3dutReloadChangedResources() == 0, "reload: resources reloaded without changed files" );
+
+	// Saving a file without changing its content must not count as reload
+	writeFile( opts.workDir + "/reloadTest.material.xml", materialWithUniform( 1.0f ) );
+	int numReloaded = 0;
+	for( int i = 0; i < 30; ++i )
+	{
+		numReloaded += h3dutReloadChangedResources();
+		this_thread::sleep_for( chrono::milliseconds( 10 ) );
+	}
+	CHECK( numReloaded == 0, "reload: unchanged file counted as reloaded (%d)", numReloaded );
+
+	// Polling of modification times has a resolution of one second on some platforms
+	writeFile( opts.workDir + "/reloadTest.material.xml", materialWithUniform( 2.0f ) );
+	numReloaded = 0;
+	for( int i = 0; i < 300 && numReloaded == 0; ++i )
+	{
+		numReloaded = h3dutReloadChangedResources();
+		if( numReloaded == 0 )
+		{
+			this_thread::sleep_for( chrono::milliseconds( 10 ) );
+			writeFile( opts.workDir + "/reloadTest.material.xml", materialWithUniform( 2.0f ) );
+		}
+	}
+	CHECK( numReloaded == 1, "reload: expected one reloaded resource, got %d", numReloaded );
+	CHECK( getMaterialUniform( matRes ) == 2.0f, "reload: unexpected value after reload %f", getMaterialUniform( matRes ) );
+	CHECK( h3dIsResLoaded( matRes ), "reload: resource not loaded after reload" );
+
+	// Direct reloading reports whether the data was replaced
+	string data = materialWithUniform( 2.0f );
+	CHECK( h3dReloadResource( matRes, data.c_str(), (int)data.size() ) == 0, "reload: unchanged data replaced" );
+	data = materialWithUniform( 3.0f );
+	CHECK( h3dReloadResource( matRes, data.c_str(), (int)data.size() ) == 1, "reload: changed data not replaced" );
+	CHECK( getMaterialUniform( matRes ) == 3.0f, "reload: unexpected value after direct reload" );
+
+	h3dutStopWatchingResourceChanges();
+	h3dRelease();
+}
+
+
+// =================================================================================================
+// Resource loading
+// =================================================================================================
+
+struct LoadState
+{
+	bool   result;
+	bool   loaded[5];
+	float  values[2];
+};
+
+
+static const char *loadTestNames[] = {
+	"prefetchA.material.xml",        // Links prefetchB and references a missing shader
+	"prefetchB.material.xml",
+	"prefetchInvalid.material.xml",  // Loading fails
+	"prefetchMissing.material.xml",
+	"prefetchMissing.shader"
+};
+
+
+static void writeLoadTestFiles( const Options &opts )
+{
+	writeFile( opts.workDir + "/prefetchA.material.xml",
+	           "<Material link=\"prefetchB.material.xml\">\n\t<Shader source=\"prefetchMissing.shader\" />\n"
+	           "\t<Uniform name=\"testValue\" a=\"1.0\" />\n</Material>\n" );
+	writeFile( opts.workDir + "/prefetchB.material.xml", materialWithUniform( 2.0f ) );
+	writeFile( opts.workDir + "/prefetchInvalid.material.xml", "<Pipeline />\n" );
+	remove( (opts.workDir + "/prefetchMissing.material.xml").c_str() );
+	remove( (opts.workDir + "/prefetchMissing.shader").c_str() );
+}
+
+
+static void addLoadTestResources()
+{
+	h3dAddResource( H3DResTypes::Material, loadTestNames[0], 0 );
+	h3dAddResource( H3DResTypes::Material, loadTestNames[2], 0 );
+	h3dAddResource( H3DResTypes::Material, loadTestNames[3], 0 );
+}
+
+
+static LoadState getLoadState( bool result )
+{
+	LoadState state;
+	state.result = result;
+	for( int i = 0; i < 5; ++i )
+	{
+		int type = i < 4 ? H3DResTypes::Material : H3DResTypes::Shader;
+		H3DRes res = h3dFindResource( type, loadTestNames[i] );
+		state.loaded[i] = res != 0 && h3dIsResLoaded( res );
+	}
+	for( int i = 0; i < 2; ++i )
+		state.values[i] = getMaterialUniform( h3dFindResource( H3DResTypes::Material, loadTestNames[i] ) );
+
+	return state;
+}
+
+
+static bool loadSynchronously( const string &dir )
+{
+	// Reference implementation without prefetching
+	bool result = true;
+	for( H3DRes res = h3dQueryUnloadedResource( 0 ); res != 0; res = h3dQueryUnloadedResource( 0 ) )
+	{
+		ifstream inf( (dir + "/" + h3dGetResName( res )).c_str(), ios::binary );
+		if( inf.good() )
+		{
+			string data( (istreambuf_iterator< char >( inf )), istreambuf_iterator< char >() );
+			result &= h3dLoadResource( res, data.c_str(), (int)data.size() );
+		}
+		else
+		{
+			h3dLoadResource( res, 0x0, 0 );
+			result = false;
+		}
+	}
+
+	return result;
+}
+
+
+static void testResourcePrefetching( const Options &opts )
+{
+	writeLoadTestFiles( opts );
+
+	if( !initEngine() ) return;
+	addLoadTestResources();
+	LoadState expected = getLoadState( loadSynchronously( opts.workDir ) );
+	h3dRelease();
+
+	if( !initEngine() ) return;
+	addLoadTestResources();
+	LoadState state = getLoadState( h3dutLoadResourcesFromDisk( opts.workDir.c_str() ) );
+
+	CHECK( !expected.result && state.result == expected.result, "prefetch: unexpected result %d", (int)state.result );
+	for( int i = 0; i < 5; ++i )
+	{
+		CHECK( state.loaded[i] == expected.loaded[i], "prefetch: loaded state of %s is %d instead of %d",
+		       loadTestNames[i], (int)state.loaded[i], (int)expected.loaded[i] );
+	}
+	for( int i = 0; i < 2; ++i )
+	{
+		CHECK( state.values[i] == expected.values[i] && state.values[i] == (float)(i + 1),
+		       "prefetch: value of %s is %f instead of %f", loadTestNames[i], state.values[i], expected.values[i] );
+	}
+
+	// Existing files are passed from the background reads, including the linked material
+	int numPrefetched = h3dutGetNumPrefetchedResources();
+	CHECK( numPrefetched == 3, "prefetch: %d instead of 3 resources prefetched", numPrefetched );
+
+	// Further calls reuse the pool, also with other search paths
+	CHECK( h3dutLoadResourcesFromDisk( opts.workDir.c_str() ), "prefetch: loading without unloaded resources failed" );
+	CHECK( h3dutGetNumPrefetchedResources() == 0, "prefetch: resources prefetched without unloaded resources" );
+
+	writeFile( opts.workDir + "/prefetchC.material.xml", materialWithUniform( 3.0f ) );
+	H3DRes matRes = h3dAddResource( H3DResTypes::Material, "prefetchC.material.xml", 0 );
+	string dirs = opts.workDir + "/missingDir|" + opts.workDir;
+	CHECK( h3dutLoadResourcesFromDisk( dirs.c_str() ), "prefetch: loading from second search path failed" );
+	CHECK( h3dutGetNumPrefetchedResources() == 1, "prefetch: resource of second call not prefetched" );
+	CHECK( getMaterialUniform( matRes ) == 3.0f, "prefetch: unexpected value %f", getMaterialUniform( matRes ) );
+
+	h3dRelease();
+}
+
+
+// =================================================================================================
+// Visibility
+// =================================================================================================
+
+static void testVisibilityCache( const Options &opts )
+{
+	if( !initEngine() ) return;
+
+	H3DRes pipelineRes = h3dAddResource( H3DResTypes::Pipeline, "pipelines/forward.pipeline.xml", 0 );
+	H3DRes sphereRes = h3dAddResource( H3DResTypes::SceneGraph, "models/sphere/sphere.scene.xml", 0 );
+	CHECK( h3dutLoadResourcesFromDisk( opts.contentDir.c_str() ), "visibility: loading content failed" );
+
+	H3DNode cam = addCamera( pipelineRes );
+	H3DNode mesh = findMesh( h3dAddNodes( H3DRootNode, sphereRes ) );
+	CHECK( mesh != 0, "visibility: sphere mesh not found" );
+
+	// Camera looks along negative z onto the sphere, turned around the sphere is behind it
+	h3dSetNodeTransform( cam, 0, 0, 10, 0, 0, 0, 1, 1, 1 );
+	h3dRender( cam );
+	h3dFinalizeFrame();
+	CHECK( h3dCheckNodeVisibility( mesh, cam, false, false ) == 0, "visibility: sphere not visible" );
+
+	// Culling results of a frame rendered after moving the camera must reflect the new position
+	h3dSetNodeTransform( cam, 0, 0, 10, 0, 180, 0, 1, 1, 1 );
+	h3dRender( cam );
+	h3dFinalizeFrame();
+	int result = -2;
+	CHECK( h3dCheckNodeVisibility( mesh, cam, false, false ) == -1, "visibility: cached result of moved camera is stale" );
+	CHECK( h3dCheckNodeVisibilityBatch( &mesh, 1, cam, false, false, &result ) == 0 && result == -1,
+	       "visibility: cached batch result of moved camera is stale" );
+
+	// Moving the camera after rendering invalidates the cached results
+	h3dSetNodeTransform( cam, 0, 0, 10, 0, 0, 0, 1, 1, 1 );
+	CHECK( h3dCheckNodeVisibility( mesh, cam, false, false ) == 0, "visibility: moved camera uses result of last frame" );
+	h3dSetNodeTransform( cam, 0, 0, 10, 0, 180, 0, 1, 1, 1 );
+	CHECK( h3dCheckNodeVisibilityBatch( &mesh, 1, cam, false, false, &result ) == 0 && result == -1,
+	       "visibility: moved camera uses batch result of last frame" );
+
+	h3dRelease();
+}
+
+
+// =================================================================================================
+// Node batches
+// =================================================================================================
+
+static bool isZero( const float *values, int count )
+{
+	for( int i = 0; i < count; ++i )
+	{
+		if( values[i] != 0.0f ) return false;
+	}
+	return true;
+}
+
+
+static void testNodeBatches( const Options &opts )
+{
+	if( !initEngine() ) return;
+
+	H3DRes pipelineRes = h3dAddResource( H3DResTypes::Pipeline, "pipelines/forward.pipeline.xml", 0 );
+	H3DRes sphereRes = h3dAddResource( H3DResTypes::SceneGraph, "models/sphere/sphere.scene.xml", 0 );
+	CHECK( h3dutLoadResourcesFromDisk( opts.contentDir.c_str() ), "batches: loading content failed" );
+
+	H3DNode cam = addCamera( pipelineRes );
+	h3dSetNodeTransform( cam, 0, 0, 10, 0, 0, 0, 1, 1, 1 );
+
+	// Models with their meshes as children, so that relative and absolute matrices differ; a removed
+	// node and the null handle are interleaved as invalid handles (removed last, since handles are reused)
+	H3DNode model0 = h3dAddNodes( H3DRootNode, sphereRes ), model1 = h3dAddNodes( H3DRootNode, sphereRes );
+	H3DNode removed = h3dAddGroupNode( H3DRootNode, "Removed" );
+	h3dRemoveNode( removed );
+	H3DNode nodes[6] = { model0, findMesh( model0 ), removed, model1, 0, findMesh( model1 ) };
+	const bool valid[6] = { true, true, false, true, false, true };
+	const int count = 6;
+	CHECK( nodes[1] != 0 && nodes[5] != 0, "batches: sphere meshes not found" );
+
+	// Transformations, the second model is moved behind the camera
+	float transforms[count * 9];
+	for( int i = 0; i < count * 9; ++i ) transforms[i] = (float)(i % 9) * 0.5f + (float)i * 0.01f;
+	for( int i = 0; i < 9; ++i ) transforms[3 * 9 + i] = i < 6 ? 0.0f : 1.0f;
+	transforms[3 * 9 + 2] = 20.0f;
+	CHECK( h3dSetNodeTransformBatch( nodes, count, transforms ) == 4, "batches: set transform count wrong" );
+
+	float results[count * 16];
+	for( int i = 0; i < count * 16; ++i ) results[i] = 7.0f;
+	CHECK( h3dGetNodeTransformBatch( nodes, count, results ) == 4, "batches: get transform count wrong" );
+	for( int i = 0; i < count; ++i )
+	{
+		if( !valid[i] )
+		{
+			CHECK( isZero( results + i * 9, 9 ), "batches: transform of invalid node %d not zeroed", i );
+			continue;
+		}
+		float single[9];
+		h3dGetNodeTransform( nodes[i], &single[0], &single[1], &single[2], &single[3], &single[4], &single[5],
+		                     &single[6], &single[7], &single[8] );
+		CHECK( memcmp( results + i * 9, single, sizeof( single ) ) == 0,
+		       "batches: transform of node %d differs from h3dGetNodeTransform", i );
+		CHECK( fabsf( single[0] - transforms[i * 9] ) < 0.001f && fabsf( single[8] - transforms[i * 9 + 8] ) < 0.001f,
+		       "batches: transform of node %d not set", i );
+	}
+
+	// Matrices, set for the models only and compared with the single node versions
+	float mats[count * 16];
+	for( int i = 0; i < count * 16; ++i ) mats[i] = (i % 16) % 5 == 0 ? 1.0f : 0.0f;
+	for( int i = 0; i < count; ++i ) mats[i * 16 + 12] = (float)(i + 1);
+	mats[3 * 16 + 14] = 20.0f;
+	H3DNode models[count] = { model0, 0, removed, model1, 0, 0 };
+	CHECK( h3dSetNodeTransMatBatch( models, count, mats ) == 2, "batches: set matrix count wrong" );
+
+	float relMats[count * 16], absMats[count * 16];
+	for( int i = 0; i < count * 16; ++i ) relMats[i] = absMats[i] = 7.0f;
+	CHECK( h3dGetNodeTransMatsBatch( nodes, count, relMats, absMats ) == 4, "batches: get matrices count wrong" );
+	for( int i = 0; i < count; ++i )
+	{
+		if( !valid[i] )
+		{
+			CHECK( isZero( relMats + i * 16, 16 ) && isZero( absMats + i * 16, 16 ),
+			       "batches: matrices of invalid node %d not zeroed", i );
+			continue;
+		}
+		const float *relMat = 0x0, *absMat = 0x0;
+		h3dGetNodeTransMats( nodes[i], &relMat, &absMat );
+		CHECK( memcmp( relMats + i * 16, relMat, 16 * sizeof( float ) ) == 0 &&
+		       memcmp( absMats + i * 16, absMat, 16 * sizeof( float ) ) == 0,
+		       "batches: matrices of node %d differ from h3dGetNodeTransMats", i );
+		if( models[i] != 0 )
+			CHECK( memcmp( relMat, mats + i * 16, 16 * sizeof( float ) ) == 0, "batches: matrix of node %d not set", i );
+	}
+	CHECK( absMats[1 * 16 + 12] != relMats[1 * 16 + 12], "batches: mesh matrices do not include parent" );
+
+	// Bounding boxes
+	float aabbs[count * 6];
+	for( int i = 0; i < count * 6; ++i ) aabbs[i] = 7.0f;
+	CHECK( h3dGetNodeAABBBatch( nodes, count, aabbs ) == 4, "batches: get AABB count wrong" );
+	for( int i = 0; i < count; ++i )
+	{
+		if( !valid[i] )
+		{
+			CHECK( isZero( aabbs + i * 6, 6 ), "batches: AABB of invalid node %d not zeroed", i );
+			continue;
+		}
+		float single[6];
+		h3dGetNodeAABB( nodes[i], &single[0], &single[1], &single[2], &single[3], &single[4], &single[5] );
+		CHECK( memcmp( aabbs + i * 6, single, sizeof( single ) ) == 0,
+		       "batches: AABB of node %d differs from h3dGetNodeAABB", i );
+	}
+
+	// Visibility, the first model is in front of the camera and the second one behind it
+	int visibility[count];
+	for( int i = 0; i < count; ++i ) visibility[i] = 7;
+	CHECK( h3dCheckNodeVisibilityBatch( nodes, count, cam, false, false, visibility ) == 2,
+	       "batches: visible count wrong" );
+	for( int i = 0; i < count; ++i )
+	{
+		int single = valid[i] ? h3dCheckNodeVisibility( nodes[i], cam, false, false ) : -1;
+		CHECK( visibility[i] == single, "batches: visibility of node %d is %d instead of %d", i, visibility[i], single );
+		CHECK( visibility[i] == (i < 2 ? 0 : -1), "batches: unexpected visibility %d of node %d", visibility[i], i );
+	}
+
+	h3dRelease();
+}
+
+
+// =================================================================================================
+// Tiled lighting
+// =================================================================================================
+
+static void testTiledLightGroups( const Options &opts )
+{
+	if( !initEngine() ) return;
+
+	H3DRes pipelineRes = h3dAddResource( H3DResTypes::Pipeline, "pipelines/deferred.pipeline.tiled.xml", 0 );
+	H3DRes lightMatRes = h3dAddResource( H3DResTypes::Material, "materials/light.material.xml", 0 );
+	CHECK( h3dutLoadResourcesFromDisk( opts.contentDir.c_str() ), "tiled: loading content failed" );
+	H3DRes otherMatRes = h3dCloneResource( lightMatRes, "tiledTestLight.material.xml" );
+
+	H3DNode cam = addCamera( pipelineRes );
+	h3dSetNodeTransform( cam, 0, 0, 30, 0, 0, 0, 1, 1, 1 );
+
+	// Enough lights of the first material for binning on several threads
+	const int numLights[2] = { 300, 3 };
+	for( int i = 0; i < numLights[0] + numLights[1]; ++i )
+	{
+		H3DNode light = h3dAddLightNode( H3DRootNode, "TiledLight", i < numLights[0] ? lightMatRes : otherMatRes,
+		                                 "LIGHTING", "SHADOWMAP" );
+		h3dSetNodeTransform( light, (float)(i % 7) - 3.0f, (float)(i % 5) - 2.0f, 0, -90.0f, 0, 0, 1, 1, 1 );
+		h3dSetNodeParamF( light, H3DLight::RadiusF, 0, 5.0f );
+		h3dSetNodeParamF( light, H3DLight::FovF, 0, 90.0f );
+		h3dSetNodeParamI( light, H3DLight::ShadowMapCountI, 0 );
+	}
+
+	// Lights are only added to the render views after their first update
+	h3dRender( cam );
+	h3dFinalizeFrame();
+	h3dGetStat( H3DStats::LightPassCount, true );
+	h3dGetStat( H3DStats::TiledLightCount, true );
+	h3dRender( cam );
+	h3dFinalizeFrame();
+
+	// All lights are shaded by tiled passes, one per light material
+	float tiledLights = h3dGetStat( H3DStats::TiledLightCount, true );
+	float lightPasses = h3dGetStat( H3DStats::LightPassCount, true );
+	CHECK( tiledLights == (float)(numLights[0] + numLights[1]), "tiled: %.0f lights tiled", tiledLights );
+	CHECK( lightPasses == 2.0f, "tiled: %.0f light passes instead of one per material", lightPasses );
+
+	h3dRelease();
+}
+
+
+// =================================================================================================
+// Texture arrays
+// =================================================================================================
+
+static string textureArrayXML( const char *layer0, const char *layer1, const char *layer2 )
+{
+	return string( "<TextureArray>\n\t<Layer map=\"" ) + layer0 + "\" />\n\t<Layer map=\"" + layer1 +
+	       "\" />\n\t<Layer map=\"" + layer2 + "\" />\n</TextureArray>\n";
+}
+
+
+static string tgaImage( int size )
+{
+	// Uncompressed 32 bit TGA, origin top left
+	unsigned char header[18] = { 0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	                             (unsigned char)size, 0, (unsigned char)size, 0, 32, 0x28 };
+	return string( (const char *)header, sizeof( header ) ) + string( size * size * 4, (char)128 );
+}
+
+
+static void testTextureArrays()
+{
+	if( !initEngine() ) return;
+
+	const int noMips = H3DResFlags::NoTexMipmaps;
+	h3dCreateTexture( "arrayLayer0", 16, 16, H3DFormats::TEX_BGRA8, noMips );
+	h3dCreateTexture( "arrayLayer1", 16, 16, H3DFormats::TEX_BGRA8, noMips );
+	h3dCreateTexture( "arrayLayer2", 16, 16, H3DFormats::TEX_BGRA8, noMips );
+	h3dCreateTexture( "arraySmallLayer", 8, 8, H3DFormats::TEX_BGRA8, noMips );
+	h3dCreateTexture( "arrayFloatLayer", 16, 16, H3DFormats::TEX_RGBA16F, noMips );
+
+	// Layers that are already loaded are copied when the array is loaded
+	H3DRes arrayRes = h3dAddResource( H3DResTypes::Texture, "testArray", noMips );
+	string data = textureArrayXML( "arrayLayer0", "arrayLayer1", "arrayLayer2" );
+	CHECK( h3dLoadResource( arrayRes, data.c_str(), (int)data.size() ), "texarray: loading failed" );
+	CHECK( h3dGetResParamI( arrayRes, H3DTexRes::TextureElem, 0, H3DTexRes::TexSliceCountI ) == 3,
+	       "texarray: %d slices instead of 3",
+	       h3dGetResParamI( arrayRes, H3DTexRes::TextureElem, 0, H3DTexRes::TexSliceCountI ) );
+	CHECK( h3dGetResParamI( arrayRes, H3DTexRes::TextureElem, 0, H3DTexRes::TexFormatI ) == H3DFormats::TEX_BGRA8,
+	       "texarray: format not taken over from the layers" );
+	CHECK( h3dGetResParamI( arrayRes, H3DTexRes::ImageElem, 0, H3DTexRes::ImgWidthI ) == 16,
+	       "texarray: size not taken over from the layers" );
+
+	// Slice counts of plain textures
+	H3DRes layerRes = h3dFindResource( H3DResTypes::Texture, "arrayLayer0" );
+	CHECK( h3dGetResParamI( layerRes, H3DTexRes::TextureElem, 0, H3DTexRes::TexSliceCountI ) == 1,
+	       "texarray: 2D texture does not have one slice" );
+	H3DRes cubeRes = h3dCreateTexture( "arrayCube", 16, 16, H3DFormats::TEX_BGRA8, noMips | H3DResFlags::TexCubemap );
+	CHECK( h3dGetResParamI( cubeRes, H3DTexRes::TextureElem, 0, H3DTexRes::TexSliceCountI ) == 6,
+	       "texarray: cube map does not have six slices" );
+
+	// Layers must match in size and format
+	H3DRes sizeRes = h3dAddResource( H3DResTypes::Texture, "testArraySize", noMips );
+	data = textureArrayXML( "arrayLayer0", "arraySmallLayer", "arrayLayer2" );
+	CHECK( !h3dLoadResource( sizeRes, data.c_str(), (int)data.size() ), "texarray: layers of different size accepted" );
+	CHECK( h3dGetResParamI( sizeRes, H3DTexRes::TextureElem, 0, H3DTexRes::TexSliceCountI ) == 0,
+	       "texarray: failed array has slices" );
+
+	H3DRes formatRes = h3dAddResource( H3DResTypes::Texture, "testArrayFormat", noMips );
+	data = textureArrayXML( "arrayFloatLayer", "arrayLayer1", "arrayLayer2" );
+	CHECK( !h3dLoadResource( formatRes, data.c_str(), (int)data.size() ), "texarray: layers of different format accepted" );
+
+	// Layers loaded later complete the array, reloading them with another size breaks it
+	H3DRes lateRes = h3dAddResource( H3DResTypes::Texture, "testArrayLate", noMips );
+	data = textureArrayXML( "arrayLayer0", "arrayLateLayer.tga", "arrayLayer2" );
+	CHECK( h3dLoadResource( lateRes, data.c_str(), (int)data.size() ), "texarray: loading with pending layer failed" );
+	CHECK( h3dGetResParamI( lateRes, H3DTexRes::ImageElem, 0, H3DTexRes::ImgWidthI ) != 16,
+	       "texarray: assembled before all layers were loaded" );
+
+	H3DRes lateLayerRes = h3dFindResource( H3DResTypes::Texture, "arrayLateLayer.tga" );
+	string image = tgaImage( 16 );
+	CHECK( h3dLoadResource( lateLayerRes, image.c_str(), (int)image.size() ), "texarray: loading layer failed" );
+	CHECK( h3dGetResParamI( lateRes, H3DTexRes::ImageElem, 0, H3DTexRes::ImgWidthI ) == 16,
+	       "texarray: not assembled after the last layer was loaded" );
+	CHECK( h3dGetResParamI( lateRes, H3DTexRes::TextureElem, 0, H3DTexRes::TexSliceCountI ) == 3,
+	       "texarray: %d slices after late assembly",
+	       h3dGetResParamI( lateRes, H3DTexRes::TextureElem, 0, H3DTexRes::TexSliceCountI ) );
+
+	image = tgaImage( 8 );
+	CHECK( h3dReloadResource( lateLayerRes, image.c_str(), (int)image.size() ) == 1, "texarray: reloading layer failed" );
+	CHECK( h3dGetResParamI( lateRes, H3DTexRes::TextureElem, 0, H3DTexRes::TexSliceCountI ) == 0,
+	       "texarray: array kept layer of different size" );
+	CHECK( h3dGetResParamI( arrayRes, H3DTexRes::TextureElem, 0, H3DTexRes::TexSliceCountI ) == 3,
+	       "texarray: unrelated array changed" );
+
+	h3dRelease();
+}
+
+
+// =================================================================================================
+// Compute synchronization
+// =================================================================================================
+
+#ifdef H3D_TEST_ENGINE_INTERNALS
+
+static RDI_Null::RenderDeviceNull &getNullDevice()
+{
+	return *(RDI_Null::RenderDeviceNull *)Modules::renderer().getRenderDevice();
+}
+
+
+static void testComputeBarriers( const Options &opts )
+{
+	typedef RDI_Null::RDICommandNull Cmd;
+	
+	if( !initEngine() ) return;
+
+	H3DRes compBufRes = h3dAddResource( H3DResTypes::ComputeBuffer, "CompBuf", H3DResFlags::NoQuery );
+	h3dSetResParamI( compBufRes, H3DComputeBufRes::ComputeBufElem, 0, H3DComputeBufRes::CompBufDataSizeI, 1024 );
+	H3DRes argsBufRes = h3dAddResource( H3DResTypes::ComputeBuffer, "ArgsBuf", H3DResFlags::NoQuery );
+	h3dSetResParamI( argsBufRes, H3DComputeBufRes::ComputeBufElem, 0, H3DComputeBufRes::CompBufDataSizeI, 32 );
+
+	// The second dispatch reads the buffer and its group counts written by the first one
+	writeFile( opts.workDir + "/computeTest.pipeline.xml",
+		"<Pipeline>\n\t<CommandQueue>\n\t\t<Stage id=\"Compute\">\n"
+		"\t\t\t<DispatchCompute material=\"materials/compute.material.xml\" context=\"COMPUTE\" x=\"4\" y=\"2\" z=\"3\" "
+		"write=\"CompBuf,ArgsBuf\" />\n"
+		"\t\t\t<DispatchCompute material=\"materials/compute.material.xml\" context=\"COMPUTE\" indirectBuffer=\"ArgsBuf\" "
+		"indirectOffset=\"16\" read=\"CompBuf\" />\n"
+		"\t\t</Stage>\n\t</CommandQueue>\n</Pipeline>\n" );
+	H3DRes pipelineRes = h3dAddResource( H3DResTypes::Pipeline, "computeTest.pipeline.xml", 0 );
+	string dirs = opts.workDir + "|" + opts.contentDir;
+	CHECK( h3dutLoadResourcesFromDisk( dirs.c_str() ), "compute: loading content failed" );
+
+	uint32 compBuf = ((ComputeBufferResource *)Modules::resMan().resolveResHandle( compBufRes ))->getBufferObject();
+	uint32 argsBuf = ((ComputeBufferResource *)Modules::resMan().resolveResHandle( argsBufRes ))->getBufferObject();
+	
+	H3DNode cam = addCamera( pipelineRes );
+	getNullDevice().setCommandRecording( true );
+	h3dRender( cam );
+	h3dFinalizeFrame();
+
+	// Reading back the results needs a barrier before mapping
+	h3dMapResStream( compBufRes, H3DComputeBufRes::ComputeBufElem, 0, 0, true, false );
+	h3dUnmapResStream( compBufRes );
+
+	// Mapping again does not need another barrier
+	h3dMapResStream( compBufRes, H3DComputeBufRes::ComputeBufElem, 0, 0, true, false );
+	h3dUnmapResStream( compBufRes );
+
+	const vector< Cmd > &cmds = getNullDevice().getRecordedCommands();
+	const Cmd expected[] = {
+		Cmd( Cmd::Compute, 4, 2, 3 ),
+		Cmd( Cmd::MemoryBarrier, StorageBufferBarrier | IndirectBufferBarrier, 0, 0 ),
+		Cmd( Cmd::ComputeIndirect, argsBuf, 16, 0 ),
+		Cmd( Cmd::MemoryBarrier, BufferUpdateBarrier, 0, 0 ),
+		Cmd( Cmd::MapBuffer, compBuf, 0, 1024 ),
+		Cmd( Cmd::MapBuffer, compBuf, 0, 1024 )
+	};
+	const size_t numExpected = sizeof( expected ) / sizeof( expected[0] );
+	
+	CHECK( cmds.size() == numExpected, "compute: %d commands recorded instead of %d", (int)cmds.size(), (int)numExpected );
+	for( size_t i = 0; i < numExpected && i < cmds.size(); ++i )
+	{
+		CHECK( cmds[i].type == expected[i].type && memcmp( cmds[i].args, expected[i].args, sizeof( cmds[i].args ) ) == 0,
+		       "compute: command %d is %d (%u, %u, %u) instead of %d (%u, %u, %u)", (int)i,
+		       (int)cmds[i].type, cmds[i].args[0], cmds[i].args[1], cmds[i].args[2],
+		       (int)expected[i].type, expected[i].args[0], expected[i].args[1], expected[i].args[2] );
+	}
+
+	getNullDevice().setCommandRecording( false );
+	h3dRelease();
+}
+
+
+// =================================================================================================
+// Buffer arenas
+// =================================================================================================
+
+static void testBufferArena()
+{
+	RDIBufferArena arena;
+	arena.reset( 100 );
+
+	// First fit from the front
+	uint32 a = 0, b = 0, c = 0, d = 0;
+	CHECK( arena.alloc( 30, a ) && arena.alloc( 30, b ) && arena.alloc( 30, c ), "arena: allocation failed" );
+	CHECK( a == 0 && b == 30 && c == 60, "arena: ranges at %u, %u, %u instead of packed", a, b, c );
+	CHECK( arena.getUsed() == 90, "arena: %u elements used instead of 90", arena.getUsed() );
+
+	// Out of space, the caller has to grow or compact the arena
+	CHECK( !arena.alloc( 20, d ), "arena: allocated more than the capacity" );
+	CHECK( arena.getUsed() == 90, "arena: failed allocation changed the used size" );
+
+	// Holes are reused and count as fragmentation
+	arena.release( b, 30 );
+	CHECK( arena.getFragmentedSize() == 30, "arena: fragmented size %u instead of 30", arena.getFragmentedSize() );
+	CHECK( arena.alloc( 20, d ) && d == 30, "arena: hole not reused" );
+
+	// Released ranges are merged with free neighbours on both sides
+	arena.release( a, 30 );
+	arena.release( d, 20 );
+	CHECK( arena.getFragmentedSize() == 60, "arena: fragmented size %u instead of 60", arena.getFragmentedSize() );
+	arena.release( c, 30 );
+	CHECK( arena.getUsed() == 0 && arena.getFragmentedSize() == 0, "arena: free ranges not merged" );
+	CHECK( arena.alloc( 100, a ) && a == 0, "arena: merged range cannot hold the whole capacity" );
+
+	// Growing adds free space at the end
+	arena.grow( 150 );
+	CHECK( arena.getCapacity() == 150 && arena.alloc( 50, b ) && b == 100, "arena: grown space not allocated" );
+}
+
+
+static H3DRes createGeometry( const char *name, int numVertices )
+{
+	vector< float > positions( numVertices * 3, 0.0f );
+	vector< unsigned int > indices( numVertices );
+	for( int i = 0; i < numVertices; ++i ) indices[i] = (unsigned int)i;
+
+	return h3dutCreateGeometryRes( name, numVertices, numVertices, &positions[0], &indices[0],
+	                               0x0, 0x0, 0x0, 0x0, 0x0 );
+}
+
+
+static GeometryResource *getGeometry( H3DRes res )
+{
+	return (GeometryResource *)Modules::resMan().resolveResHandle( res );
+}
+
+
+static void removeGeometry( H3DRes res )
+{
+	h3dRemoveResource( res );
+	h3dReleaseUnusedResources();
+}
+
+
+static void testGeometryArena()
+{
+	if( !initEngine() ) return;
+
+	// Geometry is placed in shared buffers, ranges are counted in vertices and indices so that the
+	// byte offsets are always aligned to the element size
+	H3DRes geoA = createGeometry( "arenaGeoA", 3000 );
+	H3DRes geoB = createGeometry( "arenaGeoB", 6000 );
+	H3DRes geoC = createGeometry( "arenaGeoC", 3000 );
+	uint32 geoObj = getGeometry( geoA )->getGeometryInfo();
+	CHECK( geoObj != 0 && getGeometry( geoB )->getGeometryInfo() == geoObj && getGeometry( geoC )->getGeometryInfo() == geoObj,
+	       "geoarena: geometries do not share the arena buffers" );
+	CHECK( getGeometry( geoA )->getBaseVertex() == 0 && getGeometry( geoB )->getBaseVertex() == 3000 &&
+	       getGeometry( geoC )->getBaseVertex() == 9000, "geoarena: unexpected base vertices" );
+	CHECK( getGeometry( geoB )->getFirstIndex() == 3000 && getGeometry( geoC )->getFirstIndex() == 9000,
+	       "geoarena: unexpected first indices" );
+
+	// Geometry that does not fit grows the buffers, resident geometry keeps its place
+	H3DRes geoBig = createGeometry( "arenaGeoBig", 70002 );
+	CHECK( getGeometry( geoBig )->getGeometryInfo() == getGeometry( geoA )->getGeometryInfo(),
+	       "geoarena: large geometry not placed in the arena" );
+	CHECK( getGeometry( geoBig )->getBaseVertex() == 12000 && getGeometry( geoC )->getBaseVertex() == 9000,
+	       "geoarena: unexpected base vertices after growing" );
+
+	// Small holes are reused without moving other geometry
+	removeGeometry( geoB );
+	H3DRes geoD = createGeometry( "arenaGeoD", 4002 );
+	CHECK( getGeometry( geoD )->getBaseVertex() == 3000 && getGeometry( geoC )->getBaseVertex() == 9000,
+	       "geoarena: hole of removed geometry not reused" );
+
+	// Large holes compact the arena, keeping the order of the geometry
+	removeGeometry( geoBig );
+	removeGeometry( geoA );
+	CHECK( getGeometry( geoD )->getBaseVertex() == 0 && getGeometry( geoC )->getBaseVertex() == 4002 &&
+	       getGeometry( geoC )->getFirstIndex() == 4002, "geoarena: arena not compacted (base vertices %u, %u)",
+	       getGeometry( geoD )->getBaseVertex(), getGeometry( geoC )->getBaseVertex() );
+
+	h3dRelease();
+}
+
+
+// =================================================================================================
+// Bindless material textures
+// =================================================================================================
+
+static bool texTableContains( uint32 texObj )
+{
+	// Handles of the Null backend store the texture object above the sampler state
+	const vector< uint64 > &table = Modules::renderer().getMaterialTexTable();
+	for( size_t i = 0; i < table.size(); ++i )
+	{
+		if( ((table[i] & ~((uint64)1 << 63)) >> 16) == texObj ) return true;
+	}
+
+	return false;
+}
+
+
+static uint32 getTexObject( H3DRes texRes )
+{
+	return ((TextureResource *)Modules::resMan().resolveResHandle( texRes ))->getTexObject();
+}
+
+
+static string texTableMaterial( const char *albedoMap )
+{
+	return string( "<Material>\n\t<Shader source=\"texTableTest.shader\" />\n\t<Sampler name=\"albedoMap\" map=\"" ) +
+	       albedoMap + "\" />\n</Material>\n";
+}
+
+
+static void testMaterialTexTable( const Options &opts )
+{
+	if( !initEngine() ) return;
+
+	// The Null backend uses the OpenGL4 contexts and finds uniforms in the source, so materialTexBase
+	// enables the texture table
+	writeFile( opts.workDir + "/texTableTest.shader",
+		"[[FX]]\n\nsampler2D albedoMap;\nsampler2D normalMap;\n\n"
+		"OpenGL4\n{\n\tcontext AMBIENT\n\t{\n\t\tVertexShader = compile GLSL VS_GENERAL;\n"
+		"\t\tPixelShader = compile GLSL FS_AMBIENT;\n\t}\n}\n\n"
+		"[[VS_GENERAL]]\n\nuniform mat4 viewProjMat;\nuniform mat4 worldMat;\nattribute vec3 vertPos;\n\n"
+		"void main( void )\n{\n\tgl_Position = viewProjMat * worldMat * vec4( vertPos, 1.0 );\n}\n\n"
+		"[[FS_AMBIENT]]\n\nuniform float materialTexBase;\n\n"
+		"void main( void )\n{\n\tgl_FragColor = vec4( materialTexBase );\n}\n" );
+	H3DRes texA = h3dCreateTexture( "texTableA", 16, 16, H3DFormats::TEX_BGRA8, H3DResFlags::NoTexMipmaps );
+	H3DRes texB = h3dCreateTexture( "texTableB", 16, 16, H3DFormats::TEX_BGRA8, H3DResFlags::NoTexMipmaps );
+	H3DRes texC = h3dCreateTexture( "texTableC", 16, 16, H3DFormats::TEX_BGRA8, H3DResFlags::NoTexMipmaps );
+	writeFile( opts.workDir + "/texTableA.material.xml", texTableMaterial( "texTableA" ) );
+	writeFile( opts.workDir + "/texTableB.material.xml", texTableMaterial( "texTableB" ) );
+	writeFile( opts.workDir + "/texTableC.material.xml", texTableMaterial( "texTableC" ) );
+
+	H3DRes pipelineRes = h3dAddResource( H3DResTypes::Pipeline, "pipelines/forward.pipeline.xml", 0 );
+	H3DRes sphereRes = h3dAddResource( H3DResTypes::SceneGraph, "models/sphere/sphere.scene.xml", 0 );
+	H3DRes matA = h3dAddResource( H3DResTypes::Material, "texTableA.material.xml", 0 );
+	H3DRes matB = h3dAddResource( H3DResTypes::Material, "texTableB.material.xml", 0 );
+	H3DRes matC = h3dAddResource( H3DResTypes::Material, "texTableC.material.xml", 0 );
+	string dirs = opts.workDir + "|" + opts.contentDir;
+	CHECK( h3dutLoadResourcesFromDisk( dirs.c_str() ), "textable: loading content failed" );
+
+	H3DNode cam = addCamera( pipelineRes );
+	h3dSetNodeTransform( cam, 0, 0, 10, 0, 0, 0, 1, 1, 1 );
+	H3DNode meshA = findMesh( h3dAddNodes( H3DRootNode, sphereRes ) );
+	H3DNode modelB = h3dAddNodes( H3DRootNode, sphereRes );
+	H3DNode meshB = findMesh( modelB );
+	h3dSetNodeTransform( meshA, -2, 0, 0, 0, 0, 0, 1, 1, 1 );
+	h3dSetNodeTransform( meshB, 2, 0, 0, 0, 0, 0, 1, 1, 1 );
+	h3dSetNodeParamI( meshA, H3DMesh::MatResI, matA );
+	h3dSetNodeParamI( meshB, H3DMesh::MatResI, matB );
+
+	// Every material gets one entry per shader sampler
+	h3dRender( cam );
+	h3dFinalizeFrame();
+	CHECK( Modules::renderer().getMaterialTexTable().size() == 4, "textable: %d entries instead of 4",
+	       (int)Modules::renderer().getMaterialTexTable().size() );
+	CHECK( texTableContains( getTexObject( texA ) ) && texTableContains( getTexObject( texB ) ),
+	       "textable: material textures missing" );
+
+	// Changed samplers are picked up in the next frame
+	int samplerIdx = h3dFindResElem( matA, H3DMatRes::SamplerElem, H3DMatRes::SampNameStr, "albedoMap" );
+	h3dSetResParamI( matA, H3DMatRes::SamplerElem, samplerIdx, H3DMatRes::SampTexResI, texC );
+	h3dRender( cam );
+	h3dFinalizeFrame();
+	CHECK( texTableContains( getTexObject( texC ) ) && !texTableContains( getTexObject( texA ) ),
+	       "textable: changed sampler not updated" );
+
+	// Entries of removed materials are reused
+	h3dRemoveNode( modelB );
+	h3dRemoveResource( matB );
+	h3dReleaseUnusedResources();
+	CHECK( h3dGetResType( matB ) == H3DResTypes::Undefined, "textable: material was not released" );
+	h3dSetNodeParamI( meshA, H3DMesh::MatResI, matC );
+	h3dRender( cam );
+	h3dFinalizeFrame();
+	CHECK( Modules::renderer().getMaterialTexTable().size() == 4, "textable: %d entries after reusing a range",
+	       (int)Modules::renderer().getMaterialTexTable().size() );
+	CHECK( !texTableContains( getTexObject( texB ) ), "textable: entries of removed material not replaced" );
+
+	h3dRelease();
+}
+
+
+// =================================================================================================
+// Render graph
+// =================================================================================================
+
+static int findStage( const PipelineResource &pipeline, const char *id )
+{
+	for( size_t i = 0; i < pipeline.getStages().size(); ++i )
+	{
+		if( pipeline.getStages()[i].id == id ) return (int)i;
+	}
+
+	return -1;
+}
+
+
+static const RenderTarget *findTarget( const PipelineResource &pipeline, const char *id )
+{
+	for( size_t i = 0; i < pipeline.getRenderTargets().size(); ++i )
+	{
+		if( pipeline.getRenderTargets()[i].id == id ) return &pipeline.getRenderTargets()[i];
+	}
+
+	return 0x0;
+}
+
+
+static void checkRenderGraph( const PipelineResource &pipeline, bool debugEnabled )
+{
+	const RenderTarget *unused = findTarget( pipeline, "UNUSED" ), *readback = findTarget( pipeline, "READBACK" );
+	const RenderTarget *pass1 = findTarget( pipeline, "PASS1" ), *pass2 = findTarget( pipeline, "PASS2" );
+	const RenderTarget *pass3 = findTarget( pipeline, "PASS3" );
+	if( !unused || !readback || !pass1 || !pass2 || !pass3 ) return;
+
+	// The output of the unused stage is only consumed by the debug stage
+	const PipelineStage &unusedStage = pipeline.getStages()[findStage( pipeline, "Unused" )];
+	CHECK( unusedStage.culled == !debugEnabled, "rendergraph: unused stage %s", unusedStage.culled ? "culled" : "kept" );
+	CHECK( unused->culled == !debugEnabled && (unused->rendBuf != 0) == debugEnabled,
+	       "rendergraph: unused target %s", unused->culled ? "culled" : "kept" );
+
+	// Persistent targets are kept along with the stages writing them and never share their buffer
+	CHECK( !pipeline.getStages()[findStage( pipeline, "Readback" )].culled, "rendergraph: stage of persistent target culled" );
+	CHECK( !readback->culled && readback->aliasOf < 0 && readback->rendBuf != 0 &&
+	       readback->rendBuf != unused->rendBuf, "rendergraph: persistent target culled or aliased" );
+
+	// PASS1 is last read while PASS2 is written, PASS3 is written afterwards
+	CHECK( !pass1->culled && !pass2->culled && !pass3->culled, "rendergraph: chain targets culled" );
+	CHECK( pass3->rendBuf == pass1->rendBuf && pass3->aliasOf >= 0, "rendergraph: PASS3 does not share the buffer of PASS1" );
+	CHECK( pass2->rendBuf != pass1->rendBuf && pass2->rendBuf != pass3->rendBuf && pass2->aliasOf < 0,
+	       "rendergraph: overlapping targets share a buffer" );
+}
+
+
+static void testRenderGraph( const Options &opts )
+{
+	if( !initEngine() ) return;
+
+	const char *drawQuad = "\t\t\t<DrawQuad material=\"materials/light.material.xml\" context=\"AMBIENT\" />\n";
+	writeFile( opts.workDir + "/renderGraphTest.pipeline.xml",
+		string( "<Pipeline>\n\t<Setup renderGraph=\"true\">\n"
+		"\t\t<RenderTarget id=\"UNUSED\" depthBuf=\"false\" numColBufs=\"1\" format=\"RGBA8\" scale=\"1.0\" />\n"
+		"\t\t<RenderTarget id=\"READBACK\" depthBuf=\"false\" numColBufs=\"1\" format=\"RGBA8\" scale=\"1.0\" "
+		"persistent=\"true\" />\n"
+		"\t\t<RenderTarget id=\"PASS1\" depthBuf=\"false\" numColBufs=\"1\" format=\"RGBA16F\" scale=\"0.5\" />\n"
+		"\t\t<RenderTarget id=\"PASS2\" depthBuf=\"false\" numColBufs=\"1\" format=\"RGBA16F\" scale=\"0.5\" />\n"
+		"\t\t<RenderTarget id=\"PASS3\" depthBuf=\"false\" numColBufs=\"1\" format=\"RGBA16F\" scale=\"0.5\" />\n"
+		"\t</Setup>\n\t<CommandQueue>\n" ) +
+		"\t\t<Stage id=\"Unused\">\n\t\t\t<SwitchTarget target=\"UNUSED\" />\n" + drawQuad + "\t\t</Stage>\n" +
+		"\t\t<Stage id=\"Readback\">\n\t\t\t<SwitchTarget target=\"READBACK\" />\n" + drawQuad + "\t\t</Stage>\n" +
+		"\t\t<Stage id=\"Pass1\">\n\t\t\t<SwitchTarget target=\"PASS1\" />\n" + drawQuad + "\t\t</Stage>\n" +
+		"\t\t<Stage id=\"Pass2\">\n\t\t\t<SwitchTarget target=\"PASS2\" />\n"
+		"\t\t\t<BindBuffer sampler=\"buf0\" sourceRT=\"PASS1\" bufIndex=\"0\" />\n" + drawQuad +
+		"\t\t\t<UnbindBuffers />\n\t\t</Stage>\n" +
+		"\t\t<Stage id=\"Pass3\">\n\t\t\t<SwitchTarget target=\"PASS3\" />\n"
+		"\t\t\t<BindBuffer sampler=\"buf0\" sourceRT=\"PASS2\" bufIndex=\"0\" />\n" + drawQuad +
+		"\t\t\t<UnbindBuffers />\n\t\t</Stage>\n" +
+		"\t\t<Stage id=\"Output\">\n\t\t\t<SwitchTarget target=\"\" />\n"
+		"\t\t\t<BindBuffer sampler=\"buf0\" sourceRT=\"PASS3\" bufIndex=\"0\" />\n" + drawQuad +
+		"\t\t\t<UnbindBuffers />\n\t\t</Stage>\n" +
+		"\t\t<Stage id=\"Debug\" enabled=\"false\">\n\t\t\t<SwitchTarget target=\"\" />\n"
+		"\t\t\t<BindBuffer sampler=\"buf0\" sourceRT=\"UNUSED\" bufIndex=\"0\" />\n" + drawQuad +
+		"\t\t\t<UnbindBuffers />\n\t\t</Stage>\n" +
+		"\t</CommandQueue>\n</Pipeline>\n" );
+	H3DRes pipelineRes = h3dAddResource( H3DResTypes::Pipeline, "renderGraphTest.pipeline.xml", 0 );
+	string dirs = opts.workDir + "|" + opts.contentDir;
+	CHECK( h3dutLoadResourcesFromDisk( dirs.c_str() ), "rendergraph: loading content failed" );
+
+	const PipelineResource &pipeline = *(PipelineResource *)Modules::resMan().resolveResHandle( pipelineRes );
+	CHECK( findTarget( pipeline, "UNUSED" ) && findTarget( pipeline, "READBACK" ) && findTarget( pipeline, "PASS1" ) &&
+	       findTarget( pipeline, "PASS2" ) && findTarget( pipeline, "PASS3" ), "rendergraph: render targets missing" );
+	H3DNode cam = addCamera( pipelineRes );
+	checkRenderGraph( pipeline, false );
+
+	// The application can read back the persistent target after rendering
+	h3dRender( cam );
+	h3dFinalizeFrame();
+	int width = 0, height = 0;
+	vector< float > pixels( 320 * 240 * 4 );
+	int pixelsSize = (int)(pixels.size() * sizeof( float ));
+	CHECK( h3dGetRenderTargetData( pipelineRes, "READBACK", 0, &width, &height, 0x0, &pixels[0], pixelsSize ) &&
+	       width == 320 && height == 240, "rendergraph: persistent target cannot be read back" );
+	CHECK( !h3dGetRenderTargetData( pipelineRes, "UNUSED", 0, 0x0, 0x0, 0x0, &pixels[0], pixelsSize ),
+	       "rendergraph: culled target can be read back" );
+
+	// Enabling the debug stage makes the unused target live, disabling it culls it again
+	int debugStage = findStage( pipeline, "Debug" );
+	h3dSetResParamI( pipelineRes, H3DPipeRes::StageElem, debugStage, H3DPipeRes::StageActivationI, 1 );
+	checkRenderGraph( pipeline, true );
+	h3dSetResParamI( pipelineRes, H3DPipeRes::StageElem, debugStage, H3DPipeRes::StageActivationI, 0 );
+	checkRenderGraph( pipeline, false );
+
+	h3dRender( cam );
+	h3dFinalizeFrame();
+
+	h3dRelease();
+}
+
+
+// =================================================================================================
+// Dynamic resolution
+// =================================================================================================
+
+static float renderDynResFrame( H3DNode cam, float fullResTime )
+{
+	// GPU time grows with the number of shaded pixels
+	float scale = h3dGetStat( H3DStats::DynResScale, false );
+	((RDI_Null::GPUTimerNull *)Modules::stats().getGPUTimer( EngineStats::FrameGPUTime ))->setTimeMS(
+		fullResTime * scale * scale );
+
+	h3dRender( cam );
+	h3dFinalizeFrame();
+
+	return h3dGetStat( H3DStats::DynResScale, false );
+}
+
+
+static bool findTargetViewport( uint32 rendBuf, uint32 *fbSize, uint32 *vpSize )
+{
+	typedef RDI_Null::RDICommandNull Cmd;
+	
+	const vector< Cmd > &cmds = getNullDevice().getRecordedCommands();
+	for( size_t i = 0; i + 1 < cmds.size(); ++i )
+	{
+		if( cmds[i].type == Cmd::RenderBuffer && cmds[i].args[0] == rendBuf && cmds[i + 1].type == Cmd::Viewport )
+		{
+			fbSize[0] = cmds[i].args[1]; fbSize[1] = cmds[i].args[2];
+			vpSize[0] = cmds[i + 1].args[0]; vpSize[1] = cmds[i + 1].args[1];
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+static void testDynamicResolution( const Options &opts )
+{
+	if( !initEngine() ) return;
+
+	H3DRes pipelineRes = h3dAddResource( H3DResTypes::Pipeline, "pipelines/deferred.pipeline.dynres.xml", 0 );
+	string dirs = opts.workDir + "|" + opts.contentDir;
+	CHECK( h3dutLoadResourcesFromDisk( dirs.c_str() ), "dynres: loading content failed" );
+	H3DNode cam = addCamera( pipelineRes );
+
+	// A full resolution frame takes twice the budget, the scale converges into the tolerance band
+	// of 85% to 100% of the target time
+	const float fullResTime = 20.0f, targetTime = 10.0f;
+	h3dSetOption( H3DOptions::DynResTargetTime, targetTime );
+	float scale = 1.0f, minScale = 1.0f;
+	for( int i = 0; i < 30; ++i )
+	{
+		scale = renderDynResFrame( cam, fullResTime );
+		minScale = std::min( minScale, scale );
+	}
+	float gpuTime = fullResTime * scale * scale;
+	CHECK( gpuTime >= targetTime * 0.85f && gpuTime <= targetTime, "dynres: scale %.3f gives %.2f ms", scale, gpuTime );
+	CHECK( minScale >= 0.5f, "dynres: scale dropped to %.3f below the minimum", minScale );
+
+	// The minimum scale wins over the time budget
+	h3dSetOption( H3DOptions::DynResMinScale, 0.8f );
+	minScale = 1.0f;
+	for( int i = 0; i < 10; ++i )
+	{
+		scale = renderDynResFrame( cam, fullResTime );
+		minScale = std::min( minScale, scale );
+	}
+	CHECK( minScale >= 0.8f && scale == 0.8f, "dynres: scale %.3f (lowest %.3f) with minimum 0.8", scale, minScale );
+
+	// Relative targets are drawn to a scaled viewport, their size and frameBufSize stay at full size
+	const PipelineResource &pipeline = *(PipelineResource *)Modules::resMan().resolveResHandle( pipelineRes );
+	uint32 gbuf = findTarget( pipeline, "GBUFFER" ) ? findTarget( pipeline, "GBUFFER" )->rendBuf : 0;
+	uint32 fbSize[2] = { 0 }, vpSize[2] = { 0 };
+	int width = 0, height = 0;
+	Modules::renderer().getRenderDevice()->getRenderBufferDimensions( gbuf, &width, &height );
+	CHECK( width == 320 && height == 240, "dynres: target allocated with %ix%i", width, height );
+	
+	getNullDevice().setCommandRecording( true );
+	renderDynResFrame( cam, fullResTime );
+	CHECK( findTargetViewport( gbuf, fbSize, vpSize ), "dynres: target not bound" );
+	CHECK( fbSize[0] == 320 && fbSize[1] == 240, "dynres: frame buffer size %ux%u", fbSize[0], fbSize[1] );
+	CHECK( vpSize[0] == 256 && vpSize[1] == 192, "dynres: viewport %ux%u instead of 256x192", vpSize[0], vpSize[1] );
+
+	// Without target time the full resolution is used again
+	h3dSetOption( H3DOptions::DynResTargetTime, 0 );
+	getNullDevice().setCommandRecording( true );
+	scale = renderDynResFrame( cam, fullResTime );
+	CHECK( scale == 1.0f, "dynres: scale %.3f without target time", scale );
+	CHECK( findTargetViewport( gbuf, fbSize, vpSize ) && vpSize[0] == 320 && vpSize[1] == 240,
+	       "dynres: viewport %ux%u without target time", vpSize[0], vpSize[1] );
+
+	getNullDevice().setCommandRecording( false );
+	h3dRelease();
+}
+
+
+// =================================================================================================
+// Asynchronous shader compilation
+// =================================================================================================
+
+static string asyncShaderMaterial( const char *flag )
+{
+	return string( "<Material>\n\t<Shader source=\"asyncTest.shader\" />\n\t<ShaderFlag name=\"" ) + flag +
+	       "\" />\n</Material>\n";
+}
+
+
+static uint32 getCombShader( uint32 combMask )
+{
+	H3DRes res = h3dFindResource( H3DResTypes::Shader, "asyncTest.shader" );
+	ShaderResource *shaderRes = (ShaderResource *)Modules::resMan().resolveResHandle( res );
+	ShaderContext *context = shaderRes != 0x0 ? shaderRes->findContext( "AMBIENT" ) : 0x0;
+	if( context == 0x0 ) return 0;
+
+	for( size_t i = 0; i < context->shaderCombs.size(); ++i )
+	{
+		if( context->shaderCombs[i].combMask == combMask && !context->shaderCombs[i].pending )
+			return context->shaderCombs[i].shaderObj;
+	}
+
+	return 0;
+}
+
+
+static void renderRecorded( H3DNode cam, vector< uint32 > &drawShaders, float &pendingShaders )
+{
+	typedef RDI_Null::RDICommandNull Cmd;
+	
+	getNullDevice().setCommandRecording( true );
+	h3dRender( cam );
+	h3dFinalizeFrame();
+
+	// Querying the stat finishes the combinations that have become ready
+	pendingShaders = h3dGetStat( H3DStats::PendingShaderCount, false );
+
+	drawShaders.clear();
+	const vector< Cmd > &cmds = getNullDevice().getRecordedCommands();
+	for( size_t i = 0; i < cmds.size(); ++i )
+	{
+		if( cmds[i].type == Cmd::Draw ) drawShaders.push_back( cmds[i].args[0] );
+	}
+	getNullDevice().setCommandRecording( false );
+}
+
+
+static void testAsyncShaders( const Options &opts )
+{
+	if( !initEngine() ) return;
+	h3dSetOption( H3DOptions::AsyncShaderCompilation, 1 );
+
+	// The Null backend reports every shader as pending on its first poll
+	writeFile( opts.workDir + "/asyncTest.shader",
+		"[[FX]]\n\nOpenGL4\n{\n\tcontext AMBIENT\n\t{\n\t\tVertexShader = compile GLSL VS_GENERAL;\n"
+		"\t\tPixelShader = compile GLSL FS_AMBIENT;\n\t}\n}\n\n"
+		"[[VS_GENERAL]]\n\nuniform mat4 viewProjMat;\nuniform mat4 worldMat;\nattribute vec3 vertPos;\n\n"
+		"void main( void )\n{\n\tgl_Position = viewProjMat * worldMat * vec4( vertPos, 1.0 );\n}\n\n"
+		"[[FS_AMBIENT]]\n\nvoid main( void )\n{\n#ifdef _F01_Red\n\tgl_FragColor = vec4( 1.0, 0.0, 0.0, 1.0 );\n"
+		"#else\n\tgl_FragColor = vec4( 1.0 );\n#endif\n#ifdef _F02_Half\n\tgl_FragColor *= 0.5;\n#endif\n}\n" );
+	writeFile( opts.workDir + "/asyncBase.material.xml", "<Material>\n\t<Shader source=\"asyncTest.shader\" />\n</Material>\n" );
+	writeFile( opts.workDir + "/asyncRed.material.xml", asyncShaderMaterial( "_F01_Red" ) );
+	writeFile( opts.workDir + "/asyncHalf.material.xml", asyncShaderMaterial( "_F02_Half" ) );
+
+	H3DRes pipelineRes = h3dAddResource( H3DResTypes::Pipeline, "pipelines/forward.pipeline.xml", 0 );
+	H3DRes sphereRes = h3dAddResource( H3DResTypes::SceneGraph, "models/sphere/sphere.scene.xml", 0 );
+	H3DRes matBase = h3dAddResource( H3DResTypes::Material, "asyncBase.material.xml", 0 );
+	string dirs = opts.workDir + "|" + opts.contentDir;
+	CHECK( h3dutLoadResourcesFromDisk( dirs.c_str() ), "asyncshader: loading content failed" );
+
+	H3DNode cam = addCamera( pipelineRes );
+	h3dSetNodeTransform( cam, 0, 0, 10, 0, 0, 0, 1, 1, 1 );
+	H3DNode mesh = findMesh( h3dAddNodes( H3DRootNode, sphereRes ) );
+	h3dSetNodeParamI( mesh, H3DMesh::MatResI, matBase );
+
+	// The base combination has no fallback, the mesh is skipped until it is compiled
+	vector< uint32 > draws;
+	float pending = 0;
+	renderRecorded( cam, draws, pending );
+	CHECK( pending > 0, "asyncshader: no pending shaders in the first frame" );
+	CHECK( draws.empty(), "asyncshader: %d draws with pending base combination", (int)draws.size() );
+	renderRecorded( cam, draws, pending );
+	uint32 baseShader = getCombShader( 0 );
+	CHECK( pending == 0, "asyncshader: %.0f shaders still pending", pending );
+	CHECK( baseShader != 0 && draws.size() == 1 && draws[0] == baseShader, "asyncshader: base combination not drawn" );
+
+	// A combination requested later is replaced by the base combination while it is pending
+	vector< string > flags( 1, "_F01_Red" );
+	H3DRes matRed = h3dAddResource( H3DResTypes::Material, "asyncRed.material.xml", 0 );
+	CHECK( h3dutLoadResourcesFromDisk( dirs.c_str() ), "asyncshader: loading material failed" );
+	h3dSetNodeParamI( mesh, H3DMesh::MatResI, matRed );
+	renderRecorded( cam, draws, pending );
+	CHECK( draws.size() == 1 && draws[0] == baseShader, "asyncshader: pending combination not replaced by base" );
+	renderRecorded( cam, draws, pending );
+	uint32 redShader = getCombShader( ShaderResource::calcCombMask( flags ) );
+	CHECK( redShader != 0 && redShader != baseShader && draws.size() == 1 && draws[0] == redShader,
+	       "asyncshader: requested combination not drawn after compilation" );
+
+	// Without fallback the mesh is skipped while its combination is pending
+	h3dSetOption( H3DOptions::AsyncShaderFallback, 0 );
+	flags[0] = "_F02_Half";
+	H3DRes matHalf = h3dAddResource( H3DResTypes::Material, "asyncHalf.material.xml", 0 );
+	CHECK( h3dutLoadResourcesFromDisk( dirs.c_str() ), "asyncshader: loading material failed" );
+	h3dSetNodeParamI( mesh, H3DMesh::MatResI, matHalf );
+	renderRecorded( cam, draws, pending );
+	CHECK( draws.empty(), "asyncshader: %d draws without fallback", (int)draws.size() );
+	renderRecorded( cam, draws, pending );
+	uint32 halfShader = getCombShader( ShaderResource::calcCombMask( flags ) );
+	CHECK( halfShader != 0 && draws.size() == 1 && draws[0] == halfShader,
+	       "asyncshader: combination not drawn after compilation without fallback" );
+	CHECK( pending == 0, "asyncshader: %.0f shaders still pending", pending );
+
+	h3dRelease();
+}
+
+
+// =================================================================================================
+// Frame pacing
+// =================================================================================================
+
+static void renderFenceFrame( H3DNode cam, vector< RDI_Null::RDICommandNull > &fenceCmds )
+{
+	typedef RDI_Null::RDICommandNull Cmd;
+	
+	getNullDevice().setCommandRecording( true );
+	h3dRender( cam );
+	h3dFinalizeFrame();
+
+	fenceCmds.clear();
+	const vector< Cmd > &cmds = getNullDevice().getRecordedCommands();
+	for( size_t i = 0; i < cmds.size(); ++i )
+	{
+		if( cmds[i].type == Cmd::CreateFence || cmds[i].type == Cmd::WaitFence || cmds[i].type == Cmd::DestroyFence )
+			fenceCmds.push_back( cmds[i] );
+	}
+	getNullDevice().setCommandRecording( false );
+}
+
+
+static void testFramePacing( const Options &opts )
+{
+	typedef RDI_Null::RDICommandNull Cmd;
+	
+	if( !initEngine() ) return;
+
+	H3DRes pipelineRes = h3dAddResource( H3DResTypes::Pipeline, "pipelines/forward.pipeline.xml", 0 );
+	CHECK( h3dutLoadResourcesFromDisk( opts.contentDir.c_str() ), "framepacing: loading content failed" );
+	H3DNode cam = addCamera( pipelineRes );
+
+	vector< Cmd > fenceCmds;
+	for( int maxFrames = 1; maxFrames <= 3; ++maxFrames )
+	{
+		// Every frame creates a fence and waits on the one of the frame that is maxFrames - 1 frames older
+		h3dSetOption( H3DOptions::MaxFramesInFlight, (float)maxFrames );
+		vector< uint32 > created, live;
+		for( int frame = 0; frame < 8; ++frame )
+		{
+			renderFenceFrame( cam, fenceCmds );
+			
+			uint32 waited = 0;
+			for( size_t i = 0; i < fenceCmds.size(); ++i )
+			{
+				uint32 fence = fenceCmds[i].args[0];
+				if( fenceCmds[i].type == Cmd::CreateFence )
+				{
+					created.push_back( fence );
+					live.push_back( fence );
+				}
+				else if( fenceCmds[i].type == Cmd::WaitFence )
+				{
+					CHECK( waited == 0, "framepacing: %i frames in flight, several waits in frame %i", maxFrames, frame );
+					waited = fence;
+				}
+				else
+				{
+					CHECK( fence == waited, "framepacing: %i frames in flight, fence %u destroyed without wait in frame %i",
+					       maxFrames, fence, frame );
+					live.erase( std::remove( live.begin(), live.end(), fence ), live.end() );
+				}
+			}
+			CHECK( created.size() == (size_t)frame + 1, "framepacing: %i frames in flight, %i fences in frame %i",
+			       maxFrames, (int)created.size(), frame );
+			if( created.size() != (size_t)frame + 1 ) break;
+			
+			uint32 expected = frame >= maxFrames - 1 ? created[frame - (maxFrames - 1)] : 0;
+			CHECK( waited == expected, "framepacing: %i frames in flight, frame %i waited on fence %u instead of %u",
+			       maxFrames, frame, waited, expected );
+			CHECK( live.size() == (size_t)std::min( frame + 1, maxFrames - 1 ),
+			       "framepacing: %i frames in flight, %i live fences in frame %i", maxFrames, (int)live.size(), frame );
+		}
+		
+		// Switching pacing off releases the fences that are still in flight
+		h3dSetOption( H3DOptions::MaxFramesInFlight, 0 );
+		renderFenceFrame( cam, fenceCmds );
+		for( size_t i = 0; i < fenceCmds.size(); ++i )
+		{
+			CHECK( fenceCmds[i].type == Cmd::DestroyFence, "framepacing: fence created or waited on without pacing" );
+			live.erase( std::remove( live.begin(), live.end(), fenceCmds[i].args[0] ), live.end() );
+		}
+		CHECK( live.empty(), "framepacing: %i fences leaked after %i frames in flight", (int)live.size(), maxFrames );
+	}
+
+	h3dRelease();
+}
+
+
+static void testLateLatchCamera( const Options &opts )
+{
+	if( !initEngine() ) return;
+
+	H3DRes pipelineRes = h3dAddResource( H3DResTypes::Pipeline, "pipelines/forward.pipeline.xml", 0 );
+	H3DRes sphereRes = h3dAddResource( H3DResTypes::SceneGraph, "models/sphere/sphere.scene.xml", 0 );
+	CHECK( h3dutLoadResourcesFromDisk( opts.contentDir.c_str() ), "latelatch: loading content failed" );
+
+	// Two spheres in front of the camera and one behind it
+	H3DNode cam = addCamera( pipelineRes );
+	h3dSetNodeTransform( cam, 0, 0, 10, 0, 0, 0, 1, 1, 1 );
+	h3dSetNodeTransform( h3dAddNodes( H3DRootNode, sphereRes ), -3, 0, 0, 0, 0, 0, 1, 1, 1 );
+	h3dSetNodeTransform( h3dAddNodes( H3DRootNode, sphereRes ), 3, 0, 0, 0, 0, 0, 1, 1, 1 );
+	h3dSetNodeTransform( h3dAddNodes( H3DRootNode, sphereRes ), 0, 0, 20, 0, 0, 0, 1, 1, 1 );
+	const CameraNode &camNode = *(CameraNode *)Modules::sceneMan().resolveNodeHandle( cam );
+
+	vector< uint32 > draws;
+	float pending = 0;
+	renderRecorded( cam, draws, pending );
+	size_t frontDraws = draws.size();
+	CHECK( frontDraws > 0, "latelatch: spheres in front of the camera not drawn" );
+
+	for( int lateLatch = 0; lateLatch <= 1; ++lateLatch )
+	{
+		// The camera is turned around after the frame was prepared
+		h3dSetOption( H3DOptions::LateLatchCamera, (float)lateLatch );
+		h3dSetNodeTransform( cam, 0, 0, 10, 0, 0, 0, 1, 1, 1 );
+		h3dPrepareRender( cam );
+		Matrix4f viewMatPrepared = camNode.getViewMat();
+		h3dSetNodeTransform( cam, 0, 1, 12, 0, 180, 0, 1, 1, 1 );
+		Matrix4f viewMatLatched = (Matrix4f::TransMat( 0, 1, 12 ) * Matrix4f::RotMat( 0, degToRad( 180 ), 0 )).inverted();
+		renderRecorded( cam, draws, pending );
+
+		// Culling results of the prepared frame are used in either case
+		CHECK( draws.size() == frontDraws, "latelatch: %i draws instead of %i with late latching %i",
+		       (int)draws.size(), (int)frontDraws, lateLatch );
+		
+		const Matrix4f &expected = lateLatch ? viewMatLatched : viewMatPrepared;
+		float maxDiff = 0;
+		for( int i = 0; i < 16; ++i )
+			maxDiff = std::max( maxDiff, fabsf( camNode.getViewMat().x[i] - expected.x[i] ) );
+		CHECK( maxDiff < 1e-5f, "latelatch: view matrix differs by %f with late latching %i", maxDiff, lateLatch );
+		Vec3f pos = camNode.getAbsPos();
+		Vec3f expectedPos = lateLatch ? Vec3f( 0, 1, 12 ) : Vec3f( 0, 0, 10 );
+		CHECK( (pos - expectedPos).length() < 1e-5f, "latelatch: camera at %.2f %.2f %.2f with late latching %i",
+		       pos.x, pos.y, pos.z, lateLatch );
+	}
+
+	// A regular frame culls with the new transformation
+	renderRecorded( cam, draws, pending );
+	CHECK( draws.size() < frontDraws, "latelatch: %i draws after turning the camera around", (int)draws.size() );
+
+	h3dRelease();
+}
+
+
+// =================================================================================================
+// Shadow atlas
+// =================================================================================================
+
+static void renderShadowAtlasFrame( H3DNode cam, int &atlasBinds, int &shadowMapBinds )
+{
+	typedef RDI_Null::RDICommandNull Cmd;
+	
+	getNullDevice().setCommandRecording( true );
+	h3dRender( cam );
+	h3dFinalizeFrame();
+
+	// The atlas and the shadow map buffer are told apart by their size
+	atlasBinds = shadowMapBinds = 0;
+	const vector< Cmd > &cmds = getNullDevice().getRecordedCommands();
+	for( size_t i = 0; i < cmds.size(); ++i )
+	{
+		if( cmds[i].type != Cmd::RenderBuffer ) continue;
+		if( cmds[i].args[1] == 2048 && cmds[i].args[2] == 2048 ) ++atlasBinds;
+		else if( cmds[i].args[1] == 1024 && cmds[i].args[2] == 1024 ) ++shadowMapBinds;
+	}
+	getNullDevice().setCommandRecording( false );
+}
+
+
+static void testShadowAtlas( const Options &opts )
+{
+	if( !initEngine() ) return;
+	CHECK( h3dSetOption( H3DOptions::ShadowAtlasSize, 2048 ), "shadowatlas: atlas could not be created" );
+
+	H3DRes pipelineRes = h3dAddResource( H3DResTypes::Pipeline, "pipelines/forward.pipeline.xml", 0 );
+	H3DRes lightMatRes = h3dAddResource( H3DResTypes::Material, "materials/light.material.xml", 0 );
+	CHECK( h3dutLoadResourcesFromDisk( opts.contentDir.c_str() ), "shadowatlas: loading content failed" );
+
+	H3DNode cam = addCamera( pipelineRes );
+	h3dSetNodeTransform( cam, 0, 0, 30, 0, 0, 0, 1, 1, 1 );
+
+	// Regions of the 1024 shadow map size are halved until all lights fit, down to the minimum size of
+	// 128 which gives 256 regions; lights beyond that use the shadow map buffer
+	const int numLights[3] = { 3, 6, 260 };
+	const int regionSizes[3] = { 1024, 512, ShadowAtlasMinRegionSize };
+	int lightCount = 0;
+	for( int step = 0; step < 3; ++step )
+	{
+		for( ; lightCount < numLights[step]; ++lightCount )
+		{
+			H3DNode light = h3dAddLightNode( H3DRootNode, "AtlasLight", lightMatRes, "LIGHTING", "SHADOWMAP" );
+			h3dSetNodeTransform( light, (float)(lightCount % 7) - 3.0f, (float)(lightCount % 5) - 2.0f, 0, -90.0f, 0, 0, 1, 1, 1 );
+			h3dSetNodeParamF( light, H3DLight::RadiusF, 0, 5.0f );
+			h3dSetNodeParamF( light, H3DLight::FovF, 0, 90.0f );
+			h3dSetNodeParamI( light, H3DLight::ShadowMapCountI, 1 );
+		}
+
+		// Lights are only added to the render views after their first update
+		int atlasBinds = 0, shadowMapBinds = 0;
+		renderShadowAtlasFrame( cam, atlasBinds, shadowMapBinds );
+		renderShadowAtlasFrame( cam, atlasBinds, shadowMapBinds );
+
+		const vector< ShadowParameters > &params = Modules::renderer().getShadowParams();
+		CHECK( (int)params.size() == lightCount, "shadowatlas: %i shadow lights instead of %i", (int)params.size(), lightCount );
+		if( (int)params.size() != lightCount ) continue;
+
+		// The first lights in scene order are packed, the remaining ones fall back
+		const int regionSize = regionSizes[step];
+		const int numPacked = std::min( lightCount, (2048 / regionSize) * (2048 / regionSize) );
+		for( int i = 0; i < lightCount; ++i )
+		{
+			const ShadowParameters &p = params[i];
+			if( i >= numPacked )
+			{
+				CHECK( p.atlasX < 0, "shadowatlas: light %i of %i packed although the atlas is full", i, lightCount );
+				continue;
+			}
+			
+			// Regions including their borders lie in the atlas and do not overlap
+			CHECK( p.atlasSize == regionSize - 2 * ShadowAtlasBorder, "shadowatlas: light %i of %i has region size %i",
+			       i, lightCount, p.atlasSize );
+			int x0 = p.atlasX - ShadowAtlasBorder, y0 = p.atlasY - ShadowAtlasBorder;
+			int x1 = p.atlasX + p.atlasSize + ShadowAtlasBorder, y1 = p.atlasY + p.atlasSize + ShadowAtlasBorder;
+			CHECK( x0 >= 0 && y0 >= 0 && x1 <= 2048 && y1 <= 2048, "shadowatlas: light %i of %i outside of atlas at %i, %i",
+			       i, lightCount, p.atlasX, p.atlasY );
+			for( int j = 0; j < i; ++j )
+			{
+				const ShadowParameters &q = params[j];
+				bool overlap = x0 < q.atlasX + q.atlasSize + ShadowAtlasBorder && q.atlasX - ShadowAtlasBorder < x1 &&
+				               y0 < q.atlasY + q.atlasSize + ShadowAtlasBorder && q.atlasY - ShadowAtlasBorder < y1;
+				CHECK( !overlap, "shadowatlas: regions of lights %i and %i of %i overlap", j, i, lightCount );
+			}
+		}
+
+		// All packed lights are rendered with one atlas bind, every other light binds the shadow map buffer
+		CHECK( atlasBinds == 1, "shadowatlas: atlas bound %i times for %i lights", atlasBinds, lightCount );
+		CHECK( shadowMapBinds == lightCount - numPacked, "shadowatlas: shadow map buffer bound %i times for %i lights",
+		       shadowMapBinds, lightCount );
+	}
+
+	h3dRelease();
+}
+
+#endif
+
+
+// =================================================================================================
+// Pack files
+// =================================================================================================
+
+static bool packRoundTrip( const vector< uint8 > &data, size_t *compressedSize )
+{
+	vector< uint8 > compressed;
+	packLZCompress( data.empty() ? 0x0 : &data[0], data.size(), compressed );
+	if( compressedSize != 0x0 ) *compressedSize = compressed.size();
+
+	vector< uint8 > decompressed( data.size() + 1 );
+	if( !packLZDecompress( &compressed[0], compressed.size(), &decompressed[0], data.size() ) ) return false;
+	decompressed.resize( data.size() );
+
+	// Truncated output buffers must be rejected
+	if( !data.empty() && packLZDecompress( &compressed[0], compressed.size(), &decompressed[0], data.size() - 1 ) )
+		return false;
+
+	return decompressed == data;
+}
+
+
+static void testPackLZ()
+{
+	size_t compressedSize = 0;
+
+	vector< uint8 > data;
+	CHECK( packRoundTrip( data, &compressedSize ), "pack LZ: empty input" );
+	CHECK( compressedSize == 1, "pack LZ: empty input compressed to %d bytes", (int)compressedSize );
+
+	// Short and long literal-only blocks, the latter needs length extension bytes
+	const char *text = "Horde3D";
+	data.assign( text, text + strlen( text ) );
+	CHECK( packRoundTrip( data, 0x0 ), "pack LZ: short literal block" );
+
+	data.clear();
+	unsigned int state = 12345;
+	for( int i = 0; i < 1000; ++i )
+	{
+		state = state * 1664525u + 1013904223u;
+		data.push_back( (uint8)(state >> 24) );
+	}
+	CHECK( packRoundTrip( data, &compressedSize ), "pack LZ: literal-only block" );
+	CHECK( compressedSize >= data.size(), "pack LZ: random data unexpectedly compressed" );
+
+	// Run of a single byte, encoded as overlapping match longer than 15 bytes
+	data.assign( 600, 'a' );
+	CHECK( packRoundTrip( data, &compressedSize ), "pack LZ: run" );
+	CHECK( compressedSize < 32, "pack LZ: run compressed to %d bytes", (int)compressedSize );
+
+	// Repeated text with long matches and literals in between
+	data.clear();
+	const char *line = "<Material><Shader source=\"shaders/model.shader\"/></Material>\n";
+	for( int i = 0; i < 50; ++i )
+	{
+		data.insert( data.end(), line, line + strlen( line ) );
+		data.push_back( (uint8)('0' + i % 10) );
+	}
+	CHECK( packRoundTrip( data, &compressedSize ), "pack LZ: repeated text" );
+	CHECK( compressedSize < data.size() / 4, "pack LZ: repeated text compressed to %d of %d bytes",
+	       (int)compressedSize, (int)data.size() );
+
+	// Corrupt input
+	uint8 badOffset[] = { 0x10, 'x', 0x05, 0x00, 0x00 };
+	uint8 out[16];
+	CHECK( !packLZDecompress( badOffset, sizeof( badOffset ), out, sizeof( out ) ), "pack LZ: invalid offset accepted" );
+}
+
+
+static vector< uint8 > buildPack( const string &name, const string &data, uint32 size, uint32 compression )
+{
+	// Header, data, index with a single entry, names
+	vector< uint8 > pack( PackHeaderSize + data.size() + PackEntrySize + name.size() );
+	memcpy( &pack[PackHeaderSize], data.c_str(), data.size() );
+
+	PackHeader header;
+	header.version = PackVersion;
+	header.numEntries = 1;
+	header.indexOffset = PackHeaderSize + data.size();
+	header.namesOffset = header.indexOffset + PackEntrySize;
+	header.write( &pack[0] );
+
+	PackEntry entry;
+	entry.nameHash = packHashName( name );
+	entry.dataOffset = PackHeaderSize;
+	entry.storedSize = (uint32)data.size();
+	entry.size = size;
+	entry.nameOffset = 0;
+	entry.nameLength = (uint32)name.size();
+	entry.compression = compression;
+	entry.write( &pack[header.indexOffset] );
+	memcpy( &pack[header.namesOffset], name.c_str(), name.size() );
+
+	return pack;
+}
+
+
+static bool findPackEntry( const vector< uint8 > &pack, const string &name )
+{
+	PackHeader header;
+	PackEntry entry;
+	
+	return header.read( &pack[0], pack.size() ) &&
+	       packFindEntry( &pack[0], pack.size(), header, name, entry );
+}
+
+
+static void testPackIndex()
+{
+	const string name = "models/test.xml", data = "<Test/>";
+
+	CHECK( findPackEntry( buildPack( name, data, (uint32)data.size(), PackCompression::None ), name ),
+	       "pack index: valid entry not found" );
+	CHECK( !findPackEntry( buildPack( name, data, (uint32)data.size(), PackCompression::None ), "models/other.xml" ),
+	       "pack index: missing entry found" );
+
+	// Uncompressed entries are read with their uncompressed size from the mapping
+	CHECK( !findPackEntry( buildPack( name, data, 1 << 20, PackCompression::None ), name ),
+	       "pack index: uncompressed entry larger than its stored data accepted" );
+	CHECK( !findPackEntry( buildPack( name, data, (uint32)data.size(), 7 ), name ),
+	       "pack index: unknown compression accepted" );
+
+	// Stored data beyond the end of the pack
+	vector< uint8 > pack = buildPack( name, data, (uint32)data.size(), PackCompression::None );
+	PackEntry entry;
+	entry.read( &pack[PackHeaderSize + data.size()] );
+	entry.dataOffset = 0xFFFFFFFFFFFFFFF0ull;
+	entry.write( &pack[PackHeaderSize + data.size()] );
+	CHECK( !findPackEntry( pack, name ), "pack index: entry outside of pack accepted" );
+}
+
+
+// =================================================================================================
+// Main
+// =================================================================================================
+
+static bool parseArgs( int argc, char **argv, Options &opts )
+{
+	for( int i = 1; i < argc; ++i )
+	{
+		bool hasValue = i + 1 < argc;
+
+		if( strcmp( argv[i], "--content" ) == 0 && hasValue ) opts.contentDir = argv[++i];
+		else if( strcmp( argv[i], "--work-dir" ) == 0 && hasValue ) opts.workDir = argv[++i];
+		else
+		{
+			fprintf( stderr, "Unknown or incomplete argument '%s'\n", argv[i] );
+			return false;
+		}
+	}
+
+	if( opts.contentDir.empty() || opts.workDir.empty() )
+	{
+		fprintf( stderr, "Usage: Horde3DEngineTests --content <dir> --work-dir <dir>\n" );
+		return false;
+	}
+
+	return true;
+}
+
+
+int main( int argc, char **argv )
+{
+	Options opts;
+	if( !parseArgs( argc, argv, opts ) ) return 2;
+
+	testHotReload( opts );
+	testResourcePrefetching( opts );
+	testVisibilityCache( opts );
+	testNodeBatches( opts );
+	testTiledLightGroups( opts );
+	testTextureArrays();
+#ifdef H3D_TEST_ENGINE_INTERNALS
+	testComputeBarriers( opts );
+	testMaterialTexTable( opts );
+	testBufferArena();
+	testGeometryArena();
+	testRenderGraph( opts );
+	testDynamicResolution( opts );
+	testAsyncShaders( opts );
+	testFramePacing( opts );
+	testLateLatchCamera( opts );
+	testShadowAtlas( opts );
+#endif
+	testPackLZ();
+	testPackIndex();
+
+	if( failures > 0 )
+	{
+		printf( "%d check(s) failed\n", failures );
+		return 1;
+	}
+
+	printf( "All engine tests passed\n" );
+	return 0;
+}
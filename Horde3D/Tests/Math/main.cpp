@@ -0,0 +1,520 @@
+// *************************************************************************************************
+//
+// Horde3D
+//   Next-Generation Graphics Engine
+// --------------------------------------
+// Copyright (C) 2006-2021 Nicolas Schulz and Horde3D team
+//
+// This software is distributed under the terms of the Eclipse Public License v1.0.
+// A copy of the license may be obtained at: http://www.eclipse.org/legal/epl-v10.html
+//
+// *************************************************************************************************
+
+// Math library tests
+//
+// Compares the (SIMD) implementation of the math library against straightforward scalar reference
+// implementations using random input. The same source is built once with SIMD enabled and once
+// with H3D_MATH_NO_SIMD, so running the microbenchmarks of both executables shows the speedup.
+//
+// Usage: Horde3DMathTests [--benchmark] [--iterations <n>]
+
+#include "utMath.h"
+#include "egPrimitives.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace std;
+using namespace Horde3D;
+
+
+static int failures = 0;
+
+#define CHECK( cond, ... ) \
+	if( !(cond) ) { ++failures; printf( "FAIL %s:%d: ", __FILE__, __LINE__ ); printf( __VA_ARGS__ ); printf( "\n" ); }
+
+
+// =================================================================================================
+// Random input
+// =================================================================================================
+
+class TestRandom
+{
+public:
+	explicit TestRandom( unsigned int seed ) : _state( seed ) {}
+
+	float nextFloat( float minVal, float maxVal )
+	{
+		_state = _state * 1664525u + 1013904223u;
+		return minVal + (maxVal - minVal) * ((_state >> 8) / 16777215.0f);
+	}
+
+	Vec3f nextVec3f( float minVal, float maxVal )
+	{
+		float x = nextFloat( minVal, maxVal ), y = nextFloat( minVal, maxVal );
+		return Vec3f( x, y, nextFloat( minVal, maxVal ) );
+	}
+
+	Quaternion nextQuat()
+	{
+		float x = nextFloat( -1, 1 ), y = nextFloat( -1, 1 ), z = nextFloat( -1, 1 ), w = nextFloat( -1, 1 );
+		float len = sqrtf( x * x + y * y + z * z + w * w );
+		return len > 0.01f ? Quaternion( x / len, y / len, z / len, w / len ) : Quaternion( 0, 0, 0, 1 );
+	}
+
+	Matrix4f nextAffine()
+	{
+		// Well-conditioned transformation like in scene graphs
+		Vec3f rot = nextVec3f( -Math::Pi, Math::Pi ), scale = nextVec3f( 0.5f, 2.0f ), trans = nextVec3f( -100, 100 );
+		return Matrix4f::TransMat( trans.x, trans.y, trans.z ) * Matrix4f::RotMat( rot.x, rot.y, rot.z ) *
+		       Matrix4f::ScaleMat( scale.x, scale.y, scale.z );
+	}
+
+	Matrix4f nextGeneral()
+	{
+		// Affine matrix with projective row, like view projection matrices
+		Matrix4f m = nextAffine();
+		m.x[3] = nextFloat( -0.5f, 0.5f );
+		m.x[7] = nextFloat( -0.5f, 0.5f );
+		m.x[11] = nextFloat( -0.5f, 0.5f );
+		m.x[15] = nextFloat( 1.0f, 2.0f );
+		return m;
+	}
+
+private:
+	unsigned int  _state;
+};
+
+
+// =================================================================================================
+// Scalar reference implementations
+// =================================================================================================
+
+static void refMult( float *dst, const float *a, const float *b )
+{
+	for( int col = 0; col < 4; ++col )
+		for( int row = 0; row < 4; ++row )
+		{
+			double sum = 0;
+			for( int k = 0; k < 4; ++k ) sum += (double)a[k * 4 + row] * b[col * 4 + k];
+			dst[col * 4 + row] = (float)sum;
+		}
+}
+
+static bool refInverse( float *dst, const float *src )
+{
+	// Gauss-Jordan elimination with partial pivoting in double precision
+	double m[4][8];
+	for( int row = 0; row < 4; ++row )
+		for( int col = 0; col < 4; ++col )
+		{
+			m[row][col] = src[col * 4 + row];
+			m[row][col + 4] = row == col ? 1 : 0;
+		}
+
+	for( int col = 0; col < 4; ++col )
+	{
+		int pivot = col;
+		for( int row = col + 1; row < 4; ++row )
+			if( fabs( m[row][col] ) > fabs( m[pivot][col] ) ) pivot = row;
+		if( m[pivot][col] == 0 ) return false;
+		for( int k = 0; k < 8; ++k ) { double t = m[col][k]; m[col][k] = m[pivot][k]; m[pivot][k] = t; }
+
+		double inv = 1.0 / m[col][col];
+		for( int k = 0; k < 8; ++k ) m[col][k] *= inv;
+		for( int row = 0; row < 4; ++row )
+		{
+			if( row == col ) continue;
+			double f = m[row][col];
+			for( int k = 0; k < 8; ++k ) m[row][k] -= f * m[col][k];
+		}
+	}
+
+	for( int row = 0; row < 4; ++row )
+		for( int col = 0; col < 4; ++col )
+			dst[col * 4 + row] = (float)m[row][col + 4];
+	return true;
+}
+
+static void refTransform( float *dst, const float *m, const float *v )
+{
+	for( int row = 0; row < 4; ++row )
+		dst[row] = (float)((double)m[row] * v[0] + (double)m[4 + row] * v[1] + (double)m[8 + row] * v[2] + (double)m[12 + row] * v[3]);
+}
+
+static Quaternion refQuatMult( const Quaternion &a, const Quaternion &b )
+{
+	return Quaternion( a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+	                   a.w * b.y + a.y * b.w + a.z * b.x - a.x * b.z,
+	                   a.w * b.z + a.z * b.w + a.x * b.y - a.y * b.x,
+	                   a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z );
+}
+
+static Quaternion refNlerp( const Quaternion &a, Quaternion b, float t )
+{
+	if( a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w < 0 ) b = Quaternion( -b.x, -b.y, -b.z, -b.w );
+	Quaternion r( a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t, a.w + (b.w - a.w) * t );
+	double len = sqrt( (double)r.x * r.x + (double)r.y * r.y + (double)r.z * r.z + (double)r.w * r.w );
+	return Quaternion( (float)(r.x / len), (float)(r.y / len), (float)(r.z / len), (float)(r.w / len) );
+}
+
+static void refQuatToMatrix( float *dst, const Quaternion &q )
+{
+	// Rotation of the unit axes: columns of the matrix are q * e * q^-1
+	for( int col = 0; col < 4; ++col )
+	{
+		if( col == 3 )
+		{
+			dst[12] = dst[13] = dst[14] = 0; dst[15] = 1;
+			break;
+		}
+		Quaternion e( col == 0 ? 1.0f : 0.0f, col == 1 ? 1.0f : 0.0f, col == 2 ? 1.0f : 0.0f, 0 );
+		Quaternion r = refQuatMult( refQuatMult( q, e ), Quaternion( -q.x, -q.y, -q.z, q.w ) );
+		dst[col * 4 + 0] = r.x; dst[col * 4 + 1] = r.y; dst[col * 4 + 2] = r.z; dst[col * 4 + 3] = 0;
+	}
+}
+
+static bool refCullBox( const Frustum &frust, const BoundingBox &b )
+{
+	// Box is culled if all corners are outside of one of the planes, equivalent to the tested vertex
+	// of the optimized version being outside
+	Plane planes[6] = {
+		Plane( frust.getOrigin(), frust.getCorner( 3 ), frust.getCorner( 0 ) ),
+		Plane( frust.getOrigin(), frust.getCorner( 1 ), frust.getCorner( 2 ) ),
+		Plane( frust.getOrigin(), frust.getCorner( 0 ), frust.getCorner( 1 ) ),
+		Plane( frust.getOrigin(), frust.getCorner( 2 ), frust.getCorner( 3 ) ),
+		Plane( frust.getCorner( 0 ), frust.getCorner( 1 ), frust.getCorner( 2 ) ),
+		Plane( frust.getCorner( 5 ), frust.getCorner( 4 ), frust.getCorner( 7 ) ) };
+
+	for( int i = 0; i < 6; ++i )
+	{
+		bool allOut = true;
+		for( int j = 0; j < 8 && allOut; ++j )
+		{
+			Vec3f p( j & 1 ? b.max.x : b.min.x, j & 2 ? b.max.y : b.min.y, j & 4 ? b.max.z : b.min.z );
+			allOut = planes[i].distToPoint( p ) > 0;
+		}
+		if( allOut ) return true;
+	}
+
+	return false;
+}
+
+
+// =================================================================================================
+// Tests
+// =================================================================================================
+
+static bool nearlyEqual( float a, float b, float relTol, float absTol )
+{
+	return fabsf( a - b ) <= absTol + relTol * fmaxf( fabsf( a ), fabsf( b ) );
+}
+
+static bool nearlyEqual( const float *a, const float *b, int count, float relTol, float absTol )
+{
+	for( int i = 0; i < count; ++i )
+		if( !nearlyEqual( a[i], b[i], relTol, absTol ) ) return false;
+	return true;
+}
+
+static const int TestCount = 10000;
+
+
+static void testMatrixMult( TestRandom &rnd )
+{
+	for( int i = 0; i < TestCount; ++i )
+	{
+		Matrix4f a = i % 2 ? rnd.nextGeneral() : rnd.nextAffine(), b = rnd.nextGeneral();
+		float ref[16];
+		refMult( ref, a.x, b.x );
+
+		Matrix4f m = a * b;
+		CHECK( nearlyEqual( m.x, ref, 16, 1e-5f, 1e-3f ), "Matrix4f::operator* differs (case %d)", i );
+	}
+}
+
+static void testMatrixFastMult43( TestRandom &rnd )
+{
+	for( int i = 0; i < TestCount; ++i )
+	{
+		Matrix4f a = rnd.nextAffine(), b = rnd.nextAffine();
+		float ref[16];
+		refMult( ref, a.x, b.x );
+
+		Matrix4f m( Math::NO_INIT );
+		Matrix4f::fastMult43( m, a, b );
+		CHECK( nearlyEqual( m.x, ref, 16, 1e-5f, 1e-3f ), "Matrix4f::fastMult43 differs (case %d)", i );
+		CHECK( m.x[3] == 0 && m.x[7] == 0 && m.x[11] == 0 && m.x[15] == 1, "Matrix4f::fastMult43 last row not exact" );
+	}
+}
+
+static void testMatrixInverse( TestRandom &rnd )
+{
+	for( int i = 0; i < TestCount; ++i )
+	{
+		Matrix4f a = i % 2 ? rnd.nextGeneral() : rnd.nextAffine();
+		float ref[16];
+		if( !refInverse( ref, a.x ) ) continue;
+
+		Matrix4f m = a.inverted();
+		CHECK( nearlyEqual( m.x, ref, 16, 1e-3f, 1e-4f ), "Matrix4f::inverted differs (case %d)", i );
+	}
+
+	// Projection matrices as used for frustum calculation
+	Matrix4f proj = Matrix4f::PerspectiveMat( -0.1f, 0.1f, -0.075f, 0.075f, 0.1f, 1000.0f );
+	float ref[16];
+	refInverse( ref, proj.x );
+	Matrix4f m = proj.inverted();
+	CHECK( nearlyEqual( m.x, ref, 16, 1e-3f, 1e-5f ), "Matrix4f::inverted differs for projection matrix" );
+}
+
+static void testMatrixTransform( TestRandom &rnd )
+{
+	for( int i = 0; i < TestCount; ++i )
+	{
+		Matrix4f m = i % 2 ? rnd.nextGeneral() : rnd.nextAffine();
+		Vec3f v = rnd.nextVec3f( -100, 100 );
+		float w = rnd.nextFloat( -2, 2 );
+
+		float in[4] = { v.x, v.y, v.z, w }, ref[4];
+		refTransform( ref, m.x, in );
+		Vec4f r4 = m * Vec4f( v.x, v.y, v.z, w );
+		CHECK( nearlyEqual( &r4.x, ref, 4, 1e-5f, 1e-3f ), "Matrix4f::operator*( Vec4f ) differs (case %d)", i );
+
+		float inPoint[4] = { v.x, v.y, v.z, 1 };
+		refTransform( ref, m.x, inPoint );
+		Vec3f r3 = m * v;
+		CHECK( nearlyEqual( &r3.x, ref, 3, 1e-5f, 1e-3f ), "Matrix4f::operator*( Vec3f ) differs (case %d)", i );
+
+		float inVec[4] = { v.x, v.y, v.z, 0 };
+		refTransform( ref, m.x, inVec );
+		r3 = m.mult33Vec( v );
+		CHECK( nearlyEqual( &r3.x, ref, 3, 1e-5f, 1e-3f ), "Matrix4f::mult33Vec differs (case %d)", i );
+	}
+}
+
+static void testQuaternion( TestRandom &rnd )
+{
+	for( int i = 0; i < TestCount; ++i )
+	{
+		Quaternion a = rnd.nextQuat(), b = rnd.nextQuat();
+		float t = rnd.nextFloat( 0, 1 );
+
+		Quaternion ref = refQuatMult( a, b ), q = a * b;
+		CHECK( nearlyEqual( &q.x, &ref.x, 4, 1e-5f, 1e-6f ), "Quaternion::operator* differs (case %d)", i );
+
+		ref = refNlerp( a, b, t );
+		q = a.nlerp( b, t );
+		CHECK( nearlyEqual( &q.x, &ref.x, 4, 1e-5f, 1e-6f ), "Quaternion::nlerp differs (case %d)", i );
+
+		float refMat[16];
+		refQuatToMatrix( refMat, a );
+		Matrix4f m( a );
+		CHECK( nearlyEqual( m.x, refMat, 16, 1e-5f, 1e-5f ), "Matrix4f( Quaternion ) differs (case %d)", i );
+	}
+}
+
+static void testCullBox( TestRandom &rnd )
+{
+	int culled = 0;
+	for( int i = 0; i < TestCount; ++i )
+	{
+		Frustum frust;
+		frust.buildViewFrustum( rnd.nextAffine(), rnd.nextFloat( 30, 90 ), rnd.nextFloat( 0.5f, 2 ),
+		                        rnd.nextFloat( 0.1f, 1 ), rnd.nextFloat( 100, 500 ) );
+
+		for( int j = 0; j < 10; ++j )
+		{
+			BoundingBox b;
+			Vec3f center = rnd.nextVec3f( -300, 300 ), extents = rnd.nextVec3f( 0.1f, 20 );
+			b.min = center - extents;
+			b.max = center + extents;
+
+			bool ref = refCullBox( frust, b );
+			bool result = frust.cullBox( b );
+			culled += result ? 1 : 0;
+
+			CHECK( result == ref, "Frustum::cullBox differs (case %d/%d)", i, j );
+		}
+	}
+
+	CHECK( culled > TestCount, "Frustum::cullBox culls unexpectedly few boxes (%d)", culled );
+}
+
+static void testCullBoxes( TestRandom &rnd )
+{
+	// Batch sizes that are not a multiple of the SIMD width exercise the scalar remainder
+	const int batchSize = 37;
+	BoundingBox boxes[batchSize];
+	bool culled[batchSize];
+
+	for( int i = 0; i < TestCount / 10; ++i )
+	{
+		Frustum frust;
+		frust.buildViewFrustum( rnd.nextAffine(), rnd.nextFloat( 30, 90 ), rnd.nextFloat( 0.5f, 2 ),
+		                        rnd.nextFloat( 0.1f, 1 ), rnd.nextFloat( 100, 500 ) );
+
+		for( int j = 0; j < batchSize; ++j )
+		{
+			Vec3f center = rnd.nextVec3f( -300, 300 ), extents = rnd.nextVec3f( 0.1f, 20 );
+			boxes[j].min = center - extents;
+			boxes[j].max = center + extents;
+		}
+
+		frust.cullBoxes( boxes, batchSize, culled );
+		for( int j = 0; j < batchSize; ++j )
+			CHECK( culled[j] == frust.cullBox( boxes[j] ), "Frustum::cullBoxes differs (case %d/%d)", i, j );
+	}
+}
+
+
+// =================================================================================================
+// Microbenchmarks
+// =================================================================================================
+
+typedef chrono::steady_clock Clock;
+
+static void printBenchmark( const char *name, Clock::time_point start, int ops, float checksum )
+{
+	double ns = chrono::duration< double, nano >( Clock::now() - start ).count() / ops;
+	printf( "%-28s %8.2f ns/op  (checksum %g)\n", name, ns, checksum );
+}
+
+static void runBenchmarks( int iterations )
+{
+	const int count = 1024;
+	TestRandom rnd( 4711 );
+	vector< Matrix4f > mats( count ), affine( count ), results( count );
+	vector< Vec3f > vecs( count ), vecResults( count );
+	vector< Vec4f > vec4Results( count );
+	vector< Quaternion > quats( count );
+	vector< BoundingBox > boxes( count );
+	for( int i = 0; i < count; ++i )
+	{
+		mats[i] = rnd.nextGeneral();
+		affine[i] = rnd.nextAffine();
+		vecs[i] = rnd.nextVec3f( -100, 100 );
+		quats[i] = rnd.nextQuat();
+		// Roughly half of the boxes in front of the camera are visible
+		Vec3f center( rnd.nextFloat( -300, 300 ), rnd.nextFloat( -300, 300 ), rnd.nextFloat( -500, 0 ) );
+		Vec3f extents = rnd.nextVec3f( 0.1f, 20 );
+		boxes[i].min = center - extents;
+		boxes[i].max = center + extents;
+	}
+	Frustum frust;
+	frust.buildViewFrustum( Matrix4f(), 45, 1.333f, 0.5f, 500 );
+
+#ifdef H3D_MATH_SIMD
+	printf( "SIMD implementation, %d iterations of %d operations\n", iterations, count );
+#else
+	printf( "Scalar implementation, %d iterations of %d operations\n", iterations, count );
+#endif
+	float checksum;
+	int ops = iterations * count;
+
+	Clock::time_point start = Clock::now();
+	for( int it = 0; it < iterations; ++it )
+		for( int i = 0; i < count; ++i ) results[i] = mats[i] * mats[(i + 1) % count];
+	checksum = results[count / 2].x[5];
+	printBenchmark( "Matrix4f::operator*", start, ops, checksum );
+
+	start = Clock::now();
+	for( int it = 0; it < iterations; ++it )
+		for( int i = 0; i < count; ++i ) Matrix4f::fastMult43( results[i], affine[i], affine[(i + 1) % count] );
+	checksum = results[count / 2].x[5];
+	printBenchmark( "Matrix4f::fastMult43", start, ops, checksum );
+
+	start = Clock::now();
+	for( int it = 0; it < iterations; ++it )
+		for( int i = 0; i < count; ++i ) results[i] = mats[i].inverted();
+	checksum = results[count / 2].x[5];
+	printBenchmark( "Matrix4f::inverted", start, ops, checksum );
+
+	start = Clock::now();
+	for( int it = 0; it < iterations; ++it )
+		for( int i = 0; i < count; ++i ) vecResults[i] = affine[i] * vecs[i];
+	printBenchmark( "Matrix4f::operator*( Vec3f )", start, ops, vecResults[count / 2].x );
+
+	start = Clock::now();
+	for( int it = 0; it < iterations; ++it )
+		for( int i = 0; i < count; ++i ) vec4Results[i] = mats[i] * Vec4f( vecs[i] );
+	printBenchmark( "Matrix4f::operator*( Vec4f )", start, ops, vec4Results[count / 2].x );
+
+	start = Clock::now();
+	for( int it = 0; it < iterations; ++it )
+		for( int i = 0; i < count; ++i ) vecResults[i] = affine[i].mult33Vec( vecs[i] );
+	printBenchmark( "Matrix4f::mult33Vec", start, ops, vecResults[count / 2].x );
+
+	vector< Quaternion > quatResults( count );
+	start = Clock::now();
+	for( int it = 0; it < iterations; ++it )
+		for( int i = 0; i < count; ++i ) quatResults[i] = quats[i] * quats[(i + 1) % count];
+	printBenchmark( "Quaternion::operator*", start, ops, quatResults[count / 2].x );
+
+	start = Clock::now();
+	for( int it = 0; it < iterations; ++it )
+		for( int i = 0; i < count; ++i ) quatResults[i] = quats[i].nlerp( quats[(i + 1) % count], 0.3f );
+	printBenchmark( "Quaternion::nlerp", start, ops, quatResults[count / 2].y );
+
+	start = Clock::now();
+	for( int it = 0; it < iterations; ++it )
+		for( int i = 0; i < count; ++i ) results[i] = Matrix4f( quats[i] );
+	checksum = results[count / 2].x[5];
+	printBenchmark( "Matrix4f( Quaternion )", start, ops, checksum );
+
+	start = Clock::now();
+	int culled = 0;
+	for( int it = 0; it < iterations; ++it )
+		for( int i = 0; i < count; ++i ) culled += frust.cullBox( boxes[i] ) ? 1 : 0;
+	printBenchmark( "Frustum::cullBox", start, ops, (float)culled );
+
+	bool culledFlags[count];
+	start = Clock::now();
+	culled = 0;
+	for( int it = 0; it < iterations; ++it )
+	{
+		frust.cullBoxes( &boxes[0], count, culledFlags );
+		culled += culledFlags[it % count];
+	}
+	printBenchmark( "Frustum::cullBoxes", start, ops, (float)culled );
+}
+
+
+int main( int argc, char **argv )
+{
+	bool benchmark = false;
+	int iterations = 2000;
+	for( int i = 1; i < argc; ++i )
+	{
+		if( strcmp( argv[i], "--benchmark" ) == 0 ) benchmark = true;
+		else if( strcmp( argv[i], "--iterations" ) == 0 && i + 1 < argc ) iterations = atoi( argv[++i] );
+		else
+		{
+			fprintf( stderr, "Usage: Horde3DMathTests [--benchmark] [--iterations <n>]\n" );
+			return 2;
+		}
+	}
+
+	TestRandom rnd( 99777 );
+	testMatrixMult( rnd );
+	testMatrixFastMult43( rnd );
+	testMatrixInverse( rnd );
+	testMatrixTransform( rnd );
+	testQuaternion( rnd );
+	testCullBox( rnd );
+	testCullBoxes( rnd );
+
+	if( failures > 0 )
+	{
+		printf( "%d checks failed\n", failures );
+		return 1;
+	}
+	printf( "All math tests passed\n" );
+
+	if( benchmark ) runBenchmarks( iterations );
+
+	return 0;
+}
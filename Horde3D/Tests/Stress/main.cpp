@@ -0,0 +1,421 @@
+// *************************************************************************************************
+//
+// Horde3D
+//   Next-Generation Graphics Engine
+// --------------------------------------
+// Copyright (C) 2006-2021 Nicolas Schulz and Horde3D team
+//
+// This software is distributed under the terms of the Eclipse Public License v1.0.
+// A copy of the license may be obtained at: http://www.eclipse.org/legal/epl-v10.html
+//
+// *************************************************************************************************
+
+// Stress scene generator
+//
+// Generates scenes with a large crowd of animated characters (using the Chicago crowd simulation),
+// static props, shadow casting lights and particle emitters and runs them headless on the Null render
+// backend for a fixed number of frames. Besides a run with the base configuration, single parameters
+// can be swept to record scaling curves (time vs. count). Results are printed as table and can be
+// written as JSON.
+//
+// Usage: Horde3DStress --content <dir> [--output <file>] [--frames <n>] [--characters <n>] [--props <n>]
+//                      [--lights <n>] [--shadow-lights <n>] [--shadow-cascades <n>] [--emitters <n>]
+//                      [--video-streams <n>] [--shadow-atlas <size>] [--pipeline <file>] [--async-shaders]
+//                      [--overlap-render] [--occlusion-culling] [--occluder <distance>] [--frames-in-flight <n>]
+//                      [--late-latch] [--point-chunks <n>] [--sweep <param>=<n>,<n>,...]
+//                      [--expect <metric>=<min>[,<max>]]
+//
+// Expectations are checked against the base configuration, the run fails if a metric is out of range.
+//
+// The occluder is a wall facing the camera that hides everything behind it. The Null backend does not
+// run the GPU occlusion culling shaders; where the engine internals are accessible, the tool emulates
+// their results for the wall.
+//
+// Point cloud chunks are counted as drawn or culled against the camera frustum in every frame. The number
+// of points drawn after density LOD is only known where the engine internals are accessible.
+
+#include "stress.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using namespace std;
+
+
+struct Expectation
+{
+	string  metric;
+	double  minValue, maxValue;
+};
+
+struct Options
+{
+	string                 contentDir;
+	string                 outputFile;
+	string                 pipeline;
+	StressConfig           config;
+	vector< StressCurve >  sweeps;
+	vector< Expectation >  expectations;
+	int                    shadowAtlasSize;  // 0 renders shadow maps per light
+	int                    framesInFlight;  // 0 leaves frame pacing to the driver
+	bool                   asyncShaders;
+	bool                   overlapRender;  // Prepare and render on a render thread while the scene is updated
+	bool                   occlusionCulling;
+	float                  occluderDistance;  // 0 without occluder
+	bool                   lateLatch;
+
+	Options() : pipeline( "pipelines/forward.pipeline.xml" ), shadowAtlasSize( 0 ), framesInFlight( 0 ),
+		asyncShaders( false ), overlapRender( false ), occlusionCulling( false ), occluderDistance( 0 ),
+		lateLatch( false ) {}
+};
+
+
+static bool parseSweep( const char *arg, StressConfig &config, StressCurve &curve )
+{
+	const char *sep = strchr( arg, '=' );
+	if( sep == 0x0 ) return false;
+
+	curve.param = string( arg, sep - arg );
+	if( config.getParam( curve.param ) == 0x0 || curve.param == "frames" ) return false;
+
+	// Counts are stored in the config of each point and filled in when running
+	const char *str = sep + 1;
+	while( *str != '\0' )
+	{
+		char *end;
+		long count = strtol( str, &end, 10 );
+		if( end == str || count < 0 ) return false;
+
+		StressSample sample;
+		*sample.config.getParam( curve.param ) = (int)count;
+		curve.points.push_back( sample );
+
+		if( *end != ',' && *end != '\0' ) return false;
+		str = *end == ',' ? end + 1 : end;
+	}
+
+	return !curve.points.empty();
+}
+
+
+static bool parseExpectation( const char *arg, Expectation &expect )
+{
+	const char *sep = strchr( arg, '=' );
+	if( sep == 0x0 ) return false;
+
+	expect.metric = string( arg, sep - arg );
+	if( StressSample().getMetric( expect.metric ) == 0x0 ) return false;
+
+	// A single value is expected exactly
+	char *end;
+	expect.minValue = strtod( sep + 1, &end );
+	if( end == sep + 1 ) return false;
+	expect.maxValue = expect.minValue;
+	if( *end == ',' )
+	{
+		const char *str = end + 1;
+		expect.maxValue = strtod( str, &end );
+		if( end == str || expect.maxValue < expect.minValue ) return false;
+	}
+
+	return *end == '\0';
+}
+
+
+static bool parseArgs( int argc, char **argv, Options &opts )
+{
+	struct { const char *name; const char *param; } intArgs[] = {
+		{ "--frames", "frames" }, { "--characters", "characters" }, { "--props", "props" },
+		{ "--lights", "lights" }, { "--shadow-lights", "shadowLights" },
+		{ "--shadow-cascades", "shadowCascades" }, { "--emitters", "emitters" }, { "--video-streams", "videoStreams" },
+		{ "--point-chunks", "pointChunks" } };
+
+	for( int i = 1; i < argc; ++i )
+	{
+		bool hasValue = i + 1 < argc;
+		bool handled = false;
+
+		for( size_t j = 0; j < sizeof( intArgs ) / sizeof( intArgs[0] ) && hasValue; ++j )
+		{
+			if( strcmp( argv[i], intArgs[j].name ) == 0 )
+			{
+				*opts.config.getParam( intArgs[j].param ) = atoi( argv[++i] );
+				handled = true;
+				break;
+			}
+		}
+		if( handled ) continue;
+
+		if( strcmp( argv[i], "--content" ) == 0 && hasValue ) opts.contentDir = argv[++i];
+		else if( strcmp( argv[i], "--output" ) == 0 && hasValue ) opts.outputFile = argv[++i];
+		else if( strcmp( argv[i], "--shadow-atlas" ) == 0 && hasValue ) opts.shadowAtlasSize = atoi( argv[++i] );
+		else if( strcmp( argv[i], "--pipeline" ) == 0 && hasValue ) opts.pipeline = argv[++i];
+		else if( strcmp( argv[i], "--async-shaders" ) == 0 ) opts.asyncShaders = true;
+		else if( strcmp( argv[i], "--overlap-render" ) == 0 ) opts.overlapRender = true;
+		else if( strcmp( argv[i], "--occlusion-culling" ) == 0 ) opts.occlusionCulling = true;
+		else if( strcmp( argv[i], "--occluder" ) == 0 && hasValue ) opts.occluderDistance = (float)atof( argv[++i] );
+		else if( strcmp( argv[i], "--frames-in-flight" ) == 0 && hasValue ) opts.framesInFlight = atoi( argv[++i] );
+		else if( strcmp( argv[i], "--late-latch" ) == 0 ) opts.lateLatch = true;
+		else if( strcmp( argv[i], "--sweep" ) == 0 && hasValue )
+		{
+			StressCurve curve;
+			if( !parseSweep( argv[++i], opts.config, curve ) )
+			{
+				fprintf( stderr, "Invalid sweep '%s', expected <param>=<n>,<n>,... with param one of "
+				                 "characters, props, lights, shadowLights, shadowCascades, emitters, videoStreams, pointChunks\n", argv[i] );
+				return false;
+			}
+			opts.sweeps.push_back( curve );
+		}
+		else if( strcmp( argv[i], "--expect" ) == 0 && hasValue )
+		{
+			Expectation expect;
+			if( !parseExpectation( argv[++i], expect ) )
+			{
+				fprintf( stderr, "Invalid expectation '%s', expected <metric>=<min>[,<max>] with metric one of "
+				                 "batches, triangles, lightPasses, tiledLights, tileMaxLights, shadowMaps, cascadeBatches, "
+				                 "shadowSplit0 to shadowSplit4, videoPresented, videoDropped, occCulled, occVisible, "
+				                 "pointChunksDrawn, pointChunksCulled, pointsDrawn, pointChunksReduced\n",
+				         argv[i] );
+				return false;
+			}
+			opts.expectations.push_back( expect );
+		}
+		else
+		{
+			fprintf( stderr, "Unknown or incomplete argument '%s'\n", argv[i] );
+			return false;
+		}
+	}
+
+	if( opts.contentDir.empty() )
+	{
+		fprintf( stderr, "Usage: Horde3DStress --content <dir> [--output <file>] [--frames <n>] [--characters <n>]\n"
+		                 "                     [--props <n>] [--lights <n>] [--shadow-lights <n>] [--shadow-cascades <n>]\n"
+		                 "                     [--emitters <n>] [--video-streams <n>] [--shadow-atlas <size>] [--pipeline <file>]\n"
+		                 "                     [--async-shaders] [--overlap-render] [--occlusion-culling]\n"
+		                 "                     [--occluder <distance>] [--frames-in-flight <n>] [--late-latch]\n"
+		                 "                     [--point-chunks <n>]\n"
+		                 "                     [--sweep <param>=<n>,<n>,...] [--expect <metric>=<min>[,<max>]]\n" );
+		return false;
+	}
+
+#ifndef HORDE3D_STRESS_VIDEO_STREAMS
+	if( opts.config.videoStreams > 0 )
+	{
+		fprintf( stderr, "Video streams require the ExternalTexture extension (HORDE3D_BUILD_EXTERNAL_TEXTURE)\n" );
+		return false;
+	}
+#endif
+
+	return true;
+}
+
+
+static void dumpEngineMessages()
+{
+	int level;
+	float time;
+	const char *msg = h3dGetMessage( &level, &time );
+	while( msg != 0x0 && msg[0] != '\0' )
+	{
+		if( level <= 2 ) fprintf( stderr, "Horde3D: %s\n", msg );
+		msg = h3dGetMessage( &level, &time );
+	}
+}
+
+
+static void printSampleHeader()
+{
+	printf( "%10s %6s %6s %6s %8s | %8s %8s %8s %8s %8s %8s %8s | %8s %10s\n",
+	        "characters", "props", "lights", "shadow", "emitters", "frame", "crowd", "render", "anim",
+	        "skinning", "particle", "culling", "batches", "triangles" );
+}
+
+
+static void printSample( const StressSample &s )
+{
+	printf( "%10d %6d %6d %6d %8d | %8.3f %8.3f %8.3f %8.3f %8.3f %8.3f %8.3f | %8.0f %10.0f\n",
+	        s.config.characters, s.config.props, s.config.lights, s.config.shadowLights, s.config.emitters,
+	        s.frameMs, s.crowdMs, s.renderMs, s.animationMs, s.geoUpdateMs, s.particleSimMs, s.cullingMs,
+	        s.batches, s.triangles );
+}
+
+
+static string sampleToJSON( const StressSample &s, const char *indent )
+{
+	char buf[1280];
+	snprintf( buf, sizeof( buf ),
+	          "%s{ \"characters\": %d, \"props\": %d, \"lights\": %d, \"shadowLights\": %d, \"shadowCascades\": %d, \"emitters\": %d, "
+	          "\"frameMs\": %.4f, \"crowdMs\": %.4f, \"renderMs\": %.4f, \"animationMs\": %.4f, \"geoUpdateMs\": %.4f, "
+	          "\"particleSimMs\": %.4f, \"cullingMs\": %.4f, \"batches\": %.1f, \"triangles\": %.1f, \"lightPasses\": %.1f, "
+	          "\"tiledLights\": %.1f, \"tileOccupancy\": %.3f, \"tileMaxLights\": %.0f, \"shadowMaps\": %.1f, "
+	          "\"cascadeBatches\": %.1f, \"videoStreams\": %d, "
+	          "\"videoPresented\": %.0f, \"videoDropped\": %.0f, \"pointChunks\": %d, \"occCulled\": %.0f, "
+	          "\"occVisible\": %.0f, \"pointChunksDrawn\": %.0f, \"pointChunksCulled\": %.0f, \"pointsDrawn\": %.0f, "
+	          "\"pointChunksReduced\": %.0f }",
+	          indent, s.config.characters, s.config.props, s.config.lights, s.config.shadowLights,
+	          s.config.shadowCascades, s.config.emitters,
+	          s.frameMs, s.crowdMs, s.renderMs, s.animationMs, s.geoUpdateMs, s.particleSimMs, s.cullingMs,
+	          s.batches, s.triangles, s.lightPasses, s.tiledLights, s.tileOccupancy, s.tileMaxLights,
+	          s.shadowMaps, s.cascadeBatches, s.config.videoStreams, s.videoPresented, s.videoDropped, s.config.pointChunks,
+	          s.occCulled, s.occVisible, s.pointChunksDrawn, s.pointChunksCulled, s.pointsDrawn, s.pointChunksReduced );
+	return buf;
+}
+
+
+int main( int argc, char **argv )
+{
+	Options opts;
+	if( !parseArgs( argc, argv, opts ) ) return 2;
+
+	if( !h3dInit( H3DRenderDevice::Null ) )
+	{
+		fprintf( stderr, "Failed to initialize engine with Null backend\n" );
+		dumpEngineMessages();
+		return 2;
+	}
+	h3dSetOption( H3DOptions::MaxLogLevel, 2 );
+	h3dSetOption( H3DOptions::GatherTimeStats, 1 );
+	if( opts.shadowAtlasSize > 0 && !h3dSetOption( H3DOptions::ShadowAtlasSize, (float)opts.shadowAtlasSize ) )
+	{
+		fprintf( stderr, "Invalid shadow atlas size %d\n", opts.shadowAtlasSize );
+		h3dRelease();
+		return 2;
+	}
+	h3dSetOption( H3DOptions::AsyncShaderCompilation, opts.asyncShaders ? 1.0f : 0.0f );
+	if( !h3dSetOption( H3DOptions::MaxFramesInFlight, (float)opts.framesInFlight ) )
+	{
+		fprintf( stderr, "Invalid number of frames in flight %d\n", opts.framesInFlight );
+		h3dRelease();
+		return 2;
+	}
+	h3dSetOption( H3DOptions::LateLatchCamera, opts.lateLatch ? 1.0f : 0.0f );
+
+	StressScene scene;
+	if( !scene.loadContent( opts.contentDir, opts.pipeline ) )
+	{
+		fprintf( stderr, "Failed to load content from '%s'\n", opts.contentDir.c_str() );
+		dumpEngineMessages();
+		h3dRelease();
+		return 2;
+	}
+	scene.setOverlappedRendering( opts.overlapRender );
+	scene.setLateLatching( opts.lateLatch );
+	scene.setOcclusionCulling( opts.occlusionCulling );
+	scene.setOccluder( opts.occluderDistance );
+
+	// Base configuration
+	StressSample base;
+	printf( "Base configuration, %d frames, times in ms per frame\n", opts.config.frames );
+	printSampleHeader();
+	scene.run( opts.config, base );
+	printSample( base );
+	if( opts.config.shadowCascades > 1 && opts.config.shadowLights > 0 )
+		printf( "Shadow maps per frame: %.1f, cascade batches %.1f, splits %.2f %.2f %.2f %.2f %.2f\n",
+		        base.shadowMaps, base.cascadeBatches, base.shadowSplits[0], base.shadowSplits[1],
+		        base.shadowSplits[2], base.shadowSplits[3], base.shadowSplits[4] );
+	if( opts.occlusionCulling )
+		printf( "GPU occlusion tests: %.0f culled, %.0f visible\n", base.occCulled, base.occVisible );
+	if( opts.config.videoStreams > 0 )
+		printf( "Video streams: %d, frames presented %.0f, dropped %.0f\n", opts.config.videoStreams,
+		        base.videoPresented, base.videoDropped );
+	if( opts.config.pointChunks > 0 )
+		printf( "Point cloud chunks: %.0f drawn, %.0f culled, %.0f points drawn, %.0f chunks reduced by LOD\n",
+		        base.pointChunksDrawn, base.pointChunksCulled, base.pointsDrawn, base.pointChunksReduced );
+
+	// Combinations that were drawn are finished, the remaining ones must be finished by polling
+	int pendingShaders = (int)h3dGetStat( H3DStats::PendingShaderCount, false );
+	for( int i = 0; i < 10 && pendingShaders != 0; ++i )
+		pendingShaders = (int)h3dGetStat( H3DStats::PendingShaderCount, false );
+	if( pendingShaders != 0 )
+	{
+		fprintf( stderr, "%d shader combinations still compiling after %d frames\n", pendingShaders, opts.config.frames );
+		scene.release();
+		dumpEngineMessages();
+		h3dRelease();
+		return 1;
+	}
+
+	bool expectationsMet = true;
+	for( size_t i = 0; i < opts.expectations.size(); ++i )
+	{
+		const Expectation &expect = opts.expectations[i];
+		double value = *base.getMetric( expect.metric );
+		if( value < expect.minValue || value > expect.maxValue )
+		{
+			fprintf( stderr, "%s is %g, expected %g to %g\n", expect.metric.c_str(), value, expect.minValue, expect.maxValue );
+			expectationsMet = false;
+		}
+	}
+	if( !expectationsMet )
+	{
+		scene.release();
+		dumpEngineMessages();
+		h3dRelease();
+		return 1;
+	}
+
+	// Scaling curves, all parameters except the swept one are taken from the base configuration
+	for( size_t i = 0; i < opts.sweeps.size(); ++i )
+	{
+		StressCurve &curve = opts.sweeps[i];
+		printf( "\nScaling of %s\n", curve.param.c_str() );
+		printSampleHeader();
+
+		for( size_t j = 0; j < curve.points.size(); ++j )
+		{
+			StressConfig config = opts.config;
+			*config.getParam( curve.param ) = *curve.points[j].config.getParam( curve.param );
+
+			scene.run( config, curve.points[j] );
+			printSample( curve.points[j] );
+		}
+
+		printf( "Cost per %s: frame %.4f ms, crowd %.4f ms, culling %.4f ms\n", curve.param.c_str(),
+		        curve.getSlope( &StressSample::frameMs ), curve.getSlope( &StressSample::crowdMs ),
+		        curve.getSlope( &StressSample::cullingMs ) );
+	}
+
+	scene.release();
+	dumpEngineMessages();
+	h3dRelease();
+
+	if( opts.outputFile.empty() ) return 0;
+
+	string json = "{\n\t\"backend\": \"Null\",\n";
+	char buf[256];
+	snprintf( buf, sizeof( buf ), "\t\"frames\": %d,\n\t\"shadowAtlasSize\": %d,\n", opts.config.frames, opts.shadowAtlasSize );
+	json += buf;
+	json += "\t\"base\":\n" + sampleToJSON( base, "\t" ) + ",\n";
+
+	json += "\t\"curves\": [\n";
+	for( size_t i = 0; i < opts.sweeps.size(); ++i )
+	{
+		const StressCurve &curve = opts.sweeps[i];
+		snprintf( buf, sizeof( buf ),
+		          "\t\t{\n\t\t\t\"param\": \"%s\",\n"
+		          "\t\t\t\"slope\": { \"frameMs\": %.6f, \"crowdMs\": %.6f, \"renderMs\": %.6f, \"cullingMs\": %.6f },\n"
+		          "\t\t\t\"points\": [\n",
+		          curve.param.c_str(), curve.getSlope( &StressSample::frameMs ), curve.getSlope( &StressSample::crowdMs ),
+		          curve.getSlope( &StressSample::renderMs ), curve.getSlope( &StressSample::cullingMs ) );
+		json += buf;
+
+		for( size_t j = 0; j < curve.points.size(); ++j )
+			json += sampleToJSON( curve.points[j], "\t\t\t\t" ) + (j + 1 < curve.points.size() ? ",\n" : "\n");
+
+		json += i + 1 < opts.sweeps.size() ? "\t\t\t]\n\t\t},\n" : "\t\t\t]\n\t\t}\n";
+	}
+	json += "\t]\n}\n";
+
+	FILE *f = fopen( opts.outputFile.c_str(), "w" );
+	if( f == 0x0 )
+	{
+		fprintf( stderr, "Failed to write results to '%s'\n", opts.outputFile.c_str() );
+		return 2;
+	}
+	fputs( json.c_str(), f );
+	fclose( f );
+
+	return 0;
+}
@@ -0,0 +1,663 @@
+// *************************************************************************************************
+//
+// Horde3D
+//   Next-Generation Graphics Engine
+// --------------------------------------
+// Copyright (C) 2006-2021 Nicolas Schulz and Horde3D team
+//
+// This software is distributed under the terms of the Eclipse Public License v1.0.
+// A copy of the license may be obtained at: http://www.eclipse.org/legal/epl-v10.html
+//
+// *************************************************************************************************
+
+#include "stress.h"
+#include "crowd.h"
+#include "Horde3DUtils.h"
+#ifdef HORDE3D_STRESS_VIDEO_STREAMS
+#include "Horde3DExternalTexture.h"
+#endif
+#ifdef H3D_TEST_ENGINE_INTERNALS
+#include "egModules.h"
+#include "egRenderer.h"
+#include "egRendererBaseNull.h"
+#endif
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+using namespace std;
+
+namespace {
+
+const int ViewportWidth = 1280;
+const int ViewportHeight = 720;
+const float FrameRate = 30.0f;
+const unsigned int RandomSeed = 99777;  // Same seed as the Chicago sample
+const int VideoWidth = 640;
+const int VideoHeight = 360;
+const int VideoRingSize = 4;
+const int PointsPerChunk = 4096;
+const float PointDensity = 0.1f;  // Points drawn per covered pixel
+
+class WallTimer
+{
+public:
+	WallTimer() : _start( chrono::steady_clock::now() ) {}
+
+	double getElapsedMS() const
+	{
+		return chrono::duration< double, milli >( chrono::steady_clock::now() - _start ).count();
+	}
+
+private:
+	chrono::steady_clock::time_point  _start;
+};
+
+// Deterministic random generator (independent of the C library implementation)
+class StressRandom
+{
+public:
+	explicit StressRandom( unsigned int seed ) : _state( seed ) {}
+
+	float nextFloat( float minVal, float maxVal )
+	{
+		_state = _state * 1664525u + 1013904223u;
+		return minVal + (maxVal - minVal) * (((_state >> 8) & 0xFFFF) / 65535.0f);
+	}
+
+private:
+	unsigned int  _state;
+};
+
+void resetEngineStats()
+{
+	for( int i = H3DStats::TriCount; i <= H3DStats::TileMaxLights; ++i )
+		h3dGetStat( (H3DStats::List)i, true );
+	for( int i = H3DStats::ShadowMapCount; i <= H3DStats::OccludedCount; ++i )
+		h3dGetStat( (H3DStats::List)i, true );
+}
+
+#ifdef H3D_TEST_ENGINE_INTERNALS
+// The Null backend does not run the occlusion culling shaders. The occluder covers the whole view, so
+// the depth pyramid has the depth of the wall everywhere and a box is occluded when all of its corners
+// are farther away from the camera than the wall.
+void emulateOcclusionTest( Horde3D::RDI_Null::RenderDeviceNull &rdi, uint32 shaderId, uint32 xDim,
+                           uint32 yDim, uint32 zDim, void *userData )
+{
+	const StressOccluder &occluder = *(const StressOccluder *)userData;
+	if( occluder.distance <= 0 || !rdi.hasShaderSymbol( shaderId, "OcclusionResults" ) ) return;
+
+	uint32 boxBuf = rdi.getStorageBuffer( 0 ), resultBuf = rdi.getStorageBuffer( 1 );
+	if( boxBuf == 0 || resultBuf == 0 ) return;
+	const vector< uint8 > &boxData = rdi.getBufferData( boxBuf );
+	vector< uint8 > &resultData = rdi.getBufferData( resultBuf );
+
+	// Boxes are min and max corners padded to vec4, results one bit per box
+	size_t numBoxes = min( min( boxData.size() / (8 * sizeof( float )), resultData.size() * 8 ),
+	                       (size_t)xDim * yDim * zDim * 64 );
+	const float *m = occluder.camMat;
+	for( size_t i = 0; i < numBoxes; ++i )
+	{
+		float box[8];
+		memcpy( box, &boxData[i * sizeof( box )], sizeof( box ) );
+
+		float minDist = 1e30f;
+		for( int j = 0; j < 8; ++j )
+		{
+			float x = (j & 1) ? box[4] : box[0], y = (j & 2) ? box[5] : box[1], z = (j & 4) ? box[6] : box[2];
+			float dist = -((x - m[12]) * m[8] + (y - m[13]) * m[9] + (z - m[14]) * m[10]);
+			minDist = min( minDist, dist );
+		}
+
+		// Boxes touching the wall, like the wall itself, stay visible
+		if( minDist > occluder.distance + 0.01f ) resultData[i >> 3] |= (uint8)(1u << (i & 7));
+	}
+}
+#endif
+
+}  // namespace
+
+
+// =================================================================================================
+// StressConfig / StressCurve
+// =================================================================================================
+
+int *StressConfig::getParam( const string &name )
+{
+	if( name == "frames" ) return &frames;
+	if( name == "characters" ) return &characters;
+	if( name == "props" ) return &props;
+	if( name == "lights" ) return &lights;
+	if( name == "shadowLights" ) return &shadowLights;
+	if( name == "shadowCascades" ) return &shadowCascades;
+	if( name == "emitters" ) return &emitters;
+	if( name == "videoStreams" ) return &videoStreams;
+	if( name == "pointChunks" ) return &pointChunks;
+	return 0x0;
+}
+
+
+double *StressSample::getMetric( const std::string &name )
+{
+	if( name == "batches" ) return &batches;
+	if( name == "triangles" ) return &triangles;
+	if( name == "lightPasses" ) return &lightPasses;
+	if( name == "tiledLights" ) return &tiledLights;
+	if( name == "tileMaxLights" ) return &tileMaxLights;
+	if( name == "shadowMaps" ) return &shadowMaps;
+	if( name == "cascadeBatches" ) return &cascadeBatches;
+	if( name.compare( 0, 11, "shadowSplit" ) == 0 && name.length() == 12 && name[11] >= '0' && name[11] <= '4' )
+		return &shadowSplits[name[11] - '0'];
+	if( name == "videoPresented" ) return &videoPresented;
+	if( name == "videoDropped" ) return &videoDropped;
+	if( name == "occCulled" ) return &occCulled;
+	if( name == "occVisible" ) return &occVisible;
+	if( name == "pointChunksDrawn" ) return &pointChunksDrawn;
+	if( name == "pointChunksCulled" ) return &pointChunksCulled;
+	if( name == "pointsDrawn" ) return &pointsDrawn;
+	if( name == "pointChunksReduced" ) return &pointChunksReduced;
+	return 0x0;
+}
+
+
+double StressCurve::getSlope( double StressSample::*metric ) const
+{
+	// Least squares fit of metric over the swept count, i.e. the cost per added item
+	double n = 0, sx = 0, sy = 0, sxx = 0, sxy = 0;
+	for( size_t i = 0; i < points.size(); ++i )
+	{
+		StressConfig config = points[i].config;
+		int *count = config.getParam( param );
+		if( count == 0x0 ) return 0;
+
+		double x = *count, y = points[i].*metric;
+		n += 1; sx += x; sy += y; sxx += x * x; sxy += x * y;
+	}
+
+	double denom = n * sxx - sx * sx;
+	return denom != 0 ? (n * sxy - sx * sy) / denom : 0;
+}
+
+
+// =================================================================================================
+// StressScene
+// =================================================================================================
+
+StressScene::StressScene() :
+	_pipelineRes( 0 ), _characterRes( 0 ), _walkAnimRes( 0 ), _particleSysRes( 0 ), _lightMatRes( 0 ), _pointMatRes( 0 ),
+	_pointBufRes( 0 ), _cam( 0 ),
+	_overlapRendering( false ), _lateLatching( false ), _renderStep( RenderStep::Idle ), _renderThreadStop( false ),
+	_renderFrame( 0 ), _renderSample( 0x0 ), _renderMs( 0 )
+{
+	_propRes[0] = _propRes[1] = 0;
+}
+
+
+bool StressScene::loadContent( const string &contentDir, const string &pipeline )
+{
+	_pipelineRes = h3dAddResource( H3DResTypes::Pipeline, pipeline.c_str(), 0 );
+	_characterRes = h3dAddResource( H3DResTypes::SceneGraph, "models/man/man.scene.xml", 0 );
+	_walkAnimRes = h3dAddResource( H3DResTypes::Animation, "animations/man.anim", 0 );
+	_propRes[0] = h3dAddResource( H3DResTypes::SceneGraph, "models/sphere/sphere.scene.xml", 0 );
+	_propRes[1] = h3dAddResource( H3DResTypes::SceneGraph, "models/knight/knight.scene.xml", 0 );
+	_particleSysRes = h3dAddResource( H3DResTypes::SceneGraph, "particles/particleSys1/particleSys1.scene.xml", 0 );
+	_lightMatRes = h3dAddResource( H3DResTypes::Material, "materials/light.material.xml", 0 );
+	_pointMatRes = h3dAddResource( H3DResTypes::Material, "materials/computeDraw.material.xml", 0 );
+
+	if( !h3dutLoadResourcesFromDisk( contentDir.c_str() ) ) return false;
+	if( !h3dIsResLoaded( _pipelineRes ) || !h3dIsResLoaded( _characterRes ) ) return false;
+
+	_cam = h3dAddCameraNode( H3DRootNode, "StressCamera", _pipelineRes );
+	h3dSetNodeParamI( _cam, H3DCamera::ViewportXI, 0 );
+	h3dSetNodeParamI( _cam, H3DCamera::ViewportYI, 0 );
+	h3dSetNodeParamI( _cam, H3DCamera::ViewportWidthI, ViewportWidth );
+	h3dSetNodeParamI( _cam, H3DCamera::ViewportHeightI, ViewportHeight );
+	h3dSetupCameraView( _cam, 45.0f, (float)ViewportWidth / ViewportHeight, 0.5f, 2000.0f );
+	h3dResizePipelineBuffers( _pipelineRes, ViewportWidth, ViewportHeight );
+
+	return true;
+}
+
+
+void StressScene::release()
+{
+	stopRenderThread();
+	setOccluder( 0 );
+	if( _cam != 0 ) h3dRemoveNode( _cam );
+	_cam = 0;
+}
+
+
+void StressScene::setOccluder( float distance )
+{
+	_occluder.distance = max( distance, 0.0f );
+
+#ifdef H3D_TEST_ENGINE_INTERNALS
+	Horde3D::RDI_Null::RenderDeviceNull *rdi =
+		(Horde3D::RDI_Null::RenderDeviceNull *)Horde3D::Modules::renderer().getRenderDevice();
+	if( rdi != 0x0 ) rdi->setComputeHandler( _occluder.distance > 0 ? emulateOcclusionTest : 0x0, &_occluder );
+#endif
+}
+
+
+void StressScene::setCameraPose( float t, float radius )
+{
+	// Orbit around the crowd, looking down onto it
+	float ang = t * 6.2831853f;
+	h3dSetNodeTransform( _cam, sinf( ang ) * radius, radius * 0.4f, cosf( ang ) * radius,
+	                     -25.0f, ang * 57.29578f, 0, 1, 1, 1 );
+
+	if( _occluder.distance > 0 )
+	{
+		const float *absMat = 0x0;
+		h3dGetNodeTransMats( _cam, 0x0, &absMat );
+		if( absMat != 0x0 ) memcpy( _occluder.camMat, absMat, sizeof( _occluder.camMat ) );
+	}
+}
+
+
+void StressScene::createOccluder()
+{
+	if( _occluder.distance <= 0 ) return;
+
+	// Quad in camera space, large enough to cover the field of view
+	float d = _occluder.distance, s = d * 2.0f;
+	float pos[12] = { -s, -s, -d,  s, -s, -d,  s, s, -d,  -s, s, -d };
+	float texCoords[8] = { 0, 0,  1, 0,  1, 1,  0, 1 };
+	short normals[12] = { 0, 0, 32767,  0, 0, 32767,  0, 0, 32767,  0, 0, 32767 };
+	unsigned int indices[6] = { 0, 1, 2,  2, 3, 0 };
+	_occluder.geoRes = h3dutCreateGeometryRes( "StressOccluder", 4, 6, pos, indices, normals, 0x0, 0x0, texCoords, 0x0 );
+
+	H3DRes matRes = h3dFindResource( H3DResTypes::Material, "models/sphere/stones.material.xml" );
+	_occluder.model = h3dAddModelNode( _cam, "StressOccluder", _occluder.geoRes );
+	h3dAddMeshNode( _occluder.model, "StressOccluderMesh", matRes, H3DMeshPrimType::TriangleList, 0, 6, 0, 3 );
+	h3dSetNodeFlags( _occluder.model, H3DNodeFlags::NoCastShadow, true );
+}
+
+
+void StressScene::removeOccluder()
+{
+	if( _occluder.model != 0 ) h3dRemoveNode( _occluder.model );
+	if( _occluder.geoRes != 0 ) h3dRemoveResource( _occluder.geoRes );
+	_occluder.model = 0;
+	_occluder.geoRes = 0;
+	h3dReleaseUnusedResources();
+}
+
+
+void StressScene::startRenderThread()
+{
+	// The thread is kept for all runs. The Null backend has no context, with an OpenGL backend the
+	// context would be made current on this thread.
+	if( _renderThread.joinable() ) return;
+
+	_renderStep = RenderStep::Idle;
+	_renderThreadStop = false;
+	_renderThread = thread( &StressScene::renderThreadFunc, this );
+}
+
+
+void StressScene::stopRenderThread()
+{
+	if( !_renderThread.joinable() ) return;
+
+	{
+		lock_guard< mutex > lock( _renderMutex );
+		_renderThreadStop = true;
+	}
+	_renderCond.notify_all();
+	_renderThread.join();
+}
+
+
+void StressScene::renderThreadFunc()
+{
+	for( ;; )
+	{
+		{
+			unique_lock< mutex > lock( _renderMutex );
+			_renderCond.wait( lock, [this]() { return _renderThreadStop || _renderStep == RenderStep::Requested; } );
+			if( _renderThreadStop ) return;
+		}
+
+		// Stream uploads and scene updates may use the render device
+		updateVideoStreams( _renderFrame, *_renderSample );
+		h3dPrepareRender( _cam );
+		advanceRenderStep( RenderStep::Prepared );
+		waitForRenderStep( RenderStep::Latched );
+
+		WallTimer renderTimer;
+		h3dRender( _cam );
+		h3dFinalizeFrame();
+		_renderMs = renderTimer.getElapsedMS();
+		advanceRenderStep( RenderStep::Rendered );
+	}
+}
+
+
+void StressScene::advanceRenderStep( int step )
+{
+	{
+		lock_guard< mutex > lock( _renderMutex );
+		_renderStep = step;
+	}
+	_renderCond.notify_all();
+}
+
+
+void StressScene::waitForRenderStep( int step )
+{
+	unique_lock< mutex > lock( _renderMutex );
+	_renderCond.wait( lock, [this, step]() { return _renderStep == step; } );
+}
+
+
+void StressScene::createVideoStreams( int count )
+{
+#ifdef HORDE3D_STRESS_VIDEO_STREAMS
+	for( int i = 0; i < count; ++i )
+	{
+		char name[32];
+		snprintf( name, sizeof( name ), "StressVideo%d", i );
+		H3DRes res = h3dextCreateStreamTexture( name, VideoWidth, VideoHeight, H3DFormats::TEX_BGRA8, VideoRingSize );
+		if( res != 0 ) _videoStreams.push_back( res );
+	}
+	_videoFrame.resize( VideoWidth * VideoHeight * 4 );
+#else
+	(void)count;
+#endif
+}
+
+
+void StressScene::updateVideoStreams( int frame, StressSample &sample )
+{
+#ifdef HORDE3D_STRESS_VIDEO_STREAMS
+	double time = frame / (double)FrameRate;
+
+	for( size_t i = 0; i < _videoStreams.size(); ++i )
+	{
+		// Synthetic frame: moving gradient with a stream specific tint, the way a decoder would deliver it
+		for( int y = 0; y < VideoHeight; ++y )
+		{
+			unsigned char *row = &_videoFrame[y * VideoWidth * 4];
+			for( int x = 0; x < VideoWidth; ++x )
+			{
+				row[x * 4 + 0] = (unsigned char)(x + frame * 4);
+				row[x * 4 + 1] = (unsigned char)(y + frame * 2);
+				row[x * 4 + 2] = (unsigned char)(i * 40);
+				row[x * 4 + 3] = 255;
+			}
+		}
+
+		if( !h3dextPushStreamFrame( _videoStreams[i], &_videoFrame[0], time ) ) sample.videoDropped += 1;
+		if( h3dextPresentStreamFrame( _videoStreams[i], time ) >= 0 ) sample.videoPresented += 1;
+	}
+#else
+	(void)frame;
+	(void)sample;
+#endif
+}
+
+
+void StressScene::removeVideoStreams()
+{
+	for( size_t i = 0; i < _videoStreams.size(); ++i )
+		h3dRemoveResource( _videoStreams[i] );
+	_videoStreams.clear();
+	h3dReleaseUnusedResources();
+}
+
+
+void StressScene::createPointCloud( H3DNode parent, int chunks, float areaRadius )
+{
+	if( chunks <= 0 ) return;
+
+	// All chunks share one buffer, each holds a cell of a grid covering the area
+	const int pointSize = 8 * sizeof( float );  // Position and velocity as used by the compute material
+	_pointBufRes = h3dAddResource( H3DResTypes::ComputeBuffer, "StressPoints", H3DResFlags::NoQuery );
+	h3dSetResParamI( _pointBufRes, H3DComputeBufRes::ComputeBufElem, 0, H3DComputeBufRes::CompBufDataSizeI,
+	                 chunks * PointsPerChunk * pointSize );
+	h3dSetResParamI( _pointBufRes, H3DComputeBufRes::ComputeBufElem, 0, H3DComputeBufRes::CompBufDrawableI, 1 );
+	h3dSetResParamStr( _pointBufRes, H3DComputeBufRes::DrawParamsElem, 0, H3DComputeBufRes::DrawParamsNameStr, "partPosition" );
+	h3dSetResParamI( _pointBufRes, H3DComputeBufRes::DrawParamsElem, 0, H3DComputeBufRes::DrawParamsSizeI, 4 );
+	h3dSetResParamI( _pointBufRes, H3DComputeBufRes::DrawParamsElem, 0, H3DComputeBufRes::DrawParamsOffsetI, 0 );
+	h3dSetResParamStr( _pointBufRes, H3DComputeBufRes::DrawParamsElem, 1, H3DComputeBufRes::DrawParamsNameStr, "partVelocity" );
+	h3dSetResParamI( _pointBufRes, H3DComputeBufRes::DrawParamsElem, 1, H3DComputeBufRes::DrawParamsSizeI, 4 );
+	h3dSetResParamI( _pointBufRes, H3DComputeBufRes::DrawParamsElem, 1, H3DComputeBufRes::DrawParamsOffsetI, 16 );
+
+	int gridSize = (int)ceilf( sqrtf( (float)chunks ) );
+	float cellSize = 2.0f * areaRadius / gridSize;
+	StressRandom rnd( RandomSeed );
+	vector< float > chunkData( PointsPerChunk * 8, 0.0f );
+
+	for( int i = 0; i < chunks; ++i )
+	{
+		float x0 = -areaRadius + (i % gridSize) * cellSize, z0 = -areaRadius + (i / gridSize) * cellSize;
+
+		// Random order, so that every prefix of the chunk is a uniform subsample for the LOD
+		for( int j = 0; j < PointsPerChunk; ++j )
+		{
+			chunkData[j * 8 + 0] = x0 + rnd.nextFloat( 0, cellSize );
+			chunkData[j * 8 + 1] = rnd.nextFloat( 0, 2.0f );
+			chunkData[j * 8 + 2] = z0 + rnd.nextFloat( 0, cellSize );
+			chunkData[j * 8 + 3] = 1.0f;
+		}
+
+		// Chunks are streamed one by one like from a memory-mapped file
+		h3dSetResParamI( _pointBufRes, H3DComputeBufRes::ComputeBufElem, 0, H3DComputeBufRes::CompBufMapOffsetI,
+		                 i * PointsPerChunk * pointSize );
+		h3dSetResParamI( _pointBufRes, H3DComputeBufRes::ComputeBufElem, 0, H3DComputeBufRes::CompBufMapSizeI,
+		                 PointsPerChunk * pointSize );
+		void *data = h3dMapResStream( _pointBufRes, H3DComputeBufRes::ComputeBufElem, 0, 0, false, true );
+		if( data != 0x0 ) memcpy( data, &chunkData[0], chunkData.size() * sizeof( float ) );
+		h3dUnmapResStream( _pointBufRes );
+
+		H3DNode node = h3dAddComputeNode( parent, "StressPoints", _pointMatRes, _pointBufRes,
+		                                  H3DMeshPrimType::Points, PointsPerChunk );
+		h3dSetNodeParamI( node, H3DComputeNode::ElementsStartI, i * PointsPerChunk );
+		h3dSetNodeParamF( node, H3DComputeNode::LodDensityF, 0, PointDensity );
+		h3dSetNodeParamF( node, H3DComputeNode::AABBMinF, 0, x0 );
+		h3dSetNodeParamF( node, H3DComputeNode::AABBMinF, 1, 0 );
+		h3dSetNodeParamF( node, H3DComputeNode::AABBMinF, 2, z0 );
+		h3dSetNodeParamF( node, H3DComputeNode::AABBMaxF, 0, x0 + cellSize );
+		h3dSetNodeParamF( node, H3DComputeNode::AABBMaxF, 1, 2.0f );
+		h3dSetNodeParamF( node, H3DComputeNode::AABBMaxF, 2, z0 + cellSize );
+		_pointChunks.push_back( node );
+	}
+}
+
+
+void StressScene::removePointCloud()
+{
+	if( _pointBufRes != 0 ) h3dRemoveResource( _pointBufRes );
+	_pointBufRes = 0;
+	_pointChunks.clear();
+	h3dReleaseUnusedResources();
+}
+
+
+void StressScene::countPointChunks( StressSample &sample )
+{
+	if( _pointChunks.empty() ) return;
+
+#ifdef H3D_TEST_ENGINE_INTERNALS
+	// Element counts after density LOD are only stored in the render snapshot
+	const vector< Horde3D::SnapshotNode > &nodes = Horde3D::Modules::renderer().getSnapshot().nodes;
+	vector< const Horde3D::SnapshotNode * > computeNodes;
+	for( size_t i = 0; i < nodes.size(); ++i )
+	{
+		if( nodes[i].type == Horde3D::SceneNodeTypes::Compute ) computeNodes.push_back( &nodes[i] );
+	}
+#endif
+
+	for( size_t i = 0; i < _pointChunks.size(); ++i )
+	{
+		if( h3dCheckNodeVisibility( _pointChunks[i], _cam, false, false ) < 0 )
+		{
+			sample.pointChunksCulled += 1;
+			continue;
+		}
+		sample.pointChunksDrawn += 1;
+
+#ifdef H3D_TEST_ENGINE_INTERNALS
+		for( size_t j = 0; j < computeNodes.size(); ++j )
+		{
+			if( computeNodes[j]->handle != _pointChunks[i] ) continue;
+			
+			sample.pointsDrawn += computeNodes[j]->elementsCount;
+			if( computeNodes[j]->elementsCount < (uint32)PointsPerChunk ) sample.pointChunksReduced += 1;
+			break;
+		}
+#endif
+	}
+}
+
+
+void StressScene::run( const StressConfig &config, StressSample &sample )
+{
+	StressRandom rnd( RandomSeed );
+	H3DNode root = h3dAddGroupNode( H3DRootNode, "StressScene" );
+
+	// Keep crowd density similar to the Chicago sample which uses 100 characters in a radius of 20
+	float areaRadius = 20.0f * sqrtf( max( config.characters, 100 ) / 100.0f );
+
+	CrowdSim crowd;
+	crowd.init( root, _characterRes, _walkAnimRes, (unsigned int)config.characters, (unsigned int)areaRadius );
+
+	// Static props scattered over the area
+	for( int i = 0; i < config.props; ++i )
+	{
+		H3DNode node = h3dAddNodes( root, _propRes[i % 2] );
+		float scale = i % 2 == 0 ? rnd.nextFloat( 0.5f, 1.5f ) : rnd.nextFloat( 0.01f, 0.015f );
+		h3dSetNodeTransform( node, rnd.nextFloat( -areaRadius, areaRadius ), 0, rnd.nextFloat( -areaRadius, areaRadius ),
+		                     0, rnd.nextFloat( 0.0f, 360.0f ), 0, scale, scale, scale );
+	}
+
+	// Spot lights pointing down onto the scene
+	H3DNode shadowLight = 0;
+	for( int i = 0; i < config.lights; ++i )
+	{
+		H3DNode light = h3dAddLightNode( root, "StressLight", _lightMatRes, "LIGHTING", "SHADOWMAP" );
+		if( i == 0 && config.shadowLights > 0 ) shadowLight = light;
+		h3dSetNodeTransform( light, rnd.nextFloat( -areaRadius, areaRadius ), 25.0f,
+		                     rnd.nextFloat( -areaRadius, areaRadius ), -90.0f, 0, 0, 1, 1, 1 );
+		h3dSetNodeParamF( light, H3DLight::RadiusF, 0, 60.0f );
+		h3dSetNodeParamF( light, H3DLight::FovF, 0, 90.0f );
+		h3dSetNodeParamI( light, H3DLight::ShadowMapCountI, i < config.shadowLights ? config.shadowCascades : 0 );
+	}
+
+	// Particle systems, spawning uses the C library generator
+	srand( RandomSeed );
+	for( int i = 0; i < config.emitters; ++i )
+	{
+		H3DNode node = h3dAddNodes( root, _particleSysRes );
+		h3dSetNodeTransform( node, rnd.nextFloat( -areaRadius, areaRadius ), 0, rnd.nextFloat( -areaRadius, areaRadius ),
+		                     0, 0, 0, 1, 1, 1 );
+	}
+
+	vector< H3DNode > emitters;
+	int count = h3dFindNodes( root, "", H3DNodeTypes::Emitter );
+	for( int i = 0; i < count; ++i )
+		emitters.push_back( h3dGetNodeFindResult( i ) );
+
+	createVideoStreams( config.videoStreams );
+	createPointCloud( root, config.pointChunks, areaRadius );
+	createOccluder();
+
+	sample = StressSample();
+	sample.config = config;
+
+	int frames = max( config.frames, 1 );
+	double tiles = 0, tileLightRefs = 0;
+	resetEngineStats();
+	if( _overlapRendering ) startRenderThread();
+	for( int frame = 0; frame < frames; ++frame )
+	{
+		if( !_lateLatching || !_overlapRendering ) setCameraPose( (float)frame / frames, areaRadius * 1.5f );
+
+		WallTimer frameTimer;
+
+		if( _overlapRendering )
+		{
+			// The prepared frame is rendered from the snapshot while the scene is updated for the next one.
+			// Only node transformations, animation parameters and emitters are changed during h3dRender.
+			{
+				lock_guard< mutex > lock( _renderMutex );
+				_renderFrame = frame;
+				_renderSample = &sample;
+			}
+			advanceRenderStep( RenderStep::Requested );
+			waitForRenderStep( RenderStep::Prepared );
+			if( _lateLatching ) setCameraPose( (float)frame / frames, areaRadius * 1.5f );
+			advanceRenderStep( RenderStep::Latched );
+
+			WallTimer crowdTimer;
+			crowd.update( FrameRate );
+			sample.crowdMs += crowdTimer.getElapsedMS();
+
+			for( size_t i = 0; i < emitters.size(); ++i )
+				h3dUpdateEmitter( emitters[i], 1.0f / FrameRate );
+
+			waitForRenderStep( RenderStep::Rendered );
+			sample.renderMs += _renderMs;
+		}
+		else
+		{
+			WallTimer crowdTimer;
+			crowd.update( FrameRate );
+			sample.crowdMs += crowdTimer.getElapsedMS();
+
+			for( size_t i = 0; i < emitters.size(); ++i )
+				h3dUpdateEmitter( emitters[i], 1.0f / FrameRate );
+
+			updateVideoStreams( frame, sample );
+
+			WallTimer renderTimer;
+			h3dRender( _cam );
+			h3dFinalizeFrame();
+			sample.renderMs += renderTimer.getElapsedMS();
+
+			countPointChunks( sample );
+		}
+
+		sample.frameMs += frameTimer.getElapsedMS();
+
+		sample.animationMs += h3dGetStat( H3DStats::AnimationTime, true );
+		sample.geoUpdateMs += h3dGetStat( H3DStats::GeoUpdateTime, true );
+		sample.particleSimMs += h3dGetStat( H3DStats::ParticleSimTime, true );
+		sample.cullingMs += h3dGetStat( H3DStats::CullingTime, true );
+		sample.batches += h3dGetStat( H3DStats::BatchCount, true );
+		sample.triangles += h3dGetStat( H3DStats::TriCount, true );
+		sample.lightPasses += h3dGetStat( H3DStats::LightPassCount, true );
+		sample.tiledLights += h3dGetStat( H3DStats::TiledLightCount, true );
+		tiles += h3dGetStat( H3DStats::TileCount, true );
+		tileLightRefs += h3dGetStat( H3DStats::TileLightRefs, true );
+		sample.shadowMaps += h3dGetStat( H3DStats::ShadowMapCount, true );
+		sample.cascadeBatches += h3dGetStat( H3DStats::CascadeBatchCount, true );
+
+		double occTests = h3dGetStat( H3DStats::OcclusionTestCount, true );
+		double occluded = h3dGetStat( H3DStats::OccludedCount, true );
+		sample.occCulled += occluded;
+		sample.occVisible += occTests - occluded;
+	}
+	sample.tileOccupancy = tiles > 0 ? tileLightRefs / tiles : 0;
+	sample.tileMaxLights = h3dGetStat( H3DStats::TileMaxLights, true );
+	for( int i = 0; i < 5 && shadowLight != 0; ++i )
+		sample.shadowSplits[i] = h3dGetNodeParamF( shadowLight, H3DLight::ShadowSplitDistsF5, i );
+
+	double *values[] = { &sample.frameMs, &sample.crowdMs, &sample.renderMs, &sample.animationMs,
+	                     &sample.geoUpdateMs, &sample.particleSimMs, &sample.cullingMs, &sample.batches,
+	                     &sample.triangles, &sample.lightPasses, &sample.tiledLights, &sample.shadowMaps,
+	                     &sample.cascadeBatches };
+	for( size_t i = 0; i < sizeof( values ) / sizeof( values[0] ); ++i )
+		*values[i] /= frames;
+
+	h3dRemoveNode( root );
+	removeVideoStreams();
+	removePointCloud();
+	removeOccluder();
+}
@@ -0,0 +1,201 @@
+// *************************************************************************************************
+//
+// Horde3D
+//   Next-Generation Graphics Engine
+// --------------------------------------
+// Copyright (C) 2006-2021 Nicolas Schulz and Horde3D team
+//
+// This software is distributed under the terms of the Eclipse Public License v1.0.
+// A copy of the license may be obtained at: http://www.eclipse.org/legal/epl-v10.html
+//
+// *************************************************************************************************
+
+#ifndef _Stress_H_
+#define _Stress_H_
+
+#include "Horde3D.h"
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+// =================================================================================================
+// Stress scene configuration and results
+// =================================================================================================
+
+struct StressConfig
+{
+	int  frames;        // Number of simulated frames
+	int  characters;    // Number of animated characters driven by the crowd simulation
+	int  props;         // Number of static props
+	int  lights;        // Number of spot lights
+	int  shadowLights;  // Number of lights casting shadows (subset of lights)
+	int  shadowCascades;  // Number of shadow maps (cascades) per shadow casting light
+	int  emitters;      // Number of particle systems (two emitters each)
+	int  videoStreams;  // Number of streamed textures fed with synthetic frames (ExternalTexture extension)
+	int  pointChunks;   // Number of point cloud chunks, each drawn by its own compute node
+
+	StressConfig() : frames( 120 ), characters( 2000 ), props( 2000 ), lights( 16 ), shadowLights( 4 ),
+		shadowCascades( 1 ), emitters( 20 ), videoStreams( 0 ), pointChunks( 0 ) {}
+
+	int *getParam( const std::string &name );
+};
+
+struct StressSample
+{
+	StressConfig  config;
+
+	// Averages per frame
+	double        frameMs;        // Complete frame (crowd update, emitters, render)
+	double        crowdMs;        // Crowd simulation including animation and skinning updates
+	double        renderMs;       // h3dRender and h3dFinalizeFrame
+	double        animationMs;    // Engine stats
+	double        geoUpdateMs;
+	double        particleSimMs;
+	double        cullingMs;
+	double        batches;
+	double        triangles;
+	double        lightPasses;
+	double        tiledLights;    // Lights shaded by tiled deferred lighting
+	double        tileOccupancy;  // Average number of lights per screen tile
+	double        tileMaxLights;  // Maximum over all frames
+	double        shadowMaps;     // Rendered shadow maps (cascades)
+	double        cascadeBatches; // Shadow caster batches instanced over several cascades
+
+	// Totals over all frames and streams
+	double        videoPresented; // Stream frames that became visible
+	double        videoDropped;   // Stream frames that were rejected because all slots were busy
+	double        occCulled;      // Renderables found occluded by the GPU occlusion tests
+	double        occVisible;     // Renderables found visible by the GPU occlusion tests
+	double        pointChunksDrawn;    // Point cloud chunks inside the camera frustum
+	double        pointChunksCulled;   // Point cloud chunks outside of the camera frustum
+	double        pointsDrawn;         // Points of the drawn chunks after density LOD (engine internals only)
+	double        pointChunksReduced;  // Drawn chunks subsampled by density LOD (engine internals only)
+
+	// Last frame
+	double        shadowSplits[5];  // Split distances of the first shadow casting light
+
+	StressSample() : frameMs( 0 ), crowdMs( 0 ), renderMs( 0 ), animationMs( 0 ), geoUpdateMs( 0 ),
+		particleSimMs( 0 ), cullingMs( 0 ), batches( 0 ), triangles( 0 ), lightPasses( 0 ), tiledLights( 0 ),
+		tileOccupancy( 0 ), tileMaxLights( 0 ), shadowMaps( 0 ), cascadeBatches( 0 ), videoPresented( 0 ),
+		videoDropped( 0 ), occCulled( 0 ), occVisible( 0 ), pointChunksDrawn( 0 ), pointChunksCulled( 0 ),
+		pointsDrawn( 0 ), pointChunksReduced( 0 )
+	{
+		for( int i = 0; i < 5; ++i ) shadowSplits[i] = 0;
+	}
+
+	double *getMetric( const std::string &name );
+};
+
+// Wall facing the camera at a fixed distance that hides everything behind it
+struct StressOccluder
+{
+	float    distance;     // 0 if there is no occluder
+	float    camMat[16];   // Absolute transformation of the camera in the current frame
+	H3DRes   geoRes;
+	H3DNode  model;
+
+	StressOccluder() : distance( 0 ), geoRes( 0 ), model( 0 )
+	{
+		for( int i = 0; i < 16; ++i ) camMat[i] = i % 5 == 0 ? 1.0f : 0.0f;
+	}
+};
+
+struct StressCurve
+{
+	std::string                  param;   // Swept configuration parameter
+	std::vector< StressSample >  points;
+
+	double getSlope( double StressSample::*metric ) const;
+};
+
+
+// =================================================================================================
+// Stress scene generator
+// =================================================================================================
+
+class StressScene
+{
+public:
+	StressScene();
+
+	bool loadContent( const std::string &contentDir, const std::string &pipeline );
+	void release();
+
+	// Builds the scene for config, runs it for the configured number of frames and removes it again
+	void run( const StressConfig &config, StressSample &sample );
+
+	// Prepares and renders each frame on a render thread while the crowd and particles are updated for the next one
+	void setOverlappedRendering( bool enabled ) { _overlapRendering = enabled; }
+
+	// Moves the camera after preparing an overlapped frame, drawing takes over the latest pose
+	void setLateLatching( bool enabled ) { _lateLatching = enabled; }
+
+	// Culls occluded objects with the queries or the depth pyramid of the camera pipeline
+	void setOcclusionCulling( bool enabled ) { h3dSetNodeParamI( _cam, H3DCamera::OccCullingI, enabled ? 1 : 0 ); }
+
+	// Places a wall facing the camera at the distance, 0 removes it
+	void setOccluder( float distance );
+
+private:
+	void setCameraPose( float t, float radius );
+	void createVideoStreams( int count );
+	void updateVideoStreams( int frame, StressSample &sample );
+	void removeVideoStreams();
+	void createPointCloud( H3DNode parent, int chunks, float areaRadius );
+	void removePointCloud();
+	void countPointChunks( StressSample &sample );
+	void createOccluder();
+	void removeOccluder();
+
+	// Overlapped rendering, all calls using the render device are made on the render thread
+	void startRenderThread();
+	void stopRenderThread();
+	void renderThreadFunc();
+	void advanceRenderStep( int step );
+	void waitForRenderStep( int step );
+
+private:
+	struct RenderStep
+	{
+		enum List
+		{
+			Idle,
+			Requested,  // Main thread requested a frame
+			Prepared,   // Render thread prepared the frame, the scene may be updated again
+			Latched,    // Main thread set the late latched camera pose
+			Rendered
+		};
+	};
+
+	H3DRes   _pipelineRes;
+	H3DRes   _characterRes;
+	H3DRes   _walkAnimRes;
+	H3DRes   _propRes[2];
+	H3DRes   _particleSysRes;
+	H3DRes   _lightMatRes;
+	H3DRes   _pointMatRes;
+	H3DRes   _pointBufRes;
+	H3DNode  _cam;
+	std::vector< H3DNode >  _pointChunks;
+	bool     _overlapRendering;
+	bool     _lateLatching;
+
+	std::thread              _renderThread;
+	std::mutex               _renderMutex;
+	std::condition_variable  _renderCond;
+	int                      _renderStep;
+	bool                     _renderThreadStop;
+	int                      _renderFrame;   // Frame requested from the render thread
+	StressSample             *_renderSample;
+	double                   _renderMs;
+
+	std::vector< H3DRes >         _videoStreams;
+	std::vector< unsigned char >  _videoFrame;
+
+	StressOccluder  _occluder;
+};
+
+#endif // _Stress_H_